@@ -516,6 +516,195 @@ public:
     }
   }
 
+  //----------------------------------------------------------------------------
+  static bool IsConvertAndFlipSupported(PixelEncoding inputEncoding, int outputNumberOfComponents)
+  {
+    if (outputNumberOfComponents != 1 && outputNumberOfComponents != 3)
+    {
+      return false;
+    }
+    switch (inputEncoding)
+    {
+      case PixelEncoding_RGB24:
+      case PixelEncoding_BGR24:
+      case PixelEncoding_RGBA32:
+      case PixelEncoding_YUY2:
+        return true;
+      default:
+        return false;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  /*!
+  Convert an image to 8-bit grayscale (outputNumberOfComponents = 1) or RGB (outputNumberOfComponents = 3),
+  flip it along the requested axes and write it to the output, in a single pass over the pixels.
+  Gray and RGB values are computed the same way as in ConvertToGray and ConvertToBmp24.
+  Rows of the input and output images are tightly packed. For YUY2 input the width must be even, images of odd width
+  are rejected (ConvertToGray and ConvertToBmp24 accept them, but they do not decode the last column correctly).
+  \param flipX Reverse the order of the pixels in each row
+  \param flipY Reverse the order of the rows in each slice
+  \param flipZ Reverse the order of the slices
+  */
+  static PlusStatus ConvertAndFlip(PixelEncoding inputEncoding, int outputNumberOfComponents, int width, int height, int depth,
+                                   bool flipX, bool flipY, bool flipZ, const unsigned char* s, unsigned char* d)
+  {
+    if (!IsConvertAndFlipSupported(inputEncoding, outputNumberOfComponents))
+    {
+      LOG_ERROR("Conversion from " << GetCompressionModeAsString(inputEncoding) << " to " << outputNumberOfComponents << "-component image is not supported");
+      return PLUS_FAIL;
+    }
+    if (inputEncoding == PixelEncoding_YUY2 && width % 2 != 0)
+    {
+      LOG_ERROR("YUY2 image width must be even (width: " << width << ")");
+      return PLUS_FAIL;
+    }
+
+    int inputBytesPerPixel = 3;
+    if (inputEncoding == PixelEncoding_RGBA32)
+    {
+      inputBytesPerPixel = 4;
+    }
+    else if (inputEncoding == PixelEncoding_YUY2)
+    {
+      inputBytesPerPixel = 2;
+    }
+    const size_t inputRowSizeBytes = static_cast<size_t>(width) * inputBytesPerPixel;
+    const size_t outputRowSizeBytes = static_cast<size_t>(width) * outputNumberOfComponents;
+
+    for (int z = 0; z < depth; z++)
+    {
+      const int inputZ = (flipZ ? depth - 1 - z : z);
+      for (int y = 0; y < height; y++)
+      {
+        const int inputY = (flipY ? height - 1 - y : y);
+        const unsigned char* inputRow = s + (static_cast<size_t>(inputZ) * height + inputY) * inputRowSizeBytes;
+        unsigned char* outputRow = d + (static_cast<size_t>(z) * height + y) * outputRowSizeBytes;
+        switch (inputEncoding)
+        {
+          case PixelEncoding_RGB24:
+            if (outputNumberOfComponents == 1)
+            {
+              ConvertRowToGray<3>(width, flipX, inputRow, outputRow);
+            }
+            else
+            {
+              ConvertRowToRgb<3, 0, 1, 2>(width, flipX, inputRow, outputRow);
+            }
+            break;
+          case PixelEncoding_BGR24:
+            if (outputNumberOfComponents == 1)
+            {
+              ConvertRowToGray<3>(width, flipX, inputRow, outputRow);
+            }
+            else
+            {
+              ConvertRowToRgb<3, 2, 1, 0>(width, flipX, inputRow, outputRow);
+            }
+            break;
+          case PixelEncoding_RGBA32:
+            if (outputNumberOfComponents == 1)
+            {
+              ConvertRowToGray<4>(width, flipX, inputRow, outputRow);
+            }
+            else
+            {
+              ConvertRowToRgb<4, 0, 1, 2>(width, flipX, inputRow, outputRow);
+            }
+            break;
+          default:
+            ConvertYuy2Row(outputNumberOfComponents, width, flipX, inputRow, outputRow);
+        }
+      }
+    }
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  /*!
+  Compute the intensity of each pixel of a row (see Rgb24ToGray).
+  The loops only use indexed access without dependencies between iterations, so that the compiler can vectorize them.
+  */
+  template<int InputBytesPerPixel>
+  static inline void ConvertRowToGray(int width, bool flipX, const unsigned char* s, unsigned char* d)
+  {
+    if (flipX)
+    {
+      for (int i = 0; i < width; i++)
+      {
+        const unsigned char* p = s + i * InputBytesPerPixel;
+        d[width - 1 - i] = ((unsigned short)(p[0]) + p[1] + p[2]) / 3;
+      }
+    }
+    else
+    {
+      for (int i = 0; i < width; i++)
+      {
+        const unsigned char* p = s + i * InputBytesPerPixel;
+        d[i] = ((unsigned short)(p[0]) + p[1] + p[2]) / 3;
+      }
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  /*! Copy the R, G, B components of each pixel of a row, from the specified offsets within the input pixel */
+  template<int InputBytesPerPixel, int ROffset, int GOffset, int BOffset>
+  static inline void ConvertRowToRgb(int width, bool flipX, const unsigned char* s, unsigned char* d)
+  {
+    if (flipX)
+    {
+      for (int i = 0; i < width; i++)
+      {
+        const unsigned char* p = s + i * InputBytesPerPixel;
+        unsigned char* q = d + (width - 1 - i) * 3;
+        q[0] = p[ROffset];
+        q[1] = p[GOffset];
+        q[2] = p[BOffset];
+      }
+    }
+    else
+    {
+      for (int i = 0; i < width; i++)
+      {
+        const unsigned char* p = s + i * InputBytesPerPixel;
+        unsigned char* q = d + i * 3;
+        q[0] = p[ROffset];
+        q[1] = p[GOffset];
+        q[2] = p[BOffset];
+      }
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  /*! Convert a YUY2 row to grayscale or RGB (see Yuv422pToGray and Yuv422pToBmp24) */
+  static inline void ConvertYuy2Row(int outputNumberOfComponents, int width, bool flipX, const unsigned char* s, unsigned char* d)
+  {
+    for (int i = 0; i < width / 2; i++)
+    {
+      const unsigned char* p = s + i * 4;
+      const int Y[2] = { ICCIRY(p[0]), ICCIRY(p[2]) };
+      const int U = ICCIRUV(p[1] - 128);
+      const int V = ICCIRUV(p[3] - 128);
+      for (int k = 0; k < 2; k++)
+      {
+        const int outputIndex = (flipX ? width - 1 - (2 * i + k) : 2 * i + k);
+        const unsigned char r = CLIP(GET_R_FROM_YUV(Y[k], U, V));
+        const unsigned char g = CLIP(GET_G_FROM_YUV(Y[k], U, V));
+        const unsigned char b = CLIP(GET_B_FROM_YUV(Y[k], U, V));
+        if (outputNumberOfComponents == 1)
+        {
+          d[outputIndex] = (int(b) + g + r) / 3;
+        }
+        else
+        {
+          d[outputIndex * 3] = r;
+          d[outputIndex * 3 + 1] = g;
+          d[outputIndex * 3 + 2] = b;
+        }
+      }
+    }
+  }
+
 private:
   PixelCodec(); // prevent instantiation
 };
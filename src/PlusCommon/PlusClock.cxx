@@ -0,0 +1,80 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+#include "PlusConfigure.h"
+#include "PlusClock.h"
+
+#include <atomic>
+
+namespace
+{
+  std::atomic<int> ClockModeValue(PlusClock::REAL_TIME);
+  std::atomic<double> VirtualTimeSec(0.0);
+}
+
+//----------------------------------------------------------------------------
+double PlusClock::GetSystemTime()
+{
+  if (ClockModeValue.load(std::memory_order_relaxed) == VIRTUAL_TIME)
+  {
+    return VirtualTimeSec.load();
+  }
+  return vtkIGSIOAccurateTimer::GetSystemTime();
+}
+
+//----------------------------------------------------------------------------
+void PlusClock::SetClockMode(ClockMode mode, double virtualStartTimeSec /*=0.0*/)
+{
+  if (mode == VIRTUAL_TIME)
+  {
+    VirtualTimeSec.store(virtualStartTimeSec);
+  }
+  ClockModeValue.store(mode);
+  LOG_DEBUG("Clock mode: " << GetClockModeAsString(mode));
+}
+
+//----------------------------------------------------------------------------
+PlusClock::ClockMode PlusClock::GetClockMode()
+{
+  return static_cast<ClockMode>(ClockModeValue.load());
+}
+
+//----------------------------------------------------------------------------
+bool PlusClock::IsVirtualTime()
+{
+  return ClockModeValue.load() == VIRTUAL_TIME;
+}
+
+//----------------------------------------------------------------------------
+void PlusClock::AdvanceVirtualTime(double timeSec)
+{
+  double currentTimeSec = VirtualTimeSec.load();
+  while (timeSec > currentTimeSec && !VirtualTimeSec.compare_exchange_weak(currentTimeSec, timeSec))
+  {
+  }
+}
+
+//----------------------------------------------------------------------------
+std::string PlusClock::GetClockModeAsString(ClockMode mode)
+{
+  return (mode == VIRTUAL_TIME ? "VirtualTime" : "RealTime");
+}
+
+//----------------------------------------------------------------------------
+bool PlusClock::GetClockModeFromString(const std::string& modeString, ClockMode& mode)
+{
+  if (igsioCommon::IsEqualInsensitive(modeString, "RealTime"))
+  {
+    mode = REAL_TIME;
+    return true;
+  }
+  if (igsioCommon::IsEqualInsensitive(modeString, "VirtualTime"))
+  {
+    mode = VIRTUAL_TIME;
+    return true;
+  }
+  return false;
+}
@@ -0,0 +1,62 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+#ifndef __PlusClock_h
+#define __PlusClock_h
+
+// PlusCommon includes
+#include "vtkPlusCommonExport.h"
+
+#include <string>
+
+/*!
+  \class PlusClock
+  \brief Source of the current time for devices, buffers, and channels
+
+  In real-time mode the time is the system time of vtkIGSIOAccurateTimer.
+
+  In virtual-time mode the time only changes when it is advanced explicitly, it does not change while
+  data is being processed. The acquisition scheduler advances it to the time of the next device update
+  instead of waiting for it (see PlusAcquisitionScheduler), so devices that do not depend on hardware
+  (saved data sources, virtual devices, processors) can run as fast as the CPU allows. As the updates
+  are performed one after the other in a fixed order at the same virtual times, repeated runs give the same results.
+
+  Waiting for other threads (e.g., for a thread to stop) always uses real time.
+
+  \ingroup PlusLibCommon
+*/
+class vtkPlusCommonExport PlusClock
+{
+public:
+  enum ClockMode
+  {
+    REAL_TIME,
+    VIRTUAL_TIME
+  };
+
+  /*! Get the current time in seconds */
+  static double GetSystemTime();
+
+  /*!
+    Set the clock mode. When virtual-time mode is set the virtual time is set to the specified start time.
+    It should be set before the devices are started, as the time may jump when the mode is changed.
+  */
+  static void SetClockMode(ClockMode mode, double virtualStartTimeSec = 0.0);
+  static ClockMode GetClockMode();
+  static bool IsVirtualTime();
+
+  /*! Advance the virtual time. The time is not changed if it is already past the specified time. */
+  static void AdvanceVirtualTime(double timeSec);
+
+  static std::string GetClockModeAsString(ClockMode mode);
+  /*! Get the clock mode from its string representation (RealTime or VirtualTime), returns false if the string is not recognized */
+  static bool GetClockModeFromString(const std::string& modeString, ClockMode& mode);
+
+private:
+  PlusClock();
+};
+
+#endif // __PlusClock_h
@@ -0,0 +1,189 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file PixelCodecTest.cxx
+  \brief Tests that PixelCodec::ConvertAndFlip gives the same result as converting the image by ConvertToGray or
+  ConvertToBmp24 and then flipping it, for each supported input encoding, output format, and flip combination.
+*/
+
+// Local includes
+#include "PlusConfigure.h"
+#include "PixelCodec.h"
+
+// VTK includes
+#include <vtksys/CommandLineArguments.hxx>
+
+// STL includes
+#include <vector>
+
+namespace
+{
+  // Width must be even for YUY2 input
+  const int IMAGE_WIDTH = 6;
+  const int IMAGE_HEIGHT = 5;
+  const int IMAGE_DEPTH = 3;
+
+  //----------------------------------------------------------------------------
+  int GetInputBytesPerPixel(PixelCodec::PixelEncoding encoding)
+  {
+    switch (encoding)
+    {
+      case PixelCodec::PixelEncoding_RGBA32:
+        return 4;
+      case PixelCodec::PixelEncoding_YUY2:
+        return 2;
+      default:
+        return 3;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  // Convert the image slice by slice with the scalar conversion functions and then flip it
+  PlusStatus ComputeReference(PixelCodec::PixelEncoding encoding, int outputNumberOfComponents, bool flipX, bool flipY, bool flipZ,
+                              std::vector<unsigned char>& input, std::vector<unsigned char>& reference)
+  {
+    const size_t inputSliceSizeBytes = static_cast<size_t>(IMAGE_WIDTH) * IMAGE_HEIGHT * GetInputBytesPerPixel(encoding);
+    const size_t outputSliceSizeBytes = static_cast<size_t>(IMAGE_WIDTH) * IMAGE_HEIGHT * outputNumberOfComponents;
+    std::vector<unsigned char> converted(outputSliceSizeBytes * IMAGE_DEPTH);
+    for (int z = 0; z < IMAGE_DEPTH; ++z)
+    {
+      unsigned char* inputSlice = &input[z * inputSliceSizeBytes];
+      unsigned char* convertedSlice = &converted[z * outputSliceSizeBytes];
+      PlusStatus status = PLUS_FAIL;
+      if (outputNumberOfComponents == 1)
+      {
+        status = PixelCodec::ConvertToGray(encoding, IMAGE_WIDTH, IMAGE_HEIGHT, inputSlice, convertedSlice);
+      }
+      else
+      {
+        // RGBA ordering of RGBA32 input gives RGB output, RGB ordering would swap the R and B components
+        PixelCodec::ComponentOrdering ordering = (encoding == PixelCodec::PixelEncoding_RGBA32 ? PixelCodec::ComponentOrder_RGBA : PixelCodec::ComponentOrder_RGB);
+        status = PixelCodec::ConvertToBmp24(ordering, encoding, IMAGE_WIDTH, IMAGE_HEIGHT, inputSlice, convertedSlice);
+      }
+      if (status != PLUS_SUCCESS)
+      {
+        return PLUS_FAIL;
+      }
+    }
+
+    reference.resize(converted.size());
+    for (int z = 0; z < IMAGE_DEPTH; ++z)
+    {
+      const int inputZ = (flipZ ? IMAGE_DEPTH - 1 - z : z);
+      for (int y = 0; y < IMAGE_HEIGHT; ++y)
+      {
+        const int inputY = (flipY ? IMAGE_HEIGHT - 1 - y : y);
+        for (int x = 0; x < IMAGE_WIDTH; ++x)
+        {
+          const int inputX = (flipX ? IMAGE_WIDTH - 1 - x : x);
+          for (int c = 0; c < outputNumberOfComponents; ++c)
+          {
+            reference[((z * IMAGE_HEIGHT + y) * IMAGE_WIDTH + x) * outputNumberOfComponents + c] =
+              converted[((inputZ * IMAGE_HEIGHT + inputY) * IMAGE_WIDTH + inputX) * outputNumberOfComponents + c];
+          }
+        }
+      }
+    }
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  int TestConvertAndFlip(PixelCodec::PixelEncoding encoding, int outputNumberOfComponents, bool flipX, bool flipY, bool flipZ)
+  {
+    // Fill the input with a deterministic pseudo-random pattern that covers the full value range
+    std::vector<unsigned char> input(static_cast<size_t>(IMAGE_WIDTH) * IMAGE_HEIGHT * IMAGE_DEPTH * GetInputBytesPerPixel(encoding));
+    unsigned int seed = 12345 + static_cast<unsigned int>(encoding);
+    for (size_t i = 0; i < input.size(); ++i)
+    {
+      seed = seed * 1103515245 + 12345;
+      input[i] = static_cast<unsigned char>(seed >> 16);
+    }
+
+    std::vector<unsigned char> reference;
+    if (ComputeReference(encoding, outputNumberOfComponents, flipX, flipY, flipZ, input, reference) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to compute the reference image for " << PixelCodec::GetCompressionModeAsString(encoding));
+      return 1;
+    }
+
+    std::vector<unsigned char> output(reference.size(), 0);
+    if (PixelCodec::ConvertAndFlip(encoding, outputNumberOfComponents, IMAGE_WIDTH, IMAGE_HEIGHT, IMAGE_DEPTH, flipX, flipY, flipZ, &input[0], &output[0]) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("ConvertAndFlip failed for " << PixelCodec::GetCompressionModeAsString(encoding));
+      return 1;
+    }
+
+    for (size_t i = 0; i < output.size(); ++i)
+    {
+      if (output[i] != reference[i])
+      {
+        LOG_ERROR("ConvertAndFlip result differs from the reference for " << PixelCodec::GetCompressionModeAsString(encoding)
+                  << " to " << outputNumberOfComponents << " components, flip (" << flipX << ", " << flipY << ", " << flipZ << ") at byte " << i
+                  << ": " << static_cast<int>(output[i]) << " (expected " << static_cast<int>(reference[i]) << ")");
+        return 1;
+      }
+    }
+    return 0;
+  }
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  const PixelCodec::PixelEncoding encodings[] =
+  {
+    PixelCodec::PixelEncoding_RGB24,
+    PixelCodec::PixelEncoding_BGR24,
+    PixelCodec::PixelEncoding_RGBA32,
+    PixelCodec::PixelEncoding_YUY2
+  };
+  const int outputNumberOfComponents[] = { 1, 3 };
+
+  int numberOfErrors(0);
+  for (size_t encodingIndex = 0; encodingIndex < sizeof(encodings) / sizeof(encodings[0]); ++encodingIndex)
+  {
+    for (size_t componentsIndex = 0; componentsIndex < sizeof(outputNumberOfComponents) / sizeof(outputNumberOfComponents[0]); ++componentsIndex)
+    {
+      // All combinations of flipping along the X, Y, and Z axes
+      for (int flip = 0; flip < 8; ++flip)
+      {
+        numberOfErrors += TestConvertAndFlip(encodings[encodingIndex], outputNumberOfComponents[componentsIndex], (flip & 1) != 0, (flip & 2) != 0, (flip & 4) != 0);
+      }
+    }
+  }
+
+  if (numberOfErrors != 0)
+  {
+    LOG_INFO("Test failed!");
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("Test completed successfully!");
+  return EXIT_SUCCESS;
+}
@@ -239,7 +239,7 @@ PlusStatus vtkPlusImageProcessorVideoSource::InternalUpdate()
   if (this->InputChannels[0]->GetTrackedFrame(trackedFrame) != PLUS_SUCCESS)
   {
     LOG_ERROR("Error while getting latest tracked frame. Last recorded timestamp: " << std::fixed << this->LastProcessedInputDataTimestamp << ". Device ID: " << this->GetDeviceId());
-    this->LastProcessedInputDataTimestamp = vtkIGSIOAccurateTimer::GetSystemTime(); // forget about the past, try to add frames that are acquired from now on
+    this->LastProcessedInputDataTimestamp = PlusClock::GetSystemTime(); // forget about the past, try to add frames that are acquired from now on
     return PLUS_FAIL;
   }
 
@@ -353,6 +353,6 @@ void vtkPlusImageProcessorVideoSource::SetEnableProcessing(bool aValue)
   if (processingStartsNow)
   {
     this->LastProcessedInputDataTimestamp = 0.0;
-    this->RecordingStartTime = vtkIGSIOAccurateTimer::GetSystemTime(); // reset the starting time for the grace period
+    this->RecordingStartTime = PlusClock::GetSystemTime(); // reset the starting time for the grace period
   }
 }
@@ -646,21 +646,6 @@ PlusStatus vtkPlusMmfVideoSource::AddFrame(unsigned char* bufferData, DWORD buff
     return PLUS_FAIL;
   }
 
-  if (videoSource->GetImageType() == US_IMG_RGB_COLOR)
-  {
-    decodingStatus = PixelCodec::ConvertToBmp24(PixelCodec::ComponentOrder_RGB, encoding, frameSize[0], frameSize[1], bufferData, (unsigned char*)this->UncompressedVideoFrame.GetScalarPointer());
-  }
-  else
-  {
-    decodingStatus = PixelCodec::ConvertToGray(encoding, frameSize[0], frameSize[1], bufferData, (unsigned char*)this->UncompressedVideoFrame.GetScalarPointer());
-  }
-
-  if (decodingStatus != PLUS_SUCCESS)
-  {
-    LOG_ERROR("Error while decoding the grabbed image");
-    return PLUS_FAIL;
-  }
-
   this->FrameIndex++;
   vtkPlusDataSource* aSource(NULL);
   if (this->GetFirstVideoSource(aSource) != PLUS_SUCCESS)
@@ -690,6 +675,31 @@ PlusStatus vtkPlusMmfVideoSource::AddFrame(unsigned char* bufferData, DWORD buff
       return PLUS_SUCCESS;
     }
   }
+
+  // Single-pass conversion requires even width for YUY2, frames of odd width are decoded the same way as before
+  if (encoding != PixelCodec::PixelEncoding_MJPG && (encoding != PixelCodec::PixelEncoding_YUY2 || frameSize[0] % 2 == 0))
+  {
+    // Decoding, reorientation and copy into the buffer in a single pass
+    PlusStatus status = aSource->AddItem(bufferData, encoding, aSource->GetInputImageOrientation(), frameSize, this->FrameIndex, currentTime);
+    this->Modified();
+    return status;
+  }
+
+  if (videoSource->GetImageType() == US_IMG_RGB_COLOR)
+  {
+    decodingStatus = PixelCodec::ConvertToBmp24(PixelCodec::ComponentOrder_RGB, encoding, frameSize[0], frameSize[1], bufferData, (unsigned char*)this->UncompressedVideoFrame.GetScalarPointer());
+  }
+  else
+  {
+    decodingStatus = PixelCodec::ConvertToGray(encoding, frameSize[0], frameSize[1], bufferData, (unsigned char*)this->UncompressedVideoFrame.GetScalarPointer());
+  }
+
+  if (decodingStatus != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Error while decoding the grabbed image");
+    return PLUS_FAIL;
+  }
+
   PlusStatus status = aSource->AddItem(&this->UncompressedVideoFrame, this->FrameIndex, currentTime);
 
   this->Modified();
@@ -0,0 +1,368 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+#include "PlusConfigure.h"
+#include "PlusAcquisitionScheduler.h"
+#include "vtkPlusDevice.h"
+
+#include <chrono>
+#include <vector>
+
+#if !defined(_WIN32)
+  #include <errno.h>
+  #include <fcntl.h>
+  #include <poll.h>
+  #include <string.h>
+  #include <unistd.h>
+#endif
+
+//----------------------------------------------------------------------------
+PlusAcquisitionScheduler::PlusAcquisitionScheduler(int numberOfWorkerThreads)
+  : NumberOfWorkerThreads(numberOfWorkerThreads > 0 ? numberOfWorkerThreads : 1)
+  , NextDeviceOrder(0)
+  , Threader(vtkSmartPointer<vtkMultiThreader>::New())
+  , ThreadsStarted(false)
+  , StopRequested(false)
+  , Suspended(false)
+  , NumberOfActiveThreads(0)
+  , NumberOfRunningUpdates(0)
+{
+  this->WakeUpPipe[0] = -1;
+  this->WakeUpPipe[1] = -1;
+}
+
+//----------------------------------------------------------------------------
+PlusAcquisitionScheduler::~PlusAcquisitionScheduler()
+{
+  this->Stop();
+}
+
+//----------------------------------------------------------------------------
+PlusStatus PlusAcquisitionScheduler::AddDevice(vtkPlusDevice* device)
+{
+  if (device == NULL)
+  {
+    LOG_ERROR("PlusAcquisitionScheduler::AddDevice failed: invalid device");
+    return PLUS_FAIL;
+  }
+
+  std::lock_guard<std::mutex> lock(this->Mutex);
+  if (this->StartThreads() != PLUS_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
+  if (this->Devices.find(device) != this->Devices.end())
+  {
+    LOG_DEBUG("Device " << device->GetDeviceId() << " is already scheduled");
+    return PLUS_SUCCESS;
+  }
+
+  ScheduledDevice& scheduledDevice = this->Devices[device];
+  scheduledDevice.Order = this->NextDeviceOrder++;
+  scheduledDevice.FileDescriptor = -1;
+  scheduledDevice.DueTime = 0.0;
+  scheduledDevice.Queued = false;
+  scheduledDevice.Running = false;
+  scheduledDevice.WaitingForReadiness = false;
+#if !defined(_WIN32)
+  scheduledDevice.FileDescriptor = device->GetInternalUpdateFileDescriptor();
+#endif
+
+  if (scheduledDevice.FileDescriptor >= 0)
+  {
+    scheduledDevice.WaitingForReadiness = true;
+    this->NotifyReadinessThread();
+  }
+  else
+  {
+    this->QueueDevice(device, scheduledDevice, PlusClock::GetSystemTime());
+  }
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+void PlusAcquisitionScheduler::RemoveDevice(vtkPlusDevice* device)
+{
+  std::unique_lock<std::mutex> lock(this->Mutex);
+  std::map<vtkPlusDevice*, ScheduledDevice>::iterator deviceIt = this->Devices.find(device);
+  if (deviceIt == this->Devices.end())
+  {
+    return;
+  }
+
+  // Wait for the completion of the current update. If the worker queued the device again
+  // then it is removed from the queue below.
+  while (deviceIt != this->Devices.end() && deviceIt->second.Running)
+  {
+    this->UpdateCompleted.wait(lock);
+    deviceIt = this->Devices.find(device);
+  }
+  if (deviceIt == this->Devices.end())
+  {
+    return;
+  }
+
+  if (deviceIt->second.Queued)
+  {
+    this->DueDevices.erase(DueUpdate(deviceIt->second.DueTime, deviceIt->second.Order, device));
+  }
+  bool waitingForReadiness = deviceIt->second.WaitingForReadiness;
+  this->Devices.erase(deviceIt);
+  if (waitingForReadiness)
+  {
+    // the device may close its file descriptor after it is removed, it must not be polled anymore
+    this->NotifyReadinessThread();
+  }
+}
+
+//----------------------------------------------------------------------------
+void PlusAcquisitionScheduler::Stop()
+{
+  std::unique_lock<std::mutex> lock(this->Mutex);
+  if (!this->ThreadsStarted)
+  {
+    return;
+  }
+
+  this->StopRequested = true;
+  this->UpdateQueued.notify_all();
+  this->NotifyReadinessThread();
+  while (this->NumberOfActiveThreads > 0)
+  {
+    this->UpdateCompleted.wait(lock);
+  }
+
+#if !defined(_WIN32)
+  for (int i = 0; i < 2; ++i)
+  {
+    if (this->WakeUpPipe[i] >= 0)
+    {
+      close(this->WakeUpPipe[i]);
+      this->WakeUpPipe[i] = -1;
+    }
+  }
+#endif
+
+  this->Devices.clear();
+  this->DueDevices.clear();
+  this->ThreadsStarted = false;
+  this->StopRequested = false;
+}
+
+//----------------------------------------------------------------------------
+void PlusAcquisitionScheduler::SetSuspended(bool suspended)
+{
+  std::lock_guard<std::mutex> lock(this->Mutex);
+  this->Suspended = suspended;
+  if (!suspended)
+  {
+    this->UpdateQueued.notify_all();
+  }
+}
+
+//----------------------------------------------------------------------------
+PlusStatus PlusAcquisitionScheduler::StartThreads()
+{
+  if (this->ThreadsStarted)
+  {
+    return PLUS_SUCCESS;
+  }
+
+#if !defined(_WIN32)
+  if (pipe(this->WakeUpPipe) != 0)
+  {
+    LOG_ERROR("Failed to create the wake-up pipe of the acquisition scheduler: " << strerror(errno));
+    return PLUS_FAIL;
+  }
+  // the readiness thread drains the pipe without blocking
+  fcntl(this->WakeUpPipe[0], F_SETFL, fcntl(this->WakeUpPipe[0], F_GETFL) | O_NONBLOCK);
+  fcntl(this->WakeUpPipe[1], F_SETFL, fcntl(this->WakeUpPipe[1], F_GETFL) | O_NONBLOCK);
+#endif
+
+  for (int i = 0; i < this->NumberOfWorkerThreads; ++i)
+  {
+    this->Threader->SpawnThread((vtkThreadFunctionType)&WorkerThread, this);
+    this->NumberOfActiveThreads++;
+  }
+#if !defined(_WIN32)
+  this->Threader->SpawnThread((vtkThreadFunctionType)&ReadinessThread, this);
+  this->NumberOfActiveThreads++;
+#endif
+
+  this->ThreadsStarted = true;
+  LOG_DEBUG("Acquisition scheduler started with " << this->NumberOfWorkerThreads << " worker threads");
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+void PlusAcquisitionScheduler::QueueDevice(vtkPlusDevice* device, ScheduledDevice& scheduledDevice, double dueTime)
+{
+  scheduledDevice.DueTime = dueTime;
+  scheduledDevice.Queued = true;
+  this->DueDevices.insert(DueUpdate(dueTime, scheduledDevice.Order, device));
+  this->UpdateQueued.notify_one();
+}
+
+//----------------------------------------------------------------------------
+void PlusAcquisitionScheduler::NotifyReadinessThread()
+{
+#if !defined(_WIN32)
+  if (this->WakeUpPipe[1] >= 0)
+  {
+    const char wakeUp = 0;
+    // if the pipe is full then the thread is already notified
+    ssize_t written = write(this->WakeUpPipe[1], &wakeUp, 1);
+    (void)written;
+  }
+#endif
+}
+
+//----------------------------------------------------------------------------
+void* PlusAcquisitionScheduler::WorkerThread(vtkMultiThreader::ThreadInfo* data)
+{
+  PlusAcquisitionScheduler* self = (PlusAcquisitionScheduler*)(data->UserData);
+
+  std::unique_lock<std::mutex> lock(self->Mutex);
+  while (!self->StopRequested)
+  {
+    if (self->DueDevices.empty() || self->Suspended)
+    {
+      self->UpdateQueued.wait(lock);
+      continue;
+    }
+    double updateStartTime = PlusClock::GetSystemTime();
+    std::set<DueUpdate>::iterator nextUpdate = self->DueDevices.begin();
+    const double dueTime = std::get<0>(*nextUpdate);
+    if (dueTime > updateStartTime)
+    {
+      if (PlusClock::IsVirtualTime())
+      {
+        if (self->NumberOfRunningUpdates == 0)
+        {
+          // Nothing can happen until the next update, so skip the waiting
+          PlusClock::AdvanceVirtualTime(dueTime);
+        }
+        else
+        {
+          // The running updates may queue updates that are due earlier
+          self->UpdateCompleted.wait(lock);
+        }
+        continue;
+      }
+      self->UpdateQueued.wait_for(lock, std::chrono::duration<double>(dueTime - updateStartTime));
+      continue;
+    }
+
+    vtkPlusDevice* device = std::get<2>(*nextUpdate);
+    self->DueDevices.erase(nextUpdate);
+    ScheduledDevice& scheduledDevice = self->Devices[device];
+    scheduledDevice.Queued = false;
+    scheduledDevice.Running = true;
+    self->NumberOfRunningUpdates++;
+
+    lock.unlock();
+    bool continueUpdates = device->ExecuteInternalUpdate(updateStartTime);
+    lock.lock();
+
+    // The device is not removed from the map while it is running
+    scheduledDevice.Running = false;
+    self->NumberOfRunningUpdates--;
+    if (!continueUpdates)
+    {
+      // recording has been stopped
+      self->Devices.erase(device);
+    }
+    else if (scheduledDevice.FileDescriptor >= 0)
+    {
+      scheduledDevice.WaitingForReadiness = true;
+      self->NotifyReadinessThread();
+    }
+    else
+    {
+      self->QueueDevice(device, scheduledDevice, updateStartTime + 1.0 / device->GetAcquisitionRate());
+    }
+    self->UpdateCompleted.notify_all();
+  }
+
+  self->NumberOfActiveThreads--;
+  self->UpdateCompleted.notify_all();
+  return NULL;
+}
+
+//----------------------------------------------------------------------------
+void* PlusAcquisitionScheduler::ReadinessThread(vtkMultiThreader::ThreadInfo* data)
+{
+  PlusAcquisitionScheduler* self = (PlusAcquisitionScheduler*)(data->UserData);
+
+#if !defined(_WIN32)
+  std::vector<pollfd> pollFileDescriptors;
+  std::vector<vtkPlusDevice*> polledDevices;
+
+  std::unique_lock<std::mutex> lock(self->Mutex);
+  while (!self->StopRequested)
+  {
+    pollFileDescriptors.clear();
+    polledDevices.clear();
+    pollfd wakeUp = { self->WakeUpPipe[0], POLLIN, 0 };
+    pollFileDescriptors.push_back(wakeUp);
+    for (std::map<vtkPlusDevice*, ScheduledDevice>::iterator deviceIt = self->Devices.begin(); deviceIt != self->Devices.end(); ++deviceIt)
+    {
+      if (deviceIt->second.WaitingForReadiness)
+      {
+        pollfd deviceFileDescriptor = { deviceIt->second.FileDescriptor, POLLIN, 0 };
+        pollFileDescriptors.push_back(deviceFileDescriptor);
+        polledDevices.push_back(deviceIt->first);
+      }
+    }
+
+    lock.unlock();
+    int numberOfReadyFileDescriptors = poll(&pollFileDescriptors[0], pollFileDescriptors.size(), -1);
+    lock.lock();
+
+    if (numberOfReadyFileDescriptors < 0)
+    {
+      if (errno != EINTR)
+      {
+        LOG_ERROR("Failed to wait for the devices of the acquisition scheduler: " << strerror(errno));
+        break;
+      }
+      continue;
+    }
+
+    if (pollFileDescriptors[0].revents != 0)
+    {
+      char buffer[64];
+      while (read(self->WakeUpPipe[0], buffer, sizeof(buffer)) > 0)
+      {
+      }
+    }
+
+    const double readyTime = PlusClock::GetSystemTime();
+    for (size_t i = 1; i < pollFileDescriptors.size(); ++i)
+    {
+      if (pollFileDescriptors[i].revents == 0)
+      {
+        continue;
+      }
+      // The device may have been removed while the lock was released
+      std::map<vtkPlusDevice*, ScheduledDevice>::iterator deviceIt = self->Devices.find(polledDevices[i - 1]);
+      if (deviceIt == self->Devices.end() || !deviceIt->second.WaitingForReadiness)
+      {
+        continue;
+      }
+      // Errors are reported by the internal update of the device
+      deviceIt->second.WaitingForReadiness = false;
+      self->QueueDevice(deviceIt->first, deviceIt->second, readyTime);
+    }
+  }
+#else
+  std::unique_lock<std::mutex> lock(self->Mutex);
+#endif
+
+  self->NumberOfActiveThreads--;
+  self->UpdateCompleted.notify_all();
+  return NULL;
+}
@@ -0,0 +1,126 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+#ifndef __PlusAcquisitionScheduler_h
+#define __PlusAcquisitionScheduler_h
+
+#include "PlusConfigure.h"
+#include "vtkPlusDataCollectionExport.h"
+
+#include <vtkMultiThreader.h>
+#include <vtkSmartPointer.h>
+
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <set>
+#include <tuple>
+
+class vtkPlusDevice;
+
+/*!
+  \class PlusAcquisitionScheduler
+  \brief Calls the internal update of devices from a shared pool of worker threads
+
+  Devices that would start their own data capture thread (see vtkPlusDevice::StartThreadForInternalUpdates)
+  can be added to the scheduler instead. Rate-driven devices are kept in a queue ordered by the time of their
+  next update, which is the start time of the previous update plus one acquisition period (the same as in the
+  data capture thread of the device). Devices that provide a file descriptor (see vtkPlusDevice::GetInternalUpdateFileDescriptor)
+  are updated when the file descriptor becomes readable. The internal update of a device is never called
+  from more than one thread at the same time.
+
+  Readiness notification is only available on POSIX systems, on Windows all devices are updated at their acquisition rate.
+
+  In virtual-time mode (see PlusClock) the scheduler does not wait for the due time of the next update:
+  when no update is running, it advances the virtual time to the due time. Updates that are due at the same time
+  are performed in the order the devices were added, so with a single worker thread the updates are deterministic.
+
+  \ingroup PlusLibDataCollection
+*/
+class vtkPlusDataCollectionExport PlusAcquisitionScheduler
+{
+public:
+  /*! \param numberOfWorkerThreads Number of threads that call the internal update of the devices */
+  PlusAcquisitionScheduler(int numberOfWorkerThreads);
+  virtual ~PlusAcquisitionScheduler();
+
+  int GetNumberOfWorkerThreads() const { return this->NumberOfWorkerThreads; }
+
+  /*! Start updating the device. The worker threads are started when the first device is added. */
+  PlusStatus AddDevice(vtkPlusDevice* device);
+
+  /*!
+    Stop updating the device. If the device is being updated then the method waits until the update is completed,
+    therefore it must not be called from the internal update of the device.
+  */
+  void RemoveDevice(vtkPlusDevice* device);
+
+  /*! Stop all the threads. Devices that have not been removed are not updated anymore. */
+  void Stop();
+
+  /*!
+    Suspend or resume the updates. Updates that are running are completed, but no new updates are started while suspended.
+    Can be used for adding all the devices before the virtual time starts to advance.
+  */
+  void SetSuspended(bool suspended);
+
+protected:
+  /*! Due time of an update, the order of the device, and the device */
+  typedef std::tuple<double, unsigned long, vtkPlusDevice*> DueUpdate;
+
+  struct ScheduledDevice
+  {
+    /*! Order in which the device was added, it determines the order of updates that are due at the same time */
+    unsigned long Order;
+    /*! File descriptor of the device, -1 if the device is updated at its acquisition rate */
+    int FileDescriptor;
+    /*! Time of the next update, if the device is in the queue */
+    double DueTime;
+    bool Queued;
+    bool Running;
+    /*! The device waits for its file descriptor to become readable */
+    bool WaitingForReadiness;
+  };
+
+  static void* WorkerThread(vtkMultiThreader::ThreadInfo* data);
+  static void* ReadinessThread(vtkMultiThreader::ThreadInfo* data);
+
+  /*! Start the threads if they are not running yet. Mutex must be locked. */
+  PlusStatus StartThreads();
+  /*! Put the device in the queue of updates. Mutex must be locked. */
+  void QueueDevice(vtkPlusDevice* device, ScheduledDevice& scheduledDevice, double dueTime);
+  /*! Wake up the readiness thread to update its list of file descriptors. Mutex must be locked. */
+  void NotifyReadinessThread();
+
+  int NumberOfWorkerThreads;
+
+  std::mutex Mutex;
+  /*! Notified when a device is queued or the threads should stop */
+  std::condition_variable UpdateQueued;
+  /*! Notified when a device update is completed or a thread stops */
+  std::condition_variable UpdateCompleted;
+
+  std::map<vtkPlusDevice*, ScheduledDevice> Devices;
+  /*! Queue of updates, ordered by due time */
+  std::set<DueUpdate> DueDevices;
+  unsigned long NextDeviceOrder;
+
+  vtkSmartPointer<vtkMultiThreader> Threader;
+  bool ThreadsStarted;
+  bool StopRequested;
+  bool Suspended;
+  int NumberOfActiveThreads;
+  int NumberOfRunningUpdates;
+
+  /*! Pipe used for interrupting the wait of the readiness thread */
+  int WakeUpPipe[2];
+
+private:
+  PlusAcquisitionScheduler(const PlusAcquisitionScheduler&);
+  PlusAcquisitionScheduler& operator=(const PlusAcquisitionScheduler&);
+};
+
+#endif
@@ -0,0 +1,473 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+#include "PlusConfigure.h"
+#include "PlusBufferSpillFile.h"
+
+#if defined(_WIN32)
+  #include <windows.h>
+#else
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdint.h>
+
+namespace
+{
+  //----------------------------------------------------------------------------
+  // Fixed-size part of a record, followed by the pixel data and the frame fields
+  struct RecordHeader
+  {
+    uint64_t Uid;
+    uint64_t Index;
+    double FilteredTimestamp;
+    double UnfilteredTimestamp;
+    double MatrixElements[16];
+    int32_t Status;
+    int32_t ValidTransformData;
+    uint32_t FrameSize[3];
+    int32_t PixelType;
+    uint32_t NumberOfScalarComponents;
+    int32_t ImageType;
+    int32_t ImageOrientation;
+    uint32_t NumberOfFields;
+    uint64_t PixelDataSizeBytes;
+    uint64_t FieldDataSizeBytes;
+  };
+
+  //----------------------------------------------------------------------------
+  size_t RoundUp(size_t value, size_t alignment)
+  {
+    return ((value + alignment - 1) / alignment) * alignment;
+  }
+
+  //----------------------------------------------------------------------------
+  void WriteUInt32(unsigned char*& destination, uint32_t value)
+  {
+    memcpy(destination, &value, sizeof(value));
+    destination += sizeof(value);
+  }
+
+  //----------------------------------------------------------------------------
+  uint32_t ReadUInt32(const unsigned char*& source)
+  {
+    uint32_t value(0);
+    memcpy(&value, source, sizeof(value));
+    source += sizeof(value);
+    return value;
+  }
+}
+
+//----------------------------------------------------------------------------
+PlusBufferSpillFile::PlusBufferSpillFile()
+  : Memory(NULL)
+  , CapacityBytes(0)
+  , WriteOffset(0)
+  , ReleasedOffset(0)
+  , PageSizeBytes(4096)
+#if defined(_WIN32)
+  , FileHandle(NULL)
+  , FileMappingHandle(NULL)
+#endif
+{
+}
+
+//----------------------------------------------------------------------------
+PlusBufferSpillFile::~PlusBufferSpillFile()
+{
+  this->Close();
+}
+
+//----------------------------------------------------------------------------
+PlusStatus PlusBufferSpillFile::Open(const std::string& filePath, size_t capacityBytes)
+{
+  this->Close();
+
+  if (capacityBytes == 0)
+  {
+    LOG_ERROR("Invalid spill file size requested: " << capacityBytes << " bytes");
+    return PLUS_FAIL;
+  }
+  capacityBytes = RoundUp(capacityBytes, RECORD_ALIGNMENT_BYTES);
+
+#if defined(_WIN32)
+  SYSTEM_INFO systemInfo;
+  GetSystemInfo(&systemInfo);
+  this->PageSizeBytes = systemInfo.dwPageSize;
+
+  // The file is deleted by the operating system when the last handle is closed
+  HANDLE fileHandle = CreateFileA(filePath.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+                                  FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, NULL);
+  if (fileHandle == INVALID_HANDLE_VALUE)
+  {
+    LOG_ERROR("Failed to create spill file " << filePath);
+    return PLUS_FAIL;
+  }
+  const unsigned long long capacity = capacityBytes;
+  HANDLE fileMappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READWRITE,
+                             static_cast<DWORD>(capacity >> 32), static_cast<DWORD>(capacity & 0xFFFFFFFF), NULL);
+  if (fileMappingHandle == NULL)
+  {
+    LOG_ERROR("Failed to create a " << capacityBytes << " bytes large spill file " << filePath);
+    CloseHandle(fileHandle);
+    return PLUS_FAIL;
+  }
+  void* memory = MapViewOfFile(fileMappingHandle, FILE_MAP_ALL_ACCESS, 0, 0, capacityBytes);
+  if (memory == NULL)
+  {
+    LOG_ERROR("Failed to map spill file " << filePath);
+    CloseHandle(fileMappingHandle);
+    CloseHandle(fileHandle);
+    return PLUS_FAIL;
+  }
+  this->FileHandle = fileHandle;
+  this->FileMappingHandle = fileMappingHandle;
+#else
+  this->PageSizeBytes = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+
+  int fileDescriptor = open(filePath.c_str(), O_RDWR | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+  if (fileDescriptor < 0)
+  {
+    LOG_ERROR("Failed to create spill file " << filePath);
+    return PLUS_FAIL;
+  }
+#if defined(__linux__)
+  // Reserve the disk space now, so that writing to the mapped memory cannot fail later because the disk is full
+  bool resized = (posix_fallocate(fileDescriptor, 0, static_cast<off_t>(capacityBytes)) == 0);
+#else
+  bool resized = (ftruncate(fileDescriptor, static_cast<off_t>(capacityBytes)) == 0);
+#endif
+  void* memory = resized ? mmap(NULL, capacityBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fileDescriptor, 0) : MAP_FAILED;
+  // The mapping keeps the file content available, the file can be removed from the file system right away
+  close(fileDescriptor);
+  unlink(filePath.c_str());
+  if (!resized)
+  {
+    LOG_ERROR("Failed to create a " << capacityBytes << " bytes large spill file " << filePath);
+    return PLUS_FAIL;
+  }
+  if (memory == MAP_FAILED)
+  {
+    LOG_ERROR("Failed to map spill file " << filePath);
+    return PLUS_FAIL;
+  }
+#endif
+
+  this->FilePath = filePath;
+  this->Memory = static_cast<unsigned char*>(memory);
+  this->CapacityBytes = capacityBytes;
+  this->WriteOffset = 0;
+  this->ReleasedOffset = 0;
+  this->Records.clear();
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+void PlusBufferSpillFile::Close()
+{
+  this->Records.clear();
+  if (this->Memory == NULL)
+  {
+    return;
+  }
+
+#if defined(_WIN32)
+  UnmapViewOfFile(this->Memory);
+  CloseHandle(static_cast<HANDLE>(this->FileMappingHandle));
+  CloseHandle(static_cast<HANDLE>(this->FileHandle));
+  this->FileMappingHandle = NULL;
+  this->FileHandle = NULL;
+#else
+  munmap(this->Memory, this->CapacityBytes);
+#endif
+
+  this->Memory = NULL;
+  this->CapacityBytes = 0;
+  this->WriteOffset = 0;
+  this->ReleasedOffset = 0;
+  this->FilePath.clear();
+}
+
+//----------------------------------------------------------------------------
+void PlusBufferSpillFile::Clear()
+{
+  this->Records.clear();
+  this->WriteOffset = 0;
+  this->ReleasedOffset = 0;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus PlusBufferSpillFile::AppendItem(const StreamBufferItem* item)
+{
+  if (this->Memory == NULL || item == NULL)
+  {
+    return PLUS_FAIL;
+  }
+  if (!this->Records.empty() && item->GetUid() <= this->Records.back().Uid)
+  {
+    LOG_ERROR("Unable to add item to spill file: item UID (" << item->GetUid() << ") is not larger than the latest UID in the file (" << this->Records.back().Uid << ")");
+    return PLUS_FAIL;
+  }
+
+  RecordHeader header;
+  memset(&header, 0, sizeof(header));
+  header.Uid = item->GetUid();
+  header.Index = item->GetIndex();
+  header.FilteredTimestamp = item->GetFilteredTimestamp(0.0);   // 0.0 because timestamps are stored in local time
+  header.UnfilteredTimestamp = item->GetUnfilteredTimestamp(0.0);
+  item->GetMatrixElements(header.MatrixElements);
+  header.Status = item->GetStatus();
+  header.ValidTransformData = item->HasValidTransformData() ? 1 : 0;
+
+  // The frame is not modified, but not all the accessors of igsioVideoFrame are const
+  igsioVideoFrame& frame = const_cast<StreamBufferItem*>(item)->GetFrame();
+  const void* pixelData = NULL;
+  if (!frame.IsFrameEncoded() && frame.IsImageValid())
+  {
+    FrameSizeType frameSize = { 0, 0, 0 };
+    frame.GetFrameSize(frameSize);
+    unsigned int numberOfScalarComponents(1);
+    frame.GetNumberOfScalarComponents(numberOfScalarComponents);
+    std::copy(frameSize.begin(), frameSize.end(), header.FrameSize);
+    header.PixelType = frame.GetVTKScalarPixelType();
+    header.NumberOfScalarComponents = numberOfScalarComponents;
+    header.ImageType = frame.GetImageType();
+    header.ImageOrientation = frame.GetImageOrientation();
+    header.PixelDataSizeBytes = frame.GetFrameSizeInBytes();
+    pixelData = frame.GetScalarPointer();
+  }
+
+  const std::vector<PlusFrameFieldStore::Field>& fields = item->GetFrameFieldStore().GetFields();
+  header.NumberOfFields = static_cast<uint32_t>(fields.size());
+  for (std::vector<PlusFrameFieldStore::Field>::const_iterator fieldIt = fields.begin(); fieldIt != fields.end(); ++fieldIt)
+  {
+    header.FieldDataSizeBytes += 3 * sizeof(uint32_t) + fieldIt->Name->size() + fieldIt->Value->size();
+  }
+
+  const size_t recordSizeBytes = RoundUp(sizeof(RecordHeader) + header.PixelDataSizeBytes + header.FieldDataSizeBytes, RECORD_ALIGNMENT_BYTES);
+  if (recordSizeBytes > this->CapacityBytes)
+  {
+    LOG_ERROR("Unable to add item to spill file: item size (" << recordSizeBytes << " bytes) is larger than the file size (" << this->CapacityBytes << " bytes)");
+    return PLUS_FAIL;
+  }
+
+  //============== Make room for the record ==================
+
+  size_t offset = this->WriteOffset;
+  if (offset + recordSizeBytes > this->CapacityBytes)
+  {
+    // Continue at the beginning of the file. The records after the write offset are the oldest ones,
+    // they are discarded, because the records at the beginning of the file are newer.
+    while (!this->Records.empty() && this->Records.front().Offset >= offset)
+    {
+      this->Records.pop_front();
+    }
+    offset = 0;
+    this->ReleasedOffset = 0;
+  }
+  while (!this->Records.empty() && this->Records.front().Offset < offset + recordSizeBytes && this->Records.front().Offset + this->Records.front().SizeBytes > offset)
+  {
+    this->Records.pop_front();
+  }
+
+  //============== Write the record ==================
+
+  unsigned char* destination = this->Memory + offset;
+  memcpy(destination, &header, sizeof(header));
+  destination += sizeof(header);
+  if (pixelData != NULL)
+  {
+    memcpy(destination, pixelData, header.PixelDataSizeBytes);
+    destination += header.PixelDataSizeBytes;
+  }
+  for (std::vector<PlusFrameFieldStore::Field>::const_iterator fieldIt = fields.begin(); fieldIt != fields.end(); ++fieldIt)
+  {
+    WriteUInt32(destination, static_cast<uint32_t>(fieldIt->Name->size()));
+    memcpy(destination, fieldIt->Name->data(), fieldIt->Name->size());
+    destination += fieldIt->Name->size();
+    WriteUInt32(destination, static_cast<uint32_t>(fieldIt->Flags));
+    WriteUInt32(destination, static_cast<uint32_t>(fieldIt->Value->size()));
+    memcpy(destination, fieldIt->Value->data(), fieldIt->Value->size());
+    destination += fieldIt->Value->size();
+  }
+
+  RecordLocation record;
+  record.Uid = header.Uid;
+  record.FilteredTimestamp = header.FilteredTimestamp;
+  record.Offset = offset;
+  record.SizeBytes = recordSizeBytes;
+  this->Records.push_back(record);
+  this->WriteOffset = offset + recordSizeBytes;
+
+  // The written pages are not needed in memory anymore, the operating system writes them to the file
+  this->ReleasePages(this->ReleasedOffset, this->WriteOffset);
+  this->ReleasedOffset = std::max(this->ReleasedOffset, (this->WriteOffset / this->PageSizeBytes) * this->PageSizeBytes);
+
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+const PlusBufferSpillFile::RecordLocation* PlusBufferSpillFile::FindRecord(BufferItemUidType uid, ItemStatus& status) const
+{
+  if (this->Records.empty() || uid > this->Records.back().Uid)
+  {
+    status = ITEM_NOT_AVAILABLE_YET;
+    return NULL;
+  }
+  if (uid < this->Records.front().Uid)
+  {
+    status = ITEM_NOT_AVAILABLE_ANYMORE;
+    return NULL;
+  }
+  std::deque<RecordLocation>::const_iterator recordIt = std::lower_bound(this->Records.begin(), this->Records.end(), uid,
+      [](const RecordLocation & record, BufferItemUidType recordUid) { return record.Uid < recordUid; });
+  if (recordIt == this->Records.end() || recordIt->Uid != uid)
+  {
+    // item was not spilled (e.g., because the buffer was resized)
+    status = ITEM_UNKNOWN_ERROR;
+    return NULL;
+  }
+  status = ITEM_OK;
+  return &(*recordIt);
+}
+
+//----------------------------------------------------------------------------
+ItemStatus PlusBufferSpillFile::GetTimeStamp(BufferItemUidType uid, double& filteredTimestamp) const
+{
+  ItemStatus status = ITEM_UNKNOWN_ERROR;
+  const RecordLocation* record = this->FindRecord(uid, status);
+  filteredTimestamp = (record != NULL) ? record->FilteredTimestamp : 0;
+  return status;
+}
+
+//----------------------------------------------------------------------------
+ItemStatus PlusBufferSpillFile::GetIndex(BufferItemUidType uid, unsigned long& index) const
+{
+  ItemStatus status = ITEM_UNKNOWN_ERROR;
+  const RecordLocation* record = this->FindRecord(uid, status);
+  if (record == NULL)
+  {
+    index = 0;
+    return status;
+  }
+  RecordHeader header;
+  memcpy(&header, this->Memory + record->Offset, sizeof(header));
+  index = static_cast<unsigned long>(header.Index);
+  return ITEM_OK;
+}
+
+//----------------------------------------------------------------------------
+ItemStatus PlusBufferSpillFile::GetItemUidFromTime(double time, BufferItemUidType& uid) const
+{
+  if (this->Records.empty())
+  {
+    return ITEM_NOT_AVAILABLE_YET;
+  }
+  std::deque<RecordLocation>::const_iterator nextRecordIt = std::lower_bound(this->Records.begin(), this->Records.end(), time,
+      [](const RecordLocation & record, double recordTime) { return record.FilteredTimestamp < recordTime; });
+  if (nextRecordIt == this->Records.begin())
+  {
+    uid = nextRecordIt->Uid;
+    return ITEM_OK;
+  }
+  std::deque<RecordLocation>::const_iterator previousRecordIt = nextRecordIt - 1;
+  if (nextRecordIt == this->Records.end() || time - previousRecordIt->FilteredTimestamp < nextRecordIt->FilteredTimestamp - time)
+  {
+    uid = previousRecordIt->Uid;
+  }
+  else
+  {
+    uid = nextRecordIt->Uid;
+  }
+  return ITEM_OK;
+}
+
+//----------------------------------------------------------------------------
+ItemStatus PlusBufferSpillFile::GetItem(BufferItemUidType uid, StreamBufferItem* item)
+{
+  ItemStatus status = ITEM_UNKNOWN_ERROR;
+  const RecordLocation* record = this->FindRecord(uid, status);
+  if (record == NULL)
+  {
+    return status;
+  }
+
+  const unsigned char* source = this->Memory + record->Offset;
+  RecordHeader header;
+  memcpy(&header, source, sizeof(header));
+  source += sizeof(header);
+
+  item->SetUid(header.Uid);
+  item->SetIndex(static_cast<unsigned long>(header.Index));
+  item->SetFilteredTimestamp(header.FilteredTimestamp);
+  item->SetUnfilteredTimestamp(header.UnfilteredTimestamp);
+  item->SetMatrixElements(header.MatrixElements);
+  item->SetStatus(static_cast<ToolStatus>(header.Status));
+  item->SetValidTransformData(header.ValidTransformData != 0);
+
+  if (header.PixelDataSizeBytes > 0)
+  {
+    igsioVideoFrame& frame = item->GetFrame();
+    FrameSizeType frameSize = { header.FrameSize[0], header.FrameSize[1], header.FrameSize[2] };
+    if (frame.AllocateFrame(frameSize, header.PixelType, header.NumberOfScalarComponents) != PLUS_SUCCESS
+        || frame.GetFrameSizeInBytes() != header.PixelDataSizeBytes)
+    {
+      LOG_ERROR("Failed to allocate frame for item " << uid << " of the spill file");
+      return ITEM_UNKNOWN_ERROR;
+    }
+    memcpy(frame.GetScalarPointer(), source, header.PixelDataSizeBytes);
+    frame.SetImageType(static_cast<US_IMAGE_TYPE>(header.ImageType));
+    frame.SetImageOrientation(static_cast<US_IMAGE_ORIENTATION>(header.ImageOrientation));
+    source += header.PixelDataSizeBytes;
+  }
+  else
+  {
+    item->GetFrame() = igsioVideoFrame();
+  }
+
+  PlusFrameFieldStore fields;
+  for (uint32_t i = 0; i < header.NumberOfFields; ++i)
+  {
+    uint32_t nameSize = ReadUInt32(source);
+    std::string name(reinterpret_cast<const char*>(source), nameSize);
+    source += nameSize;
+    igsioFrameFieldFlags flags = static_cast<igsioFrameFieldFlags>(ReadUInt32(source));
+    uint32_t valueSize = ReadUInt32(source);
+    std::string value(reinterpret_cast<const char*>(source), valueSize);
+    source += valueSize;
+    fields.SetField(name, value, flags);
+  }
+  item->SetFrameFieldStore(fields);
+
+  // The record has been copied, its pages are not needed in memory anymore
+  this->ReleasePages(record->Offset, record->Offset + record->SizeBytes);
+
+  return ITEM_OK;
+}
+
+//----------------------------------------------------------------------------
+void PlusBufferSpillFile::ReleasePages(size_t beginOffset, size_t endOffset)
+{
+  size_t firstPageOffset = RoundUp(beginOffset, this->PageSizeBytes);
+  size_t endPageOffset = (endOffset / this->PageSizeBytes) * this->PageSizeBytes;
+  if (endPageOffset <= firstPageOffset)
+  {
+    return;
+  }
+#if defined(_WIN32)
+  // Removes the pages from the working set of the process, they are written to the file by the operating system
+  VirtualUnlock(this->Memory + firstPageOffset, endPageOffset - firstPageOffset);
+#else
+  // For shared file mappings the content is kept in the file, the pages are only unmapped
+  madvise(this->Memory + firstPageOffset, endPageOffset - firstPageOffset, MADV_DONTNEED);
+#endif
+}
@@ -0,0 +1,123 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+#ifndef __PlusBufferSpillFile_h
+#define __PlusBufferSpillFile_h
+
+#include "vtkPlusDataCollectionExport.h"
+#include "PlusStreamBufferItem.h"
+#include "vtkPlusTimestampedCircularBuffer.h"
+
+#include <cstddef>
+#include <deque>
+#include <string>
+
+/*!
+  \class PlusBufferSpillFile
+  \brief Memory-mapped file that keeps the items that have been evicted from the memory of a buffer.
+
+  Items are appended to a file of fixed size as records (item properties, pixel data, and frame fields).
+  When the file is full, writing continues at the beginning of the file and the oldest records are discarded,
+  so the file holds the most recent history that fits in it. Records are found by UID or by timestamp
+  using an in-memory index, which only contains a few numbers for each record.
+
+  The file is deleted when it is closed (on POSIX systems it is unlinked right after it is created),
+  so no file is left behind even if the process terminates unexpectedly. Pages of written records
+  are released from the address space of the process, so the file does not increase the resident memory size.
+
+  Encoded (compressed) frames are stored without their pixel data.
+  The class is not thread-safe, the owner buffer serializes the access by its spill file mutex.
+
+  \ingroup PlusLibDataCollection
+*/
+class vtkPlusDataCollectionExport PlusBufferSpillFile
+{
+public:
+  /*! Alignment of the first byte of each record */
+  static const size_t RECORD_ALIGNMENT_BYTES = 64;
+
+  PlusBufferSpillFile();
+  virtual ~PlusBufferSpillFile();
+
+  /*!
+    Create and map a file of capacityBytes size. A previously opened file is closed.
+    \param filePath Path of the file. The file is overwritten if it exists.
+  */
+  PlusStatus Open(const std::string& filePath, size_t capacityBytes);
+  /*! Unmap and delete the file */
+  void Close();
+  bool IsOpen() const { return this->Memory != NULL; }
+
+  /*! Get the size of the file in bytes */
+  size_t GetCapacityBytes() const { return this->CapacityBytes; }
+
+  /*! Discard all records */
+  void Clear();
+
+  /*!
+    Append an item to the file. The UID of the item must be larger than the UID of all the items in the file.
+    The oldest records are discarded if there is not enough space for the item.
+  */
+  PlusStatus AppendItem(const StreamBufferItem* item);
+
+  bool IsEmpty() const { return this->Records.empty(); }
+  int GetNumberOfItems() const { return static_cast<int>(this->Records.size()); }
+  /*! Get the UID of the oldest item in the file. The file must not be empty. */
+  BufferItemUidType GetOldestItemUid() const { return this->Records.front().Uid; }
+  /*! Get the UID of the latest item in the file. The file must not be empty. */
+  BufferItemUidType GetLatestItemUid() const { return this->Records.back().Uid; }
+  /*! Get the filtered timestamp (in local time) of the oldest item in the file. The file must not be empty. */
+  double GetOldestTimeStamp() const { return this->Records.front().FilteredTimestamp; }
+
+  /*! Get the filtered timestamp (in local time) of an item */
+  ItemStatus GetTimeStamp(BufferItemUidType uid, double& filteredTimestamp) const;
+  /*! Get the index assigned by the data acquisition system of an item */
+  ItemStatus GetIndex(BufferItemUidType uid, unsigned long& index) const;
+  /*! Get the UID of the item that is the closest to the specified time (in local time) */
+  ItemStatus GetItemUidFromTime(double time, BufferItemUidType& uid) const;
+
+  /*! Read an item from the file */
+  ItemStatus GetItem(BufferItemUidType uid, StreamBufferItem* item);
+
+protected:
+  /*! Location of a record in the file */
+  struct RecordLocation
+  {
+    BufferItemUidType Uid;
+    double FilteredTimestamp;
+    size_t Offset;
+    size_t SizeBytes;
+  };
+
+  /*! Find the record of an item. Returns NULL if the item is not in the file. */
+  const RecordLocation* FindRecord(BufferItemUidType uid, ItemStatus& status) const;
+
+  /*! Release the pages that are completely within the specified range from the address space of the process */
+  void ReleasePages(size_t beginOffset, size_t endOffset);
+
+  /*! Records in the file, ordered by UID (and timestamp) */
+  std::deque<RecordLocation> Records;
+
+  std::string FilePath;
+  unsigned char* Memory;
+  size_t CapacityBytes;
+  /*! Offset where the next record is written */
+  size_t WriteOffset;
+  /*! Pages before this offset have been released since writing started at the beginning of the file */
+  size_t ReleasedOffset;
+  size_t PageSizeBytes;
+
+#if defined(_WIN32)
+  void* FileHandle;
+  void* FileMappingHandle;
+#endif
+
+private:
+  PlusBufferSpillFile(const PlusBufferSpillFile&);
+  PlusBufferSpillFile& operator=(const PlusBufferSpillFile&);
+};
+
+#endif
@@ -0,0 +1,184 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+#include "PlusConfigure.h"
+#include "PlusFrameArena.h"
+
+#if defined(_WIN32)
+  #include <malloc.h>
+#elif defined(__linux__)
+  #include <sys/mman.h>
+#else
+  #include <stdlib.h>
+  #include <sys/mman.h>
+#endif
+
+#include <cstring>
+#if !defined(_WIN32)
+  #include <errno.h>
+#endif
+
+namespace
+{
+  // Size of transparent huge pages on Linux
+  const size_t HUGE_PAGE_SIZE_BYTES = 2 * 1024 * 1024;
+
+  //----------------------------------------------------------------------------
+  size_t RoundUp(size_t value, size_t alignment)
+  {
+    return ((value + alignment - 1) / alignment) * alignment;
+  }
+}
+
+//----------------------------------------------------------------------------
+PlusFrameArena::PlusFrameArena()
+  : Memory(NULL)
+  , SizeBytes(0)
+  , SlotSizeBytes(0)
+  , SlotStrideBytes(0)
+  , NumberOfSlots(0)
+  , UseHugePages(false)
+  , PagesLocked(false)
+{
+}
+
+//----------------------------------------------------------------------------
+PlusFrameArena::~PlusFrameArena()
+{
+  this->Free();
+}
+
+//----------------------------------------------------------------------------
+PlusStatus PlusFrameArena::Allocate(size_t slotSizeBytes, int numberOfSlots, bool useHugePages)
+{
+  this->Free();
+
+  if (slotSizeBytes == 0 || numberOfSlots <= 0)
+  {
+    LOG_ERROR("Invalid frame arena size requested: " << numberOfSlots << " slots of " << slotSizeBytes << " bytes");
+    return PLUS_FAIL;
+  }
+
+  size_t slotStrideBytes = RoundUp(slotSizeBytes, SLOT_ALIGNMENT_BYTES);
+  size_t sizeBytes = slotStrideBytes * numberOfSlots;
+
+#if defined(__linux__)
+  // Map the memory directly, so that it is page aligned and it can be backed by huge pages.
+  // Without huge pages MAP_POPULATE pre-faults all the pages in the kernel.
+  // With huge pages the pages are faulted in after madvise, otherwise they would be populated with normal pages.
+  if (useHugePages)
+  {
+    sizeBytes = RoundUp(sizeBytes, HUGE_PAGE_SIZE_BYTES);
+  }
+  int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+  if (!useHugePages)
+  {
+    flags |= MAP_POPULATE;
+  }
+  void* memory = mmap(NULL, sizeBytes, PROT_READ | PROT_WRITE, flags, -1, 0);
+  if (memory == MAP_FAILED)
+  {
+    LOG_ERROR("Failed to map " << sizeBytes << " bytes of memory for the frame arena");
+    return PLUS_FAIL;
+  }
+  if (useHugePages)
+  {
+    if (madvise(memory, sizeBytes, MADV_HUGEPAGE) != 0)
+    {
+      LOG_WARNING("Transparent huge pages are not available for the frame arena, normal pages are used instead");
+    }
+    std::memset(memory, 0, sizeBytes);
+  }
+#elif defined(_WIN32)
+  void* memory = _aligned_malloc(sizeBytes, SLOT_ALIGNMENT_BYTES);
+  if (memory == NULL)
+  {
+    LOG_ERROR("Failed to allocate " << sizeBytes << " bytes of memory for the frame arena");
+    return PLUS_FAIL;
+  }
+  // Touch all the pages now, so that they are not faulted in on the acquisition thread
+  std::memset(memory, 0, sizeBytes);
+#else
+  void* memory = NULL;
+  if (posix_memalign(&memory, SLOT_ALIGNMENT_BYTES, sizeBytes) != 0)
+  {
+    LOG_ERROR("Failed to allocate " << sizeBytes << " bytes of memory for the frame arena");
+    return PLUS_FAIL;
+  }
+  // Touch all the pages now, so that they are not faulted in on the acquisition thread
+  std::memset(memory, 0, sizeBytes);
+#endif
+
+  this->Memory = static_cast<unsigned char*>(memory);
+  this->SizeBytes = sizeBytes;
+  this->SlotSizeBytes = slotSizeBytes;
+  this->SlotStrideBytes = slotStrideBytes;
+  this->NumberOfSlots = numberOfSlots;
+  this->UseHugePages = useHugePages;
+
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+void PlusFrameArena::Free()
+{
+  if (this->Memory == NULL)
+  {
+    return;
+  }
+
+  if (this->PagesLocked)
+  {
+    this->SetPagesLocked(false);
+  }
+
+#if defined(__linux__)
+  munmap(this->Memory, this->SizeBytes);
+#elif defined(_WIN32)
+  _aligned_free(this->Memory);
+#else
+  free(this->Memory);
+#endif
+
+  this->Memory = NULL;
+  this->SizeBytes = 0;
+  this->SlotSizeBytes = 0;
+  this->SlotStrideBytes = 0;
+  this->NumberOfSlots = 0;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus PlusFrameArena::SetPagesLocked(bool locked)
+{
+  if (this->Memory == NULL || this->PagesLocked == locked)
+  {
+    return PLUS_SUCCESS;
+  }
+
+#if defined(_WIN32)
+  LOG_WARNING("Locking the frame arena in memory is not supported on Windows");
+  return PLUS_FAIL;
+#else
+  int result = locked ? mlock(this->Memory, this->SizeBytes) : munlock(this->Memory, this->SizeBytes);
+  if (result != 0)
+  {
+    LOG_WARNING("Failed to " << (locked ? "lock" : "unlock") << " " << this->SizeBytes << " bytes of the frame arena in memory: " << strerror(errno));
+    return PLUS_FAIL;
+  }
+  this->PagesLocked = locked;
+  return PLUS_SUCCESS;
+#endif
+}
+
+//----------------------------------------------------------------------------
+unsigned char* PlusFrameArena::GetSlotPointer(int slotIndex) const
+{
+  if (this->Memory == NULL || slotIndex < 0 || slotIndex >= this->NumberOfSlots)
+  {
+    return NULL;
+  }
+  return this->Memory + slotIndex * this->SlotStrideBytes;
+}
@@ -0,0 +1,82 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+#ifndef __PlusFrameArena_h
+#define __PlusFrameArena_h
+
+#include "vtkPlusDataCollectionExport.h"
+
+#include <cstddef>
+
+/*!
+  \class PlusFrameArena
+  \brief Contiguous block of memory that holds the pixel data of all the frames of a buffer.
+
+  The memory is divided into equally sized slots, one for each item of the buffer. Each slot starts
+  at an address that is aligned to SLOT_ALIGNMENT_BYTES, so that SIMD instructions can be used for
+  processing the frames. All pages of the arena are touched when it is allocated, so that no page faults
+  occur on the acquisition thread when the buffer is filled for the first time.
+
+  On Linux the memory is mapped directly from the operating system and optionally backed by transparent huge pages.
+
+  \ingroup PlusLibDataCollection
+*/
+class vtkPlusDataCollectionExport PlusFrameArena
+{
+public:
+  /*! Alignment of the first byte of each slot */
+  static const size_t SLOT_ALIGNMENT_BYTES = 64;
+
+  PlusFrameArena();
+  virtual ~PlusFrameArena();
+
+  /*!
+    Allocate and pre-fault memory for numberOfSlots slots, each at least slotSizeBytes large.
+    Previously allocated memory is released.
+    \param useHugePages Request transparent huge pages for the arena (only has effect on Linux)
+  */
+  PlusStatus Allocate(size_t slotSizeBytes, int numberOfSlots, bool useHugePages);
+
+  /*! Get the first byte of a slot. Returns NULL if the slot index is out of range. */
+  unsigned char* GetSlotPointer(int slotIndex) const;
+
+  /*! Get the usable size of a slot in bytes */
+  size_t GetSlotSizeBytes() const { return this->SlotSizeBytes; }
+  /*! Get the distance between the first bytes of subsequent slots */
+  size_t GetSlotStrideBytes() const { return this->SlotStrideBytes; }
+  /*! Get the number of slots */
+  int GetNumberOfSlots() const { return this->NumberOfSlots; }
+  /*! Get the total size of the allocated memory in bytes */
+  size_t GetSizeBytes() const { return this->SizeBytes; }
+  /*! Returns true if huge pages were requested for the arena */
+  bool GetUseHugePages() const { return this->UseHugePages; }
+
+  /*!
+    Lock the pages of the arena in physical memory, so that they are never paged out (or unlock them).
+    Requires CAP_IPC_LOCK or a sufficient RLIMIT_MEMLOCK. Not supported on Windows.
+  */
+  PlusStatus SetPagesLocked(bool locked);
+  /*! Returns true if the pages of the arena are locked in physical memory */
+  bool GetPagesLocked() const { return this->PagesLocked; }
+
+protected:
+  /*! Release the memory of the arena */
+  void Free();
+
+  unsigned char* Memory;
+  size_t SizeBytes;
+  size_t SlotSizeBytes;
+  size_t SlotStrideBytes;
+  int NumberOfSlots;
+  bool UseHugePages;
+  bool PagesLocked;
+
+private:
+  PlusFrameArena(const PlusFrameArena&);
+  PlusFrameArena& operator=(const PlusFrameArena&);
+};
+
+#endif
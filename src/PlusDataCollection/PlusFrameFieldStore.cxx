@@ -0,0 +1,321 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+#include "PlusConfigure.h"
+#include "PlusFrameFieldStore.h"
+
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+namespace
+{
+  //----------------------------------------------------------------------------
+  // Process-wide table of interned field names
+  struct InternedFieldNames
+  {
+    std::mutex Mutex;
+    std::unordered_map<std::string, PlusFrameFieldStore::KeyIdType> KeyIds;
+    // Elements of a deque are not moved when new elements are added, so pointers to the names remain valid
+    std::deque<std::string> Names;
+  };
+
+  //----------------------------------------------------------------------------
+  InternedFieldNames& GetInternedFieldNames()
+  {
+    static InternedFieldNames internedFieldNames;
+    return internedFieldNames;
+  }
+
+  //----------------------------------------------------------------------------
+  const std::string* GetInternedName(PlusFrameFieldStore::KeyIdType keyId)
+  {
+    InternedFieldNames& interned = GetInternedFieldNames();
+    std::lock_guard<std::mutex> lock(interned.Mutex);
+    return &interned.Names[keyId];
+  }
+
+  //----------------------------------------------------------------------------
+  // Get the key ID and the interned name of a field name, adding it to the table if it is not interned yet
+  PlusFrameFieldStore::KeyIdType InternFieldName(const std::string& fieldName, const std::string*& internedName)
+  {
+    InternedFieldNames& interned = GetInternedFieldNames();
+    std::lock_guard<std::mutex> lock(interned.Mutex);
+    std::unordered_map<std::string, PlusFrameFieldStore::KeyIdType>::iterator keyIdIt = interned.KeyIds.find(fieldName);
+    if (keyIdIt != interned.KeyIds.end())
+    {
+      internedName = &interned.Names[keyIdIt->second];
+      return keyIdIt->second;
+    }
+    PlusFrameFieldStore::KeyIdType keyId = static_cast<PlusFrameFieldStore::KeyIdType>(interned.Names.size());
+    interned.Names.push_back(fieldName);
+    interned.KeyIds[fieldName] = keyId;
+    internedName = &interned.Names.back();
+    return keyId;
+  }
+
+  //----------------------------------------------------------------------------
+  bool KeyIdLess(const PlusFrameFieldStore::Field& field, PlusFrameFieldStore::KeyIdType keyId)
+  {
+    return field.KeyId < keyId;
+  }
+}
+
+//----------------------------------------------------------------------------
+PlusFrameFieldStore::PlusFrameFieldStore()
+{
+}
+
+//----------------------------------------------------------------------------
+PlusFrameFieldStore::~PlusFrameFieldStore()
+{
+}
+
+//----------------------------------------------------------------------------
+PlusFrameFieldStore::KeyIdType PlusFrameFieldStore::GetKeyId(const std::string& fieldName)
+{
+  const std::string* internedName(NULL);
+  return InternFieldName(fieldName, internedName);
+}
+
+//----------------------------------------------------------------------------
+bool PlusFrameFieldStore::FindKeyId(const std::string& fieldName, KeyIdType& keyId)
+{
+  InternedFieldNames& interned = GetInternedFieldNames();
+  std::lock_guard<std::mutex> lock(interned.Mutex);
+  std::unordered_map<std::string, KeyIdType>::iterator keyIdIt = interned.KeyIds.find(fieldName);
+  if (keyIdIt == interned.KeyIds.end())
+  {
+    return false;
+  }
+  keyId = keyIdIt->second;
+  return true;
+}
+
+//----------------------------------------------------------------------------
+std::vector<PlusFrameFieldStore::Field>::iterator PlusFrameFieldStore::FindFieldByName(const std::string& fieldName)
+{
+  // There are only a few fields in a frame, a linear search is faster than locking the table of interned names
+  for (std::vector<Field>::iterator fieldIt = this->Fields.begin(); fieldIt != this->Fields.end(); ++fieldIt)
+  {
+    if (*(fieldIt->Name) == fieldName)
+    {
+      return fieldIt;
+    }
+  }
+  return this->Fields.end();
+}
+
+//----------------------------------------------------------------------------
+std::vector<PlusFrameFieldStore::Field>::const_iterator PlusFrameFieldStore::FindFieldByName(const std::string& fieldName) const
+{
+  for (std::vector<Field>::const_iterator fieldIt = this->Fields.begin(); fieldIt != this->Fields.end(); ++fieldIt)
+  {
+    if (*(fieldIt->Name) == fieldName)
+    {
+      return fieldIt;
+    }
+  }
+  return this->Fields.end();
+}
+
+//----------------------------------------------------------------------------
+std::vector<PlusFrameFieldStore::Field>::iterator PlusFrameFieldStore::FindFieldPosition(KeyIdType keyId)
+{
+  return std::lower_bound(this->Fields.begin(), this->Fields.end(), keyId, KeyIdLess);
+}
+
+//----------------------------------------------------------------------------
+std::vector<PlusFrameFieldStore::Field>::const_iterator PlusFrameFieldStore::FindFieldPosition(KeyIdType keyId) const
+{
+  return std::lower_bound(this->Fields.begin(), this->Fields.end(), keyId, KeyIdLess);
+}
+
+//----------------------------------------------------------------------------
+const PlusFrameFieldStore::Field* PlusFrameFieldStore::GetField(KeyIdType keyId) const
+{
+  std::vector<Field>::const_iterator fieldIt = this->FindFieldPosition(keyId);
+  if (fieldIt == this->Fields.end() || fieldIt->KeyId != keyId)
+  {
+    return NULL;
+  }
+  return &(*fieldIt);
+}
+
+//----------------------------------------------------------------------------
+const PlusFrameFieldStore::Field* PlusFrameFieldStore::GetField(const std::string& fieldName) const
+{
+  std::vector<Field>::const_iterator fieldIt = this->FindFieldByName(fieldName);
+  if (fieldIt == this->Fields.end())
+  {
+    return NULL;
+  }
+  return &(*fieldIt);
+}
+
+//----------------------------------------------------------------------------
+void PlusFrameFieldStore::SetField(KeyIdType keyId, const std::string& value, igsioFrameFieldFlags flags, const PlusFrameFieldStore* previousFields /*= NULL*/)
+{
+  const std::string* internedName(NULL);
+  std::vector<Field>::const_iterator fieldIt = this->FindFieldPosition(keyId);
+  if (fieldIt == this->Fields.end() || fieldIt->KeyId != keyId)
+  {
+    internedName = GetInternedName(keyId);
+  }
+  else
+  {
+    internedName = fieldIt->Name;
+  }
+  this->SetField(keyId, internedName, value, flags, previousFields);
+}
+
+//----------------------------------------------------------------------------
+void PlusFrameFieldStore::SetField(KeyIdType keyId, const std::string* internedName, const std::string& value, igsioFrameFieldFlags flags, const PlusFrameFieldStore* previousFields)
+{
+  std::vector<Field>::iterator fieldIt = this->FindFieldPosition(keyId);
+  if (fieldIt == this->Fields.end() || fieldIt->KeyId != keyId)
+  {
+    Field newField;
+    newField.KeyId = keyId;
+    newField.Name = internedName;
+    fieldIt = this->Fields.insert(fieldIt, newField);
+  }
+  fieldIt->Flags = flags;
+
+  if (fieldIt->Value && *(fieldIt->Value) == value)
+  {
+    // unchanged
+    return;
+  }
+  if (previousFields != NULL && previousFields != this)
+  {
+    const Field* previousField = previousFields->GetField(keyId);
+    if (previousField != NULL && previousField->Value && *(previousField->Value) == value)
+    {
+      // same as in the previous frame, share the value
+      fieldIt->Value = previousField->Value;
+      return;
+    }
+  }
+  // The caller holds the lock of the frame that owns this store, so no other store can start referring to the value
+  // while it is modified. Other stores may only release their references meanwhile, which at worst causes an unnecessary copy.
+  if (fieldIt->Value && fieldIt->Value.use_count() == 1)
+  {
+    // not referenced by any other store, the string can be reused
+    fieldIt->Value->assign(value);
+    return;
+  }
+  fieldIt->Value = std::make_shared<std::string>(value);
+}
+
+//----------------------------------------------------------------------------
+void PlusFrameFieldStore::SetField(const std::string& fieldName, const std::string& value, igsioFrameFieldFlags flags, const PlusFrameFieldStore* previousFields /*= NULL*/)
+{
+  // Usually the field is already in this store or in the previous frame, then the key ID is known without locking the table of interned names
+  std::vector<Field>::const_iterator fieldIt = this->FindFieldByName(fieldName);
+  if (fieldIt != this->Fields.end())
+  {
+    this->SetField(fieldIt->KeyId, fieldIt->Name, value, flags, previousFields);
+    return;
+  }
+  if (previousFields != NULL && previousFields != this)
+  {
+    std::vector<Field>::const_iterator previousFieldIt = previousFields->FindFieldByName(fieldName);
+    if (previousFieldIt != previousFields->Fields.end())
+    {
+      this->SetField(previousFieldIt->KeyId, previousFieldIt->Name, value, flags, previousFields);
+      return;
+    }
+  }
+  const std::string* internedName(NULL);
+  KeyIdType keyId = InternFieldName(fieldName, internedName);
+  this->SetField(keyId, internedName, value, flags, previousFields);
+}
+
+//----------------------------------------------------------------------------
+void PlusFrameFieldStore::SetFields(const PlusFrameFieldStore& fields)
+{
+  if (&fields == this)
+  {
+    return;
+  }
+  if (this->Fields.empty())
+  {
+    this->Fields = fields.Fields;
+    return;
+  }
+  for (std::vector<Field>::const_iterator otherFieldIt = fields.Fields.begin(); otherFieldIt != fields.Fields.end(); ++otherFieldIt)
+  {
+    std::vector<Field>::iterator fieldIt = this->FindFieldPosition(otherFieldIt->KeyId);
+    if (fieldIt == this->Fields.end() || fieldIt->KeyId != otherFieldIt->KeyId)
+    {
+      this->Fields.insert(fieldIt, *otherFieldIt);
+    }
+    else
+    {
+      *fieldIt = *otherFieldIt;
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+void PlusFrameFieldStore::SetFields(const igsioFieldMapType& fields, const PlusFrameFieldStore* previousFields /*= NULL*/)
+{
+  for (igsioFieldMapType::const_iterator fieldIt = fields.begin(); fieldIt != fields.end(); ++fieldIt)
+  {
+    this->SetField(fieldIt->first, fieldIt->second.second, fieldIt->second.first, previousFields);
+  }
+}
+
+//----------------------------------------------------------------------------
+void PlusFrameFieldStore::ReplaceFields(const igsioFieldMapType& fields, const PlusFrameFieldStore* previousFields /*= NULL*/)
+{
+  // Remove the fields that are not in the map, all other fields are overwritten
+  std::vector<Field>::iterator keptFieldEnd = this->Fields.begin();
+  for (std::vector<Field>::iterator fieldIt = this->Fields.begin(); fieldIt != this->Fields.end(); ++fieldIt)
+  {
+    if (fields.find(*(fieldIt->Name)) != fields.end())
+    {
+      if (keptFieldEnd != fieldIt)
+      {
+        *keptFieldEnd = *fieldIt;
+      }
+      ++keptFieldEnd;
+    }
+  }
+  this->Fields.erase(keptFieldEnd, this->Fields.end());
+  this->SetFields(fields, previousFields);
+}
+
+//----------------------------------------------------------------------------
+bool PlusFrameFieldStore::DeleteField(const std::string& fieldName)
+{
+  std::vector<Field>::iterator fieldIt = this->FindFieldByName(fieldName);
+  if (fieldIt == this->Fields.end())
+  {
+    return false;
+  }
+  this->Fields.erase(fieldIt);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void PlusFrameFieldStore::Clear()
+{
+  this->Fields.clear();
+}
+
+//----------------------------------------------------------------------------
+void PlusFrameFieldStore::AddToFieldMap(igsioFieldMapType& fieldMap) const
+{
+  for (std::vector<Field>::const_iterator fieldIt = this->Fields.begin(); fieldIt != this->Fields.end(); ++fieldIt)
+  {
+    std::pair<igsioFrameFieldFlags, std::string>& mapValue = fieldMap[*(fieldIt->Name)];
+    mapValue.first = fieldIt->Flags;
+    mapValue.second = *(fieldIt->Value);
+  }
+}
@@ -0,0 +1,110 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+#ifndef __PlusFrameFieldStore_h
+#define __PlusFrameFieldStore_h
+
+#include "vtkPlusDataCollectionExport.h"
+
+// IGSIO includes
+#include <igsioCommon.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+/*!
+  \class PlusFrameFieldStore
+  \brief Custom frame fields of a buffer item, stored without allocating memory for each frame.
+
+  Field names are interned: each distinct name is stored only once in a process-wide table and the fields
+  refer to it by an integer key ID. The fields are kept in a vector that is sorted by key ID, so the memory
+  of the vector is reused when a buffer item is overwritten. Values are shared between stores (copy-on-write),
+  so copying a store does not copy any strings, and a value that is the same as in the previous frame
+  can be shared with the previous frame instead of being allocated again.
+
+  Fields are looked up by name in the store itself (and in the fields of the previous frame when setting a field),
+  so the process-wide table is only locked when a field name is used for the first time.
+
+  A store is not thread-safe. Modifying a store requires the lock of the object that owns it (e.g., the buffer
+  that contains the frame), because a value is only reused in place if no other store refers to it, and other
+  stores can only start referring to it by copying from the owning frame under the same lock.
+
+  \ingroup PlusLibDataCollection
+*/
+class vtkPlusDataCollectionExport PlusFrameFieldStore
+{
+public:
+  typedef int KeyIdType;
+  typedef std::shared_ptr<std::string> ValuePointerType;
+
+  struct Field
+  {
+    KeyIdType KeyId;
+    /*! Interned field name, valid until the end of the process */
+    const std::string* Name;
+    igsioFrameFieldFlags Flags;
+    /*! Field value. Shared with other stores, must not be modified if it is referenced by other stores. */
+    ValuePointerType Value;
+  };
+
+  PlusFrameFieldStore();
+  virtual ~PlusFrameFieldStore();
+
+  /*! Get the key ID of a field name. The name is added to the interned names if it is not interned yet. */
+  static KeyIdType GetKeyId(const std::string& fieldName);
+  /*! Get the key ID of a field name. Returns false if no field has been stored with this name yet. */
+  static bool FindKeyId(const std::string& fieldName, KeyIdType& keyId);
+
+  bool IsEmpty() const { return this->Fields.empty(); }
+  int GetNumberOfFields() const { return static_cast<int>(this->Fields.size()); }
+  /*! Get all the fields, sorted by key ID */
+  const std::vector<Field>& GetFields() const { return this->Fields; }
+
+  /*! Get a field. Returns NULL if the field is not found. Does not lock the table of interned names. */
+  const Field* GetField(KeyIdType keyId) const;
+  const Field* GetField(const std::string& fieldName) const;
+
+  /*!
+    Set a field value. No memory is allocated if the value is unchanged, or if previousFields (typically the fields of the
+    previous frame) contains the same value for this field, because then the value is shared with previousFields.
+    The caller must hold the lock of the frame that owns this store (see class description).
+  */
+  void SetField(KeyIdType keyId, const std::string& value, igsioFrameFieldFlags flags, const PlusFrameFieldStore* previousFields = NULL);
+  void SetField(const std::string& fieldName, const std::string& value, igsioFrameFieldFlags flags, const PlusFrameFieldStore* previousFields = NULL);
+
+  /*! Set all the fields that are in the other store (other fields are not changed). Values are shared with the other store. */
+  void SetFields(const PlusFrameFieldStore& fields);
+  /*! Set all the fields that are in the field map (other fields are not changed) */
+  void SetFields(const igsioFieldMapType& fields, const PlusFrameFieldStore* previousFields = NULL);
+  /*! Replace all fields by the fields of the field map. Memory of unchanged values is kept. */
+  void ReplaceFields(const igsioFieldMapType& fields, const PlusFrameFieldStore* previousFields = NULL);
+
+  /*! Remove a field. Returns false if the field is not found. */
+  bool DeleteField(const std::string& fieldName);
+  /*! Remove all fields */
+  void Clear();
+
+  /*! Add all the fields to a field map (existing fields of the map with the same name are overwritten) */
+  void AddToFieldMap(igsioFieldMapType& fieldMap) const;
+
+protected:
+  /*! Set a field value, the interned name of the key is already known */
+  void SetField(KeyIdType keyId, const std::string* internedName, const std::string& value, igsioFrameFieldFlags flags, const PlusFrameFieldStore* previousFields);
+
+  /*! Find a field by comparing the field names, without looking up the key ID */
+  std::vector<Field>::iterator FindFieldByName(const std::string& fieldName);
+  std::vector<Field>::const_iterator FindFieldByName(const std::string& fieldName) const;
+
+  /*! Get the position of the field with the key ID, or the position where it should be inserted */
+  std::vector<Field>::iterator FindFieldPosition(KeyIdType keyId);
+  std::vector<Field>::const_iterator FindFieldPosition(KeyIdType keyId) const;
+
+  /*! Fields sorted by key ID */
+  std::vector<Field> Fields;
+};
+
+#endif
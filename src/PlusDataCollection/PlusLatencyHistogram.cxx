@@ -0,0 +1,180 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+#include "PlusConfigure.h"
+#include "PlusLatencyHistogram.h"
+
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+namespace
+{
+  const uint64_t MAX_LATENCY_MICROSECONDS = (uint64_t(1) << (PlusLatencyHistogram::MAX_EXPONENT + 1)) - 1;
+  const int SUB_BUCKET_COUNT = 1 << PlusLatencyHistogram::SUB_BUCKET_BITS;
+}
+
+//----------------------------------------------------------------------------
+PlusLatencyHistogram::Snapshot::Snapshot()
+  : Counts(NUMBER_OF_BUCKETS, 0)
+  , TotalCount(0)
+  , SumMicroseconds(0)
+{
+}
+
+//----------------------------------------------------------------------------
+double PlusLatencyHistogram::Snapshot::GetMeanSec() const
+{
+  if (this->TotalCount == 0)
+  {
+    return 0.0;
+  }
+  return static_cast<double>(this->SumMicroseconds) / this->TotalCount * 1e-6;
+}
+
+//----------------------------------------------------------------------------
+double PlusLatencyHistogram::Snapshot::GetPercentileSec(double percentile) const
+{
+  if (this->TotalCount == 0)
+  {
+    return 0.0;
+  }
+  uint64_t rank = static_cast<uint64_t>(std::ceil(percentile / 100.0 * this->TotalCount));
+  if (rank < 1)
+  {
+    rank = 1;
+  }
+  uint64_t cumulativeCount(0);
+  for (int bucketIndex = 0; bucketIndex < NUMBER_OF_BUCKETS; ++bucketIndex)
+  {
+    cumulativeCount += this->Counts[bucketIndex];
+    if (cumulativeCount >= rank)
+    {
+      return GetBucketUpperBound(bucketIndex) * 1e-6;
+    }
+  }
+  return this->GetMaxSec();
+}
+
+//----------------------------------------------------------------------------
+double PlusLatencyHistogram::Snapshot::GetMaxSec() const
+{
+  for (int bucketIndex = NUMBER_OF_BUCKETS - 1; bucketIndex >= 0; --bucketIndex)
+  {
+    if (this->Counts[bucketIndex] > 0)
+    {
+      return GetBucketUpperBound(bucketIndex) * 1e-6;
+    }
+  }
+  return 0.0;
+}
+
+//----------------------------------------------------------------------------
+void PlusLatencyHistogram::Snapshot::Subtract(const Snapshot& earlierSnapshot)
+{
+  this->TotalCount = 0;
+  for (int bucketIndex = 0; bucketIndex < NUMBER_OF_BUCKETS; ++bucketIndex)
+  {
+    // a snapshot may miss latencies that were being recorded, so the earlier counts may be slightly larger
+    uint64_t earlierCount = earlierSnapshot.Counts[bucketIndex];
+    this->Counts[bucketIndex] = (this->Counts[bucketIndex] > earlierCount) ? this->Counts[bucketIndex] - earlierCount : 0;
+    this->TotalCount += this->Counts[bucketIndex];
+  }
+  this->SumMicroseconds = (this->SumMicroseconds > earlierSnapshot.SumMicroseconds) ? this->SumMicroseconds - earlierSnapshot.SumMicroseconds : 0;
+}
+
+//----------------------------------------------------------------------------
+std::string PlusLatencyHistogram::Snapshot::GetSummary() const
+{
+  std::ostringstream summary;
+  summary << "Count=" << this->TotalCount
+          << std::fixed << std::setprecision(3)
+          << ";MeanMs=" << this->GetMeanSec() * 1000.0
+          << ";P50Ms=" << this->GetPercentileSec(50) * 1000.0
+          << ";P90Ms=" << this->GetPercentileSec(90) * 1000.0
+          << ";P99Ms=" << this->GetPercentileSec(99) * 1000.0
+          << ";MaxMs=" << this->GetMaxSec() * 1000.0;
+  return summary.str();
+}
+
+//----------------------------------------------------------------------------
+PlusLatencyHistogram::PlusLatencyHistogram()
+  : SumMicroseconds(0)
+{
+  for (int bucketIndex = 0; bucketIndex < NUMBER_OF_BUCKETS; ++bucketIndex)
+  {
+    this->Counts[bucketIndex].store(0, std::memory_order_relaxed);
+  }
+}
+
+//----------------------------------------------------------------------------
+void PlusLatencyHistogram::RecordLatency(double latencySec)
+{
+  uint64_t latencyMicroseconds(0);
+  if (latencySec > 0)
+  {
+    double microseconds = latencySec * 1e6 + 0.5;
+    latencyMicroseconds = (microseconds < MAX_LATENCY_MICROSECONDS) ? static_cast<uint64_t>(microseconds) : MAX_LATENCY_MICROSECONDS;
+  }
+  this->Counts[GetBucketIndex(latencyMicroseconds)].fetch_add(1, std::memory_order_relaxed);
+  this->SumMicroseconds.fetch_add(latencyMicroseconds, std::memory_order_relaxed);
+}
+
+//----------------------------------------------------------------------------
+void PlusLatencyHistogram::GetSnapshot(Snapshot& snapshot) const
+{
+  snapshot.Counts.resize(NUMBER_OF_BUCKETS);
+  snapshot.TotalCount = 0;
+  for (int bucketIndex = 0; bucketIndex < NUMBER_OF_BUCKETS; ++bucketIndex)
+  {
+    snapshot.Counts[bucketIndex] = this->Counts[bucketIndex].load(std::memory_order_relaxed);
+    snapshot.TotalCount += snapshot.Counts[bucketIndex];
+  }
+  snapshot.SumMicroseconds = this->SumMicroseconds.load(std::memory_order_relaxed);
+}
+
+//----------------------------------------------------------------------------
+int PlusLatencyHistogram::GetBucketIndex(uint64_t latencyMicroseconds)
+{
+  if (latencyMicroseconds > MAX_LATENCY_MICROSECONDS)
+  {
+    latencyMicroseconds = MAX_LATENCY_MICROSECONDS;
+  }
+  if (latencyMicroseconds < static_cast<uint64_t>(SUB_BUCKET_COUNT))
+  {
+    return static_cast<int>(latencyMicroseconds);
+  }
+  int exponent = SUB_BUCKET_BITS;
+  while ((latencyMicroseconds >> (exponent + 1)) != 0)
+  {
+    ++exponent;
+  }
+  int subBucketIndex = static_cast<int>((latencyMicroseconds >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKET_COUNT - 1));
+  return ((exponent - SUB_BUCKET_BITS + 1) << SUB_BUCKET_BITS) + subBucketIndex;
+}
+
+//----------------------------------------------------------------------------
+uint64_t PlusLatencyHistogram::GetBucketLowerBound(int bucketIndex)
+{
+  if (bucketIndex < SUB_BUCKET_COUNT)
+  {
+    return static_cast<uint64_t>(bucketIndex);
+  }
+  int exponent = (bucketIndex >> SUB_BUCKET_BITS) + SUB_BUCKET_BITS - 1;
+  uint64_t subBucketIndex = static_cast<uint64_t>(bucketIndex & (SUB_BUCKET_COUNT - 1));
+  return (SUB_BUCKET_COUNT + subBucketIndex) << (exponent - SUB_BUCKET_BITS);
+}
+
+//----------------------------------------------------------------------------
+uint64_t PlusLatencyHistogram::GetBucketUpperBound(int bucketIndex)
+{
+  if (bucketIndex < SUB_BUCKET_COUNT)
+  {
+    return static_cast<uint64_t>(bucketIndex);
+  }
+  int exponent = (bucketIndex >> SUB_BUCKET_BITS) + SUB_BUCKET_BITS - 1;
+  return GetBucketLowerBound(bucketIndex) + (uint64_t(1) << (exponent - SUB_BUCKET_BITS)) - 1;
+}
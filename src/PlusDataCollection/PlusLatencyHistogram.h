@@ -0,0 +1,91 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+#ifndef __PlusLatencyHistogram_h
+#define __PlusLatencyHistogram_h
+
+#include "vtkPlusDataCollectionExport.h"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*!
+  \class PlusLatencyHistogram
+  \brief Histogram of latencies that can be recorded from any thread without locking.
+
+  Latencies are counted in microsecond buckets with logarithmic-linear spacing (as in HDR histograms):
+  latencies below 32us have their own bucket, longer latencies are counted in 32 buckets per power of two,
+  so percentiles are accurate within about 3% from microseconds up to hours, using a fixed amount of memory.
+
+  Recording is a single atomic increment. Snapshots may miss the latencies that are recorded while
+  the snapshot is taken, but the counts are never corrupted.
+
+  \ingroup PlusLibDataCollection
+*/
+class vtkPlusDataCollectionExport PlusLatencyHistogram
+{
+public:
+  /*! Number of buckets for each power of two is 2^SUB_BUCKET_BITS */
+  static const int SUB_BUCKET_BITS = 5;
+  /*! Latencies above 2^(MAX_EXPONENT+1) microseconds (about 19 hours) are counted in the last bucket */
+  static const int MAX_EXPONENT = 35;
+  static const int NUMBER_OF_BUCKETS = (MAX_EXPONENT - SUB_BUCKET_BITS + 2) << SUB_BUCKET_BITS;
+
+  /*! Counts of a histogram at a point in time */
+  class vtkPlusDataCollectionExport Snapshot
+  {
+  public:
+    Snapshot();
+
+    /*! Get the number of recorded latencies */
+    uint64_t GetCount() const { return this->TotalCount; }
+    /*! Get the mean latency in seconds, 0 if there are no recorded latencies */
+    double GetMeanSec() const;
+    /*! Get the latency in seconds that the specified percentage (0-100) of the latencies does not exceed */
+    double GetPercentileSec(double percentile) const;
+    /*! Get the largest recorded latency in seconds (the upper limit of its bucket) */
+    double GetMaxSec() const;
+
+    /*! Remove the latencies of an earlier snapshot of the same histogram, to get the latencies that were recorded since then */
+    void Subtract(const Snapshot& earlierSnapshot);
+
+    /*! Get the count, mean, median, 90th, 99th percentile and maximum as a list of key=value pairs separated by semicolons */
+    std::string GetSummary() const;
+
+  protected:
+    friend class PlusLatencyHistogram;
+    std::vector<uint64_t> Counts;
+    uint64_t TotalCount;
+    uint64_t SumMicroseconds;
+  };
+
+  PlusLatencyHistogram();
+
+  /*! Count a latency. Negative latencies (caused by clock adjustments) are counted as 0. */
+  void RecordLatency(double latencySec);
+
+  /*! Get the current counts */
+  void GetSnapshot(Snapshot& snapshot) const;
+
+  /*! Get the index of the bucket that counts the latency */
+  static int GetBucketIndex(uint64_t latencyMicroseconds);
+  /*! Get the smallest latency (in microseconds) that is counted in the bucket */
+  static uint64_t GetBucketLowerBound(int bucketIndex);
+  /*! Get the largest latency (in microseconds) that is counted in the bucket */
+  static uint64_t GetBucketUpperBound(int bucketIndex);
+
+protected:
+  std::atomic<uint64_t> Counts[NUMBER_OF_BUCKETS];
+  std::atomic<uint64_t> SumMicroseconds;
+
+private:
+  PlusLatencyHistogram(const PlusLatencyHistogram&);
+  PlusLatencyHistogram& operator=(const PlusLatencyHistogram&);
+};
+
+#endif
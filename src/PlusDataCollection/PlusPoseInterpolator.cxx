@@ -0,0 +1,154 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+#include "PlusConfigure.h"
+#include "PlusPoseInterpolator.h"
+
+#include <vtkMath.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+  // If the orientations are closer than this then linear interpolation is used instead of SLERP (same as in igsioMath::Slerp)
+  const double SLERP_LINEAR_INTERPOLATION_THRESHOLD = 1e-6;
+
+  //----------------------------------------------------------------------------
+  // Compute the unit quaternion (w, x, y, z) of the rotation part of a rigid 4x4 matrix (row-major order)
+  void MatrixToQuaternion(const double* m, double& w, double& x, double& y, double& z)
+  {
+    const double trace = m[0] + m[5] + m[10];
+    if (trace > 0)
+    {
+      const double s = 0.5 / sqrt(trace + 1.0);
+      w = 0.25 / s;
+      x = (m[9] - m[6]) * s;
+      y = (m[2] - m[8]) * s;
+      z = (m[4] - m[1]) * s;
+    }
+    else if (m[0] > m[5] && m[0] > m[10])
+    {
+      const double s = 2.0 * sqrt(1.0 + m[0] - m[5] - m[10]);
+      w = (m[9] - m[6]) / s;
+      x = 0.25 * s;
+      y = (m[1] + m[4]) / s;
+      z = (m[2] + m[8]) / s;
+    }
+    else if (m[5] > m[10])
+    {
+      const double s = 2.0 * sqrt(1.0 + m[5] - m[0] - m[10]);
+      w = (m[2] - m[8]) / s;
+      x = (m[1] + m[4]) / s;
+      y = 0.25 * s;
+      z = (m[6] + m[9]) / s;
+    }
+    else
+    {
+      const double s = 2.0 * sqrt(1.0 + m[10] - m[0] - m[5]);
+      w = (m[4] - m[1]) / s;
+      x = (m[2] + m[8]) / s;
+      y = (m[6] + m[9]) / s;
+      z = 0.25 * s;
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+void PlusPoseInterpolator::InterpolatePoses(int numberOfPoses, const double* matricesA, const double* matricesB, const double* weightsB,
+    double* interpolatedMatrices, double* angleDifferencesDeg /*= NULL*/)
+{
+  double quatAw[BLOCK_SIZE], quatAx[BLOCK_SIZE], quatAy[BLOCK_SIZE], quatAz[BLOCK_SIZE];
+  double quatBw[BLOCK_SIZE], quatBx[BLOCK_SIZE], quatBy[BLOCK_SIZE], quatBz[BLOCK_SIZE];
+  double quatW[BLOCK_SIZE], quatX[BLOCK_SIZE], quatY[BLOCK_SIZE], quatZ[BLOCK_SIZE];
+  double halfAngles[BLOCK_SIZE];
+
+  for (int blockStart = 0; blockStart < numberOfPoses; blockStart += BLOCK_SIZE)
+  {
+    const int blockSize = std::min(BLOCK_SIZE, numberOfPoses - blockStart);
+    const double* blockMatricesA = matricesA + blockStart * 16;
+    const double* blockMatricesB = matricesB + blockStart * 16;
+    const double* blockWeightsB = weightsB + blockStart;
+    double* blockInterpolatedMatrices = interpolatedMatrices + blockStart * 16;
+
+    //============== Convert rotations to quaternions ==================
+
+    for (int i = 0; i < blockSize; ++i)
+    {
+      MatrixToQuaternion(blockMatricesA + i * 16, quatAw[i], quatAx[i], quatAy[i], quatAz[i]);
+      MatrixToQuaternion(blockMatricesB + i * 16, quatBw[i], quatBx[i], quatBy[i], quatBz[i]);
+    }
+
+    //============== Interpolate rotation ==================
+
+    // SLERP, interpolating along the shorter arc
+    for (int i = 0; i < blockSize; ++i)
+    {
+      const double t = blockWeightsB[i];
+      const double dot = quatAw[i] * quatBw[i] + quatAx[i] * quatBx[i] + quatAy[i] * quatBy[i] + quatAz[i] * quatBz[i];
+      const double sign = (dot < 0.0) ? -1.0 : 1.0;
+      const double cosOmega = std::min(dot * sign, 1.0);
+      const double omega = acos(cosOmega);
+      const bool linear = (1.0 - cosOmega) <= SLERP_LINEAR_INTERPOLATION_THRESHOLD;
+      const double invSinOmega = linear ? 0.0 : 1.0 / sin(omega);
+      const double scaleA = linear ? 1.0 - t : sin((1.0 - t) * omega) * invSinOmega;
+      const double scaleB = (linear ? t : sin(t * omega) * invSinOmega) * sign;
+      quatW[i] = scaleA * quatAw[i] + scaleB * quatBw[i];
+      quatX[i] = scaleA * quatAx[i] + scaleB * quatBx[i];
+      quatY[i] = scaleA * quatAy[i] + scaleB * quatBy[i];
+      quatZ[i] = scaleA * quatAz[i] + scaleB * quatBz[i];
+      halfAngles[i] = omega;
+    }
+
+    //============== Compose interpolated matrices ==================
+
+    for (int i = 0; i < blockSize; ++i)
+    {
+      const double t = blockWeightsB[i];
+      const double* a = blockMatricesA + i * 16;
+      const double* b = blockMatricesB + i * 16;
+      double* m = blockInterpolatedMatrices + i * 16;
+
+      const double ww = quatW[i] * quatW[i];
+      const double wx = quatW[i] * quatX[i];
+      const double wy = quatW[i] * quatY[i];
+      const double wz = quatW[i] * quatZ[i];
+      const double xx = quatX[i] * quatX[i];
+      const double xy = quatX[i] * quatY[i];
+      const double xz = quatX[i] * quatZ[i];
+      const double yy = quatY[i] * quatY[i];
+      const double yz = quatY[i] * quatZ[i];
+      const double zz = quatZ[i] * quatZ[i];
+      // normalize the quaternion (same as vtkMath::QuaternionToMatrix3x3)
+      const double s = 1.0 / (ww + xx + yy + zz);
+
+      m[0] = (ww + xx - yy - zz) * s;
+      m[1] = 2.0 * (xy - wz) * s;
+      m[2] = 2.0 * (xz + wy) * s;
+      m[3] = a[3] * (1.0 - t) + b[3] * t;
+      m[4] = 2.0 * (xy + wz) * s;
+      m[5] = (ww - xx + yy - zz) * s;
+      m[6] = 2.0 * (yz - wx) * s;
+      m[7] = a[7] * (1.0 - t) + b[7] * t;
+      m[8] = 2.0 * (xz - wy) * s;
+      m[9] = 2.0 * (yz + wx) * s;
+      m[10] = (ww - xx - yy + zz) * s;
+      m[11] = a[11] * (1.0 - t) + b[11] * t;
+      m[12] = 0.0;
+      m[13] = 0.0;
+      m[14] = 0.0;
+      m[15] = 1.0;
+    }
+
+    if (angleDifferencesDeg != NULL)
+    {
+      for (int i = 0; i < blockSize; ++i)
+      {
+        angleDifferencesDeg[blockStart + i] = vtkMath::DegreesFromRadians(2.0 * halfAngles[i]);
+      }
+    }
+  }
+}
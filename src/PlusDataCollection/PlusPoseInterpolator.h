@@ -0,0 +1,91 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+#ifndef __PlusPoseInterpolator_h
+#define __PlusPoseInterpolator_h
+
+#include "vtkPlusDataCollectionExport.h"
+#include "PlusStreamBufferItem.h"
+#include "vtkPlusTimestampedCircularBuffer.h"
+
+/*!
+  \struct PlusInterpolatedPose
+  \brief Pose of a tool at a requested time, as returned by the batch interpolation methods of vtkPlusBuffer.
+
+  Contains the same information as the transform part of the StreamBufferItem that
+  vtkPlusBuffer::GetStreamBufferItemFromTime returns with INTERPOLATED interpolation,
+  but without allocating memory, so that arrays of poses can be filled efficiently.
+
+  \ingroup PlusLibDataCollection
+*/
+struct PlusInterpolatedPose
+{
+  /*! Interpolated transform, 4x4 matrix elements in row-major order */
+  double Matrix[16];
+  /*! Status of the pose. TOOL_MISSING if there were no valid items around the requested time to interpolate between. */
+  ToolStatus Status;
+  /*! Filtered timestamp (in local time, same as in StreamBufferItem) */
+  double FilteredTimestamp;
+  /*! Unfiltered timestamp (in local time, same as in StreamBufferItem) */
+  double UnfilteredTimestamp;
+  /*! Index of the buffer item closest to the requested time */
+  unsigned long Index;
+  /*! UID of the buffer item closest to the requested time */
+  BufferItemUidType Uid;
+  /*! True if the buffer item closest to the requested time has custom frame fields (they can be retrieved using Uid) */
+  bool HasFrameFields;
+  /*! ITEM_OK if the pose could be determined. Other members are only valid if the result is ITEM_OK. */
+  ItemStatus Result;
+
+  PlusInterpolatedPose()
+    : Status(TOOL_INVALID)
+    , FilteredTimestamp(0)
+    , UnfilteredTimestamp(0)
+    , Index(0)
+    , Uid(0)
+    , HasFrameFields(false)
+    , Result(ITEM_UNKNOWN_ERROR)
+  {
+  }
+
+  /*! Get timestamp of the pose in global time (global = local + offset) */
+  double GetTimestamp(double localTimeOffsetSec) const { return this->FilteredTimestamp + localTimeOffsetSec; }
+};
+
+/*!
+  \class PlusPoseInterpolator
+  \brief Interpolates many poses at once.
+
+  The rotation is interpolated with SLERP interpolation, and the position is interpolated with linear interpolation.
+  Poses are processed in fixed-size blocks, the quaternions of a block are stored in separate arrays for each component.
+  No memory is allocated on the heap.
+
+  \ingroup PlusLibDataCollection
+*/
+class vtkPlusDataCollectionExport PlusPoseInterpolator
+{
+public:
+  /*! Number of poses that are interpolated together */
+  static const int BLOCK_SIZE = 32;
+
+  /*!
+    Interpolate between pairs of rigid transforms.
+    \param numberOfPoses Number of transform pairs
+    \param matricesA First transform of each pair, 16 elements (4x4 matrix, row-major order) for each pose
+    \param matricesB Second transform of each pair, 16 elements for each pose
+    \param weightsB Weight of the second transform for each pose (0: result is equal to A, 1: result is equal to B)
+    \param interpolatedMatrices Output transforms, 16 elements for each pose. Must not overlap with the inputs.
+    \param angleDifferencesDeg Optional output, angle between the orientations of A and B for each pose (in degrees)
+  */
+  static void InterpolatePoses(int numberOfPoses, const double* matricesA, const double* matricesB, const double* weightsB,
+                               double* interpolatedMatrices, double* angleDifferencesDeg = NULL);
+
+private:
+  PlusPoseInterpolator();
+  ~PlusPoseInterpolator();
+};
+
+#endif
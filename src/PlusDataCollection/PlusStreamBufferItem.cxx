@@ -53,6 +53,8 @@ StreamBufferItem& StreamBufferItem::operator=(StreamBufferItem const& dataItem)
   this->Status = dataItem.Status;
   this->Matrix->DeepCopy(dataItem.Matrix);
   this->ValidTransformData = dataItem.ValidTransformData;
+  // The copied frame has its own memory, it does not use the arena of the other item
+  this->FrameArena.reset();
 
   return *this;
 }
@@ -60,8 +62,13 @@ StreamBufferItem& StreamBufferItem::operator=(StreamBufferItem const& dataItem)
 //----------------------------------------------------------------------------
 void StreamBufferItem::SetFrameField(std::string fieldName, std::string fieldValue, igsioFrameFieldFlags flags)
 {
-  this->FrameFields[fieldName].first = flags;
-  this->FrameFields[fieldName].second = fieldValue;
+  this->FrameFields.SetField(fieldName, fieldValue, flags);
+}
+
+//----------------------------------------------------------------------------
+void StreamBufferItem::SetFrameField(const std::string& fieldName, const std::string& fieldValue, igsioFrameFieldFlags flags, const PlusFrameFieldStore* previousFields)
+{
+  this->FrameFields.SetField(fieldName, fieldValue, flags, previousFields);
 }
 
 //----------------------------------------------------------------------------
@@ -73,15 +80,28 @@ std::string StreamBufferItem::GetFrameField(const std::string& fieldName) const
     return "";
   }
 
-  igsioFieldMapType::const_iterator fieldIterator;
-  fieldIterator = this->FrameFields.find(fieldName);
-  if (fieldIterator != this->FrameFields.end())
+  const PlusFrameFieldStore::Field* field = this->FrameFields.GetField(fieldName);
+  if (field != NULL)
   {
-    return fieldIterator->second.second;
+    return *(field->Value);
   }
   return "";
 }
 
+//----------------------------------------------------------------------------
+igsioFieldMapType StreamBufferItem::GetFrameFieldMap() const
+{
+  igsioFieldMapType fieldMap;
+  this->FrameFields.AddToFieldMap(fieldMap);
+  return fieldMap;
+}
+
+//----------------------------------------------------------------------------
+void StreamBufferItem::SetFrameFieldMap(const igsioFieldMapType& fields)
+{
+  this->FrameFields.ReplaceFields(fields);
+}
+
 //----------------------------------------------------------------------------
 PlusStatus StreamBufferItem::DeleteFrameField(const char* fieldName)
 {
@@ -91,10 +111,8 @@ PlusStatus StreamBufferItem::DeleteFrameField(const char* fieldName)
     return PLUS_FAIL;
   }
 
-  igsioFieldMapType::iterator field = this->FrameFields.find(fieldName);
-  if (field != this->FrameFields.end())
+  if (this->FrameFields.DeleteField(fieldName))
   {
-    this->FrameFields.erase(field);
     return PLUS_SUCCESS;
   }
   LOG_DEBUG("Failed to delete frame field - could find field " << fieldName);
@@ -138,7 +156,7 @@ PlusStatus StreamBufferItem::SetMatrix(vtkMatrix4x4* matrix)
 }
 
 //----------------------------------------------------------------------------
-PlusStatus StreamBufferItem::GetMatrix(vtkMatrix4x4* outputMatrix)
+PlusStatus StreamBufferItem::GetMatrix(vtkMatrix4x4* outputMatrix) const
 {
   if (outputMatrix == NULL)
   {
@@ -151,6 +169,18 @@ PlusStatus StreamBufferItem::GetMatrix(vtkMatrix4x4* outputMatrix)
   return PLUS_SUCCESS;
 }
 
+//----------------------------------------------------------------------------
+void StreamBufferItem::SetMatrixElements(const double elements[16])
+{
+  this->Matrix->DeepCopy(elements);
+}
+
+//----------------------------------------------------------------------------
+void StreamBufferItem::GetMatrixElements(double elements[16]) const
+{
+  vtkMatrix4x4::DeepCopy(elements, this->Matrix);
+}
+
 //----------------------------------------------------------------------------
 void StreamBufferItem::SetStatus(ToolStatus status)
 {
@@ -166,5 +196,5 @@ ToolStatus StreamBufferItem::GetStatus() const
 //----------------------------------------------------------------------------
 bool StreamBufferItem::HasValidFieldData() const
 {
-  return this->FrameFields.size() > 0;
+  return !this->FrameFields.IsEmpty();
 }
\ No newline at end of file
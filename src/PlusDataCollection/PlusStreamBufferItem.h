@@ -8,6 +8,7 @@ See License.txt for details.
 #define __StreamBufferItem_h
 
 #include "vtkPlusDataCollectionExport.h"
+#include "PlusFrameFieldStore.h"
 
 // IGSIO includes
 #include <igsioCommon.h>
@@ -15,8 +16,10 @@ See License.txt for details.
 // VTK includes
 #include <vtkSmartPointer.h>
 
+#include <memory>
 #include <vector>
 
+class PlusFrameArena;
 class vtkMatrix4x4;
 class vtkPlusDevice;
 class vtkPlusChannel;
@@ -45,16 +48,16 @@ public:
   StreamBufferItem& operator=(StreamBufferItem const& dataItem);
 
   /*! Get timestamp for the current buffer item in global time (global = local + offset) */
-  double GetTimestamp(double localTimeOffsetSec) { return this->GetFilteredTimestamp(localTimeOffsetSec); }
+  double GetTimestamp(double localTimeOffsetSec) const { return this->GetFilteredTimestamp(localTimeOffsetSec); }
 
   /*! Get filtered timestamp in global time (global = local + offset) */
-  double GetFilteredTimestamp(double localTimeOffsetSec) { return this->FilteredTimeStamp + localTimeOffsetSec; }
+  double GetFilteredTimestamp(double localTimeOffsetSec) const { return this->FilteredTimeStamp + localTimeOffsetSec; }
 
   /*! Set filtered timestamp */
   void SetFilteredTimestamp(double filteredTimestamp) { this->FilteredTimeStamp = filteredTimestamp; }
 
   /*! Get unfiltered timestamp in global time (global = local + offset) */
-  double GetUnfilteredTimestamp(double localTimeOffsetSec) { return this->UnfilteredTimeStamp + localTimeOffsetSec; }
+  double GetUnfilteredTimestamp(double localTimeOffsetSec) const { return this->UnfilteredTimeStamp + localTimeOffsetSec; }
 
   /*! Set unfiltered timestamp */
   void SetUnfilteredTimestamp(double unfilteredTimestamp) { this->UnfilteredTimeStamp = unfilteredTimestamp; }
@@ -64,20 +67,31 @@ public:
     If frames are skipped then the counter should be increased by the number of skipped frames, therefore
     the index difference between subsequent frames be more than 1.
   */
-  unsigned long GetIndex() { return this->Index; };
+  unsigned long GetIndex() const { return this->Index; };
   void SetIndex(unsigned long index) { this->Index = index; };
 
   /*! Set/get unique identifier assigned by the storage buffer */
-  BufferItemUidType GetUid() { return this->Uid; };
+  BufferItemUidType GetUid() const { return this->Uid; };
   void SetUid(BufferItemUidType uid) { this->Uid = uid; };
 
   /*! Set frame field */
   void SetFrameField(std::string fieldName, std::string fieldValue, igsioFrameFieldFlags flags = FRAMEFIELD_NONE);
+  /*!
+    Set frame field. If the value is the same as in previousFields (typically the fields of the previous
+    item in the buffer) then the value is shared with previousFields instead of allocating memory for it.
+  */
+  void SetFrameField(const std::string& fieldName, const std::string& fieldValue, igsioFrameFieldFlags flags, const PlusFrameFieldStore* previousFields);
 
   /*! Get frame field value */
   std::string GetFrameField(const std::string& fieldName) const;
   /*! Get frame field map */
-  igsioFieldMapType GetFrameFieldMap() {return this->FrameFields;}
+  igsioFieldMapType GetFrameFieldMap() const;
+  /*! Replace all frame fields */
+  void SetFrameFieldMap(const igsioFieldMapType& fields);
+  /*! Get frame fields without copying them to a field map */
+  const PlusFrameFieldStore& GetFrameFieldStore() const { return this->FrameFields; }
+  /*! Replace all frame fields. The field values are shared with the other store. */
+  void SetFrameFieldStore(const PlusFrameFieldStore& fields) { this->FrameFields = fields; }
   /*! Delete frame field */
   PlusStatus DeleteFrameField(const char* fieldName);
   PlusStatus DeleteFrameField(const std::string& fieldName);
@@ -86,11 +100,16 @@ public:
   PlusStatus DeepCopy(StreamBufferItem* dataItem);
 
   igsioVideoFrame& GetFrame() { return this->Frame; };
+  const igsioVideoFrame& GetFrame() const { return this->Frame; };
 
   /*! Set tracker matrix */
   PlusStatus SetMatrix(vtkMatrix4x4* matrix);
   /*! Get tracker matrix */
-  PlusStatus GetMatrix(vtkMatrix4x4* outputMatrix);
+  PlusStatus GetMatrix(vtkMatrix4x4* outputMatrix) const;
+  /*! Set tracker matrix from 16 elements in row-major order. Does not change the transform validity flag. */
+  void SetMatrixElements(const double elements[16]);
+  /*! Get tracker matrix as 16 elements in row-major order */
+  void GetMatrixElements(double elements[16]) const;
 
   /*! Set tracker item status */
   void SetStatus(ToolStatus status);
@@ -105,6 +124,14 @@ public:
     return Frame.IsImageValid();
   }
 
+  /*!
+    Set the frame arena that holds the pixel data of the frame. The item keeps the arena alive,
+    so the pixel data remains valid while the item is referenced, even if the buffer has allocated a new arena since then.
+  */
+  void SetFrameArena(const std::shared_ptr<PlusFrameArena>& arena) { this->FrameArena = arena; }
+  /*! Get the frame arena that holds the pixel data of the frame. NULL if the frame has its own memory. */
+  const std::shared_ptr<PlusFrameArena>& GetFrameArena() const { return this->FrameArena; }
+
 protected:
   double FilteredTimeStamp;
   double UnfilteredTimeStamp;
@@ -116,12 +143,22 @@ protected:
   BufferItemUidType Uid;
 
   /*! Custom frame fields */
-  igsioFieldMapType FrameFields;
+  PlusFrameFieldStore FrameFields;
 
   bool ValidTransformData;
   igsioVideoFrame Frame;
   vtkSmartPointer<vtkMatrix4x4> Matrix;
   ToolStatus Status;
+
+  /*! Arena that holds the pixel data of Frame */
+  std::shared_ptr<PlusFrameArena> FrameArena;
 };
 
+/*!
+  Read-only, reference-counted handle to an item stored in a buffer.
+  The buffer does not modify or recycle the referenced item as long as a handle to it exists,
+  therefore the item can be accessed without copying and without locking the buffer.
+*/
+typedef std::shared_ptr<const StreamBufferItem> StreamBufferItemView;
+
 #endif
@@ -0,0 +1,405 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+#include "PlusConfigure.h"
+#include "PlusClock.h"
+#include "PlusTrackedFrameJoiner.h"
+#include "vtkPlusDataSource.h"
+
+#include <igsioTrackedFrame.h>
+#include <vtkIGSIOTrackedFrameList.h>
+
+#include <chrono>
+#include <limits>
+
+namespace
+{
+  const int DEFAULT_MAX_NUMBER_OF_READY_FRAMES = 100;
+  const double DEFAULT_SOURCE_STALL_TIMEOUT_SEC = 0.5;
+}
+
+//----------------------------------------------------------------------------
+PlusTrackedFrameJoiner::PlusTrackedFrameJoiner(vtkPlusChannel* channel, bool enableImageData /*=true*/)
+  : Channel(channel)
+  , EnableImageData(enableImageData)
+  , Started(false)
+  , MaxNumberOfReadyFrames(DEFAULT_MAX_NUMBER_OF_READY_FRAMES)
+  , SourceStallTimeoutSec(DEFAULT_SOURCE_STALL_TIMEOUT_SEC)
+  , LatestJoinedTimestamp(UNDEFINED_TIMESTAMP)
+  , NumberOfDroppedFrames(0)
+  , Threader(vtkSmartPointer<vtkMultiThreader>::New())
+  , JoinThreadId(-1)
+  , StopRequested(false)
+  , JoinThreadActive(false)
+{
+}
+
+//----------------------------------------------------------------------------
+PlusTrackedFrameJoiner::~PlusTrackedFrameJoiner()
+{
+  this->Stop();
+}
+
+//----------------------------------------------------------------------------
+PlusStatus PlusTrackedFrameJoiner::Start()
+{
+  if (this->Started)
+  {
+    return PLUS_SUCCESS;
+  }
+  if (this->Channel == NULL)
+  {
+    LOG_ERROR("Unable to start tracked frame joiner: channel is not specified");
+    return PLUS_FAIL;
+  }
+  vtkPlusDataSource* masterSource = this->Channel->GetNewFrameMasterSource();
+  if (masterSource == NULL)
+  {
+    LOG_ERROR("Unable to start tracked frame joiner: channel " << this->Channel->GetChannelId() << " has no data sources");
+    return PLUS_FAIL;
+  }
+
+  // Collect the sources first, the callbacks may be called as soon as they are registered
+  std::vector<vtkPlusDataSource*> sources;
+  sources.push_back(masterSource);
+  vtkPlusDataSource* videoSource(NULL);
+  if (this->Channel->GetVideoSource(videoSource) == PLUS_SUCCESS && videoSource != masterSource)
+  {
+    sources.push_back(videoSource);
+  }
+  for (DataSourceContainerConstIterator it = this->Channel->GetToolsStartConstIterator(); it != this->Channel->GetToolsEndConstIterator(); ++it)
+  {
+    if (it->second != masterSource)
+    {
+      sources.push_back(it->second);
+    }
+  }
+  for (DataSourceContainerConstIterator it = this->Channel->GetFieldDataSourcesStartConstIterator(); it != this->Channel->GetFieldDataSourcesEndConstIterator(); ++it)
+  {
+    if (it->second != masterSource)
+    {
+      sources.push_back(it->second);
+    }
+  }
+
+  const double now = PlusClock::GetSystemTime();
+  {
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    this->Sources.clear();
+    this->PendingTimestamps.clear();
+    this->StopRequested = false;
+    for (std::vector<vtkPlusDataSource*>::iterator it = sources.begin(); it != sources.end(); ++it)
+    {
+      SourceWatermark watermark;
+      watermark.DataSource = *it;
+      watermark.CallbackId = 0;
+      watermark.UpdateTime = now;
+      if ((*it)->GetLatestTimeStamp(watermark.Timestamp) != ITEM_OK)
+      {
+        watermark.Timestamp = UNDEFINED_TIMESTAMP;
+      }
+      this->Sources.push_back(watermark);
+    }
+  }
+
+  for (size_t sourceIndex = 0; sourceIndex < sources.size(); ++sourceIndex)
+  {
+    unsigned long callbackId = sources[sourceIndex]->AddItemAddedCallback([this, sourceIndex](BufferItemUidType, double timestamp)
+    {
+      this->OnItemAdded(sourceIndex, timestamp);
+    });
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    this->Sources[sourceIndex].CallbackId = callbackId;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    this->JoinThreadActive = true;
+  }
+  this->JoinThreadId = this->Threader->SpawnThread((vtkThreadFunctionType)&JoinThread, this);
+  this->Started = true;
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+void PlusTrackedFrameJoiner::Stop()
+{
+  if (!this->Started)
+  {
+    return;
+  }
+
+  // Callbacks lock the mutex, so they must be removed without holding it
+  this->Unsubscribe();
+
+  {
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    this->StopRequested = true;
+  }
+  this->SourceUpdated.notify_all();
+
+  {
+    // Wait until the join thread is finished, it notifies FramesReady when it exits
+    std::unique_lock<std::mutex> lock(this->Mutex);
+    this->FramesReady.wait(lock, [this]()
+    {
+      return !this->JoinThreadActive;
+    });
+  }
+  this->Threader->TerminateThread(this->JoinThreadId);
+  this->JoinThreadId = -1;
+
+  {
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    this->PendingTimestamps.clear();
+    this->Sources.clear();
+  }
+  this->Started = false;
+}
+
+//----------------------------------------------------------------------------
+void PlusTrackedFrameJoiner::Unsubscribe()
+{
+  std::vector<SourceWatermark> sources;
+  {
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    sources = this->Sources;
+  }
+  for (std::vector<SourceWatermark>::iterator it = sources.begin(); it != sources.end(); ++it)
+  {
+    it->DataSource->RemoveItemAddedCallback(it->CallbackId);
+  }
+}
+
+//----------------------------------------------------------------------------
+void PlusTrackedFrameJoiner::SetMaxNumberOfReadyFrames(int maxNumberOfReadyFrames)
+{
+  std::lock_guard<std::mutex> lock(this->Mutex);
+  this->MaxNumberOfReadyFrames = maxNumberOfReadyFrames;
+}
+
+//----------------------------------------------------------------------------
+int PlusTrackedFrameJoiner::GetMaxNumberOfReadyFrames()
+{
+  std::lock_guard<std::mutex> lock(this->Mutex);
+  return this->MaxNumberOfReadyFrames;
+}
+
+//----------------------------------------------------------------------------
+void PlusTrackedFrameJoiner::SetSourceStallTimeoutSec(double timeoutSec)
+{
+  std::lock_guard<std::mutex> lock(this->Mutex);
+  this->SourceStallTimeoutSec = timeoutSec;
+}
+
+//----------------------------------------------------------------------------
+double PlusTrackedFrameJoiner::GetSourceStallTimeoutSec()
+{
+  std::lock_guard<std::mutex> lock(this->Mutex);
+  return this->SourceStallTimeoutSec;
+}
+
+//----------------------------------------------------------------------------
+void PlusTrackedFrameJoiner::SetFramesReadyCallback(FramesReadyCallbackType callback)
+{
+  if (this->Started)
+  {
+    LOG_ERROR("Unable to set the frames ready callback of a started tracked frame joiner");
+    return;
+  }
+  this->FramesReadyCallback = callback;
+}
+
+//----------------------------------------------------------------------------
+int PlusTrackedFrameJoiner::GetNumberOfReadyFrames()
+{
+  std::lock_guard<std::mutex> lock(this->Mutex);
+  return static_cast<int>(this->ReadyFrames.size());
+}
+
+//----------------------------------------------------------------------------
+bool PlusTrackedFrameJoiner::WaitForReadyFrames(double timeoutSec)
+{
+  std::unique_lock<std::mutex> lock(this->Mutex);
+  return this->FramesReady.wait_for(lock, std::chrono::duration<double>(timeoutSec), [this]()
+  {
+    return !this->ReadyFrames.empty() || !this->JoinThreadActive;
+  }) && !this->ReadyFrames.empty();
+}
+
+//----------------------------------------------------------------------------
+int PlusTrackedFrameJoiner::PopReadyFrames(vtkIGSIOTrackedFrameList* trackedFrameList, int maxNumberOfFrames /*=-1*/)
+{
+  if (trackedFrameList == NULL)
+  {
+    LOG_ERROR("Unable to get ready frames: tracked frame list is NULL");
+    return 0;
+  }
+
+  std::vector<vtkPlusChannel::TrackedFrameView> frameViews;
+  {
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    while (!this->ReadyFrames.empty() && (maxNumberOfFrames < 0 || static_cast<int>(frameViews.size()) < maxNumberOfFrames))
+    {
+      frameViews.push_back(this->ReadyFrames.front());
+      this->ReadyFrames.pop_front();
+    }
+  }
+
+  // Copy the images without holding the lock, so the join thread is not blocked
+  int numberOfAddedFrames(0);
+  for (std::vector<vtkPlusChannel::TrackedFrameView>::const_iterator it = frameViews.begin(); it != frameViews.end(); ++it)
+  {
+    igsioTrackedFrame* trackedFrame = new igsioTrackedFrame;
+    if (it->CopyToTrackedFrame(*trackedFrame) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to copy joined frame (timestamp: " << std::fixed << it->Timestamp << ")");
+      delete trackedFrame;
+      continue;
+    }
+    if (trackedFrameList->TakeTrackedFrame(trackedFrame, vtkIGSIOTrackedFrameList::SKIP_INVALID_FRAME) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to add joined frame to the list (timestamp: " << std::fixed << it->Timestamp << ")");
+      continue;
+    }
+    ++numberOfAddedFrames;
+  }
+  return numberOfAddedFrames;
+}
+
+//----------------------------------------------------------------------------
+void PlusTrackedFrameJoiner::ClearReadyFrames()
+{
+  std::lock_guard<std::mutex> lock(this->Mutex);
+  this->ReadyFrames.clear();
+}
+
+//----------------------------------------------------------------------------
+double PlusTrackedFrameJoiner::GetLatestJoinedTimestamp()
+{
+  std::lock_guard<std::mutex> lock(this->Mutex);
+  return this->LatestJoinedTimestamp;
+}
+
+//----------------------------------------------------------------------------
+unsigned long PlusTrackedFrameJoiner::GetNumberOfDroppedFrames()
+{
+  std::lock_guard<std::mutex> lock(this->Mutex);
+  return this->NumberOfDroppedFrames;
+}
+
+//----------------------------------------------------------------------------
+void PlusTrackedFrameJoiner::OnItemAdded(size_t sourceIndex, double timestamp)
+{
+  {
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    if (sourceIndex >= this->Sources.size())
+    {
+      return;
+    }
+    SourceWatermark& watermark = this->Sources[sourceIndex];
+    if (watermark.Timestamp == UNDEFINED_TIMESTAMP || timestamp > watermark.Timestamp)
+    {
+      watermark.Timestamp = timestamp;
+    }
+    watermark.UpdateTime = PlusClock::GetSystemTime();
+    if (sourceIndex == 0 && (this->PendingTimestamps.empty() || timestamp > this->PendingTimestamps.back()))
+    {
+      this->PendingTimestamps.push_back(timestamp);
+    }
+  }
+  this->SourceUpdated.notify_one();
+}
+
+//----------------------------------------------------------------------------
+double PlusTrackedFrameJoiner::GetSafeTimestamp(double currentTime) const
+{
+  double safeTimestamp = std::numeric_limits<double>::max();
+  // The master source determines the frames, only the other sources can hold them back
+  for (size_t sourceIndex = 1; sourceIndex < this->Sources.size(); ++sourceIndex)
+  {
+    const SourceWatermark& watermark = this->Sources[sourceIndex];
+    if (currentTime - watermark.UpdateTime > this->SourceStallTimeoutSec)
+    {
+      // Stalled source, do not wait for it
+      continue;
+    }
+    if (watermark.Timestamp == UNDEFINED_TIMESTAMP)
+    {
+      // No data yet, nothing can be joined
+      return UNDEFINED_TIMESTAMP;
+    }
+    if (watermark.Timestamp < safeTimestamp)
+    {
+      safeTimestamp = watermark.Timestamp;
+    }
+  }
+  return safeTimestamp;
+}
+
+//----------------------------------------------------------------------------
+void* PlusTrackedFrameJoiner::JoinThread(vtkMultiThreader::ThreadInfo* data)
+{
+  PlusTrackedFrameJoiner* self = static_cast<PlusTrackedFrameJoiner*>(data->UserData);
+
+  std::vector<double> timestamps;
+  std::vector<vtkPlusChannel::TrackedFrameView> frameViews;
+  std::unique_lock<std::mutex> lock(self->Mutex);
+  while (!self->StopRequested)
+  {
+    // Collect the pending frames that all the sources have data for
+    const double safeTimestamp = self->GetSafeTimestamp(PlusClock::GetSystemTime());
+    timestamps.clear();
+    while (safeTimestamp != UNDEFINED_TIMESTAMP && !self->PendingTimestamps.empty() && self->PendingTimestamps.front() <= safeTimestamp)
+    {
+      timestamps.push_back(self->PendingTimestamps.front());
+      self->PendingTimestamps.pop_front();
+    }
+
+    if (timestamps.empty())
+    {
+      // Wake up regularly even if there are no new items, to notice stalled sources
+      self->SourceUpdated.wait_for(lock, std::chrono::duration<double>(self->SourceStallTimeoutSec));
+      continue;
+    }
+
+    // Buffers are queried without holding the lock, because it is needed by the item added callbacks
+    lock.unlock();
+    self->Channel->GetTrackedFrameViews(timestamps, frameViews, self->EnableImageData);
+    lock.lock();
+
+    for (std::vector<vtkPlusChannel::TrackedFrameView>::iterator it = frameViews.begin(); it != frameViews.end(); ++it)
+    {
+      if (it->Timestamp == UNDEFINED_TIMESTAMP)
+      {
+        // Data is not available (e.g., it has been already overwritten in the buffer)
+        ++self->NumberOfDroppedFrames;
+        continue;
+      }
+      self->ReadyFrames.push_back(*it);
+      self->LatestJoinedTimestamp = it->Timestamp;
+    }
+    while (self->MaxNumberOfReadyFrames >= 0 && static_cast<int>(self->ReadyFrames.size()) > self->MaxNumberOfReadyFrames)
+    {
+      self->ReadyFrames.pop_front();
+      ++self->NumberOfDroppedFrames;
+    }
+    frameViews.clear();
+    self->FramesReady.notify_all();
+    if (self->FramesReadyCallback)
+    {
+      // The callback is not changed while the thread runs, and it is called without the lock, so that it can query the joiner
+      lock.unlock();
+      self->FramesReadyCallback();
+      lock.lock();
+    }
+  }
+
+  self->JoinThreadActive = false;
+  lock.unlock();
+  self->FramesReady.notify_all();
+  return NULL;
+}
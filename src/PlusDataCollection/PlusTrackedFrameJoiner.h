@@ -0,0 +1,162 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+#ifndef __PlusTrackedFrameJoiner_h
+#define __PlusTrackedFrameJoiner_h
+
+#include "PlusConfigure.h"
+#include "vtkPlusDataCollectionExport.h"
+#include "vtkPlusChannel.h"
+
+#include <vtkMultiThreader.h>
+#include <vtkSmartPointer.h>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+class vtkIGSIOTrackedFrameList;
+class vtkPlusDataSource;
+
+/*!
+  \class PlusTrackedFrameJoiner
+  \brief Joins the data sources of a channel into tracked frames in time order, as soon as all the sources have data for them
+
+  Channels that combine sources of several devices (such as the output channel of a virtual mixer) receive the items
+  of each source at a different rate and delay. When a frame is requested right after the master source
+  (see vtkPlusChannel::GetNewFrameMasterSource) received it, the slower sources may not have data for that time yet.
+
+  The joiner keeps a watermark for each source of the channel: the timestamp of its latest item, which is updated
+  whenever an item is added to the source. A new item of the master source becomes a pending frame,
+  which is joined when the watermarks of all the other sources have passed its timestamp. The pending frames are joined
+  in batches on a background thread (see vtkPlusChannel::GetTrackedFrameViews), so the buffers are queried once
+  for many frames and each tool is interpolated by walking its buffer forward. Joined frames are put into a ready queue,
+  from which consumers can take them without querying the buffers.
+
+  Times are measured by PlusClock, so in virtual-time mode a source only stalls when the virtual time advances.
+  A source that has not received any item for SourceStallTimeoutSec (for example because its device was disconnected)
+  does not hold back the join, frames that need its data cannot be retrieved and are dropped.
+
+  The frames in the ready queue refer to the video items (see vtkPlusChannel::TrackedFrameView),
+  therefore the queue should be drained regularly. The oldest frames are dropped if the queue is full.
+
+  \ingroup PlusLibDataCollection
+*/
+class vtkPlusDataCollectionExport PlusTrackedFrameJoiner
+{
+public:
+  typedef std::function<void()> FramesReadyCallbackType;
+
+  /*!
+    \param channel Channel whose sources are joined. The channel must not be deleted or reconfigured while the joiner is started.
+    \param enableImageData Include the image data in the joined frames
+  */
+  PlusTrackedFrameJoiner(vtkPlusChannel* channel, bool enableImageData = true);
+  virtual ~PlusTrackedFrameJoiner();
+
+  /*! Start monitoring the sources of the channel and joining their items. Only the items that are added after this call are joined. */
+  PlusStatus Start();
+  /*! Stop joining frames. Frames in the ready queue are kept, pending frames are discarded. */
+  void Stop();
+  bool IsStarted() const { return this->Started; }
+
+  /*! Set the maximum number of frames in the ready queue. The oldest frames are dropped if the queue is full. */
+  void SetMaxNumberOfReadyFrames(int maxNumberOfReadyFrames);
+  int GetMaxNumberOfReadyFrames();
+
+  /*! Set the time after a source without new items does not hold back the join anymore */
+  void SetSourceStallTimeoutSec(double timeoutSec);
+  double GetSourceStallTimeoutSec();
+
+  /*!
+    Set a function that is called whenever frames are added to the ready queue, for example to wake up a consumer that
+    waits for the frames of several joiners. The function is called on the join thread without holding the lock of the joiner.
+    It can only be set while the joiner is stopped.
+  */
+  void SetFramesReadyCallback(FramesReadyCallbackType callback);
+
+  /*! Get the number of frames that can be taken from the ready queue */
+  int GetNumberOfReadyFrames();
+
+  /*!
+    Block the calling thread until there are frames in the ready queue or the timeout expires
+    \return true if there are ready frames
+  */
+  bool WaitForReadyFrames(double timeoutSec);
+
+  /*!
+    Take frames from the ready queue (in time order) and append them to a tracked frame list. The images are copied at this point.
+    \param maxNumberOfFrames Maximum number of frames to take, all the ready frames are taken if it is negative
+    \return Number of frames that were appended to the list
+  */
+  int PopReadyFrames(vtkIGSIOTrackedFrameList* trackedFrameList, int maxNumberOfFrames = -1);
+
+  /*! Discard the frames in the ready queue, for example when there is no consumer for them. They are not counted as dropped. */
+  void ClearReadyFrames();
+
+  /*! Get the timestamp of the latest joined frame, UNDEFINED_TIMESTAMP if no frame has been joined yet */
+  double GetLatestJoinedTimestamp();
+
+  /*! Get the number of frames that were dropped because the ready queue was full or their data could not be retrieved */
+  unsigned long GetNumberOfDroppedFrames();
+
+protected:
+  /*! Watermark of a data source of the channel */
+  struct SourceWatermark
+  {
+    vtkSmartPointer<vtkPlusDataSource> DataSource;
+    unsigned long CallbackId;
+    /*! Timestamp of the latest item of the source (in global time) */
+    double Timestamp;
+    /*! Time (see PlusClock) when the watermark was updated the last time */
+    double UpdateTime;
+  };
+
+  static void* JoinThread(vtkMultiThreader::ThreadInfo* data);
+
+  /*! Called by the data sources when an item is added */
+  void OnItemAdded(size_t sourceIndex, double timestamp);
+
+  /*! Get the time until which all the sources that are not stalled have data. Mutex must be locked. */
+  double GetSafeTimestamp(double currentTime) const;
+
+  /*! Remove the item added callbacks of all the sources. Mutex must not be locked. */
+  void Unsubscribe();
+
+  vtkPlusChannel* Channel;
+  bool EnableImageData;
+  bool Started;
+
+  std::mutex Mutex;
+  /*! Notified when the watermark of a source is updated or the thread should stop */
+  std::condition_variable SourceUpdated;
+  /*! Notified when frames are added to the ready queue or the thread stops */
+  std::condition_variable FramesReady;
+  FramesReadyCallbackType FramesReadyCallback;
+
+  /*! Watermarks of the sources, the first one is the master source of the channel */
+  std::vector<SourceWatermark> Sources;
+  /*! Timestamps of the master source items that have not been joined yet, in time order */
+  std::deque<double> PendingTimestamps;
+  std::deque<vtkPlusChannel::TrackedFrameView> ReadyFrames;
+  int MaxNumberOfReadyFrames;
+  double SourceStallTimeoutSec;
+  double LatestJoinedTimestamp;
+  unsigned long NumberOfDroppedFrames;
+
+  vtkSmartPointer<vtkMultiThreader> Threader;
+  int JoinThreadId;
+  bool StopRequested;
+  bool JoinThreadActive;
+
+private:
+  PlusTrackedFrameJoiner(const PlusTrackedFrameJoiner&);
+  PlusTrackedFrameJoiner& operator=(const PlusTrackedFrameJoiner&);
+};
+
+#endif
@@ -0,0 +1,124 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+#include "PlusConfigure.h"
+#include "PlusTransformSampleStore.h"
+
+#include <vtkMatrix4x4.h>
+
+//----------------------------------------------------------------------------
+PlusTransformSampleStore::PlusTransformSampleStore()
+{
+}
+
+//----------------------------------------------------------------------------
+PlusTransformSampleStore::~PlusTransformSampleStore()
+{
+}
+
+//----------------------------------------------------------------------------
+void PlusTransformSampleStore::Clear()
+{
+  this->Matrices.clear();
+  this->FilteredTimestamps.clear();
+  this->UnfilteredTimestamps.clear();
+  this->Indices.clear();
+  this->Uids.clear();
+  this->Statuses.clear();
+  this->ValidTransformData.clear();
+  this->FrameFields.clear();
+}
+
+//----------------------------------------------------------------------------
+void PlusTransformSampleStore::InsertSlots(int position, int numberOfSlots)
+{
+  if (numberOfSlots <= 0)
+  {
+    return;
+  }
+  this->Matrices.insert(this->Matrices.begin() + static_cast<size_t>(position) * MATRIX_ELEMENT_COUNT, static_cast<size_t>(numberOfSlots) * MATRIX_ELEMENT_COUNT, 0.0);
+  this->FilteredTimestamps.insert(this->FilteredTimestamps.begin() + position, numberOfSlots, 0.0);
+  this->UnfilteredTimestamps.insert(this->UnfilteredTimestamps.begin() + position, numberOfSlots, 0.0);
+  this->Indices.insert(this->Indices.begin() + position, numberOfSlots, 0);
+  this->Uids.insert(this->Uids.begin() + position, numberOfSlots, 0);
+  this->Statuses.insert(this->Statuses.begin() + position, numberOfSlots, TOOL_OK);
+  this->ValidTransformData.insert(this->ValidTransformData.begin() + position, numberOfSlots, 0);
+  this->FrameFields.insert(this->FrameFields.begin() + position, numberOfSlots, PlusFrameFieldStore());
+}
+
+//----------------------------------------------------------------------------
+void PlusTransformSampleStore::EraseSlot(int position)
+{
+  std::vector<double>::iterator matrixBegin = this->Matrices.begin() + static_cast<size_t>(position) * MATRIX_ELEMENT_COUNT;
+  this->Matrices.erase(matrixBegin, matrixBegin + MATRIX_ELEMENT_COUNT);
+  this->FilteredTimestamps.erase(this->FilteredTimestamps.begin() + position);
+  this->UnfilteredTimestamps.erase(this->UnfilteredTimestamps.begin() + position);
+  this->Indices.erase(this->Indices.begin() + position);
+  this->Uids.erase(this->Uids.begin() + position);
+  this->Statuses.erase(this->Statuses.begin() + position);
+  this->ValidTransformData.erase(this->ValidTransformData.begin() + position);
+  this->FrameFields.erase(this->FrameFields.begin() + position);
+}
+
+//----------------------------------------------------------------------------
+PlusStatus PlusTransformSampleStore::SetItem(int slot, vtkMatrix4x4* matrix, ToolStatus status, unsigned long index, BufferItemUidType uid,
+    double filteredTimestamp, double unfilteredTimestamp, const igsioFieldMapType* customFields)
+{
+  if (slot < 0 || slot >= this->GetSize())
+  {
+    LOG_ERROR("Failed to store transform - slot index is out of range (slot: " << slot << ", size: " << this->GetSize() << ").");
+    return PLUS_FAIL;
+  }
+  if (matrix == NULL)
+  {
+    LOG_ERROR("Failed to store transform - input matrix is NULL!");
+    return PLUS_FAIL;
+  }
+
+  vtkMatrix4x4::DeepCopy(&this->Matrices[static_cast<size_t>(slot) * MATRIX_ELEMENT_COUNT], matrix);
+  this->FilteredTimestamps[slot] = filteredTimestamp;
+  this->UnfilteredTimestamps[slot] = unfilteredTimestamp;
+  this->Indices[slot] = index;
+  this->Uids[slot] = uid;
+  this->Statuses[slot] = status;
+  this->ValidTransformData[slot] = 1;
+  if (customFields != NULL)
+  {
+    // Field values that are the same as in the previous item are shared with it
+    int previousSlot = (slot > 0 ? slot : this->GetSize()) - 1;
+    const PlusFrameFieldStore* previousFields = (previousSlot != slot && this->Uids[previousSlot] + 1 == uid) ? &this->FrameFields[previousSlot] : NULL;
+    this->FrameFields[slot].ReplaceFields(*customFields, previousFields);
+  }
+  else
+  {
+    this->FrameFields[slot].Clear();
+  }
+
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+void PlusTransformSampleStore::GetItem(int slot, StreamBufferItem& item) const
+{
+  if (item.HasValidVideoData())
+  {
+    item.GetFrame() = igsioVideoFrame();
+  }
+  item.SetMatrixElements(&this->Matrices[static_cast<size_t>(slot) * MATRIX_ELEMENT_COUNT]);
+  item.SetValidTransformData(this->ValidTransformData[slot] != 0);
+  item.SetStatus(this->Statuses[slot]);
+  item.SetFilteredTimestamp(this->FilteredTimestamps[slot]);
+  item.SetUnfilteredTimestamp(this->UnfilteredTimestamps[slot]);
+  item.SetIndex(this->Indices[slot]);
+  item.SetUid(this->Uids[slot]);
+  item.SetFrameFieldStore(this->FrameFields[slot]);
+}
+
+//----------------------------------------------------------------------------
+void PlusTransformSampleStore::SetFrameField(int slot, const std::string& fieldName, const std::string& fieldValue, igsioFrameFieldFlags flags)
+{
+  this->FrameFields[slot].SetField(fieldName, fieldValue, flags);
+}
@@ -0,0 +1,84 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+#ifndef __PlusTransformSampleStore_h
+#define __PlusTransformSampleStore_h
+
+#include "vtkPlusDataCollectionExport.h"
+#include "PlusStreamBufferItem.h"
+
+#include <vector>
+
+class vtkMatrix4x4;
+
+/*!
+  \class PlusTransformSampleStore
+  \brief Compact storage for the items of a transform-only buffer.
+
+  Each item is stored in a slot of parallel arrays (matrix elements, status, index, UID and timestamps)
+  instead of a StreamBufferItem object, so a pose takes a few hundred bytes less memory, requires no heap
+  allocation, and poses of subsequent items are next to each other in memory. Custom frame fields are kept
+  in a field store for each slot, which shares unchanged field values with the previous slot.
+
+  \ingroup PlusLibDataCollection
+*/
+class vtkPlusDataCollectionExport PlusTransformSampleStore
+{
+public:
+  /*! Number of matrix elements stored for each item (4x4 matrix, row-major order) */
+  static const int MATRIX_ELEMENT_COUNT = 16;
+
+  PlusTransformSampleStore();
+  virtual ~PlusTransformSampleStore();
+
+  /*! Get the number of slots */
+  int GetSize() const { return static_cast<int>(this->FilteredTimestamps.size()); }
+  /*! Get the number of bytes of memory that one slot uses (custom frame field values are not included) */
+  static size_t GetSlotSizeBytes()
+  {
+    return MATRIX_ELEMENT_COUNT * sizeof(double) + 2 * sizeof(double) + sizeof(unsigned long) + sizeof(BufferItemUidType)
+           + sizeof(ToolStatus) + sizeof(unsigned char) + sizeof(PlusFrameFieldStore);
+  }
+
+  /*! Remove all slots */
+  void Clear();
+  /*! Insert numberOfSlots empty slots before the slot at position */
+  void InsertSlots(int position, int numberOfSlots);
+  /*! Remove the slot at position */
+  void EraseSlot(int position);
+
+  /*! Store a transform in a slot. Previous content of the slot is overwritten. */
+  PlusStatus SetItem(int slot, vtkMatrix4x4* matrix, ToolStatus status, unsigned long index, BufferItemUidType uid,
+                     double filteredTimestamp, double unfilteredTimestamp, const igsioFieldMapType* customFields);
+  /*! Copy the content of a slot to a buffer item. The item does not contain video data after the copy. */
+  void GetItem(int slot, StreamBufferItem& item) const;
+
+  double GetFilteredTimestamp(int slot) const { return this->FilteredTimestamps[slot]; }
+  double GetUnfilteredTimestamp(int slot) const { return this->UnfilteredTimestamps[slot]; }
+  unsigned long GetIndex(int slot) const { return this->Indices[slot]; }
+  BufferItemUidType GetUid(int slot) const { return this->Uids[slot]; }
+  ToolStatus GetStatus(int slot) const { return this->Statuses[slot]; }
+  bool HasValidTransformData(int slot) const { return this->ValidTransformData[slot] != 0; }
+  bool HasValidFieldData(int slot) const { return !this->FrameFields[slot].IsEmpty(); }
+  /*! Get the MATRIX_ELEMENT_COUNT matrix elements of the transform stored in a slot */
+  const double* GetMatrixElements(int slot) const { return &this->Matrices[static_cast<size_t>(slot) * MATRIX_ELEMENT_COUNT]; }
+
+  /*! Set a custom frame field of the item stored in a slot */
+  void SetFrameField(int slot, const std::string& fieldName, const std::string& fieldValue, igsioFrameFieldFlags flags = FRAMEFIELD_NONE);
+
+protected:
+  /*! MATRIX_ELEMENT_COUNT elements for each slot */
+  std::vector<double> Matrices;
+  std::vector<double> FilteredTimestamps;
+  std::vector<double> UnfilteredTimestamps;
+  std::vector<unsigned long> Indices;
+  std::vector<BufferItemUidType> Uids;
+  std::vector<ToolStatus> Statuses;
+  std::vector<unsigned char> ValidTransformData;
+  std::vector<PlusFrameFieldStore> FrameFields;
+};
+
+#endif
@@ -85,7 +85,7 @@ PlusStatus vtkPlusSavedDataSource::InternalUpdate()
 PlusStatus vtkPlusSavedDataSource::InternalUpdateOriginalTimestamp(BufferItemUidType frameToBeAddedUid, int frameToBeAddedLoopIndex)
 {
   // Compute elapsed time since we started the acquisition
-  double elapsedTime = vtkIGSIOAccurateTimer::GetSystemTime() - this->GetOutputDataSource()->GetStartTime();
+  double elapsedTime = PlusClock::GetSystemTime() - this->GetOutputDataSource()->GetStartTime();
   double loopTime = this->LoopStopTime_Local - this->LoopStartTime_Local;
 
   const int numberOfFramesInTheLoop = this->LoopLastFrameUid - this->LoopFirstFrameUid + 1;
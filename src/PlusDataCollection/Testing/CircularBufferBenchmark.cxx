@@ -0,0 +1,347 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file CircularBufferBenchmark.cxx
+  \brief Measures how much readers of a buffer slow down the thread that adds items to the buffer and how fast items can be looked up by time.
+
+  A writer thread adds transforms to a buffer as fast as it can while reader threads continuously query
+  the latest item UID, item timestamps and look up item UIDs by time (as the OpenIGTLink server and
+  virtual devices do). The benchmark runs once with the default (locked) buffer and once with
+  lock-free reads enabled, reports the writer throughput and latency, and checks that the readers
+  got consistent results in both modes.
+
+  The lookup benchmark fills a large buffer with items that have slightly irregular timestamps (with jitter
+  and dropped frames) and measures the time of looking up item UIDs by time, in both modes. The returned
+  UIDs are checked against the expected values.
+
+  With --compact-transform-storage the buffers store the transforms in compact, transform-only storage.
+*/
+
+// Local includes
+#include "PlusConfigure.h"
+#include "vtkPlusBuffer.h"
+
+// VTK includes
+#include <vtkMatrix4x4.h>
+#include <vtkMultiThreader.h>
+#include <vtksys/CommandLineArguments.hxx>
+
+// STL includes
+#include <atomic>
+#include <cmath>
+
+namespace
+{
+  // Period of the simulated tracker (300Hz)
+  const double ITEM_PERIOD_SEC = 1.0 / 300.0;
+
+  // Every DROPPED_FRAME_PERIOD-th frame is not added to the buffer in the lookup benchmark
+  const int DROPPED_FRAME_PERIOD = 7;
+
+  struct BenchmarkState
+  {
+    vtkPlusBuffer* Buffer;
+    double DurationSec;
+    std::atomic<bool> WriterDone;
+
+    // Writer statistics
+    unsigned long NumberOfItemsAdded;
+    double MaxAddItemTimeSec;
+    double SumAddItemTimeSec;
+
+    // Reader statistics
+    std::atomic<unsigned long> NumberOfReads;
+    std::atomic<unsigned long> NumberOfInconsistentReads;
+  };
+
+  //----------------------------------------------------------------------------
+  void* WriterThread(vtkMultiThreader::ThreadInfo* data)
+  {
+    BenchmarkState* state = static_cast<BenchmarkState*>(data->UserData);
+    vtkSmartPointer<vtkMatrix4x4> matrix = vtkSmartPointer<vtkMatrix4x4>::New();
+
+    double startTime = vtkIGSIOAccurateTimer::GetSystemTime();
+    unsigned long frameNumber = 0;
+    while (vtkIGSIOAccurateTimer::GetSystemTime() - startTime < state->DurationSec)
+    {
+      ++frameNumber;
+      // Timestamps are generated from the frame number, so readers can verify the UID - timestamp pairs
+      double timestamp = frameNumber * ITEM_PERIOD_SEC;
+      matrix->SetElement(0, 3, frameNumber);
+
+      double addItemStartTime = vtkIGSIOAccurateTimer::GetSystemTime();
+      if (state->Buffer->AddTimeStampedItem(matrix, TOOL_OK, frameNumber, timestamp, timestamp) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Failed to add item " << frameNumber << " to the buffer");
+        break;
+      }
+      double addItemTimeSec = vtkIGSIOAccurateTimer::GetSystemTime() - addItemStartTime;
+
+      state->SumAddItemTimeSec += addItemTimeSec;
+      if (addItemTimeSec > state->MaxAddItemTimeSec)
+      {
+        state->MaxAddItemTimeSec = addItemTimeSec;
+      }
+    }
+    state->NumberOfItemsAdded = frameNumber;
+    state->WriterDone = true;
+    return NULL;
+  }
+
+  //----------------------------------------------------------------------------
+  void* ReaderThread(vtkMultiThreader::ThreadInfo* data)
+  {
+    BenchmarkState* state = static_cast<BenchmarkState*>(data->UserData);
+    unsigned long numberOfReads = 0;
+    unsigned long numberOfInconsistentReads = 0;
+    while (!state->WriterDone)
+    {
+      BufferItemUidType latestUid = state->Buffer->GetLatestItemUidInBuffer();
+      if (latestUid < 2)
+      {
+        continue;
+      }
+
+      // Query an item that is a few items older than the latest, as the server does when it waits for all tools to have data
+      BufferItemUidType uid = latestUid - 1;
+      double timestamp = 0;
+      if (state->Buffer->GetTimeStamp(uid, timestamp) != ITEM_OK)
+      {
+        continue;
+      }
+
+      // Slightly perturbed time must still be mapped back to the same item
+      BufferItemUidType foundUid = 0;
+      ItemStatus status = state->Buffer->GetItemUidFromTime(timestamp + 0.1 * ITEM_PERIOD_SEC, foundUid);
+      ++numberOfReads;
+      if (status == ITEM_OK && foundUid != uid)
+      {
+        ++numberOfInconsistentReads;
+      }
+    }
+    state->NumberOfReads += numberOfReads;
+    state->NumberOfInconsistentReads += numberOfInconsistentReads;
+    return NULL;
+  }
+
+  //----------------------------------------------------------------------------
+  PlusStatus RunContentionBenchmark(bool lockFreeReads, bool compactTransformStorage, int bufferSize, int numberOfReaders, double durationSec, double& itemsPerSec)
+  {
+    vtkSmartPointer<vtkPlusBuffer> buffer = vtkSmartPointer<vtkPlusBuffer>::New();
+    buffer->SetCompactTransformStorage(compactTransformStorage);
+    buffer->SetBufferSize(bufferSize);
+    buffer->SetLockFreeReads(lockFreeReads);
+
+    BenchmarkState state;
+    state.Buffer = buffer;
+    state.DurationSec = durationSec;
+    state.WriterDone = false;
+    state.NumberOfItemsAdded = 0;
+    state.MaxAddItemTimeSec = 0;
+    state.SumAddItemTimeSec = 0;
+    state.NumberOfReads = 0;
+    state.NumberOfInconsistentReads = 0;
+
+    vtkSmartPointer<vtkMultiThreader> threader = vtkSmartPointer<vtkMultiThreader>::New();
+    std::vector<int> threadIds;
+    for (int i = 0; i < numberOfReaders; ++i)
+    {
+      threadIds.push_back(threader->SpawnThread((vtkThreadFunctionType)&ReaderThread, &state));
+    }
+    threadIds.push_back(threader->SpawnThread((vtkThreadFunctionType)&WriterThread, &state));
+    for (std::vector<int>::iterator it = threadIds.begin(); it != threadIds.end(); ++it)
+    {
+      threader->TerminateThread(*it);
+    }
+
+    itemsPerSec = state.NumberOfItemsAdded / durationSec;
+    double meanAddItemTimeUs = state.NumberOfItemsAdded > 0 ? state.SumAddItemTimeSec / state.NumberOfItemsAdded * 1e6 : 0;
+    LOG_INFO((lockFreeReads ? "Lock-free reads" : "Locked reads") << ": "
+             << std::fixed << itemsPerSec << " items/sec added"
+             << ", mean AddItem time: " << meanAddItemTimeUs << "us"
+             << ", max AddItem time: " << state.MaxAddItemTimeSec * 1e6 << "us"
+             << ", reads: " << state.NumberOfReads);
+
+    if (state.NumberOfInconsistentReads > 0)
+    {
+      LOG_ERROR((lockFreeReads ? "Lock-free reads" : "Locked reads") << ": " << state.NumberOfInconsistentReads
+                << " of " << state.NumberOfReads << " item lookups by time returned a wrong item");
+      return PLUS_FAIL;
+    }
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  PlusStatus RunLookupBenchmark(bool lockFreeReads, bool compactTransformStorage, int bufferSize, int numberOfLookups)
+  {
+    if (bufferSize < 2)
+    {
+      LOG_ERROR("The lookup benchmark requires a buffer with at least 2 items");
+      return PLUS_FAIL;
+    }
+
+    vtkSmartPointer<vtkPlusBuffer> buffer = vtkSmartPointer<vtkPlusBuffer>::New();
+    buffer->SetCompactTransformStorage(compactTransformStorage);
+    buffer->SetBufferSize(bufferSize);
+    buffer->SetLockFreeReads(lockFreeReads);
+
+    // Fill the buffer with items that have jitter in their timestamps and some dropped frames
+    vtkSmartPointer<vtkMatrix4x4> matrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    std::vector<double> timestamps;
+    std::vector<BufferItemUidType> uids;
+    for (unsigned long frameNumber = 1; static_cast<int>(timestamps.size()) < bufferSize; ++frameNumber)
+    {
+      if (frameNumber % DROPPED_FRAME_PERIOD == 0)
+      {
+        continue;
+      }
+      double timestamp = frameNumber * ITEM_PERIOD_SEC + 0.1 * ITEM_PERIOD_SEC * sin(static_cast<double>(frameNumber));
+      matrix->SetElement(0, 3, frameNumber);
+      if (buffer->AddTimeStampedItem(matrix, TOOL_OK, frameNumber, timestamp, timestamp) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Failed to add item " << frameNumber << " to the buffer");
+        return PLUS_FAIL;
+      }
+      timestamps.push_back(timestamp);
+      uids.push_back(buffer->GetLatestItemUidInBuffer());
+    }
+
+    // Query times between neighbor items, the closest one is expected to be found
+    const double fractions[] = { 0.0, 0.2, 0.4, 0.6, 0.8 };
+    const int numberOfFractions = sizeof(fractions) / sizeof(fractions[0]);
+    int numberOfWrongResults = 0;
+    double startTime = vtkIGSIOAccurateTimer::GetSystemTime();
+    for (int i = 0; i < numberOfLookups; ++i)
+    {
+      // Visit items in a scattered order, to avoid measuring cache effects only
+      int itemIndex = static_cast<int>((static_cast<unsigned long long>(i) * 7919) % (timestamps.size() - 1));
+      double fraction = fractions[i % numberOfFractions];
+      double time = timestamps[itemIndex] + fraction * (timestamps[itemIndex + 1] - timestamps[itemIndex]);
+      BufferItemUidType expectedUid = (fraction < 0.5) ? uids[itemIndex] : uids[itemIndex + 1];
+
+      BufferItemUidType foundUid = 0;
+      if (buffer->GetItemUidFromTime(time, foundUid) != ITEM_OK || foundUid != expectedUid)
+      {
+        numberOfWrongResults++;
+      }
+    }
+    double lookupTimeSec = vtkIGSIOAccurateTimer::GetSystemTime() - startTime;
+
+    // The stored transforms must be retrieved unchanged
+    StreamBufferItem item;
+    vtkSmartPointer<vtkMatrix4x4> retrievedMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    for (size_t itemIndex = 0; itemIndex < uids.size(); itemIndex += uids.size() / 10 + 1)
+    {
+      if (buffer->GetStreamBufferItem(uids[itemIndex], &item) != ITEM_OK
+          || item.GetFilteredTimestamp(0) != timestamps[itemIndex]
+          || item.GetStatus() != TOOL_OK
+          || item.GetMatrix(retrievedMatrix) != PLUS_SUCCESS
+          || retrievedMatrix->GetElement(0, 3) != static_cast<double>(item.GetIndex()))
+      {
+        LOG_ERROR("Item " << uids[itemIndex] << " was not retrieved correctly from the buffer");
+        numberOfWrongResults++;
+      }
+    }
+
+    LOG_INFO((lockFreeReads ? "Lock-free reads" : "Locked reads") << ": "
+             << std::fixed << "mean lookup time in a buffer of " << bufferSize << " items: "
+             << (numberOfLookups > 0 ? lookupTimeSec / numberOfLookups * 1e9 : 0) << "ns");
+
+    if (numberOfWrongResults > 0)
+    {
+      LOG_ERROR((lockFreeReads ? "Lock-free reads" : "Locked reads") << ": " << numberOfWrongResults
+                << " of " << numberOfLookups << " item lookups by time returned a wrong item");
+      return PLUS_FAIL;
+    }
+    return PLUS_SUCCESS;
+  }
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  int numberOfReaders(4);
+  int bufferSize(150);
+  double durationSec(2.0);
+  double minSpeedup(0.0);
+  int lookupBufferSize(10000);
+  int numberOfLookups(1000000);
+  bool compactTransformStorage(false);
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--number-of-readers", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &numberOfReaders, "Number of threads reading the buffer (Default: 4).");
+  args.AddArgument("--buffer-size", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &bufferSize, "Number of items in the buffer (Default: 150).");
+  args.AddArgument("--duration-sec", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &durationSec, "Duration of each benchmark run in seconds (Default: 2).");
+  args.AddArgument("--min-speedup", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &minSpeedup, "Minimum required ratio of writer throughput with lock-free reads and with locked reads. 0 means that the speedup is only reported (Default: 0).");
+  args.AddArgument("--lookup-buffer-size", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &lookupBufferSize, "Number of items in the buffer for the lookup benchmark (Default: 10000).");
+  args.AddArgument("--number-of-lookups", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &numberOfLookups, "Number of item lookups by time in the lookup benchmark. 0 means that the lookup benchmark is skipped (Default: 1000000).");
+  args.AddArgument("--compact-transform-storage", vtksys::CommandLineArguments::NO_ARGUMENT, &compactTransformStorage, "Store the transforms in compact, transform-only storage.");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  int numberOfErrors(0);
+
+  double lockedItemsPerSec(0);
+  if (RunContentionBenchmark(false, compactTransformStorage, bufferSize, numberOfReaders, durationSec, lockedItemsPerSec) != PLUS_SUCCESS)
+  {
+    numberOfErrors++;
+  }
+
+  double lockFreeItemsPerSec(0);
+  if (RunContentionBenchmark(true, compactTransformStorage, bufferSize, numberOfReaders, durationSec, lockFreeItemsPerSec) != PLUS_SUCCESS)
+  {
+    numberOfErrors++;
+  }
+
+  double speedup = lockedItemsPerSec > 0 ? lockFreeItemsPerSec / lockedItemsPerSec : 0;
+  LOG_INFO("Writer speedup with lock-free reads: " << std::fixed << speedup);
+  if (minSpeedup > 0 && speedup < minSpeedup)
+  {
+    LOG_ERROR("Writer speedup with lock-free reads is smaller than the threshold (speedup: " << speedup << ", threshold: " << minSpeedup << ")");
+    numberOfErrors++;
+  }
+
+  if (numberOfLookups > 0)
+  {
+    if (RunLookupBenchmark(false, compactTransformStorage, lookupBufferSize, numberOfLookups) != PLUS_SUCCESS)
+    {
+      numberOfErrors++;
+    }
+    if (RunLookupBenchmark(true, compactTransformStorage, lookupBufferSize, numberOfLookups) != PLUS_SUCCESS)
+    {
+      numberOfErrors++;
+    }
+  }
+
+  if (numberOfErrors != 0)
+  {
+    LOG_INFO("Test failed!");
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("Test completed successfully!");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,140 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file PlusBufferTestHelpers.h
+  \brief Video buffer fixture shared by the buffer tests.
+
+  Each frame is filled with a pattern that depends on the frame number, so frames that share memory, frames that are
+  read while they are partially overwritten, or frames that are read back with wrong content are detected.
+  Frames are 8-bit single component B-mode images, frame number N is added with the timestamp N * FRAME_PERIOD_SEC.
+*/
+
+#ifndef __PlusBufferTestHelpers_h
+#define __PlusBufferTestHelpers_h
+
+// Local includes
+#include "PlusConfigure.h"
+#include "vtkPlusBuffer.h"
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkSmartPointer.h>
+
+// STL includes
+#include <array>
+#include <string>
+#include <vector>
+
+namespace PlusBufferTestHelpers
+{
+  const double FRAME_PERIOD_SEC = 0.01;
+
+  //----------------------------------------------------------------------------
+  inline unsigned char GetExpectedPixelValue(unsigned long frameNumber, unsigned int pixelIndex)
+  {
+    return static_cast<unsigned char>((frameNumber * 7 + pixelIndex) % 251);
+  }
+
+  //----------------------------------------------------------------------------
+  inline double GetFrameTimestamp(unsigned long frameNumber)
+  {
+    return frameNumber * FRAME_PERIOD_SEC;
+  }
+
+  //----------------------------------------------------------------------------
+  /*! Fill the pixels of a frame with the pattern of the frame number, the size of the pixel array is kept */
+  inline void FillFrame(unsigned long frameNumber, std::vector<unsigned char>& pixels)
+  {
+    for (unsigned int i = 0; i < pixels.size(); ++i)
+    {
+      pixels[i] = GetExpectedPixelValue(frameNumber, i);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  /*!
+    Add a frame of the size of the buffer
+    \param pixels Scratch array for the pixels, reused to avoid allocation for each frame
+    \param imageOrientation Orientation the frame is added in, the pattern is the same in any orientation
+  */
+  inline PlusStatus AddFrame(vtkPlusBuffer* buffer, unsigned long frameNumber, std::vector<unsigned char>& pixels,
+                             US_IMAGE_ORIENTATION imageOrientation = US_IMG_ORIENT_MF)
+  {
+    FrameSizeType frameSize = buffer->GetFrameSize();
+    pixels.resize(frameSize[0] * frameSize[1]);
+    FillFrame(frameNumber, pixels);
+    std::array<int, 3> noClip = {igsioCommon::NO_CLIP, igsioCommon::NO_CLIP, igsioCommon::NO_CLIP};
+    double timestamp = GetFrameTimestamp(frameNumber);
+    return buffer->AddItem(&pixels[0], imageOrientation, frameSize, VTK_UNSIGNED_CHAR, 1, US_IMG_BRIGHTNESS, 0, frameNumber, noClip, noClip, timestamp, timestamp);
+  }
+
+  //----------------------------------------------------------------------------
+  /*! Add the frames from firstFrameNumber to lastFrameNumber */
+  inline PlusStatus AddFrames(vtkPlusBuffer* buffer, unsigned long firstFrameNumber, unsigned long lastFrameNumber)
+  {
+    std::vector<unsigned char> pixels;
+    for (unsigned long frameNumber = firstFrameNumber; frameNumber <= lastFrameNumber; ++frameNumber)
+    {
+      if (AddFrame(buffer, frameNumber, pixels) != PLUS_SUCCESS)
+      {
+        return PLUS_FAIL;
+      }
+    }
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  /*! Get the pixels of the frame of an item, NULL if the item has no frame */
+  inline const unsigned char* GetPixels(const StreamBufferItem& item)
+  {
+    vtkImageData* image = item.GetFrame().GetImage();
+    if (image == NULL)
+    {
+      return NULL;
+    }
+    return static_cast<const unsigned char*>(image->GetScalarPointer());
+  }
+
+  //----------------------------------------------------------------------------
+  /*! Returns true if the pixels of the item match the frame number of the item (the frame must be in the orientation it was added in) */
+  inline bool CheckItemContent(const StreamBufferItem& item)
+  {
+    const unsigned char* pixels = GetPixels(item);
+    if (pixels == NULL)
+    {
+      return false;
+    }
+    int dimensions[3] = {0, 0, 0};
+    item.GetFrame().GetImage()->GetDimensions(dimensions);
+    const unsigned int numberOfPixels = static_cast<unsigned int>(dimensions[0] * dimensions[1] * dimensions[2]);
+    for (unsigned int i = 0; i < numberOfPixels; ++i)
+    {
+      if (pixels[i] != GetExpectedPixelValue(item.GetIndex(), i))
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  /*! Create an MF oriented video buffer for frames of the specified size */
+  inline vtkSmartPointer<vtkPlusBuffer> CreateVideoBuffer(const std::string& descriptiveName, unsigned int frameWidthPx, unsigned int frameHeightPx, int bufferSize)
+  {
+    vtkSmartPointer<vtkPlusBuffer> buffer = vtkSmartPointer<vtkPlusBuffer>::New();
+    buffer->SetDescriptiveName(descriptiveName.c_str());
+    buffer->SetImageOrientation(US_IMG_ORIENT_MF);
+    buffer->SetImageType(US_IMG_BRIGHTNESS);
+    buffer->SetPixelType(VTK_UNSIGNED_CHAR);
+    buffer->SetNumberOfScalarComponents(1);
+    buffer->SetFrameSize(frameWidthPx, frameHeightPx, 1);
+    buffer->SetBufferSize(bufferSize);
+    return buffer;
+  }
+}
+
+#endif
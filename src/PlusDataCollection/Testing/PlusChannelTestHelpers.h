@@ -0,0 +1,134 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file PlusChannelTestHelpers.h
+  \brief Video source and tool fixture shared by the channel and tracked frame joiner tests.
+
+  The frames of the video source are filled with the pattern of PlusBufferTestHelpers. The translation of the
+  ProbeToTracker tool changes linearly with time, so interpolated transforms are easy to verify.
+*/
+
+#ifndef __PlusChannelTestHelpers_h
+#define __PlusChannelTestHelpers_h
+
+// Local includes
+#include "PlusBufferTestHelpers.h"
+#include "PlusConfigure.h"
+#include "vtkPlusDataSource.h"
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkMatrix4x4.h>
+#include <vtkSmartPointer.h>
+
+// STL includes
+#include <cmath>
+#include <vector>
+
+namespace PlusChannelTestHelpers
+{
+  const unsigned int FRAME_WIDTH_PX = 16;
+  const unsigned int FRAME_HEIGHT_PX = 8;
+  const unsigned int FRAME_SIZE_BYTES = FRAME_WIDTH_PX * FRAME_HEIGHT_PX;
+  const char* const TOOL_TRANSFORM_NAME = "ProbeToTracker";
+
+  //----------------------------------------------------------------------------
+  /*! Create an empty MF oriented video source */
+  inline vtkSmartPointer<vtkPlusDataSource> CreateVideoSource(int bufferSize)
+  {
+    vtkSmartPointer<vtkPlusDataSource> videoSource = vtkSmartPointer<vtkPlusDataSource>::New();
+    videoSource->SetId("Video");
+    videoSource->SetInputImageOrientation(US_IMG_ORIENT_MF);
+    videoSource->SetOutputImageOrientation(US_IMG_ORIENT_MF);
+    videoSource->SetImageType(US_IMG_BRIGHTNESS);
+    videoSource->SetPixelType(VTK_UNSIGNED_CHAR);
+    videoSource->SetNumberOfScalarComponents(1);
+    videoSource->SetInputFrameSize(FRAME_WIDTH_PX, FRAME_HEIGHT_PX, 1);
+    videoSource->SetBufferSize(bufferSize);
+    return videoSource;
+  }
+
+  //----------------------------------------------------------------------------
+  /*!
+    Add a video frame that is filled with the pattern of the frame number
+    \param pixels Scratch array for the pixels, reused to avoid allocation for each frame
+  */
+  inline PlusStatus AddVideoFrame(vtkPlusDataSource* videoSource, unsigned long frameNumber, double timestamp, std::vector<unsigned char>& pixels)
+  {
+    pixels.resize(FRAME_SIZE_BYTES);
+    PlusBufferTestHelpers::FillFrame(frameNumber, pixels);
+    FrameSizeType frameSize = {FRAME_WIDTH_PX, FRAME_HEIGHT_PX, 1};
+    return videoSource->AddItem(&pixels[0], US_IMG_ORIENT_MF, frameSize, VTK_UNSIGNED_CHAR, 1, US_IMG_BRIGHTNESS, 0, frameNumber, timestamp, timestamp);
+  }
+
+  //----------------------------------------------------------------------------
+  /*! Returns true if the image is filled with the pattern of the frame number */
+  inline bool CheckVideoFrameContent(vtkImageData* image, unsigned long frameNumber)
+  {
+    if (image == NULL || image->GetScalarPointer() == NULL)
+    {
+      return false;
+    }
+    const unsigned char* pixels = static_cast<const unsigned char*>(image->GetScalarPointer());
+    for (unsigned int i = 0; i < FRAME_SIZE_BYTES; ++i)
+    {
+      if (pixels[i] != PlusBufferTestHelpers::GetExpectedPixelValue(frameNumber, i))
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  //----------------------------------------------------------------------------
+  /*! Create an empty ProbeToTracker tool */
+  inline vtkSmartPointer<vtkPlusDataSource> CreateTool(int bufferSize)
+  {
+    vtkSmartPointer<vtkPlusDataSource> tool = vtkSmartPointer<vtkPlusDataSource>::New();
+    tool->SetId(TOOL_TRANSFORM_NAME);
+    tool->SetBufferSize(bufferSize);
+    return tool;
+  }
+
+  //----------------------------------------------------------------------------
+  /*! Get the expected ProbeToTracker transform at the specified time, also between the added tool frames */
+  inline void GetToolTransform(double timestamp, vtkMatrix4x4* matrix)
+  {
+    matrix->Identity();
+    matrix->SetElement(0, 3, timestamp * 100.0);
+    matrix->SetElement(1, 3, -timestamp * 10.0);
+  }
+
+  //----------------------------------------------------------------------------
+  inline PlusStatus AddToolFrame(vtkPlusDataSource* tool, unsigned long frameNumber, double timestamp)
+  {
+    vtkSmartPointer<vtkMatrix4x4> matrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    GetToolTransform(timestamp, matrix);
+    return tool->AddTimeStampedItem(matrix, TOOL_OK, frameNumber, timestamp, timestamp);
+  }
+
+  //----------------------------------------------------------------------------
+  /*! Returns true if the matrix is the expected ProbeToTracker transform at the specified time */
+  inline bool CheckToolTransform(vtkMatrix4x4* matrix, double timestamp)
+  {
+    vtkSmartPointer<vtkMatrix4x4> expectedMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    GetToolTransform(timestamp, expectedMatrix);
+    for (int i = 0; i < 4; ++i)
+    {
+      for (int j = 0; j < 4; ++j)
+      {
+        if (fabs(matrix->GetElement(i, j) - expectedMatrix->GetElement(i, j)) > 1e-6)
+        {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+}
+
+#endif
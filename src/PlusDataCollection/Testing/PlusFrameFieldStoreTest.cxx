@@ -0,0 +1,248 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file PlusFrameFieldStoreTest.cxx
+  \brief Tests setting, sharing, and copy-on-write of frame fields, and interning of field names from multiple threads.
+*/
+
+// Local includes
+#include "PlusConfigure.h"
+#include "PlusFrameFieldStore.h"
+
+// VTK includes
+#include <vtksys/CommandLineArguments.hxx>
+
+// STL includes
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace
+{
+  const int NUMBER_OF_INTERNING_THREADS = 4;
+  const int NUMBER_OF_INTERNED_NAMES = 200;
+
+  //----------------------------------------------------------------------------
+  std::string GetFieldValue(const PlusFrameFieldStore& store, const std::string& fieldName)
+  {
+    const PlusFrameFieldStore::Field* field = store.GetField(fieldName);
+    if (field == NULL || !field->Value)
+    {
+      return "";
+    }
+    return *(field->Value);
+  }
+
+  //----------------------------------------------------------------------------
+  int TestSetAndGetFields()
+  {
+    int numberOfErrors(0);
+    PlusFrameFieldStore store;
+    store.SetField("FieldStoreTestB", "valueB", igsioFrameFieldFlags::FRAMEFIELD_NONE);
+    store.SetField("FieldStoreTestA", "valueA", igsioFrameFieldFlags::FRAMEFIELD_FORCE_SERVER_SEND);
+    store.SetField("FieldStoreTestB", "valueB2", igsioFrameFieldFlags::FRAMEFIELD_NONE);
+    if (store.GetNumberOfFields() != 2 || GetFieldValue(store, "FieldStoreTestA") != "valueA" || GetFieldValue(store, "FieldStoreTestB") != "valueB2")
+    {
+      LOG_ERROR("Field values are not stored correctly");
+      numberOfErrors++;
+    }
+    if (store.GetField("FieldStoreTestA")->Flags != igsioFrameFieldFlags::FRAMEFIELD_FORCE_SERVER_SEND)
+    {
+      LOG_ERROR("Field flags are not stored correctly");
+      numberOfErrors++;
+    }
+    if (store.GetField("FieldStoreTestNotSet") != NULL)
+    {
+      LOG_ERROR("A field that was not set was found");
+      numberOfErrors++;
+    }
+
+    // Fields are sorted by key ID, and the key ID can be used for lookup
+    const std::vector<PlusFrameFieldStore::Field>& fields = store.GetFields();
+    for (size_t i = 1; i < fields.size(); ++i)
+    {
+      if (fields[i - 1].KeyId >= fields[i].KeyId)
+      {
+        LOG_ERROR("Fields are not sorted by key ID");
+        numberOfErrors++;
+      }
+    }
+    PlusFrameFieldStore::KeyIdType keyId(-1);
+    if (!PlusFrameFieldStore::FindKeyId("FieldStoreTestA", keyId) || store.GetField(keyId) != store.GetField("FieldStoreTestA"))
+    {
+      LOG_ERROR("Field cannot be found by key ID");
+      numberOfErrors++;
+    }
+
+    if (!store.DeleteField("FieldStoreTestA") || store.DeleteField("FieldStoreTestA") || store.GetNumberOfFields() != 1)
+    {
+      LOG_ERROR("Field deletion failed");
+      numberOfErrors++;
+    }
+
+    igsioFieldMapType fieldMap;
+    fieldMap["FieldStoreTestC"] = std::make_pair(igsioFrameFieldFlags::FRAMEFIELD_NONE, std::string("valueC"));
+    fieldMap["FieldStoreTestD"] = std::make_pair(igsioFrameFieldFlags::FRAMEFIELD_NONE, std::string("valueD"));
+    store.ReplaceFields(fieldMap);
+    igsioFieldMapType outputFieldMap;
+    store.AddToFieldMap(outputFieldMap);
+    if (outputFieldMap != fieldMap)
+    {
+      LOG_ERROR("Replaced fields do not match the field map");
+      numberOfErrors++;
+    }
+    return numberOfErrors;
+  }
+
+  //----------------------------------------------------------------------------
+  int TestValueSharing()
+  {
+    int numberOfErrors(0);
+
+    // A value that is the same as in the previous frame is shared with the previous frame
+    PlusFrameFieldStore previousFrame;
+    previousFrame.SetField("FieldStoreTestShared", "sameValue", igsioFrameFieldFlags::FRAMEFIELD_NONE);
+    PlusFrameFieldStore frame;
+    frame.SetField("FieldStoreTestShared", "sameValue", igsioFrameFieldFlags::FRAMEFIELD_NONE, &previousFrame);
+    if (frame.GetField("FieldStoreTestShared")->Value != previousFrame.GetField("FieldStoreTestShared")->Value)
+    {
+      LOG_ERROR("Unchanged value is not shared with the previous frame");
+      numberOfErrors++;
+    }
+
+    // Copy-on-write: modifying a shared value must not change the other store
+    frame.SetField("FieldStoreTestShared", "newValue", igsioFrameFieldFlags::FRAMEFIELD_NONE);
+    if (GetFieldValue(previousFrame, "FieldStoreTestShared") != "sameValue" || GetFieldValue(frame, "FieldStoreTestShared") != "newValue")
+    {
+      LOG_ERROR("Modifying a shared value changed the other store");
+      numberOfErrors++;
+    }
+
+    // A value that is not shared is reused in place
+    const std::string* unsharedValue = frame.GetField("FieldStoreTestShared")->Value.get();
+    frame.SetField("FieldStoreTestShared", "otherValue", igsioFrameFieldFlags::FRAMEFIELD_NONE);
+    if (frame.GetField("FieldStoreTestShared")->Value.get() != unsharedValue || GetFieldValue(frame, "FieldStoreTestShared") != "otherValue")
+    {
+      LOG_ERROR("Value that is not referenced by other stores is not reused");
+      numberOfErrors++;
+    }
+
+    // Copying a store shares the values, and the copy is not affected by modifying the original
+    PlusFrameFieldStore copy(frame);
+    if (copy.GetField("FieldStoreTestShared")->Value != frame.GetField("FieldStoreTestShared")->Value)
+    {
+      LOG_ERROR("Copied store does not share the values");
+      numberOfErrors++;
+    }
+    frame.SetField("FieldStoreTestShared", "modifiedAfterCopy", igsioFrameFieldFlags::FRAMEFIELD_NONE);
+    if (GetFieldValue(copy, "FieldStoreTestShared") != "otherValue")
+    {
+      LOG_ERROR("Modifying the original store changed the copy");
+      numberOfErrors++;
+    }
+
+    // Setting fields from another store shares the values
+    PlusFrameFieldStore target;
+    target.SetField("FieldStoreTestOther", "otherFieldValue", igsioFrameFieldFlags::FRAMEFIELD_NONE);
+    target.SetFields(frame);
+    if (target.GetNumberOfFields() != 2 || target.GetField("FieldStoreTestShared")->Value != frame.GetField("FieldStoreTestShared")->Value)
+    {
+      LOG_ERROR("Fields set from another store are not shared");
+      numberOfErrors++;
+    }
+    return numberOfErrors;
+  }
+
+  //----------------------------------------------------------------------------
+  std::string GetInternedNameForIndex(int index)
+  {
+    std::ostringstream name;
+    name << "FieldStoreTestInterned" << index;
+    return name.str();
+  }
+
+  //----------------------------------------------------------------------------
+  int TestConcurrentInterning()
+  {
+    // All threads intern the same names in different order, all of them must get the same key IDs
+    std::vector<std::vector<PlusFrameFieldStore::KeyIdType> > keyIds(NUMBER_OF_INTERNING_THREADS, std::vector<PlusFrameFieldStore::KeyIdType>(NUMBER_OF_INTERNED_NAMES));
+    std::vector<std::thread> threads;
+    for (int threadIndex = 0; threadIndex < NUMBER_OF_INTERNING_THREADS; ++threadIndex)
+    {
+      threads.push_back(std::thread([threadIndex, &keyIds]()
+      {
+        PlusFrameFieldStore store;
+        for (int i = 0; i < NUMBER_OF_INTERNED_NAMES; ++i)
+        {
+          int nameIndex = (threadIndex % 2 == 0) ? i : NUMBER_OF_INTERNED_NAMES - 1 - i;
+          std::string name = GetInternedNameForIndex(nameIndex);
+          store.SetField(name, name, igsioFrameFieldFlags::FRAMEFIELD_NONE);
+          keyIds[threadIndex][nameIndex] = store.GetField(name)->KeyId;
+        }
+      }));
+    }
+    for (std::vector<std::thread>::iterator threadIt = threads.begin(); threadIt != threads.end(); ++threadIt)
+    {
+      threadIt->join();
+    }
+
+    int numberOfErrors(0);
+    for (int nameIndex = 0; nameIndex < NUMBER_OF_INTERNED_NAMES; ++nameIndex)
+    {
+      PlusFrameFieldStore::KeyIdType expectedKeyId = PlusFrameFieldStore::GetKeyId(GetInternedNameForIndex(nameIndex));
+      for (int threadIndex = 0; threadIndex < NUMBER_OF_INTERNING_THREADS; ++threadIndex)
+      {
+        if (keyIds[threadIndex][nameIndex] != expectedKeyId)
+        {
+          LOG_ERROR("Field name " << GetInternedNameForIndex(nameIndex) << " got different key IDs in different threads");
+          numberOfErrors++;
+        }
+      }
+    }
+    return numberOfErrors;
+  }
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  int numberOfErrors(0);
+  numberOfErrors += TestSetAndGetFields();
+  numberOfErrors += TestValueSharing();
+  numberOfErrors += TestConcurrentInterning();
+
+  if (numberOfErrors != 0)
+  {
+    LOG_INFO("Test failed!");
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("Test completed successfully!");
+  return EXIT_SUCCESS;
+}
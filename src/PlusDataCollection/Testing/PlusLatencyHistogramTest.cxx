@@ -0,0 +1,239 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file PlusLatencyHistogramTest.cxx
+  \brief Tests the bucket mapping and the statistics of PlusLatencyHistogram.
+
+  The percentiles are compared to the exact values of known latency distributions, they must not be smaller
+  than the exact value and must not exceed it by more than the width of a bucket.
+*/
+
+// Local includes
+#include "PlusConfigure.h"
+#include "PlusLatencyHistogram.h"
+
+// VTK includes
+#include <vtksys/CommandLineArguments.hxx>
+
+// STL includes
+#include <cmath>
+#include <thread>
+#include <vector>
+
+namespace
+{
+  // Largest relative width of a bucket above the linear range
+  const double MAX_RELATIVE_BUCKET_WIDTH = 1.0 / (1 << PlusLatencyHistogram::SUB_BUCKET_BITS);
+
+  //----------------------------------------------------------------------------
+  int TestBucketMapping()
+  {
+    int numberOfErrors(0);
+    const int subBucketCount = 1 << PlusLatencyHistogram::SUB_BUCKET_BITS;
+
+    // Latencies below the sub-bucket count have their own bucket
+    for (int latency = 0; latency < subBucketCount; ++latency)
+    {
+      if (PlusLatencyHistogram::GetBucketIndex(latency) != latency)
+      {
+        LOG_ERROR("Latency " << latency << "us is counted in bucket " << PlusLatencyHistogram::GetBucketIndex(latency) << " instead of its own bucket");
+        numberOfErrors++;
+      }
+    }
+
+    // The buckets are contiguous, and the bounds of each bucket are mapped to the bucket
+    for (int bucketIndex = 0; bucketIndex < PlusLatencyHistogram::NUMBER_OF_BUCKETS; ++bucketIndex)
+    {
+      uint64_t lowerBound = PlusLatencyHistogram::GetBucketLowerBound(bucketIndex);
+      uint64_t upperBound = PlusLatencyHistogram::GetBucketUpperBound(bucketIndex);
+      if (upperBound < lowerBound)
+      {
+        LOG_ERROR("Bucket " << bucketIndex << " has invalid bounds: " << lowerBound << "-" << upperBound << "us");
+        numberOfErrors++;
+        continue;
+      }
+      if (PlusLatencyHistogram::GetBucketIndex(lowerBound) != bucketIndex || PlusLatencyHistogram::GetBucketIndex(upperBound) != bucketIndex)
+      {
+        LOG_ERROR("Bounds of bucket " << bucketIndex << " (" << lowerBound << "-" << upperBound << "us) are mapped to buckets "
+                  << PlusLatencyHistogram::GetBucketIndex(lowerBound) << "-" << PlusLatencyHistogram::GetBucketIndex(upperBound));
+        numberOfErrors++;
+      }
+      if (bucketIndex > 0 && PlusLatencyHistogram::GetBucketUpperBound(bucketIndex - 1) + 1 != lowerBound)
+      {
+        LOG_ERROR("Bucket " << bucketIndex << " does not start where bucket " << bucketIndex - 1 << " ends");
+        numberOfErrors++;
+      }
+      if (bucketIndex >= subBucketCount && static_cast<double>(upperBound - lowerBound + 1) / lowerBound > MAX_RELATIVE_BUCKET_WIDTH)
+      {
+        LOG_ERROR("Bucket " << bucketIndex << " (" << lowerBound << "-" << upperBound << "us) is wider than " << MAX_RELATIVE_BUCKET_WIDTH * 100 << "%");
+        numberOfErrors++;
+      }
+    }
+
+    // Latencies that are too large for the histogram are counted in the last bucket
+    uint64_t largestLatency = PlusLatencyHistogram::GetBucketUpperBound(PlusLatencyHistogram::NUMBER_OF_BUCKETS - 1);
+    if (PlusLatencyHistogram::GetBucketIndex(largestLatency + 1) != PlusLatencyHistogram::NUMBER_OF_BUCKETS - 1
+        || PlusLatencyHistogram::GetBucketIndex(~uint64_t(0)) != PlusLatencyHistogram::NUMBER_OF_BUCKETS - 1)
+    {
+      LOG_ERROR("Latencies above " << largestLatency << "us are not counted in the last bucket");
+      numberOfErrors++;
+    }
+
+    return numberOfErrors;
+  }
+
+  //----------------------------------------------------------------------------
+  int CheckPercentile(const PlusLatencyHistogram::Snapshot& snapshot, double percentile, double expectedSec)
+  {
+    double actualSec = snapshot.GetPercentileSec(percentile);
+    // 1us tolerance for rounding the latencies to microseconds
+    if (actualSec < expectedSec - 1e-6 || actualSec > expectedSec * (1.0 + MAX_RELATIVE_BUCKET_WIDTH) + 1e-6)
+    {
+      LOG_ERROR("Percentile " << percentile << " is " << actualSec << "s, expected " << expectedSec << "s");
+      return 1;
+    }
+    return 0;
+  }
+
+  //----------------------------------------------------------------------------
+  int TestStatistics()
+  {
+    int numberOfErrors(0);
+
+    PlusLatencyHistogram histogram;
+    PlusLatencyHistogram::Snapshot emptySnapshot;
+    histogram.GetSnapshot(emptySnapshot);
+    if (emptySnapshot.GetCount() != 0 || emptySnapshot.GetMeanSec() != 0.0 || emptySnapshot.GetPercentileSec(50) != 0.0 || emptySnapshot.GetMaxSec() != 0.0)
+    {
+      LOG_ERROR("Statistics of an empty histogram are not 0: " << emptySnapshot.GetSummary());
+      numberOfErrors++;
+    }
+
+    // Latencies of 1, 2, ..., 1000ms
+    const int numberOfLatencies = 1000;
+    for (int i = 1; i <= numberOfLatencies; ++i)
+    {
+      histogram.RecordLatency(i * 0.001);
+    }
+    PlusLatencyHistogram::Snapshot snapshot;
+    histogram.GetSnapshot(snapshot);
+    if (snapshot.GetCount() != static_cast<uint64_t>(numberOfLatencies))
+    {
+      LOG_ERROR("Histogram count is " << snapshot.GetCount() << ", expected " << numberOfLatencies);
+      numberOfErrors++;
+    }
+    if (std::fabs(snapshot.GetMeanSec() - 0.5005) > 1e-9)
+    {
+      LOG_ERROR("Mean latency is " << snapshot.GetMeanSec() << "s, expected 0.5005s");
+      numberOfErrors++;
+    }
+    numberOfErrors += CheckPercentile(snapshot, 0, 0.001);
+    numberOfErrors += CheckPercentile(snapshot, 50, 0.500);
+    numberOfErrors += CheckPercentile(snapshot, 90, 0.900);
+    numberOfErrors += CheckPercentile(snapshot, 99, 0.990);
+    numberOfErrors += CheckPercentile(snapshot, 100, 1.000);
+    if (snapshot.GetMaxSec() != snapshot.GetPercentileSec(100))
+    {
+      LOG_ERROR("Maximum latency " << snapshot.GetMaxSec() << "s does not match the 100th percentile " << snapshot.GetPercentileSec(100) << "s");
+      numberOfErrors++;
+    }
+
+    // Negative latencies are counted as 0, only the new latencies remain after subtracting the earlier snapshot
+    histogram.RecordLatency(-0.5);
+    histogram.RecordLatency(2.0);
+    PlusLatencyHistogram::Snapshot periodSnapshot;
+    histogram.GetSnapshot(periodSnapshot);
+    periodSnapshot.Subtract(snapshot);
+    if (periodSnapshot.GetCount() != 2 || std::fabs(periodSnapshot.GetMeanSec() - 1.0) > 1e-9)
+    {
+      LOG_ERROR("Unexpected statistics of the latencies since the earlier snapshot: " << periodSnapshot.GetSummary());
+      numberOfErrors++;
+    }
+    numberOfErrors += CheckPercentile(periodSnapshot, 50, 0.0);
+    numberOfErrors += CheckPercentile(periodSnapshot, 100, 2.0);
+
+    return numberOfErrors;
+  }
+
+  //----------------------------------------------------------------------------
+  int TestConcurrentRecording()
+  {
+    const int numberOfThreads = 4;
+    const int latenciesPerThread = 100000;
+
+    PlusLatencyHistogram histogram;
+    std::vector<std::thread> threads;
+    for (int threadIndex = 0; threadIndex < numberOfThreads; ++threadIndex)
+    {
+      threads.push_back(std::thread([&histogram, threadIndex]()
+      {
+        for (int i = 0; i < latenciesPerThread; ++i)
+        {
+          histogram.RecordLatency((threadIndex + 1) * 0.001);
+        }
+      }));
+    }
+    for (std::vector<std::thread>::iterator it = threads.begin(); it != threads.end(); ++it)
+    {
+      it->join();
+    }
+
+    PlusLatencyHistogram::Snapshot snapshot;
+    histogram.GetSnapshot(snapshot);
+    if (snapshot.GetCount() != static_cast<uint64_t>(numberOfThreads * latenciesPerThread))
+    {
+      LOG_ERROR("Histogram count is " << snapshot.GetCount() << " after recording from " << numberOfThreads << " threads, expected " << numberOfThreads * latenciesPerThread);
+      return 1;
+    }
+    if (std::fabs(snapshot.GetMeanSec() - 0.0025) > 1e-9)
+    {
+      LOG_ERROR("Mean latency is " << snapshot.GetMeanSec() << "s after recording from " << numberOfThreads << " threads, expected 0.0025s");
+      return 1;
+    }
+    return 0;
+  }
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  int numberOfErrors(0);
+  numberOfErrors += TestBucketMapping();
+  numberOfErrors += TestStatistics();
+  numberOfErrors += TestConcurrentRecording();
+
+  if (numberOfErrors != 0)
+  {
+    LOG_INFO("Test failed!");
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("Test completed successfully!");
+  return EXIT_SUCCESS;
+}
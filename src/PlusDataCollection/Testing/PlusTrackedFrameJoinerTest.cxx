@@ -0,0 +1,225 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file PlusTrackedFrameJoinerTest.cxx
+  \brief Tests that PlusTrackedFrameJoiner only joins frames when all the sources of the channel have data for them.
+
+  A producer thread adds video frames to the master source of the channel, then another producer thread adds the tool
+  data for the same period. No frame is joined until the tool data arrives. A consumer takes the joined frames while
+  the tool data is produced and checks that all the frames are returned once, in time order, with interpolated tool transforms,
+  and that the frames ready callback is only called when frames are joined.
+*/
+
+// Local includes
+#include "PlusChannelTestHelpers.h"
+#include "PlusConfigure.h"
+#include "PlusTrackedFrameJoiner.h"
+#include "vtkPlusChannel.h"
+#include "vtkPlusDataSource.h"
+
+// IGSIO includes
+#include <igsioTrackedFrame.h>
+#include <vtkIGSIOTrackedFrameList.h>
+
+// VTK includes
+#include <vtkMatrix4x4.h>
+#include <vtksys/CommandLineArguments.hxx>
+
+// STL includes
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace PlusChannelTestHelpers;
+
+namespace
+{
+  const double FIRST_TIMESTAMP_SEC = 1.0;
+  const double VIDEO_FRAME_PERIOD_SEC = 0.01;
+  const double TOOL_FRAME_PERIOD_SEC = 0.005;
+  const int NUMBER_OF_VIDEO_FRAMES = 60;
+
+  //----------------------------------------------------------------------------
+  double GetVideoTimestamp(int frameIndex)
+  {
+    return FIRST_TIMESTAMP_SEC + frameIndex * VIDEO_FRAME_PERIOD_SEC;
+  }
+
+  //----------------------------------------------------------------------------
+  void ProduceVideo(vtkPlusDataSource* videoSource)
+  {
+    std::vector<unsigned char> pixels;
+    for (int frameIndex = 0; frameIndex < NUMBER_OF_VIDEO_FRAMES; ++frameIndex)
+    {
+      AddVideoFrame(videoSource, frameIndex, GetVideoTimestamp(frameIndex), pixels);
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  void ProduceTool(vtkPlusDataSource* tool)
+  {
+    const int numberOfToolFrames = static_cast<int>((NUMBER_OF_VIDEO_FRAMES + 1) * VIDEO_FRAME_PERIOD_SEC / TOOL_FRAME_PERIOD_SEC) + 1;
+    for (int frameIndex = 0; frameIndex < numberOfToolFrames; ++frameIndex)
+    {
+      AddToolFrame(tool, frameIndex, FIRST_TIMESTAMP_SEC - TOOL_FRAME_PERIOD_SEC + frameIndex * TOOL_FRAME_PERIOD_SEC);
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  // Returns the number of errors in the joined frame
+  int CheckJoinedFrame(igsioTrackedFrame& frame, int expectedFrameIndex)
+  {
+    int numberOfErrors(0);
+    double expectedTimestamp = GetVideoTimestamp(expectedFrameIndex);
+    if (fabs(frame.GetTimestamp() - expectedTimestamp) > 1e-9)
+    {
+      LOG_ERROR("Joined frame timestamp is " << frame.GetTimestamp() << " (expected " << expectedTimestamp << ")");
+      return 1;
+    }
+
+    if (!CheckVideoFrameContent(frame.GetImageData()->GetImage(), expectedFrameIndex))
+    {
+      LOG_ERROR("Image mismatch in joined frame at " << expectedTimestamp);
+      numberOfErrors++;
+    }
+
+    igsioTransformName transformName(TOOL_TRANSFORM_NAME);
+    vtkSmartPointer<vtkMatrix4x4> matrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    ToolStatus status(TOOL_INVALID);
+    if (frame.GetFrameTransform(transformName, matrix) != PLUS_SUCCESS || frame.GetFrameTransformStatus(transformName, status) != PLUS_SUCCESS || status != TOOL_OK)
+    {
+      LOG_ERROR("Tool transform is missing or invalid in joined frame at " << expectedTimestamp);
+      return numberOfErrors + 1;
+    }
+    if (!CheckToolTransform(matrix, expectedTimestamp))
+    {
+      LOG_ERROR("Tool transform mismatch in joined frame at " << expectedTimestamp << ": " << matrix->GetElement(0, 3) << ", " << matrix->GetElement(1, 3));
+      numberOfErrors++;
+    }
+    return numberOfErrors;
+  }
+
+  //----------------------------------------------------------------------------
+  int TestProducerConsumer()
+  {
+    vtkSmartPointer<vtkPlusDataSource> videoSource = CreateVideoSource(2 * NUMBER_OF_VIDEO_FRAMES);
+    vtkSmartPointer<vtkPlusDataSource> tool = CreateTool(500);
+    vtkSmartPointer<vtkPlusChannel> channel = vtkSmartPointer<vtkPlusChannel>::New();
+    channel->SetChannelId("TrackedVideoStream");
+    channel->SetVideoSource(videoSource);
+    channel->AddTool(tool);
+
+    PlusTrackedFrameJoiner joiner(channel);
+    // The tool does not produce anything while the video is produced, it must not be considered stalled
+    joiner.SetSourceStallTimeoutSec(10.0);
+    std::atomic<int> numberOfFramesReadyCallbacks(0);
+    joiner.SetFramesReadyCallback([&numberOfFramesReadyCallbacks]()
+    {
+      ++numberOfFramesReadyCallbacks;
+    });
+    if (joiner.Start() != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to start the tracked frame joiner");
+      return 1;
+    }
+
+    int numberOfErrors(0);
+    std::thread videoProducer(ProduceVideo, videoSource.GetPointer());
+    videoProducer.join();
+    if (joiner.WaitForReadyFrames(0.1) || joiner.GetNumberOfReadyFrames() != 0)
+    {
+      LOG_ERROR("Frames were joined before the tool had data for them");
+      numberOfErrors++;
+    }
+    if (numberOfFramesReadyCallbacks != 0)
+    {
+      LOG_ERROR("Frames ready callback was called before the tool had data for the frames");
+      numberOfErrors++;
+    }
+
+    std::thread toolProducer(ProduceTool, tool.GetPointer());
+    vtkSmartPointer<vtkIGSIOTrackedFrameList> joinedFrames = vtkSmartPointer<vtkIGSIOTrackedFrameList>::New();
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (static_cast<int>(joinedFrames->GetNumberOfTrackedFrames()) < NUMBER_OF_VIDEO_FRAMES && std::chrono::steady_clock::now() < deadline)
+    {
+      if (joiner.WaitForReadyFrames(0.5))
+      {
+        // Take a few frames at a time, as a consumer that cannot keep up with the producers
+        joiner.PopReadyFrames(joinedFrames, 7);
+      }
+    }
+    toolProducer.join();
+    joiner.Stop();
+
+    if (numberOfFramesReadyCallbacks == 0)
+    {
+      LOG_ERROR("Frames ready callback was not called");
+      numberOfErrors++;
+    }
+
+    if (static_cast<int>(joinedFrames->GetNumberOfTrackedFrames()) != NUMBER_OF_VIDEO_FRAMES)
+    {
+      LOG_ERROR("Number of joined frames is " << joinedFrames->GetNumberOfTrackedFrames() << " (expected " << NUMBER_OF_VIDEO_FRAMES << ")");
+      numberOfErrors++;
+    }
+    if (joiner.GetNumberOfDroppedFrames() != 0)
+    {
+      LOG_ERROR(joiner.GetNumberOfDroppedFrames() << " frames were dropped by the joiner");
+      numberOfErrors++;
+    }
+    for (unsigned int i = 0; i < joinedFrames->GetNumberOfTrackedFrames(); ++i)
+    {
+      numberOfErrors += CheckJoinedFrame(*joinedFrames->GetTrackedFrame(i), i);
+    }
+    if (fabs(joiner.GetLatestJoinedTimestamp() - GetVideoTimestamp(NUMBER_OF_VIDEO_FRAMES - 1)) > 1e-9)
+    {
+      LOG_ERROR("Latest joined timestamp is " << joiner.GetLatestJoinedTimestamp() << " (expected " << GetVideoTimestamp(NUMBER_OF_VIDEO_FRAMES - 1) << ")");
+      numberOfErrors++;
+    }
+    return numberOfErrors;
+  }
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  int numberOfErrors = TestProducerConsumer();
+
+  if (numberOfErrors != 0)
+  {
+    LOG_INFO("Test failed!");
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("Test completed successfully!");
+  return EXIT_SUCCESS;
+}
@@ -97,6 +97,15 @@ int main(int argc, char** argv)
     numberOfErrors++;
   }
 
+  // Compute filtered timestamps by fitting the line to all the averaged items for each item, for comparison with the incremental computation
+  vtkSmartPointer<vtkPlusBuffer> referenceTrackerBuffer = vtkSmartPointer<vtkPlusBuffer>::New();
+  referenceTrackerBuffer->SetIncrementalTimestampFiltering(false);
+  if (referenceTrackerBuffer->CopyTransformFromTrackedFrameList(trackerFrameList, vtkPlusBuffer::READ_UNFILTERED_COMPUTE_FILTERED_TIMESTAMPS, transformName) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("CopyDefaultTrackerDataToBuffer failed for the reference buffer");
+    numberOfErrors++;
+  }
+
   // Check filtering results
   //************************
 
@@ -129,7 +138,33 @@ int main(int argc, char** argv)
 
   LOG_INFO("Maximum filtered and unfiltered timestamp difference: " << maxTimestampDifference * 1000 << "ms");
 
-  //2. The standard deviation of the frame periods in the filtered data should be better than without filtering (stdevFramePeriodsUnfiltered / stdevFramePeriodsFiltered < minStdevReductionFactor)
+  // 2. Incremental and non-incremental filtering shall give the same filtered timestamps
+  const double maxFilteringMethodDifference = 1e-6;
+  double maxFilteringMethodDifferenceFound(0);
+  for (BufferItemUidType item = trackerBuffer->GetOldestItemUidInBuffer(); item <= trackerBuffer->GetLatestItemUidInBuffer(); ++item)
+  {
+    StreamBufferItem bufferItem;
+    StreamBufferItem referenceBufferItem;
+    if (trackerBuffer->GetStreamBufferItem(item, &bufferItem) != ITEM_OK || referenceTrackerBuffer->GetStreamBufferItem(item, &referenceBufferItem) != ITEM_OK)
+    {
+      LOG_ERROR("Failed to get buffer item with UID: " << item);
+      numberOfErrors++;
+      continue;
+    }
+    double filteringMethodDifference = fabs(bufferItem.GetFilteredTimestamp(0) - referenceBufferItem.GetFilteredTimestamp(0));
+    if (filteringMethodDifference > maxFilteringMethodDifferenceFound)
+    {
+      maxFilteringMethodDifferenceFound = filteringMethodDifference;
+    }
+  }
+  LOG_INFO("Maximum incremental and non-incremental filtered timestamp difference: " << maxFilteringMethodDifferenceFound * 1000 << "ms");
+  if (maxFilteringMethodDifferenceFound > maxFilteringMethodDifference)
+  {
+    LOG_ERROR("Incremental and non-incremental timestamp filtering results differ (difference: " << std::fixed << maxFilteringMethodDifferenceFound << ", threshold: " << maxFilteringMethodDifference << ")");
+    numberOfErrors++;
+  }
+
+  //3. The standard deviation of the frame periods in the filtered data should be better than without filtering (stdevFramePeriodsUnfiltered / stdevFramePeriodsFiltered < minStdevReductionFactor)
   vnl_vector<double>unfilteredFramePeriods(trackerBuffer->GetNumberOfItems() - 1);
   vnl_vector<double>filteredFramePeriods(trackerBuffer->GetNumberOfItems() - 1);
   int i = 0;
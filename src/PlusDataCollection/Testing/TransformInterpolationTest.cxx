@@ -9,6 +9,7 @@
 #include "vtkPlusHTMLGenerator.h"
 #include "vtkMath.h"
 #include "vtkMatrix4x4.h"
+#include "vtkTransform.h"
 #include "vtkPlusBuffer.h"
 #include "vtkPlusDevice.h"
 #include "vtkIGSIOSequenceIO.h"
@@ -16,6 +17,190 @@
 #include "vtksys/CommandLineArguments.hxx"
 #include "vtksys/SystemTools.hxx"
 
+#include <algorithm>
+
+namespace
+{
+  const double MAX_MATRIX_ELEMENT_DIFFERENCE = 1e-6;
+
+  //----------------------------------------------------------------------------
+  // Interpolate between two transforms the same way as vtkPlusBuffer did before batch interpolation:
+  // SLERP for the rotation, linear interpolation for the translation
+  void ComputeReferencePose(vtkMatrix4x4* matrixA, vtkMatrix4x4* matrixB, double weightB, vtkMatrix4x4* interpolatedMatrix)
+  {
+    double rotationA[3][3] = {{0, 0, 0}, {0, 0, 0}, {0, 0, 0}};
+    double rotationB[3][3] = {{0, 0, 0}, {0, 0, 0}, {0, 0, 0}};
+    for (int i = 0; i < 3; i++)
+    {
+      for (int j = 0; j < 3; j++)
+      {
+        rotationA[i][j] = matrixA->GetElement(i, j);
+        rotationB[i][j] = matrixB->GetElement(i, j);
+      }
+    }
+    double quatA[4] = {0, 0, 0, 0};
+    vtkMath::Matrix3x3ToQuaternion(rotationA, quatA);
+    double quatB[4] = {0, 0, 0, 0};
+    vtkMath::Matrix3x3ToQuaternion(rotationB, quatB);
+    double interpolatedQuat[4] = {0, 0, 0, 0};
+    igsioMath::Slerp(interpolatedQuat, weightB, quatA, quatB);
+    double interpolatedRotation[3][3] = {{0, 0, 0}, {0, 0, 0}, {0, 0, 0}};
+    vtkMath::QuaternionToMatrix3x3(interpolatedQuat, interpolatedRotation);
+
+    interpolatedMatrix->Identity();
+    for (int i = 0; i < 3; i++)
+    {
+      for (int j = 0; j < 3; j++)
+      {
+        interpolatedMatrix->SetElement(i, j, interpolatedRotation[i][j]);
+      }
+      interpolatedMatrix->SetElement(i, 3, matrixA->GetElement(i, 3) * (1 - weightB) + matrixB->GetElement(i, 3) * weightB);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  int ComparePoseWithMatrix(const PlusInterpolatedPose& pose, vtkMatrix4x4* expectedMatrix, double time)
+  {
+    for (int i = 0; i < 16; ++i)
+    {
+      double difference = fabs(expectedMatrix->GetElement(i / 4, i % 4) - pose.Matrix[i]);
+      if (difference > MAX_MATRIX_ELEMENT_DIFFERENCE)
+      {
+        LOG_ERROR("Batch interpolated matrix differs from the reference (timestamp=" << std::fixed << time << ", element=" << i << ", difference=" << difference << ")!");
+        return 1;
+      }
+    }
+    return 0;
+  }
+
+  //----------------------------------------------------------------------------
+  // Interpolate poses between the valid items of the buffer with SLERP and compare them to the batch interpolation results
+  int CheckBatchInterpolationWithReference(vtkPlusBuffer* trackerBuffer, double startTime, double endTime, double timeStep)
+  {
+    int numberOfErrors(0);
+
+    // Collect the valid items of the buffer, in time order
+    std::vector<double> itemTimes;
+    std::vector<vtkSmartPointer<vtkMatrix4x4> > itemMatrices;
+    for (BufferItemUidType uid = trackerBuffer->GetOldestItemUidInBuffer(); uid <= trackerBuffer->GetLatestItemUidInBuffer(); ++uid)
+    {
+      StreamBufferItem item;
+      if (trackerBuffer->GetStreamBufferItem(uid, &item) != ITEM_OK || item.GetStatus() != TOOL_OK)
+      {
+        continue;
+      }
+      vtkSmartPointer<vtkMatrix4x4> itemMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+      item.GetMatrix(itemMatrix);
+      itemTimes.push_back(item.GetFilteredTimestamp(trackerBuffer->GetLocalTimeOffsetSec()));
+      itemMatrices.push_back(itemMatrix);
+    }
+
+    std::vector<double> sampleTimes;
+    for (double newTime = startTime; newTime < endTime; newTime += timeStep)
+    {
+      sampleTimes.push_back(newTime);
+    }
+    if (sampleTimes.empty())
+    {
+      return numberOfErrors;
+    }
+    std::vector<PlusInterpolatedPose> poses(sampleTimes.size());
+    trackerBuffer->GetInterpolatedPosesFromTimes(&sampleTimes[0], static_cast<int>(sampleTimes.size()), &poses[0]);
+
+    vtkSmartPointer<vtkMatrix4x4> referenceMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    int numberOfComparedPoses(0);
+    for (size_t sampleIndex = 0; sampleIndex < sampleTimes.size(); ++sampleIndex)
+    {
+      const double time = sampleTimes[sampleIndex];
+      if (poses[sampleIndex].Result != ITEM_OK || poses[sampleIndex].Status != TOOL_OK)
+      {
+        continue;
+      }
+      // Find the valid items before and after the requested time
+      std::vector<double>::iterator itemBIt = std::lower_bound(itemTimes.begin(), itemTimes.end(), time);
+      if (itemBIt == itemTimes.end())
+      {
+        continue;
+      }
+      size_t itemBIndex = itemBIt - itemTimes.begin();
+      size_t itemAIndex = (*itemBIt == time || itemBIndex == 0) ? itemBIndex : itemBIndex - 1;
+      double weightB(0);
+      if (itemAIndex != itemBIndex)
+      {
+        weightB = (time - itemTimes[itemAIndex]) / (itemTimes[itemBIndex] - itemTimes[itemAIndex]);
+      }
+      ComputeReferencePose(itemMatrices[itemAIndex], itemMatrices[itemBIndex], weightB, referenceMatrix);
+      numberOfErrors += ComparePoseWithMatrix(poses[sampleIndex], referenceMatrix, time);
+      numberOfComparedPoses++;
+    }
+
+    if (numberOfComparedPoses == 0)
+    {
+      LOG_ERROR("No interpolated poses could be compared to the reference poses!");
+      numberOfErrors++;
+    }
+    return numberOfErrors;
+  }
+
+  //----------------------------------------------------------------------------
+  // Rotation around a fixed axis with constant angular velocity and linear translation: poses between the items are known exactly
+  int CheckBatchInterpolationWithAnalyticPoses()
+  {
+    const int numberOfItems = 20;
+    const double timeStepSec = 0.1;
+    const double angleStepDeg = 7.0;
+    const double translationStep[3] = {10.0, -5.0, 2.5};
+
+    vtkSmartPointer<vtkPlusBuffer> buffer = vtkSmartPointer<vtkPlusBuffer>::New();
+    buffer->SetBufferSize(numberOfItems);
+
+    vtkSmartPointer<vtkTransform> transform = vtkSmartPointer<vtkTransform>::New();
+    for (int itemIndex = 0; itemIndex < numberOfItems; ++itemIndex)
+    {
+      transform->Identity();
+      transform->Translate(translationStep[0] * itemIndex, translationStep[1] * itemIndex, translationStep[2] * itemIndex);
+      transform->RotateWXYZ(angleStepDeg * itemIndex, 1, 2, 3);
+      double timestamp = 1.0 + itemIndex * timeStepSec;
+      if (buffer->AddTimeStampedItem(transform->GetMatrix(), TOOL_OK, itemIndex + 1, timestamp, timestamp) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Failed to add item " << itemIndex << " to the buffer!");
+        return 1;
+      }
+    }
+
+    std::vector<double> sampleTimes;
+    std::vector<double> sampleItemPositions;
+    for (double itemPosition = 0.0; itemPosition <= numberOfItems - 1; itemPosition += 0.3)
+    {
+      sampleTimes.push_back(1.0 + itemPosition * timeStepSec);
+      sampleItemPositions.push_back(itemPosition);
+    }
+    std::vector<PlusInterpolatedPose> poses(sampleTimes.size());
+    if (buffer->GetInterpolatedPosesFromTimes(&sampleTimes[0], static_cast<int>(sampleTimes.size()), &poses[0]) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to interpolate poses from the analytic buffer!");
+      return 1;
+    }
+
+    int numberOfErrors(0);
+    for (size_t sampleIndex = 0; sampleIndex < sampleTimes.size(); ++sampleIndex)
+    {
+      if (poses[sampleIndex].Result != ITEM_OK || poses[sampleIndex].Status != TOOL_OK)
+      {
+        LOG_ERROR("Analytic pose could not be interpolated (timestamp=" << std::fixed << sampleTimes[sampleIndex] << ")!");
+        numberOfErrors++;
+        continue;
+      }
+      const double itemPosition = sampleItemPositions[sampleIndex];
+      transform->Identity();
+      transform->Translate(translationStep[0] * itemPosition, translationStep[1] * itemPosition, translationStep[2] * itemPosition);
+      transform->RotateWXYZ(angleStepDeg * itemPosition, 1, 2, 3);
+      numberOfErrors += ComparePoseWithMatrix(poses[sampleIndex], transform->GetMatrix(), sampleTimes[sampleIndex]);
+    }
+    return numberOfErrors;
+  }
+}
+
 int main(int argc, char **argv)
 {
   int numberOfErrors(0); 
@@ -162,6 +347,16 @@ int main(int argc, char **argv)
     prevmatrix->DeepCopy(matrix);      
   }
 
+  // Check batch interpolation against SLERP reference poses computed from the neighboring items
+  //****************************
+
+  numberOfErrors += CheckBatchInterpolationWithReference(trackerBuffer, startTime, endTime, 1.0 / (frameRate * 5.0));
+
+  // Check batch interpolation against analytically known poses
+  //****************************
+
+  numberOfErrors += CheckBatchInterpolationWithAnalyticPoses();
+
   if ( numberOfErrors != 0 )
   {
     LOG_INFO("Test failed!");
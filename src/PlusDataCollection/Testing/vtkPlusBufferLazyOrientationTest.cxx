@@ -0,0 +1,325 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file vtkPlusBufferLazyOrientationTest.cxx
+  \brief Tests that frames that are stored in the orientation they are added in are reoriented correctly when they are retrieved.
+
+  Frames are added in MN orientation to an MF buffer with lazy image orientation and to a reference buffer that reorients them
+  when they are added, the retrieved frames of the two buffers must be the same. The test checks that a frame is reoriented in place
+  if it is not referenced, that a frame that is referenced by a view (a snapshot) is not modified and its reoriented copy is reused,
+  that frames that are read back from the spill file are in the orientation of the buffer, and that changing the orientation
+  of the buffer does not modify the stored frames.
+*/
+
+// Local includes
+#include "PlusBufferTestHelpers.h"
+#include "PlusConfigure.h"
+#include "vtkPlusBuffer.h"
+
+// VTK includes
+#include <vtksys/CommandLineArguments.hxx>
+
+// STL includes
+#include <cstring>
+#include <vector>
+
+using namespace PlusBufferTestHelpers;
+
+namespace
+{
+  const unsigned int FRAME_WIDTH_PX = 32;
+  const unsigned int FRAME_HEIGHT_PX = 16;
+  const unsigned int FRAME_SIZE_BYTES = FRAME_WIDTH_PX * FRAME_HEIGHT_PX;
+  const int BUFFER_SIZE = 10;
+  const size_t SPILL_FILE_SIZE_BYTES = 64 * 1024;
+
+  //----------------------------------------------------------------------------
+  vtkSmartPointer<vtkPlusBuffer> CreateMfBuffer(bool lazyImageOrientation, int bufferSize)
+  {
+    vtkSmartPointer<vtkPlusBuffer> buffer = CreateVideoBuffer(lazyImageOrientation ? "LazyOrientationTest" : "ReferenceTest", FRAME_WIDTH_PX, FRAME_HEIGHT_PX, bufferSize);
+    buffer->SetLazyImageOrientation(lazyImageOrientation);
+    return buffer;
+  }
+
+  //----------------------------------------------------------------------------
+  PlusStatus AddMnFrame(vtkPlusBuffer* buffer, unsigned long frameNumber)
+  {
+    std::vector<unsigned char> pixels;
+    return AddFrame(buffer, frameNumber, pixels, US_IMG_ORIENT_MN);
+  }
+
+  //----------------------------------------------------------------------------
+  // Returns true if the frame of the item is the same as the frame of the item with the same UID in the reference buffer
+  bool IsSameAsReference(const StreamBufferItem& item, vtkPlusBuffer* referenceBuffer)
+  {
+    StreamBufferItemView referenceItem;
+    if (referenceBuffer->GetStreamBufferItemView(item.GetUid(), referenceItem) != ITEM_OK)
+    {
+      return false;
+    }
+    const unsigned char* pixels = GetPixels(item);
+    const unsigned char* referencePixels = GetPixels(*referenceItem);
+    return pixels != NULL && referencePixels != NULL && memcmp(pixels, referencePixels, FRAME_SIZE_BYTES) == 0;
+  }
+
+  //----------------------------------------------------------------------------
+  int TestReorientInPlace()
+  {
+    vtkSmartPointer<vtkPlusBuffer> buffer = CreateMfBuffer(true, BUFFER_SIZE);
+    vtkSmartPointer<vtkPlusBuffer> referenceBuffer = CreateMfBuffer(false, BUFFER_SIZE);
+    int numberOfErrors(0);
+    for (unsigned long frameNumber = 1; frameNumber <= BUFFER_SIZE; ++frameNumber)
+    {
+      AddMnFrame(buffer, frameNumber);
+      AddMnFrame(referenceBuffer, frameNumber);
+    }
+
+    for (BufferItemUidType uid = buffer->GetOldestItemUidInBuffer(); uid <= buffer->GetLatestItemUidInBuffer(); ++uid)
+    {
+      StreamBufferItemView firstView;
+      StreamBufferItemView secondView;
+      if (buffer->GetStreamBufferItemView(uid, firstView) != ITEM_OK || buffer->GetStreamBufferItemView(uid, secondView) != ITEM_OK)
+      {
+        LOG_ERROR("Failed to get item " << uid);
+        numberOfErrors++;
+        continue;
+      }
+      if (!IsSameAsReference(*firstView, referenceBuffer))
+      {
+        LOG_ERROR("Frame of item " << uid << " is not reoriented correctly");
+        numberOfErrors++;
+      }
+      // The item was not referenced when it was reoriented, so it was reoriented in place and the second view refers to the same item
+      if (firstView.get() != secondView.get())
+      {
+        LOG_ERROR("Item " << uid << " was copied instead of reoriented in place");
+        numberOfErrors++;
+      }
+    }
+    return numberOfErrors;
+  }
+
+  //----------------------------------------------------------------------------
+  int TestReorientReferencedItem()
+  {
+    vtkSmartPointer<vtkPlusBuffer> buffer = CreateMfBuffer(true, BUFFER_SIZE);
+    vtkSmartPointer<vtkPlusBuffer> referenceBuffer = CreateMfBuffer(false, BUFFER_SIZE);
+    int numberOfErrors(0);
+    for (unsigned long frameNumber = 1; frameNumber <= BUFFER_SIZE; ++frameNumber)
+    {
+      AddMnFrame(buffer, frameNumber);
+      AddMnFrame(referenceBuffer, frameNumber);
+    }
+
+    // The snapshot references the items in their stored orientation
+    vtkPlusBuffer::Snapshot snapshot;
+    if (buffer->GetSnapshot(snapshot) != PLUS_SUCCESS || snapshot.Items.size() != static_cast<size_t>(BUFFER_SIZE))
+    {
+      LOG_ERROR("Failed to take a snapshot of the buffer");
+      return numberOfErrors + 1;
+    }
+
+    for (size_t i = 0; i < snapshot.Items.size(); ++i)
+    {
+      BufferItemUidType uid = snapshot.Items[i]->GetUid();
+      StreamBufferItemView firstView;
+      StreamBufferItemView secondView;
+      StreamBufferItem copiedItem;
+      if (buffer->GetStreamBufferItemView(uid, firstView) != ITEM_OK || buffer->GetStreamBufferItemView(uid, secondView) != ITEM_OK
+          || buffer->GetStreamBufferItem(uid, &copiedItem) != ITEM_OK)
+      {
+        LOG_ERROR("Failed to get item " << uid);
+        numberOfErrors++;
+        continue;
+      }
+      if (!IsSameAsReference(*firstView, referenceBuffer) || !IsSameAsReference(copiedItem, referenceBuffer))
+      {
+        LOG_ERROR("Frame of item " << uid << " is not reoriented correctly");
+        numberOfErrors++;
+      }
+      if (firstView.get() == snapshot.Items[i].get())
+      {
+        LOG_ERROR("Item " << uid << " was reoriented while it was referenced by the snapshot");
+        numberOfErrors++;
+      }
+      // The reoriented copy is kept, so the item is not reoriented again
+      if (firstView.get() != secondView.get())
+      {
+        LOG_ERROR("Reoriented copy of item " << uid << " was not reused");
+        numberOfErrors++;
+      }
+
+      // The frame that is referenced by the snapshot is not modified
+      std::vector<unsigned char> storedPixels(FRAME_SIZE_BYTES);
+      FillFrame(snapshot.Items[i]->GetIndex(), storedPixels);
+      const unsigned char* snapshotPixels = GetPixels(*snapshot.Items[i]);
+      if (snapshotPixels == NULL || memcmp(snapshotPixels, &storedPixels[0], FRAME_SIZE_BYTES) != 0)
+      {
+        LOG_ERROR("Frame of item " << uid << " was modified while it was referenced by the snapshot");
+        numberOfErrors++;
+      }
+    }
+
+    // The copies are not used anymore when the items are overwritten
+    for (unsigned long frameNumber = BUFFER_SIZE + 1; frameNumber <= 2 * BUFFER_SIZE; ++frameNumber)
+    {
+      AddMnFrame(buffer, frameNumber);
+      AddMnFrame(referenceBuffer, frameNumber);
+    }
+    for (BufferItemUidType uid = buffer->GetOldestItemUidInBuffer(); uid <= buffer->GetLatestItemUidInBuffer(); ++uid)
+    {
+      StreamBufferItemView itemView;
+      if (buffer->GetStreamBufferItemView(uid, itemView) != ITEM_OK || itemView->GetUid() != uid || !IsSameAsReference(*itemView, referenceBuffer))
+      {
+        LOG_ERROR("Frame of item " << uid << " is not reoriented correctly after the buffer was overwritten");
+        numberOfErrors++;
+      }
+    }
+    return numberOfErrors;
+  }
+
+  //----------------------------------------------------------------------------
+  int TestReorientSpilledItems()
+  {
+    vtkSmartPointer<vtkPlusBuffer> buffer = CreateMfBuffer(true, BUFFER_SIZE);
+    vtkSmartPointer<vtkPlusBuffer> referenceBuffer = CreateMfBuffer(false, 3 * BUFFER_SIZE);
+    if (buffer->SetSpillFileSizeBytes(SPILL_FILE_SIZE_BYTES) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to create the spill file");
+      return 1;
+    }
+    int numberOfErrors(0);
+    for (unsigned long frameNumber = 1; frameNumber <= 3 * BUFFER_SIZE; ++frameNumber)
+    {
+      AddMnFrame(buffer, frameNumber);
+      AddMnFrame(referenceBuffer, frameNumber);
+      buffer->SpillPendingItems();
+    }
+    if (buffer->GetOldestItemUidInBuffer() != 1)
+    {
+      LOG_ERROR("Items were not spilled, oldest item UID: " << buffer->GetOldestItemUidInBuffer());
+      numberOfErrors++;
+    }
+
+    // Spilled items are read twice, to make sure that they are not reoriented again
+    for (int pass = 0; pass < 2; ++pass)
+    {
+      for (BufferItemUidType uid = buffer->GetOldestItemUidInBuffer(); uid <= buffer->GetLatestItemUidInBuffer(); ++uid)
+      {
+        StreamBufferItem item;
+        if (buffer->GetStreamBufferItem(uid, &item) != ITEM_OK || item.GetUid() != uid || !IsSameAsReference(item, referenceBuffer))
+        {
+          LOG_ERROR("Frame of item " << uid << " is not reoriented correctly");
+          numberOfErrors++;
+        }
+      }
+    }
+    return numberOfErrors;
+  }
+
+  //----------------------------------------------------------------------------
+  int TestChangeOrientation()
+  {
+    vtkSmartPointer<vtkPlusBuffer> buffer = CreateMfBuffer(true, BUFFER_SIZE);
+    vtkSmartPointer<vtkPlusBuffer> referenceBuffer = CreateMfBuffer(false, BUFFER_SIZE);
+    int numberOfErrors(0);
+    for (unsigned long frameNumber = 1; frameNumber <= BUFFER_SIZE; ++frameNumber)
+    {
+      AddMnFrame(buffer, frameNumber);
+      AddMnFrame(referenceBuffer, frameNumber);
+    }
+
+    // The snapshot makes the buffer keep reoriented copies of the items in MF orientation
+    vtkPlusBuffer::Snapshot snapshot;
+    if (buffer->GetSnapshot(snapshot) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to take a snapshot of the buffer");
+      return numberOfErrors + 1;
+    }
+    for (size_t i = 0; i < snapshot.Items.size(); ++i)
+    {
+      StreamBufferItemView itemView;
+      buffer->GetStreamBufferItemView(snapshot.Items[i]->GetUid(), itemView);
+    }
+
+    // The frames were added in MN orientation, so they are retrieved as they were added
+    buffer->SetImageOrientation(US_IMG_ORIENT_MN);
+    for (BufferItemUidType uid = buffer->GetOldestItemUidInBuffer(); uid <= buffer->GetLatestItemUidInBuffer(); ++uid)
+    {
+      StreamBufferItemView itemView;
+      if (buffer->GetStreamBufferItemView(uid, itemView) != ITEM_OK)
+      {
+        LOG_ERROR("Failed to get item " << uid);
+        numberOfErrors++;
+        continue;
+      }
+      std::vector<unsigned char> addedPixels(FRAME_SIZE_BYTES);
+      FillFrame(itemView->GetIndex(), addedPixels);
+      const unsigned char* pixels = GetPixels(*itemView);
+      if (const_cast<StreamBufferItem&>(*itemView).GetFrame().GetImageOrientation() != US_IMG_ORIENT_MN
+          || pixels == NULL || memcmp(pixels, &addedPixels[0], FRAME_SIZE_BYTES) != 0)
+      {
+        LOG_ERROR("Frame of item " << uid << " is not in the new orientation of the buffer");
+        numberOfErrors++;
+      }
+    }
+
+    // Back to the original orientation, the frames are reoriented again
+    buffer->SetImageOrientation(US_IMG_ORIENT_MF);
+    for (BufferItemUidType uid = buffer->GetOldestItemUidInBuffer(); uid <= buffer->GetLatestItemUidInBuffer(); ++uid)
+    {
+      StreamBufferItem item;
+      if (buffer->GetStreamBufferItem(uid, &item) != ITEM_OK || !IsSameAsReference(item, referenceBuffer))
+      {
+        LOG_ERROR("Frame of item " << uid << " is not reoriented correctly after the orientation of the buffer was restored");
+        numberOfErrors++;
+      }
+    }
+    return numberOfErrors;
+  }
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  int numberOfErrors(0);
+  numberOfErrors += TestReorientInPlace();
+  numberOfErrors += TestReorientReferencedItem();
+  numberOfErrors += TestReorientSpilledItems();
+  numberOfErrors += TestChangeOrientation();
+
+  if (numberOfErrors != 0)
+  {
+    LOG_INFO("Test failed!");
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("Test completed successfully!");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,310 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file vtkPlusBufferResizeTest.cxx
+  \brief Tests that resizing a video buffer keeps the content of the frames, while frames are added and read concurrently.
+
+  Each frame is filled with a pattern that depends on the frame number, so frames that share memory
+  or that are read while they are partially overwritten are detected.
+*/
+
+// Local includes
+#include "PlusBufferTestHelpers.h"
+#include "PlusConfigure.h"
+#include "vtkPlusBuffer.h"
+
+// VTK includes
+#include <vtksys/CommandLineArguments.hxx>
+
+// STL includes
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace PlusBufferTestHelpers;
+
+namespace
+{
+  const unsigned int FRAME_SIZE_PX = 32;
+
+  //----------------------------------------------------------------------------
+  int CheckAllItems(vtkPlusBuffer* buffer, int expectedNumberOfItems, unsigned long expectedLatestFrameNumber)
+  {
+    int numberOfErrors(0);
+    if (buffer->GetNumberOfItems() != expectedNumberOfItems)
+    {
+      LOG_ERROR("Unexpected number of items in the buffer: " << buffer->GetNumberOfItems() << " (expected " << expectedNumberOfItems << ")");
+      numberOfErrors++;
+    }
+    for (BufferItemUidType uid = buffer->GetOldestItemUidInBuffer(); uid <= buffer->GetLatestItemUidInBuffer(); ++uid)
+    {
+      StreamBufferItem item;
+      if (buffer->GetStreamBufferItem(uid, &item) != ITEM_OK)
+      {
+        LOG_ERROR("Failed to get item " << uid << " from the buffer");
+        numberOfErrors++;
+        continue;
+      }
+      if (uid == buffer->GetLatestItemUidInBuffer() && item.GetIndex() != expectedLatestFrameNumber)
+      {
+        LOG_ERROR("Unexpected latest frame number: " << item.GetIndex() << " (expected " << expectedLatestFrameNumber << ")");
+        numberOfErrors++;
+      }
+      if (!CheckItemContent(item))
+      {
+        LOG_ERROR("Content of frame " << item.GetIndex() << " is corrupted");
+        numberOfErrors++;
+      }
+    }
+    return numberOfErrors;
+  }
+
+  //----------------------------------------------------------------------------
+  int TestResizeKeepsContent()
+  {
+    int numberOfErrors(0);
+    vtkSmartPointer<vtkPlusBuffer> buffer = CreateVideoBuffer("ResizeTest", FRAME_SIZE_PX, FRAME_SIZE_PX, 10);
+    std::vector<unsigned char> pixels(FRAME_SIZE_PX * FRAME_SIZE_PX);
+    unsigned long frameNumber(0);
+
+    for (int i = 0; i < 10; ++i)
+    {
+      AddFrame(buffer, ++frameNumber, pixels);
+    }
+    numberOfErrors += CheckAllItems(buffer, 10, frameNumber);
+
+    // Grow: existing frames are kept, the new slots are filled by the next frames
+    if (buffer->SetBufferSize(20) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to grow the buffer");
+      numberOfErrors++;
+    }
+    numberOfErrors += CheckAllItems(buffer, 10, frameNumber);
+    for (int i = 0; i < 15; ++i)
+    {
+      AddFrame(buffer, ++frameNumber, pixels);
+      numberOfErrors += CheckAllItems(buffer, std::min(20, 10 + i + 1), frameNumber);
+    }
+
+    // Shrink: the oldest frames are removed, the remaining frames are kept
+    if (buffer->SetBufferSize(8) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to shrink the buffer");
+      numberOfErrors++;
+    }
+    numberOfErrors += CheckAllItems(buffer, 8, frameNumber);
+    for (int i = 0; i < 30; ++i)
+    {
+      AddFrame(buffer, ++frameNumber, pixels);
+      numberOfErrors += CheckAllItems(buffer, 8, frameNumber);
+    }
+    return numberOfErrors;
+  }
+
+  //----------------------------------------------------------------------------
+  // Returns the number of items that cannot be found by their timestamp or UID
+  int CheckLookups(vtkPlusBuffer* buffer)
+  {
+    int numberOfErrors(0);
+    for (BufferItemUidType uid = buffer->GetOldestItemUidInBuffer(); uid <= buffer->GetLatestItemUidInBuffer(); ++uid)
+    {
+      StreamBufferItemView view;
+      if (buffer->GetStreamBufferItemView(uid, view) != ITEM_OK || !view)
+      {
+        LOG_ERROR("Failed to get a view of item " << uid);
+        numberOfErrors++;
+        continue;
+      }
+      if (view->GetUid() != uid || view->GetIndex() == 0)
+      {
+        LOG_ERROR("Item " << uid << " has unexpected UID " << view->GetUid() << " and frame number " << view->GetIndex());
+        numberOfErrors++;
+        continue;
+      }
+      double timestamp = GetFrameTimestamp(view->GetIndex());
+      BufferItemUidType uidFromTime(0);
+      if (buffer->GetItemUidFromTime(timestamp, uidFromTime) != ITEM_OK || uidFromTime != uid)
+      {
+        LOG_ERROR("Item " << uid << " is not found by its timestamp " << timestamp << " (found " << uidFromTime << ")");
+        numberOfErrors++;
+      }
+      StreamBufferItem item;
+      if (buffer->GetStreamBufferItemFromTime(timestamp, &item, vtkPlusBuffer::EXACT_TIME) != ITEM_OK
+          || item.GetUid() != uid || item.GetFilteredTimestamp(0) != timestamp || !CheckItemContent(item))
+      {
+        LOG_ERROR("Item " << uid << " cannot be retrieved by its timestamp " << timestamp);
+        numberOfErrors++;
+      }
+    }
+    return numberOfErrors;
+  }
+
+  //----------------------------------------------------------------------------
+  // Items that are referenced by views while the buffer is resized are moved to the new memory with all their data
+  int TestResizeWithHeldView()
+  {
+    int numberOfErrors(0);
+    vtkSmartPointer<vtkPlusBuffer> buffer = CreateVideoBuffer("ResizeTest", FRAME_SIZE_PX, FRAME_SIZE_PX, 10);
+    std::vector<unsigned char> pixels(FRAME_SIZE_PX * FRAME_SIZE_PX);
+    unsigned long frameNumber(0);
+
+    for (int i = 0; i < 10; ++i)
+    {
+      AddFrame(buffer, ++frameNumber, pixels);
+    }
+    StreamBufferItemView oldestView;
+    StreamBufferItemView latestView;
+    if (buffer->GetStreamBufferItemView(buffer->GetOldestItemUidInBuffer() + 2, oldestView) != ITEM_OK
+        || buffer->GetStreamBufferItemView(buffer->GetLatestItemUidInBuffer(), latestView) != ITEM_OK)
+    {
+      LOG_ERROR("Failed to get views of the items");
+      return 1;
+    }
+
+    if (buffer->SetBufferSize(20) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to grow the buffer while views are held");
+      numberOfErrors++;
+    }
+    numberOfErrors += CheckAllItems(buffer, 10, frameNumber);
+    numberOfErrors += CheckLookups(buffer);
+
+    if (buffer->SetBufferSize(8) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to shrink the buffer while views are held");
+      numberOfErrors++;
+    }
+    numberOfErrors += CheckAllItems(buffer, 8, frameNumber);
+    numberOfErrors += CheckLookups(buffer);
+
+    // The held items are not modified by the buffer
+    if (!CheckItemContent(*oldestView) || !CheckItemContent(*latestView) || latestView->GetIndex() != frameNumber)
+    {
+      LOG_ERROR("Content of the items referenced by views changed while the buffer was resized");
+      numberOfErrors++;
+    }
+    oldestView.reset();
+    latestView.reset();
+
+    for (int i = 0; i < 20; ++i)
+    {
+      AddFrame(buffer, ++frameNumber, pixels);
+    }
+    numberOfErrors += CheckAllItems(buffer, 8, frameNumber);
+    numberOfErrors += CheckLookups(buffer);
+    return numberOfErrors;
+  }
+
+  //----------------------------------------------------------------------------
+  int TestConcurrentResize(double durationSec)
+  {
+    vtkSmartPointer<vtkPlusBuffer> buffer = CreateVideoBuffer("ResizeTest", FRAME_SIZE_PX, FRAME_SIZE_PX, 10);
+    std::atomic<bool> done(false);
+    std::atomic<int> numberOfCorruptedFrames(0);
+    std::atomic<int> numberOfReads(0);
+
+    std::thread writer([&]()
+    {
+      std::vector<unsigned char> pixels(FRAME_SIZE_PX * FRAME_SIZE_PX);
+      unsigned long frameNumber(0);
+      while (!done)
+      {
+        AddFrame(buffer, ++frameNumber, pixels);
+        // leave time for the reader to retrieve the latest item before it is overwritten
+        vtkIGSIOAccurateTimer::Delay(0.001);
+      }
+    });
+    std::thread reader([&]()
+    {
+      while (!done)
+      {
+        StreamBufferItem item;
+        if (buffer->GetNumberOfItems() == 0 || buffer->GetLatestStreamBufferItem(&item) != ITEM_OK)
+        {
+          continue;
+        }
+        numberOfReads++;
+        if (!CheckItemContent(item))
+        {
+          numberOfCorruptedFrames++;
+        }
+      }
+    });
+
+    const int bufferSizes[] = {40, 15, 25, 10, 50, 12};
+    const int numberOfBufferSizes = sizeof(bufferSizes) / sizeof(bufferSizes[0]);
+    int numberOfErrors(0);
+    double startTime = vtkIGSIOAccurateTimer::GetSystemTime();
+    for (int i = 0; vtkIGSIOAccurateTimer::GetSystemTime() - startTime < durationSec; ++i)
+    {
+      if (buffer->SetBufferSize(bufferSizes[i % numberOfBufferSizes]) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Failed to resize the buffer to " << bufferSizes[i % numberOfBufferSizes]);
+        numberOfErrors++;
+      }
+      vtkIGSIOAccurateTimer::Delay(0.01);
+    }
+    done = true;
+    writer.join();
+    reader.join();
+
+    if (numberOfCorruptedFrames > 0)
+    {
+      LOG_ERROR(numberOfCorruptedFrames << " of " << numberOfReads << " frames were corrupted while the buffer was resized");
+      numberOfErrors++;
+    }
+    if (numberOfReads == 0)
+    {
+      LOG_ERROR("No frames could be read while the buffer was resized");
+      numberOfErrors++;
+    }
+    return numberOfErrors;
+  }
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  double durationSec(1.0);
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--duration-sec", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &durationSec, "Duration of resizing the buffer while frames are added and read (Default: 1 sec).");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  int numberOfErrors(0);
+  numberOfErrors += TestResizeKeepsContent();
+  numberOfErrors += TestResizeWithHeldView();
+  numberOfErrors += TestConcurrentResize(durationSec);
+
+  if (numberOfErrors != 0)
+  {
+    LOG_INFO("Test failed!");
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("Test completed successfully!");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,155 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file vtkPlusBufferSnapshotTest.cxx
+  \brief Tests that the frames of a snapshot are not modified while the buffer is overwritten, and that the slots
+  of the frame arena are used again after the snapshot is released.
+
+  Each frame is filled with a pattern that depends on the frame number, so frames that share memory are detected.
+*/
+
+// Local includes
+#include "PlusBufferTestHelpers.h"
+#include "PlusConfigure.h"
+#include "vtkPlusBuffer.h"
+
+// VTK includes
+#include <vtksys/CommandLineArguments.hxx>
+
+// STL includes
+#include <vector>
+
+using namespace PlusBufferTestHelpers;
+
+namespace
+{
+  const unsigned int FRAME_SIZE_PX = 32;
+  const int BUFFER_SIZE = 10;
+
+  //----------------------------------------------------------------------------
+  int CheckSnapshot(const vtkPlusBuffer::Snapshot& snapshot, unsigned long firstFrameNumber)
+  {
+    int numberOfErrors(0);
+    for (size_t i = 0; i < snapshot.Items.size(); ++i)
+    {
+      if (snapshot.Items[i]->GetIndex() != firstFrameNumber + i || !CheckItemContent(*snapshot.Items[i]))
+      {
+        LOG_ERROR("Frame " << firstFrameNumber + i << " of the snapshot has been modified");
+        numberOfErrors++;
+      }
+    }
+    return numberOfErrors;
+  }
+
+  //----------------------------------------------------------------------------
+  // Checks the content of the items in the buffer and whether their frames are in the frame arena
+  int CheckBufferItems(vtkPlusBuffer* buffer, bool expectFramesInArena)
+  {
+    int numberOfErrors(0);
+    for (BufferItemUidType uid = buffer->GetOldestItemUidInBuffer(); uid <= buffer->GetLatestItemUidInBuffer(); ++uid)
+    {
+      StreamBufferItemView itemView;
+      if (buffer->GetStreamBufferItemView(uid, itemView) != ITEM_OK || !CheckItemContent(*itemView))
+      {
+        LOG_ERROR("Content of item " << uid << " is corrupted");
+        numberOfErrors++;
+        continue;
+      }
+      if ((itemView->GetFrameArena() != NULL) != expectFramesInArena)
+      {
+        LOG_ERROR("Frame of item " << uid << (expectFramesInArena ? " is not" : " is") << " in the frame arena");
+        numberOfErrors++;
+      }
+    }
+    return numberOfErrors;
+  }
+
+  //----------------------------------------------------------------------------
+  int TestSnapshotWhileOverwritten()
+  {
+    vtkSmartPointer<vtkPlusBuffer> buffer = CreateVideoBuffer("SnapshotTest", FRAME_SIZE_PX, FRAME_SIZE_PX, BUFFER_SIZE);
+
+    int numberOfErrors(0);
+    AddFrames(buffer, 1, BUFFER_SIZE);
+    numberOfErrors += CheckBufferItems(buffer, true);
+
+    {
+      vtkPlusBuffer::Snapshot snapshot;
+      if (buffer->GetSnapshot(snapshot) != PLUS_SUCCESS || snapshot.Items.size() != static_cast<size_t>(BUFFER_SIZE))
+      {
+        LOG_ERROR("Failed to take a snapshot of the buffer");
+        return numberOfErrors + 1;
+      }
+
+      // The buffer is overwritten twice while the snapshot is held, the new frames cannot use the arena slots
+      AddFrames(buffer, BUFFER_SIZE + 1, 2 * BUFFER_SIZE);
+      numberOfErrors += CheckSnapshot(snapshot, 1);
+      numberOfErrors += CheckBufferItems(buffer, false);
+      AddFrames(buffer, 2 * BUFFER_SIZE + 1, 3 * BUFFER_SIZE);
+      numberOfErrors += CheckSnapshot(snapshot, 1);
+      numberOfErrors += CheckBufferItems(buffer, false);
+    }
+
+    // The snapshot is released, the slots are returned to the arena when the items are overwritten
+    AddFrames(buffer, 3 * BUFFER_SIZE + 1, 4 * BUFFER_SIZE);
+    numberOfErrors += CheckBufferItems(buffer, true);
+
+    // A snapshot that is taken while some frames are not in the arena
+    AddFrames(buffer, 4 * BUFFER_SIZE + 1, 4 * BUFFER_SIZE + BUFFER_SIZE / 2);
+    {
+      vtkPlusBuffer::Snapshot snapshot;
+      if (buffer->GetSnapshot(snapshot) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Failed to take a snapshot of the buffer");
+        return numberOfErrors + 1;
+      }
+      AddFrames(buffer, 4 * BUFFER_SIZE + BUFFER_SIZE / 2 + 1, 6 * BUFFER_SIZE);
+      numberOfErrors += CheckSnapshot(snapshot, 3 * BUFFER_SIZE + BUFFER_SIZE / 2 + 1);
+    }
+    AddFrames(buffer, 6 * BUFFER_SIZE + 1, 7 * BUFFER_SIZE);
+    numberOfErrors += CheckBufferItems(buffer, true);
+
+    return numberOfErrors;
+  }
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  int numberOfErrors = TestSnapshotWhileOverwritten();
+
+  if (numberOfErrors != 0)
+  {
+    LOG_INFO("Test failed!");
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("Test completed successfully!");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,252 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file vtkPlusBufferSpillTest.cxx
+  \brief Tests that items overwritten in a video buffer are read back from the spill file.
+
+  Each frame is filled with a pattern that depends on the frame number, so frames that are read back
+  with wrong content are detected. The test also checks that the oldest items are evicted from the spill
+  file when it is full, and that the spill writer thread writes the items without an explicit request.
+*/
+
+// Local includes
+#include "PlusBufferTestHelpers.h"
+#include "PlusConfigure.h"
+#include "vtkPlusBuffer.h"
+
+// VTK includes
+#include <vtksys/CommandLineArguments.hxx>
+
+// STL includes
+#include <vector>
+
+using namespace PlusBufferTestHelpers;
+
+namespace
+{
+  const unsigned int FRAME_SIZE_PX = 32;
+  const int BUFFER_SIZE = 10;
+  // about 50 records of a 32x32 frame fit in the file
+  const size_t SPILL_FILE_SIZE_BYTES = 64 * 1024;
+
+  //----------------------------------------------------------------------------
+  vtkSmartPointer<vtkPlusBuffer> CreateSpillingVideoBuffer()
+  {
+    vtkSmartPointer<vtkPlusBuffer> buffer = CreateVideoBuffer("SpillTest", FRAME_SIZE_PX, FRAME_SIZE_PX, BUFFER_SIZE);
+    if (buffer->SetSpillFileSizeBytes(SPILL_FILE_SIZE_BYTES) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to create the spill file");
+      return NULL;
+    }
+    return buffer;
+  }
+
+  //----------------------------------------------------------------------------
+  // Checks that the items from firstUid to the latest item (in memory or in the spill file) can be retrieved
+  int CheckItems(vtkPlusBuffer* buffer, BufferItemUidType firstUid)
+  {
+    int numberOfErrors(0);
+    if (buffer->GetOldestItemUidInBuffer() != firstUid)
+    {
+      LOG_ERROR("Unexpected oldest item UID: " << buffer->GetOldestItemUidInBuffer() << " (expected " << firstUid << ")");
+      numberOfErrors++;
+    }
+    for (BufferItemUidType uid = firstUid; uid <= buffer->GetLatestItemUidInBuffer(); ++uid)
+    {
+      // frame numbers start at 1, the same as UIDs
+      const unsigned long frameNumber = static_cast<unsigned long>(uid);
+      StreamBufferItem item;
+      if (buffer->GetStreamBufferItem(uid, &item) != ITEM_OK)
+      {
+        LOG_ERROR("Failed to get item " << uid);
+        numberOfErrors++;
+        continue;
+      }
+      if (item.GetUid() != uid || item.GetIndex() != frameNumber)
+      {
+        LOG_ERROR("Unexpected item " << item.GetUid() << " with frame number " << item.GetIndex() << " (expected item " << uid << ")");
+        numberOfErrors++;
+      }
+      if (!CheckItemContent(item))
+      {
+        LOG_ERROR("Content of frame " << item.GetIndex() << " is corrupted");
+        numberOfErrors++;
+      }
+
+      double timestamp(0);
+      if (buffer->GetTimeStamp(uid, timestamp) != ITEM_OK || fabs(timestamp - GetFrameTimestamp(frameNumber)) > 1e-6)
+      {
+        LOG_ERROR("Unexpected timestamp of item " << uid << ": " << timestamp << " (expected " << GetFrameTimestamp(frameNumber) << ")");
+        numberOfErrors++;
+      }
+      BufferItemUidType uidFromTime(0);
+      if (buffer->GetItemUidFromTime(GetFrameTimestamp(frameNumber), uidFromTime) != ITEM_OK || uidFromTime != uid)
+      {
+        LOG_ERROR("Unexpected item found by the timestamp of item " << uid << ": " << uidFromTime);
+        numberOfErrors++;
+      }
+    }
+    return numberOfErrors;
+  }
+
+  //----------------------------------------------------------------------------
+  int TestReadBack()
+  {
+    vtkSmartPointer<vtkPlusBuffer> buffer = CreateSpillingVideoBuffer();
+    if (buffer == NULL)
+    {
+      return 1;
+    }
+    int numberOfErrors(0);
+    std::vector<unsigned char> pixels(FRAME_SIZE_PX * FRAME_SIZE_PX);
+    for (unsigned long frameNumber = 1; frameNumber <= 3 * BUFFER_SIZE; ++frameNumber)
+    {
+      AddFrame(buffer, frameNumber, pixels);
+      buffer->SpillPendingItems();
+    }
+
+    // All the items fit in the spill file
+    numberOfErrors += CheckItems(buffer, 1);
+
+    double oldestTimestamp(0);
+    if (buffer->GetOldestTimeStamp(oldestTimestamp) != ITEM_OK || fabs(oldestTimestamp - GetFrameTimestamp(1)) > 1e-6)
+    {
+      LOG_ERROR("Unexpected oldest timestamp: " << oldestTimestamp << " (expected " << GetFrameTimestamp(1) << ")");
+      numberOfErrors++;
+    }
+
+    // Items are read the same way by pose and by view
+    PlusInterpolatedPose pose;
+    if (buffer->GetPoseFromUid(2, pose) != ITEM_OK || pose.Uid != 2 || pose.Index != 2)
+    {
+      LOG_ERROR("Failed to get the pose of spilled item 2");
+      numberOfErrors++;
+    }
+    StreamBufferItemView itemView;
+    if (buffer->GetStreamBufferItemView(3, itemView) != ITEM_OK || !CheckItemContent(*itemView) || itemView->GetUid() != 3)
+    {
+      LOG_ERROR("Failed to get a view of spilled item 3");
+      numberOfErrors++;
+    }
+
+    // Spilled items are discarded when the buffer is cleared
+    buffer->Clear();
+    if (buffer->GetNumberOfItems() != 0 || buffer->GetSpillFileSizeBytes() == 0)
+    {
+      LOG_ERROR("Buffer was not cleared");
+      numberOfErrors++;
+    }
+    for (unsigned long frameNumber = 1; frameNumber <= 2 * BUFFER_SIZE; ++frameNumber)
+    {
+      AddFrame(buffer, frameNumber, pixels);
+      buffer->SpillPendingItems();
+    }
+    numberOfErrors += CheckItems(buffer, 1);
+
+    return numberOfErrors;
+  }
+
+  //----------------------------------------------------------------------------
+  int TestEviction()
+  {
+    vtkSmartPointer<vtkPlusBuffer> buffer = CreateSpillingVideoBuffer();
+    if (buffer == NULL)
+    {
+      return 1;
+    }
+    int numberOfErrors(0);
+    std::vector<unsigned char> pixels(FRAME_SIZE_PX * FRAME_SIZE_PX);
+    const unsigned long numberOfFrames = 200;
+    for (unsigned long frameNumber = 1; frameNumber <= numberOfFrames; ++frameNumber)
+    {
+      AddFrame(buffer, frameNumber, pixels);
+      buffer->SpillPendingItems();
+    }
+
+    // The file is full, the oldest items have been evicted
+    BufferItemUidType oldestUid = buffer->GetOldestItemUidInBuffer();
+    if (oldestUid <= 1 || oldestUid + BUFFER_SIZE > numberOfFrames)
+    {
+      LOG_ERROR("Unexpected oldest item UID after the spill file is full: " << oldestUid);
+      return numberOfErrors + 1;
+    }
+    double timestamp(0);
+    if (buffer->GetTimeStamp(1, timestamp) != ITEM_NOT_AVAILABLE_ANYMORE
+        || buffer->GetTimeStamp(oldestUid - 1, timestamp) != ITEM_NOT_AVAILABLE_ANYMORE)
+    {
+      LOG_ERROR("Evicted items are still available");
+      numberOfErrors++;
+    }
+    BufferItemUidType uidFromTime(0);
+    if (buffer->GetItemUidFromTime(GetFrameTimestamp(1), uidFromTime) != ITEM_OK || uidFromTime != oldestUid)
+    {
+      LOG_ERROR("A time before the oldest item is expected to return the oldest item " << oldestUid << ", but returned " << uidFromTime);
+      numberOfErrors++;
+    }
+    numberOfErrors += CheckItems(buffer, oldestUid);
+
+    return numberOfErrors;
+  }
+
+  //----------------------------------------------------------------------------
+  int TestSpillWriterThread()
+  {
+    vtkSmartPointer<vtkPlusBuffer> buffer = CreateSpillingVideoBuffer();
+    if (buffer == NULL)
+    {
+      return 1;
+    }
+    // Frames are added slower than the spill writer checks the buffer, so all the items are written by the thread
+    std::vector<unsigned char> pixels(FRAME_SIZE_PX * FRAME_SIZE_PX);
+    for (unsigned long frameNumber = 1; frameNumber <= 3 * BUFFER_SIZE; ++frameNumber)
+    {
+      AddFrame(buffer, frameNumber, pixels);
+      vtkIGSIOAccurateTimer::Delay(2 * FRAME_PERIOD_SEC);
+    }
+    return CheckItems(buffer, 1);
+  }
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  int numberOfErrors(0);
+  numberOfErrors += TestReadBack();
+  numberOfErrors += TestEviction();
+  numberOfErrors += TestSpillWriterThread();
+
+  if (numberOfErrors != 0)
+  {
+    LOG_INFO("Test failed!");
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("Test completed successfully!");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,337 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file vtkPlusChannelGetTrackedFramesTest.cxx
+  \brief Tests that the batched queries return the same results as the queries for a single timestamp.
+
+  vtkPlusBuffer::GetItemUidsFromTimes is compared to GetItemUidFromTime for increasing, decreasing, and out of range times.
+  vtkPlusChannel::GetTrackedFrames and GetTrackedFrameListSampled (which retrieves the frames in batches) are compared
+  to GetTrackedFrame on a channel that contains a video source and a tool.
+  The new frame callbacks of a channel are checked to follow the changes of the data sources of the channel.
+*/
+
+// Local includes
+#include "PlusChannelTestHelpers.h"
+#include "PlusConfigure.h"
+#include "vtkPlusBuffer.h"
+#include "vtkPlusChannel.h"
+#include "vtkPlusDataSource.h"
+
+// IGSIO includes
+#include <igsioTrackedFrame.h>
+#include <vtkIGSIOTrackedFrameList.h>
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkMatrix4x4.h>
+#include <vtksys/CommandLineArguments.hxx>
+
+// STL includes
+#include <cstring>
+#include <vector>
+
+using namespace PlusChannelTestHelpers;
+
+namespace
+{
+  const double VIDEO_FRAME_PERIOD_SEC = 0.05;
+  const double TOOL_FRAME_PERIOD_SEC = 0.02;
+  const int NUMBER_OF_VIDEO_FRAMES = 40;
+  const int NUMBER_OF_TOOL_FRAMES = 110;
+
+  //----------------------------------------------------------------------------
+  vtkSmartPointer<vtkPlusDataSource> CreateRecordedVideoSource()
+  {
+    vtkSmartPointer<vtkPlusDataSource> videoSource = CreateVideoSource(NUMBER_OF_VIDEO_FRAMES);
+    std::vector<unsigned char> pixels;
+    for (int frameNumber = 1; frameNumber <= NUMBER_OF_VIDEO_FRAMES; ++frameNumber)
+    {
+      AddVideoFrame(videoSource, frameNumber, frameNumber * VIDEO_FRAME_PERIOD_SEC, pixels);
+    }
+    return videoSource;
+  }
+
+  //----------------------------------------------------------------------------
+  vtkSmartPointer<vtkPlusDataSource> CreateRecordedTool()
+  {
+    vtkSmartPointer<vtkPlusDataSource> tool = CreateTool(NUMBER_OF_TOOL_FRAMES);
+    for (int frameNumber = 1; frameNumber <= NUMBER_OF_TOOL_FRAMES; ++frameNumber)
+    {
+      AddToolFrame(tool, frameNumber, frameNumber * TOOL_FRAME_PERIOD_SEC);
+    }
+    return tool;
+  }
+
+  //----------------------------------------------------------------------------
+  // Returns the number of differences between the two tracked frames
+  int CompareTrackedFrames(igsioTrackedFrame& frame, igsioTrackedFrame& expectedFrame)
+  {
+    int numberOfErrors(0);
+    if (fabs(frame.GetTimestamp() - expectedFrame.GetTimestamp()) > 1e-9)
+    {
+      LOG_ERROR("Timestamp mismatch: " << frame.GetTimestamp() << " (expected " << expectedFrame.GetTimestamp() << ")");
+      numberOfErrors++;
+    }
+
+    vtkImageData* image = frame.GetImageData()->GetImage();
+    vtkImageData* expectedImage = expectedFrame.GetImageData()->GetImage();
+    if (image == NULL || expectedImage == NULL
+        || memcmp(image->GetScalarPointer(), expectedImage->GetScalarPointer(), FRAME_SIZE_BYTES) != 0)
+    {
+      LOG_ERROR("Image mismatch in frame at " << expectedFrame.GetTimestamp());
+      numberOfErrors++;
+    }
+
+    igsioTransformName transformName(TOOL_TRANSFORM_NAME);
+    vtkSmartPointer<vtkMatrix4x4> matrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    vtkSmartPointer<vtkMatrix4x4> expectedMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    if (frame.GetFrameTransform(transformName, matrix) != PLUS_SUCCESS || expectedFrame.GetFrameTransform(transformName, expectedMatrix) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Tool transform is missing from frame at " << expectedFrame.GetTimestamp());
+      return numberOfErrors + 1;
+    }
+    for (int i = 0; i < 4; ++i)
+    {
+      for (int j = 0; j < 4; ++j)
+      {
+        if (fabs(matrix->GetElement(i, j) - expectedMatrix->GetElement(i, j)) > 1e-6)
+        {
+          LOG_ERROR("Tool transform mismatch in frame at " << expectedFrame.GetTimestamp() << " in element (" << i << ", " << j << ")");
+          return numberOfErrors + 1;
+        }
+      }
+    }
+    return numberOfErrors;
+  }
+
+  //----------------------------------------------------------------------------
+  int TestGetItemUidsFromTimes(vtkPlusDataSource* videoSource)
+  {
+    int numberOfErrors(0);
+    std::vector<double> times;
+    // increasing, between frames, exactly at frames, and repeated
+    for (double time = VIDEO_FRAME_PERIOD_SEC; time <= NUMBER_OF_VIDEO_FRAMES * VIDEO_FRAME_PERIOD_SEC; time += VIDEO_FRAME_PERIOD_SEC * 0.37)
+    {
+      times.push_back(time);
+    }
+    times.push_back(times.back());
+    // going backwards falls back to a search
+    times.push_back(VIDEO_FRAME_PERIOD_SEC * 3.2);
+    times.push_back(VIDEO_FRAME_PERIOD_SEC * 2.9);
+    // out of range
+    times.push_back(0.0);
+    times.push_back((NUMBER_OF_VIDEO_FRAMES + 5) * VIDEO_FRAME_PERIOD_SEC);
+    times.push_back(VIDEO_FRAME_PERIOD_SEC * 10.5);
+
+    const int numberOfTimes = static_cast<int>(times.size());
+    std::vector<BufferItemUidType> uids(numberOfTimes, 0);
+    std::vector<ItemStatus> statuses(numberOfTimes, ITEM_UNKNOWN_ERROR);
+    videoSource->GetItemUidsFromTimes(&times[0], numberOfTimes, &uids[0], &statuses[0]);
+    for (int i = 0; i < numberOfTimes; ++i)
+    {
+      BufferItemUidType expectedUid(0);
+      ItemStatus expectedStatus = videoSource->GetItemUidFromTime(times[i], expectedUid);
+      if (statuses[i] != expectedStatus || (expectedStatus == ITEM_OK && uids[i] != expectedUid))
+      {
+        LOG_ERROR("GetItemUidsFromTimes mismatch at time " << times[i] << ": status " << statuses[i] << ", UID " << uids[i]
+                  << " (expected status " << expectedStatus << ", UID " << expectedUid << ")");
+        numberOfErrors++;
+      }
+    }
+    if (statuses[numberOfTimes - 3] != ITEM_NOT_AVAILABLE_ANYMORE || statuses[numberOfTimes - 2] != ITEM_NOT_AVAILABLE_YET)
+    {
+      LOG_ERROR("Times out of the range of the buffer are expected to be reported as not available");
+      numberOfErrors++;
+    }
+    return numberOfErrors;
+  }
+
+  //----------------------------------------------------------------------------
+  int TestGetTrackedFrames(vtkPlusChannel* channel)
+  {
+    int numberOfErrors(0);
+    // The tool is interpolated at the video timestamps, some timestamps are the same
+    std::vector<double> timestamps;
+    for (int i = 2; i < NUMBER_OF_VIDEO_FRAMES; i += 3)
+    {
+      timestamps.push_back(i * VIDEO_FRAME_PERIOD_SEC + 0.01);
+    }
+    timestamps.push_back(timestamps.back());
+
+    vtkSmartPointer<vtkIGSIOTrackedFrameList> trackedFrameList = vtkSmartPointer<vtkIGSIOTrackedFrameList>::New();
+    if (channel->GetTrackedFrames(timestamps, trackedFrameList) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("GetTrackedFrames failed");
+      return numberOfErrors + 1;
+    }
+    if (trackedFrameList->GetNumberOfTrackedFrames() != timestamps.size())
+    {
+      LOG_ERROR("GetTrackedFrames returned " << trackedFrameList->GetNumberOfTrackedFrames() << " frames (expected " << timestamps.size() << ")");
+      return numberOfErrors + 1;
+    }
+    for (size_t i = 0; i < timestamps.size(); ++i)
+    {
+      igsioTrackedFrame expectedFrame;
+      if (channel->GetTrackedFrame(timestamps[i], expectedFrame) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("GetTrackedFrame failed at " << timestamps[i]);
+        numberOfErrors++;
+        continue;
+      }
+      numberOfErrors += CompareTrackedFrames(*trackedFrameList->GetTrackedFrame(i), expectedFrame);
+    }
+    return numberOfErrors;
+  }
+
+  //----------------------------------------------------------------------------
+  int TestGetTrackedFrameListSampled(vtkPlusChannel* channel)
+  {
+    int numberOfErrors(0);
+    // Sampled more often than the frames, so that all the frames are returned, each of them once
+    double timestampOfLastFrameAlreadyGot = UNDEFINED_TIMESTAMP;
+    double timestampOfNextFrameToBeAdded = 0.3;
+    vtkSmartPointer<vtkIGSIOTrackedFrameList> trackedFrameList = vtkSmartPointer<vtkIGSIOTrackedFrameList>::New();
+    if (channel->GetTrackedFrameListSampled(timestampOfLastFrameAlreadyGot, timestampOfNextFrameToBeAdded, trackedFrameList, VIDEO_FRAME_PERIOD_SEC / 3) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("GetTrackedFrameListSampled failed");
+      return numberOfErrors + 1;
+    }
+
+    // Frames from 0.3 sec (frame 6) to the latest frame
+    const unsigned int expectedNumberOfFrames = NUMBER_OF_VIDEO_FRAMES - 6 + 1;
+    if (trackedFrameList->GetNumberOfTrackedFrames() != expectedNumberOfFrames)
+    {
+      LOG_ERROR("GetTrackedFrameListSampled returned " << trackedFrameList->GetNumberOfTrackedFrames() << " frames (expected " << expectedNumberOfFrames << ")");
+      return numberOfErrors + 1;
+    }
+    for (unsigned int i = 0; i < trackedFrameList->GetNumberOfTrackedFrames(); ++i)
+    {
+      igsioTrackedFrame expectedFrame;
+      if (channel->GetTrackedFrame((6 + i) * VIDEO_FRAME_PERIOD_SEC, expectedFrame) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("GetTrackedFrame failed at " << (6 + i) * VIDEO_FRAME_PERIOD_SEC);
+        numberOfErrors++;
+        continue;
+      }
+      numberOfErrors += CompareTrackedFrames(*trackedFrameList->GetTrackedFrame(i), expectedFrame);
+    }
+    if (fabs(timestampOfLastFrameAlreadyGot - NUMBER_OF_VIDEO_FRAMES * VIDEO_FRAME_PERIOD_SEC) > 1e-9)
+    {
+      LOG_ERROR("Unexpected timestamp of the last frame: " << timestampOfLastFrameAlreadyGot);
+      numberOfErrors++;
+    }
+
+    // No new frames are returned when there are no new frames in the buffer
+    if (channel->GetTrackedFrameListSampled(timestampOfLastFrameAlreadyGot, timestampOfNextFrameToBeAdded, trackedFrameList, VIDEO_FRAME_PERIOD_SEC / 3) != PLUS_SUCCESS
+        || trackedFrameList->GetNumberOfTrackedFrames() != expectedNumberOfFrames)
+    {
+      LOG_ERROR("GetTrackedFrameListSampled returned frames that have been already returned");
+      numberOfErrors++;
+    }
+    return numberOfErrors;
+  }
+
+  //----------------------------------------------------------------------------
+  int TestNewFrameCallbacks()
+  {
+    int numberOfErrors(0);
+    vtkSmartPointer<vtkPlusChannel> channel = vtkSmartPointer<vtkPlusChannel>::New();
+    channel->SetChannelId("NewFrameStream");
+
+    // The callback is added before the channel has any data source
+    int numberOfCalls(0);
+    channel->AddNewFrameCallback([&numberOfCalls](vtkPlusChannel*, double) { ++numberOfCalls; });
+
+    vtkSmartPointer<vtkPlusDataSource> videoSource = CreateVideoSource(4);
+    channel->SetVideoSource(videoSource);
+    std::vector<unsigned char> pixels;
+    AddVideoFrame(videoSource, 1, VIDEO_FRAME_PERIOD_SEC, pixels);
+    if (numberOfCalls != 1)
+    {
+      LOG_ERROR("New frame callback is not called for the video source that is set after the callback is added (number of calls: " << numberOfCalls << ")");
+      numberOfErrors++;
+    }
+
+    // A callback removes itself when it is called
+    int numberOfSelfRemovingCalls(0);
+    unsigned long selfRemovingCallbackId(0);
+    selfRemovingCallbackId = channel->AddNewFrameCallback([&numberOfSelfRemovingCalls, &selfRemovingCallbackId](vtkPlusChannel * aChannel, double)
+    {
+      ++numberOfSelfRemovingCalls;
+      aChannel->RemoveNewFrameCallback(selfRemovingCallbackId);
+    });
+    AddVideoFrame(videoSource, 2, 2 * VIDEO_FRAME_PERIOD_SEC, pixels);
+    AddVideoFrame(videoSource, 3, 3 * VIDEO_FRAME_PERIOD_SEC, pixels);
+    if (numberOfSelfRemovingCalls != 1 || numberOfCalls != 3)
+    {
+      LOG_ERROR("Unexpected number of new frame callback calls: " << numberOfCalls << " (expected 3), self removing: " << numberOfSelfRemovingCalls << " (expected 1)");
+      numberOfErrors++;
+    }
+
+    // The tool becomes the master data source when the video source is removed
+    vtkSmartPointer<vtkPlusDataSource> tool = CreateTool(4);
+    channel->AddTool(tool);
+    channel->SetVideoSource(NULL);
+    numberOfCalls = 0;
+    AddVideoFrame(videoSource, 4, 4 * VIDEO_FRAME_PERIOD_SEC, pixels);
+    AddToolFrame(tool, 1, TOOL_FRAME_PERIOD_SEC);
+    if (numberOfCalls != 1)
+    {
+      LOG_ERROR("New frame callback does not follow the master data source of the channel (number of calls: " << numberOfCalls << ", expected 1)");
+      numberOfErrors++;
+    }
+    return numberOfErrors;
+  }
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  vtkSmartPointer<vtkPlusDataSource> videoSource = CreateRecordedVideoSource();
+  vtkSmartPointer<vtkPlusDataSource> tool = CreateRecordedTool();
+  vtkSmartPointer<vtkPlusChannel> channel = vtkSmartPointer<vtkPlusChannel>::New();
+  channel->SetChannelId("TrackedVideoStream");
+  channel->SetVideoSource(videoSource);
+  channel->AddTool(tool);
+
+  int numberOfErrors(0);
+  numberOfErrors += TestGetItemUidsFromTimes(videoSource);
+  numberOfErrors += TestGetTrackedFrames(channel);
+  numberOfErrors += TestGetTrackedFrameListSampled(channel);
+  numberOfErrors += TestNewFrameCallbacks();
+
+  if (numberOfErrors != 0)
+  {
+    LOG_INFO("Test failed!");
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("Test completed successfully!");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,310 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file vtkPlusDataCollectorReplayTest.cxx
+  \brief Tests that replaying saved data in virtual-time mode gives the same tracked frames in every run.
+
+  The saved data set is played back twice with ClockMode="VirtualTime". The tracked frames of the TrackedVideoDevice
+  that cover the same virtual time period are retrieved after each run and compared: timestamps, pixels, and transforms
+  must be identical.
+*/
+
+// Local includes
+#include "PlusConfigure.h"
+#include "PlusClock.h"
+#include "vtkPlusChannel.h"
+#include "vtkPlusDataCollector.h"
+#include "vtkPlusDataSource.h"
+#include "vtkPlusDevice.h"
+#include "vtkPlusSavedDataSource.h"
+
+// IGSIO includes
+#include <igsioTrackedFrame.h>
+#include <vtkIGSIOTrackedFrameList.h>
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkMatrix4x4.h>
+#include <vtkSmartPointer.h>
+#include <vtksys/CommandLineArguments.hxx>
+
+// STL includes
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace
+{
+  const double VIRTUAL_CLOCK_START_TIME_SEC = 100.0;
+  /*! Frames of the first period are not compared, the filtered timestamps need a few items to settle */
+  const double SKIPPED_PERIOD_SEC = 0.5;
+  /*! Maximum (real) time for a replay */
+  const double REPLAY_TIMEOUT_SEC = 60.0;
+
+  //----------------------------------------------------------------------------
+  PlusStatus SetSequenceFile(vtkPlusDataCollector* dataCollector, const std::string& deviceId, const std::string& sequenceFile)
+  {
+    if (sequenceFile.empty())
+    {
+      return PLUS_SUCCESS;
+    }
+    vtkPlusDevice* device(NULL);
+    if (dataCollector->GetDevice(device, deviceId) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Unable to locate the device with Id=\"" << deviceId << "\". Check config file.");
+      return PLUS_FAIL;
+    }
+    vtkPlusSavedDataSource* savedDataSource = dynamic_cast<vtkPlusSavedDataSource*>(device);
+    if (savedDataSource == NULL)
+    {
+      LOG_ERROR("Device " << deviceId << " is not a saved data source");
+      return PLUS_FAIL;
+    }
+    savedDataSource->SetSequenceFile(sequenceFile.c_str());
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  // Replays the data and gets the tracked frames of the first replayDurationSec of the virtual time
+  PlusStatus Replay(vtkXMLDataElement* configRootElement, const std::string& videoSequenceFile, const std::string& trackerSequenceFile,
+                    double replayDurationSec, vtkIGSIOTrackedFrameList* trackedFrames)
+  {
+    vtkSmartPointer<vtkPlusDataCollector> dataCollector = vtkSmartPointer<vtkPlusDataCollector>::New();
+    if (dataCollector->ReadConfiguration(configRootElement) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Unable to read the data collector configuration");
+      return PLUS_FAIL;
+    }
+    if (!PlusClock::IsVirtualTime() || dataCollector->GetAcquisitionThreadPoolSize() != 1)
+    {
+      LOG_ERROR("Virtual-time mode with a single acquisition thread is expected");
+      return PLUS_FAIL;
+    }
+    if (SetSequenceFile(dataCollector, "VideoDevice", videoSequenceFile) != PLUS_SUCCESS
+        || SetSequenceFile(dataCollector, "TrackerDevice", trackerSequenceFile) != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+
+    vtkPlusDevice* trackedVideoDevice(NULL);
+    if (dataCollector->GetDevice(trackedVideoDevice, "TrackedVideoDevice") != PLUS_SUCCESS || trackedVideoDevice->OutputChannelCount() == 0)
+    {
+      LOG_ERROR("Unable to locate the output channel of the device with Id=\"TrackedVideoDevice\". Check config file.");
+      return PLUS_FAIL;
+    }
+    vtkPlusChannel* channel = *(trackedVideoDevice->GetOutputChannelsStart());
+    vtkPlusDataSource* videoSource(NULL);
+    if (channel->GetVideoSource(videoSource) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Channel " << channel->GetChannelId() << " has no video source");
+      return PLUS_FAIL;
+    }
+
+    if (dataCollector->Connect() != PLUS_SUCCESS || dataCollector->Start() != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to start data collection");
+      return PLUS_FAIL;
+    }
+
+    // The virtual time advances as fast as the devices are updated, wait until the replayed period is in the buffers
+    const double endTimestamp = VIRTUAL_CLOCK_START_TIME_SEC + replayDurationSec;
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::duration<double>(REPLAY_TIMEOUT_SEC);
+    double latestTimestamp(UNDEFINED_TIMESTAMP);
+    while (channel->GetMostRecentTimestamp(latestTimestamp) != PLUS_SUCCESS || latestTimestamp < endTimestamp)
+    {
+      if (std::chrono::steady_clock::now() > deadline)
+      {
+        LOG_ERROR("Replay of " << replayDurationSec << " sec did not finish in " << REPLAY_TIMEOUT_SEC << " sec");
+        dataCollector->Stop();
+        dataCollector->Disconnect();
+        return PLUS_FAIL;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    dataCollector->Stop();
+
+    // The frames of the period at the timestamps of the video items
+    std::vector<double> timestamps;
+    for (BufferItemUidType uid = videoSource->GetOldestItemUidInBuffer(); uid <= videoSource->GetLatestItemUidInBuffer(); ++uid)
+    {
+      double timestamp(0);
+      if (videoSource->GetTimeStamp(uid, timestamp) == ITEM_OK
+          && timestamp >= VIRTUAL_CLOCK_START_TIME_SEC + SKIPPED_PERIOD_SEC && timestamp <= endTimestamp)
+      {
+        timestamps.push_back(timestamp);
+      }
+    }
+    PlusStatus status = channel->GetTrackedFrames(timestamps, trackedFrames);
+    dataCollector->Disconnect();
+    if (status != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to get the tracked frames of the replay");
+      return PLUS_FAIL;
+    }
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  // Returns the number of differences between the two tracked frames
+  int CompareTrackedFrames(igsioTrackedFrame& frame, igsioTrackedFrame& expectedFrame)
+  {
+    if (frame.GetTimestamp() != expectedFrame.GetTimestamp())
+    {
+      LOG_ERROR("Timestamp mismatch: " << std::fixed << frame.GetTimestamp() << " (expected " << expectedFrame.GetTimestamp() << ")");
+      return 1;
+    }
+
+    int numberOfErrors(0);
+    vtkImageData* image = frame.GetImageData()->GetImage();
+    vtkImageData* expectedImage = expectedFrame.GetImageData()->GetImage();
+    if (image == NULL || expectedImage == NULL)
+    {
+      LOG_ERROR("Image is missing from frame at " << std::fixed << expectedFrame.GetTimestamp());
+      numberOfErrors++;
+    }
+    else
+    {
+      size_t imageSizeBytes = static_cast<size_t>(expectedImage->GetNumberOfPoints()) * expectedImage->GetNumberOfScalarComponents() * expectedImage->GetScalarSize();
+      size_t actualImageSizeBytes = static_cast<size_t>(image->GetNumberOfPoints()) * image->GetNumberOfScalarComponents() * image->GetScalarSize();
+      if (actualImageSizeBytes != imageSizeBytes || memcmp(image->GetScalarPointer(), expectedImage->GetScalarPointer(), imageSizeBytes) != 0)
+      {
+        LOG_ERROR("Image mismatch in frame at " << std::fixed << expectedFrame.GetTimestamp());
+        numberOfErrors++;
+      }
+    }
+
+    std::vector<igsioTransformName> transformNames;
+    expectedFrame.GetFrameTransformNameList(transformNames);
+    vtkSmartPointer<vtkMatrix4x4> matrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    vtkSmartPointer<vtkMatrix4x4> expectedMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    for (std::vector<igsioTransformName>::iterator it = transformNames.begin(); it != transformNames.end(); ++it)
+    {
+      ToolStatus status(TOOL_INVALID);
+      ToolStatus expectedStatus(TOOL_INVALID);
+      expectedFrame.GetFrameTransform(*it, expectedMatrix);
+      expectedFrame.GetFrameTransformStatus(*it, expectedStatus);
+      if (frame.GetFrameTransform(*it, matrix) != PLUS_SUCCESS || frame.GetFrameTransformStatus(*it, status) != PLUS_SUCCESS || status != expectedStatus)
+      {
+        LOG_ERROR("Transform " << it->GetTransformName() << " is missing or has a different status in frame at " << std::fixed << expectedFrame.GetTimestamp());
+        numberOfErrors++;
+        continue;
+      }
+      for (int i = 0; i < 4; ++i)
+      {
+        for (int j = 0; j < 4; ++j)
+        {
+          if (matrix->GetElement(i, j) != expectedMatrix->GetElement(i, j))
+          {
+            LOG_ERROR("Transform " << it->GetTransformName() << " mismatch in frame at " << std::fixed << expectedFrame.GetTimestamp() << " in element (" << i << ", " << j << ")");
+            numberOfErrors++;
+            i = 4;
+            break;
+          }
+        }
+      }
+    }
+    return numberOfErrors;
+  }
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  std::string inputConfigFileName;
+  std::string inputVideoBufferMetafile;
+  std::string inputTrackerBufferMetafile;
+  double replayDurationSec(3.0);
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--config-file", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &inputConfigFileName, "Name of the input configuration file. It has to contain VideoDevice and TrackerDevice saved data sources and a TrackedVideoDevice.");
+  args.AddArgument("--video-buffer-seq-file", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &inputVideoBufferMetafile, "Video buffer sequence metafile.");
+  args.AddArgument("--tracker-buffer-seq-file", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &inputTrackerBufferMetafile, "Tracker buffer sequence metafile.");
+  args.AddArgument("--replay-duration-sec", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &replayDurationSec, "Virtual time period that is compared (default: 3 sec).");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  if (inputConfigFileName.empty())
+  {
+    std::cerr << "--config-file is required" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  vtkSmartPointer<vtkXMLDataElement> configRootElement = vtkSmartPointer<vtkXMLDataElement>::New();
+  if (PlusXmlUtils::ReadDeviceSetConfigurationFromFile(configRootElement, inputConfigFileName.c_str()) == PLUS_FAIL)
+  {
+    LOG_ERROR("Unable to read configuration from file " << inputConfigFileName);
+    return EXIT_FAILURE;
+  }
+  vtkPlusConfig::GetInstance()->SetDeviceSetConfigurationData(configRootElement);
+
+  vtkXMLDataElement* dataCollectionElement = configRootElement->FindNestedElementWithName("DataCollection");
+  if (dataCollectionElement == NULL)
+  {
+    LOG_ERROR("Unable to find the DataCollection element in the configuration");
+    return EXIT_FAILURE;
+  }
+  dataCollectionElement->SetAttribute("ClockMode", PlusClock::GetClockModeAsString(PlusClock::VIRTUAL_TIME).c_str());
+  dataCollectionElement->SetDoubleAttribute("VirtualClockStartTimeSec", VIRTUAL_CLOCK_START_TIME_SEC);
+
+  vtkSmartPointer<vtkIGSIOTrackedFrameList> firstReplayFrames = vtkSmartPointer<vtkIGSIOTrackedFrameList>::New();
+  vtkSmartPointer<vtkIGSIOTrackedFrameList> secondReplayFrames = vtkSmartPointer<vtkIGSIOTrackedFrameList>::New();
+  if (Replay(configRootElement, inputVideoBufferMetafile, inputTrackerBufferMetafile, replayDurationSec, firstReplayFrames) != PLUS_SUCCESS
+      || Replay(configRootElement, inputVideoBufferMetafile, inputTrackerBufferMetafile, replayDurationSec, secondReplayFrames) != PLUS_SUCCESS)
+  {
+    PlusClock::SetClockMode(PlusClock::REAL_TIME);
+    LOG_INFO("Test failed!");
+    return EXIT_FAILURE;
+  }
+  PlusClock::SetClockMode(PlusClock::REAL_TIME);
+
+  int numberOfErrors(0);
+  if (firstReplayFrames->GetNumberOfTrackedFrames() == 0)
+  {
+    LOG_ERROR("No frames were replayed");
+    numberOfErrors++;
+  }
+  if (secondReplayFrames->GetNumberOfTrackedFrames() != firstReplayFrames->GetNumberOfTrackedFrames())
+  {
+    LOG_ERROR("Number of replayed frames is different: " << secondReplayFrames->GetNumberOfTrackedFrames() << " (first replay: " << firstReplayFrames->GetNumberOfTrackedFrames() << ")");
+    numberOfErrors++;
+  }
+  else
+  {
+    LOG_INFO("Comparing " << firstReplayFrames->GetNumberOfTrackedFrames() << " replayed frames");
+    for (unsigned int i = 0; i < firstReplayFrames->GetNumberOfTrackedFrames(); ++i)
+    {
+      numberOfErrors += CompareTrackedFrames(*secondReplayFrames->GetTrackedFrame(i), *firstReplayFrames->GetTrackedFrame(i));
+    }
+  }
+
+  if (numberOfErrors != 0)
+  {
+    LOG_INFO("Test failed!");
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("Test completed successfully!");
+  return EXIT_SUCCESS;
+}
@@ -558,6 +558,12 @@ PlusStatus vtkPlusV4L2VideoSource::InternalUpdate()
   return PLUS_SUCCESS;
 }
 
+//----------------------------------------------------------------------------
+int vtkPlusV4L2VideoSource::GetInternalUpdateFileDescriptor() const
+{
+  return this->FileDescriptor;
+}
+
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusV4L2VideoSource::ReadFrame(unsigned int& currentBufferIndex, unsigned int& bytesUsed)
 {
@@ -57,6 +57,9 @@ public:
   /*! Poll the device for new frames */
   PlusStatus InternalUpdate();
 
+  /*! The video device is readable when a new frame is available */
+  virtual int GetInternalUpdateFileDescriptor() const;
+
   /*! Verify the device is correctly configured */
   virtual PlusStatus NotifyConfigured();
 
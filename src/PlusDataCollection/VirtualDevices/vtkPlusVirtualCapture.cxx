@@ -139,7 +139,7 @@ PlusStatus vtkPlusVirtualCapture::InternalConnect()
     this->SetEnableCapturing(true);
   }
 
-  this->LastUpdateTime = vtkIGSIOAccurateTimer::GetSystemTime();
+  this->LastUpdateTime = PlusClock::GetSystemTime();
 
   return PLUS_SUCCESS;
 }
@@ -296,13 +296,13 @@ PlusStatus vtkPlusVirtualCapture::InternalUpdate()
 
   if (this->LastUpdateTime == 0.0)
   {
-    this->LastUpdateTime = vtkIGSIOAccurateTimer::GetSystemTime();
+    this->LastUpdateTime = PlusClock::GetSystemTime();
   }
   if (this->NextFrameToBeRecordedTimestamp == 0.0)
   {
-    this->NextFrameToBeRecordedTimestamp = vtkIGSIOAccurateTimer::GetSystemTime();
+    this->NextFrameToBeRecordedTimestamp = PlusClock::GetSystemTime();
   }
-  double startTimeSec = vtkIGSIOAccurateTimer::GetSystemTime();
+  double startTimeSec = PlusClock::GetSystemTime();
 
   this->TimeWaited += startTimeSec - LastUpdateTime;
 
@@ -385,8 +385,8 @@ PlusStatus vtkPlusVirtualCapture::InternalUpdate()
   }
 
   // Check whether the recording needed more time than the sampling interval
-  double recordingTimeSec = vtkIGSIOAccurateTimer::GetSystemTime() - startTimeSec;
-  double currentSystemTime = vtkIGSIOAccurateTimer::GetSystemTime();
+  double recordingTimeSec = PlusClock::GetSystemTime() - startTimeSec;
+  double currentSystemTime = PlusClock::GetSystemTime();
   double recordingLagSec =  currentSystemTime - this->NextFrameToBeRecordedTimestamp;
 
   if (recordingTimeSec > samplingPeriodSec)
@@ -410,10 +410,10 @@ PlusStatus vtkPlusVirtualCapture::InternalUpdate()
       // (because acquisitionLagSec < MAX_ALLOWED_RECORDING_LAG_SEC)
       LOG_ERROR("Recording cannot keep up with the acquisition. Skip " << recordingLagSec << " seconds of the data stream to catch up.");
     }
-    this->NextFrameToBeRecordedTimestamp = vtkIGSIOAccurateTimer::GetSystemTime();
+    this->NextFrameToBeRecordedTimestamp = PlusClock::GetSystemTime();
   }
 
-  this->LastUpdateTime = vtkIGSIOAccurateTimer::GetSystemTime();
+  this->LastUpdateTime = PlusClock::GetSystemTime();
 
   return PLUS_SUCCESS;
 }
@@ -490,7 +490,7 @@ void vtkPlusVirtualCapture::SetEnableCapturing(bool aValue)
     this->LastAlreadyRecordedFrameTimestamp = UNDEFINED_TIMESTAMP;
     this->NextFrameToBeRecordedTimestamp = 0.0;
     this->FirstFrameIndexInThisSegment = this->RecordedFrames->GetNumberOfTrackedFrames();
-    this->RecordingStartTime = vtkIGSIOAccurateTimer::GetSystemTime(); // reset the starting time for the grace period
+    this->RecordingStartTime = PlusClock::GetSystemTime(); // reset the starting time for the grace period
   }
 }
 
@@ -519,7 +519,7 @@ PlusStatus vtkPlusVirtualCapture::Reset()
     return PLUS_FAIL;
   }
 
-  this->LastUpdateTime = vtkIGSIOAccurateTimer::GetSystemTime();
+  this->LastUpdateTime = PlusClock::GetSystemTime();
 
   return PLUS_SUCCESS;
 }
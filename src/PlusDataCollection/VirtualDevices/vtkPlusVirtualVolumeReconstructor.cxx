@@ -107,7 +107,7 @@ PlusStatus vtkPlusVirtualVolumeReconstructor::InternalConnect()
     LOG_WARNING("vtkPlusVirtualVolumeReconstructor acquisition rate is not known");
   }
 
-  m_LastUpdateTime = vtkIGSIOAccurateTimer::GetSystemTime();
+  m_LastUpdateTime = PlusClock::GetSystemTime();
 
   return PLUS_SUCCESS;
 }
@@ -130,13 +130,13 @@ PlusStatus vtkPlusVirtualVolumeReconstructor::InternalUpdate()
 
   if (m_LastUpdateTime == 0.0)
   {
-    m_LastUpdateTime = vtkIGSIOAccurateTimer::GetSystemTime();
+    m_LastUpdateTime = PlusClock::GetSystemTime();
   }
   if (m_NextFrameToBeRecordedTimestamp == 0.0)
   {
-    m_NextFrameToBeRecordedTimestamp = vtkIGSIOAccurateTimer::GetSystemTime();
+    m_NextFrameToBeRecordedTimestamp = PlusClock::GetSystemTime();
   }
-  double startTimeSec = vtkIGSIOAccurateTimer::GetSystemTime();
+  double startTimeSec = PlusClock::GetSystemTime();
 
   m_TimeWaited += startTimeSec - m_LastUpdateTime;
 
@@ -195,20 +195,20 @@ PlusStatus vtkPlusVirtualVolumeReconstructor::InternalUpdate()
   this->TotalFramesRecorded += nbFramesRecorded;
 
   // Check whether the reconstruction needed more time than the sampling interval
-  double recordingTimeSec = vtkIGSIOAccurateTimer::GetSystemTime() - startTimeSec;
+  double recordingTimeSec = PlusClock::GetSystemTime() - startTimeSec;
   if (recordingTimeSec > GetSamplingPeriodSec())
   {
     LOG_WARNING("Volume reconstruction of the acquired " << nbFramesRecorded << " frames takes too long time (" << recordingTimeSec << "sec instead of the allocated " << GetSamplingPeriodSec() << "sec). This can cause slow-down of the application and non-uniform sampling. Reduce the image acquisition rate, output size, or image clip rectangle size to resolve the problem.");
   }
-  double recordingLagSec = vtkIGSIOAccurateTimer::GetSystemTime() - m_NextFrameToBeRecordedTimestamp;
+  double recordingLagSec = PlusClock::GetSystemTime() - m_NextFrameToBeRecordedTimestamp;
 
   if (recordingLagSec > MAX_ALLOWED_RECONSTRUCTION_LAG_SEC)
   {
     LOG_ERROR("Volume reconstruction cannot keep up with the acquisition. Skip " << recordingLagSec << " seconds of the data stream to catch up.");
-    m_NextFrameToBeRecordedTimestamp = vtkIGSIOAccurateTimer::GetSystemTime();
+    m_NextFrameToBeRecordedTimestamp = PlusClock::GetSystemTime();
   }
 
-  m_LastUpdateTime = vtkIGSIOAccurateTimer::GetSystemTime();
+  m_LastUpdateTime = PlusClock::GetSystemTime();
 
   return PLUS_SUCCESS;
 }
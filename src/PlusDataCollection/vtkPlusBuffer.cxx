@@ -6,27 +6,39 @@ See License.txt for details.
 
 // Local includes
 #include "PlusConfigure.h"
+#include "PlusBufferSpillFile.h"
+#include "PlusFrameArena.h"
 #include "igsioMath.h"
 #include "igsioTrackedFrame.h"
 #include "vtkPlusBuffer.h"
+#include "vtkPlusConfig.h"
 #include "vtkPlusDevice.h"
 #include "vtkPlusSequenceIO.h"
+#include "vtkIGSIOAccurateTimer.h"
 #include "vtkIGSIOTrackedFrameList.h"
+#include "vtkIGSIORecursiveCriticalSection.h"
 
 // VTK includes
+#include <vtkDataArray.h>
 #include <vtkDoubleArray.h>
 #include <vtkImageData.h>
 #include <vtkIntArray.h>
 #include <vtkMath.h>
 #include <vtkMatrix4x4.h>
 #include <vtkObjectFactory.h>
+#include <vtkPointData.h>
 #include <vtkUnsignedLongLongArray.h>
 
 // vtkAddon includes
 #include <vtkStreamingVolumeCodec.h>
 
+// STL includes
+#include <algorithm>
+#include <cfloat>
+
 static const double NEGLIGIBLE_TIME_DIFFERENCE = 0.00001; // in seconds, used for comparing between exact timestamps
 static const double ANGLE_INTERPOLATION_WARNING_THRESHOLD_DEG = 10; // if the interpolated orientation differs from both the interpolated orientation by more than this threshold then display a warning
+static const double SPILL_WRITER_PERIOD_SEC = 0.01; // period of checking for items that have to be written to the spill file
 
 vtkStandardNewMacro(vtkPlusBuffer);
 
@@ -84,6 +96,21 @@ vtkPlusBuffer::vtkPlusBuffer()
   , StreamBuffer(vtkPlusTimestampedCircularBuffer::New())
   , MaxAllowedTimeDifference(0.5)
   , DescriptiveName(NULL)
+  , UseHugePages(false)
+  , LockFrameMemory(false)
+  , LazyImageOrientation(false)
+  , NextUidToSpill(0)
+  , HasSpilledItems(false)
+  , SpillWriterThreader(vtkSmartPointer<vtkMultiThreader>::New())
+  , SpillWriterThreadId(-1)
+  , SpillWriterThreadActive(false)
+  , SpillWriterThreadAlive(false)
+  , ItemAddedCallbacksMutex(vtkIGSIORecursiveCriticalSection::New())
+  , NextItemAddedCallbackId(1)
+  , NumberOfItemAddedCallbackInvocations(0)
+  , NumberOfItemAddedCallbacks(0)
+  , OldestRequestedTimestamp(DBL_MAX)
+  , NumberOfItemsNotAvailableAnymore(0)
 {
   this->FrameSize[0] = 0;
   this->FrameSize[1] = 0;
@@ -98,11 +125,13 @@ vtkPlusBuffer::vtkPlusBuffer()
 //----------------------------------------------------------------------------
 vtkPlusBuffer::~vtkPlusBuffer()
 {
+  this->StopSpillWriterThread();
   if (this->StreamBuffer != NULL)
   {
     this->StreamBuffer->Delete();
     this->StreamBuffer = NULL;
   }
+  DELETE_IF_NOT_NULL(this->ItemAddedCallbacksMutex);
 }
 
 //----------------------------------------------------------------------------
@@ -112,7 +141,13 @@ void vtkPlusBuffer::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "Frame size in pixel: " << this->GetFrameSize()[0] << "   " << this->GetFrameSize()[1] << "   " << this->GetFrameSize()[2] << std::endl;
   os << indent << "Scalar pixel type: " << vtkImageScalarTypeNameMacro(this->GetPixelType()) << std::endl;
   os << indent << "Image type: " << igsioVideoFrame::GetStringFromUsImageType(this->GetImageType()) << std::endl;
-  os << indent << "Image orientation: " << igsioVideoFrame::GetStringFromUsImageOrientation(this->GetImageOrientation()) << std::endl;
+  os << indent << "Image orientation: " << igsioVideoFrame::GetStringFromUsImageOrientation(this->GetImageOrientation())
+     << (this->LazyImageOrientation ? " (lazy)" : "") << std::endl;
+  if (this->FrameArena)
+  {
+    os << indent << "Frame arena: " << this->FrameArena->GetNumberOfSlots() << " slots of " << this->FrameArena->GetSlotSizeBytes() << " bytes"
+       << (this->FrameArena->GetUseHugePages() ? " (huge pages)" : "") << std::endl;
+  }
 
   os << indent << "StreamBuffer: " << this->StreamBuffer << "\n";
   if (this->StreamBuffer)
@@ -124,23 +159,264 @@ void vtkPlusBuffer::PrintSelf(ostream& os, vtkIndent indent)
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusBuffer::AllocateMemoryForFrames()
 {
+  if (this->StreamBuffer->GetCompactTransformStorage())
+  {
+    // items have no frames
+    igsioLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
+    this->SetFrameArena(std::shared_ptr<PlusFrameArena>());
+    return PLUS_SUCCESS;
+  }
+
+  // The new arena is allocated and pre-faulted before locking the buffer, so adding items is not blocked meanwhile.
+  // The frames are switched to the new arena while the buffer is locked, so readers never see a partially updated buffer.
+  std::shared_ptr<PlusFrameArena> frameArena = this->PrepareFrameArena(this->StreamBuffer->GetBufferSize());
+
   igsioLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
   PlusStatus result = PLUS_SUCCESS;
+  this->SetFrameArena(frameArena);
 
   for (int i = 0; i < this->StreamBuffer->GetBufferSize(); ++i)
   {
-    if (!this->StreamBuffer->GetBufferItemPointerFromBufferIndex(i)->GetFrame().IsFrameEncoded())
+    // Items that are referenced by views must not be reallocated, a copy of them is moved to the new arena
+    bool itemReplaced(false);
+    StreamBufferItemView replacedItem;
+    StreamBufferItem* item = this->StreamBuffer->GetWritableBufferItemPointerFromBufferIndex(i, itemReplaced, &replacedItem, true);
+    if (itemReplaced)
     {
-      if (this->StreamBuffer->GetBufferItemPointerFromBufferIndex(i)->GetFrame().AllocateFrame(this->GetFrameSize(), this->GetPixelType(), this->GetNumberOfScalarComponents()) != PLUS_SUCCESS)
-      {
-        LOCAL_LOG_ERROR("Failed to allocate memory for frame " << i);
-        result = PLUS_FAIL;
-      }
+      this->SetArenaSlotUser(i, replacedItem);
+    }
+    if (this->SetUpFrameMemory(item, i, true) != PLUS_SUCCESS)
+    {
+      result = PLUS_FAIL;
     }
   }
   return result;
 }
 
+//----------------------------------------------------------------------------
+std::shared_ptr<PlusFrameArena> vtkPlusBuffer::PrepareFrameArena(int bufferSize)
+{
+  size_t frameSizeBytes = static_cast<size_t>(this->FrameSize[0]) * this->FrameSize[1] * this->FrameSize[2] * this->GetNumberOfBytesPerPixel();
+  if (this->StreamBuffer->GetCompactTransformStorage() || frameSizeBytes == 0 || bufferSize <= 0)
+  {
+    return std::shared_ptr<PlusFrameArena>();
+  }
+
+  std::shared_ptr<PlusFrameArena> currentFrameArena = this->FrameArena;
+  if (currentFrameArena
+      && currentFrameArena->GetSlotSizeBytes() == frameSizeBytes
+      && currentFrameArena->GetNumberOfSlots() == bufferSize
+      && currentFrameArena->GetUseHugePages() == this->UseHugePages)
+  {
+    // no change
+    return currentFrameArena;
+  }
+
+  std::shared_ptr<PlusFrameArena> frameArena = std::make_shared<PlusFrameArena>();
+  if (frameArena->Allocate(frameSizeBytes, bufferSize, this->UseHugePages) != PLUS_SUCCESS)
+  {
+    LOCAL_LOG_WARNING("Failed to allocate frame arena, memory is allocated for each frame separately");
+    frameArena.reset();
+  }
+  else if (this->LockFrameMemory)
+  {
+    // Failure is already logged, the arena is still usable
+    frameArena->SetPagesLocked(true);
+  }
+  return frameArena;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusBuffer::SetUpFrameMemory(StreamBufferItem* item, int bufferIndex, bool keepContent)
+{
+  // the caller must have locked the buffer
+  if (item->GetFrame().IsFrameEncoded())
+  {
+    return PLUS_SUCCESS;
+  }
+  if (this->FrameArena && !this->IsArenaSlotInUse(bufferIndex))
+  {
+    // The frame memory is the arena slot, it is not allocated separately
+    if (this->BindFrameToArena(item, bufferIndex, keepContent) != PLUS_SUCCESS)
+    {
+      LOCAL_LOG_ERROR("Failed to use frame arena memory for frame " << bufferIndex);
+      return PLUS_FAIL;
+    }
+    return PLUS_SUCCESS;
+  }
+  if (item->GetFrame().AllocateFrame(this->GetFrameSize(), this->GetPixelType(), this->GetNumberOfScalarComponents()) != PLUS_SUCCESS)
+  {
+    LOCAL_LOG_ERROR("Failed to allocate memory for frame " << bufferIndex);
+    return PLUS_FAIL;
+  }
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusBuffer::BindFrameToArena(StreamBufferItem* item, int slotIndex, bool keepContent /*= true*/)
+{
+  // the caller must have locked the buffer
+  unsigned char* slotPointer = this->FrameArena->GetSlotPointer(slotIndex);
+  vtkImageData* image = item->GetFrame().GetImage();
+  if (slotPointer == NULL || image == NULL)
+  {
+    return PLUS_FAIL;
+  }
+
+  FrameSizeType frameSize = this->GetFrameSize();
+  vtkIdType numberOfValues = static_cast<vtkIdType>(frameSize[0]) * frameSize[1] * frameSize[2] * this->GetNumberOfScalarComponents();
+  size_t frameSizeBytes = static_cast<size_t>(frameSize[0]) * frameSize[1] * frameSize[2] * this->GetNumberOfBytesPerPixel();
+  if (frameSizeBytes > this->FrameArena->GetSlotSizeBytes())
+  {
+    LOCAL_LOG_ERROR("Frame size (" << frameSizeBytes << " bytes) is larger than the frame arena slot size (" << this->FrameArena->GetSlotSizeBytes() << " bytes)");
+    return PLUS_FAIL;
+  }
+
+  vtkDataArray* scalars = image->GetPointData()->GetScalars();
+  if (scalars == NULL
+      || scalars->GetDataType() != this->GetPixelType()
+      || scalars->GetNumberOfComponents() != static_cast<int>(this->GetNumberOfScalarComponents())
+      || scalars->GetNumberOfTuples() * scalars->GetNumberOfComponents() != numberOfValues)
+  {
+    // The frame has no pixel data in the buffer frame format yet, set up the image in the arena slot
+    vtkSmartPointer<vtkDataArray> slotScalars = vtkSmartPointer<vtkDataArray>::Take(vtkDataArray::CreateDataArray(this->GetPixelType()));
+    if (slotScalars == NULL)
+    {
+      LOCAL_LOG_ERROR("Unable to create pixel data array for frame arena slot " << slotIndex);
+      return PLUS_FAIL;
+    }
+    slotScalars->SetNumberOfComponents(this->GetNumberOfScalarComponents());
+    // The arena owns the memory, the array must not free it
+    slotScalars->SetVoidArray(slotPointer, numberOfValues, 1);
+    image->SetExtent(0, static_cast<int>(frameSize[0]) - 1, 0, static_cast<int>(frameSize[1]) - 1, 0, static_cast<int>(frameSize[2]) - 1);
+    image->GetPointData()->SetScalars(slotScalars);
+    image->Modified();
+  }
+  else if (scalars->GetVoidPointer(0) != slotPointer)
+  {
+    if (keepContent)
+    {
+      // Keep the current content of the frame (the frame format may be changed while the buffer contains data)
+      memcpy(slotPointer, scalars->GetVoidPointer(0), frameSizeBytes);
+    }
+    // The arena owns the memory, the array must not free it
+    scalars->SetVoidArray(slotPointer, numberOfValues, 1);
+    scalars->Modified();
+  }
+  item->SetFrameArena(this->FrameArena);
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+StreamBufferItem* vtkPlusBuffer::GetWritableBufferItem(int bufferIndex)
+{
+  // the caller must have locked the buffer
+  if (!this->ReorientedItems.empty() && this->StreamBuffer->GetBufferItemPointerFromBufferIndex(bufferIndex) != NULL)
+  {
+    // The item in the slot and all older items are not in the buffer anymore, so their reoriented copies are not needed.
+    // This keeps the number of copies below the buffer size.
+    BufferItemUidType overwrittenUid = this->StreamBuffer->GetBufferItemPointerFromBufferIndex(bufferIndex)->GetUid();
+    this->ReorientedItems.erase(this->ReorientedItems.begin(), this->ReorientedItems.upper_bound(overwrittenUid));
+  }
+  bool itemReplaced(false);
+  StreamBufferItemView replacedItem;
+  StreamBufferItem* item = this->StreamBuffer->GetWritableBufferItemPointerFromBufferIndex(bufferIndex, itemReplaced, &replacedItem);
+  if (item == NULL)
+  {
+    return NULL;
+  }
+  if (itemReplaced)
+  {
+    this->SetArenaSlotUser(bufferIndex, replacedItem);
+    replacedItem.reset();
+  }
+
+  if (this->FrameArena && item->GetFrameArena() != this->FrameArena && !item->GetFrame().IsFrameEncoded() && !this->IsArenaSlotInUse(bufferIndex))
+  {
+    // The frame does not use the arena slot: the buffer has been resized since the item was written, or the item was written
+    // while the slot was used by a replaced item that has been released since then.
+    // Move it to the arena slot, without copying the content, because the new item overwrites it.
+    if (this->BindFrameToArena(item, bufferIndex, false) != PLUS_SUCCESS)
+    {
+      LOCAL_LOG_ERROR("Failed to use frame arena memory for frame " << bufferIndex);
+      return NULL;
+    }
+  }
+  else if (itemReplaced)
+  {
+    // The previous item is still referenced by a view and it still uses the arena slot, the new item needs its own frame memory.
+    // The memory is only allocated once: the item keeps using it while the slot is in use.
+    if (item->GetFrame().AllocateFrame(this->GetFrameSize(), this->GetPixelType(), this->GetNumberOfScalarComponents()) != PLUS_SUCCESS)
+    {
+      LOCAL_LOG_ERROR("Failed to allocate memory for frame " << bufferIndex);
+      return NULL;
+    }
+  }
+  if (itemReplaced)
+  {
+    item->GetFrame().SetImageOrientation(this->ImageOrientation);
+  }
+  return item;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusBuffer::SetFrameArena(const std::shared_ptr<PlusFrameArena>& frameArena)
+{
+  // the caller must have locked the buffer
+  if (frameArena == this->FrameArena)
+  {
+    return;
+  }
+  this->FrameArena = frameArena;
+  this->ArenaSlotUsers.clear();
+  if (this->FrameArena)
+  {
+    this->ArenaSlotUsers.resize(this->FrameArena->GetNumberOfSlots());
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusBuffer::SetArenaSlotUser(int slotIndex, const StreamBufferItemView& replacedItem)
+{
+  // the caller must have locked the buffer
+  if (!replacedItem || !this->FrameArena || replacedItem->GetFrameArena() != this->FrameArena
+      || slotIndex < 0 || slotIndex >= static_cast<int>(this->ArenaSlotUsers.size()))
+  {
+    // the replaced item does not use a slot of the current arena
+    return;
+  }
+  this->ArenaSlotUsers[slotIndex] = replacedItem;
+}
+
+//----------------------------------------------------------------------------
+bool vtkPlusBuffer::IsArenaSlotInUse(int slotIndex) const
+{
+  // the caller must have locked the buffer
+  if (slotIndex < 0 || slotIndex >= static_cast<int>(this->ArenaSlotUsers.size()))
+  {
+    return false;
+  }
+  return !this->ArenaSlotUsers[slotIndex].expired();
+}
+
+//----------------------------------------------------------------------------
+const PlusFrameFieldStore* vtkPlusBuffer::GetPreviousItemFrameFields(int bufferIndex, BufferItemUidType itemUid)
+{
+  // the caller must have locked the buffer
+  if (itemUid <= this->StreamBuffer->GetOldestItemUidInBuffer())
+  {
+    // the previous item has been overwritten already (or there was no previous item)
+    return NULL;
+  }
+  int previousBufferIndex = (bufferIndex > 0 ? bufferIndex : this->StreamBuffer->GetBufferSize()) - 1;
+  const StreamBufferItem* previousItem = this->StreamBuffer->GetBufferItemPointerFromBufferIndex(previousBufferIndex);
+  if (previousItem == NULL)
+  {
+    return NULL;
+  }
+  return &(previousItem->GetFrameFieldStore());
+}
+
 //----------------------------------------------------------------------------
 void vtkPlusBuffer::SetLocalTimeOffsetSec(double offsetSec)
 {
@@ -173,14 +449,41 @@ PlusStatus vtkPlusBuffer::SetBufferSize(int bufsize)
     return PLUS_SUCCESS;
   }
 
-  PlusStatus result = PLUS_SUCCESS;
+  // The arena for the new size is allocated and pre-faulted before locking the buffer, so adding items is not blocked meanwhile
+  std::shared_ptr<PlusFrameArena> frameArena = this->PrepareFrameArena(bufsize);
+
+  // The buffer is resized and the new slots are set up in one lock scope, so other threads never see slots without frame memory.
+  // Existing frames are not copied: they keep the memory of the previous arena (they hold a reference to it)
+  // and they are moved to the new arena when they are overwritten (see GetWritableBufferItem).
+  igsioLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
   if (this->StreamBuffer->SetBufferSize(bufsize) != PLUS_SUCCESS)
   {
-    result = PLUS_FAIL;
+    return PLUS_FAIL;
+  }
+  this->SetFrameArena(frameArena);
+  if (this->StreamBuffer->GetCompactTransformStorage())
+  {
+    // items have no frames
+    return PLUS_SUCCESS;
   }
-  if (this->AllocateMemoryForFrames() != PLUS_SUCCESS)
+
+  PlusStatus result = PLUS_SUCCESS;
+  for (int i = 0; i < this->StreamBuffer->GetBufferSize(); ++i)
   {
-    return PLUS_FAIL;
+    const StreamBufferItem* existingItem = this->StreamBuffer->GetBufferItemPointerFromBufferIndex(i);
+    if (existingItem == NULL || existingItem->GetFrameArena() || existingItem->GetFrame().GetImage() == NULL
+        || existingItem->GetFrame().GetImage()->GetPointData()->GetScalars() != NULL)
+    {
+      // the item already has frame memory
+      continue;
+    }
+    // new slots are not referenced by views, so the item is not replaced
+    bool itemReplaced(false);
+    StreamBufferItem* item = this->StreamBuffer->GetWritableBufferItemPointerFromBufferIndex(i, itemReplaced);
+    if (this->SetUpFrameMemory(item, i, false) != PLUS_SUCCESS)
+    {
+      result = PLUS_FAIL;
+    }
   }
 
   return result;
@@ -325,10 +628,15 @@ PlusStatus vtkPlusBuffer::AddItem(const igsioFieldMapType& fields,
   {
     return PLUS_SUCCESS;
   }
+  if (this->StreamBuffer->GetCompactTransformStorage())
+  {
+    LOCAL_LOG_ERROR("Unable to add field data item to the buffer: the buffer uses compact transform storage, it can only store transforms");
+    return PLUS_FAIL;
+  }
 
   if (unfilteredTimestamp == UNDEFINED_TIMESTAMP)
   {
-    unfilteredTimestamp = vtkIGSIOAccurateTimer::GetSystemTime();
+    unfilteredTimestamp = PlusClock::GetSystemTime();
   }
   if (filteredTimestamp == UNDEFINED_TIMESTAMP)
   {
@@ -352,6 +660,8 @@ PlusStatus vtkPlusBuffer::AddItem(const igsioFieldMapType& fields,
   int bufferIndex(0);
   BufferItemUidType itemUid;
 
+  // Declared before the lock guard, so that the callbacks are invoked after the buffer is unlocked
+  ItemAddedNotification itemAddedNotification(this);
   igsioLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
   if (this->StreamBuffer->PrepareForNewItem(filteredTimestamp, itemUid, bufferIndex) != PLUS_SUCCESS)
   {
@@ -361,7 +671,7 @@ PlusStatus vtkPlusBuffer::AddItem(const igsioFieldMapType& fields,
   }
 
   // get the pointer to the correct location in the tracker buffer, where this data needs to be copied
-  StreamBufferItem* newObjectInBuffer = this->StreamBuffer->GetBufferItemPointerFromBufferIndex(bufferIndex);
+  StreamBufferItem* newObjectInBuffer = this->GetWritableBufferItem(bufferIndex);
   if (newObjectInBuffer == NULL)
   {
     LOCAL_LOG_ERROR("vtkPlusBuffer: Failed to get pointer to data buffer object from the tracker buffer for the new frame!");
@@ -374,12 +684,16 @@ PlusStatus vtkPlusBuffer::AddItem(const igsioFieldMapType& fields,
   newObjectInBuffer->SetUid(itemUid);
 
   // Add custom fields
+  const PlusFrameFieldStore* previousFields = this->GetPreviousItemFrameFields(bufferIndex, itemUid);
   for (igsioFieldMapType::const_iterator it = fields.begin(); it != fields.end(); ++it)
   {
-    newObjectInBuffer->SetFrameField(it->first, it->second.second, it->second.first);
-    std::string name(it->first);
+    newObjectInBuffer->SetFrameField(it->first, it->second.second, it->second.first, previousFields);
   }
 
+  // The item is complete, subscribers can retrieve it as soon as the buffer is unlocked
+  this->CommitLatencyHistogram.RecordLatency(PlusClock::GetSystemTime() - unfilteredTimestamp);
+  itemAddedNotification.SetItem(itemUid, filteredTimestamp);
+
   return PLUS_SUCCESS;
 }
 
@@ -399,9 +713,87 @@ PlusStatus vtkPlusBuffer::AddItem(void* imageDataPtr,
                                   const igsioFieldMapType* customFields /*= NULL */,
                                   vtkStreamingVolumeFrame* encodedFrame /*=NULL*/)
 {
+  return this->AddImageItem(imageDataPtr, PixelCodec::PixelEncoding_ERROR, usImageOrientation, inputFrameSizeInPx, pixelType, numberOfScalarComponents, imageType,
+                            numberOfBytesToSkip, frameNumber, clipRectangleOrigin, clipRectangleSize, unfilteredTimestamp, filteredTimestamp, customFields, encodedFrame);
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusBuffer::AddItem(void* imageDataPtr,
+                                  PixelCodec::PixelEncoding inputEncoding,
+                                  US_IMAGE_ORIENTATION usImageOrientation,
+                                  const FrameSizeType& inputFrameSizeInPx,
+                                  long frameNumber,
+                                  const std::array<int, 3>& clipRectangleOrigin,
+                                  const std::array<int, 3>& clipRectangleSize,
+                                  double unfilteredTimestamp /*= UNDEFINED_TIMESTAMP*/,
+                                  double filteredTimestamp /*= UNDEFINED_TIMESTAMP*/,
+                                  const igsioFieldMapType* customFields /*= NULL */)
+{
+  const int numberOfScalarComponents = this->GetNumberOfScalarComponents();
+  if (this->GetPixelType() != VTK_UNSIGNED_CHAR || !PixelCodec::IsConvertAndFlipSupported(inputEncoding, numberOfScalarComponents))
+  {
+    LOCAL_LOG_ERROR("Unable to add frame to the buffer: conversion from " << PixelCodec::GetCompressionModeAsString(inputEncoding)
+                    << " to the pixel format of the buffer (" << vtkImageScalarTypeNameMacro(this->GetPixelType()) << ", "
+                    << numberOfScalarComponents << " components) is not supported");
+    return PLUS_FAIL;
+  }
+  if (imageDataPtr == NULL)
+  {
+    LOG_ERROR("vtkPlusBuffer: Unable to add NULL frame to video buffer!");
+    return PLUS_FAIL;
+  }
+  US_IMAGE_TYPE imageType = (numberOfScalarComponents == 1 ? US_IMG_BRIGHTNESS : US_IMG_RGB_COLOR);
+
+  igsioVideoFrame::FlipInfoType flipInfo;
+  if (igsioVideoFrame::GetFlipAxes(usImageOrientation, imageType, this->ImageOrientation, flipInfo) == PLUS_SUCCESS
+      && flipInfo.tranpose == igsioVideoFrame::TRANSPOSE_NONE
+      && !igsioCommon::IsClippingRequested(clipRectangleOrigin, clipRectangleSize))
+  {
+    // Convert, reorient and copy in one pass
+    return this->AddImageItem(imageDataPtr, inputEncoding, usImageOrientation, inputFrameSizeInPx, VTK_UNSIGNED_CHAR, numberOfScalarComponents, imageType,
+                              0, frameNumber, clipRectangleOrigin, clipRectangleSize, unfilteredTimestamp, filteredTimestamp, customFields, NULL);
+  }
+
+  // Transposing or clipping is needed (or the orientation is invalid, which is reported by AddImageItem),
+  // convert the pixels first and then use the general reorienting and clipping
+  std::lock_guard<std::mutex> conversionScratchLock(this->ConversionScratchMutex);
+  this->ConversionScratch.resize(static_cast<size_t>(inputFrameSizeInPx[0]) * inputFrameSizeInPx[1] * inputFrameSizeInPx[2] * numberOfScalarComponents);
+  if (PixelCodec::ConvertAndFlip(inputEncoding, numberOfScalarComponents, inputFrameSizeInPx[0], inputFrameSizeInPx[1], inputFrameSizeInPx[2],
+                                 false, false, false, reinterpret_cast<unsigned char*>(imageDataPtr), this->ConversionScratch.data()) != PLUS_SUCCESS)
+  {
+    LOCAL_LOG_ERROR("Failed to convert the frame from " << PixelCodec::GetCompressionModeAsString(inputEncoding));
+    return PLUS_FAIL;
+  }
+  return this->AddImageItem(this->ConversionScratch.data(), PixelCodec::PixelEncoding_ERROR, usImageOrientation, inputFrameSizeInPx, VTK_UNSIGNED_CHAR, numberOfScalarComponents, imageType,
+                            0, frameNumber, clipRectangleOrigin, clipRectangleSize, unfilteredTimestamp, filteredTimestamp, customFields, NULL);
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusBuffer::AddImageItem(void* imageDataPtr,
+                                       PixelCodec::PixelEncoding inputEncoding,
+                                       US_IMAGE_ORIENTATION usImageOrientation,
+                                       const FrameSizeType& inputFrameSizeInPx,
+                                       igsioCommon::VTKScalarPixelType pixelType,
+                                       unsigned int numberOfScalarComponents,
+                                       US_IMAGE_TYPE imageType,
+                                       int numberOfBytesToSkip,
+                                       long frameNumber,
+                                       const std::array<int, 3>& clipRectangleOrigin,
+                                       const std::array<int, 3>& clipRectangleSize,
+                                       double unfilteredTimestamp,
+                                       double filteredTimestamp,
+                                       const igsioFieldMapType* customFields,
+                                       vtkStreamingVolumeFrame* encodedFrame)
+{
+  if (this->StreamBuffer->GetCompactTransformStorage())
+  {
+    LOCAL_LOG_ERROR("Unable to add video frame to the buffer: the buffer uses compact transform storage, it can only store transforms");
+    return PLUS_FAIL;
+  }
+
   if (unfilteredTimestamp == UNDEFINED_TIMESTAMP)
   {
-    unfilteredTimestamp = vtkIGSIOAccurateTimer::GetSystemTime();
+    unfilteredTimestamp = PlusClock::GetSystemTime();
   }
 
   if (filteredTimestamp == UNDEFINED_TIMESTAMP)
@@ -438,6 +830,17 @@ PlusStatus vtkPlusBuffer::AddItem(void* imageDataPtr,
     return PLUS_FAIL;
   }
 
+  // Frames that only need flipping are stored as they are, they are reoriented when they are retrieved
+  US_IMAGE_ORIENTATION storedImageOrientation = this->ImageOrientation;
+  if (this->LazyImageOrientation && encodedFrame == NULL && flipInfo.tranpose == igsioVideoFrame::TRANSPOSE_NONE
+      && (flipInfo.hFlip || flipInfo.vFlip || flipInfo.eFlip))
+  {
+    storedImageOrientation = usImageOrientation;
+    flipInfo.hFlip = false;
+    flipInfo.vFlip = false;
+    flipInfo.eFlip = false;
+  }
+
   // Calculate the output frame size to validate that buffer is correctly setup
   FrameSizeType outputFrameSizeInPx = { inputFrameSizeInPx[0], inputFrameSizeInPx[1], inputFrameSizeInPx[2] };
   if (igsioCommon::IsClippingRequested(clipRectangleOrigin, clipRectangleSize))
@@ -463,6 +866,8 @@ PlusStatus vtkPlusBuffer::AddItem(void* imageDataPtr,
 
   int bufferIndex(0);
   BufferItemUidType itemUid;
+  // Declared before the lock guard, so that the callbacks are invoked after the buffer is unlocked
+  ItemAddedNotification itemAddedNotification(this);
   igsioLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
   if (this->StreamBuffer->PrepareForNewItem(filteredTimestamp, itemUid, bufferIndex) != PLUS_SUCCESS)
   {
@@ -472,7 +877,7 @@ PlusStatus vtkPlusBuffer::AddItem(void* imageDataPtr,
   }
 
   // get the pointer to the correct location in the frame buffer, where this data needs to be copied
-  StreamBufferItem* newObjectInBuffer = this->StreamBuffer->GetBufferItemPointerFromBufferIndex(bufferIndex);
+  StreamBufferItem* newObjectInBuffer = this->GetWritableBufferItem(bufferIndex);
   if (newObjectInBuffer == NULL)
   {
     LOCAL_LOG_ERROR("vtkPlusBuffer: Failed to get pointer to video buffer object from the video buffer for the new frame!");
@@ -500,7 +905,18 @@ PlusStatus vtkPlusBuffer::AddItem(void* imageDataPtr,
     unsigned char* byteImageDataPtr = reinterpret_cast<unsigned char*>(imageDataPtr);
     byteImageDataPtr += numberOfBytesToSkip;
 
-    if (igsioVideoFrame::GetOrientedClippedImage(byteImageDataPtr, flipInfo, imageType, pixelType, numberOfScalarComponents, inputFrameSizeInPx, newObjectInBuffer->GetFrame(), clipRectangleOrigin, clipRectangleSize) != PLUS_SUCCESS)
+    if (inputEncoding != PixelCodec::PixelEncoding_ERROR)
+    {
+      // Conversion, reorientation and copy into the buffer in a single pass
+      if (PixelCodec::ConvertAndFlip(inputEncoding, numberOfScalarComponents, inputFrameSizeInPx[0], inputFrameSizeInPx[1], inputFrameSizeInPx[2],
+                                     flipInfo.hFlip, flipInfo.vFlip, flipInfo.eFlip, byteImageDataPtr,
+                                     reinterpret_cast<unsigned char*>(newObjectInBuffer->GetFrame().GetScalarPointer())) != PLUS_SUCCESS)
+      {
+        LOCAL_LOG_ERROR("Failed to convert input image from " << PixelCodec::GetCompressionModeAsString(inputEncoding) << " to the buffer pixel format!");
+        return PLUS_FAIL;
+      }
+    }
+    else if (igsioVideoFrame::GetOrientedClippedImage(byteImageDataPtr, flipInfo, imageType, pixelType, numberOfScalarComponents, inputFrameSizeInPx, newObjectInBuffer->GetFrame(), clipRectangleOrigin, clipRectangleSize) != PLUS_SUCCESS)
     {
       LOCAL_LOG_ERROR("Failed to convert input US image to the requested orientation!");
       return PLUS_FAIL;
@@ -516,13 +932,15 @@ PlusStatus vtkPlusBuffer::AddItem(void* imageDataPtr,
   newObjectInBuffer->SetIndex(frameNumber);
   newObjectInBuffer->SetUid(itemUid);
   newObjectInBuffer->GetFrame().SetImageType(imageType);
+  newObjectInBuffer->GetFrame().SetImageOrientation(storedImageOrientation);
 
   // Add custom fields
   if (customFields != NULL)
   {
+    const PlusFrameFieldStore* previousFields = this->GetPreviousItemFrameFields(bufferIndex, itemUid);
     for (igsioFieldMapType::const_iterator it = customFields->begin(); it != customFields->end(); ++it)
     {
-      newObjectInBuffer->SetFrameField(it->first, it->second.second, it->second.first);
+      newObjectInBuffer->SetFrameField(it->first, it->second.second, it->second.first, previousFields);
       std::string name(it->first);
       if (name.find("Transform") != std::string::npos)
       {
@@ -531,15 +949,25 @@ PlusStatus vtkPlusBuffer::AddItem(void* imageDataPtr,
     }
   }
 
+  // The item is complete, subscribers can retrieve it as soon as the buffer is unlocked
+  this->CommitLatencyHistogram.RecordLatency(PlusClock::GetSystemTime() - unfilteredTimestamp);
+  itemAddedNotification.SetItem(itemUid, filteredTimestamp);
+
   return PLUS_SUCCESS;
 }
 
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusBuffer::AddItem(void* imageDataPtr, const FrameSizeType& frameSize, unsigned int inputFrameSizeInBytes, US_IMAGE_TYPE imageType, long frameNumber, double unfilteredTimestamp /*= UNDEFINED_TIMESTAMP*/, double filteredTimestamp /*= UNDEFINED_TIMESTAMP*/, const igsioFieldMapType* customFields /*= NULL*/)
 {
+  if (this->StreamBuffer->GetCompactTransformStorage())
+  {
+    LOCAL_LOG_ERROR("Unable to add video frame to the buffer: the buffer uses compact transform storage, it can only store transforms");
+    return PLUS_FAIL;
+  }
+
   if (unfilteredTimestamp == UNDEFINED_TIMESTAMP)
   {
-    unfilteredTimestamp = vtkIGSIOAccurateTimer::GetSystemTime();
+    unfilteredTimestamp = PlusClock::GetSystemTime();
   }
 
   if (filteredTimestamp == UNDEFINED_TIMESTAMP)
@@ -576,6 +1004,8 @@ PlusStatus vtkPlusBuffer::AddItem(void* imageDataPtr, const FrameSizeType& frame
 
   int bufferIndex(0);
   BufferItemUidType itemUid;
+  // Declared before the lock guard, so that the callbacks are invoked after the buffer is unlocked
+  ItemAddedNotification itemAddedNotification(this);
   igsioLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
   if (this->StreamBuffer->PrepareForNewItem(filteredTimestamp, itemUid, bufferIndex) != PLUS_SUCCESS)
   {
@@ -585,7 +1015,7 @@ PlusStatus vtkPlusBuffer::AddItem(void* imageDataPtr, const FrameSizeType& frame
   }
 
   // get the pointer to the correct location in the frame buffer, where this data needs to be copied
-  StreamBufferItem* newObjectInBuffer = this->StreamBuffer->GetBufferItemPointerFromBufferIndex(bufferIndex);
+  StreamBufferItem* newObjectInBuffer = this->GetWritableBufferItem(bufferIndex);
   if (newObjectInBuffer == NULL)
   {
     LOCAL_LOG_ERROR("vtkPlusBuffer: Failed to get pointer to video buffer object from the video buffer for the new frame!");
@@ -604,14 +1034,16 @@ PlusStatus vtkPlusBuffer::AddItem(void* imageDataPtr, const FrameSizeType& frame
   newObjectInBuffer->SetIndex(frameNumber);
   newObjectInBuffer->SetUid(itemUid);
   newObjectInBuffer->GetFrame().SetImageType(imageType);
+  newObjectInBuffer->GetFrame().SetImageOrientation(this->ImageOrientation);
   memcpy(newObjectInBuffer->GetFrame().GetImage()->GetScalarPointer(), imageDataPtr, inputFrameSizeInBytes);
 
   // Add custom fields
+  const PlusFrameFieldStore* previousFields = this->GetPreviousItemFrameFields(bufferIndex, itemUid);
   if (customFields != NULL)
   {
     for (igsioFieldMapType::const_iterator it = customFields->begin(); it != customFields->end(); ++it)
     {
-      newObjectInBuffer->SetFrameField(it->first, it->second.second, it->second.first);
+      newObjectInBuffer->SetFrameField(it->first, it->second.second, it->second.first, previousFields);
       std::string name(it->first);
       if (name.find("Transform") != std::string::npos)
       {
@@ -620,7 +1052,11 @@ PlusStatus vtkPlusBuffer::AddItem(void* imageDataPtr, const FrameSizeType& frame
     }
   }
 
-  newObjectInBuffer->SetFrameField("FrameSizeInBytes", igsioCommon::ToString<unsigned int>(inputFrameSizeInBytes));
+  newObjectInBuffer->SetFrameField("FrameSizeInBytes", igsioCommon::ToString<unsigned int>(inputFrameSizeInBytes), FRAMEFIELD_NONE, previousFields);
+
+  // The item is complete, subscribers can retrieve it as soon as the buffer is unlocked
+  this->CommitLatencyHistogram.RecordLatency(PlusClock::GetSystemTime() - unfilteredTimestamp);
+  itemAddedNotification.SetItem(itemUid, filteredTimestamp);
 
   return PLUS_SUCCESS;
 }
@@ -635,7 +1071,7 @@ PlusStatus vtkPlusBuffer::AddTimeStampedItem(vtkMatrix4x4* matrix, ToolStatus st
   }
   if (unfilteredTimestamp == UNDEFINED_TIMESTAMP)
   {
-    unfilteredTimestamp = vtkIGSIOAccurateTimer::GetSystemTime();
+    unfilteredTimestamp = PlusClock::GetSystemTime();
   }
   if (filteredTimestamp == UNDEFINED_TIMESTAMP)
   {
@@ -659,6 +1095,8 @@ PlusStatus vtkPlusBuffer::AddTimeStampedItem(vtkMatrix4x4* matrix, ToolStatus st
   int bufferIndex(0);
   BufferItemUidType itemUid;
 
+  // Declared before the lock guard, so that the callbacks are invoked after the buffer is unlocked
+  ItemAddedNotification itemAddedNotification(this);
   igsioLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
   if (this->StreamBuffer->PrepareForNewItem(filteredTimestamp, itemUid, bufferIndex) != PLUS_SUCCESS)
   {
@@ -667,8 +1105,19 @@ PlusStatus vtkPlusBuffer::AddTimeStampedItem(vtkMatrix4x4* matrix, ToolStatus st
     return PLUS_FAIL;
   }
 
+  if (this->StreamBuffer->GetCompactTransformStorage())
+  {
+    PlusStatus itemStatus = this->StreamBuffer->GetTransformSampleStore().SetItem(bufferIndex, matrix, status, frameNumber, itemUid, filteredTimestamp, unfilteredTimestamp, customFields);
+
+    // The item is complete, subscribers can retrieve it as soon as the buffer is unlocked
+    this->CommitLatencyHistogram.RecordLatency(PlusClock::GetSystemTime() - unfilteredTimestamp);
+    itemAddedNotification.SetItem(itemUid, filteredTimestamp);
+
+    return itemStatus;
+  }
+
   // get the pointer to the correct location in the tracker buffer, where this data needs to be copied
-  StreamBufferItem* newObjectInBuffer = this->StreamBuffer->GetBufferItemPointerFromBufferIndex(bufferIndex);
+  StreamBufferItem* newObjectInBuffer = this->GetWritableBufferItem(bufferIndex);
   if (newObjectInBuffer == NULL)
   {
     LOCAL_LOG_ERROR("vtkPlusBuffer: Failed to get pointer to data buffer object from the tracker buffer for the new frame!");
@@ -685,9 +1134,10 @@ PlusStatus vtkPlusBuffer::AddTimeStampedItem(vtkMatrix4x4* matrix, ToolStatus st
   // Add custom fields
   if (customFields != NULL)
   {
+    const PlusFrameFieldStore* previousFields = this->GetPreviousItemFrameFields(bufferIndex, itemUid);
     for (igsioFieldMapType::const_iterator it = customFields->begin(); it != customFields->end(); ++it)
     {
-      newObjectInBuffer->SetFrameField(it->first, it->second.second, it->second.first);
+      newObjectInBuffer->SetFrameField(it->first, it->second.second, it->second.first, previousFields);
       std::string name(it->first);
       if (name.find("Transform") != std::string::npos)
       {
@@ -696,6 +1146,10 @@ PlusStatus vtkPlusBuffer::AddTimeStampedItem(vtkMatrix4x4* matrix, ToolStatus st
     }
   }
 
+  // The item is complete, subscribers can retrieve it as soon as the buffer is unlocked
+  this->CommitLatencyHistogram.RecordLatency(PlusClock::GetSystemTime() - unfilteredTimestamp);
+  itemAddedNotification.SetItem(itemUid, filteredTimestamp);
+
   return itemStatus;
 }
 
@@ -708,92 +1162,695 @@ ItemStatus vtkPlusBuffer::GetLatestTimeStamp(double& latestTimestamp)
 //----------------------------------------------------------------------------
 ItemStatus vtkPlusBuffer::GetOldestTimeStamp(double& oldestTimestamp)
 {
+  if (this->HasSpilledItems)
+  {
+    std::lock_guard<std::mutex> spillFileLock(this->SpillFileMutex);
+    if (this->SpillFile && !this->SpillFile->IsEmpty())
+    {
+      oldestTimestamp = this->SpillFile->GetOldestTimeStamp() + this->StreamBuffer->GetLocalTimeOffsetSec();
+      return ITEM_OK;
+    }
+  }
   return this->StreamBuffer->GetOldestTimeStamp(oldestTimestamp);
 }
 
 //----------------------------------------------------------------------------
 ItemStatus vtkPlusBuffer::GetTimeStamp(BufferItemUidType uid, double& timestamp)
 {
+  if (this->IsItemSpilled(uid))
+  {
+    std::lock_guard<std::mutex> spillFileLock(this->SpillFileMutex);
+    if (!this->SpillFile)
+    {
+      return ITEM_NOT_AVAILABLE_ANYMORE;
+    }
+    ItemStatus status = this->SpillFile->GetTimeStamp(uid, timestamp);
+    timestamp += this->StreamBuffer->GetLocalTimeOffsetSec();
+    return status;
+  }
   return this->StreamBuffer->GetTimeStamp(uid, timestamp);
 }
 
 //----------------------------------------------------------------------------
 ItemStatus vtkPlusBuffer::GetIndex(BufferItemUidType uid, unsigned long& index)
 {
+  if (this->IsItemSpilled(uid))
+  {
+    std::lock_guard<std::mutex> spillFileLock(this->SpillFileMutex);
+    return this->SpillFile ? this->SpillFile->GetIndex(uid, index) : ITEM_NOT_AVAILABLE_ANYMORE;
+  }
   return this->StreamBuffer->GetIndex(uid, index);
 }
 
-
 //----------------------------------------------------------------------------
-ItemStatus vtkPlusBuffer::GetBufferIndexFromTime(const double time, int& bufferIndex)
+BufferItemUidType vtkPlusBuffer::GetOldestItemUidInBuffer()
 {
-  return this->StreamBuffer->GetBufferIndexFromTime(time, bufferIndex);
+  if (this->HasSpilledItems)
+  {
+    std::lock_guard<std::mutex> spillFileLock(this->SpillFileMutex);
+    if (this->SpillFile && !this->SpillFile->IsEmpty())
+    {
+      return std::min(this->SpillFile->GetOldestItemUid(), this->StreamBuffer->GetOldestItemUidInBuffer());
+    }
+  }
+  return this->StreamBuffer->GetOldestItemUidInBuffer();
 }
 
 //----------------------------------------------------------------------------
-void vtkPlusBuffer::SetAveragedItemsForFiltering(int averagedItemsForFiltering)
+ItemStatus vtkPlusBuffer::GetItemUidFromTime(double time, BufferItemUidType& uid)
 {
-  this->StreamBuffer->SetAveragedItemsForFiltering(averagedItemsForFiltering);
+  this->RecordRequestedTime(time);
+  ItemStatus status = this->GetItemUidFromTimeInAnyTier(time, uid);
+  this->RecordRequestStatus(status);
+  return status;
 }
 
 //----------------------------------------------------------------------------
-int vtkPlusBuffer::GetAveragedItemsForFiltering()
+void vtkPlusBuffer::GetItemUidsFromTimes(const double* times, int numberOfTimes, BufferItemUidType* uids, ItemStatus* statuses)
 {
-  return this->StreamBuffer->GetAveragedItemsForFiltering();
+  this->GetItemUidsFromTimesInAnyTier(times, numberOfTimes, uids, statuses);
+  for (int i = 0; i < numberOfTimes; ++i)
+  {
+    this->RecordRequestedTime(times[i]);
+    this->RecordRequestStatus(statuses[i]);
+  }
 }
 
 //----------------------------------------------------------------------------
-void vtkPlusBuffer::SetStartTime(double startTime)
+void vtkPlusBuffer::GetItemUidsFromTimesInAnyTier(const double* times, int numberOfTimes, BufferItemUidType* uids, ItemStatus* statuses)
 {
-  this->StreamBuffer->SetStartTime(startTime);
+  igsioLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
+  this->StreamBuffer->GetItemUidsFromTimes(times, numberOfTimes, uids, statuses);
+  if (!this->HasSpilledItems)
+  {
+    return;
+  }
+  for (int i = 0; i < numberOfTimes; ++i)
+  {
+    if (statuses[i] == ITEM_NOT_AVAILABLE_ANYMORE)
+    {
+      statuses[i] = this->GetItemUidFromTimeInAnyTier(times[i], uids[i]);
+    }
+  }
 }
 
 //----------------------------------------------------------------------------
-double vtkPlusBuffer::GetStartTime()
+ItemStatus vtkPlusBuffer::GetItemUidFromTimeInAnyTier(double time, BufferItemUidType& uid)
 {
-  return this->StreamBuffer->GetStartTime();
+  ItemStatus status = this->StreamBuffer->GetItemUidFromTime(time, uid);
+  if (status != ITEM_NOT_AVAILABLE_ANYMORE || !this->HasSpilledItems)
+  {
+    return status;
+  }
+
+  // The requested time is older than the items in memory, find the closest item in the spill file
+  const double localTimeOffsetSec = this->StreamBuffer->GetLocalTimeOffsetSec();
+  BufferItemUidType spilledItemUid(0);
+  double spilledItemTimestamp(0);
+  {
+    std::lock_guard<std::mutex> spillFileLock(this->SpillFileMutex);
+    if (!this->SpillFile
+        || this->SpillFile->GetItemUidFromTime(time - localTimeOffsetSec, spilledItemUid) != ITEM_OK
+        || this->SpillFile->GetTimeStamp(spilledItemUid, spilledItemTimestamp) != ITEM_OK)
+    {
+      return status;
+    }
+  }
+  spilledItemTimestamp += localTimeOffsetSec;
+
+  // The requested time may be between the latest spilled item and the oldest item in memory
+  double oldestTimestampInMemory(0);
+  if (this->StreamBuffer->GetOldestTimeStamp(oldestTimestampInMemory) == ITEM_OK
+      && fabs(oldestTimestampInMemory - time) < fabs(spilledItemTimestamp - time))
+  {
+    uid = this->StreamBuffer->GetOldestItemUidInBuffer();
+  }
+  else
+  {
+    uid = spilledItemUid;
+  }
+  return ITEM_OK;
 }
 
 //----------------------------------------------------------------------------
-PlusStatus vtkPlusBuffer::GetTimeStampReportTable(vtkTable* timeStampReportTable)
+bool vtkPlusBuffer::IsItemSpilled(BufferItemUidType uid)
 {
-  return this->StreamBuffer->GetTimeStampReportTable(timeStampReportTable);
+  if (!this->HasSpilledItems)
+  {
+    return false;
+  }
+  return uid < this->StreamBuffer->GetOldestItemUidInBuffer();
 }
 
 //----------------------------------------------------------------------------
-ItemStatus vtkPlusBuffer::GetStreamBufferItem(BufferItemUidType uid, StreamBufferItem* bufferItem)
+ItemStatus vtkPlusBuffer::GetSpilledItem(BufferItemUidType uid, StreamBufferItem* bufferItem)
 {
-  if (bufferItem == NULL)
+  std::lock_guard<std::mutex> spillFileLock(this->SpillFileMutex);
+  if (!this->SpillFile)
   {
-    LOCAL_LOG_ERROR("Unable to copy data buffer item into a NULL data buffer item!");
-    return ITEM_UNKNOWN_ERROR;
+    return ITEM_NOT_AVAILABLE_ANYMORE;
+  }
+  ItemStatus itemStatus = this->SpillFile->GetItem(uid, bufferItem);
+  if (itemStatus != ITEM_OK)
+  {
+    return itemStatus;
+  }
+  // Frames are written in the image orientation of the buffer (see SpillPendingItems), they are only reoriented
+  // here if the image orientation of the buffer has been changed since they were written
+  if (this->IsReorientationNeeded(*bufferItem)
+      && ReorientFrame(bufferItem->GetFrame(), this->ImageOrientation, this->PixelType, this->NumberOfScalarComponents, this->SpillReorientationScratch) != PLUS_SUCCESS)
+  {
+    LOCAL_LOG_ERROR("Failed to convert spilled buffer item " << uid << " to " << igsioVideoFrame::GetStringFromUsImageOrientation(this->ImageOrientation) << " orientation");
+    return ITEM_UNKNOWN_ERROR;
+  }
+  return ITEM_OK;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusBuffer::SpillPendingItems()
+{
+  std::lock_guard<std::mutex> spillWriterLock(this->SpillWriterMutex);
+  if (!this->SpillFile)
+  {
+    return;
+  }
+
+  while (true)
+  {
+    // Get the item while the buffer is locked, but write it to the file after the buffer is unlocked,
+    // so that the acquisition thread is not blocked while the item is written
+    BufferItemUidType uid(0);
+    StreamBufferItemView itemView;
+    {
+      igsioLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
+      if (this->StreamBuffer->GetNumberOfItems() < 1)
+      {
+        return;
+      }
+      BufferItemUidType oldestUidInMemory = this->StreamBuffer->GetOldestItemUidInBuffer();
+      if (this->NextUidToSpill < oldestUidInMemory)
+      {
+        if (this->NextUidToSpill > 0)
+        {
+          static vtkIGSIOLogHelper helper(5.f, 5000, vtkPlusLogger::LOG_LEVEL_WARNING);
+          if (helper.ShouldWeLog(true))
+          {
+            LOCAL_LOG_WARNING((oldestUidInMemory - this->NextUidToSpill) << " items were overwritten before they could be written to the spill file");
+          }
+        }
+        this->NextUidToSpill = oldestUidInMemory;
+      }
+      // Items are written when they get to the older half of the buffer, well before they are overwritten,
+      // so that the latest items, which are accessed the most, are not referenced by the writer
+      if (this->NextUidToSpill + this->StreamBuffer->GetBufferSize() / 2 > this->StreamBuffer->GetLatestItemUidInBuffer())
+      {
+        return;
+      }
+      uid = this->NextUidToSpill;
+
+      ItemStatus itemStatus = ITEM_UNKNOWN_ERROR;
+      if (this->StreamBuffer->GetCompactTransformStorage())
+      {
+        int bufferIndex(-1);
+        itemStatus = this->StreamBuffer->GetBufferIndexFromUid(uid, bufferIndex);
+        if (itemStatus == ITEM_OK)
+        {
+          std::shared_ptr<StreamBufferItem> item = std::make_shared<StreamBufferItem>();
+          this->StreamBuffer->GetTransformSampleStore().GetItem(bufferIndex, *item);
+          itemView = item;
+        }
+      }
+      else
+      {
+        itemStatus = this->StreamBuffer->GetBufferItemViewFromUid(uid, itemView);
+        if (itemStatus == ITEM_OK && this->IsReorientationNeeded(*itemView))
+        {
+          // Use the reoriented copy of the item if a reader has already made one
+          std::map<BufferItemUidType, StreamBufferItemView>::iterator reorientedItem = this->ReorientedItems.find(uid);
+          if (reorientedItem != this->ReorientedItems.end())
+          {
+            itemView = reorientedItem->second;
+          }
+        }
+      }
+      if (itemStatus != ITEM_OK)
+      {
+        LOCAL_LOG_ERROR("Unable to get item " << uid << " from the buffer to write it to the spill file");
+        this->NextUidToSpill = uid + 1;
+        continue;
+      }
+    }
+
+    // Frames are written in the image orientation of the buffer, so that they are not reoriented each time they are read
+    const StreamBufferItem* spilledItem = itemView.get();
+    if (this->IsReorientationNeeded(*itemView))
+    {
+      this->SpillWriterReorientedItem = *itemView;
+      if (ReorientFrame(this->SpillWriterReorientedItem.GetFrame(), this->ImageOrientation, this->PixelType, this->NumberOfScalarComponents,
+                        this->SpillWriterReorientationScratch) == PLUS_SUCCESS)
+      {
+        spilledItem = &this->SpillWriterReorientedItem;
+      }
+      else
+      {
+        LOCAL_LOG_ERROR("Failed to convert buffer item " << uid << " to " << igsioVideoFrame::GetStringFromUsImageOrientation(this->ImageOrientation)
+                        << " orientation, it is written to the spill file in its stored orientation");
+      }
+    }
+
+    {
+      std::lock_guard<std::mutex> spillFileLock(this->SpillFileMutex);
+      if (this->SpillFile->AppendItem(spilledItem) == PLUS_SUCCESS)
+      {
+        this->HasSpilledItems = true;
+      }
+    }
+    this->NextUidToSpill = uid + 1;
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusBuffer::StartSpillWriterThread()
+{
+  if (this->SpillWriterThreadAlive)
+  {
+    return;
+  }
+  this->SpillWriterThreadActive = true;
+  this->SpillWriterThreadAlive = true;
+  this->SpillWriterThreadId = this->SpillWriterThreader->SpawnThread((vtkThreadFunctionType)&SpillWriterThread, this);
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusBuffer::StopSpillWriterThread()
+{
+  if (this->SpillWriterThreadId < 0)
+  {
+    return;
+  }
+  this->SpillWriterThreadActive = false;
+  while (this->SpillWriterThreadAlive)
+  {
+    vtkIGSIOAccurateTimer::Delay(SPILL_WRITER_PERIOD_SEC);
+  }
+  this->SpillWriterThreadId = -1;
+}
+
+//----------------------------------------------------------------------------
+void* vtkPlusBuffer::SpillWriterThread(vtkMultiThreader::ThreadInfo* data)
+{
+  vtkPlusBuffer* self = (vtkPlusBuffer*)(data->UserData);
+  while (self->SpillWriterThreadActive)
+  {
+    self->SpillPendingItems();
+    vtkIGSIOAccurateTimer::Delay(SPILL_WRITER_PERIOD_SEC);
+  }
+  self->SpillWriterThreadAlive = false;
+  return NULL;
+}
+
+//----------------------------------------------------------------------------
+ItemStatus vtkPlusBuffer::GetBufferIndexFromTime(const double time, int& bufferIndex)
+{
+  return this->StreamBuffer->GetBufferIndexFromTime(time, bufferIndex);
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusBuffer::SetAveragedItemsForFiltering(int averagedItemsForFiltering)
+{
+  this->StreamBuffer->SetAveragedItemsForFiltering(averagedItemsForFiltering);
+}
+
+//----------------------------------------------------------------------------
+int vtkPlusBuffer::GetAveragedItemsForFiltering()
+{
+  return this->StreamBuffer->GetAveragedItemsForFiltering();
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusBuffer::SetStartTime(double startTime)
+{
+  this->StreamBuffer->SetStartTime(startTime);
+}
+
+//----------------------------------------------------------------------------
+double vtkPlusBuffer::GetStartTime()
+{
+  return this->StreamBuffer->GetStartTime();
+}
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+size_t vtkPlusBuffer::GetItemSizeBytes()
+{
+  if (this->StreamBuffer->GetCompactTransformStorage())
+  {
+    return PlusTransformSampleStore::GetSlotSizeBytes();
+  }
+
+  // item object and its matrix
+  size_t itemSizeBytes = sizeof(StreamBufferItem) + 16 * sizeof(double);
+
+  igsioLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
+  if (this->FrameArena)
+  {
+    itemSizeBytes += this->FrameArena->GetSlotStrideBytes();
+  }
+  else
+  {
+    itemSizeBytes += static_cast<size_t>(this->FrameSize[0]) * this->FrameSize[1] * this->FrameSize[2] * this->GetNumberOfBytesPerPixel();
+  }
+  return itemSizeBytes;
+}
+
+//----------------------------------------------------------------------------
+size_t vtkPlusBuffer::GetMemoryUsageBytes()
+{
+  return this->GetItemSizeBytes() * static_cast<size_t>(this->GetBufferSize());
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusBuffer::GetConsumerLag(double& lagSec, int& numberOfItemsNotAvailableAnymore, bool reset)
+{
+  double oldestRequestedTimestamp = reset ? this->OldestRequestedTimestamp.exchange(DBL_MAX) : this->OldestRequestedTimestamp.load();
+  numberOfItemsNotAvailableAnymore = reset ? this->NumberOfItemsNotAvailableAnymore.exchange(0) : this->NumberOfItemsNotAvailableAnymore.load();
+
+  lagSec = 0.0;
+  double latestTimestamp(0);
+  if (oldestRequestedTimestamp != DBL_MAX && this->GetLatestTimeStamp(latestTimestamp) == ITEM_OK)
+  {
+    lagSec = std::max(0.0, latestTimestamp - oldestRequestedTimestamp);
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusBuffer::RecordRequestedTime(double time)
+{
+  double oldestRequestedTimestamp = this->OldestRequestedTimestamp.load(std::memory_order_relaxed);
+  while (time < oldestRequestedTimestamp
+         && !this->OldestRequestedTimestamp.compare_exchange_weak(oldestRequestedTimestamp, time, std::memory_order_relaxed))
+  {
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusBuffer::RecordRequestStatus(ItemStatus status)
+{
+  if (status == ITEM_NOT_AVAILABLE_ANYMORE)
+  {
+    this->NumberOfItemsNotAvailableAnymore++;
+  }
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusBuffer::GetTimeStampReportTable(vtkTable* timeStampReportTable)
+{
+  return this->StreamBuffer->GetTimeStampReportTable(timeStampReportTable);
+}
+
+//----------------------------------------------------------------------------
+ItemStatus vtkPlusBuffer::GetStreamBufferItem(BufferItemUidType uid, StreamBufferItem* bufferItem)
+{
+  if (bufferItem == NULL)
+  {
+    LOCAL_LOG_ERROR("Unable to copy data buffer item into a NULL data buffer item!");
+    return ITEM_UNKNOWN_ERROR;
+  }
+
+  ItemStatus itemStatus = ITEM_NOT_AVAILABLE_ANYMORE;
+  if (!this->IsItemSpilled(uid))
+  {
+    itemStatus = this->GetStreamBufferItemFromMemory(uid, bufferItem);
+  }
+  if (itemStatus == ITEM_NOT_AVAILABLE_ANYMORE && this->HasSpilledItems)
+  {
+    // The item is not in memory anymore, it is read from the spill file without locking the buffer
+    itemStatus = this->GetSpilledItem(uid, bufferItem);
   }
-
-  igsioLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
-
-  StreamBufferItem* dataItem = NULL;
-  ItemStatus itemStatus = this->StreamBuffer->GetBufferItemPointerFromUid(uid, dataItem);
   if (itemStatus != ITEM_OK)
   {
     LOCAL_LOG_WARNING("Failed to retrieve data item");
+    this->RecordRequestStatus(itemStatus);
+  }
+  return itemStatus;
+}
+
+//----------------------------------------------------------------------------
+ItemStatus vtkPlusBuffer::GetStreamBufferItemFromMemory(BufferItemUidType uid, StreamBufferItem* bufferItem)
+{
+  if (this->StreamBuffer->GetCompactTransformStorage())
+  {
+    igsioLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
+    int bufferIndex(-1);
+    ItemStatus itemStatus = this->StreamBuffer->GetBufferIndexFromUid(uid, bufferIndex);
+    if (itemStatus != ITEM_OK)
+    {
+      return itemStatus;
+    }
+    this->StreamBuffer->GetTransformSampleStore().GetItem(bufferIndex, *bufferItem);
+    return ITEM_OK;
+  }
+
+  // The item is copied from a view, so the buffer is not locked while the frame is copied
+  StreamBufferItemView itemView;
+  ItemStatus itemStatus = this->GetReorientedBufferItemView(uid, itemView);
+  if (itemStatus != ITEM_OK)
+  {
     return itemStatus;
   }
+  *bufferItem = *itemView;
+  return ITEM_OK;
+}
+
+//----------------------------------------------------------------------------
+ItemStatus vtkPlusBuffer::GetStreamBufferItemView(BufferItemUidType uid, StreamBufferItemView& bufferItemView)
+{
+  if (this->StreamBuffer->GetCompactTransformStorage() || this->IsItemSpilled(uid))
+  {
+    // Items are not stored as objects in memory, the view refers to a copy of the item
+    std::shared_ptr<StreamBufferItem> item = std::make_shared<StreamBufferItem>();
+    ItemStatus itemStatus = this->GetStreamBufferItem(uid, item.get());
+    bufferItemView = (itemStatus == ITEM_OK) ? item : StreamBufferItemView();
+    return itemStatus;
+  }
+
+  ItemStatus itemStatus = this->GetReorientedBufferItemView(uid, bufferItemView);
+  if (itemStatus == ITEM_NOT_AVAILABLE_ANYMORE && this->HasSpilledItems)
+  {
+    // The item has been overwritten in memory since it was looked up, it is read from the spill file without locking the buffer
+    std::shared_ptr<StreamBufferItem> item = std::make_shared<StreamBufferItem>();
+    itemStatus = this->GetSpilledItem(uid, item.get());
+    bufferItemView = (itemStatus == ITEM_OK) ? item : StreamBufferItemView();
+  }
+  if (itemStatus != ITEM_OK)
+  {
+    LOCAL_LOG_WARNING("Failed to retrieve data item");
+    this->RecordRequestStatus(itemStatus);
+  }
+  return itemStatus;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusBuffer::GetStreamBufferItemViewsFromTimes(const double* times, int numberOfTimes, StreamBufferItemView* bufferItemViews, ItemStatus* statuses)
+{
+  std::vector<BufferItemUidType> uids(numberOfTimes, 0);
+  {
+    // Lock the buffer only once for all the items in memory
+    igsioLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
+    this->GetItemUidsFromTimes(times, numberOfTimes, uids.data(), statuses);
+    for (int i = 0; i < numberOfTimes; ++i)
+    {
+      bufferItemViews[i].reset();
+      if (statuses[i] == ITEM_OK && !this->IsItemSpilled(uids[i]) && !this->StreamBuffer->GetCompactTransformStorage())
+      {
+        statuses[i] = this->StreamBuffer->GetBufferItemViewFromUid(uids[i], bufferItemViews[i]);
+        if (statuses[i] != ITEM_OK)
+        {
+          LOCAL_LOG_WARNING("Failed to retrieve data item");
+          this->RecordRequestStatus(statuses[i]);
+        }
+      }
+    }
+  }
+
+  // Spilled items are read and frames are reoriented after the buffer is unlocked, so that the producer is not blocked meanwhile
+  for (int i = 0; i < numberOfTimes; ++i)
+  {
+    if (statuses[i] != ITEM_OK)
+    {
+      continue;
+    }
+    if (bufferItemViews[i] && this->IsReorientationNeeded(*bufferItemViews[i]))
+    {
+      // the view is released so that the item can be reoriented in place if it is not referenced by other views
+      bufferItemViews[i].reset();
+    }
+    if (!bufferItemViews[i])
+    {
+      statuses[i] = this->GetStreamBufferItemView(uids[i], bufferItemViews[i]);
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+ItemStatus vtkPlusBuffer::GetStoredBufferItemView(BufferItemUidType uid, StreamBufferItemView& bufferItemView)
+{
+  bufferItemView.reset();
+  if (this->IsItemSpilled(uid) || this->StreamBuffer->GetCompactTransformStorage())
+  {
+    return ITEM_OK;
+  }
+  return this->StreamBuffer->GetBufferItemViewFromUid(uid, bufferItemView);
+}
+
+//----------------------------------------------------------------------------
+ItemStatus vtkPlusBuffer::CopyStreamBufferItemFromView(BufferItemUidType uid, StreamBufferItemView& bufferItemView, StreamBufferItem* bufferItem)
+{
+  if (bufferItemView && this->IsReorientationNeeded(*bufferItemView))
+  {
+    // the view is released so that the item can be reoriented in place if it is not referenced by other views
+    bufferItemView.reset();
+  }
+  if (!bufferItemView)
+  {
+    return this->GetStreamBufferItem(uid, bufferItem);
+  }
+  *bufferItem = *bufferItemView;
+  return ITEM_OK;
+}
+
+//----------------------------------------------------------------------------
+bool vtkPlusBuffer::IsReorientationNeeded(const StreamBufferItem& item) const
+{
+  if (!item.HasValidVideoData())
+  {
+    return false;
+  }
+  // The frame is not modified, but not all the accessors of igsioVideoFrame are const
+  igsioVideoFrame& frame = const_cast<StreamBufferItem&>(item).GetFrame();
+  US_IMAGE_ORIENTATION storedImageOrientation = frame.GetImageOrientation();
+  return storedImageOrientation != this->ImageOrientation && storedImageOrientation != US_IMG_ORIENT_XX && !frame.IsFrameEncoded();
+}
+
+//----------------------------------------------------------------------------
+ItemStatus vtkPlusBuffer::GetReorientedBufferItemView(BufferItemUidType uid, StreamBufferItemView& bufferItemView)
+{
+  {
+    igsioLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
+    ItemStatus itemStatus = this->StreamBuffer->GetBufferItemViewFromUid(uid, bufferItemView);
+    if (itemStatus != ITEM_OK || !this->IsReorientationNeeded(*bufferItemView))
+    {
+      return itemStatus;
+    }
+
+    std::map<BufferItemUidType, StreamBufferItemView>::iterator reorientedItem = this->ReorientedItems.find(uid);
+    if (reorientedItem != this->ReorientedItems.end() && !this->IsReorientationNeeded(*reorientedItem->second))
+    {
+      bufferItemView = reorientedItem->second;
+      return ITEM_OK;
+    }
+
+    if (bufferItemView.use_count() <= 2)
+    {
+      // Only the buffer and this view reference the item, the stored frame is reoriented without copying the item
+      bufferItemView.reset();
+      StreamBufferItem* dataItem = NULL;
+      itemStatus = this->StreamBuffer->GetWritableBufferItemPointerFromUid(uid, dataItem);
+      if (itemStatus != ITEM_OK)
+      {
+        return itemStatus;
+      }
+      if (this->ReorientItemFrame(dataItem) != PLUS_SUCCESS)
+      {
+        return ITEM_UNKNOWN_ERROR;
+      }
+      return this->StreamBuffer->GetBufferItemViewFromUid(uid, bufferItemView);
+    }
+  }
 
-  if (bufferItem->DeepCopy(dataItem) != PLUS_SUCCESS)
+  // The item is referenced by other views, which must not see it change, so a copy is reoriented.
+  // The buffer is unlocked meanwhile, the view keeps the item unchanged.
+  std::shared_ptr<StreamBufferItem> reorientedItem = std::make_shared<StreamBufferItem>(*bufferItemView);
+  std::vector<unsigned char> scratch;
+  if (ReorientFrame(reorientedItem->GetFrame(), this->ImageOrientation, this->PixelType, this->NumberOfScalarComponents, scratch) != PLUS_SUCCESS)
   {
-    LOCAL_LOG_WARNING("Failed to copy data item");
+    LOCAL_LOG_ERROR("Failed to convert buffer item " << uid << " to " << igsioVideoFrame::GetStringFromUsImageOrientation(this->ImageOrientation) << " orientation");
+    bufferItemView.reset();
     return ITEM_UNKNOWN_ERROR;
   }
+  bufferItemView = reorientedItem;
 
+  igsioLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
+  if (this->StreamBuffer->GetNumberOfItems() > 0 && uid >= this->StreamBuffer->GetOldestItemUidInBuffer())
+  {
+    // Copies of the items that have been overwritten since they were reoriented are not needed anymore
+    this->ReorientedItems.erase(this->ReorientedItems.begin(), this->ReorientedItems.lower_bound(this->StreamBuffer->GetOldestItemUidInBuffer()));
+    this->ReorientedItems[uid] = bufferItemView;
+  }
   return ITEM_OK;
 }
 
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusBuffer::ReorientItemFrame(StreamBufferItem* item)
+{
+  // the caller must have locked the buffer
+  if (!item->HasValidVideoData())
+  {
+    return PLUS_SUCCESS;
+  }
+  US_IMAGE_ORIENTATION storedImageOrientation = item->GetFrame().GetImageOrientation();
+  if (ReorientFrame(item->GetFrame(), this->ImageOrientation, this->PixelType, this->NumberOfScalarComponents, this->ReorientationScratch) != PLUS_SUCCESS)
+  {
+    LOCAL_LOG_ERROR("Failed to convert buffer item " << item->GetUid() << " from " << igsioVideoFrame::GetStringFromUsImageOrientation(storedImageOrientation) <<
+                    " to " << igsioVideoFrame::GetStringFromUsImageOrientation(this->ImageOrientation) << " orientation");
+    return PLUS_FAIL;
+  }
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusBuffer::ReorientFrame(igsioVideoFrame& frame, US_IMAGE_ORIENTATION imageOrientation, igsioCommon::VTKScalarPixelType pixelType,
+                                       unsigned int numberOfScalarComponents, std::vector<unsigned char>& scratch)
+{
+  US_IMAGE_ORIENTATION storedImageOrientation = frame.GetImageOrientation();
+  if (storedImageOrientation == imageOrientation || storedImageOrientation == US_IMG_ORIENT_XX || frame.IsFrameEncoded())
+  {
+    return PLUS_SUCCESS;
+  }
+
+  igsioVideoFrame::FlipInfoType flipInfo;
+  if (igsioVideoFrame::GetFlipAxes(storedImageOrientation, frame.GetImageType(), imageOrientation, flipInfo) != PLUS_SUCCESS
+      || flipInfo.tranpose != igsioVideoFrame::TRANSPOSE_NONE)
+  {
+    return PLUS_FAIL;
+  }
+
+  FrameSizeType frameSize = { 0, 0, 0 };
+  frame.GetFrameSize(frameSize);
+  const unsigned char* pixels = reinterpret_cast<const unsigned char*>(frame.GetScalarPointer());
+  scratch.assign(pixels, pixels + frame.GetFrameSizeInBytes());
+
+  std::array<int, 3> noClip = { igsioCommon::NO_CLIP, igsioCommon::NO_CLIP, igsioCommon::NO_CLIP };
+  if (igsioVideoFrame::GetOrientedClippedImage(scratch.data(), flipInfo, frame.GetImageType(), pixelType, numberOfScalarComponents,
+      frameSize, frame, noClip, noClip) != PLUS_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
+  frame.SetImageOrientation(imageOrientation);
+  return PLUS_SUCCESS;
+}
+
 //----------------------------------------------------------------------------
 void vtkPlusBuffer::DeepCopy(vtkPlusBuffer* buffer)
 {
   LOG_TRACE("vtkPlusBuffer::DeepCopy");
 
   this->StreamBuffer->DeepCopy(buffer->StreamBuffer);
+  {
+    // UIDs of the copied items may be the same as the UIDs of the reoriented items
+    igsioLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
+    this->ReorientedItems.clear();
+  }
   if (buffer->GetFrameSize()[0] != -1 && buffer->GetFrameSize()[1] != -1 && buffer->GetFrameSize()[2] != -1)
   {
     this->SetFrameSize(buffer->GetFrameSize());
@@ -803,12 +1860,26 @@ void vtkPlusBuffer::DeepCopy(vtkPlusBuffer* buffer)
   this->SetNumberOfScalarComponents(buffer->GetNumberOfScalarComponents());
   this->SetImageOrientation(buffer->GetImageOrientation());
   this->SetBufferSize(buffer->GetBufferSize());
+  // Copied items have their own frame memory, move them to the arena of this buffer
+  this->AllocateMemoryForFrames();
 }
 
 //----------------------------------------------------------------------------
 void vtkPlusBuffer::Clear()
 {
+  // The spill writer is not writing an item while the buffer is cleared
+  std::lock_guard<std::mutex> spillWriterLock(this->SpillWriterMutex);
+  igsioLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
   this->StreamBuffer->Clear();
+  this->ReorientedItems.clear();
+  if (this->SpillFile)
+  {
+    // UIDs are restarted, the spilled items cannot be retrieved anymore
+    std::lock_guard<std::mutex> spillFileLock(this->SpillFileMutex);
+    this->SpillFile->Clear();
+    this->HasSpilledItems = false;
+  }
+  this->NextUidToSpill = 0;
 }
 
 //----------------------------------------------------------------------------
@@ -884,11 +1955,12 @@ PlusStatus vtkPlusBuffer::SetImageOrientation(US_IMAGE_ORIENTATION imgOrientatio
     LOCAL_LOG_ERROR("Invalid image orientation attempted to set in the video buffer: " << imgOrientation);
     return PLUS_FAIL;
   }
+  // Stored frames are not modified: they keep the orientation of their pixels and they are reoriented
+  // when they are retrieved (see GetReorientedBufferItemView). New items are stored in the new orientation.
+  igsioLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
   this->ImageOrientation = imgOrientation;
-  for (int frameNumber = 0; frameNumber < this->StreamBuffer->GetBufferSize(); frameNumber++)
-  {
-    this->StreamBuffer->GetBufferItemPointerFromBufferIndex(frameNumber)->GetFrame().SetImageOrientation(imgOrientation);
-  }
+  // Reoriented copies are in the previous orientation
+  this->ReorientedItems.clear();
   return PLUS_SUCCESS;
 }
 
@@ -1068,94 +2140,461 @@ PlusStatus vtkPlusBuffer::CopyImagesFromTrackedFrameList(vtkIGSIOTrackedFrameLis
     }
   }
 
-  return (numberOfErrors > 0 ? PLUS_FAIL : PLUS_SUCCESS);
+  return (numberOfErrors > 0 ? PLUS_FAIL : PLUS_SUCCESS);
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusBuffer::WriteToSequenceFile(const char* filename, bool useCompression /*=false*/)
+{
+  LOG_TRACE("vtkPlusBuffer::WriteToSequenceFile");
+
+  Snapshot snapshot;
+  if (this->GetSnapshot(snapshot) != PLUS_SUCCESS)
+  {
+    LOCAL_LOG_ERROR("Failed to take a snapshot of the buffer");
+    return PLUS_FAIL;
+  }
+  return WriteSnapshotToSequenceFile(snapshot, filename, useCompression);
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusBuffer::GetSnapshot(Snapshot& snapshot)
+{
+  LOG_TRACE("vtkPlusBuffer::GetSnapshot");
+
+  snapshot.Items.clear();
+  snapshot.LocalTimeOffsetSec = this->GetLocalTimeOffsetSec();
+  snapshot.ImageOrientation = this->ImageOrientation;
+  snapshot.PixelType = this->PixelType;
+  snapshot.NumberOfScalarComponents = this->NumberOfScalarComponents;
+
+  PlusStatus status = PLUS_SUCCESS;
+  BufferItemUidType oldestPinnedUid(0);
+  {
+    // Pin all the items in memory at once, so that the snapshot is consistent and the producer does not have to wait long
+    igsioLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
+    if (this->StreamBuffer->GetNumberOfItems() == 0)
+    {
+      return PLUS_SUCCESS;
+    }
+    oldestPinnedUid = this->StreamBuffer->GetOldestItemUidInBuffer();
+    BufferItemUidType latestUid = this->StreamBuffer->GetLatestItemUidInBuffer();
+    snapshot.Items.reserve(static_cast<size_t>(latestUid - oldestPinnedUid + 1));
+    for (BufferItemUidType uid = oldestPinnedUid; uid <= latestUid; ++uid)
+    {
+      StreamBufferItemView itemView;
+      ItemStatus itemStatus(ITEM_OK);
+      if (this->StreamBuffer->GetCompactTransformStorage())
+      {
+        // Compact transform items are small, they are copied
+        itemStatus = this->GetStreamBufferItemView(uid, itemView);
+      }
+      else
+      {
+        // Frames are reoriented when the snapshot is written, to keep the lock short
+        itemStatus = this->StreamBuffer->GetBufferItemViewFromUid(uid, itemView);
+      }
+      if (itemStatus != ITEM_OK)
+      {
+        LOCAL_LOG_ERROR("Unable to get frame from buffer with UID: " << uid);
+        status = PLUS_FAIL;
+        continue;
+      }
+      snapshot.Items.push_back(itemView);
+    }
+  }
+
+  if (this->HasSpilledItems)
+  {
+    // Spilled items are read one by one, so that the producer is not blocked while the file is read
+    std::vector<StreamBufferItemView> spilledItems;
+    BufferItemUidType oldestUid = this->GetOldestItemUidInBuffer();
+    for (BufferItemUidType uid = oldestUid; uid < oldestPinnedUid; ++uid)
+    {
+      StreamBufferItemView itemView;
+      if (this->GetStreamBufferItemView(uid, itemView) != ITEM_OK)
+      {
+        // the item has been overwritten in the spill file since the snapshot was taken
+        continue;
+      }
+      spilledItems.push_back(itemView);
+    }
+    snapshot.Items.insert(snapshot.Items.begin(), spilledItems.begin(), spilledItems.end());
+  }
+
+  return status;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusBuffer::WriteSnapshotToSequenceFile(const Snapshot& snapshot, const char* filename, bool useCompression /*=false*/)
+{
+  LOG_TRACE("vtkPlusBuffer::WriteSnapshotToSequenceFile");
+
+  vtkSmartPointer<vtkIGSIOTrackedFrameList> trackedFrameList = vtkSmartPointer<vtkIGSIOTrackedFrameList>::New();
+
+  PlusStatus status = PLUS_SUCCESS;
+  std::vector<unsigned char> reorientationScratch;
+
+  for (std::vector<StreamBufferItemView>::const_iterator itemIt = snapshot.Items.begin(); itemIt != snapshot.Items.end(); ++itemIt)
+  {
+    const StreamBufferItem& bufferItem = **itemIt;
+
+    igsioTrackedFrame* trackedFrame = new igsioTrackedFrame;
+
+    // Add image data
+    trackedFrame->SetImageData(bufferItem.GetFrame());
+    if (bufferItem.HasValidVideoData()
+        && ReorientFrame(*trackedFrame->GetImageData(), snapshot.ImageOrientation, snapshot.PixelType, snapshot.NumberOfScalarComponents, reorientationScratch) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to convert buffer item " << bufferItem.GetUid() << " to " << igsioVideoFrame::GetStringFromUsImageOrientation(snapshot.ImageOrientation) << " orientation");
+      status = PLUS_FAIL;
+    }
+
+    // Add tracking data
+    vtkSmartPointer<vtkMatrix4x4> matrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    bufferItem.GetMatrix(matrix);
+    trackedFrame->SetFrameTransform(igsioTransformName("Tool", "Tracker"), matrix);
+    trackedFrame->SetFrameTransformStatus(igsioTransformName("Tool", "Tracker"), bufferItem.GetStatus());
+
+    // Add filtered timestamp
+    double filteredTimestamp = bufferItem.GetFilteredTimestamp(snapshot.LocalTimeOffsetSec);
+    std::ostringstream timestampFieldValue;
+    timestampFieldValue << std::fixed << filteredTimestamp;
+    trackedFrame->SetFrameField("Timestamp", timestampFieldValue.str());
+
+    // Add unfiltered timestamp
+    double unfilteredTimestamp = bufferItem.GetUnfilteredTimestamp(snapshot.LocalTimeOffsetSec);
+    std::ostringstream unfilteredtimestampFieldValue;
+    unfilteredtimestampFieldValue << std::fixed << unfilteredTimestamp;
+    trackedFrame->SetFrameField("UnfilteredTimestamp", unfilteredtimestampFieldValue.str());
+
+    // Add frame number
+    unsigned long frameNumber = bufferItem.GetIndex();
+    std::ostringstream frameNumberFieldValue;
+    frameNumberFieldValue << std::fixed << frameNumber;
+    trackedFrame->SetFrameField("FrameNumber", frameNumberFieldValue.str());
+
+    // Add custom fields
+    const std::vector<PlusFrameFieldStore::Field>& customFields = bufferItem.GetFrameFieldStore().GetFields();
+    for (std::vector<PlusFrameFieldStore::Field>::const_iterator cf = customFields.begin(); cf != customFields.end(); ++cf)
+    {
+      trackedFrame->SetFrameField(*(cf->Name), *(cf->Value), cf->Flags);
+    }
+
+    // Add tracked frame to the list
+    trackedFrameList->TakeTrackedFrame(trackedFrame);
+  }
+
+  // Save tracked frames to metafile
+  if (vtkPlusSequenceIO::Write(filename, trackedFrameList, trackedFrameList->GetImageOrientation(), useCompression) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to save tracked frames to sequence metafile!");
+    return PLUS_FAIL;
+  }
+
+  return status;
+}
+
+//-----------------------------------------------------------------------------
+void vtkPlusBuffer::SetTimeStampReporting(bool enable)
+{
+  this->StreamBuffer->SetTimeStampReporting(enable);
+}
+
+//-----------------------------------------------------------------------------
+bool vtkPlusBuffer::GetTimeStampReporting()
+{
+  return this->StreamBuffer->GetTimeStampReporting();
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusBuffer::SetLockFreeReads(bool enable)
+{
+  this->StreamBuffer->SetLockFreeReads(enable);
+}
+
+//----------------------------------------------------------------------------
+bool vtkPlusBuffer::GetLockFreeReads()
+{
+  return this->StreamBuffer->GetLockFreeReads();
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusBuffer::SetIncrementalTimestampFiltering(bool enable)
+{
+  this->StreamBuffer->SetIncrementalTimestampFiltering(enable);
+}
+
+//----------------------------------------------------------------------------
+bool vtkPlusBuffer::GetIncrementalTimestampFiltering()
+{
+  return this->StreamBuffer->GetIncrementalTimestampFiltering();
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusBuffer::SetCompactTransformStorage(bool enable)
+{
+  if (this->StreamBuffer->GetCompactTransformStorage() == enable)
+  {
+    // no change
+    return PLUS_SUCCESS;
+  }
+  this->StreamBuffer->SetCompactTransformStorage(enable);
+  // Release the frame memory or allocate frames for the new items
+  return this->AllocateMemoryForFrames();
+}
+
+//----------------------------------------------------------------------------
+bool vtkPlusBuffer::GetCompactTransformStorage()
+{
+  return this->StreamBuffer->GetCompactTransformStorage();
 }
 
 //----------------------------------------------------------------------------
-PlusStatus vtkPlusBuffer::WriteToSequenceFile(const char* filename, bool useCompression /*=false*/)
+unsigned long vtkPlusBuffer::AddItemAddedCallback(ItemAddedCallbackType callback)
 {
-  LOG_TRACE("vtkPlusBuffer::WriteToSequenceFile");
+  igsioLockGuard<vtkIGSIORecursiveCriticalSection> callbacksGuardedLock(this->ItemAddedCallbacksMutex);
+  unsigned long callbackId = this->NextItemAddedCallbackId++;
+  this->ItemAddedCallbacks[callbackId] = callback;
+  this->UpdateItemAddedCallbacksSnapshot();
+  return callbackId;
+}
 
-  vtkSmartPointer<vtkIGSIOTrackedFrameList> trackedFrameList = vtkSmartPointer<vtkIGSIOTrackedFrameList>::New();
+//----------------------------------------------------------------------------
+void vtkPlusBuffer::RemoveItemAddedCallback(unsigned long callbackId)
+{
+  {
+    igsioLockGuard<vtkIGSIORecursiveCriticalSection> callbacksGuardedLock(this->ItemAddedCallbacksMutex);
+    this->ItemAddedCallbacks.erase(callbackId);
+    this->UpdateItemAddedCallbacksSnapshot();
+  }
+  // Invocations that have started before the removal may still call the removed function
+  std::unique_lock<std::mutex> invocationsLock(this->ItemAddedCallbackInvocationsMutex);
+  this->ItemAddedCallbackInvocationsCondition.wait(invocationsLock, [this] { return this->NumberOfItemAddedCallbackInvocations == 0; });
+}
 
-  PlusStatus status = PLUS_SUCCESS;
+//----------------------------------------------------------------------------
+void vtkPlusBuffer::UpdateItemAddedCallbacksSnapshot()
+{
+  igsioLockGuard<vtkIGSIORecursiveCriticalSection> callbacksGuardedLock(this->ItemAddedCallbacksMutex);
+  std::shared_ptr<std::vector<ItemAddedCallbackType> > snapshot = std::make_shared<std::vector<ItemAddedCallbackType> >();
+  snapshot->reserve(this->ItemAddedCallbacks.size());
+  for (std::map<unsigned long, ItemAddedCallbackType>::iterator it = this->ItemAddedCallbacks.begin(); it != this->ItemAddedCallbacks.end(); ++it)
+  {
+    snapshot->push_back(it->second);
+  }
+  this->ItemAddedCallbacksSnapshot = snapshot;
+  this->NumberOfItemAddedCallbacks = this->ItemAddedCallbacks.size();
+}
+
+//----------------------------------------------------------------------------
+const PlusLatencyHistogram& vtkPlusBuffer::GetCommitLatencyHistogram() const
+{
+  return this->CommitLatencyHistogram;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusBuffer::InvokeItemAddedCallbacks(BufferItemUidType uid, double filteredTimestamp)
+{
+  if (this->NumberOfItemAddedCallbacks == 0)
+  {
+    // no subscribers, avoid locking
+    return;
+  }
+  double timestamp = filteredTimestamp + this->GetLocalTimeOffsetSec();
 
-  for (BufferItemUidType frameUid = this->GetOldestItemUidInBuffer(); frameUid <= this->GetLatestItemUidInBuffer(); ++frameUid)
+  // Take the current list of callbacks and call them without holding any lock,
+  // so that the callbacks can access the buffer and can wait for other threads
+  std::shared_ptr<const std::vector<ItemAddedCallbackType> > callbacks;
+  {
+    std::lock_guard<std::mutex> invocationsLock(this->ItemAddedCallbackInvocationsMutex);
+    igsioLockGuard<vtkIGSIORecursiveCriticalSection> callbacksGuardedLock(this->ItemAddedCallbacksMutex);
+    callbacks = this->ItemAddedCallbacksSnapshot;
+    ++this->NumberOfItemAddedCallbackInvocations;
+  }
+  if (callbacks)
   {
-    StreamBufferItem bufferItem;
-    if (this->GetStreamBufferItem(frameUid, &bufferItem) != ITEM_OK)
+    for (std::vector<ItemAddedCallbackType>::const_iterator it = callbacks->begin(); it != callbacks->end(); ++it)
     {
-      LOCAL_LOG_ERROR("Unable to get frame from buffer with UID: " << frameUid);
-      status = PLUS_FAIL;
-      continue;
+      (*it)(uid, timestamp);
     }
+  }
+  {
+    std::lock_guard<std::mutex> invocationsLock(this->ItemAddedCallbackInvocationsMutex);
+    --this->NumberOfItemAddedCallbackInvocations;
+  }
+  this->ItemAddedCallbackInvocationsCondition.notify_all();
+}
 
-    igsioTrackedFrame* trackedFrame = new igsioTrackedFrame;
-
-    // Add image data
-    trackedFrame->SetImageData(bufferItem.GetFrame());
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusBuffer::SetUseHugePages(bool useHugePages)
+{
+  if (this->UseHugePages == useHugePages)
+  {
+    // no change
+    return PLUS_SUCCESS;
+  }
+  this->UseHugePages = useHugePages;
+  return this->AllocateMemoryForFrames();
+}
 
-    // Add tracking data
-    vtkSmartPointer<vtkMatrix4x4> matrix = vtkSmartPointer<vtkMatrix4x4>::New();
-    bufferItem.GetMatrix(matrix);
-    trackedFrame->SetFrameTransform(igsioTransformName("Tool", "Tracker"), matrix);
-    trackedFrame->SetFrameTransformStatus(igsioTransformName("Tool", "Tracker"), bufferItem.GetStatus());
+//----------------------------------------------------------------------------
+bool vtkPlusBuffer::GetUseHugePages() const
+{
+  return this->UseHugePages;
+}
 
-    // Add filtered timestamp
-    double filteredTimestamp = bufferItem.GetFilteredTimestamp(this->GetLocalTimeOffsetSec());
-    std::ostringstream timestampFieldValue;
-    timestampFieldValue << std::fixed << filteredTimestamp;
-    trackedFrame->SetFrameField("Timestamp", timestampFieldValue.str());
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusBuffer::SetLockFrameMemory(bool lockFrameMemory)
+{
+  std::shared_ptr<PlusFrameArena> frameArena;
+  {
+    igsioLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
+    this->LockFrameMemory = lockFrameMemory;
+    frameArena = this->FrameArena;
+  }
+  // Locking may take a while, it is done after the buffer is unlocked
+  return frameArena ? frameArena->SetPagesLocked(lockFrameMemory) : PLUS_SUCCESS;
+}
 
-    // Add unfiltered timestamp
-    double unfilteredTimestamp = bufferItem.GetUnfilteredTimestamp(this->GetLocalTimeOffsetSec());
-    std::ostringstream unfilteredtimestampFieldValue;
-    unfilteredtimestampFieldValue << std::fixed << unfilteredTimestamp;
-    trackedFrame->SetFrameField("UnfilteredTimestamp", unfilteredtimestampFieldValue.str());
+//----------------------------------------------------------------------------
+bool vtkPlusBuffer::GetLockFrameMemory() const
+{
+  return this->LockFrameMemory;
+}
 
-    // Add frame number
-    unsigned long frameNumber = bufferItem.GetIndex();
-    std::ostringstream frameNumberFieldValue;
-    frameNumberFieldValue << std::fixed << frameNumber;
-    trackedFrame->SetFrameField("FrameNumber", frameNumberFieldValue.str());
+//----------------------------------------------------------------------------
+void vtkPlusBuffer::SetLazyImageOrientation(bool enable)
+{
+  igsioLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
+  this->LazyImageOrientation = enable;
+}
 
-    // Add custom fields
-    const igsioFieldMapType& customFields = bufferItem.GetFrameFieldMap();
-    for (igsioFieldMapType::const_iterator cf = customFields.begin(); cf != customFields.end(); ++cf)
-    {
-      trackedFrame->SetFrameField(cf->first, cf->second.second, cf->second.first);
-    }
+//----------------------------------------------------------------------------
+bool vtkPlusBuffer::GetLazyImageOrientation() const
+{
+  return this->LazyImageOrientation;
+}
 
-    // Add tracked frame to the list
-    trackedFrameList->TakeTrackedFrame(trackedFrame);
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusBuffer::SetSpillFileSizeBytes(size_t sizeBytes)
+{
+  this->StopSpillWriterThread();
+  if (sizeBytes == 0)
+  {
+    this->SetSpillFile(NULL);
+    return PLUS_SUCCESS;
   }
 
-  // Save tracked frames to metafile
-  if (vtkPlusSequenceIO::Write(filename, trackedFrameList, trackedFrameList->GetImageOrientation(), useCompression) != PLUS_SUCCESS)
+  // The file is created before locking the buffer, because reserving the disk space may take a while
+  std::ostringstream fileName;
+  fileName << "BufferSpill_" << (this->DescriptiveName != NULL ? this->DescriptiveName : "") << "_" << static_cast<const void*>(this) << ".bin";
+  std::unique_ptr<PlusBufferSpillFile> spillFile(new PlusBufferSpillFile);
+  if (spillFile->Open(vtkPlusConfig::GetInstance()->GetOutputPath(fileName.str()), sizeBytes) != PLUS_SUCCESS)
   {
-    LOCAL_LOG_ERROR("Failed to save tracked frames to sequence metafile!");
+    LOCAL_LOG_ERROR("Failed to create a " << sizeBytes << " bytes large spill file in the output directory");
+    if (this->GetSpillFileSizeBytes() > 0)
+    {
+      // keep using the previous file
+      this->StartSpillWriterThread();
+    }
     return PLUS_FAIL;
   }
 
-  return status;
+  this->SetSpillFile(spillFile.release());
+  this->StartSpillWriterThread();
+  return PLUS_SUCCESS;
 }
 
-//-----------------------------------------------------------------------------
-void vtkPlusBuffer::SetTimeStampReporting(bool enable)
+//----------------------------------------------------------------------------
+void vtkPlusBuffer::SetSpillFile(PlusBufferSpillFile* spillFile)
 {
-  this->StreamBuffer->SetTimeStampReporting(enable);
+  std::lock_guard<std::mutex> spillWriterLock(this->SpillWriterMutex);
+  igsioLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
+  std::lock_guard<std::mutex> spillFileLock(this->SpillFileMutex);
+  this->SpillFile.reset(spillFile);
+  this->HasSpilledItems = false;
+  // Items that are in memory already are written to the new file
+  this->NextUidToSpill = 0;
 }
 
-//-----------------------------------------------------------------------------
-bool vtkPlusBuffer::GetTimeStampReporting()
+//----------------------------------------------------------------------------
+size_t vtkPlusBuffer::GetSpillFileSizeBytes()
 {
-  return this->StreamBuffer->GetTimeStampReporting();
+  std::lock_guard<std::mutex> spillFileLock(this->SpillFileMutex);
+  return this->SpillFile ? this->SpillFile->GetCapacityBytes() : 0;
+}
+
+//----------------------------------------------------------------------------
+ItemStatus vtkPlusBuffer::GetPoseFromUid(BufferItemUidType uid, PlusInterpolatedPose& pose)
+{
+  if (this->IsItemSpilled(uid))
+  {
+    // The buffer is not locked while the item is read from the spill file
+    StreamBufferItem spilledItem;
+    ItemStatus itemStatus = ITEM_UNKNOWN_ERROR;
+    {
+      std::lock_guard<std::mutex> spillFileLock(this->SpillFileMutex);
+      itemStatus = this->SpillFile ? this->SpillFile->GetItem(uid, &spilledItem) : ITEM_NOT_AVAILABLE_ANYMORE;
+    }
+    if (itemStatus != ITEM_OK)
+    {
+      return itemStatus;
+    }
+    GetPoseFromItem(spilledItem, pose);
+    return ITEM_OK;
+  }
+
+  igsioLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
+
+  if (this->StreamBuffer->GetCompactTransformStorage())
+  {
+    int bufferIndex(-1);
+    ItemStatus itemStatus = this->StreamBuffer->GetBufferIndexFromUid(uid, bufferIndex);
+    if (itemStatus != ITEM_OK)
+    {
+      return itemStatus;
+    }
+    const PlusTransformSampleStore& store = this->StreamBuffer->GetTransformSampleStore();
+    const double* matrixElements = store.GetMatrixElements(bufferIndex);
+    std::copy(matrixElements, matrixElements + PlusTransformSampleStore::MATRIX_ELEMENT_COUNT, pose.Matrix);
+    pose.Status = store.GetStatus(bufferIndex);
+    pose.FilteredTimestamp = store.GetFilteredTimestamp(bufferIndex);
+    pose.UnfilteredTimestamp = store.GetUnfilteredTimestamp(bufferIndex);
+    pose.Index = store.GetIndex(bufferIndex);
+    pose.Uid = store.GetUid(bufferIndex);
+    pose.HasFrameFields = store.HasValidFieldData(bufferIndex);
+    pose.Result = ITEM_OK;
+    return ITEM_OK;
+  }
+
+  StreamBufferItem* dataItem = NULL;
+  ItemStatus itemStatus = this->StreamBuffer->GetBufferItemPointerFromUid(uid, dataItem);
+  if (itemStatus != ITEM_OK)
+  {
+    return itemStatus;
+  }
+  GetPoseFromItem(*dataItem, pose);
+  return ITEM_OK;
 }
 
 //----------------------------------------------------------------------------
-// Returns the two buffer items that are closest previous and next buffer items relative to the specified time.
-// itemA is the closest item
-PlusStatus vtkPlusBuffer::GetPrevNextBufferItemFromTime(double time, StreamBufferItem& itemA, StreamBufferItem& itemB)
+void vtkPlusBuffer::GetPoseFromItem(const StreamBufferItem& item, PlusInterpolatedPose& pose)
+{
+  item.GetMatrixElements(pose.Matrix);
+  pose.Status = item.GetStatus();
+  pose.FilteredTimestamp = item.GetFilteredTimestamp(0.0);   // 0.0 because timestamps in the buffer are in local time
+  pose.UnfilteredTimestamp = item.GetUnfilteredTimestamp(0.0);
+  pose.Index = item.GetIndex();
+  pose.Uid = item.GetUid();
+  pose.HasFrameFields = item.HasValidFieldData();
+  pose.Result = ITEM_OK;
+}
+
+//----------------------------------------------------------------------------
+// Returns the poses of the two buffer items that are closest previous and next buffer items relative to the specified time.
+// poseA is the closest item
+PlusStatus vtkPlusBuffer::GetPrevNextPosesFromTime(double time, PlusInterpolatedPose& poseA, PlusInterpolatedPose& poseB, const BufferItemUidType* closestItemUid/*=NULL*/)
 {
   igsioLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
 
@@ -1168,7 +2607,15 @@ PlusStatus vtkPlusBuffer::GetPrevNextBufferItemFromTime(double time, StreamBuffe
 
   // itemA is the item that is the closest to the requested time, get its UID and time
   BufferItemUidType itemAuid(0);
-  ItemStatus status = this->StreamBuffer->GetItemUidFromTime(time, itemAuid);
+  ItemStatus status = ITEM_OK;
+  if (closestItemUid != NULL)
+  {
+    itemAuid = *closestItemUid;
+  }
+  else
+  {
+    status = this->GetItemUidFromTimeInAnyTier(time, itemAuid);
+  }
   if (status != ITEM_OK)
   {
     switch (status)
@@ -1184,7 +2631,7 @@ PlusStatus vtkPlusBuffer::GetPrevNextBufferItemFromTime(double time, StreamBuffe
     }
     return PLUS_FAIL;
   }
-  status = this->GetStreamBufferItem(itemAuid, &itemA);
+  status = this->GetPoseFromUid(itemAuid, poseA);
   if (status != ITEM_OK)
   {
     LOCAL_LOG_ERROR("vtkPlusBuffer: Failed to get data buffer item with Uid: " << itemAuid);
@@ -1192,7 +2639,7 @@ PlusStatus vtkPlusBuffer::GetPrevNextBufferItemFromTime(double time, StreamBuffe
   }
 
   // If tracker is out of view, etc. then we don't have a valid before and after the requested time, so we cannot do interpolation
-  if (itemA.GetStatus() != TOOL_OK)
+  if (poseA.Status != TOOL_OK)
   {
     // tracker is out of view, ...
     LOCAL_LOG_DEBUG("vtkPlusBuffer: Cannot do data interpolation. The closest item to the requested time (time: " << std::fixed << time << ", uid: " << itemAuid << ") is invalid.");
@@ -1200,7 +2647,7 @@ PlusStatus vtkPlusBuffer::GetPrevNextBufferItemFromTime(double time, StreamBuffe
   }
 
   double itemAtime(0);
-  status = this->StreamBuffer->GetTimeStamp(itemAuid, itemAtime);
+  status = this->GetTimeStamp(itemAuid, itemAtime);
   if (status != ITEM_OK)
   {
     LOCAL_LOG_ERROR("vtkPlusBuffer: Failed to get data buffer timestamp (time: " << std::fixed << time << ", uid: " << itemAuid << ")");
@@ -1211,7 +2658,7 @@ PlusStatus vtkPlusBuffer::GetPrevNextBufferItemFromTime(double time, StreamBuffe
   if (fabs(itemAtime - time) < NEGLIGIBLE_TIME_DIFFERENCE)
   {
     //No need for interpolation, it's very close to the closest element
-    itemB.DeepCopy(&itemA);
+    poseB = poseA;
     return PLUS_SUCCESS;
   }
 
@@ -1242,7 +2689,7 @@ PlusStatus vtkPlusBuffer::GetPrevNextBufferItemFromTime(double time, StreamBuffe
   }
   // Get item B details
   double itemBtime(0);
-  status = this->StreamBuffer->GetTimeStamp(itemBuid, itemBtime);
+  status = this->GetTimeStamp(itemBuid, itemBtime);
   if (status != ITEM_OK)
   {
     LOCAL_LOG_ERROR("Cannot do interpolation: Failed to get data buffer timestamp with Uid: " << itemBuid);
@@ -1255,14 +2702,14 @@ PlusStatus vtkPlusBuffer::GetPrevNextBufferItemFromTime(double time, StreamBuffe
     return PLUS_FAIL;
   }
   // Get the item
-  status = this->GetStreamBufferItem(itemBuid, &itemB);
+  status = this->GetPoseFromUid(itemBuid, poseB);
   if (status != ITEM_OK)
   {
     LOCAL_LOG_ERROR("vtkPlusBuffer: Failed to get data buffer item with Uid: " << itemBuid);
     return PLUS_FAIL;
   }
   // If there is no valid element on the other side of the requested time, then we cannot do an interpolation
-  if (itemB.GetStatus() != TOOL_OK)
+  if (poseB.Status != TOOL_OK)
   {
     LOCAL_LOG_DEBUG("vtkPlusBuffer: Cannot get a second element (uid=" << itemBuid << ") on the other side of the requested time (" << std::fixed << time << ")");
     return PLUS_FAIL;
@@ -1274,6 +2721,7 @@ PlusStatus vtkPlusBuffer::GetPrevNextBufferItemFromTime(double time, StreamBuffe
 //----------------------------------------------------------------------------
 ItemStatus vtkPlusBuffer::GetStreamBufferItemFromTime(double time, StreamBufferItem* bufferItem, DataItemTemporalInterpolationType interpolation)
 {
+  this->RecordRequestedTime(time);
   switch (interpolation)
   {
     case EXACT_TIME:
@@ -1291,8 +2739,19 @@ ItemStatus vtkPlusBuffer::GetStreamBufferItemFromTime(double time, StreamBufferI
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusBuffer::ModifyBufferItemFrameField(BufferItemUidType uid, const std::string& key, const std::string& value)
 {
+  igsioLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
+  if (this->StreamBuffer->GetCompactTransformStorage())
+  {
+    int bufferIndex(-1);
+    if (this->StreamBuffer->GetBufferIndexFromUid(uid, bufferIndex) != ITEM_OK)
+    {
+      return PLUS_FAIL;
+    }
+    this->StreamBuffer->GetTransformSampleStore().SetFrameField(bufferIndex, key, value);
+    return PLUS_SUCCESS;
+  }
   StreamBufferItem* item;
-  auto itemStatus = this->StreamBuffer->GetBufferItemPointerFromUid(uid, item);
+  auto itemStatus = this->StreamBuffer->GetWritableBufferItemPointerFromUid(uid, item);
   if (itemStatus == ITEM_OK)
   {
     item->SetFrameField(key, value);
@@ -1324,10 +2783,24 @@ ItemStatus vtkPlusBuffer::GetStreamBufferItemFromExactTime(double time, StreamBu
 //----------------------------------------------------------------------------
 ItemStatus vtkPlusBuffer::GetStreamBufferItemFromClosestTime(double time, StreamBufferItem* bufferItem)
 {
-  igsioLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
+  if (bufferItem == NULL)
+  {
+    LOCAL_LOG_ERROR("Unable to copy data buffer item into a NULL data buffer item!");
+    return ITEM_UNKNOWN_ERROR;
+  }
 
   BufferItemUidType itemUid(0);
-  ItemStatus status = this->StreamBuffer->GetItemUidFromTime(time, itemUid);
+  StreamBufferItemView itemView;
+  ItemStatus status = ITEM_UNKNOWN_ERROR;
+  {
+    // The buffer is only locked while the item is looked up, it is copied from the view after the buffer is unlocked
+    igsioLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
+    status = this->GetItemUidFromTimeInAnyTier(time, itemUid);
+    if (status == ITEM_OK)
+    {
+      status = this->GetStoredBufferItemView(itemUid, itemView);
+    }
+  }
   if (status != ITEM_OK)
   {
     switch (status)
@@ -1344,7 +2817,7 @@ ItemStatus vtkPlusBuffer::GetStreamBufferItemFromClosestTime(double time, Stream
     return status;
   }
 
-  status = this->GetStreamBufferItem(itemUid, bufferItem);
+  status = this->CopyStreamBufferItemFromView(itemUid, itemView, bufferItem);
   if (status != ITEM_OK)
   {
     LOCAL_LOG_ERROR("vtkPlusBuffer: Failed to get buffer item with Uid: " << itemUid);
@@ -1362,130 +2835,191 @@ ItemStatus vtkPlusBuffer::GetStreamBufferItemFromClosestTime(double time, Stream
 // The flags correspond to the closest element.
 ItemStatus vtkPlusBuffer::GetInterpolatedStreamBufferItemFromTime(double time, StreamBufferItem* bufferItem)
 {
-  StreamBufferItem itemA;
-  StreamBufferItem itemB;
+  if (bufferItem == NULL)
+  {
+    LOCAL_LOG_ERROR("Unable to copy data buffer item into a NULL data buffer item!");
+    return ITEM_UNKNOWN_ERROR;
+  }
+
+  PlusInterpolatedPose pose;
+  StreamBufferItemView itemView;
+  ItemStatus status = ITEM_UNKNOWN_ERROR;
+  {
+    // The pose and the view of the closest item are taken under the same lock, the item is copied after the buffer is unlocked
+    igsioLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
+    if (this->GetInterpolatedPosesFromTimes(&time, 1, &pose) != PLUS_SUCCESS)
+    {
+      return pose.Result;
+    }
+    status = this->GetStoredBufferItemView(pose.Uid, itemView);
+  }
+
+  // The interpolated item is a copy of the closest item, with interpolated pose and timestamps
+  if (status == ITEM_OK)
+  {
+    status = this->CopyStreamBufferItemFromView(pose.Uid, itemView, bufferItem);
+  }
+  if (status != ITEM_OK)
+  {
+    LOCAL_LOG_ERROR("vtkPlusBuffer: Failed to get data buffer item with Uid: " << pose.Uid);
+    return status;
+  }
+  bufferItem->SetMatrixElements(pose.Matrix);
+  bufferItem->SetStatus(pose.Status);
+  bufferItem->SetFilteredTimestamp(pose.FilteredTimestamp);
+  bufferItem->SetUnfilteredTimestamp(pose.UnfilteredTimestamp);
+
+  return ITEM_OK;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusBuffer::GetInterpolatedPosesFromTimes(const double* times, int numberOfTimes, PlusInterpolatedPose* poses)
+{
+  // Lock the buffer only once for all the timestamps
+  igsioLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
+
+  // Find the closest items for all the timestamps in one pass over the buffer
+  std::vector<BufferItemUidType> closestItemUids(numberOfTimes, 0);
+  std::vector<ItemStatus> closestItemStatuses(numberOfTimes, ITEM_UNKNOWN_ERROR);
+  this->GetItemUidsFromTimesInAnyTier(times, numberOfTimes, closestItemUids.data(), closestItemStatuses.data());
+
+  PlusStatus status = PLUS_SUCCESS;
+  PoseInterpolationBatch batch;
+  for (int i = 0; i < numberOfTimes; ++i)
+  {
+    // If the closest item was not found then the pose is determined the same way as for a single timestamp, which reports the error
+    const BufferItemUidType* closestItemUid = (closestItemStatuses[i] == ITEM_OK) ? &closestItemUids[i] : NULL;
+    if (this->AddPoseToInterpolationBatch(times[i], poses[i], batch, closestItemUid) != ITEM_OK)
+    {
+      status = PLUS_FAIL;
+    }
+  }
+  InterpolatePoseBatch(batch);
+
+  return status;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusBuffer::GetInterpolatedPosesFromTime(double time, vtkPlusBuffer* const* buffers, int numberOfBuffers, PlusInterpolatedPose* poses)
+{
+  PlusStatus status = PLUS_SUCCESS;
+  PoseInterpolationBatch batch;
+  for (int i = 0; i < numberOfBuffers; ++i)
+  {
+    if (buffers[i]->AddPoseToInterpolationBatch(time, poses[i], batch) != ITEM_OK)
+    {
+      status = PLUS_FAIL;
+    }
+  }
+  InterpolatePoseBatch(batch);
+
+  return status;
+}
+
+//----------------------------------------------------------------------------
+ItemStatus vtkPlusBuffer::AddPoseToInterpolationBatch(double time, PlusInterpolatedPose& pose, PoseInterpolationBatch& batch, const BufferItemUidType* closestItemUid/*=NULL*/)
+{
+  igsioLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
+  this->RecordRequestedTime(time);
 
-  if (GetPrevNextBufferItemFromTime(time, itemA, itemB) != PLUS_SUCCESS)
+  PlusInterpolatedPose poseB;
+  if (this->GetPrevNextPosesFromTime(time, pose, poseB, closestItemUid) != PLUS_SUCCESS)
   {
     // cannot get two neighbors, so cannot do interpolation
     // it may be normal (e.g., when tracker out of view), so don't return with an error
-    ItemStatus status = GetStreamBufferItemFromClosestTime(time, bufferItem);
-    // Update the timestamp to match the requested time
-    bufferItem->SetFilteredTimestamp(time);
-    bufferItem->SetUnfilteredTimestamp(time);
-    if (status != ITEM_OK)
+    BufferItemUidType closestUid(0);
+    if (closestItemUid != NULL)
+    {
+      closestUid = *closestItemUid;
+      pose.Result = ITEM_OK;
+    }
+    else
     {
+      pose.Result = this->GetItemUidFromTimeInAnyTier(time, closestUid);
+    }
+    if (pose.Result == ITEM_OK)
+    {
+      pose.Result = this->GetPoseFromUid(closestUid, pose);
+    }
+    if (pose.Result != ITEM_OK)
+    {
+      this->RecordRequestStatus(pose.Result);
       LOCAL_LOG_ERROR("vtkPlusBuffer: Failed to get data buffer timestamp (time: " << std::fixed << time << ")");
-      return status;
+      return pose.Result;
     }
-    bufferItem->SetStatus(TOOL_MISSING);   // if we return at any point due to an error then it means that the interpolation is not successful, so the item is missing
+    // Update the timestamp to match the requested time
+    pose.FilteredTimestamp = time;
+    pose.UnfilteredTimestamp = time;
+    pose.Status = TOOL_MISSING;   // if we return at any point due to an error then it means that the interpolation is not successful, so the item is missing
     return ITEM_OK;
   }
 
-  if (itemA.GetUid() == itemB.GetUid())
+  if (pose.Uid == poseB.Uid)
   {
     // exact match, no need for interpolation
-    bufferItem->DeepCopy(&itemA);
     return ITEM_OK;
   }
 
   //============== Get item weights ==================
 
-  double itemAtime(0);
-  if (this->StreamBuffer->GetTimeStamp(itemA.GetUid(), itemAtime) != ITEM_OK)
-  {
-    LOCAL_LOG_ERROR("vtkPlusBuffer: Failed to get data buffer timestamp (time: " << std::fixed << time << ", uid: " << itemA.GetUid() << ")");
-    return ITEM_UNKNOWN_ERROR;
-  }
-
-  double itemBtime(0);
-  if (this->StreamBuffer->GetTimeStamp(itemB.GetUid(), itemBtime) != ITEM_OK)
-  {
-    LOCAL_LOG_ERROR("vtkPlusBuffer: Failed to get data buffer timestamp (time: " << std::fixed << time << ", uid: " << itemB.GetUid() << ")");
-    return ITEM_UNKNOWN_ERROR;
-  }
+  const double localTimeOffsetSec = this->StreamBuffer->GetLocalTimeOffsetSec();
+  double itemAtime = pose.GetTimestamp(localTimeOffsetSec);
+  double itemBtime = poseB.GetTimestamp(localTimeOffsetSec);
 
   if (fabs(itemAtime - itemBtime) < NEGLIGIBLE_TIME_DIFFERENCE)
   {
     // exact time match, no need for interpolation
-    bufferItem->DeepCopy(&itemA);
-    bufferItem->SetFilteredTimestamp(time);
-    bufferItem->SetUnfilteredTimestamp(time);
+    pose.FilteredTimestamp = time;
+    pose.UnfilteredTimestamp = time;
     return ITEM_OK;
   }
 
   double itemAweight = fabs(itemBtime - time) / fabs(itemAtime - itemBtime);
   double itemBweight = 1 - itemAweight;
 
-  //============== Get transform matrices ==================
-
-  vtkSmartPointer<vtkMatrix4x4> itemAmatrix = vtkSmartPointer<vtkMatrix4x4>::New();
-  if (itemA.GetMatrix(itemAmatrix) != PLUS_SUCCESS)
-  {
-    LOCAL_LOG_ERROR("Failed to get item A matrix");
-    return ITEM_UNKNOWN_ERROR;
-  }
-  double matrixA[3][3] = {{0, 0, 0}, {0, 0, 0}, {0, 0, 0}};
-  double xyzA[3] = {0, 0, 0};
-  for (int i = 0; i < 3; i++)
-  {
-    matrixA[i][0] = itemAmatrix->GetElement(i, 0);
-    matrixA[i][1] = itemAmatrix->GetElement(i, 1);
-    matrixA[i][2] = itemAmatrix->GetElement(i, 2);
-    xyzA[i] = itemAmatrix->GetElement(i, 3);
-  }
-
-  vtkSmartPointer<vtkMatrix4x4> itemBmatrix = vtkSmartPointer<vtkMatrix4x4>::New();
-  if (itemB.GetMatrix(itemBmatrix) != PLUS_SUCCESS)
-  {
-    LOCAL_LOG_ERROR("Failed to get item B matrix");
-    return ITEM_UNKNOWN_ERROR;
-  }
-  double matrixB[3][3] = {{0, 0, 0}, {0, 0, 0}, {0, 0, 0}};
-  double xyzB[3] = {0, 0, 0};
-  for (int i = 0; i < 3; i++)
-  {
-    matrixB[i][0] = itemBmatrix->GetElement(i, 0);
-    matrixB[i][1] = itemBmatrix->GetElement(i, 1);
-    matrixB[i][2] = itemBmatrix->GetElement(i, 2);
-    xyzB[i] = itemBmatrix->GetElement(i, 3);
-  }
+  //============== Interpolate time ==================
 
-  //============== Interpolate rotation ==================
+  pose.FilteredTimestamp = time - localTimeOffsetSec;   // global = local + offset => local = global - offset
+  pose.UnfilteredTimestamp = pose.UnfilteredTimestamp * itemAweight + poseB.UnfilteredTimestamp * itemBweight;
 
-  double matrixAquat[4] = {0, 0, 0, 0};
-  vtkMath::Matrix3x3ToQuaternion(matrixA, matrixAquat);
-  double matrixBquat[4] = {0, 0, 0, 0};
-  vtkMath::Matrix3x3ToQuaternion(matrixB, matrixBquat);
-  double interpolatedRotationQuat[4] = {0, 0, 0, 0};
-  igsioMath::Slerp(interpolatedRotationQuat, itemBweight, matrixAquat, matrixBquat);
-  double interpolatedRotation[3][3] = {{0, 0, 0}, {0, 0, 0}, {0, 0, 0}};
-  vtkMath::QuaternionToMatrix3x3(interpolatedRotationQuat, interpolatedRotation);
+  //============== Add transforms to the batch, they are interpolated together ==================
 
-  vtkSmartPointer<vtkMatrix4x4> interpolatedMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
-  for (int i = 0; i < 3; i++)
+  int batchIndex = batch.NumberOfPoses;
+  batch.Buffers[batchIndex] = this;
+  batch.Poses[batchIndex] = &pose;
+  std::copy(pose.Matrix, pose.Matrix + 16, batch.MatricesA + batchIndex * 16);
+  std::copy(poseB.Matrix, poseB.Matrix + 16, batch.MatricesB + batchIndex * 16);
+  batch.WeightsB[batchIndex] = itemBweight;
+  batch.NumberOfPoses++;
+  if (batch.NumberOfPoses == PlusPoseInterpolator::BLOCK_SIZE)
   {
-    interpolatedMatrix->Element[i][0] = interpolatedRotation[i][0];
-    interpolatedMatrix->Element[i][1] = interpolatedRotation[i][1];
-    interpolatedMatrix->Element[i][2] = interpolatedRotation[i][2];
-    interpolatedMatrix->Element[i][3] = xyzA[i] * itemAweight + xyzB[i] * itemBweight;
+    InterpolatePoseBatch(batch);
   }
 
-  //============== Interpolate time ==================
+  return ITEM_OK;
+}
 
-  double itemAunfilteredTimestamp = itemA.GetUnfilteredTimestamp(0.0);   // 0.0 because timestamps in the buffer are in local time
-  double itemBunfilteredTimestamp = itemB.GetUnfilteredTimestamp(0.0);   // 0.0 because timestamps in the buffer are in local time
-  double interpolatedUnfilteredTimestamp = itemAunfilteredTimestamp * itemAweight + itemBunfilteredTimestamp * itemBweight;
+//----------------------------------------------------------------------------
+void vtkPlusBuffer::InterpolatePoseBatch(PoseInterpolationBatch& batch)
+{
+  PlusPoseInterpolator::InterpolatePoses(batch.NumberOfPoses, batch.MatricesA, batch.MatricesB, batch.WeightsB,
+                                         batch.InterpolatedMatrices, batch.AngleDifferencesDeg);
 
-  //============== Write interpolated results into the bufferItem ==================
+  for (int i = 0; i < batch.NumberOfPoses; ++i)
+  {
+    std::copy(batch.InterpolatedMatrices + i * 16, batch.InterpolatedMatrices + (i + 1) * 16, batch.Poses[i]->Matrix);
 
-  bufferItem->DeepCopy(&itemA);
-  bufferItem->SetMatrix(interpolatedMatrix);
-  bufferItem->SetFilteredTimestamp(time - this->StreamBuffer->GetLocalTimeOffsetSec());   // global = local + offset => local = global - offset
-  bufferItem->SetUnfilteredTimestamp(interpolatedUnfilteredTimestamp);
+    // With SLERP the interpolated orientation differs from A and B proportionally to the weight of the other item
+    double angleDiffA = batch.AngleDifferencesDeg[i] * batch.WeightsB[i];
+    double angleDiffB = batch.AngleDifferencesDeg[i] * (1 - batch.WeightsB[i]);
+    batch.Buffers[i]->CheckInterpolatedOrientationDifference(angleDiffA, angleDiffB);
+  }
+  batch.NumberOfPoses = 0;
+}
 
-  double angleDiffA = igsioMath::GetOrientationDifference(interpolatedMatrix, itemAmatrix);
-  double angleDiffB = igsioMath::GetOrientationDifference(interpolatedMatrix, itemBmatrix);
+//----------------------------------------------------------------------------
+void vtkPlusBuffer::CheckInterpolatedOrientationDifference(double angleDiffA, double angleDiffB)
+{
   if (fabs(angleDiffA) > ANGLE_INTERPOLATION_WARNING_THRESHOLD_DEG && fabs(angleDiffB) > ANGLE_INTERPOLATION_WARNING_THRESHOLD_DEG)
   {
     static vtkIGSIOLogHelper helper(5.f, 5000, vtkPlusLogger::LOG_LEVEL_WARNING);
@@ -1494,8 +3028,6 @@ ItemStatus vtkPlusBuffer::GetInterpolatedStreamBufferItemFromTime(double time, S
       LOCAL_LOG_WARNING("Angle difference between interpolated orientations is large (" << fabs(angleDiffA) << " and " << fabs(angleDiffB) << " deg, warning threshold is " << ANGLE_INTERPOLATION_WARNING_THRESHOLD_DEG << "), interpolation may be inaccurate. Consider moving the tools slower.");
     }
   }
-
-  return ITEM_OK;
 }
 
 //-----------------------------------------------------------------------------
@@ -16,16 +16,33 @@ See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
 
 // Local includes
 #include "igsioCommon.h"
+#include "PixelCodec.h"
 #include "PlusConfigure.h"
 #include "vtkPlusDataCollectionExport.h"
+#include "PlusLatencyHistogram.h"
+#include "PlusPoseInterpolator.h"
 #include "PlusStreamBufferItem.h"
 #include "vtkPlusTimestampedCircularBuffer.h"
 
 //#include "igsioTrackedFrame.h"
 
 // VTK includes
+#include <vtkMultiThreader.h>
 #include <vtkObject.h>
-
+#include <vtkSmartPointer.h>
+
+// STL includes
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class PlusBufferSpillFile;
+class PlusFrameArena;
+class vtkIGSIORecursiveCriticalSection;
 class vtkPlusDevice;
 enum ToolStatus;
 
@@ -115,6 +132,24 @@ public:
                              const igsioFieldMapType* customFields = NULL,
                              vtkStreamingVolumeFrame* encodedFrame = NULL);
 
+  /*!
+    Add a frame in the specified pixel encoding (e.g., as received from a frame grabber).
+    The pixels are converted to the pixel format of the buffer (8-bit grayscale or RGB), reoriented
+    and copied into the buffer in a single pass, without intermediate images. Otherwise it works the same way
+    as the AddItem overload that takes an image data pointer and pixel type.
+    The width of YUY2 frames must be even (see PixelCodec::ConvertAndFlip).
+  */
+  virtual PlusStatus AddItem(void* imageDataPtr,
+                             PixelCodec::PixelEncoding inputEncoding,
+                             US_IMAGE_ORIENTATION usImageOrientation,
+                             const FrameSizeType& inputFrameSizeInPx,
+                             long frameNumber,
+                             const std::array<int, 3>& clipRectangleOrigin,
+                             const std::array<int, 3>& clipRectangleSize,
+                             double unfilteredTimestamp = UNDEFINED_TIMESTAMP,
+                             double filteredTimestamp = UNDEFINED_TIMESTAMP,
+                             const igsioFieldMapType* customFields = NULL);
+
   /*!
     Add a frame plus a timestamp to the buffer with frame index.
     Additionally an optional field name&value can be added,
@@ -163,8 +198,48 @@ public:
   {
     return this->GetStreamBufferItem(this->GetOldestItemUidInBuffer(), bufferItem);
   };
+  /*!
+    Get a read-only reference to the frame with the specified frame uid, without copying it.
+    The referenced item is not modified by the buffer while the view is held, so the view
+    can be used without locking the buffer. Views should be released as soon as possible,
+    as the buffer has to allocate a new item for each slot that is still referenced when it is overwritten.
+  */
+  virtual ItemStatus GetStreamBufferItemView(BufferItemUidType uid, StreamBufferItemView& bufferItemView);
+  /*!
+    Get read-only references to the items that are the closest to multiple timestamps (see GetStreamBufferItemView).
+    The result is the same as calling GetItemUidFromTime and GetStreamBufferItemView for each timestamp, but the buffer
+    is locked only once for the items in memory (spilled items are read after it is unlocked) and the items are found by walking the buffer forward if the timestamps are in increasing order
+    (see vtkPlusTimestampedCircularBuffer::GetItemUidsFromTimes).
+    \param times Requested timestamps (in global time)
+    \param numberOfTimes Number of requested timestamps
+    \param bufferItemViews Array of numberOfTimes views that receives the results
+    \param statuses Array of numberOfTimes statuses that receives the result of each request
+  */
+  virtual void GetStreamBufferItemViewsFromTimes(const double* times, int numberOfTimes, StreamBufferItemView* bufferItemViews, ItemStatus* statuses);
   /*! Get a frame that was acquired at the specified time from buffer */
   virtual ItemStatus GetStreamBufferItemFromTime(double time, StreamBufferItem* bufferItem, DataItemTemporalInterpolationType interpolation);
+  /*!
+    Get the interpolated pose of the tool at multiple timestamps.
+    The result is the same as calling GetStreamBufferItemFromTime with INTERPOLATED interpolation for each timestamp,
+    but the buffer is locked only once, the items are not copied, and the poses are interpolated in batches (see PlusPoseInterpolator).
+    If the timestamps are in increasing order then the items are found by walking the buffer forward instead of searching for each timestamp.
+    \param times Requested timestamps (in global time)
+    \param numberOfTimes Number of requested timestamps
+    \param poses Array of numberOfTimes poses that receives the results
+    \return PLUS_FAIL if the pose could not be determined for any of the timestamps (Result of each pose tells which ones)
+  */
+  virtual PlusStatus GetInterpolatedPosesFromTimes(const double* times, int numberOfTimes, PlusInterpolatedPose* poses);
+  /*!
+    Get the interpolated pose of multiple tools at the same timestamp.
+    The result is the same as calling GetStreamBufferItemFromTime with INTERPOLATED interpolation for each buffer,
+    but the poses are interpolated in batches (see PlusPoseInterpolator).
+    \param time Requested timestamp (in global time)
+    \param buffers Array of numberOfBuffers buffers
+    \param numberOfBuffers Number of buffers
+    \param poses Array of numberOfBuffers poses that receives the results
+    \return PLUS_FAIL if the pose could not be determined for any of the buffers (Result of each pose tells which ones)
+  */
+  static PlusStatus GetInterpolatedPosesFromTime(double time, vtkPlusBuffer* const* buffers, int numberOfBuffers, PlusInterpolatedPose* poses);
   virtual PlusStatus ModifyBufferItemFrameField(BufferItemUidType uid, const std::string& key, const std::string& value);
 
   /*! Get latest timestamp in the buffer */
@@ -194,26 +269,25 @@ public:
   */
   ItemStatus GetBufferIndexFromTime(const double time, int& bufferIndex);
 
-  /*! Get buffer item unique ID */
-  virtual BufferItemUidType GetOldestItemUidInBuffer()
-  {
-    return this->StreamBuffer->GetOldestItemUidInBuffer();
-  }
+  /*! Get buffer item unique ID (items in the spill file are included) */
+  virtual BufferItemUidType GetOldestItemUidInBuffer();
   virtual BufferItemUidType GetLatestItemUidInBuffer()
   {
     return this->StreamBuffer->GetLatestItemUidInBuffer();
   }
-  virtual ItemStatus GetItemUidFromTime(double time, BufferItemUidType& uid)
-  {
-    return this->StreamBuffer->GetItemUidFromTime(time, uid);
-  }
+  virtual ItemStatus GetItemUidFromTime(double time, BufferItemUidType& uid);
+  /*!
+    Get the UIDs of the items that are the closest to multiple timestamps. Same as calling GetItemUidFromTime for each timestamp,
+    but the buffer is locked only once (see vtkPlusTimestampedCircularBuffer::GetItemUidsFromTimes).
+  */
+  virtual void GetItemUidsFromTimes(const double* times, int numberOfTimes, BufferItemUidType* uids, ItemStatus* statuses);
 
   /*! Set the local time offset in seconds (global = local + offset) */
   virtual void SetLocalTimeOffsetSec(double offsetSec);
   /*! Get the local time offset in seconds (global = local + offset) */
   virtual double GetLocalTimeOffsetSec();
 
-  /*! Get the number of items in the buffer */
+  /*! Get the number of items in the buffer (items in the spill file are not included) */
   virtual int GetNumberOfItems()
   {
     return this->StreamBuffer->GetNumberOfItems();
@@ -231,6 +305,20 @@ public:
     return this->StreamBuffer->GetFrameRate(ideal, framePeriodStdevSecPtr);
   }
 
+  /*! Get the number of bytes of memory that one item of the buffer uses (pixel data, pose and bookkeeping, frame fields are not included) */
+  virtual size_t GetItemSizeBytes();
+  /*! Get the number of bytes of memory that all the items of the buffer use */
+  virtual size_t GetMemoryUsageBytes();
+
+  /*!
+    Get how far behind the consumers of the buffer are.
+    \param lagSec Time difference between the latest item and the oldest item that was requested by time
+      since the last reset (in seconds). 0 if no items were requested.
+    \param numberOfItemsNotAvailableAnymore Number of requests that failed because the item had already been overwritten
+    \param reset If true then a new measurement period is started
+  */
+  virtual void GetConsumerLag(double& lagSec, int& numberOfItemsNotAvailableAnymore, bool reset);
+
   /*! Set maximum allowed time difference in seconds between the desired and the closest valid timestamp */
   vtkSetMacro(MaxAllowedTimeDifference, double);
   /*! Get maximum allowed time difference in seconds between the desired and the closest valid timestamp */
@@ -271,6 +359,103 @@ public:
   /*! If TimeStampReporting is enabled then all filtered and unfiltered timestamp values will be saved in a table for diagnostic purposes. */
   bool GetTimeStampReporting();
 
+  /*!
+    If LockFreeReads is enabled then item UIDs and timestamps can be queried without waiting for the buffer lock
+    (see vtkPlusTimestampedCircularBuffer::SetLockFreeReads). Items may only be added from a single thread in this mode.
+  */
+  void SetLockFreeReads(bool enable);
+  /*! Get if item UIDs and timestamps can be queried without waiting for the buffer lock */
+  bool GetLockFreeReads();
+
+  /*!
+    If IncrementalTimestampFiltering is enabled (default) then filtered timestamps are computed from running sums in constant time per item
+    (see vtkPlusTimestampedCircularBuffer::SetIncrementalTimestampFiltering). Disabling it is only useful for validation.
+  */
+  void SetIncrementalTimestampFiltering(bool enable);
+  /*! Get if filtered timestamps are computed from running sums */
+  bool GetIncrementalTimestampFiltering();
+
+  /*!
+    If CompactTransformStorage is enabled then items are stored in compact, transform-only storage
+    (see PlusTransformSampleStore), which requires much less memory for tracker tools than storing StreamBufferItem objects.
+    Only transforms can be added in this mode. Items are still retrieved as StreamBufferItem objects, by copying them
+    (views refer to a copy of the item, too). Changing the storage mode clears the buffer.
+  */
+  PlusStatus SetCompactTransformStorage(bool enable);
+  /*! Get if items are stored in compact, transform-only storage */
+  bool GetCompactTransformStorage();
+
+  /*!
+    If UseHugePages is enabled then the frame arena that holds the pixel data of all the frames
+    is backed by transparent huge pages (only has effect on Linux). The arena is reallocated if the value changes.
+  */
+  PlusStatus SetUseHugePages(bool useHugePages);
+  /*! Get if the frame arena is backed by transparent huge pages */
+  bool GetUseHugePages() const;
+
+  /*!
+    If LockFrameMemory is enabled then the frame arena that holds the pixel data of all the frames is locked
+    in physical memory (see PlusFrameArena::SetPagesLocked), so that adding a frame never causes a page fault.
+    Arenas that are allocated later (e.g., when the buffer is resized) are locked, too.
+  */
+  PlusStatus SetLockFrameMemory(bool lockFrameMemory);
+  /*! Get if the frame arena is locked in physical memory */
+  bool GetLockFrameMemory() const;
+
+  /*!
+    If LazyImageOrientation is enabled then frames that only need to be flipped to match the image orientation
+    of the buffer are stored in the orientation they are added in (recorded in the image orientation of the item frame),
+    which saves a full pass over each frame when it is added. Frames are reoriented when they are retrieved
+    (see GetStreamBufferItem and GetStreamBufferItemView) and the result is kept, so each item is reoriented at most once.
+    Spilled frames are reoriented before they are written to the spill file. Frames that need transposing are always reoriented when they are added.
+  */
+  void SetLazyImageOrientation(bool enable);
+  /*! Get if frames are stored in the orientation they are added in */
+  bool GetLazyImageOrientation() const;
+
+  /*!
+    If the spill file size is not 0 then items are copied to a memory-mapped file of the specified size in the output directory
+    (see PlusBufferSpillFile) before they are overwritten in the buffer, which extends the history of the buffer without using more memory.
+    Items are written by a background thread when they get to the older half of the buffer, so the acquisition thread is not slowed down
+    and the file also holds (up to) the older half of the items that are still in memory.
+    Items in the file can be retrieved the same way as items in memory, only slower.
+    The file is recreated (and previously spilled items are discarded) when the size is changed.
+    Must be set before items are added to the buffer.
+  */
+  PlusStatus SetSpillFileSizeBytes(size_t sizeBytes);
+  /*! Get the size of the spill file, 0 if items are not spilled to a file */
+  size_t GetSpillFileSizeBytes();
+  /*!
+    Write the items in the older half of the buffer that are not in the spill file yet to the spill file.
+    Called periodically by the spill writer thread, can be called to write the items immediately.
+  */
+  void SpillPendingItems();
+
+  /*!
+    Function that is called after a new item is added to the buffer.
+    Arguments are the UID and the timestamp (in global time) of the new item.
+  */
+  typedef std::function<void(BufferItemUidType uid, double timestamp)> ItemAddedCallbackType;
+  /*!
+    Register a function that is called after each new item is added to the buffer.
+    The function is called on the thread that adds the item, after the buffer is unlocked, therefore it may retrieve the new item.
+    It should return quickly, because it delays adding the next item, and it must not remove callbacks.
+    \return Identifier of the callback, which can be used for removing it
+  */
+  unsigned long AddItemAddedCallback(ItemAddedCallbackType callback);
+  /*!
+    Remove a function that was registered by AddItemAddedCallback.
+    Waits until the callbacks that are being called on other threads return, so the function is not called after this method returns.
+  */
+  void RemoveItemAddedCallback(unsigned long callbackId);
+
+  /*!
+    Get the histogram of the time between the unfiltered timestamp of the items and the time when they were added to the buffer.
+    The unfiltered timestamp is the time that the device assigned to the data, or the time when the item was added if the device
+    did not specify it, so the latency of devices that timestamp the data only when they add it to the buffer is close to 0.
+  */
+  const PlusLatencyHistogram& GetCommitLatencyHistogram() const;
+
   /*! Set the frame size in pixel  */
   PlusStatus SetFrameSize(unsigned int x, unsigned int y, unsigned int z, bool allocateFrames = true);
   /*! Set the frame size in pixel  */
@@ -294,7 +479,10 @@ public:
   /*! Get the image type (B-mode, RF, ...) */
   vtkGetMacro(ImageType, US_IMAGE_TYPE);
 
-  /*! Set the image orientation (MF, MN, ...). Does not reorder the pixels. */
+  /*!
+    Set the image orientation (MF, MN, ...). Frames that are already in the buffer are not modified,
+    they are converted to the new orientation when they are retrieved.
+  */
   PlusStatus SetImageOrientation(US_IMAGE_ORIENTATION imageOrientation);
   /*! Get the image orientation (MF, MN, ...) */
   vtkGetMacro(ImageOrientation, US_IMAGE_ORIENTATION);
@@ -314,6 +502,39 @@ public:
   /*! Dump the current state of the video buffer to metafile */
   virtual PlusStatus WriteToSequenceFile(const char* filename, bool useCompression = false);
 
+  /*! Items of the buffer at the time when the snapshot was taken (see GetSnapshot) */
+  struct Snapshot
+  {
+    Snapshot()
+      : LocalTimeOffsetSec(0.0)
+      , ImageOrientation(US_IMG_ORIENT_XX)
+      , PixelType(VTK_UNSIGNED_CHAR)
+      , NumberOfScalarComponents(1)
+    {
+    }
+    /*! Items ordered by UID */
+    std::vector<StreamBufferItemView> Items;
+    double LocalTimeOffsetSec;
+    US_IMAGE_ORIENTATION ImageOrientation;
+    igsioCommon::VTKScalarPixelType PixelType;
+    unsigned int NumberOfScalarComponents;
+  };
+  /*!
+    Take a snapshot of all the items of the buffer without copying the items in memory. The items in memory are pinned
+    while the buffer is locked once: the snapshot references them the same way as GetStreamBufferItemView, so when
+    the buffer overwrites a pinned item it writes the new item into newly allocated memory instead. Acquisition therefore
+    continues while the snapshot is processed and no item is lost, but the snapshot should be released as soon as possible,
+    because each overwritten pinned item costs an extra frame allocation. Items in the spill file are copied after
+    the items in memory are pinned, spilled items that are overwritten in the file in the meantime are left out.
+    Frames that are not reoriented yet (see SetLazyImageOrientation) are reoriented when the snapshot is written.
+  */
+  PlusStatus GetSnapshot(Snapshot& snapshot);
+  /*!
+    Write the items of a snapshot to a sequence file. The buffer is not accessed, therefore the snapshot can be written
+    on any thread, even after the buffer is deleted.
+  */
+  static PlusStatus WriteSnapshotToSequenceFile(const Snapshot& snapshot, const char* filename, bool useCompression = false);
+
   vtkGetStringMacro(DescriptiveName);
   vtkSetStringMacro(DescriptiveName);
 
@@ -321,17 +542,242 @@ protected:
   vtkPlusBuffer();
   ~vtkPlusBuffer();
 
-  /*! Update video buffer by setting the frame format for each frame  */
+  /*!
+    Update video buffer by setting the frame format for each frame.
+    The pixel data of the frames is stored in a single frame arena, which is reallocated if the frame format or the buffer size changes.
+  */
   virtual PlusStatus AllocateMemoryForFrames();
 
+  /*!
+    Get a frame arena for the current frame format and the specified number of slots.
+    The current arena is returned if it matches, otherwise a new arena is allocated and pre-faulted.
+    Returns NULL if the items have no frames or the allocation failed. Does not lock the buffer.
+  */
+  std::shared_ptr<PlusFrameArena> PrepareFrameArena(int bufferSize);
+
+  /*!
+    Set up the frame memory of an item: bind it to the frame arena or allocate it if there is no arena
+    or the arena slot is still used by a replaced item (see IsArenaSlotInUse).
+    The caller must have locked the stream buffer.
+  */
+  PlusStatus SetUpFrameMemory(StreamBufferItem* item, int bufferIndex, bool keepContent);
+
+  /*!
+    Set the frame arena. The slots of a new arena are not used by any item yet.
+    The caller must have locked the stream buffer.
+  */
+  void SetFrameArena(const std::shared_ptr<PlusFrameArena>& frameArena);
+
+  /*!
+    Record that an item that has been replaced in the buffer while it was referenced by a view (see GetWritableBufferItem)
+    still uses its slot of the frame arena. The slot is returned to the arena when the item is released.
+    The caller must have locked the stream buffer.
+  */
+  void SetArenaSlotUser(int slotIndex, const StreamBufferItemView& replacedItem);
+
+  /*!
+    Returns true if the arena slot is used by a replaced item that is still referenced by a view, so other items cannot use the slot.
+    The caller must have locked the stream buffer.
+  */
+  bool IsArenaSlotInUse(int slotIndex) const;
+
+  /*!
+    Make the pixel data of the frame of the item point to a slot of the frame arena.
+    If the frame already has pixel data in the buffer frame format then it is copied into the slot (if keepContent is true),
+    otherwise the frame is set up directly in the slot, without allocating any other memory.
+    The caller must have locked the stream buffer.
+  */
+  PlusStatus BindFrameToArena(StreamBufferItem* item, int slotIndex, bool keepContent = true);
+
+  /*! Rebuild ItemAddedCallbacksSnapshot from ItemAddedCallbacks */
+  void UpdateItemAddedCallbacksSnapshot();
+
+  /*! Call all the registered item added callbacks. The buffer must not be locked by the caller. */
+  void InvokeItemAddedCallbacks(BufferItemUidType uid, double filteredTimestamp);
+
+  /*!
+    \class ItemAddedNotification
+    \brief Calls the item added callbacks when it goes out of scope, if an item was added
+
+    Declare it before the buffer lock guard, so that the callbacks are called after the buffer is unlocked.
+  */
+  class ItemAddedNotification
+  {
+  public:
+    ItemAddedNotification(vtkPlusBuffer* buffer)
+      : Buffer(buffer)
+      , ItemUid(0)
+      , FilteredTimestamp(UNDEFINED_TIMESTAMP)
+      , ItemAdded(false)
+    {
+    }
+    ~ItemAddedNotification()
+    {
+      if (this->ItemAdded)
+      {
+        this->Buffer->InvokeItemAddedCallbacks(this->ItemUid, this->FilteredTimestamp);
+      }
+    }
+    /*! Set the item that has been added to the buffer */
+    void SetItem(BufferItemUidType uid, double filteredTimestamp)
+    {
+      this->ItemUid = uid;
+      this->FilteredTimestamp = filteredTimestamp;
+      this->ItemAdded = true;
+    }
+  private:
+    ItemAddedNotification(const ItemAddedNotification&);
+    ItemAddedNotification& operator=(const ItemAddedNotification&);
+    vtkPlusBuffer* Buffer;
+    BufferItemUidType ItemUid;
+    double FilteredTimestamp;
+    bool ItemAdded;
+  };
+
+  /*!
+    Get the buffer item where a new item can be written.
+    If the slot is still referenced by a view then a new item is created for the slot. The new item gets its own frame memory,
+    because the referenced item still uses the arena slot, and it keeps writing into that memory until the referenced item
+    is released. Then the item is moved back to the arena slot when it is overwritten next time.
+    The caller must have locked the stream buffer.
+  */
+  StreamBufferItem* GetWritableBufferItem(int bufferIndex);
+
+  /*!
+    Get the frame fields of the item that was added before the item at bufferIndex, so that field values
+    that have not changed can be shared with it. Returns NULL if there is no previous item in the buffer.
+    The caller must have locked the stream buffer.
+  */
+  const PlusFrameFieldStore* GetPreviousItemFrameFields(int bufferIndex, BufferItemUidType itemUid);
+
   /*!
     Compares frame format with new frame imaging parameters.
     \return true if current buffer frame format matches the method arguments, otherwise false
   */
   virtual bool CheckFrameFormat(const FrameSizeType& frameSizeInPx, igsioCommon::VTKScalarPixelType pixelType, US_IMAGE_TYPE imgType, int numberOfScalarComponents);
 
-  /*! Returns the two buffer items that are closest previous and next buffer items relative to the specified time. itemA is the closest item */
-  PlusStatus GetPrevNextBufferItemFromTime(double time, StreamBufferItem& itemA, StreamBufferItem& itemB);
+  /*!
+    Common implementation of the AddItem overloads that take an image data pointer.
+    If inputEncoding is PixelEncoding_ERROR then the image is already in the pixel format of the buffer,
+    otherwise it is converted from inputEncoding while it is copied into the buffer (pixelType and numberOfScalarComponents
+    then describe the converted image). Conversion is not supported with transposing or clipping.
+  */
+  PlusStatus AddImageItem(void* imageDataPtr,
+                          PixelCodec::PixelEncoding inputEncoding,
+                          US_IMAGE_ORIENTATION usImageOrientation,
+                          const FrameSizeType& inputFrameSizeInPx,
+                          igsioCommon::VTKScalarPixelType pixelType,
+                          unsigned int numberOfScalarComponents,
+                          US_IMAGE_TYPE imageType,
+                          int numberOfBytesToSkip,
+                          long frameNumber,
+                          const std::array<int, 3>& clipRectangleOrigin,
+                          const std::array<int, 3>& clipRectangleSize,
+                          double unfilteredTimestamp,
+                          double filteredTimestamp,
+                          const igsioFieldMapType* customFields,
+                          vtkStreamingVolumeFrame* encodedFrame);
+
+  /*!
+    Reorient the frame of the item to the image orientation of the buffer, if it was stored in a different orientation
+    (see SetLazyImageOrientation). The caller must have locked the stream buffer.
+  */
+  PlusStatus ReorientItemFrame(StreamBufferItem* item);
+
+  /*!
+    Reorient a frame that is stored in a different orientation. Frames that need transposing cannot be reoriented.
+    \param scratch Memory that holds a copy of the pixels while the frame is reoriented
+  */
+  static PlusStatus ReorientFrame(igsioVideoFrame& frame, US_IMAGE_ORIENTATION imageOrientation, igsioCommon::VTKScalarPixelType pixelType,
+                                  unsigned int numberOfScalarComponents, std::vector<unsigned char>& scratch);
+
+  /*! Returns true if the frame of the item is stored in a different orientation than the image orientation of the buffer */
+  bool IsReorientationNeeded(const StreamBufferItem& item) const;
+
+  /*!
+    Get a view of an item that is in memory, with its frame reoriented to the image orientation of the buffer (see SetLazyImageOrientation).
+    If the item is not referenced by a view then it is reoriented in place. Otherwise a copy is reoriented while the buffer is unlocked
+    (so that the referenced item is not modified and the producer is not blocked) and the copy is kept in ReorientedItems,
+    so that the item is not reoriented again when it is retrieved next time. Locks the buffer, which must not be locked by the caller.
+  */
+  ItemStatus GetReorientedBufferItemView(BufferItemUidType uid, StreamBufferItemView& bufferItemView);
+
+  /*!
+    Get a view of an item that is stored as an object in memory. The view is empty if the item is spilled or stored in the compact transform storage.
+    The buffer must be locked by the caller, the view keeps the item unchanged after the buffer is unlocked.
+  */
+  ItemStatus GetStoredBufferItemView(BufferItemUidType uid, StreamBufferItemView& bufferItemView);
+
+  /*!
+    Copy an item into bufferItem from a view that was taken by GetStoredBufferItemView. If the view is empty or the frame
+    has to be reoriented then the item is retrieved by its uid. The buffer must not be locked by the caller, so that the
+    producer is not blocked while the item is copied or reoriented.
+  */
+  ItemStatus CopyStreamBufferItemFromView(BufferItemUidType uid, StreamBufferItemView& bufferItemView, StreamBufferItem* bufferItem);
+
+  /*! Poses that are waiting to be interpolated. The poses are interpolated together when the batch is full or flushed. */
+  struct PoseInterpolationBatch
+  {
+    int NumberOfPoses;
+    vtkPlusBuffer* Buffers[PlusPoseInterpolator::BLOCK_SIZE];
+    PlusInterpolatedPose* Poses[PlusPoseInterpolator::BLOCK_SIZE];
+    double MatricesA[PlusPoseInterpolator::BLOCK_SIZE * 16];
+    double MatricesB[PlusPoseInterpolator::BLOCK_SIZE * 16];
+    double WeightsB[PlusPoseInterpolator::BLOCK_SIZE];
+    double InterpolatedMatrices[PlusPoseInterpolator::BLOCK_SIZE * 16];
+    double AngleDifferencesDeg[PlusPoseInterpolator::BLOCK_SIZE];
+    PoseInterpolationBatch() : NumberOfPoses(0) {}
+  };
+
+  /*! Copy the transform, status, and timestamps of a buffer item to a pose, without copying the item */
+  ItemStatus GetPoseFromUid(BufferItemUidType uid, PlusInterpolatedPose& pose);
+  static void GetPoseFromItem(const StreamBufferItem& item, PlusInterpolatedPose& pose);
+
+  /*!
+    Returns the poses of the closest previous and next buffer items relative to the specified time. poseA is the closest item.
+    If closestItemUid is not NULL then it is the UID of the closest item, which has already been found by the caller.
+  */
+  PlusStatus GetPrevNextPosesFromTime(double time, PlusInterpolatedPose& poseA, PlusInterpolatedPose& poseB, const BufferItemUidType* closestItemUid = NULL);
+
+  /*!
+    Determine the pose at the specified time. If the pose has to be interpolated then it is added to the batch
+    and its matrix is only valid after the batch is flushed by InterpolatePoseBatch.
+    If closestItemUid is not NULL then it is the UID of the closest item, which has already been found by the caller.
+  */
+  ItemStatus AddPoseToInterpolationBatch(double time, PlusInterpolatedPose& pose, PoseInterpolationBatch& batch, const BufferItemUidType* closestItemUid = NULL);
+
+  /*! Interpolate all the poses in the batch and empty the batch */
+  static void InterpolatePoseBatch(PoseInterpolationBatch& batch);
+
+  /*! Returns true if the item is older than the items in memory and so it has to be retrieved from the spill file */
+  bool IsItemSpilled(BufferItemUidType uid);
+  /*!
+    Read an item from the spill file. Frames are written to the file in the image orientation of the buffer,
+    they are only reoriented if the orientation has been changed since then. Locks the spill file only, the buffer does not have to be locked.
+  */
+  ItemStatus GetSpilledItem(BufferItemUidType uid, StreamBufferItem* bufferItem);
+  /*! Copy an item that is in memory, without logging a warning if the item is not available */
+  ItemStatus GetStreamBufferItemFromMemory(BufferItemUidType uid, StreamBufferItem* bufferItem);
+  /*! Replace the spill file (NULL disables spilling). The spill writer thread must be stopped. */
+  void SetSpillFile(PlusBufferSpillFile* spillFile);
+
+  /*! Start the thread that writes the items to the spill file */
+  void StartSpillWriterThread();
+  /*! Stop the spill writer thread and wait until it terminates */
+  void StopSpillWriterThread();
+  static void* SpillWriterThread(vtkMultiThreader::ThreadInfo* data);
+  /*! Get the UID of the item that is the closest to the specified time, from the memory or the spill file */
+  ItemStatus GetItemUidFromTimeInAnyTier(double time, BufferItemUidType& uid);
+  /*! Get the UIDs of the items that are the closest to multiple timestamps, from the memory or the spill file */
+  void GetItemUidsFromTimesInAnyTier(const double* times, int numberOfTimes, BufferItemUidType* uids, ItemStatus* statuses);
+
+  /*! Remember the requested time for computing the consumer lag */
+  void RecordRequestedTime(double time);
+  /*! Count the requests that failed because the item had already been overwritten */
+  void RecordRequestStatus(ItemStatus status);
+
+  /*! Log a warning if the interpolated orientation differs a lot from the orientations that it was interpolated from */
+  void CheckInterpolatedOrientationDifference(double angleDiffA, double angleDiffB);
 
   /*!
   Interpolate the matrix for the given timestamp from the two nearest transforms in the buffer.
@@ -371,6 +817,82 @@ protected:
 
   char* DescriptiveName;
 
+  /*! Contiguous memory that holds the pixel data of all the frames of the buffer */
+  std::shared_ptr<PlusFrameArena> FrameArena;
+  /*!
+    Items that have been replaced in the buffer while they were referenced by a view and that still use a slot of FrameArena,
+    indexed by slot (see SetArenaSlotUser). Guarded by the buffer lock.
+  */
+  std::vector<std::weak_ptr<const StreamBufferItem> > ArenaSlotUsers;
+
+  /*! Back the frame arena by transparent huge pages */
+  bool UseHugePages;
+
+  /*! Lock the frame arena in physical memory */
+  bool LockFrameMemory;
+
+  /*! Store frames in the orientation they are added in and reorient them when they are retrieved */
+  bool LazyImageOrientation;
+
+  /*! Time from the unfiltered timestamp of the item until it is added to the buffer */
+  PlusLatencyHistogram CommitLatencyHistogram;
+  /*! Copy of the frame that is being reoriented, frames cannot be reoriented in place */
+  std::vector<unsigned char> ReorientationScratch;
+  /*!
+    Reoriented copies of items that were referenced by a view when they were retrieved (see GetReorientedBufferItemView),
+    indexed by UID. Guarded by the buffer lock. Copies of items that are not in the buffer anymore are removed when a new copy is added
+    and when the slot of the item is reused, so there are at most as many copies as items in the buffer.
+  */
+  std::map<BufferItemUidType, StreamBufferItemView> ReorientedItems;
+  /*! Converted frame that has to be transposed or clipped before it is added, reused to avoid allocation for each frame */
+  std::vector<unsigned char> ConversionScratch;
+  std::mutex ConversionScratchMutex;
+
+  /*!
+    File that holds the items that have been overwritten in memory, NULL if items are not spilled.
+    The pointer is only changed while the spill writer is stopped and SpillWriterMutex, the buffer, and SpillFileMutex are locked.
+    The content of the file is accessed while SpillFileMutex is locked. The mutexes are always locked in this order.
+  */
+  std::unique_ptr<PlusBufferSpillFile> SpillFile;
+  /*! Serializes writing items to the spill file (see SpillPendingItems) */
+  std::mutex SpillWriterMutex;
+  /*! Guards the content of the spill file */
+  std::mutex SpillFileMutex;
+  /*! UID of the next item that is written to the spill file, guarded by SpillWriterMutex */
+  BufferItemUidType NextUidToSpill;
+  /*! True if the spill file is not empty, allows checking if items have to be looked up in the spill file without locking */
+  std::atomic<bool> HasSpilledItems;
+  /*! Copy of the spilled frame that is being reoriented, guarded by SpillFileMutex */
+  std::vector<unsigned char> SpillReorientationScratch;
+  /*! Reoriented copy of the item that is being written to the spill file, guarded by SpillWriterMutex */
+  StreamBufferItem SpillWriterReorientedItem;
+  /*! Copy of the frame that is being reoriented by the spill writer, guarded by SpillWriterMutex */
+  std::vector<unsigned char> SpillWriterReorientationScratch;
+  vtkSmartPointer<vtkMultiThreader> SpillWriterThreader;
+  int SpillWriterThreadId;
+  /*! Requests the spill writer thread to keep running */
+  std::atomic<bool> SpillWriterThreadActive;
+  /*! True until the spill writer thread terminates */
+  std::atomic<bool> SpillWriterThreadAlive;
+
+  /*! Functions that are called after a new item is added to the buffer */
+  std::map<unsigned long, ItemAddedCallbackType> ItemAddedCallbacks;
+  /*! Copy of the callbacks that is invoked without holding ItemAddedCallbacksMutex, replaced when a callback is added or removed */
+  std::shared_ptr<const std::vector<ItemAddedCallbackType> > ItemAddedCallbacksSnapshot;
+  vtkIGSIORecursiveCriticalSection* ItemAddedCallbacksMutex;
+  unsigned long NextItemAddedCallbackId;
+  /*! Number of threads that are calling item added callbacks, RemoveItemAddedCallback waits until it is 0 */
+  int NumberOfItemAddedCallbackInvocations;
+  std::mutex ItemAddedCallbackInvocationsMutex;
+  std::condition_variable ItemAddedCallbackInvocationsCondition;
+  /*! Number of item added callbacks, allows checking if there are any callbacks without locking */
+  std::atomic<size_t> NumberOfItemAddedCallbacks;
+
+  /*! Oldest timestamp that was requested since the consumer lag was reset (DBL_MAX if none) */
+  std::atomic<double> OldestRequestedTimestamp;
+  /*! Number of requests for already overwritten items since the consumer lag was reset */
+  std::atomic<int> NumberOfItemsNotAvailableAnymore;
+
 private:
   vtkPlusBuffer(const vtkPlusBuffer&);
   void operator=(const vtkPlusBuffer&);
@@ -13,14 +13,22 @@ See License.txt for details.
 #include "vtkPlusChannel.h"
 #include "vtkPlusDataSource.h"
 #include "vtkPlusHTMLGenerator.h"
+#include "vtkIGSIORecursiveCriticalSection.h"
 #include "vtkIGSIOTrackedFrameList.h"
 
 // VTK includes
+#include <vtkDoubleArray.h>
 #include <vtkImageData.h>
 #include <vtkMatrix4x4.h>
 #include <vtkObjectFactory.h>
 #include <vtkTable.h>
 
+// STL includes
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+
 //----------------------------------------------------------------------------
 
 vtkStandardNewMacro(vtkPlusChannel);
@@ -31,6 +39,44 @@ vtkStandardNewMacro(vtkPlusChannel);
 // This time should be long enough to comfortably retrieve a frame from the buffer.
 static const double SAMPLING_SKIPPING_MARGIN_SEC = 0.1;
 
+// Number of frames that GetTrackedFrameListSampled retrieves at once. The time limit is checked between the batches,
+// and the buffers have to keep this many items referenced while they are copied.
+static const size_t SAMPLING_BATCH_SIZE = 8;
+
+#ifdef PLUS_RENDERING_ENABLED
+namespace
+{
+  //----------------------------------------------------------------------------
+  // Statistics of the TimestampJitter column of a timestamp report table, for comparing acquisition settings
+  std::string GetTimestampJitterSummary(vtkTable* timestampReportTable)
+  {
+    vtkDoubleArray* jitter = vtkDoubleArray::SafeDownCast(timestampReportTable->GetColumnByName("TimestampJitter"));
+    if (jitter == NULL || jitter->GetNumberOfTuples() == 0)
+    {
+      return "Timestamp jitter: no data";
+    }
+    double sum(0.0);
+    double sumOfSquares(0.0);
+    double maximumAbsolute(0.0);
+    const vtkIdType numberOfValues = jitter->GetNumberOfTuples();
+    for (vtkIdType i = 0; i < numberOfValues; ++i)
+    {
+      const double value = jitter->GetValue(i);
+      sum += value;
+      sumOfSquares += value * value;
+      maximumAbsolute = std::max(maximumAbsolute, std::fabs(value));
+    }
+    const double mean = sum / numberOfValues;
+    const double standardDeviation = std::sqrt(std::max(0.0, sumOfSquares / numberOfValues - mean * mean));
+    std::ostringstream summary;
+    summary << std::fixed << std::setprecision(3) << "Timestamp jitter (unfiltered minus filtered timestamp): mean " << mean * 1000.0
+            << " ms, standard deviation " << standardDeviation * 1000.0 << " ms, maximum absolute " << maximumAbsolute * 1000.0
+            << " ms (" << numberOfValues << " items)";
+    return summary.str();
+  }
+}
+#endif
+
 //----------------------------------------------------------------------------
 vtkPlusChannel::vtkPlusChannel(void)
   : VideoSource(NULL)
@@ -39,6 +85,12 @@ vtkPlusChannel::vtkPlusChannel(void)
   , RfProcessor(NULL)
   , BlankImage(vtkImageData::New())
   , SaveRfProcessingParameters(false)
+  , NextNewFrameCallbackId(1)
+  , NewFrameCallbacksMutex(vtkIGSIORecursiveCriticalSection::New())
+  , NewFrameSubscribedSourceCallbackId(0)
+  , NewFrameSubscriptionRequested(false)
+  , NewFrameSubscriptionMutex(vtkIGSIORecursiveCriticalSection::New())
+  , NewFrameSequenceNumber(0)
 {
   // Default size for brightness frame
   this->BrightnessFrameSize[0] = 640;
@@ -58,6 +110,10 @@ vtkPlusChannel::vtkPlusChannel(void)
 //----------------------------------------------------------------------------
 vtkPlusChannel::~vtkPlusChannel(void)
 {
+  this->RemoveNewFrameSubscription();
+  DELETE_IF_NOT_NULL(this->NewFrameSubscriptionMutex);
+  DELETE_IF_NOT_NULL(this->NewFrameCallbacksMutex);
+
   this->VideoSource = NULL;
   this->Tools.clear();
   this->FieldDataSources.clear();
@@ -137,6 +193,7 @@ PlusStatus vtkPlusChannel::ReadConfiguration(vtkXMLDataElement* aChannelElement,
     LOG_ERROR("Unable to find video data source that matches Id: " << aChannelElement->GetAttribute("VideoDataSourceId"));
     return PLUS_FAIL;
   }
+  this->RefreshNewFrameSubscription();
 
   vtkXMLDataElement* rfElement = aChannelElement->FindNestedElementWithName(vtkPlusRfProcessor::GetRfProcessorTagName());
   if (rfElement != NULL)
@@ -301,6 +358,7 @@ PlusStatus vtkPlusChannel::AddTool(vtkPlusDataSource* aTool)
     // (the first item in the std::map is not the first added tool but depends on the source ID)
     this->TimestampMasterTool = aTool;
   }
+  this->RefreshNewFrameSubscription();
 
   return PLUS_SUCCESS;
 }
@@ -318,12 +376,13 @@ PlusStatus vtkPlusChannel::RemoveTool(const std::string& toolSourceId)
   {
     if (it->second->GetId() == toolSourceId)
     {
-      this->Tools.erase(it);
       if (this->TimestampMasterTool == it->second)
       {
         // the master tool has been deleted
         this->TimestampMasterTool = NULL;
       }
+      this->Tools.erase(it);
+      this->RefreshNewFrameSubscription();
       return PLUS_SUCCESS;
     }
   }
@@ -335,6 +394,8 @@ PlusStatus vtkPlusChannel::RemoveTool(const std::string& toolSourceId)
 PlusStatus vtkPlusChannel::RemoveTools()
 {
   this->Tools.clear();
+  this->TimestampMasterTool = NULL;
+  this->RefreshNewFrameSubscription();
 
   return PLUS_SUCCESS;
 }
@@ -359,6 +420,7 @@ PlusStatus vtkPlusChannel::AddFieldDataSource(vtkPlusDataSource* aSource)
 
   this->FieldDataSources[aSource->GetId()] = aSource;
   this->FieldDataSources[aSource->GetId()]->Register(this);
+  this->RefreshNewFrameSubscription();
 
   return PLUS_SUCCESS;
 }
@@ -377,6 +439,7 @@ PlusStatus vtkPlusChannel::RemoveFieldDataSource(const std::string& sourceId)
     if (it->second->GetId() == sourceId)
     {
       this->FieldDataSources.erase(it);
+      this->RefreshNewFrameSubscription();
       return PLUS_SUCCESS;
     }
   }
@@ -409,6 +472,7 @@ PlusStatus vtkPlusChannel::GetFieldDataSource(vtkPlusDataSource*& aSource, const
 PlusStatus vtkPlusChannel::RemoveFieldDataSources()
 {
   this->FieldDataSources.clear();
+  this->RefreshNewFrameSubscription();
 
   return PLUS_SUCCESS;
 }
@@ -429,6 +493,7 @@ PlusStatus vtkPlusChannel::Clear()
   {
     it->second->Clear();
   }
+  this->RefreshNewFrameSubscription();
   return PLUS_SUCCESS;
 }
 
@@ -500,7 +565,7 @@ void vtkPlusChannel::ShallowCopy(const vtkPlusChannel& aChannel)
   vtkPlusDataSource* aSource = NULL;
   if (aChannel.HasVideoSource() && aChannel.GetVideoSource(aSource))
   {
-    this->VideoSource = aSource;
+    this->SetVideoSource(aSource);
   }
   for (DataSourceContainerConstIterator it = aChannel.GetToolsStartConstIterator(); it != aChannel.GetToolsEndConstIterator(); ++it)
   {
@@ -524,14 +589,77 @@ void vtkPlusChannel::ShallowCopy(const vtkPlusChannel& aChannel)
 void vtkPlusChannel::SetVideoSource(vtkPlusDataSource* aSource)
 {
   this->VideoSource = aSource;
+  this->RefreshNewFrameSubscription();
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusChannel::TrackedFrameView::CopyToTrackedFrame(igsioTrackedFrame& aTrackedFrame) const
+{
+  int numberOfErrors(0);
+
+  if (this->VideoItem)
+  {
+    aTrackedFrame.SetImageData(this->VideoItem->GetFrame());
+  }
+
+  for (std::vector<ToolTransform>::const_iterator it = this->ToolTransforms.begin(); it != this->ToolTransforms.end(); ++it)
+  {
+    if (aTrackedFrame.SetFrameTransform(it->Name, it->Matrix) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to set transform for tool " << it->Name.GetTransformName());
+      numberOfErrors++;
+      continue;
+    }
+
+    if (aTrackedFrame.SetFrameTransformStatus(it->Name, it->Status) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to set transform status for tool " << it->Name.GetTransformName());
+      numberOfErrors++;
+      continue;
+    }
+  }
+
+  const std::vector<PlusFrameFieldStore::Field>& fields = this->FrameFields.GetFields();
+  for (std::vector<PlusFrameFieldStore::Field>::const_iterator fieldIterator = fields.begin(); fieldIterator != fields.end(); ++fieldIterator)
+  {
+    aTrackedFrame.SetFrameField(*(fieldIterator->Name), *(fieldIterator->Value), fieldIterator->Flags);
+  }
+
+  aTrackedFrame.SetTimestamp(this->Timestamp);
+
+  return (numberOfErrors == 0 ? PLUS_SUCCESS : PLUS_FAIL);
 }
 
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusChannel::GetTrackedFrame(double timestamp, igsioTrackedFrame& aTrackedFrame, bool enableImageData/*=true*/)
+{
+  TrackedFrameView trackedFrameView;
+  PlusStatus status = this->GetTrackedFrameView(timestamp, trackedFrameView, enableImageData);
+  if (trackedFrameView.Timestamp == UNDEFINED_TIMESTAMP)
+  {
+    // nothing could be retrieved
+    return PLUS_FAIL;
+  }
+
+  if (trackedFrameView.CopyToTrackedFrame(aTrackedFrame) != PLUS_SUCCESS)
+  {
+    status = PLUS_FAIL;
+  }
+
+  return status;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusChannel::GetTrackedFrameView(double timestamp, TrackedFrameView& trackedFrameView, bool enableImageData/*=true*/)
 {
   int numberOfErrors(0);
   double synchronizedTimestamp(0);
 
+  trackedFrameView.Timestamp = UNDEFINED_TIMESTAMP;
+  trackedFrameView.VideoItem.reset();
+  trackedFrameView.ToolTransforms.clear();
+  trackedFrameView.FrameFields.Clear();
+
   // Get frame UID
   if (this->HasVideoSource() && enableImageData)
   {
@@ -562,25 +690,17 @@ PlusStatus vtkPlusChannel::GetTrackedFrame(double timestamp, igsioTrackedFrame&
       return PLUS_FAIL;
     }
 
-    StreamBufferItem CurrentStreamBufferItem;
-    if (this->VideoSource->GetStreamBufferItem(frameUID, &CurrentStreamBufferItem) != ITEM_OK)
+    // Get a reference to the frame, it is not copied
+    if (this->VideoSource->GetStreamBufferItemView(frameUID, trackedFrameView.VideoItem) != ITEM_OK)
     {
       LOG_ERROR("Couldn't get video buffer item by frame UID: " << frameUID);
       return PLUS_FAIL;
     }
 
-    // Copy frame
-    igsioVideoFrame frame = CurrentStreamBufferItem.GetFrame();
-    aTrackedFrame.SetImageData(frame);
-
     // Copy all custom fields
-    igsioFieldMapType fieldMap = CurrentStreamBufferItem.GetFrameFieldMap();
-    for (igsioFieldMapType::const_iterator fieldIterator = fieldMap.begin(); fieldIterator != fieldMap.end(); fieldIterator++)
-    {
-      aTrackedFrame.SetFrameField((*fieldIterator).first, (*fieldIterator).second.second, fieldIterator->second.first);
-    }
+    trackedFrameView.FrameFields = trackedFrameView.VideoItem->GetFrameFieldStore();
 
-    synchronizedTimestamp = CurrentStreamBufferItem.GetTimestamp(this->VideoSource->GetLocalTimeOffsetSec());
+    synchronizedTimestamp = trackedFrameView.VideoItem->GetTimestamp(this->VideoSource->GetLocalTimeOffsetSec());
   }
 
   if (synchronizedTimestamp == 0)
@@ -589,8 +709,11 @@ PlusStatus vtkPlusChannel::GetTrackedFrame(double timestamp, igsioTrackedFrame&
   }
 
   // Add main tool timestamp
-  aTrackedFrame.SetTimestamp(synchronizedTimestamp);
+  trackedFrameView.Timestamp = synchronizedTimestamp;
 
+  // Interpolate the poses of all the tools together
+  std::vector<vtkPlusDataSource*> tools;
+  std::vector<igsioTransformName> toolTransformNames;
   for (DataSourceContainerConstIterator it = this->GetToolsStartIterator(); it != this->GetToolsEndIterator(); ++it)
   {
     vtkPlusDataSource* aTool = it->second;
@@ -601,10 +724,21 @@ PlusStatus vtkPlusChannel::GetTrackedFrame(double timestamp, igsioTrackedFrame&
       numberOfErrors++;
       continue;
     }
+    tools.push_back(aTool);
+    toolTransformNames.push_back(toolTransformName);
+  }
+  std::vector<PlusInterpolatedPose> toolPoses(tools.size());
+  if (!tools.empty())
+  {
+    vtkPlusDataSource::GetInterpolatedPosesFromTime(synchronizedTimestamp, &tools[0], static_cast<int>(tools.size()), &toolPoses[0]);
+  }
 
-    StreamBufferItem bufferItem;
-    ItemStatus result = aTool->GetStreamBufferItemFromTime(synchronizedTimestamp, &bufferItem, vtkPlusBuffer::INTERPOLATED);
-    if (result != ITEM_OK)
+  double toolsSynchronizedTimestamp = synchronizedTimestamp;
+  for (size_t toolIndex = 0; toolIndex < tools.size(); ++toolIndex)
+  {
+    vtkPlusDataSource* aTool = tools[toolIndex];
+    const PlusInterpolatedPose& toolPose = toolPoses[toolIndex];
+    if (toolPose.Result != ITEM_OK)
     {
       double latestTimestamp(0);
       if (aTool->GetLatestTimeStamp(latestTimestamp) != ITEM_OK)
@@ -625,38 +759,29 @@ PlusStatus vtkPlusChannel::GetTrackedFrame(double timestamp, igsioTrackedFrame&
       continue;
     }
 
-    vtkSmartPointer<vtkMatrix4x4> dMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
-    if (bufferItem.GetMatrix(dMatrix) != PLUS_SUCCESS)
-    {
-      LOG_ERROR("Failed to get matrix from buffer item for tool " << aTool->GetId());
-      numberOfErrors++;
-      continue;
-    }
-
-    if (aTrackedFrame.SetFrameTransform(toolTransformName, dMatrix) != PLUS_SUCCESS)
-    {
-      LOG_ERROR("Failed to set transform for tool " << aTool->GetId());
-      numberOfErrors++;
-      continue;
-    }
-
-    if (aTrackedFrame.SetFrameTransformStatus(toolTransformName, bufferItem.GetStatus()) != PLUS_SUCCESS)
-    {
-      LOG_ERROR("Failed to set transform status for tool " << aTool->GetId());
-      numberOfErrors++;
-      continue;
-    }
+    TrackedFrameView::ToolTransform toolTransform;
+    toolTransform.Name = toolTransformNames[toolIndex];
+    toolTransform.Matrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    toolTransform.Matrix->DeepCopy(toolPose.Matrix);
+    toolTransform.Status = toolPose.Status;
+    trackedFrameView.ToolTransforms.push_back(toolTransform);
 
-    // Copy all custom fields
-    igsioFieldMapType fieldMap = bufferItem.GetFrameFieldMap();
-    igsioFieldMapType::iterator fieldIterator;
-    for (igsioFieldMapType::const_iterator fieldIterator = fieldMap.begin(); fieldIterator != fieldMap.end(); fieldIterator++)
+    // Copy all custom fields, the item is only retrieved if it has any
+    if (toolPose.HasFrameFields)
     {
-      aTrackedFrame.SetFrameField(fieldIterator->first, fieldIterator->second.second, fieldIterator->second.first);
+      StreamBufferItem bufferItem;
+      if (aTool->GetStreamBufferItem(toolPose.Uid, &bufferItem) != ITEM_OK)
+      {
+        LOG_ERROR("Failed to get custom fields from buffer item for tool " << aTool->GetId());
+        numberOfErrors++;
+        continue;
+      }
+      trackedFrameView.FrameFields.SetFields(bufferItem.GetFrameFieldStore());
     }
 
-    synchronizedTimestamp = bufferItem.GetTimestamp(aTool->GetLocalTimeOffsetSec());
+    toolsSynchronizedTimestamp = toolPose.GetTimestamp(aTool->GetLocalTimeOffsetSec());
   }
+  synchronizedTimestamp = toolsSynchronizedTimestamp;
 
   for (DataSourceContainerConstIterator it = this->GetFieldDataSourcesStartIterator(); it != this->GetFieldDataSourcesEndIterator(); ++it)
   {
@@ -686,17 +811,200 @@ PlusStatus vtkPlusChannel::GetTrackedFrame(double timestamp, igsioTrackedFrame&
     }
 
     // Copy all custom fields
-    igsioFieldMapType fieldMap = bufferItem.GetFrameFieldMap();
-    for (igsioFieldMapType::const_iterator fieldIterator = fieldMap.begin(); fieldIterator != fieldMap.end(); fieldIterator++)
-    {
-      aTrackedFrame.SetFrameField(fieldIterator->first, fieldIterator->second.second, fieldIterator->second.first);
-    }
+    trackedFrameView.FrameFields.SetFields(bufferItem.GetFrameFieldStore());
 
     synchronizedTimestamp = bufferItem.GetTimestamp(aSource->GetLocalTimeOffsetSec());
   }
 
   // Copy frame timestamp
-  aTrackedFrame.SetTimestamp(synchronizedTimestamp);
+  trackedFrameView.Timestamp = synchronizedTimestamp;
+  this->ReadLatencyHistogram.RecordLatency(PlusClock::GetSystemTime() - synchronizedTimestamp);
+
+  return (numberOfErrors == 0 ? PLUS_SUCCESS : PLUS_FAIL);
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusChannel::GetTrackedFrames(const std::vector<double>& timestamps, vtkIGSIOTrackedFrameList* aTrackedFrameList, bool enableImageData/*=true*/)
+{
+  if (aTrackedFrameList == NULL)
+  {
+    LOG_ERROR("vtkPlusChannel::GetTrackedFrames failed: output tracked frame list is NULL");
+    return PLUS_FAIL;
+  }
+  if (timestamps.empty())
+  {
+    return PLUS_SUCCESS;
+  }
+
+  std::vector<TrackedFrameView> trackedFrameViews;
+  int numberOfErrors = (this->GetTrackedFrameViews(timestamps, trackedFrameViews, enableImageData) == PLUS_SUCCESS) ? 0 : 1;
+
+  for (size_t frameIndex = 0; frameIndex < trackedFrameViews.size(); ++frameIndex)
+  {
+    if (trackedFrameViews[frameIndex].Timestamp == UNDEFINED_TIMESTAMP)
+    {
+      // the frame could not be retrieved, the error has been logged already
+      continue;
+    }
+
+    igsioTrackedFrame* trackedFrame = new igsioTrackedFrame;
+    if (trackedFrameViews[frameIndex].CopyToTrackedFrame(*trackedFrame) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Unable to get tracked frame by time: " << std::fixed << timestamps[frameIndex]);
+      delete trackedFrame;
+      numberOfErrors++;
+      continue;
+    }
+    // The image is copied, the reference to the video item is not needed anymore
+    trackedFrameViews[frameIndex].VideoItem.reset();
+    if (aTrackedFrameList->TakeTrackedFrame(trackedFrame, vtkIGSIOTrackedFrameList::SKIP_INVALID_FRAME) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Unable to add tracked frame to the list!");
+      numberOfErrors++;
+    }
+  }
+
+  return (numberOfErrors == 0 ? PLUS_SUCCESS : PLUS_FAIL);
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusChannel::GetTrackedFrameViews(const std::vector<double>& timestamps, std::vector<TrackedFrameView>& trackedFrameViews, bool enableImageData/*=true*/)
+{
+  trackedFrameViews.clear();
+  if (timestamps.empty())
+  {
+    return PLUS_SUCCESS;
+  }
+
+  // Same steps as in GetTrackedFrameView, but each step is performed for all the frames at once
+  const int numberOfFrames = static_cast<int>(timestamps.size());
+  int numberOfErrors(0);
+  trackedFrameViews.resize(numberOfFrames);
+  std::vector<bool> frameValid(numberOfFrames, true);
+  std::vector<double> synchronizedTimestamps(timestamps);
+
+  // Get references to the video frames, they are not copied
+  if (this->HasVideoSource() && enableImageData)
+  {
+    if (this->VideoSource->GetNumberOfItems() < 1)
+    {
+      LOG_ERROR("Couldn't get tracked frames from video source, frames are not available yet");
+      return PLUS_FAIL;
+    }
+    std::vector<StreamBufferItemView> videoItems(numberOfFrames);
+    std::vector<ItemStatus> videoItemStatuses(numberOfFrames, ITEM_UNKNOWN_ERROR);
+    this->VideoSource->GetStreamBufferItemViewsFromTimes(&timestamps[0], numberOfFrames, &videoItems[0], &videoItemStatuses[0]);
+    for (int frameIndex = 0; frameIndex < numberOfFrames; ++frameIndex)
+    {
+      if (videoItemStatuses[frameIndex] != ITEM_OK)
+      {
+        LOG_ERROR("Couldn't get video buffer item by time (" << std::fixed << timestamps[frameIndex] << ")!");
+        frameValid[frameIndex] = false;
+        numberOfErrors++;
+        continue;
+      }
+      trackedFrameViews[frameIndex].VideoItem = videoItems[frameIndex];
+      trackedFrameViews[frameIndex].FrameFields = videoItems[frameIndex]->GetFrameFieldStore();
+      synchronizedTimestamps[frameIndex] = videoItems[frameIndex]->GetTimestamp(this->VideoSource->GetLocalTimeOffsetSec());
+    }
+  }
+
+  // Interpolate the poses of each tool at all the frame timestamps
+  std::vector<double> toolsSynchronizedTimestamps(synchronizedTimestamps);
+  std::vector<PlusInterpolatedPose> toolPoses(numberOfFrames);
+  for (DataSourceContainerConstIterator it = this->GetToolsStartIterator(); it != this->GetToolsEndIterator(); ++it)
+  {
+    vtkPlusDataSource* aTool = it->second;
+    igsioTransformName toolTransformName(aTool->GetId());
+    if (!toolTransformName.IsValid())
+    {
+      LOG_ERROR("Tool transform name is invalid!");
+      std::fill(frameValid.begin(), frameValid.end(), false);
+      numberOfErrors++;
+      continue;
+    }
+
+    aTool->GetInterpolatedPosesFromTimes(&synchronizedTimestamps[0], numberOfFrames, &toolPoses[0]);
+    for (int frameIndex = 0; frameIndex < numberOfFrames; ++frameIndex)
+    {
+      if (!frameValid[frameIndex])
+      {
+        continue;
+      }
+      const PlusInterpolatedPose& toolPose = toolPoses[frameIndex];
+      if (toolPose.Result != ITEM_OK)
+      {
+        LOG_ERROR(aTool->GetId() << ": Failed to get tracker item from buffer by time: " << std::fixed << synchronizedTimestamps[frameIndex]);
+        frameValid[frameIndex] = false;
+        numberOfErrors++;
+        continue;
+      }
+
+      TrackedFrameView::ToolTransform toolTransform;
+      toolTransform.Name = toolTransformName;
+      toolTransform.Matrix = vtkSmartPointer<vtkMatrix4x4>::New();
+      toolTransform.Matrix->DeepCopy(toolPose.Matrix);
+      toolTransform.Status = toolPose.Status;
+      trackedFrameViews[frameIndex].ToolTransforms.push_back(toolTransform);
+
+      // Copy all custom fields, the item is only retrieved if it has any
+      if (toolPose.HasFrameFields)
+      {
+        StreamBufferItem bufferItem;
+        if (aTool->GetStreamBufferItem(toolPose.Uid, &bufferItem) != ITEM_OK)
+        {
+          LOG_ERROR("Failed to get custom fields from buffer item for tool " << aTool->GetId());
+          frameValid[frameIndex] = false;
+          numberOfErrors++;
+          continue;
+        }
+        trackedFrameViews[frameIndex].FrameFields.SetFields(bufferItem.GetFrameFieldStore());
+      }
+
+      toolsSynchronizedTimestamps[frameIndex] = toolPose.GetTimestamp(aTool->GetLocalTimeOffsetSec());
+    }
+  }
+  synchronizedTimestamps = toolsSynchronizedTimestamps;
+
+  // Get the closest items of the field data sources
+  std::vector<StreamBufferItemView> fieldItems(numberOfFrames);
+  std::vector<ItemStatus> fieldItemStatuses(numberOfFrames, ITEM_UNKNOWN_ERROR);
+  for (DataSourceContainerConstIterator it = this->GetFieldDataSourcesStartIterator(); it != this->GetFieldDataSourcesEndIterator(); ++it)
+  {
+    vtkPlusDataSource* aSource = it->second;
+    aSource->GetStreamBufferItemViewsFromTimes(&synchronizedTimestamps[0], numberOfFrames, &fieldItems[0], &fieldItemStatuses[0]);
+    for (int frameIndex = 0; frameIndex < numberOfFrames; ++frameIndex)
+    {
+      if (!frameValid[frameIndex])
+      {
+        continue;
+      }
+      if (fieldItemStatuses[frameIndex] != ITEM_OK)
+      {
+        LOG_ERROR(aSource->GetId() << ": Failed to get field data item from buffer by time: " << std::fixed << synchronizedTimestamps[frameIndex]);
+        frameValid[frameIndex] = false;
+        numberOfErrors++;
+        continue;
+      }
+      trackedFrameViews[frameIndex].FrameFields.SetFields(fieldItems[frameIndex]->GetFrameFieldStore());
+      synchronizedTimestamps[frameIndex] = fieldItems[frameIndex]->GetTimestamp(aSource->GetLocalTimeOffsetSec());
+    }
+  }
+  // Release the field items, so that the buffers do not have to copy them when they are overwritten
+  fieldItems.clear();
+
+  const double readTime = PlusClock::GetSystemTime();
+  for (int frameIndex = 0; frameIndex < numberOfFrames; ++frameIndex)
+  {
+    if (!frameValid[frameIndex])
+    {
+      // Release the video item of the frames that could not be retrieved
+      trackedFrameViews[frameIndex] = TrackedFrameView();
+      continue;
+    }
+    trackedFrameViews[frameIndex].Timestamp = synchronizedTimestamps[frameIndex];
+    this->ReadLatencyHistogram.RecordLatency(readTime - synchronizedTimestamps[frameIndex]);
+  }
 
   return (numberOfErrors == 0 ? PLUS_SUCCESS : PLUS_FAIL);
 }
@@ -1057,32 +1365,42 @@ PlusStatus vtkPlusChannel::GetTrackedFrameListSampled(double& aTimestampOfLastFr
     return PLUS_FAIL;
   }
 
-  double startTimeSec = vtkIGSIOAccurateTimer::GetSystemTime();
+  double startTimeSec = PlusClock::GetSystemTime();
 
   double mostRecentTimestamp(0);
   RETURN_WITH_FAIL_IF(this->GetMostRecentTimestamp(mostRecentTimestamp) != PLUS_SUCCESS,
                       "vtkPlusChannel::GetTrackedFrameListSampled failed: unable to get most recent timestamp. Probably no frames have been acquired yet.");
 
+  double oldestTimestamp = 0;
+  if (this->GetOldestTimestamp(oldestTimestamp) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("vtkPlusChannel::GetTrackedFrameListSampled: Failed to get oldest timestamp from buffer. Probably no frames have been acquired yet.");
+    return PLUS_FAIL;
+  }
+
+  // Collect the timestamps of the frames to be added and retrieve them in batches
   PlusStatus status = PLUS_SUCCESS;
-  // Add frames to input trackedFrameList
+  std::vector<double> frameTimestamps;
+  double firstBatchSampleTimestamp = aTimestampOfNextFrameToBeAdded;
+  double timestampOfLastFrameToBeAdded = aTimestampOfLastFrameAlreadyGot;
   for (; aTimestampOfNextFrameToBeAdded <= mostRecentTimestamp; aTimestampOfNextFrameToBeAdded += aSamplingPeriodSec)
   {
     // If the time that is allowed for adding of frames is expired then stop the processing now
-    if (maxTimeLimitSec > 0 && vtkIGSIOAccurateTimer::GetSystemTime() - startTimeSec > maxTimeLimitSec)
+    if (maxTimeLimitSec > 0 && PlusClock::GetSystemTime() - startTimeSec > maxTimeLimitSec)
     {
       LOG_DEBUG("Reached maximum time that is allowed for sampling frames");
+      if (!frameTimestamps.empty())
+      {
+        // The frames of the current batch are not retrieved now, sampling continues with them next time
+        aTimestampOfNextFrameToBeAdded = firstBatchSampleTimestamp;
+        frameTimestamps.clear();
+      }
       break;
     }
 
     // Make sure the next frame to be added is still in the buffer:
     // If the frame will be removed from the buffer really soon, then jump ahead in time (and skip some frames),
     // instead of trying to retrieve from the buffer (and then fail because the frame is not available anymore).
-    double oldestTimestamp = 0;
-    if (this->GetOldestTimestamp(oldestTimestamp) != PLUS_SUCCESS)
-    {
-      LOG_ERROR("vtkPlusChannel::GetTrackedFrameListSampled: Failed to get oldest timestamp from buffer. Probably no frames have been acquired yet.");
-      return PLUS_FAIL;
-    }
     if (aTimestampOfNextFrameToBeAdded < oldestTimestamp + SAMPLING_SKIPPING_MARGIN_SEC)
     {
       double newTimestampOfFrameToBeAdded = oldestTimestamp + SAMPLING_SKIPPING_MARGIN_SEC;
@@ -1098,29 +1416,62 @@ PlusStatus vtkPlusChannel::GetTrackedFrameListSampled(double& aTimestampOfLastFr
       LOG_ERROR("vtkPlusChannel::GetTrackedFrameListSampled: Failed to get closest timestamp from buffer for the next frame. Probably no frames have been acquired yet.");
       return PLUS_FAIL;
     }
-    if (aTimestampOfLastFrameAlreadyGot != UNDEFINED_TIMESTAMP && closestTimestamp <= aTimestampOfLastFrameAlreadyGot)
+    if (timestampOfLastFrameToBeAdded != UNDEFINED_TIMESTAMP && closestTimestamp <= timestampOfLastFrameToBeAdded)
     {
       // This frame has been already added. Don't spend time with retrieving this frame, just jump to the next
       continue;
     }
-    // Get tracked frame from buffer (actually copies pixel and field data)
-    igsioTrackedFrame* trackedFrame = new igsioTrackedFrame;
-    if (GetTrackedFrame(closestTimestamp, *trackedFrame) != PLUS_SUCCESS)
+    if (frameTimestamps.empty())
     {
-      LOG_WARNING("vtkPlusChannel::GetTrackedFrameListSampled: Unable retrieve frame from the devices for time: " << std::fixed << aTimestampOfNextFrameToBeAdded << ", probably the item is not available in the buffers anymore. Frames may be lost.");
-      delete trackedFrame;
-      continue;
+      firstBatchSampleTimestamp = aTimestampOfNextFrameToBeAdded;
     }
-    aTimestampOfLastFrameAlreadyGot = trackedFrame->GetTimestamp();
-    // Add tracked frame to the list
-    if (aTrackedFrameList->TakeTrackedFrame(trackedFrame, vtkIGSIOTrackedFrameList::SKIP_INVALID_FRAME) != PLUS_SUCCESS)
+    frameTimestamps.push_back(closestTimestamp);
+    timestampOfLastFrameToBeAdded = closestTimestamp;
+
+    if (frameTimestamps.size() >= SAMPLING_BATCH_SIZE)
     {
-      LOG_ERROR("vtkPlusChannel::GetTrackedFrameListSampled: Unable to add tracked frame to the list");
-      status = PLUS_FAIL;
+      if (this->AddSampledTrackedFrames(frameTimestamps, aTrackedFrameList, aTimestampOfLastFrameAlreadyGot) != PLUS_SUCCESS)
+      {
+        status = PLUS_FAIL;
+      }
+      // Time has passed while the frames were retrieved, older frames may have been removed from the buffer meanwhile
+      if (this->GetOldestTimestamp(oldestTimestamp) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("vtkPlusChannel::GetTrackedFrameListSampled: Failed to get oldest timestamp from buffer. Probably no frames have been acquired yet.");
+        return PLUS_FAIL;
+      }
     }
   }
 
+  if (this->AddSampledTrackedFrames(frameTimestamps, aTrackedFrameList, aTimestampOfLastFrameAlreadyGot) != PLUS_SUCCESS)
+  {
+    status = PLUS_FAIL;
+  }
+
+  return status;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusChannel::AddSampledTrackedFrames(std::vector<double>& timestamps, vtkIGSIOTrackedFrameList* aTrackedFrameList, double& aTimestampOfLastFrameAlreadyGot)
+{
+  if (timestamps.empty())
+  {
+    return PLUS_SUCCESS;
+  }
 
+  // Get tracked frames from buffer (actually copies pixel and field data)
+  PlusStatus status = PLUS_SUCCESS;
+  unsigned int numberOfFramesBefore = aTrackedFrameList->GetNumberOfTrackedFrames();
+  if (this->GetTrackedFrames(timestamps, aTrackedFrameList) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("vtkPlusChannel::GetTrackedFrameListSampled: Unable to retrieve some of the frames from the devices, probably the items are not available in the buffers anymore. Frames may be lost.");
+    status = PLUS_FAIL;
+  }
+  if (aTrackedFrameList->GetNumberOfTrackedFrames() > numberOfFramesBefore)
+  {
+    aTimestampOfLastFrameAlreadyGot = aTrackedFrameList->GetTrackedFrame(aTrackedFrameList->GetNumberOfTrackedFrames() - 1)->GetTimestamp();
+  }
+  timestamps.clear();
   return status;
 }
 
@@ -1564,6 +1915,157 @@ bool vtkPlusChannel::GetFieldDataEnabled() const
   return this->FieldCount() > 0;
 }
 
+//----------------------------------------------------------------------------
+unsigned long vtkPlusChannel::AddNewFrameCallback(NewFrameCallbackType callback)
+{
+  unsigned long callbackId(0);
+  {
+    igsioLockGuard<vtkIGSIORecursiveCriticalSection> callbacksGuardedLock(this->NewFrameCallbacksMutex);
+    callbackId = this->NextNewFrameCallbackId++;
+    this->NewFrameCallbacks[callbackId] = callback;
+  }
+  this->UpdateNewFrameSubscription();
+  return callbackId;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusChannel::RemoveNewFrameCallback(unsigned long callbackId)
+{
+  {
+    igsioLockGuard<vtkIGSIORecursiveCriticalSection> callbacksGuardedLock(this->NewFrameCallbacksMutex);
+    this->NewFrameCallbacks.erase(callbackId);
+  }
+  // Invocations that have started before the removal may still call the removed function.
+  // The invocations of the current thread are not waited for, as a callback may remove itself.
+  const std::thread::id currentThreadId = std::this_thread::get_id();
+  std::unique_lock<std::mutex> invocationsLock(this->NewFrameCallbackInvocationsMutex);
+  this->NewFrameCallbackInvocationsCondition.wait(invocationsLock, [this, currentThreadId]
+  {
+    return std::count(this->NewFrameCallbackInvokingThreads.begin(), this->NewFrameCallbackInvokingThreads.end(), currentThreadId)
+           == static_cast<std::ptrdiff_t>(this->NewFrameCallbackInvokingThreads.size());
+  });
+}
+
+//----------------------------------------------------------------------------
+unsigned long long vtkPlusChannel::GetNewFrameSequenceNumber()
+{
+  this->UpdateNewFrameSubscription();
+  std::lock_guard<std::mutex> newFrameGuardedLock(this->NewFrameMutex);
+  return this->NewFrameSequenceNumber;
+}
+
+//----------------------------------------------------------------------------
+bool vtkPlusChannel::WaitForNewFrame(unsigned long long& sequenceNumber, double timeoutSec)
+{
+  this->UpdateNewFrameSubscription();
+  std::unique_lock<std::mutex> newFrameLock(this->NewFrameMutex);
+  bool newFrameAvailable = this->NewFrameCondition.wait_for(newFrameLock,
+                           std::chrono::duration<double>(timeoutSec),
+                           [this, sequenceNumber] { return this->NewFrameSequenceNumber != sequenceNumber; });
+  sequenceNumber = this->NewFrameSequenceNumber;
+  return newFrameAvailable;
+}
+
+//----------------------------------------------------------------------------
+vtkPlusDataSource* vtkPlusChannel::GetNewFrameMasterSource()
+{
+  if (this->VideoSource != NULL)
+  {
+    return this->VideoSource;
+  }
+  vtkPlusDataSource* masterTool = NULL;
+  if (this->ToolCount() > 0 && this->GetTimestampMasterTool(masterTool) == PLUS_SUCCESS)
+  {
+    return masterTool;
+  }
+  if (this->FieldCount() > 0)
+  {
+    return this->FieldDataSources.begin()->second;
+  }
+  return NULL;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusChannel::UpdateNewFrameSubscription()
+{
+  igsioLockGuard<vtkIGSIORecursiveCriticalSection> subscriptionGuardedLock(this->NewFrameSubscriptionMutex);
+  this->NewFrameSubscriptionRequested = true;
+  vtkPlusDataSource* masterSource = this->GetNewFrameMasterSource();
+  if (masterSource == this->NewFrameSubscribedSource.GetPointer())
+  {
+    // no change
+    return;
+  }
+  this->RemoveNewFrameSubscription();
+  if (masterSource == NULL)
+  {
+    return;
+  }
+  this->NewFrameSubscribedSource = masterSource;
+  this->NewFrameSubscribedSourceCallbackId = masterSource->AddItemAddedCallback(
+        [this](BufferItemUidType, double timestamp) { this->OnNewFrame(timestamp); });
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusChannel::RefreshNewFrameSubscription()
+{
+  igsioLockGuard<vtkIGSIORecursiveCriticalSection> subscriptionGuardedLock(this->NewFrameSubscriptionMutex);
+  if (!this->NewFrameSubscriptionRequested)
+  {
+    return;
+  }
+  this->UpdateNewFrameSubscription();
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusChannel::RemoveNewFrameSubscription()
+{
+  igsioLockGuard<vtkIGSIORecursiveCriticalSection> subscriptionGuardedLock(this->NewFrameSubscriptionMutex);
+  if (this->NewFrameSubscribedSource == NULL)
+  {
+    return;
+  }
+  this->NewFrameSubscribedSource->RemoveItemAddedCallback(this->NewFrameSubscribedSourceCallbackId);
+  this->NewFrameSubscribedSource = NULL;
+  this->NewFrameSubscribedSourceCallbackId = 0;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusChannel::OnNewFrame(double timestamp)
+{
+  {
+    std::lock_guard<std::mutex> newFrameGuardedLock(this->NewFrameMutex);
+    ++this->NewFrameSequenceNumber;
+  }
+  this->NewFrameCondition.notify_all();
+
+  // The callbacks are called after the mutex is released, so that they can add or remove callbacks
+  std::vector<NewFrameCallbackType> callbacks;
+  {
+    std::lock_guard<std::mutex> invocationsLock(this->NewFrameCallbackInvocationsMutex);
+    igsioLockGuard<vtkIGSIORecursiveCriticalSection> callbacksGuardedLock(this->NewFrameCallbacksMutex);
+    if (this->NewFrameCallbacks.empty())
+    {
+      return;
+    }
+    callbacks.reserve(this->NewFrameCallbacks.size());
+    for (std::map<unsigned long, NewFrameCallbackType>::iterator it = this->NewFrameCallbacks.begin(); it != this->NewFrameCallbacks.end(); ++it)
+    {
+      callbacks.push_back(it->second);
+    }
+    this->NewFrameCallbackInvokingThreads.push_back(std::this_thread::get_id());
+  }
+  for (std::vector<NewFrameCallbackType>::iterator it = callbacks.begin(); it != callbacks.end(); ++it)
+  {
+    (*it)(this, timestamp);
+  }
+  {
+    std::lock_guard<std::mutex> invocationsLock(this->NewFrameCallbackInvocationsMutex);
+    this->NewFrameCallbackInvokingThreads.erase(std::find(this->NewFrameCallbackInvokingThreads.begin(), this->NewFrameCallbackInvokingThreads.end(), std::this_thread::get_id()));
+  }
+  this->NewFrameCallbackInvocationsCondition.notify_all();
+}
+
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusChannel::GetTimestampMasterTool(vtkPlusDataSource*& aTool)
 {
@@ -1816,6 +2318,7 @@ PlusStatus vtkPlusChannel::GenerateDataAcquisitionReport(vtkPlusHTMLGenerator* h
 
   std::string reportText = std::string("Device: ") + this->GetOwnerDevice()->GetDeviceId() + " - Channel: " + this->GetChannelId();
   htmlReport->AddText(reportText.c_str(), vtkPlusHTMLGenerator::H1);
+  htmlReport->AddParagraph(this->GetOwnerDevice()->GetCaptureThreadSettingsDescription().c_str());
 
   std::string deviceAndChannelName = std::string(this->GetOwnerDevice()->GetDeviceId()) + "-" + this->GetChannelId();
 
@@ -1835,6 +2338,7 @@ PlusStatus vtkPlusChannel::GenerateDataAcquisitionReport(vtkPlusHTMLGenerator* h
     PlusPlotter::WriteTableToFile(*timestampReportTable, reportFile.c_str());
 
     htmlReport->AddText("Video data", vtkPlusHTMLGenerator::H2);
+    htmlReport->AddParagraph(GetTimestampJitterSummary(timestampReportTable).c_str());
     std::string imageFilePath = htmlReport->AddImageAutoFilename(std::string(deviceAndChannelName + "VideoBufferTimestamps.png").c_str(), "Video Data Acquisition Analysis");
     PlusPlotter::WriteLineChartToFile("Frame index", "Timestamp (s)", *timestampReportTable, 0, 1, 2, imageSize, imageFilePath.c_str());
 
@@ -1854,6 +2358,7 @@ PlusStatus vtkPlusChannel::GenerateDataAcquisitionReport(vtkPlusHTMLGenerator* h
 
     reportText =  std::string("Tracking data - ") + tool->GetId();
     htmlReport->AddText(reportText.c_str(), vtkPlusHTMLGenerator::H2);
+    htmlReport->AddParagraph(GetTimestampJitterSummary(timestampReportTable).c_str());
     std::string imageFilePath = htmlReport->AddImageAutoFilename(std::string(deviceAndChannelName + "-" + tool->GetId() + "-TrackerBufferTimestamps.png").c_str(), reportText.c_str());
     PlusPlotter::WriteLineChartToFile("Frame index", "Timestamp (s)", *timestampReportTable, 0, 1, 2, imageSize, imageFilePath.c_str());
 
@@ -1876,6 +2381,7 @@ PlusStatus vtkPlusChannel::GenerateDataAcquisitionReport(vtkPlusHTMLGenerator* h
 
     reportText =  std::string("Field data - ") + aSource->GetId();
     htmlReport->AddText(reportText.c_str(), vtkPlusHTMLGenerator::H2);
+    htmlReport->AddParagraph(GetTimestampJitterSummary(timestampReportTable).c_str());
     std::string imageFilePath = htmlReport->AddImageAutoFilename(std::string(deviceAndChannelName + "-" + aSource->GetId() + "-FieldDataBufferTimestamps.png").c_str(), reportText.c_str());
     PlusPlotter::WriteLineChartToFile("Frame index", "Timestamp (s)", *timestampReportTable, 0, 1, 2, imageSize, imageFilePath.c_str());
 
@@ -10,11 +10,19 @@
 #include "PlusConfigure.h"
 #include "vtkPlusDataCollectionExport.h"
 
+#include "PlusLatencyHistogram.h"
 #include "PlusStreamBufferItem.h"
 #include "vtkDataObject.h"
 #include "vtkPlusRfProcessor.h"
 
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 //class igsioTrackedFrame; 
+class vtkIGSIORecursiveCriticalSection;
 class vtkPlusHTMLGenerator;
 class vtkPlusDataSource;
 class vtkPlusDevice;
@@ -38,6 +46,48 @@ public:
   typedef CustomAttributeMap::iterator CustomAttributeMapIterator;
   typedef CustomAttributeMap::const_iterator CustomAttributeMapConstIterator;
 
+  /*!
+    Tracked frame that refers to the video buffer item instead of containing a copy of the image.
+    The referenced video item is not modified or recycled by the buffer while the view is held.
+  */
+  struct TrackedFrameView
+  {
+    /*! Transform of a tool, interpolated at the timestamp of the tracked frame */
+    struct ToolTransform
+    {
+      igsioTransformName Name;
+      vtkSmartPointer<vtkMatrix4x4> Matrix;
+      ToolStatus Status;
+      ToolTransform()
+        : Status(TOOL_INVALID)
+      {
+      }
+    };
+
+    /*! Timestamp of the tracked frame. UNDEFINED_TIMESTAMP if no data could be retrieved. */
+    double Timestamp;
+    /*! Video buffer item. Empty if the channel has no video source or image data was not requested. */
+    StreamBufferItemView VideoItem;
+    /*! Transforms of all the tools of the channel */
+    std::vector<ToolTransform> ToolTransforms;
+    /*! Custom fields of the video item, the tool items, and the field data items. Field values are shared with the buffer items. */
+    PlusFrameFieldStore FrameFields;
+
+    TrackedFrameView()
+      : Timestamp(UNDEFINED_TIMESTAMP)
+    {
+    }
+
+    /*! Copy the content of the view into a tracked frame. This is the only place where the image is copied. */
+    PlusStatus CopyToTrackedFrame(igsioTrackedFrame& trackedFrame) const;
+  };
+
+  /*!
+    Function that is called when a new item is added to the master data source of the channel.
+    Arguments are the channel and the timestamp of the new item.
+  */
+  typedef std::function<void(vtkPlusChannel* channel, double timestamp)> NewFrameCallbackType;
+
 public:
   static vtkPlusChannel* New();
   vtkTypeMacro(vtkPlusChannel, vtkObject);
@@ -112,13 +162,46 @@ public:
   virtual PlusStatus GetTrackedFrame(double timestamp, igsioTrackedFrame& trackedFrame, bool enableImageData = true);
   virtual PlusStatus GetTrackedFrame(igsioTrackedFrame& trackedFrame);
 
+  /*!
+    Get tracked frame view containing the transform(s) and a reference to the video buffer item
+    acquired from the device at a specific timestamp. The image is not copied.
+    \param timestamp Timestamp of the requested tracked frame
+    \param trackedFrameView Target tracked frame view
+    \param enableImageData Enable returning of image data. Tracking data will be interpolated at the timestamp of the image data.
+  */
+  virtual PlusStatus GetTrackedFrameView(double timestamp, TrackedFrameView& trackedFrameView, bool enableImageData = true);
+
+  /*!
+    Get tracked frames at multiple timestamps and append them to a tracked frame list.
+    The frames are the same as the ones returned by GetTrackedFrame for each timestamp, but each buffer is locked
+    only once, and if the timestamps are in increasing order then the items are found by walking each buffer forward
+    instead of searching the buffers for each timestamp.
+    \param timestamps Timestamps of the requested tracked frames, preferably in increasing order
+    \param trackedFrameList Tracked frame list that the frames are appended to
+    \param enableImageData Enable returning of image data. Tracking data will be interpolated at the timestamp of the image data.
+    \return PLUS_FAIL if any of the frames could not be retrieved (those frames are not added to the list)
+  */
+  virtual PlusStatus GetTrackedFrames(const std::vector<double>& timestamps, vtkIGSIOTrackedFrameList* trackedFrameList, bool enableImageData = true);
+
+  /*!
+    Get tracked frame views at multiple timestamps. The views are the same as the ones returned by GetTrackedFrameView
+    for each timestamp, but the buffers are queried the same way as in GetTrackedFrames. The images are not copied.
+    \param timestamps Timestamps of the requested tracked frames, preferably in increasing order
+    \param trackedFrameViews Receives one view for each timestamp. The timestamp of the views that could not be retrieved is UNDEFINED_TIMESTAMP.
+    \param enableImageData Enable returning of image data. Tracking data will be interpolated at the timestamp of the image data.
+    \return PLUS_FAIL if any of the frames could not be retrieved
+  */
+  virtual PlusStatus GetTrackedFrameViews(const std::vector<double>& timestamps, std::vector<TrackedFrameView>& trackedFrameViews, bool enableImageData = true);
+
   /*!
     Get the tracked frame list from devices since time specified
     \param aTimestampOfLastFrameAlreadyGot Used for preventing returning the same frame multiple times. In: the timestamp of the timestamp that has been already returned in previous GetTrackedFrameListSampled calls. If no frames have got yet then set it to UNDEFINED_TIMESTAMP. Out: the timestamp of the most recent frame that is returned.
     \param aTimestampOfNextFrameToBeAdded Timestamp of the next frame that should be added. This value is increased by the multiple of aSamplingPeriodSec.
     \param aTrackedFrameList Tracked frame list used to get the newly acquired frames into. The new frames are appended to the tracked frame.
     \param aSamplingPeriodSec Sampling period time for getting the frames in seconds (timestamps are in seconds too)
-    \param maxTimeLimitSec Maximum time spent in the function (in sec)
+    \param maxTimeLimitSec Maximum time spent in the function (in sec). Frames are retrieved in small batches and the time limit
+      is checked before each frame is sampled, so the limit is exceeded by at most the time of retrieving one batch.
+    \return PLUS_FAIL if any of the sampled frames could not be retrieved or added to the list
   */
   virtual PlusStatus GetTrackedFrameListSampled(double& aTimestampOfLastFrameAlreadyGot, double& aTimestampOfNextFrameToBeAdded, vtkIGSIOTrackedFrameList* aTrackedFrameList, double aSamplingPeriodSec, double maxTimeLimitSec = -1);
 
@@ -142,6 +225,49 @@ public:
   /*! Return the oldest synchronized timestamp in the buffers */
   virtual PlusStatus GetOldestTimestamp(double& ts);
 
+  /*!
+    Register a function that is called whenever a new item is added to the master data source of the channel
+    (the video source, or if there is no video source then the timestamp master tool, or the first field data source).
+    The function is called on the acquisition thread of the data source, therefore it must return quickly,
+    it must not wait for other threads, and it must not change the data sources of the channel.
+    The function may add or remove callbacks (including itself).
+    \return Identifier of the callback, which can be used for removing it
+  */
+  unsigned long AddNewFrameCallback(NewFrameCallbackType callback);
+  /*!
+    Remove a function that was registered by AddNewFrameCallback. Waits until the calls of the function
+    that are in progress on other threads are completed, so the function is not called after this method returns.
+  */
+  void RemoveNewFrameCallback(unsigned long callbackId);
+
+  /*!
+    Get the number of items that have been added to the master data source of the channel since the channel started to monitor it.
+    The returned value can be used as a cursor in WaitForNewFrame.
+  */
+  unsigned long long GetNewFrameSequenceNumber();
+
+  /*!
+    Block the calling thread until a new item is added to the master data source of the channel or the timeout expires.
+    Consumers can use this instead of periodically polling the channel for new frames.
+    \param sequenceNumber In: the sequence number that the caller has already processed (obtained by GetNewFrameSequenceNumber
+      before getting the frames from the channel). Out: the current sequence number.
+    \param timeoutSec Maximum time to wait
+    \return true if new item has been added since sequenceNumber, false if the timeout expired
+  */
+  bool WaitForNewFrame(unsigned long long& sequenceNumber, double timeoutSec);
+
+  /*!
+    Get the data source that determines when new frames are available in the channel: the video source,
+    or if there is no video source then the timestamp master tool, or the first field data source
+  */
+  vtkPlusDataSource* GetNewFrameMasterSource();
+
+  /*!
+    Get the histogram of the age of the tracked frames when they are read from the channel
+    (time between the timestamp of the frame and the time when a consumer retrieved it)
+  */
+  const PlusLatencyHistogram& GetReadLatencyHistogram() const { return this->ReadLatencyHistogram; }
+
   virtual PlusStatus Clear();
 
   virtual void ShallowCopy(vtkDataObject*);
@@ -174,6 +300,21 @@ protected:
   /*! Get number of tracked frames between two given timestamps (inclusive) */
   virtual int GetNumberOfFramesBetweenTimestamps(double aTimestampFrom, double aTimestampTo);
 
+  /*! Start monitoring the master data source for new items (if not monitored already) */
+  void UpdateNewFrameSubscription();
+
+  /*!
+    Monitor the current master data source after the data sources of the channel have changed.
+    Has no effect if new items have not been monitored yet (the subscription is made when it is first needed).
+  */
+  void RefreshNewFrameSubscription();
+
+  /*! Stop monitoring the master data source for new items */
+  void RemoveNewFrameSubscription();
+
+  /*! Called by the master data source when a new item is added */
+  void OnNewFrame(double timestamp);
+
 protected:
   DataSourceContainer       FieldDataSources;
   DataSourceContainer       Tools;
@@ -199,6 +340,36 @@ protected:
 
   CustomAttributeMap CustomAttributes;
 
+  /*! Functions that are called when a new item is added to the master data source */
+  std::map<unsigned long, NewFrameCallbackType> NewFrameCallbacks;
+  unsigned long NextNewFrameCallbackId;
+  vtkIGSIORecursiveCriticalSection* NewFrameCallbacksMutex;
+  /*! Threads that are calling the new frame callbacks, protected by NewFrameCallbackInvocationsMutex */
+  std::vector<std::thread::id> NewFrameCallbackInvokingThreads;
+  std::mutex NewFrameCallbackInvocationsMutex;
+  std::condition_variable NewFrameCallbackInvocationsCondition;
+
+  /*! Master data source that is monitored for new items */
+  vtkSmartPointer<vtkPlusDataSource> NewFrameSubscribedSource;
+  unsigned long NewFrameSubscribedSourceCallbackId;
+  /*! True if new items have been monitored, the subscription follows the master data source from then on */
+  bool NewFrameSubscriptionRequested;
+  vtkIGSIORecursiveCriticalSection* NewFrameSubscriptionMutex;
+
+  /*! Number of items added to the master data source, protected by NewFrameMutex */
+  unsigned long long NewFrameSequenceNumber;
+  std::mutex NewFrameMutex;
+  std::condition_variable NewFrameCondition;
+
+  /*! Age of the tracked frames when they are read from the channel */
+  PlusLatencyHistogram ReadLatencyHistogram;
+
+  /*!
+    Retrieve a batch of frames of GetTrackedFrameListSampled and update the timestamp of the last frame already got.
+    The timestamps are cleared.
+  */
+  PlusStatus AddSampledTrackedFrames(std::vector<double>& timestamps, vtkIGSIOTrackedFrameList* aTrackedFrameList, double& aTimestampOfLastFrameAlreadyGot);
+
   vtkPlusChannel(void);
   virtual ~vtkPlusChannel(void);
 
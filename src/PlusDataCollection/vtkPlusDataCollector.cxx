@@ -6,6 +6,7 @@ See License.txt for details.
 
 // Local includes
 #include "PlusConfigure.h"
+#include "PlusAcquisitionScheduler.h"
 #include "vtkPlusBuffer.h"
 #include "vtkPlusChannel.h"
 #include "vtkPlusDataCollector.h"
@@ -25,6 +26,8 @@ See License.txt for details.
 #endif
 
 // STD includes
+#include <cmath>
+#include <cstdlib>
 #include <set>
 
 // VTK includes
@@ -34,6 +37,26 @@ See License.txt for details.
 
 //----------------------------------------------------------------------------
 
+namespace
+{
+  // Period of adapting the buffer sizes to the consumer lag
+  const double BUFFER_SIZE_UPDATE_PERIOD_SEC = 1.0;
+  // Buffers are sized to hold this many times the time range that consumers request
+  const double BUFFER_CONSUMER_LAG_SAFETY_FACTOR = 1.5;
+  // Buffer size is increased by this factor if items were requested that were not available anymore
+  const double BUFFER_SIZE_GROWTH_FACTOR = 1.5;
+  // Buffer size is increased at most by this factor in one update, to limit the effect of very old requests
+  const double BUFFER_SIZE_MAX_GROWTH_FACTOR = 2.0;
+  // Buffer size is decreased at most by this factor in one update, to avoid oscillation
+  const double BUFFER_SIZE_SHRINK_FACTOR = 0.75;
+  // Buffers are only reallocated if the size changes at least by this fraction (or items were not available anymore)
+  const double BUFFER_SIZE_CHANGE_THRESHOLD = 0.1;
+  // A buffer is resized at most once in this period, unless items were requested that were not available anymore
+  const double BUFFER_SIZE_MIN_RESIZE_PERIOD_SEC = 10.0;
+  // Buffers are not made smaller than this, even if the memory budget is exceeded
+  const int MINIMUM_ADAPTIVE_BUFFER_SIZE = 10;
+}
+
 vtkStandardNewMacro(vtkPlusDataCollector);
 
 //----------------------------------------------------------------------------
@@ -43,6 +66,18 @@ vtkPlusDataCollector::vtkPlusDataCollector()
   , DeviceFactory(vtkSmartPointer<vtkPlusDeviceFactory>::New())
   , Connected(false)
   , Started(false)
+  , BufferMemoryBudgetMb(0.0)
+  , BufferMemoryBudgetExceeded(false)
+  , BufferSizeUpdateThreader(vtkSmartPointer<vtkMultiThreader>::New())
+  , BufferSizeUpdateThreadId(-1)
+  , BufferSizeUpdateThreadAlive(false)
+  , AcquisitionThreadPoolSize(0)
+  , ConfiguredAcquisitionThreadPoolSize(0)
+  , ClockMode(PlusClock::REAL_TIME)
+  , VirtualClockStartTimeSec(0.0)
+  , BufferDumpThreader(vtkSmartPointer<vtkMultiThreader>::New())
+  , BufferDumpThreadId(-1)
+  , BufferDumpThreadAlive(false)
 {
   vtkStreamingVolumeCodecFactory* factory = vtkStreamingVolumeCodecFactory::GetInstance();
 #if defined PLUS_USE_VP9
@@ -55,6 +90,7 @@ vtkPlusDataCollector::vtkPlusDataCollector()
 vtkPlusDataCollector::~vtkPlusDataCollector()
 {
   LOG_TRACE("vtkPlusDataCollector::~vtkPlusDataCollector()");
+  this->WaitForBufferDump();
   if (this->Started)
   {
     this->Stop();
@@ -63,6 +99,14 @@ vtkPlusDataCollector::~vtkPlusDataCollector()
   {
     this->Disconnect();
   }
+  // All devices have stopped recording, so none of them is updated by the scheduler anymore
+  this->AcquisitionScheduler.reset();
+
+  {
+    // the buffers are deleted with the devices
+    std::lock_guard<std::mutex> bufferSizeLock(this->BufferSizeMutex);
+    this->BufferSizeStates.clear();
+  }
 
   for (DeviceCollectionIterator it = this->Devices.begin(); it != this->Devices.end(); ++it)
   {
@@ -105,6 +149,49 @@ PlusStatus vtkPlusDataCollector::ReadConfiguration(vtkXMLDataElement* aConfig)
     LOG_DEBUG("StartupDelaySec: " << std::fixed << startupDelaySec);
   }
 
+  // Read BufferMemoryBudgetMb
+  double bufferMemoryBudgetMb(0.0);
+  if (dataCollectionElement->GetScalarAttribute("BufferMemoryBudgetMb", bufferMemoryBudgetMb))
+  {
+    if (bufferMemoryBudgetMb < 0)
+    {
+      LOG_ERROR("BufferMemoryBudgetMb must not be negative (" << bufferMemoryBudgetMb << ")");
+      return PLUS_FAIL;
+    }
+    this->SetBufferMemoryBudgetMb(bufferMemoryBudgetMb);
+    LOG_DEBUG("BufferMemoryBudgetMb: " << std::fixed << bufferMemoryBudgetMb);
+  }
+
+  // Read AcquisitionThreadPoolSize
+  int acquisitionThreadPoolSize(0);
+  if (dataCollectionElement->GetScalarAttribute("AcquisitionThreadPoolSize", acquisitionThreadPoolSize))
+  {
+    if (this->SetAcquisitionThreadPoolSize(acquisitionThreadPoolSize) != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+    LOG_DEBUG("AcquisitionThreadPoolSize: " << acquisitionThreadPoolSize);
+  }
+
+  // Read ClockMode. The clock is shared by all the data collectors, it is only changed if the configuration specifies a mode.
+  const char* clockModeString = dataCollectionElement->GetAttribute("ClockMode");
+  if (clockModeString != NULL)
+  {
+    PlusClock::ClockMode clockMode(PlusClock::REAL_TIME);
+    if (!PlusClock::GetClockModeFromString(clockModeString, clockMode))
+    {
+      LOG_ERROR("Invalid ClockMode: " << clockModeString << ". Valid values are RealTime and VirtualTime.");
+      return PLUS_FAIL;
+    }
+    double virtualClockStartTimeSec(0.0);
+    dataCollectionElement->GetScalarAttribute("VirtualClockStartTimeSec", virtualClockStartTimeSec);
+    if (this->SetClockMode(clockMode, virtualClockStartTimeSec) != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+    LOG_DEBUG("ClockMode: " << clockModeString);
+  }
+
   std::set<std::string> existingDeviceIds;
 
   for (int i = 0; i < dataCollectionElement->GetNumberOfNestedElements(); ++i)
@@ -281,6 +368,33 @@ PlusStatus vtkPlusDataCollector::WriteConfiguration(vtkXMLDataElement* aConfig)
   }
 
   dataCollectionConfig->SetDoubleAttribute("StartupDelaySec", GetStartupDelaySec());
+  if (this->BufferMemoryBudgetMb > 0)
+  {
+    dataCollectionConfig->SetDoubleAttribute("BufferMemoryBudgetMb", this->BufferMemoryBudgetMb);
+  }
+  else
+  {
+    dataCollectionConfig->RemoveAttribute("BufferMemoryBudgetMb");
+  }
+  // The pool size that virtual-time mode forces is not saved, so the configuration still applies in real-time mode
+  if (this->ConfiguredAcquisitionThreadPoolSize > 0)
+  {
+    dataCollectionConfig->SetIntAttribute("AcquisitionThreadPoolSize", this->ConfiguredAcquisitionThreadPoolSize);
+  }
+  else
+  {
+    dataCollectionConfig->RemoveAttribute("AcquisitionThreadPoolSize");
+  }
+  if (this->ClockMode == PlusClock::VIRTUAL_TIME)
+  {
+    dataCollectionConfig->SetAttribute("ClockMode", PlusClock::GetClockModeAsString(this->ClockMode).c_str());
+    dataCollectionConfig->SetDoubleAttribute("VirtualClockStartTimeSec", this->VirtualClockStartTimeSec);
+  }
+  else
+  {
+    dataCollectionConfig->RemoveAttribute("ClockMode");
+    dataCollectionConfig->RemoveAttribute("VirtualClockStartTimeSec");
+  }
 
   PlusStatus status = PLUS_SUCCESS;
 
@@ -320,7 +434,13 @@ PlusStatus vtkPlusDataCollector::Start()
 
   PlusStatus status = PLUS_SUCCESS;
 
-  const double startTime = vtkIGSIOAccurateTimer::GetSystemTime();
+  const double startTime = PlusClock::GetSystemTime();
+
+  if (this->ClockMode == PlusClock::VIRTUAL_TIME && this->AcquisitionScheduler)
+  {
+    // The virtual time must not advance until all the devices are started
+    this->AcquisitionScheduler->SetSuspended(true);
+  }
 
   for (DeviceCollectionIterator it = Devices.begin(); it != Devices.end(); ++ it)
   {
@@ -334,12 +454,29 @@ PlusStatus vtkPlusDataCollector::Start()
     device->SetStartTime(startTime);
   }
 
-  LOG_DEBUG("vtkPlusDataCollector::Start -- wait " << std::fixed << this->StartupDelaySec << " sec for buffer init...");
+  if (this->ClockMode == PlusClock::VIRTUAL_TIME)
+  {
+    // Nothing to wait for, the virtual time does not advance while waiting
+    if (this->AcquisitionScheduler)
+    {
+      this->AcquisitionScheduler->SetSuspended(false);
+    }
+  }
+  else
+  {
+    LOG_DEBUG("vtkPlusDataCollector::Start -- wait " << std::fixed << this->StartupDelaySec << " sec for buffer init...");
 
-  vtkIGSIOAccurateTimer::DelayWithEventProcessing(this->StartupDelaySec);
+    vtkIGSIOAccurateTimer::DelayWithEventProcessing(this->StartupDelaySec);
+  }
 
   this->Started = true;
 
+  if (this->BufferMemoryBudgetMb > 0 && !this->BufferSizeUpdateThreadAlive)
+  {
+    this->BufferSizeUpdateThreadAlive = true;
+    this->BufferSizeUpdateThreadId = this->BufferSizeUpdateThreader->SpawnThread((vtkThreadFunctionType)&BufferSizeUpdateThread, this);
+  }
+
   return status;
 }
 
@@ -350,6 +487,383 @@ PlusStatus vtkPlusDataCollector::Stop()
 
   this->Started = false;
 
+  if (this->BufferSizeUpdateThreadId >= 0)
+  {
+    LOG_DEBUG("Wait for buffer size update thread to terminate");
+    while (this->BufferSizeUpdateThreadAlive)
+    {
+      vtkIGSIOAccurateTimer::Delay(0.1);
+    }
+    this->BufferSizeUpdateThreadId = -1;
+  }
+
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusDataCollector::SetAcquisitionThreadPoolSize(int poolSize)
+{
+  if (poolSize < 0)
+  {
+    LOG_ERROR("AcquisitionThreadPoolSize must not be negative (" << poolSize << ")");
+    return PLUS_FAIL;
+  }
+  if (this->ClockMode == PlusClock::VIRTUAL_TIME)
+  {
+    // Virtual-time mode uses a single acquisition thread, the size is applied when real-time mode is set
+    this->ConfiguredAcquisitionThreadPoolSize = poolSize;
+    return PLUS_SUCCESS;
+  }
+  if (this->ApplyAcquisitionThreadPoolSize(poolSize) != PLUS_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
+  this->ConfiguredAcquisitionThreadPoolSize = poolSize;
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusDataCollector::ApplyAcquisitionThreadPoolSize(int poolSize)
+{
+  if (poolSize == this->AcquisitionThreadPoolSize)
+  {
+    return PLUS_SUCCESS;
+  }
+  for (DeviceCollectionConstIterator it = this->Devices.begin(); it != this->Devices.end(); ++it)
+  {
+    if ((*it)->IsRecording())
+    {
+      LOG_ERROR("Acquisition thread pool size cannot be changed while device " << (*it)->GetDeviceId() << " is recording");
+      return PLUS_FAIL;
+    }
+  }
+
+  this->AcquisitionThreadPoolSize = poolSize;
+  if (poolSize > 0)
+  {
+    this->AcquisitionScheduler.reset(new PlusAcquisitionScheduler(poolSize));
+  }
+  else
+  {
+    this->AcquisitionScheduler.reset();
+  }
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusAcquisitionScheduler* vtkPlusDataCollector::GetAcquisitionScheduler() const
+{
+  return this->AcquisitionScheduler.get();
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusDataCollector::SetClockMode(PlusClock::ClockMode clockMode, double virtualStartTimeSec /*=0.0*/)
+{
+  for (DeviceCollectionConstIterator it = this->Devices.begin(); it != this->Devices.end(); ++it)
+  {
+    if ((*it)->IsRecording())
+    {
+      LOG_ERROR("Clock mode cannot be changed while device " << (*it)->GetDeviceId() << " is recording");
+      return PLUS_FAIL;
+    }
+  }
+
+  // Updates are only deterministic if they are performed one after the other
+  int poolSize = (clockMode == PlusClock::VIRTUAL_TIME ? 1 : this->ConfiguredAcquisitionThreadPoolSize);
+  if (poolSize != this->AcquisitionThreadPoolSize)
+  {
+    if (clockMode == PlusClock::VIRTUAL_TIME)
+    {
+      LOG_INFO("Virtual time clock mode: internal updates of the devices are performed by a single acquisition thread");
+    }
+    if (this->ApplyAcquisitionThreadPoolSize(poolSize) != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+  }
+
+  this->ClockMode = clockMode;
+  this->VirtualClockStartTimeSec = virtualStartTimeSec;
+  PlusClock::SetClockMode(clockMode, virtualStartTimeSec);
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+void* vtkPlusDataCollector::BufferSizeUpdateThread(vtkMultiThreader::ThreadInfo* data)
+{
+  vtkPlusDataCollector* self = (vtkPlusDataCollector*)(data->UserData);
+
+  // The update period is measured by PlusClock, the same clock as the timestamps that the buffer sizes are computed from
+  double nextUpdateTime = PlusClock::GetSystemTime() + BUFFER_SIZE_UPDATE_PERIOD_SEC;
+  while (self->Started)
+  {
+    const double currentTime = PlusClock::GetSystemTime();
+    if (currentTime < nextUpdateTime)
+    {
+      // wait in short real-time steps, so that stopping is not delayed by a full update period
+      vtkIGSIOAccurateTimer::Delay(0.1);
+      continue;
+    }
+    self->UpdateBufferSizes();
+    // virtual time may jump by more than an update period, the missed updates are not repeated
+    nextUpdateTime = currentTime + BUFFER_SIZE_UPDATE_PERIOD_SEC;
+  }
+
+  self->BufferSizeUpdateThreadAlive = false;
+  return NULL;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusDataCollector::GetLatencyHistograms(std::vector<LatencyHistogramSnapshot>& latencyHistograms) const
+{
+  latencyHistograms.clear();
+
+  std::vector<DeviceBuffer> deviceBuffers;
+  this->GetDeviceBuffers(deviceBuffers);
+  for (std::vector<DeviceBuffer>::iterator it = deviceBuffers.begin(); it != deviceBuffers.end(); ++it)
+  {
+    LatencyHistogramSnapshot latencyHistogram;
+    latencyHistogram.Name = std::string("Commit:") + it->DeviceId + "/" + it->SourceId;
+    it->Buffer->GetCommitLatencyHistogram().GetSnapshot(latencyHistogram.Snapshot);
+    latencyHistograms.push_back(latencyHistogram);
+  }
+
+  for (DeviceCollectionConstIterator deviceIt = this->Devices.begin(); deviceIt != this->Devices.end(); ++deviceIt)
+  {
+    for (ChannelContainerConstIterator channelIt = (*deviceIt)->GetOutputChannelsStart(); channelIt != (*deviceIt)->GetOutputChannelsEnd(); ++channelIt)
+    {
+      LatencyHistogramSnapshot latencyHistogram;
+      latencyHistogram.Name = std::string("Read:") + (*channelIt)->GetChannelId();
+      (*channelIt)->GetReadLatencyHistogram().GetSnapshot(latencyHistogram.Snapshot);
+      latencyHistograms.push_back(latencyHistogram);
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusDataCollector::GetDeviceBuffers(std::vector<DeviceBuffer>& deviceBuffers) const
+{
+  deviceBuffers.clear();
+  std::set<vtkPlusBuffer*> addedBuffers;
+  for (DeviceCollectionConstIterator deviceIt = this->Devices.begin(); deviceIt != this->Devices.end(); ++deviceIt)
+  {
+    vtkPlusDevice* device = *deviceIt;
+    const DataSourceContainerConstIterator beginIterators[3] = { device->GetVideoSourceIteratorBegin(), device->GetToolIteratorBegin(), device->GetFieldDataSourcessIteratorBegin() };
+    const DataSourceContainerConstIterator endIterators[3] = { device->GetVideoSourceIteratorEnd(), device->GetToolIteratorEnd(), device->GetFieldDataSourcessIteratorEnd() };
+    for (int sourceType = 0; sourceType < 3; ++sourceType)
+    {
+      for (DataSourceContainerConstIterator sourceIt = beginIterators[sourceType]; sourceIt != endIterators[sourceType]; ++sourceIt)
+      {
+        vtkPlusBuffer* buffer = sourceIt->second->GetBuffer();
+        if (buffer == NULL || !addedBuffers.insert(buffer).second)
+        {
+          continue;
+        }
+        DeviceBuffer deviceBuffer;
+        deviceBuffer.DeviceId = device->GetDeviceId();
+        deviceBuffer.SourceId = sourceIt->second->GetId();
+        deviceBuffer.Buffer = buffer;
+        deviceBuffers.push_back(deviceBuffer);
+      }
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusDataCollector::UpdateBufferSizes()
+{
+  std::vector<DeviceBuffer> deviceBuffers;
+  this->GetDeviceBuffers(deviceBuffers);
+
+  std::lock_guard<std::mutex> bufferSizeLock(this->BufferSizeMutex);
+
+  //============== Compute the buffer sizes required by the consumers ==================
+
+  std::vector<int> newBufferSizes(deviceBuffers.size());
+  std::vector<size_t> itemSizesBytes(deviceBuffers.size());
+  double totalBytes(0);
+  double totalConfiguredBytes(0);
+  for (size_t i = 0; i < deviceBuffers.size(); ++i)
+  {
+    vtkPlusBuffer* buffer = deviceBuffers[i].Buffer;
+    const int bufferSize = buffer->GetBufferSize();
+    std::map<vtkPlusBuffer*, BufferSizeState>::iterator stateIt = this->BufferSizeStates.find(buffer);
+    if (stateIt != this->BufferSizeStates.end() && stateIt->second.Buffer.GetPointer() != buffer)
+    {
+      // the buffer of the state has been deleted and a new buffer has been created at the same address
+      this->BufferSizeStates.erase(stateIt);
+      stateIt = this->BufferSizeStates.end();
+    }
+    if (stateIt == this->BufferSizeStates.end())
+    {
+      BufferSizeState newState;
+      newState.Buffer = buffer;
+      newState.ConfiguredBufferSize = bufferSize;
+      newState.ConsumerLagSec = 0;
+      newState.NumberOfItemsNotAvailableAnymore = 0;
+      newState.LastResizeTime = PlusClock::GetSystemTime();
+      stateIt = this->BufferSizeStates.insert(std::make_pair(buffer, newState)).first;
+    }
+    BufferSizeState& state = stateIt->second;
+    buffer->GetConsumerLag(state.ConsumerLagSec, state.NumberOfItemsNotAvailableAnymore, true);
+
+    int newBufferSize = state.ConfiguredBufferSize;
+    const int numberOfItems = buffer->GetNumberOfItems();
+    double oldestTimestamp(0);
+    double latestTimestamp(0);
+    // Items older than the items in memory are still available from the spill file, so lagging consumers do not need a larger buffer
+    if (numberOfItems > 1
+        && buffer->GetSpillFileSizeBytes() == 0
+        && buffer->GetOldestTimeStamp(oldestTimestamp) == ITEM_OK
+        && buffer->GetLatestTimeStamp(latestTimestamp) == ITEM_OK
+        && latestTimestamp > oldestTimestamp)
+    {
+      const double itemPeriodSec = (latestTimestamp - oldestTimestamp) / (numberOfItems - 1);
+      const int requiredBufferSize = static_cast<int>(std::ceil(state.ConsumerLagSec * BUFFER_CONSUMER_LAG_SAFETY_FACTOR / itemPeriodSec));
+      newBufferSize = std::max(newBufferSize, requiredBufferSize);
+    }
+    if (state.NumberOfItemsNotAvailableAnymore > 0)
+    {
+      newBufferSize = std::max(newBufferSize, static_cast<int>(std::ceil(bufferSize * BUFFER_SIZE_GROWTH_FACTOR)));
+    }
+    newBufferSize = std::min(newBufferSize, static_cast<int>(std::ceil(bufferSize * BUFFER_SIZE_MAX_GROWTH_FACTOR)));
+    if (newBufferSize < bufferSize)
+    {
+      newBufferSize = std::max(newBufferSize, static_cast<int>(bufferSize * BUFFER_SIZE_SHRINK_FACTOR));
+    }
+
+    newBufferSizes[i] = newBufferSize;
+    itemSizesBytes[i] = buffer->GetItemSizeBytes();
+    totalBytes += static_cast<double>(newBufferSize) * itemSizesBytes[i];
+    totalConfiguredBytes += static_cast<double>(std::min(newBufferSize, state.ConfiguredBufferSize)) * itemSizesBytes[i];
+  }
+
+  // Remove the states of the buffers that are not used by any device anymore
+  for (std::map<vtkPlusBuffer*, BufferSizeState>::iterator stateIt = this->BufferSizeStates.begin(); stateIt != this->BufferSizeStates.end();)
+  {
+    bool bufferInUse(false);
+    for (size_t i = 0; i < deviceBuffers.size() && !bufferInUse; ++i)
+    {
+      bufferInUse = (deviceBuffers[i].Buffer == stateIt->first);
+    }
+    if (bufferInUse)
+    {
+      ++stateIt;
+    }
+    else
+    {
+      this->BufferSizeStates.erase(stateIt++);
+    }
+  }
+
+  //============== Keep the total size within the budget ==================
+
+  const double budgetBytes = this->BufferMemoryBudgetMb * 1024.0 * 1024.0;
+  if (budgetBytes > 0 && totalBytes > budgetBytes)
+  {
+    if (totalConfiguredBytes <= budgetBytes)
+    {
+      // share the memory that is available above the configured sizes among the growing buffers
+      const double growthScale = (budgetBytes - totalConfiguredBytes) / (totalBytes - totalConfiguredBytes);
+      for (size_t i = 0; i < deviceBuffers.size(); ++i)
+      {
+        const int configuredBufferSize = this->BufferSizeStates[deviceBuffers[i].Buffer].ConfiguredBufferSize;
+        if (newBufferSizes[i] > configuredBufferSize)
+        {
+          newBufferSizes[i] = configuredBufferSize + static_cast<int>((newBufferSizes[i] - configuredBufferSize) * growthScale);
+        }
+      }
+      this->BufferMemoryBudgetExceeded = false;
+    }
+    else
+    {
+      // even the configured sizes do not fit into the budget, all buffers are made smaller
+      if (!this->BufferMemoryBudgetExceeded)
+      {
+        LOG_WARNING("Configured buffer sizes require " << static_cast<int>(totalConfiguredBytes / (1024.0 * 1024.0)) << " MB memory, which exceeds the buffer memory budget ("
+                    << this->BufferMemoryBudgetMb << " MB). Buffer sizes are reduced.");
+        this->BufferMemoryBudgetExceeded = true;
+      }
+      const double scale = budgetBytes / totalBytes;
+      for (size_t i = 0; i < deviceBuffers.size(); ++i)
+      {
+        newBufferSizes[i] = std::max(MINIMUM_ADAPTIVE_BUFFER_SIZE, static_cast<int>(newBufferSizes[i] * scale));
+      }
+    }
+  }
+  else
+  {
+    this->BufferMemoryBudgetExceeded = false;
+  }
+
+  //============== Resize the buffers ==================
+
+  PlusStatus status = PLUS_SUCCESS;
+  const double currentTime = PlusClock::GetSystemTime();
+  for (size_t i = 0; i < deviceBuffers.size(); ++i)
+  {
+    vtkPlusBuffer* buffer = deviceBuffers[i].Buffer;
+    BufferSizeState& state = this->BufferSizeStates[buffer];
+    const int bufferSize = buffer->GetBufferSize();
+    const int sizeChange = std::abs(newBufferSizes[i] - bufferSize);
+    if (sizeChange == 0)
+    {
+      continue;
+    }
+    if (state.NumberOfItemsNotAvailableAnymore == 0
+        && (sizeChange < bufferSize * BUFFER_SIZE_CHANGE_THRESHOLD || currentTime - state.LastResizeTime < BUFFER_SIZE_MIN_RESIZE_PERIOD_SEC))
+    {
+      // not worth reallocating the buffer
+      continue;
+    }
+    LOG_DEBUG("Change buffer size of " << deviceBuffers[i].DeviceId << "/" << deviceBuffers[i].SourceId << " from " << bufferSize << " to " << newBufferSizes[i]
+              << " items (consumer lag: " << std::fixed << state.ConsumerLagSec << " sec)");
+    if (buffer->SetBufferSize(newBufferSizes[i]) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to change buffer size of " << deviceBuffers[i].DeviceId << "/" << deviceBuffers[i].SourceId << " to " << newBufferSizes[i]);
+      status = PLUS_FAIL;
+    }
+    state.LastResizeTime = currentTime;
+  }
+
+  return status;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusDataCollector::GetBufferMemoryUsage(std::vector<BufferMemoryUsage>& bufferMemoryUsage, size_t& totalMemoryUsageBytes)
+{
+  std::vector<DeviceBuffer> deviceBuffers;
+  this->GetDeviceBuffers(deviceBuffers);
+
+  std::lock_guard<std::mutex> bufferSizeLock(this->BufferSizeMutex);
+
+  bufferMemoryUsage.clear();
+  totalMemoryUsageBytes = 0;
+  for (std::vector<DeviceBuffer>::iterator it = deviceBuffers.begin(); it != deviceBuffers.end(); ++it)
+  {
+    BufferMemoryUsage usage;
+    usage.DeviceId = it->DeviceId;
+    usage.SourceId = it->SourceId;
+    usage.BufferSize = it->Buffer->GetBufferSize();
+    usage.ItemSizeBytes = it->Buffer->GetItemSizeBytes();
+    usage.MemoryUsageBytes = usage.ItemSizeBytes * static_cast<size_t>(usage.BufferSize);
+    std::map<vtkPlusBuffer*, BufferSizeState>::iterator stateIt = this->BufferSizeStates.find(it->Buffer);
+    if (stateIt != this->BufferSizeStates.end())
+    {
+      // values of the last completed measurement period
+      usage.ConfiguredBufferSize = stateIt->second.ConfiguredBufferSize;
+      usage.ConsumerLagSec = stateIt->second.ConsumerLagSec;
+      usage.NumberOfItemsNotAvailableAnymore = stateIt->second.NumberOfItemsNotAvailableAnymore;
+    }
+    else
+    {
+      usage.ConfiguredBufferSize = usage.BufferSize;
+      it->Buffer->GetConsumerLag(usage.ConsumerLagSec, usage.NumberOfItemsNotAvailableAnymore, false);
+    }
+    totalMemoryUsageBytes += usage.MemoryUsageBytes;
+    bufferMemoryUsage.push_back(usage);
+  }
+
   return PLUS_SUCCESS;
 }
 
@@ -472,20 +986,24 @@ bool vtkPlusDataCollector::GetConnected() const
 }
 
 //----------------------------------------------------------------------------
-PlusStatus vtkPlusDataCollector::DumpBuffersToDirectory(const char* aDirectory)
+PlusStatus vtkPlusDataCollector::DumpBuffersToDirectory(const char* aDirectory, bool waitForCompletion /*=true*/)
 {
   LOG_TRACE("vtkPlusDataCollector::DumpBuffersToDirectory(" << aDirectory << ")");
 
+  // Snapshots of the previous dump are released before new ones are taken
+  this->WaitForBufferDump();
+
   // Assemble file names
   std::string dateAndTime = vtksys::SystemTools::GetCurrentDateTime("%Y%m%d_%H%M%S");
 
+  // Take the snapshots of all the buffers before writing any of them, so that the dumps cover the same time range
+  std::vector<BufferDump> bufferDumps;
+  PlusStatus status = PLUS_SUCCESS;
   for (DeviceCollectionIterator it = this->Devices.begin(); it != this->Devices.end(); ++it)
   {
     vtkPlusDevice* device = *it;
 
-    std::string outputDeviceBufferSequenceFileName = vtkPlusConfig::GetInstance()->GetOutputPath(std::string("BufferDump_") + device->GetDeviceId() + "_" + dateAndTime + ".nrrd");
-
-    LOG_INFO("Write device buffer to " << outputDeviceBufferSequenceFileName);
+    std::set<vtkPlusBuffer*> dumpedBuffers;
     vtkPlusDataSource* aSource(NULL);
     for (ChannelContainerIterator chanIt = device->GetOutputChannelsStart(); chanIt != device->GetOutputChannelsEnd(); ++chanIt)
     {
@@ -494,11 +1012,82 @@ PlusStatus vtkPlusDataCollector::DumpBuffersToDirectory(const char* aDirectory)
         LOG_ERROR("Unable to retrieve the video source in the device.");
         return PLUS_FAIL;
       }
-      aSource->WriteToSequenceFile(outputDeviceBufferSequenceFileName.c_str(), false);
+      if (!dumpedBuffers.insert(aSource->GetBuffer()).second)
+      {
+        // multiple channels of the device provide the same video source
+        continue;
+      }
+
+      // Additional video sources of the device are written to separate files
+      std::string sourceName = dumpedBuffers.size() > 1 ? std::string("_") + aSource->GetId() : std::string();
+      BufferDump bufferDump;
+      bufferDump.FileName = vtkPlusConfig::GetInstance()->GetOutputPath(std::string("BufferDump_") + device->GetDeviceId() + sourceName + "_" + dateAndTime + ".nrrd");
+      if (aSource->GetBuffer()->GetSnapshot(bufferDump.Snapshot) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Failed to take a snapshot of the buffer of " << aSource->GetId() << " in device " << device->GetDeviceId());
+        status = PLUS_FAIL;
+      }
+      bufferDumps.push_back(bufferDump);
     }
   }
 
-  return PLUS_SUCCESS;
+  if (waitForCompletion)
+  {
+    if (WriteBufferDumps(bufferDumps) != PLUS_SUCCESS)
+    {
+      status = PLUS_FAIL;
+    }
+    return status;
+  }
+
+  this->PendingBufferDumps.swap(bufferDumps);
+  this->BufferDumpThreadAlive = true;
+  this->BufferDumpThreadId = this->BufferDumpThreader->SpawnThread((vtkThreadFunctionType)&BufferDumpThread, this);
+  return status;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusDataCollector::WriteBufferDumps(std::vector<BufferDump>& bufferDumps)
+{
+  PlusStatus status = PLUS_SUCCESS;
+  for (std::vector<BufferDump>::iterator dumpIt = bufferDumps.begin(); dumpIt != bufferDumps.end(); ++dumpIt)
+  {
+    LOG_INFO("Write device buffer to " << dumpIt->FileName);
+    if (vtkPlusBuffer::WriteSnapshotToSequenceFile(dumpIt->Snapshot, dumpIt->FileName.c_str(), false) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to write device buffer to " << dumpIt->FileName);
+      status = PLUS_FAIL;
+    }
+    // Release the pinned items as soon as possible
+    dumpIt->Snapshot.Items.clear();
+  }
+  bufferDumps.clear();
+  return status;
+}
+
+//----------------------------------------------------------------------------
+void* vtkPlusDataCollector::BufferDumpThread(vtkMultiThreader::ThreadInfo* data)
+{
+  vtkPlusDataCollector* self = (vtkPlusDataCollector*)(data->UserData);
+  WriteBufferDumps(self->PendingBufferDumps);
+  self->BufferDumpThreadAlive = false;
+  return NULL;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusDataCollector::WaitForBufferDump()
+{
+  if (this->BufferDumpThreadId < 0)
+  {
+    return;
+  }
+  LOG_DEBUG("Wait for buffer dump thread to terminate");
+  while (this->BufferDumpThreadAlive)
+  {
+    vtkIGSIOAccurateTimer::Delay(0.1);
+  }
+  this->BufferDumpThreader->TerminateThread(this->BufferDumpThreadId);
+  this->BufferDumpThreadId = -1;
 }
 
 //----------------------------------------------------------------------------
@@ -631,10 +1220,10 @@ PlusStatus vtkPlusDataCollector::GetVideoData(vtkPlusChannel* aRequestedChannel,
     trackedFrame->SetTimestamp(itemTimestamp);
 
     // Copy all custom fields
-    igsioFieldMapType fieldMap = currentStreamBufferItem.GetFrameFieldMap();
-    for (igsioFieldMapType::const_iterator fieldIterator = fieldMap.begin(); fieldIterator != fieldMap.end(); fieldIterator++)
+    const std::vector<PlusFrameFieldStore::Field>& fields = currentStreamBufferItem.GetFrameFieldStore().GetFields();
+    for (std::vector<PlusFrameFieldStore::Field>::const_iterator fieldIterator = fields.begin(); fieldIterator != fields.end(); ++fieldIterator)
     {
-      trackedFrame->SetFrameField(fieldIterator->first, fieldIterator->second.second, fieldIterator->second.first);
+      trackedFrame->SetFrameField(*(fieldIterator->Name), *(fieldIterator->Value), fieldIterator->Flags);
     }
 
     // Add tracked frame to the list
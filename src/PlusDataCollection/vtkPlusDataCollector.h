@@ -9,13 +9,24 @@ See License.txt for details.
 
 // Local includes
 #include "igsioCommon.h"
+#include "vtkPlusBuffer.h"
 #include "vtkPlusDataCollectionExport.h"
 #include "vtkPlusDevice.h"
 
 // VTK includes
+#include <vtkMultiThreader.h>
 #include <vtkObject.h>
+#include <vtkWeakPointer.h>
+
+// STL includes
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
 
 //class igsioTrackedFrame; 
+class PlusAcquisitionScheduler;
 class vtkPlusChannel;
 class vtkPlusDeviceFactory;
 //class vtkIGSIOTrackedFrameList;
@@ -32,6 +43,31 @@ Provides an interface for clients to connect to a device set, and request data t
 class vtkPlusDataCollectionExport vtkPlusDataCollector : public vtkObject
 {
 public:
+  /*! Memory accounting of a buffer, see GetBufferMemoryUsage */
+  struct BufferMemoryUsage
+  {
+    std::string DeviceId;
+    std::string SourceId;
+    /*! Current number of items that the buffer can hold */
+    int BufferSize;
+    /*! Buffer size that was set in the configuration (buffer size before the first adaptation) */
+    int ConfiguredBufferSize;
+    size_t ItemSizeBytes;
+    size_t MemoryUsageBytes;
+    /*! Time difference between the latest item and the oldest requested item (in seconds) */
+    double ConsumerLagSec;
+    /*! Number of requests for items that had already been overwritten */
+    int NumberOfItemsNotAvailableAnymore;
+  };
+
+  /*! Latency statistics of a processing stage, see GetLatencyHistograms */
+  struct LatencyHistogramSnapshot
+  {
+    /*! Name of the stage and where it was measured, for example Commit:TrackerDevice/Probe or Read:TrackedVideoStream */
+    std::string Name;
+    PlusLatencyHistogram::Snapshot Snapshot;
+  };
+
   static vtkPlusDataCollector* New();
   vtkTypeMacro(vtkPlusDataCollector, vtkObject);
   virtual void PrintSelf(ostream& os, vtkIndent indent) VTK_OVERRIDE;
@@ -114,10 +150,13 @@ public:
 
   /*!
     Have each device dump their buffers to disk
+    A snapshot of all the video buffers is taken first (see vtkPlusBuffer::GetSnapshot), so acquisition is not blocked
+    while the files are written and the items that are acquired during writing do not replace the dumped ones.
     \param aDirectory directory to dump to
-    \param maxTimeLimitSec Maximum time spent in the function (in sec)
+    \param waitForCompletion If false then the files are written on a background thread and the method returns
+      right after the snapshots are taken. The next dump waits for the completion of the previous one.
   */
-  PlusStatus DumpBuffersToDirectory(const char* aDirectory);
+  PlusStatus DumpBuffersToDirectory(const char* aDirectory, bool waitForCompletion = true);
 
   /*!
     Get tracking data in a tracked frame list since time specified
@@ -154,6 +193,55 @@ public:
   /*! Get startup delay in sec to give some time to the buffers for proper initialization */
   vtkGetMacro(StartupDelaySec, double);
 
+  /*!
+    Set the maximum amount of memory that the buffers of all the devices may use together, in MB.
+    If it is larger than 0 then the buffer sizes are adapted to the consumer lag while the data collection is started.
+  */
+  vtkSetMacro(BufferMemoryBudgetMb, double);
+  /*! Get the maximum amount of memory that the buffers of all the devices may use together, in MB. 0 if there is no limit. */
+  vtkGetMacro(BufferMemoryBudgetMb, double);
+
+  /*!
+    Adapt the size of each buffer to the consumer lag (how old items the consumers still request):
+    buffers grow if old items are requested or items were not available anymore, and shrink back
+    to the configured size if they are not needed. The total memory usage is kept within BufferMemoryBudgetMb.
+    It is called periodically while the data collection is started, if BufferMemoryBudgetMb is set.
+  */
+  PlusStatus UpdateBufferSizes();
+
+  /*! Get the memory accounting of the buffers of all the devices */
+  PlusStatus GetBufferMemoryUsage(std::vector<BufferMemoryUsage>& bufferMemoryUsage, size_t& totalMemoryUsageBytes);
+
+  /*!
+    Get the latency histograms of the buffers of all the devices (Commit stage: from the unfiltered timestamp of the items until they are added to the buffer)
+    and of the output channels of all the devices (Read stage: age of the tracked frames when they are read from the channel)
+  */
+  void GetLatencyHistograms(std::vector<LatencyHistogramSnapshot>& latencyHistograms) const;
+
+  /*!
+    Set the number of shared threads that perform the internal updates of the devices.
+    If it is 0 then each device that requires polling starts its own data capture thread.
+    It cannot be changed while any of the devices is recording.
+    In virtual-time mode a single thread is used, the specified size is applied when real-time mode is set.
+  */
+  PlusStatus SetAcquisitionThreadPoolSize(int poolSize);
+  /*! Get the number of shared threads that perform the internal updates of the devices. 0 if each device uses its own thread, 1 in virtual-time mode. */
+  vtkGetMacro(AcquisitionThreadPoolSize, int);
+
+  /*! Get the scheduler that performs the internal updates of the devices. NULL if each device uses its own thread. */
+  PlusAcquisitionScheduler* GetAcquisitionScheduler() const;
+
+  /*!
+    Set the clock that the devices use (see PlusClock). In virtual-time mode the internal updates of the devices
+    are performed by a single acquisition thread, which advances the virtual time instead of waiting, therefore
+    devices that do not depend on hardware (e.g., saved data sources and virtual devices) run as fast as possible,
+    with the same results in every run. It cannot be changed while any of the devices is recording.
+    \param virtualStartTimeSec Initial value of the virtual time
+  */
+  PlusStatus SetClockMode(PlusClock::ClockMode clockMode, double virtualStartTimeSec = 0.0);
+  /*! Get the clock mode that is set in the configuration */
+  vtkGetMacro(ClockMode, PlusClock::ClockMode);
+
 protected:
   vtkPlusDataCollector();
   virtual ~vtkPlusDataCollector();
@@ -168,6 +256,71 @@ protected:
   bool Connected;
   bool Started;
 
+  /*! Buffer of a data source and the device that provides it */
+  struct DeviceBuffer
+  {
+    std::string DeviceId;
+    std::string SourceId;
+    vtkPlusBuffer* Buffer;
+  };
+  /*! Get the buffers of all the devices (each buffer is listed only once, even if multiple devices use the data source) */
+  void GetDeviceBuffers(std::vector<DeviceBuffer>& deviceBuffers) const;
+
+  /*! Create the scheduler with the specified number of threads, without changing the configured pool size */
+  PlusStatus ApplyAcquisitionThreadPoolSize(int poolSize);
+
+  /*! Thread that periodically updates the buffer sizes */
+  static void* BufferSizeUpdateThread(vtkMultiThreader::ThreadInfo* data);
+
+  /*! Adaptation state of a buffer */
+  struct BufferSizeState
+  {
+    /*! The buffer that the state belongs to, NULL if it has been deleted (the address may be reused by another buffer) */
+    vtkWeakPointer<vtkPlusBuffer> Buffer;
+    int ConfiguredBufferSize;
+    double ConsumerLagSec;
+    int NumberOfItemsNotAvailableAnymore;
+    /*! System time of the last change of the buffer size */
+    double LastResizeTime;
+  };
+
+  double BufferMemoryBudgetMb;
+  std::map<vtkPlusBuffer*, BufferSizeState> BufferSizeStates;
+  /*! True if the configured buffer sizes alone exceed the memory budget (the warning is only logged once) */
+  bool BufferMemoryBudgetExceeded;
+  std::mutex BufferSizeMutex;
+  vtkSmartPointer<vtkMultiThreader> BufferSizeUpdateThreader;
+  int BufferSizeUpdateThreadId;
+  bool BufferSizeUpdateThreadAlive;
+
+  /*! Number of threads of the scheduler that is in use */
+  int AcquisitionThreadPoolSize;
+  /*! Number of threads that was set by SetAcquisitionThreadPoolSize, it is used in real-time mode */
+  int ConfiguredAcquisitionThreadPoolSize;
+  std::unique_ptr<PlusAcquisitionScheduler> AcquisitionScheduler;
+
+  PlusClock::ClockMode ClockMode;
+  double VirtualClockStartTimeSec;
+
+  /*! Snapshot of a buffer that is written to a file by DumpBuffersToDirectory */
+  struct BufferDump
+  {
+    std::string FileName;
+    vtkPlusBuffer::Snapshot Snapshot;
+  };
+  /*! Write the buffer dumps to files and release the snapshots */
+  static PlusStatus WriteBufferDumps(std::vector<BufferDump>& bufferDumps);
+  /*! Thread that writes the pending buffer dumps */
+  static void* BufferDumpThread(vtkMultiThreader::ThreadInfo* data);
+  /*! Wait until the buffer dump thread has written all the pending buffer dumps */
+  void WaitForBufferDump();
+
+  /*! Buffer dumps that are being written by the buffer dump thread */
+  std::vector<BufferDump> PendingBufferDumps;
+  vtkSmartPointer<vtkMultiThreader> BufferDumpThreader;
+  int BufferDumpThreadId;
+  bool BufferDumpThreadAlive;
+
 private:
   vtkPlusDataCollector(const vtkPlusDataCollector&);
   void operator=(const vtkPlusDataCollector&);
@@ -401,6 +401,18 @@ PlusStatus vtkPlusDataSource::ReadConfiguration(vtkXMLDataElement* sourceElement
     LOG_DEBUG("AveragedItemsForFiltering is not defined in source element \"" << this->GetId() << "\". Using default value: " << this->GetBuffer()->GetAveragedItemsForFiltering());
   }
 
+  XML_READ_BOOL_ATTRIBUTE_OPTIONAL(LockFreeReads, sourceElement);
+  XML_READ_BOOL_ATTRIBUTE_OPTIONAL(UseHugePages, sourceElement);
+  if (this->GetType() == DATA_SOURCE_TYPE_TOOL)
+  {
+    // Only tool buffers contain nothing but transforms
+    XML_READ_BOOL_ATTRIBUTE_OPTIONAL(CompactTransformStorage, sourceElement);
+  }
+  else
+  {
+    XML_READ_BOOL_ATTRIBUTE_OPTIONAL(LazyImageOrientation, sourceElement);
+  }
+
   std::string descName;
   if (!aDescriptiveNameForBuffer.empty())
   {
@@ -414,6 +426,17 @@ PlusStatus vtkPlusDataSource::ReadConfiguration(vtkXMLDataElement* sourceElement
   }
   this->GetBuffer()->SetDescriptiveName(descName.c_str());
 
+  // The name of the spill file is based on the descriptive name, so it is set up after the name is known
+  int spillFileSizeMb = 0;
+  if (sourceElement->GetScalarAttribute("SpillFileSizeMb", spillFileSizeMb) && spillFileSizeMb > 0)
+  {
+    if (this->GetBuffer()->SetSpillFileSizeBytes(static_cast<size_t>(spillFileSizeMb) * 1024 * 1024) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to create spill file for source \"" << this->GetId() << "\"");
+      return PLUS_FAIL;
+    }
+  }
+
   // Read custom properties
   for (int i = 0; i < sourceElement->GetNumberOfNestedElements(); ++i)
   {
@@ -456,6 +479,10 @@ PlusStatus vtkPlusDataSource::WriteConfiguration(vtkXMLDataElement* aSourceEleme
 
   XML_WRITE_STRING_ATTRIBUTE_IF_NOT_EMPTY(PortName, aSourceElement);
   aSourceElement->SetIntAttribute("BufferSize", this->GetBuffer()->GetBufferSize());
+  if (this->GetBuffer()->GetSpillFileSizeBytes() > 0)
+  {
+    aSourceElement->SetIntAttribute("SpillFileSizeMb", static_cast<int>(this->GetBuffer()->GetSpillFileSizeBytes() / (1024 * 1024)));
+  }
 
   if (aSourceElement->GetAttribute("AveragedItemsForFiltering") != NULL)
   {
@@ -573,6 +600,14 @@ PlusStatus vtkPlusDataSource::AddItem(void* imageDataPtr, US_IMAGE_ORIENTATION u
                                     this->ClipRectangleOrigin, this->ClipRectangleSize, unfilteredTimestamp, filteredTimestamp, customFields);
 }
 
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusDataSource::AddItem(void* imageDataPtr, PixelCodec::PixelEncoding inputEncoding, US_IMAGE_ORIENTATION usImageOrientation, const FrameSizeType& frameSizeInPx, long frameNumber,
+                                      double unfilteredTimestamp /*= UNDEFINED_TIMESTAMP*/, double filteredTimestamp /*= UNDEFINED_TIMESTAMP*/, const igsioFieldMapType* customFields /*= NULL*/)
+{
+  return this->GetBuffer()->AddItem(imageDataPtr, inputEncoding, usImageOrientation, frameSizeInPx, frameNumber,
+                                    this->ClipRectangleOrigin, this->ClipRectangleSize, unfilteredTimestamp, filteredTimestamp, customFields);
+}
+
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusDataSource::AddItem(void* imageDataPtr, const FrameSizeType& frameSize, unsigned int frameSizeInBytes, US_IMAGE_TYPE imageType, long frameNumber, double unfilteredTimestamp /*= UNDEFINED_TIMESTAMP*/, double filteredTimestamp /*= UNDEFINED_TIMESTAMP*/, const igsioFieldMapType* customFields /*= NULL*/)
 {
@@ -789,6 +824,12 @@ ItemStatus vtkPlusDataSource::GetItemUidFromTime(double time, BufferItemUidType&
   return this->GetBuffer()->GetItemUidFromTime(time, uid);
 }
 
+//-----------------------------------------------------------------------------
+void vtkPlusDataSource::GetItemUidsFromTimes(const double* times, int numberOfTimes, BufferItemUidType* uids, ItemStatus* statuses)
+{
+  this->GetBuffer()->GetItemUidsFromTimes(times, numberOfTimes, uids, statuses);
+}
+
 //-----------------------------------------------------------------------------
 bool vtkPlusDataSource::GetLatestItemHasValidVideoData()
 {
@@ -813,6 +854,18 @@ ItemStatus vtkPlusDataSource::GetStreamBufferItem(BufferItemUidType uid, StreamB
   return this->GetBuffer()->GetStreamBufferItem(uid, bufferItem);
 }
 
+//-----------------------------------------------------------------------------
+ItemStatus vtkPlusDataSource::GetStreamBufferItemView(BufferItemUidType uid, StreamBufferItemView& bufferItemView)
+{
+  return this->GetBuffer()->GetStreamBufferItemView(uid, bufferItemView);
+}
+
+//-----------------------------------------------------------------------------
+void vtkPlusDataSource::GetStreamBufferItemViewsFromTimes(const double* times, int numberOfTimes, StreamBufferItemView* bufferItemViews, ItemStatus* statuses)
+{
+  this->GetBuffer()->GetStreamBufferItemViewsFromTimes(times, numberOfTimes, bufferItemViews, statuses);
+}
+
 //-----------------------------------------------------------------------------
 ItemStatus vtkPlusDataSource::GetLatestStreamBufferItem(StreamBufferItem* bufferItem)
 {
@@ -831,6 +884,23 @@ ItemStatus vtkPlusDataSource::GetStreamBufferItemFromTime(double time, StreamBuf
   return this->GetBuffer()->GetStreamBufferItemFromTime(time, bufferItem, interpolation);
 }
 
+//-----------------------------------------------------------------------------
+PlusStatus vtkPlusDataSource::GetInterpolatedPosesFromTimes(const double* times, int numberOfTimes, PlusInterpolatedPose* poses)
+{
+  return this->GetBuffer()->GetInterpolatedPosesFromTimes(times, numberOfTimes, poses);
+}
+
+//-----------------------------------------------------------------------------
+PlusStatus vtkPlusDataSource::GetInterpolatedPosesFromTime(double time, vtkPlusDataSource* const* sources, int numberOfSources, PlusInterpolatedPose* poses)
+{
+  std::vector<vtkPlusBuffer*> buffers(numberOfSources);
+  for (int i = 0; i < numberOfSources; ++i)
+  {
+    buffers[i] = sources[i]->GetBuffer();
+  }
+  return vtkPlusBuffer::GetInterpolatedPosesFromTime(time, buffers.data(), numberOfSources, poses);
+}
+
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusDataSource::ModifyBufferItemFrameField(BufferItemUidType uid, const std::string& key, const std::string& value)
 {
@@ -903,6 +973,66 @@ bool vtkPlusDataSource::GetTimeStampReporting()
   return this->GetBuffer()->GetTimeStampReporting();
 }
 
+//-----------------------------------------------------------------------------
+void vtkPlusDataSource::SetLockFreeReads(bool enable)
+{
+  this->GetBuffer()->SetLockFreeReads(enable);
+}
+
+//-----------------------------------------------------------------------------
+bool vtkPlusDataSource::GetLockFreeReads()
+{
+  return this->GetBuffer()->GetLockFreeReads();
+}
+
+//-----------------------------------------------------------------------------
+PlusStatus vtkPlusDataSource::SetCompactTransformStorage(bool enable)
+{
+  return this->GetBuffer()->SetCompactTransformStorage(enable);
+}
+
+//-----------------------------------------------------------------------------
+bool vtkPlusDataSource::GetCompactTransformStorage()
+{
+  return this->GetBuffer()->GetCompactTransformStorage();
+}
+
+//-----------------------------------------------------------------------------
+PlusStatus vtkPlusDataSource::SetUseHugePages(bool useHugePages)
+{
+  return this->GetBuffer()->SetUseHugePages(useHugePages);
+}
+
+//-----------------------------------------------------------------------------
+bool vtkPlusDataSource::GetUseHugePages()
+{
+  return this->GetBuffer()->GetUseHugePages();
+}
+
+//-----------------------------------------------------------------------------
+void vtkPlusDataSource::SetLazyImageOrientation(bool enable)
+{
+  this->GetBuffer()->SetLazyImageOrientation(enable);
+}
+
+//-----------------------------------------------------------------------------
+bool vtkPlusDataSource::GetLazyImageOrientation()
+{
+  return this->GetBuffer()->GetLazyImageOrientation();
+}
+
+//-----------------------------------------------------------------------------
+unsigned long vtkPlusDataSource::AddItemAddedCallback(vtkPlusBuffer::ItemAddedCallbackType callback)
+{
+  return this->GetBuffer()->AddItemAddedCallback(callback);
+}
+
+//-----------------------------------------------------------------------------
+void vtkPlusDataSource::RemoveItemAddedCallback(unsigned long callbackId)
+{
+  this->GetBuffer()->RemoveItemAddedCallback(callbackId);
+}
+
 //-----------------------------------------------------------------------------
 PlusStatus vtkPlusDataSource::WriteToSequenceFile(const char* filename, bool useCompression /*= false */)
 {
@@ -122,6 +122,8 @@ public:
   virtual BufferItemUidType GetOldestItemUidInBuffer();
   virtual BufferItemUidType GetLatestItemUidInBuffer();
   virtual ItemStatus GetItemUidFromTime(double time, BufferItemUidType& uid);
+  /*! Get the UIDs of the items that are the closest to multiple timestamps (see vtkPlusBuffer::GetItemUidsFromTimes) */
+  virtual void GetItemUidsFromTimes(const double* times, int numberOfTimes, BufferItemUidType* uids, ItemStatus* statuses);
 
   /*! Returns true if the latest item contains valid video data */
   virtual bool GetLatestItemHasValidVideoData();
@@ -138,8 +140,16 @@ public:
   virtual ItemStatus GetLatestStreamBufferItem(StreamBufferItem* bufferItem);
   /*! Get the oldest frame from buffer */
   virtual ItemStatus GetOldestStreamBufferItem(StreamBufferItem* bufferItem);
+  /*! Get a read-only reference to the frame with the specified frame uid, without copying it (see vtkPlusBuffer::GetStreamBufferItemView) */
+  virtual ItemStatus GetStreamBufferItemView(BufferItemUidType uid, StreamBufferItemView& bufferItemView);
+  /*! Get read-only references to the items that are the closest to multiple timestamps (see vtkPlusBuffer::GetStreamBufferItemViewsFromTimes) */
+  virtual void GetStreamBufferItemViewsFromTimes(const double* times, int numberOfTimes, StreamBufferItemView* bufferItemViews, ItemStatus* statuses);
   /*! Get a frame that was acquired at the specified time from buffer */
   virtual ItemStatus GetStreamBufferItemFromTime(double time, StreamBufferItem* bufferItem, vtkPlusBuffer::DataItemTemporalInterpolationType interpolation);
+  /*! Get the interpolated pose of the tool at multiple timestamps (see vtkPlusBuffer::GetInterpolatedPosesFromTimes) */
+  virtual PlusStatus GetInterpolatedPosesFromTimes(const double* times, int numberOfTimes, PlusInterpolatedPose* poses);
+  /*! Get the interpolated pose of multiple tools at the same timestamp (see vtkPlusBuffer::GetInterpolatedPosesFromTime) */
+  static PlusStatus GetInterpolatedPosesFromTime(double time, vtkPlusDataSource* const* sources, int numberOfSources, PlusInterpolatedPose* poses);
   /*! Update a field in the specified stream buffer item */
   virtual PlusStatus ModifyBufferItemFrameField(BufferItemUidType uid, const std::string& key, const std::string& value);
 
@@ -160,6 +170,37 @@ public:
   /*! If TimeStampReporting is enabled then all filtered and unfiltered timestamp values will be saved in a table for diagnostic purposes. */
   bool GetTimeStampReporting();
 
+  /*! If LockFreeReads is enabled then item UIDs and timestamps can be queried without waiting for the buffer lock */
+  void SetLockFreeReads(bool enable);
+  /*! Get if item UIDs and timestamps can be queried without waiting for the buffer lock */
+  bool GetLockFreeReads();
+
+  /*! If CompactTransformStorage is enabled then the buffer of the tool stores transforms in compact arrays instead of buffer item objects */
+  PlusStatus SetCompactTransformStorage(bool enable);
+  /*! Get if the buffer of the tool stores transforms in compact arrays */
+  bool GetCompactTransformStorage();
+
+  /*! If UseHugePages is enabled then the pixel data of the buffered frames is backed by transparent huge pages (only has effect on Linux) */
+  PlusStatus SetUseHugePages(bool useHugePages);
+  /*! Get if the pixel data of the buffered frames is backed by transparent huge pages */
+  bool GetUseHugePages();
+
+  /*!
+    If LazyImageOrientation is enabled then frames are buffered in the orientation they are acquired in
+    and they are reoriented when they are retrieved (see vtkPlusBuffer::SetLazyImageOrientation)
+  */
+  void SetLazyImageOrientation(bool enable);
+  /*! Get if frames are buffered in the orientation they are acquired in */
+  bool GetLazyImageOrientation();
+
+  /*!
+    Register a function that is called after each new item is added to the buffer of the source
+    (see vtkPlusBuffer::AddItemAddedCallback)
+  */
+  unsigned long AddItemAddedCallback(vtkPlusBuffer::ItemAddedCallbackType callback);
+  /*! Remove a function that was registered by AddItemAddedCallback */
+  void RemoveItemAddedCallback(unsigned long callbackId);
+
   /*!
     Set the size of the buffer, i.e. the maximum number of
     video frames that it will hold.  The default is 30.
@@ -228,6 +269,19 @@ public:
                              double filteredTimestamp = UNDEFINED_TIMESTAMP,
                              const igsioFieldMapType* customFields = NULL);
 
+  /*!
+    Add a frame in the specified pixel encoding. The pixels are converted to the pixel format of the buffer,
+    reoriented and copied into the buffer in a single pass (see vtkPlusBuffer::AddItem).
+  */
+  virtual PlusStatus AddItem(void* imageDataPtr,
+                             PixelCodec::PixelEncoding inputEncoding,
+                             US_IMAGE_ORIENTATION usImageOrientation,
+                             const FrameSizeType& frameSizeInPx,
+                             long frameNumber,
+                             double unfilteredTimestamp = UNDEFINED_TIMESTAMP,
+                             double filteredTimestamp = UNDEFINED_TIMESTAMP,
+                             const igsioFieldMapType* customFields = NULL);
+
   /*!
     Add a frame plus a timestamp to the buffer with frame index.
     Additionally an optional field name&value can be added,
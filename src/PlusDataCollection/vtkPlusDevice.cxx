@@ -6,8 +6,10 @@ See License.txt for details.
 
 // Local includes
 #include "PlusConfigure.h"
+#include "PlusAcquisitionScheduler.h"
 #include "vtkPlusBuffer.h"
 #include "vtkPlusChannel.h"
+#include "vtkPlusDataCollector.h"
 #include "vtkPlusDataSource.h"
 #include "vtkPlusDevice.h"
 #include "vtkIGSIORecursiveCriticalSection.h"
@@ -31,6 +33,18 @@ See License.txt for details.
 // System includes
 #include <ctype.h>
 #include <time.h>
+#if !defined(_WIN32)
+  #include <errno.h>
+  #include <pthread.h>
+  #include <sched.h>
+  #include <string.h>
+  #include <sys/mman.h>
+#endif
+#if defined(__linux__)
+  #include <sys/resource.h>
+  #include <sys/syscall.h>
+  #include <unistd.h>
+#endif
 
 #if ( _MSC_VER >= 1300 ) // Visual studio .NET
   #pragma warning ( disable : 4311 )
@@ -114,6 +128,8 @@ vtkStandardNewMacro(vtkPlusDevice);
 
 const int vtkPlusDevice::VIRTUAL_DEVICE_FRAME_RATE = 50;
 static const int FRAME_RATE_AVERAGING = 10;
+// Nice value of data capture threads with high priority
+static const int CAPTURE_THREAD_HIGH_PRIORITY_NICE_VALUE = -10;
 const std::string vtkPlusDevice::BMODE_PORT_NAME = "B";
 const std::string vtkPlusDevice::RFMODE_PORT_NAME = "Rf";
 const std::string vtkPlusDevice::PARAMETERS_XML_ELEMENT_TAG = "Parameters";
@@ -125,6 +141,8 @@ vtkPlusDevice::vtkPlusDevice()
   , Connected(0)
   , Threader(vtkMultiThreader::New())
   , ThreadId(-1)
+  , AcquisitionScheduler(NULL)
+  , UpdateCount(0)
   , CurrentStreamBufferItem(new StreamBufferItem())
   , ToolReferenceFrameName("")
   , DeviceId("")
@@ -141,6 +159,9 @@ vtkPlusDevice::vtkPlusDevice()
   , StartThreadForInternalUpdates(false)
   , LocalTimeOffsetSec(0.0)
   , MissingInputGracePeriodSec(0.0)
+  , ThreadPriority(CAPTURE_THREAD_PRIORITY_NORMAL)
+  , LockMemory(false)
+  , LockProcessMemory(false)
   , RequireImageOrientationInConfiguration(false)
   , RequirePortNameInDeviceSetConfiguration(false)
 {
@@ -607,6 +628,10 @@ void vtkPlusDevice::DeepCopy(const vtkPlusDevice& device)
   this->CorrectlyConfigured = device.GetCorrectlyConfigured();
   this->LocalTimeOffsetSec = device.GetLocalTimeOffsetSec();
   this->MissingInputGracePeriodSec = device.GetMissingInputGracePeriodSec();
+  this->ThreadPriority = device.ThreadPriority;
+  this->CpuAffinity = device.CpuAffinity;
+  this->LockMemory = device.LockMemory;
+  this->LockProcessMemory = device.LockProcessMemory;
   this->RequireImageOrientationInConfiguration = device.RequireImageOrientationInConfiguration;
   this->RequirePortNameInDeviceSetConfiguration = device.RequirePortNameInDeviceSetConfiguration;
   this->Parameters = device.Parameters;
@@ -1103,6 +1128,48 @@ PlusStatus vtkPlusDevice::ReadConfiguration(vtkXMLDataElement* rootXMLElement)
     LOCAL_LOG_DEBUG("Local time offset was not defined in device configuration");
   }
 
+  // Data capture thread settings
+  const char* threadPriority = deviceXMLElement->GetAttribute("ThreadPriority");
+  if (threadPriority != NULL)
+  {
+    if (igsioCommon::IsEqualInsensitive(threadPriority, "Normal"))
+    {
+      this->SetThreadPriority(CAPTURE_THREAD_PRIORITY_NORMAL);
+    }
+    else if (igsioCommon::IsEqualInsensitive(threadPriority, "High"))
+    {
+      this->SetThreadPriority(CAPTURE_THREAD_PRIORITY_HIGH);
+    }
+    else if (igsioCommon::IsEqualInsensitive(threadPriority, "RealTime"))
+    {
+      this->SetThreadPriority(CAPTURE_THREAD_PRIORITY_REALTIME);
+    }
+    else
+    {
+      LOCAL_LOG_ERROR("Invalid ThreadPriority: " << threadPriority << ". Valid values: Normal, High, RealTime.");
+      return PLUS_FAIL;
+    }
+  }
+  const char* cpuAffinity = deviceXMLElement->GetAttribute("CpuAffinity");
+  if (cpuAffinity != NULL)
+  {
+    std::vector<int> cpuIndices;
+    std::vector<std::string> tokens = igsioCommon::SplitStringIntoTokens(cpuAffinity, ' ', false);
+    for (std::vector<std::string>::iterator tokenIt = tokens.begin(); tokenIt != tokens.end(); ++tokenIt)
+    {
+      int cpuIndex(-1);
+      if (igsioCommon::StringToNumber<int>(*tokenIt, cpuIndex) != PLUS_SUCCESS || cpuIndex < 0)
+      {
+        LOCAL_LOG_ERROR("Invalid CpuAffinity: " << cpuAffinity << ". Expected a space-separated list of CPU indices.");
+        return PLUS_FAIL;
+      }
+      cpuIndices.push_back(cpuIndex);
+    }
+    this->SetCpuAffinity(cpuIndices);
+  }
+  XML_READ_BOOL_ATTRIBUTE_OPTIONAL(LockMemory, deviceXMLElement);
+  XML_READ_BOOL_ATTRIBUTE_OPTIONAL(LockProcessMemory, deviceXMLElement);
+
   // Parameter reading
   XML_FIND_NESTED_ELEMENT_OPTIONAL(parametersElem, deviceXMLElement, vtkPlusDevice::PARAMETERS_XML_ELEMENT_TAG.c_str());
   if (parametersElem)
@@ -1201,6 +1268,47 @@ PlusStatus vtkPlusDevice::WriteConfiguration(vtkXMLDataElement* config)
     deviceDataElement->SetDoubleAttribute("LocalTimeOffsetSec", this->GetLocalTimeOffsetSec());
   }
 
+  switch (this->ThreadPriority)
+  {
+    case CAPTURE_THREAD_PRIORITY_HIGH:
+      deviceDataElement->SetAttribute("ThreadPriority", "High");
+      break;
+    case CAPTURE_THREAD_PRIORITY_REALTIME:
+      deviceDataElement->SetAttribute("ThreadPriority", "RealTime");
+      break;
+    default:
+      deviceDataElement->RemoveAttribute("ThreadPriority");
+  }
+  if (!this->CpuAffinity.empty())
+  {
+    std::ostringstream cpuAffinity;
+    for (std::vector<int>::const_iterator cpuIt = this->CpuAffinity.begin(); cpuIt != this->CpuAffinity.end(); ++cpuIt)
+    {
+      cpuAffinity << (cpuIt == this->CpuAffinity.begin() ? "" : " ") << *cpuIt;
+    }
+    deviceDataElement->SetAttribute("CpuAffinity", cpuAffinity.str().c_str());
+  }
+  else
+  {
+    deviceDataElement->RemoveAttribute("CpuAffinity");
+  }
+  if (this->LockMemory)
+  {
+    deviceDataElement->SetAttribute("LockMemory", "TRUE");
+  }
+  else
+  {
+    deviceDataElement->RemoveAttribute("LockMemory");
+  }
+  if (this->LockProcessMemory)
+  {
+    deviceDataElement->SetAttribute("LockProcessMemory", "TRUE");
+  }
+  else
+  {
+    deviceDataElement->RemoveAttribute("LockProcessMemory");
+  }
+
   // Parameters writing
   XML_FIND_NESTED_ELEMENT_CREATE_IF_MISSING(parameterList, deviceDataElement, PARAMETERS_XML_ELEMENT_TAG.c_str());
 
@@ -1295,14 +1403,55 @@ PlusStatus vtkPlusDevice::StartRecording()
     return PLUS_FAIL;
   }
 
-  this->RecordingStartTime = vtkIGSIOAccurateTimer::GetSystemTime();
+  if (this->LockMemory)
+  {
+    // Prevents page faults when frames are added to the buffers, only the frame memory of the buffers is locked
+    std::vector<vtkPlusDataSource*> videoSources = this->GetVideoSources();
+    for (std::vector<vtkPlusDataSource*>::iterator sourceIt = videoSources.begin(); sourceIt != videoSources.end(); ++sourceIt)
+    {
+      if ((*sourceIt)->GetBuffer()->SetLockFrameMemory(true) != PLUS_SUCCESS)
+      {
+        LOCAL_LOG_WARNING("Failed to lock the frame memory of video source " << (*sourceIt)->GetSourceId());
+      }
+    }
+  }
+  if (this->LockProcessMemory)
+  {
+#if defined(_WIN32)
+    LOCAL_LOG_WARNING("LockProcessMemory is not supported on Windows");
+#else
+    // Requires CAP_IPC_LOCK or a sufficient RLIMIT_MEMLOCK
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+    {
+      LOCAL_LOG_WARNING("Failed to lock the memory of the process: " << strerror(errno));
+    }
+#endif
+  }
+
+  this->RecordingStartTime = PlusClock::GetSystemTime();
   this->Recording = 1;
 
   if (this->StartThreadForInternalUpdates)
   {
-    this->ThreadId =
-      this->Threader->SpawnThread((vtkThreadFunctionType)\
-                                  &vtkDataCaptureThread, this);
+    this->UpdateStartTimes.assign(FRAME_RATE_AVERAGING, 0.0);
+    this->UpdateCount = 0;
+    PlusAcquisitionScheduler* scheduler = (this->DataCollector != NULL ? this->DataCollector->GetAcquisitionScheduler() : NULL);
+    if (scheduler != NULL && scheduler->AddDevice(this) == PLUS_SUCCESS)
+    {
+      LOCAL_LOG_DEBUG("Internal updates are performed by the acquisition scheduler");
+      if (this->ThreadPriority != CAPTURE_THREAD_PRIORITY_NORMAL || !this->CpuAffinity.empty())
+      {
+        LOCAL_LOG_WARNING("ThreadPriority and CpuAffinity are ignored, the device is updated by the shared acquisition threads");
+      }
+      this->AcquisitionScheduler = scheduler;
+      this->ThreadAlive = true;
+    }
+    else
+    {
+      this->ThreadId =
+        this->Threader->SpawnThread((vtkThreadFunctionType)\
+                                    &vtkDataCaptureThread, this);
+    }
   }
 
   this->Modified();
@@ -1326,6 +1475,14 @@ PlusStatus vtkPlusDevice::StopRecording()
   this->ThreadId = -1;
   this->Recording = 0;
 
+  if (this->AcquisitionScheduler != NULL)
+  {
+    // Waits for the completion of the current update
+    this->AcquisitionScheduler->RemoveDevice(this);
+    this->AcquisitionScheduler = NULL;
+    this->ThreadAlive = false;
+  }
+
   if (this->GetStartThreadForInternalUpdates())
   {
     LOCAL_LOG_DEBUG("Wait for internal update thread to terminate");
@@ -1356,46 +1513,71 @@ void* vtkPlusDevice::vtkDataCaptureThread(vtkMultiThreader::ThreadInfo* data)
   vtkPlusDevice* self = (vtkPlusDevice*)(data->UserData);
 
   double rate = self->GetAcquisitionRate();
-  double currtime[FRAME_RATE_AVERAGING] = {0};
-  unsigned long updatecount = 0;
   self->ThreadAlive = true;
+  self->ApplyCaptureThreadSettings();
 
-  while (self->IsRecording() && self->GetCorrectlyConfigured())
+  while (true)
   {
-    double newtime = vtkIGSIOAccurateTimer::GetSystemTime();
-    // get current tracking rate over last few updates
-    double difftime = newtime - currtime[updatecount % FRAME_RATE_AVERAGING];
-    currtime[updatecount % FRAME_RATE_AVERAGING] = newtime;
-    if (updatecount > FRAME_RATE_AVERAGING && difftime != 0)
+    double newtime = PlusClock::GetSystemTime();
+    if (!self->ExecuteInternalUpdate(newtime))
     {
-      self->InternalUpdateRate = (FRAME_RATE_AVERAGING / difftime);
-    }
-
-    {
-      // Lock before update
-      igsioLockGuard<vtkIGSIORecursiveCriticalSection> updateMutexGuardedLock(self->UpdateMutex);
-      if (!self->Recording)
-      {
-        // recording has been stopped
-        break;
-      }
-      self->InternalUpdate();
-      self->UpdateTime.Modified();
+      break;
     }
 
-    double delay = (newtime + 1.0 / rate - vtkIGSIOAccurateTimer::GetSystemTime());
+    double delay = (newtime + 1.0 / rate - PlusClock::GetSystemTime());
     if (delay > 0)
     {
       vtkIGSIOAccurateTimer::Delay(delay);
     }
-
-    updatecount++;
   }
 
   self->ThreadAlive = false;
   return NULL;
 }
 
+//----------------------------------------------------------------------------
+bool vtkPlusDevice::ExecuteInternalUpdate(double updateStartTime)
+{
+  if (!this->IsRecording() || !this->GetCorrectlyConfigured())
+  {
+    return false;
+  }
+
+  // get current tracking rate over last few updates
+  if (this->UpdateStartTimes.size() != static_cast<size_t>(FRAME_RATE_AVERAGING))
+  {
+    this->UpdateStartTimes.assign(FRAME_RATE_AVERAGING, 0.0);
+  }
+  double& oldestUpdateStartTime = this->UpdateStartTimes[this->UpdateCount % FRAME_RATE_AVERAGING];
+  double difftime = updateStartTime - oldestUpdateStartTime;
+  oldestUpdateStartTime = updateStartTime;
+  if (this->UpdateCount > FRAME_RATE_AVERAGING && difftime != 0)
+  {
+    this->InternalUpdateRate = (FRAME_RATE_AVERAGING / difftime);
+  }
+
+  {
+    // Lock before update
+    igsioLockGuard<vtkIGSIORecursiveCriticalSection> updateMutexGuardedLock(this->UpdateMutex);
+    if (!this->Recording)
+    {
+      // recording has been stopped
+      return false;
+    }
+    this->InternalUpdate();
+    this->UpdateTime.Modified();
+  }
+
+  this->UpdateCount++;
+  return true;
+}
+
+//----------------------------------------------------------------------------
+int vtkPlusDevice::GetInternalUpdateFileDescriptor() const
+{
+  return -1;
+}
+
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusDevice::InternalConnect()
 {
@@ -2361,7 +2543,7 @@ void vtkPlusDevice::SetDataCollector(vtkPlusDataCollector* _arg)
 //------------------------------------------------------------------------------
 bool vtkPlusDevice::HasGracePeriodExpired()
 {
-  return (vtkIGSIOAccurateTimer::GetSystemTime() - this->RecordingStartTime) > this->MissingInputGracePeriodSec;
+  return (PlusClock::GetSystemTime() - this->RecordingStartTime) > this->MissingInputGracePeriodSec;
 }
 
 //----------------------------------------------------------------------------
@@ -2370,6 +2552,144 @@ double vtkPlusDevice::GetMissingInputGracePeriodSec() const
   return this->MissingInputGracePeriodSec;
 }
 
+//----------------------------------------------------------------------------
+void vtkPlusDevice::SetCpuAffinity(const std::vector<int>& cpuIndices)
+{
+  this->CpuAffinity = cpuIndices;
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+const std::vector<int>& vtkPlusDevice::GetCpuAffinity() const
+{
+  return this->CpuAffinity;
+}
+
+//----------------------------------------------------------------------------
+std::string vtkPlusDevice::GetCaptureThreadSettingsDescription() const
+{
+  std::ostringstream description;
+  description << "Thread priority: ";
+  switch (this->ThreadPriority)
+  {
+    case CAPTURE_THREAD_PRIORITY_HIGH:
+      description << "High";
+      break;
+    case CAPTURE_THREAD_PRIORITY_REALTIME:
+      description << "RealTime";
+      break;
+    default:
+      description << "Normal";
+  }
+  description << ", CPU affinity: ";
+  if (this->CpuAffinity.empty())
+  {
+    description << "any";
+  }
+  for (std::vector<int>::const_iterator cpuIt = this->CpuAffinity.begin(); cpuIt != this->CpuAffinity.end(); ++cpuIt)
+  {
+    description << (cpuIt == this->CpuAffinity.begin() ? "" : " ") << *cpuIt;
+  }
+  description << ", memory locked: " << (this->LockProcessMemory ? "process" : (this->LockMemory ? "frame buffers" : "no"));
+  if (this->AcquisitionScheduler != NULL)
+  {
+    description << ", updated by the shared acquisition threads";
+  }
+  return description.str();
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusDevice::ApplyCaptureThreadSettings()
+{
+  PlusStatus status = PLUS_SUCCESS;
+
+  bool useHighPriority = (this->ThreadPriority == CAPTURE_THREAD_PRIORITY_HIGH);
+  if (this->ThreadPriority == CAPTURE_THREAD_PRIORITY_REALTIME)
+  {
+#if defined(_WIN32)
+    // The Win32 function is hidden by the SetThreadPriority member function
+    if (!::SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL))
+    {
+      LOCAL_LOG_WARNING("Failed to set real-time priority of the data capture thread (error code: " << GetLastError() << ")");
+      status = PLUS_FAIL;
+    }
+#else
+    sched_param schedulingParameters;
+    memset(&schedulingParameters, 0, sizeof(schedulingParameters));
+    schedulingParameters.sched_priority = (sched_get_priority_min(SCHED_FIFO) + sched_get_priority_max(SCHED_FIFO)) / 2;
+    int result = pthread_setschedparam(pthread_self(), SCHED_FIFO, &schedulingParameters);
+    if (result != 0)
+    {
+      // the process needs CAP_SYS_NICE or a sufficient RLIMIT_RTPRIO
+      LOCAL_LOG_WARNING("Failed to set real-time scheduling of the data capture thread: " << strerror(result) << ". High priority is used instead.");
+      useHighPriority = true;
+      status = PLUS_FAIL;
+    }
+#endif
+  }
+
+  if (useHighPriority)
+  {
+#if defined(_WIN32)
+    if (!::SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_HIGHEST))
+    {
+      LOCAL_LOG_WARNING("Failed to set high priority of the data capture thread (error code: " << GetLastError() << ")");
+      status = PLUS_FAIL;
+    }
+#elif defined(__linux__)
+    // On Linux the nice value is a per-thread attribute
+    if (setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), CAPTURE_THREAD_HIGH_PRIORITY_NICE_VALUE) != 0)
+    {
+      LOCAL_LOG_WARNING("Failed to set high priority of the data capture thread: " << strerror(errno));
+      status = PLUS_FAIL;
+    }
+#else
+    LOCAL_LOG_WARNING("High priority of the data capture thread is not supported on this platform");
+    status = PLUS_FAIL;
+#endif
+  }
+
+  if (!this->CpuAffinity.empty())
+  {
+#if defined(_WIN32)
+    DWORD_PTR affinityMask = 0;
+    for (std::vector<int>::iterator cpuIt = this->CpuAffinity.begin(); cpuIt != this->CpuAffinity.end(); ++cpuIt)
+    {
+      if (*cpuIt >= 0 && *cpuIt < static_cast<int>(sizeof(DWORD_PTR) * 8))
+      {
+        affinityMask |= (static_cast<DWORD_PTR>(1) << *cpuIt);
+      }
+    }
+    if (SetThreadAffinityMask(GetCurrentThread(), affinityMask) == 0)
+    {
+      LOCAL_LOG_WARNING("Failed to set CPU affinity of the data capture thread (error code: " << GetLastError() << ")");
+      status = PLUS_FAIL;
+    }
+#elif defined(__linux__)
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    for (std::vector<int>::iterator cpuIt = this->CpuAffinity.begin(); cpuIt != this->CpuAffinity.end(); ++cpuIt)
+    {
+      if (*cpuIt >= 0 && *cpuIt < CPU_SETSIZE)
+      {
+        CPU_SET(*cpuIt, &cpuSet);
+      }
+    }
+    int result = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuSet);
+    if (result != 0)
+    {
+      LOCAL_LOG_WARNING("Failed to set CPU affinity of the data capture thread: " << strerror(result));
+      status = PLUS_FAIL;
+    }
+#else
+    LOCAL_LOG_WARNING("CPU affinity of the data capture thread is not supported on this platform");
+    status = PLUS_FAIL;
+#endif
+  }
+
+  return status;
+}
+
 //------------------------------------------------------------------------------
 PlusStatus vtkPlusDevice::CreateDefaultOutputChannel(const char* channelId /*=NULL*/, bool addSource/*=true*/)
 {
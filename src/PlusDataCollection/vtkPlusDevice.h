@@ -23,7 +23,9 @@ See License.txt for details.
 
 // STL includes
 #include <string>
+#include <vector>
 
+class PlusAcquisitionScheduler;
 class vtkPlusBuffer;
 class vtkPlusDataCollector;
 class vtkPlusDataSource;
@@ -69,6 +71,16 @@ public:
   static const std::string PARAMETERS_XML_ELEMENT_TAG;
   static const std::string PARAMETER_XML_ELEMENT_TAG;
 
+  /*! Scheduling priority of the data capture thread */
+  enum CaptureThreadPriorityType
+  {
+    CAPTURE_THREAD_PRIORITY_NORMAL,
+    /*! Increased priority within the normal scheduling class (nice value on Linux) */
+    CAPTURE_THREAD_PRIORITY_HIGH,
+    /*! Real-time scheduling (SCHED_FIFO on POSIX systems, time critical priority on Windows) */
+    CAPTURE_THREAD_PRIORITY_REALTIME
+  };
+
   /*!
   Probe to see to see if the device is connected to the
   computer.  This method should be overridden in subclasses.
@@ -266,6 +278,21 @@ public:
   */
   virtual PlusStatus InternalUpdate();
 
+  /*!
+  Perform one iteration of the data capture loop: measure the internal update rate and call InternalUpdate.
+  It is called from the data capture thread of the device or from the acquisition scheduler of the data collector.
+  \param updateStartTime System time when the iteration was started
+  \return False if the device is not recording anymore and no more updates should be performed
+  */
+  bool ExecuteInternalUpdate(double updateStartTime);
+
+  /*!
+  File descriptor that becomes readable when new data is available from the device, -1 if not available.
+  If the device is updated by the acquisition scheduler and it provides a file descriptor then InternalUpdate
+  is called when the file descriptor becomes readable instead of at the acquisition rate.
+  */
+  virtual int GetInternalUpdateFileDescriptor() const;
+
   /*!
   Build a list of all of the input devices directly connected to this device (if any)
   */
@@ -415,6 +442,33 @@ public:
   vtkSetMacro(MissingInputGracePeriodSec, double);
   double GetMissingInputGracePeriodSec() const;
 
+  /*! Scheduling priority of the data capture thread, applied when the thread is started */
+  vtkSetMacro(ThreadPriority, CaptureThreadPriorityType);
+  vtkGetMacro(ThreadPriority, CaptureThreadPriorityType);
+
+  /*! Indices of the CPUs that the data capture thread may run on, applied when the thread is started. Empty if not restricted. */
+  void SetCpuAffinity(const std::vector<int>& cpuIndices);
+  const std::vector<int>& GetCpuAffinity() const;
+
+  /*!
+    If enabled then the frame memory of the video buffers of the device is locked in physical memory when recording is started
+    (see vtkPlusBuffer::SetLockFrameMemory)
+  */
+  vtkSetMacro(LockMemory, bool);
+  vtkGetMacro(LockMemory, bool);
+  vtkBooleanMacro(LockMemory, bool);
+
+  /*!
+    If enabled then all current and future memory pages of the whole process are locked in physical memory when recording is started.
+    Affects all the devices and the memory use of the process, therefore it has to be enabled explicitly (not supported on Windows).
+  */
+  vtkSetMacro(LockProcessMemory, bool);
+  vtkGetMacro(LockProcessMemory, bool);
+  vtkBooleanMacro(LockProcessMemory, bool);
+
+  /*! Get a short description of the data capture thread settings, for acquisition reports */
+  std::string GetCaptureThreadSettingsDescription() const;
+
   /*!
     Creates a default output channel for the device with the name channelId or "OutputChannel".
     \param addSource If true then for imaging devices a default 'Video' source is added to the output.
@@ -513,6 +567,9 @@ protected:
   /*! Ensure uniqueness of given ID */
   PlusStatus EnsureUniqueDataSourceId(const std::string& aSourceId);
 
+  /*! Apply ThreadPriority and CpuAffinity to the calling thread. Called by the data capture thread when it is started. */
+  PlusStatus ApplyCaptureThreadSettings();
+
   vtkSetMacro(CorrectlyConfigured, bool);
 
   vtkSetMacro(StartThreadForInternalUpdates, bool);
@@ -541,6 +598,13 @@ protected:
   /*! Recording thread id */
   int ThreadId;
 
+  /*! Scheduler that performs the internal updates instead of the recording thread, NULL if the recording thread is used */
+  PlusAcquisitionScheduler* AcquisitionScheduler;
+
+  /*! Start times of the last few internal updates, for computing the internal update rate */
+  std::vector<double> UpdateStartTimes;
+  unsigned long UpdateCount;
+
   ChannelContainer  OutputChannels;
   ChannelContainer  InputChannels;
 
@@ -593,6 +657,15 @@ protected:
   /*! Adjust the device reporting behaviour depending on whether or not a grace period has expired */
   double RecordingStartTime;
 
+  /*! Scheduling priority of the data capture thread */
+  CaptureThreadPriorityType ThreadPriority;
+  /*! CPUs that the data capture thread may run on */
+  std::vector<int> CpuAffinity;
+  /*! Lock the frame memory of the video buffers when recording is started */
+  bool LockMemory;
+  /*! Lock all the memory of the process when recording is started */
+  bool LockProcessMemory;
+
   /*!
     The list contains the IDs of the tools that have been already reported to be unknown.
     This list is used to only report an unknown tool once (after the connection has been established), not at each
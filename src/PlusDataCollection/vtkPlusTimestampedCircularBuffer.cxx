@@ -12,8 +12,76 @@ See License.txt for details.
 #include "vtkTable.h"
 #include "vtkVariantArray.h"
 
+#include <algorithm>
+
 vtkStandardNewMacro(vtkPlusTimestampedCircularBuffer);
 
+// Maximum number of times a lock-free read is retried (when the accessed item is being overwritten) before falling back to a locked read
+static const int LOCK_FREE_READ_MAX_ATTEMPTS = 10;
+
+// Maximum number of interpolation steps in an item UID lookup by time. If the item is not found by then
+// (timestamps are far from being evenly spaced) then the search continues with bisection.
+static const int INTERPOLATION_SEARCH_MAX_STEPS = 3;
+
+namespace
+{
+  //----------------------------------------------------------------------------
+  // Find the UID of the item that is closest to the given time, between the items lo and hi (tlo and thi are their timestamps).
+  // Timestamps in the buffer are strictly increasing and they are acquired at an approximately constant frame rate,
+  // (filtered timestamps lie on the line that is fitted to the item index vs. time function),
+  // so the position of the item can be predicted by linear interpolation between lo and hi. The prediction is
+  // then corrected by checking the neighbors, which usually requires just one or two timestamp accesses.
+  // The same pair of neighboring items is found as with a bisection, so if the time is exactly halfway between
+  // two items then the older item is returned.
+  // getTimestamp(uid, timestamp) returns false if the timestamp of an item could not be retrieved, in this case the search fails.
+  template<class GetTimestampFunctionType>
+  bool FindClosestItemUid(const double time, BufferItemUidType lo, double tlo, BufferItemUidType hi, double thi, GetTimestampFunctionType getTimestamp, BufferItemUidType& uid)
+  {
+    int interpolationSteps = 0;
+    while (hi - lo > 1)
+    {
+      BufferItemUidType probe = lo + (hi - lo) / 2;
+      if (interpolationSteps < INTERPOLATION_SEARCH_MAX_STEPS && thi > tlo)
+      {
+        ++interpolationSteps;
+        double offset = (time - tlo) / (thi - tlo) * (hi - lo);
+        // Probe the predicted item, but always make progress
+        if (offset < 1.0)
+        {
+          probe = lo + 1;
+        }
+        else if (offset > hi - lo - 1)
+        {
+          probe = hi - 1;
+        }
+        else
+        {
+          probe = lo + static_cast<BufferItemUidType>(offset);
+        }
+      }
+
+      double tprobe = 0;
+      if (!getTimestamp(probe, tprobe))
+      {
+        return false;
+      }
+      if (time < tprobe)
+      {
+        hi = probe;
+        thi = tprobe;
+      }
+      else
+      {
+        lo = probe;
+        tlo = tprobe;
+      }
+    }
+
+    uid = (time - tlo > thi - time) ? hi : lo;
+    return true;
+  }
+}
+
 //----------------------------------------------------------------------------
 vtkPlusTimestampedCircularBuffer::vtkPlusTimestampedCircularBuffer()
   : Mutex(vtkIGSIORecursiveCriticalSection::New())
@@ -22,6 +90,20 @@ vtkPlusTimestampedCircularBuffer::vtkPlusTimestampedCircularBuffer()
   , CurrentTimeStamp(0.0)
   , LocalTimeOffsetSec(0.0)
   , LatestItemUid(0)
+  , CompactTransformStorage(false)
+  , LockFreeReads(false)
+  , LockFreeSlots(NULL)
+  , PublishedLatestItemUid(0)
+  , PublishedNumberOfItems(0)
+  , PublishedItemRangeSequence(0)
+  , IncrementalTimestampFiltering(true)
+  , FilterSumsReferenceIndex(0)
+  , FilterSumsReferenceTimestamp(0)
+  , FilterSumX(0)
+  , FilterSumY(0)
+  , FilterSumXX(0)
+  , FilterSumXY(0)
+  , FilterSumsNumberOfUpdates(-1)
   , AveragedItemsForFiltering(20)
   , MaxAllowedFilteringTimeDifference(0.5)
   , TimeStampReportTable(NULL)
@@ -55,6 +137,12 @@ vtkPlusTimestampedCircularBuffer::~vtkPlusTimestampedCircularBuffer()
     this->TimeStampReportTable = NULL;
   }
 
+  delete this->LockFreeSlots.exchange(NULL);
+  for (std::vector<LockFreeSlotTable*>::iterator it = this->RetiredLockFreeSlotTables.begin(); it != this->RetiredLockFreeSlotTables.end(); ++it)
+  {
+    delete *it;
+  }
+  this->RetiredLockFreeSlotTables.clear();
 }
 
 //----------------------------------------------------------------------------
@@ -67,6 +155,8 @@ void vtkPlusTimestampedCircularBuffer::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "CurrentTimeStamp: " << this->CurrentTimeStamp << "\n";
   os << indent << "Local time offset: " << this->LocalTimeOffsetSec << "\n";
   os << indent << "Latest Item Uid: " << this->LatestItemUid << "\n";
+  os << indent << "Lock-free reads: " << (this->LockFreeReads ? "enabled" : "disabled") << "\n";
+  os << indent << "Compact transform storage: " << (this->CompactTransformStorage ? "enabled" : "disabled") << "\n";
 }
 
 //----------------------------------------------------------------------------
@@ -96,9 +186,175 @@ PlusStatus vtkPlusTimestampedCircularBuffer::PrepareForNewItem(const double time
     this->WritePointer = 0;
   }
 
+  LockFreeSlotTable* lockFreeSlots = this->LockFreeSlots.load(std::memory_order_relaxed);
+  if (lockFreeSlots != NULL)
+  {
+    // Publish the slot first, so that a reader that sees the new latest UID finds the item in the slot table
+    this->PublishLockFreeSlot(lockFreeSlots, newFrameUid, timestamp);
+    this->PublishItemRange();
+  }
+
   return PLUS_SUCCESS;
 }
 
+//----------------------------------------------------------------------------
+void vtkPlusTimestampedCircularBuffer::SetLockFreeReads(bool enable)
+{
+  igsioLockGuard< vtkPlusTimestampedCircularBuffer > bufferGuardedLock(this);
+  if (this->LockFreeReads == enable)
+  {
+    return;
+  }
+  this->LockFreeReads = enable;
+  this->RebuildLockFreeSlotTable();
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusTimestampedCircularBuffer::SetCompactTransformStorage(bool enable)
+{
+  igsioLockGuard< vtkPlusTimestampedCircularBuffer > bufferGuardedLock(this);
+  if (this->CompactTransformStorage == enable)
+  {
+    return;
+  }
+
+  // Keep the buffer size, but items cannot be kept, as the two storages do not hold the same information
+  int bufferSize = this->GetBufferSize();
+  this->BufferItemContainer.clear();
+  this->TransformSamples.Clear();
+  this->CompactTransformStorage = enable;
+  if (enable)
+  {
+    this->TransformSamples.InsertSlots(0, bufferSize);
+  }
+  else
+  {
+    for (int i = 0; i < bufferSize; i++)
+    {
+      this->BufferItemContainer.push_back(std::make_shared<StreamBufferItem>());
+    }
+  }
+
+  this->WritePointer = 0;
+  this->NumberOfItems = 0;
+  this->CurrentTimeStamp = 0;
+  this->LatestItemUid = 0;
+  if (this->LockFreeReads)
+  {
+    // UIDs are restarted, therefore slots in the current table must not be used anymore
+    this->RebuildLockFreeSlotTable();
+  }
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+double vtkPlusTimestampedCircularBuffer::GetFilteredTimeStampFromBufferIndex(int bufferIndex)
+{
+  // the caller must have locked the buffer
+  if (this->CompactTransformStorage)
+  {
+    return this->TransformSamples.GetFilteredTimestamp(bufferIndex);
+  }
+  return this->BufferItemContainer[bufferIndex]->GetFilteredTimestamp(0);
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusTimestampedCircularBuffer::PublishLockFreeSlot(LockFreeSlotTable* table, BufferItemUidType uid, double filteredTimestamp)
+{
+  // the caller must have locked the buffer
+  LockFreeSlot& slot = table->Slots[uid % table->Size];
+  // Invalidate the slot while it is being modified
+  slot.Uid.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.FilteredTimestamp.store(filteredTimestamp, std::memory_order_relaxed);
+  slot.Uid.store(uid, std::memory_order_release);
+}
+
+//----------------------------------------------------------------------------
+bool vtkPlusTimestampedCircularBuffer::ReadLockFreeSlot(LockFreeSlotTable* table, BufferItemUidType uid, double& filteredTimestamp)
+{
+  if (uid == 0)
+  {
+    // UID 0 marks a slot that has not been written
+    return false;
+  }
+  const LockFreeSlot& slot = table->Slots[uid % table->Size];
+  if (slot.Uid.load(std::memory_order_acquire) != uid)
+  {
+    return false;
+  }
+  filteredTimestamp = slot.FilteredTimestamp.load(std::memory_order_relaxed);
+  // If the UID is still the same then the timestamp has not been modified while we were reading it
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return slot.Uid.load(std::memory_order_relaxed) == uid;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusTimestampedCircularBuffer::RebuildLockFreeSlotTable()
+{
+  // the caller must have locked the buffer
+  LockFreeSlotTable* newTable = NULL;
+  if (this->LockFreeReads)
+  {
+    newTable = new LockFreeSlotTable(this->GetBufferSize());
+    if (this->NumberOfItems > 0)
+    {
+      for (BufferItemUidType uid = this->LatestItemUid - (this->NumberOfItems - 1); uid <= this->LatestItemUid; ++uid)
+      {
+        int bufferIndex(-1);
+        if (this->GetBufferIndexFromUid(uid, bufferIndex) == ITEM_OK)
+        {
+          this->PublishLockFreeSlot(newTable, uid, this->GetFilteredTimeStampFromBufferIndex(bufferIndex));
+        }
+      }
+    }
+  }
+
+  // The new table must be visible before the new latest UID, as readers get the latest UID first and then the table
+  LockFreeSlotTable* oldTable = this->LockFreeSlots.exchange(newTable, std::memory_order_acq_rel);
+  if (oldTable != NULL)
+  {
+    // Readers may still use the old table, it is only deleted when the buffer is deleted
+    this->RetiredLockFreeSlotTables.push_back(oldTable);
+  }
+  this->PublishItemRange();
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusTimestampedCircularBuffer::PublishItemRange()
+{
+  // the caller must have locked the buffer, so there is only one writer
+  unsigned int sequence = this->PublishedItemRangeSequence.load(std::memory_order_relaxed);
+  this->PublishedItemRangeSequence.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  this->PublishedNumberOfItems.store(this->NumberOfItems, std::memory_order_relaxed);
+  this->PublishedLatestItemUid.store(this->LatestItemUid, std::memory_order_relaxed);
+  this->PublishedItemRangeSequence.store(sequence + 2, std::memory_order_release);
+}
+
+//----------------------------------------------------------------------------
+bool vtkPlusTimestampedCircularBuffer::ReadPublishedItemRange(BufferItemUidType& latestUid, int& numberOfItems)
+{
+  for (int attempt = 0; attempt < LOCK_FREE_READ_MAX_ATTEMPTS; ++attempt)
+  {
+    unsigned int sequence = this->PublishedItemRangeSequence.load(std::memory_order_acquire);
+    if (sequence & 1)
+    {
+      // the writer is updating the values
+      continue;
+    }
+    latestUid = this->PublishedLatestItemUid.load(std::memory_order_relaxed);
+    numberOfItems = this->PublishedNumberOfItems.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (this->PublishedItemRangeSequence.load(std::memory_order_relaxed) == sequence)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
 //----------------------------------------------------------------------------
 // Sets the buffer size, and copies the maximum number of the most current old
 // frames and timestamps
@@ -117,12 +373,39 @@ PlusStatus vtkPlusTimestampedCircularBuffer::SetBufferSize(int newBufferSize)
     return PLUS_SUCCESS;
   }
 
-  if (this->GetBufferSize() == 0)
+  if (this->CompactTransformStorage)
+  {
+    if (this->GetBufferSize() == 0)
+    {
+      this->TransformSamples.InsertSlots(0, newBufferSize);
+      this->WritePointer = 0;
+      this->NumberOfItems = 0;
+      this->CurrentTimeStamp = 0.0;
+    }
+    else if (this->GetBufferSize() < newBufferSize)
+    {
+      // new slots are inserted before the oldest item, as in the item container below
+      this->TransformSamples.InsertSlots(this->WritePointer, newBufferSize - this->GetBufferSize());
+    }
+    else
+    {
+      // delete the oldest slots
+      int oldBufferSize = this->GetBufferSize();
+      for (int i = 0; i < oldBufferSize - newBufferSize; ++i)
+      {
+        this->TransformSamples.EraseSlot(this->WritePointer);
+        if (this->WritePointer >= this->GetBufferSize())
+        {
+          this->WritePointer = 0;
+        }
+      }
+    }
+  }
+  else if (this->GetBufferSize() == 0)
   {
     for (int i = 0; i < newBufferSize; i++)
     {
-      StreamBufferItem emptyBufferItem;
-      this->BufferItemContainer.push_back(emptyBufferItem);
+      this->BufferItemContainer.push_back(std::make_shared<StreamBufferItem>());
     }
     this->WritePointer = 0;
     this->NumberOfItems = 0;
@@ -131,12 +414,11 @@ PlusStatus vtkPlusTimestampedCircularBuffer::SetBufferSize(int newBufferSize)
   // if the new buffer is bigger than the old buffer
   else if (this->GetBufferSize() < newBufferSize)
   {
-    std::deque<StreamBufferItem>::iterator it = this->BufferItemContainer.begin() + this->WritePointer;
+    std::deque<StreamBufferItemPtr>::iterator it = this->BufferItemContainer.begin() + this->WritePointer;
     const int numberOfNewBufferObjects = newBufferSize - this->GetBufferSize();
     for (int i = 0; i < numberOfNewBufferObjects; ++i)
     {
-      StreamBufferItem emptyBufferItem;
-      it = this->BufferItemContainer.insert(it, emptyBufferItem);
+      it = this->BufferItemContainer.insert(it, std::make_shared<StreamBufferItem>());
     }
   }
   // if the new buffer is smaller than the old buffer
@@ -146,7 +428,7 @@ PlusStatus vtkPlusTimestampedCircularBuffer::SetBufferSize(int newBufferSize)
     int oldBufferSize = this->GetBufferSize();
     for (int i = 0; i < oldBufferSize - newBufferSize; ++i)
     {
-      std::deque<StreamBufferItem>::iterator it = this->BufferItemContainer.begin() + this->WritePointer;
+      std::deque<StreamBufferItemPtr>::iterator it = this->BufferItemContainer.begin() + this->WritePointer;
       this->BufferItemContainer.erase(it);
       if (this->WritePointer >= this->GetBufferSize())
       {
@@ -161,37 +443,135 @@ PlusStatus vtkPlusTimestampedCircularBuffer::SetBufferSize(int newBufferSize)
     this->NumberOfItems = this->GetBufferSize();
   }
 
+  if (this->LockFreeReads)
+  {
+    // slot table size must match the buffer size
+    this->RebuildLockFreeSlotTable();
+  }
+
   this->Modified();
 
   return PLUS_SUCCESS;
 }
 
 //----------------------------------------------------------------------------
-ItemStatus vtkPlusTimestampedCircularBuffer::GetBufferItemPointerFromUid(const BufferItemUidType uid, StreamBufferItem*& itemPtr)
+ItemStatus vtkPlusTimestampedCircularBuffer::GetBufferIndexFromUid(const BufferItemUidType uid, int& bufferIndex)
 {
   // the caller must have locked the buffer
   BufferItemUidType oldestUid = this->LatestItemUid - (this->NumberOfItems - 1);
   if (uid < oldestUid)
   {
     LOG_WARNING("Buffer item is not in the buffer (Uid: " << uid << ")!");
-    itemPtr = NULL;
+    bufferIndex = -1;
     return ITEM_NOT_AVAILABLE_ANYMORE;
   }
   else if (uid > this->LatestItemUid)
   {
     LOG_WARNING("Buffer item is not in the buffer (Uid: " << uid << ")!");
-    itemPtr = NULL;
+    bufferIndex = -1;
     return ITEM_NOT_AVAILABLE_YET;
   }
+  bufferIndex = (this->WritePointer - 1) - (this->LatestItemUid - uid);
+  if (bufferIndex < 0)
+  {
+    bufferIndex += this->GetBufferSize();
+  }
+  return ITEM_OK;
+}
+
+//----------------------------------------------------------------------------
+ItemStatus vtkPlusTimestampedCircularBuffer::GetBufferItemPointerFromUid(const BufferItemUidType uid, StreamBufferItem*& itemPtr)
+{
+  // the caller must have locked the buffer
+  itemPtr = NULL;
+  if (this->CompactTransformStorage)
+  {
+    LOG_ERROR("Failed to get buffer item - items are not stored as objects in compact transform storage (Uid: " << uid << ").");
+    return ITEM_UNKNOWN_ERROR;
+  }
+  int bufferIndex(-1);
+  ItemStatus status = this->GetBufferIndexFromUid(uid, bufferIndex);
+  if (status != ITEM_OK)
+  {
+    return status;
+  }
+  itemPtr = this->BufferItemContainer[bufferIndex].get();
+  return ITEM_OK;
+}
+
+//----------------------------------------------------------------------------
+ItemStatus vtkPlusTimestampedCircularBuffer::GetWritableBufferItemPointerFromUid(const BufferItemUidType uid, StreamBufferItem*& itemPtr)
+{
+  // the caller must have locked the buffer
+  ItemStatus status = this->GetBufferItemPointerFromUid(uid, itemPtr);
+  if (status != ITEM_OK)
+  {
+    return status;
+  }
   int bufferIndex = (this->WritePointer - 1) - (this->LatestItemUid - uid);
   if (bufferIndex < 0)
   {
     bufferIndex += this->BufferItemContainer.size();
   }
-  itemPtr = &this->BufferItemContainer[bufferIndex];
+  if (this->BufferItemContainer[bufferIndex].use_count() > 1)
+  {
+    // The item is referenced by a view, modify a copy instead
+    this->BufferItemContainer[bufferIndex] = std::make_shared<StreamBufferItem>(*this->BufferItemContainer[bufferIndex]);
+    itemPtr = this->BufferItemContainer[bufferIndex].get();
+  }
   return ITEM_OK;
 }
 
+//----------------------------------------------------------------------------
+ItemStatus vtkPlusTimestampedCircularBuffer::GetBufferItemViewFromUid(const BufferItemUidType uid, StreamBufferItemView& itemView)
+{
+  igsioLockGuard< vtkPlusTimestampedCircularBuffer > bufferGuardedLock(this);
+  StreamBufferItem* itemPtr = NULL;
+  ItemStatus status = GetBufferItemPointerFromUid(uid, itemPtr);
+  if (status != ITEM_OK)
+  {
+    itemView.reset();
+    return status;
+  }
+  int bufferIndex = (this->WritePointer - 1) - (this->LatestItemUid - uid);
+  if (bufferIndex < 0)
+  {
+    bufferIndex += this->BufferItemContainer.size();
+  }
+  itemView = this->BufferItemContainer[bufferIndex];
+  return ITEM_OK;
+}
+
+//----------------------------------------------------------------------------
+StreamBufferItem* vtkPlusTimestampedCircularBuffer::GetWritableBufferItemPointerFromBufferIndex(const int bufferIndex, bool& itemReplaced, StreamBufferItemView* replacedItem /*= NULL*/, bool keepContent /*= false*/)
+{
+  // the caller must have locked the buffer
+  itemReplaced = false;
+  if (this->GetBufferItemPointerFromBufferIndex(bufferIndex) == NULL)
+  {
+    return NULL;
+  }
+  if (this->BufferItemContainer[bufferIndex].use_count() > 1)
+  {
+    // The item is referenced by a view, it must not be modified, so put a new item in its place
+    if (replacedItem != NULL)
+    {
+      *replacedItem = this->BufferItemContainer[bufferIndex];
+    }
+    if (keepContent)
+    {
+      // Keep index, UID, timestamps, status, transform and fields, so the item can still be found by time and UID
+      this->BufferItemContainer[bufferIndex] = std::make_shared<StreamBufferItem>(*this->BufferItemContainer[bufferIndex]);
+    }
+    else
+    {
+      this->BufferItemContainer[bufferIndex] = std::make_shared<StreamBufferItem>();
+    }
+    itemReplaced = true;
+  }
+  return this->BufferItemContainer[bufferIndex].get();
+}
+
 //----------------------------------------------------------------------------
 StreamBufferItem* vtkPlusTimestampedCircularBuffer::GetBufferItemPointerFromBufferIndex(const int bufferIndex)
 {
@@ -203,21 +583,102 @@ StreamBufferItem* vtkPlusTimestampedCircularBuffer::GetBufferItemPointerFromBuff
     LOG_ERROR("Failed to get buffer item with buffer index - index is out of range (bufferIndex: " << bufferIndex << ").");
     return NULL;
   }
-  return &this->BufferItemContainer[bufferIndex];
+  if (this->CompactTransformStorage)
+  {
+    LOG_ERROR("Failed to get buffer item with buffer index - items are not stored as objects in compact transform storage (bufferIndex: " << bufferIndex << ").");
+    return NULL;
+  }
+  return this->BufferItemContainer[bufferIndex].get();
 }
 
 //----------------------------------------------------------------------------
 ItemStatus vtkPlusTimestampedCircularBuffer::GetFilteredTimeStamp(const BufferItemUidType uid, double& filteredTimestamp)
 {
+  ItemStatus lockFreeStatus = ITEM_UNKNOWN_ERROR;
+  if (this->LockFreeSlots.load(std::memory_order_acquire) != NULL && this->GetFilteredTimeStampLockFree(uid, filteredTimestamp, lockFreeStatus))
+  {
+    if (lockFreeStatus != ITEM_OK)
+    {
+      LOG_WARNING("Buffer item is not in the buffer (Uid: " << uid << ")!");
+    }
+    return lockFreeStatus;
+  }
+
   igsioLockGuard< vtkPlusTimestampedCircularBuffer > bufferGuardedLock(this);
-  StreamBufferItem* itemPtr = NULL;
-  ItemStatus status = GetBufferItemPointerFromUid(uid, itemPtr);
+  int bufferIndex(-1);
+  ItemStatus status = this->GetBufferIndexFromUid(uid, bufferIndex);
   if (status != ITEM_OK)
   {
     filteredTimestamp = 0;
     return status;
   }
-  filteredTimestamp = itemPtr->GetFilteredTimestamp(this->LocalTimeOffsetSec);
+  filteredTimestamp = this->GetFilteredTimeStampFromBufferIndex(bufferIndex) + this->LocalTimeOffsetSec;
+  return status;
+}
+
+//----------------------------------------------------------------------------
+bool vtkPlusTimestampedCircularBuffer::GetFilteredTimeStampLockFree(const BufferItemUidType uid, double& filteredTimestamp, ItemStatus& status)
+{
+  filteredTimestamp = 0;
+  for (int attempt = 0; attempt < LOCK_FREE_READ_MAX_ATTEMPTS; ++attempt)
+  {
+    // Latest UID must be read before the table (see RebuildLockFreeSlotTable)
+    BufferItemUidType latestUid(0);
+    int numberOfItems(0);
+    if (!this->ReadPublishedItemRange(latestUid, numberOfItems))
+    {
+      return false;
+    }
+    LockFreeSlotTable* table = this->LockFreeSlots.load(std::memory_order_acquire);
+    if (table == NULL)
+    {
+      return false;
+    }
+    BufferItemUidType oldestUid = latestUid - (numberOfItems - 1);
+    if (uid < oldestUid)
+    {
+      status = ITEM_NOT_AVAILABLE_ANYMORE;
+      return true;
+    }
+    else if (uid > latestUid)
+    {
+      status = ITEM_NOT_AVAILABLE_YET;
+      return true;
+    }
+    double timestamp = 0;
+    if (this->ReadLockFreeSlot(table, uid, timestamp))
+    {
+      filteredTimestamp = timestamp + this->LocalTimeOffsetSec;
+      status = ITEM_OK;
+      return true;
+    }
+    // the item is being overwritten or the table has been replaced, check again
+  }
+  return false;
+}
+
+//----------------------------------------------------------------------------
+ItemStatus vtkPlusTimestampedCircularBuffer::GetOldestTimeStampLockFree(double& timestamp)
+{
+  for (int attempt = 0; attempt < LOCK_FREE_READ_MAX_ATTEMPTS; ++attempt)
+  {
+    ItemStatus status = ITEM_UNKNOWN_ERROR;
+    if (!this->GetFilteredTimeStampLockFree(this->GetOldestItemUidInBuffer(), timestamp, status))
+    {
+      break;
+    }
+    if (status != ITEM_NOT_AVAILABLE_ANYMORE)
+    {
+      return status;
+    }
+    // the oldest item has just been overwritten, try with the new oldest item
+  }
+
+  igsioLockGuard< vtkPlusTimestampedCircularBuffer > bufferGuardedLock(this);
+  BufferItemUidType oldestUid = (this->LatestItemUid - (this->NumberOfItems - 1));
+  int bufferIndex(-1);
+  ItemStatus status = this->GetBufferIndexFromUid(oldestUid, bufferIndex);
+  timestamp = (status == ITEM_OK) ? this->GetFilteredTimeStampFromBufferIndex(bufferIndex) + this->LocalTimeOffsetSec : 0;
   return status;
 }
 
@@ -225,14 +686,21 @@ ItemStatus vtkPlusTimestampedCircularBuffer::GetFilteredTimeStamp(const BufferIt
 ItemStatus vtkPlusTimestampedCircularBuffer::GetUnfilteredTimeStamp(const BufferItemUidType uid, double& unfilteredTimestamp)
 {
   igsioLockGuard< vtkPlusTimestampedCircularBuffer > bufferGuardedLock(this);
-  StreamBufferItem* itemPtr = NULL;
-  ItemStatus status = GetBufferItemPointerFromUid(uid, itemPtr);
+  int bufferIndex(-1);
+  ItemStatus status = this->GetBufferIndexFromUid(uid, bufferIndex);
   if (status != ITEM_OK)
   {
     unfilteredTimestamp = 0;
     return status;
   }
-  unfilteredTimestamp = itemPtr->GetUnfilteredTimestamp(this->LocalTimeOffsetSec);
+  if (this->CompactTransformStorage)
+  {
+    unfilteredTimestamp = this->TransformSamples.GetUnfilteredTimestamp(bufferIndex) + this->LocalTimeOffsetSec;
+  }
+  else
+  {
+    unfilteredTimestamp = this->BufferItemContainer[bufferIndex]->GetUnfilteredTimestamp(this->LocalTimeOffsetSec);
+  }
   return status;
 }
 
@@ -244,8 +712,12 @@ bool vtkPlusTimestampedCircularBuffer::GetLatestItemHasValidVideoData()
   {
     return false;
   }
+  if (this->CompactTransformStorage)
+  {
+    return false;
+  }
   int latestItemBufferIndex = (this->WritePointer > 0) ? (this->WritePointer - 1) : (this->BufferItemContainer.size() - 1);
-  return this->BufferItemContainer[latestItemBufferIndex].HasValidVideoData();
+  return this->BufferItemContainer[latestItemBufferIndex]->HasValidVideoData();
 }
 
 //----------------------------------------------------------------------------
@@ -256,8 +728,12 @@ bool vtkPlusTimestampedCircularBuffer::GetLatestItemHasValidTransformData()
   {
     return false;
   }
-  int latestItemBufferIndex = (this->WritePointer > 0) ? (this->WritePointer - 1) : (this->BufferItemContainer.size() - 1);
-  return this->BufferItemContainer[latestItemBufferIndex].HasValidTransformData();
+  int latestItemBufferIndex = (this->WritePointer > 0) ? (this->WritePointer - 1) : (this->GetBufferSize() - 1);
+  if (this->CompactTransformStorage)
+  {
+    return this->TransformSamples.HasValidTransformData(latestItemBufferIndex);
+  }
+  return this->BufferItemContainer[latestItemBufferIndex]->HasValidTransformData();
 }
 
 //----------------------------------------------------------------------------
@@ -268,22 +744,26 @@ bool vtkPlusTimestampedCircularBuffer::GetLatestItemHasValidFieldData()
   {
     return false;
   }
-  int latestItemBufferIndex = (this->WritePointer > 0) ? (this->WritePointer - 1) : (this->BufferItemContainer.size() - 1);
-  return this->BufferItemContainer[latestItemBufferIndex].HasValidFieldData();
+  int latestItemBufferIndex = (this->WritePointer > 0) ? (this->WritePointer - 1) : (this->GetBufferSize() - 1);
+  if (this->CompactTransformStorage)
+  {
+    return this->TransformSamples.HasValidFieldData(latestItemBufferIndex);
+  }
+  return this->BufferItemContainer[latestItemBufferIndex]->HasValidFieldData();
 }
 
 //----------------------------------------------------------------------------
 ItemStatus vtkPlusTimestampedCircularBuffer::GetIndex(const BufferItemUidType uid, unsigned long& index)
 {
   igsioLockGuard< vtkPlusTimestampedCircularBuffer > bufferGuardedLock(this);
-  StreamBufferItem* itemPtr = NULL;
-  ItemStatus status = GetBufferItemPointerFromUid(uid, itemPtr);
+  int bufferIndex(-1);
+  ItemStatus status = this->GetBufferIndexFromUid(uid, bufferIndex);
   if (status != ITEM_OK)
   {
     index = 0;
     return status;
   }
-  index = itemPtr->GetIndex();
+  index = this->CompactTransformStorage ? this->TransformSamples.GetIndex(bufferIndex) : this->BufferItemContainer[bufferIndex]->GetIndex();
   return status;
 }
 
@@ -304,16 +784,22 @@ ItemStatus vtkPlusTimestampedCircularBuffer::GetBufferIndexFromTime(const double
   bufferIndex = (this->WritePointer - 1) - (this->LatestItemUid - itemUid);
   if (bufferIndex < 0)
   {
-    bufferIndex += this->BufferItemContainer.size();
+    bufferIndex += this->GetBufferSize();
   }
   return ITEM_OK;
 }
 
 //----------------------------------------------------------------------------
-// do a simple divide-and-conquer search for the transform
+// do an interpolation search for the transform
 // that best matches the given timestamp
 ItemStatus vtkPlusTimestampedCircularBuffer::GetItemUidFromTime(const double time, BufferItemUidType& uid)
 {
+  ItemStatus lockFreeStatus = ITEM_UNKNOWN_ERROR;
+  if (this->LockFreeSlots.load(std::memory_order_acquire) != NULL && this->GetItemUidFromTimeLockFree(time, uid, lockFreeStatus))
+  {
+    return lockFreeStatus;
+  }
+
   igsioLockGuard< vtkPlusTimestampedCircularBuffer > bufferGuardedLock(this);
 
   if (this->NumberOfItems == 1)
@@ -331,17 +817,17 @@ ItemStatus vtkPlusTimestampedCircularBuffer::GetItemUidFromTime(const double tim
   int loBufferIndex = (this->WritePointer - 1) - (this->LatestItemUid - lo);
   if (loBufferIndex < 0)
   {
-    loBufferIndex += this->BufferItemContainer.size();
+    loBufferIndex += this->GetBufferSize();
   }
-  double tlo = this->BufferItemContainer[loBufferIndex].GetFilteredTimestamp(this->LocalTimeOffsetSec);
+  double tlo = this->GetFilteredTimeStampFromBufferIndex(loBufferIndex) + this->LocalTimeOffsetSec;
 
   // This method is called often, therefore instead of calling this->GetTimeStamp(hi, thi) we perform low-level operations to get the timestamp
   int hiBufferIndex = (this->WritePointer - 1) - (this->LatestItemUid - hi);
   if (hiBufferIndex < 0)
   {
-    hiBufferIndex += this->BufferItemContainer.size();
+    hiBufferIndex += this->GetBufferSize();
   }
-  double thi = this->BufferItemContainer[hiBufferIndex].GetFilteredTimestamp(this->LocalTimeOffsetSec);
+  double thi = this->GetFilteredTimeStampFromBufferIndex(hiBufferIndex) + this->LocalTimeOffsetSec;
 
   // If the timestamp is slightly out of range then still accept it
   // (due to errors in conversions there could be slight differences)
@@ -354,44 +840,177 @@ ItemStatus vtkPlusTimestampedCircularBuffer::GetItemUidFromTime(const double tim
     return ITEM_NOT_AVAILABLE_YET;
   }
 
-  for (;;)
+  // This is a hot loop, therefore instead of calling this->GetTimeStamp(uid, timestamp) we perform low-level operations to get the timestamp
+  auto getTimestamp = [this](BufferItemUidType itemUid, double& timestamp) -> bool
   {
-    if (hi - lo <= 1)
+    int bufferIndex = (this->WritePointer - 1) - (this->LatestItemUid - itemUid);
+    if (bufferIndex < 0)
     {
-      if (time - tlo > thi - time)
-      {
-        uid = hi;
-        return ITEM_OK;
-      }
-      else
+      bufferIndex += this->GetBufferSize();
+    }
+    timestamp = this->GetFilteredTimeStampFromBufferIndex(bufferIndex) + this->LocalTimeOffsetSec;
+    return true;
+  };
+  FindClosestItemUid(time, lo, tlo, hi, thi, getTimestamp, uid);
+  return ITEM_OK;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusTimestampedCircularBuffer::GetItemUidsFromTimes(const double* times, int numberOfTimes, BufferItemUidType* uids, ItemStatus* statuses)
+{
+  igsioLockGuard< vtkPlusTimestampedCircularBuffer > bufferGuardedLock(this);
+
+  if (this->NumberOfItems < 1)
+  {
+    std::fill(statuses, statuses + numberOfTimes, ITEM_NOT_AVAILABLE_YET);
+    return;
+  }
+
+  auto getTimestamp = [this](BufferItemUidType itemUid, double& timestamp) -> bool
+  {
+    int bufferIndex = (this->WritePointer - 1) - (this->LatestItemUid - itemUid);
+    if (bufferIndex < 0)
+    {
+      bufferIndex += this->GetBufferSize();
+    }
+    timestamp = this->GetFilteredTimeStampFromBufferIndex(bufferIndex) + this->LocalTimeOffsetSec;
+    return true;
+  };
+
+  BufferItemUidType lo = this->LatestItemUid - (this->NumberOfItems - 1);   // oldest item UID
+  BufferItemUidType hi = this->LatestItemUid; // latest item UID
+  double tlo = 0;
+  double thi = 0;
+  getTimestamp(lo, tlo);
+  getTimestamp(hi, thi);
+
+  // The cursor is the latest item that is not after the previous requested time (or the oldest item),
+  // 0 if no item has been found yet
+  BufferItemUidType cursor = 0;
+  double tcursor = 0;
+  for (int i = 0; i < numberOfTimes; ++i)
+  {
+    const double time = times[i];
+
+    // If the timestamp is slightly out of range then still accept it (same as in GetItemUidFromTime)
+    if (time < tlo - this->NegligibleTimeDifferenceSec)
+    {
+      statuses[i] = ITEM_NOT_AVAILABLE_ANYMORE;
+      continue;
+    }
+    else if (time > thi + this->NegligibleTimeDifferenceSec)
+    {
+      statuses[i] = ITEM_NOT_AVAILABLE_YET;
+      continue;
+    }
+    statuses[i] = ITEM_OK;
+    if (lo == hi)
+    {
+      // There is only one item, it's the closest one to any timestamp
+      uids[i] = hi;
+      continue;
+    }
+
+    if (cursor == 0 || time < tcursor)
+    {
+      // First lookup or the time is before the previous one, search the whole buffer
+      FindClosestItemUid(time, lo, tlo, hi, thi, getTimestamp, cursor);
+      getTimestamp(cursor, tcursor);
+      if (tcursor > time && cursor > lo)
       {
-        uid = lo;
-        return ITEM_OK;
+        --cursor;
+        getTimestamp(cursor, tcursor);
       }
     }
 
-    int mid = (lo + hi) / 2;
+    // Walk forward to the latest item that is not after the requested time
+    double tnext = 0;
+    while (cursor < hi && getTimestamp(cursor + 1, tnext) && tnext <= time)
+    {
+      ++cursor;
+      tcursor = tnext;
+    }
+
+    // Same choice between the two neighbors as in FindClosestItemUid
+    uids[i] = (cursor < hi && time - tcursor > tnext - time) ? cursor + 1 : cursor;
+  }
+}
 
-    // This is a hot loop, therefore instead of calling this->GetTimeStamp(mid, tmid) we perform low-level operations to get the timestamp
-    int midBufferIndex = (this->WritePointer - 1) - (this->LatestItemUid - mid);
-    if (midBufferIndex < 0)
+//----------------------------------------------------------------------------
+// Same search as in GetItemUidFromTime, but timestamps are read from the lock-free slot table.
+// If any of the accessed items is overwritten during the search then the search is restarted.
+bool vtkPlusTimestampedCircularBuffer::GetItemUidFromTimeLockFree(const double time, BufferItemUidType& uid, ItemStatus& status)
+{
+  for (int attempt = 0; attempt < LOCK_FREE_READ_MAX_ATTEMPTS; ++attempt)
+  {
+    // Latest UID must be read before the table (see RebuildLockFreeSlotTable)
+    BufferItemUidType latestUid(0);
+    int numberOfItems(0);
+    if (!this->ReadPublishedItemRange(latestUid, numberOfItems))
+    {
+      return false;
+    }
+    LockFreeSlotTable* table = this->LockFreeSlots.load(std::memory_order_acquire);
+    if (table == NULL)
+    {
+      return false;
+    }
+    if (numberOfItems < 1)
     {
-      midBufferIndex += this->BufferItemContainer.size();
+      status = ITEM_NOT_AVAILABLE_YET;
+      return true;
+    }
+    if (numberOfItems == 1)
+    {
+      // There is only one item, it's the closest one to any timestamp
+      uid = latestUid;
+      status = ITEM_OK;
+      return true;
     }
-    double tmid = this->BufferItemContainer[midBufferIndex].GetFilteredTimestamp(this->LocalTimeOffsetSec);
 
-    if (time < tmid)
+    BufferItemUidType lo = latestUid - (numberOfItems - 1);   // oldest item UID
+    BufferItemUidType hi = latestUid; // latest item UID
+    double tlo = 0;
+    double thi = 0;
+    if (!this->ReadLockFreeSlot(table, lo, tlo) || !this->ReadLockFreeSlot(table, hi, thi))
     {
-      hi = mid;
-      thi = tmid;
+      continue;
     }
-    else
+    tlo += this->LocalTimeOffsetSec;
+    thi += this->LocalTimeOffsetSec;
+
+    // If the timestamp is slightly out of range then still accept it
+    // (due to errors in conversions there could be slight differences)
+    if (time < tlo - this->NegligibleTimeDifferenceSec)
     {
-      lo = mid;
-      tlo = tmid;
+      status = ITEM_NOT_AVAILABLE_ANYMORE;
+      return true;
+    }
+    else if (time > thi + this->NegligibleTimeDifferenceSec)
+    {
+      status = ITEM_NOT_AVAILABLE_YET;
+      return true;
+    }
+
+    auto getTimestamp = [this, table](BufferItemUidType itemUid, double& timestamp) -> bool
+    {
+      if (!this->ReadLockFreeSlot(table, itemUid, timestamp))
+      {
+        return false;
+      }
+      timestamp += this->LocalTimeOffsetSec;
+      return true;
+    };
+    if (!FindClosestItemUid(time, lo, tlo, hi, thi, getTimestamp, uid))
+    {
+      // an item was overwritten during the search
+      continue;
     }
-  }
 
+    status = ITEM_OK;
+    return true;
+  }
+  return false;
 }
 
 //----------------------------------------------------------------------------
@@ -410,8 +1029,21 @@ void vtkPlusTimestampedCircularBuffer::DeepCopy(vtkPlusTimestampedCircularBuffer
   this->FilterContainersOldestIndex = buffer->FilterContainersOldestIndex;
   this->FilterContainerTimestampVector = buffer->FilterContainerTimestampVector;
   this->FilterContainerIndexVector = buffer->FilterContainerIndexVector;
+  this->IncrementalTimestampFiltering = buffer->IncrementalTimestampFiltering;
+  this->FilterSumsNumberOfUpdates = -1;
 
-  this->BufferItemContainer = buffer->BufferItemContainer;
+  // Items are copied (not shared), as the two buffers write into their items independently
+  this->CompactTransformStorage = buffer->CompactTransformStorage;
+  this->TransformSamples = buffer->TransformSamples;
+  this->BufferItemContainer.clear();
+  for (std::deque<StreamBufferItemPtr>::iterator it = buffer->BufferItemContainer.begin(); it != buffer->BufferItemContainer.end(); ++it)
+  {
+    this->BufferItemContainer.push_back(std::make_shared<StreamBufferItem>(**it));
+  }
+  if (this->LockFreeReads)
+  {
+    this->RebuildLockFreeSlotTable();
+  }
   this->Unlock();
   buffer->Unlock();
 }
@@ -424,6 +1056,11 @@ void vtkPlusTimestampedCircularBuffer::Clear()
   this->NumberOfItems = 0;
   this->CurrentTimeStamp = 0;
   this->LatestItemUid = 0;
+  if (this->LockFreeReads)
+  {
+    // UIDs are restarted, therefore slots in the current table must not be used anymore
+    this->RebuildLockFreeSlotTable();
+  }
   this->Unlock();
 }
 
@@ -539,11 +1176,17 @@ PlusStatus vtkPlusTimestampedCircularBuffer::CreateFilteredTimeStampForItem(unsi
     this->FilterContainerTimestampVector.set_size(this->AveragedItemsForFiltering);
     this->FilterContainersOldestIndex = 0;
     this->FilterContainersNumberOfValidElements = 0;
+    this->FilterSumsNumberOfUpdates = -1;
   }
 
   // We store the last AveragedItemsForFiltering unfiltered timestamp and item indexes, because these are used for computing the filtered timestamp.
   if (this->AveragedItemsForFiltering > 1)
   {
+    // If the containers are full then the new item replaces the oldest one
+    bool containersFull = (this->FilterContainersNumberOfValidElements >= this->AveragedItemsForFiltering);
+    double removedIndex = containersFull ? this->FilterContainerIndexVector(this->FilterContainersOldestIndex) : 0;
+    double removedTimestamp = containersFull ? this->FilterContainerTimestampVector(this->FilterContainersOldestIndex) : 0;
+
     this->FilterContainerIndexVector(this->FilterContainersOldestIndex) = itemIndex;
     this->FilterContainerTimestampVector[this->FilterContainersOldestIndex] = inUnfilteredTimestamp;
     this->FilterContainersNumberOfValidElements++;
@@ -558,6 +1201,34 @@ PlusStatus vtkPlusTimestampedCircularBuffer::CreateFilteredTimeStampForItem(unsi
     {
       this->FilterContainersOldestIndex = 0;
     }
+
+    if (this->IncrementalTimestampFiltering)
+    {
+      if (this->FilterSumsNumberOfUpdates < 0 || this->FilterSumsNumberOfUpdates >= static_cast<int>(this->AveragedItemsForFiltering))
+      {
+        // Recompute the sums regularly (amortized constant time) to prevent accumulation of rounding errors
+        this->RecomputeFilterSums();
+      }
+      else
+      {
+        if (containersFull)
+        {
+          double removedX = removedIndex - this->FilterSumsReferenceIndex;
+          double removedY = removedTimestamp - this->FilterSumsReferenceTimestamp;
+          this->FilterSumX -= removedX;
+          this->FilterSumY -= removedY;
+          this->FilterSumXX -= removedX * removedX;
+          this->FilterSumXY -= removedX * removedY;
+        }
+        double addedX = itemIndex - this->FilterSumsReferenceIndex;
+        double addedY = inUnfilteredTimestamp - this->FilterSumsReferenceTimestamp;
+        this->FilterSumX += addedX;
+        this->FilterSumY += addedY;
+        this->FilterSumXX += addedX * addedX;
+        this->FilterSumXY += addedX * addedY;
+        this->FilterSumsNumberOfUpdates++;
+      }
+    }
   }
 
   // If we don't have enough unfiltered timestamps or we don't want to use afiltering then just use the unfiltered timestamps
@@ -591,20 +1262,40 @@ PlusStatus vtkPlusTimestampedCircularBuffer::CreateFilteredTimeStampForItem(unsi
   //   b = yMean - a*xMean
   //
 
-  double xMean = this->FilterContainerIndexVector.mean();
-  double yMean = this->FilterContainerTimestampVector.mean();
-  double covarianceXY = 0;
-  double varianceX = 0;
-  for (int i = this->FilterContainerTimestampVector.size() - 1; i >= 0; i--)
+  // With running sums (x and y relative to the reference item, n = number of items):
+  //   xMean = sumX / n, yMean = sumY / n
+  //   sum( (x(i)-xMean) * (y(i)-yMean) ) = sumXY - sumX * yMean
+  //   sum( (x(i)-xMean) * (x(i)-xMean) ) = sumXX - sumX * xMean
+  //
+
+  if (this->IncrementalTimestampFiltering)
   {
-    double xiMinusXmean = (this->FilterContainerIndexVector(i) - xMean);
-    covarianceXY += xiMinusXmean * (this->FilterContainerTimestampVector(i) - yMean);
-    varianceX += xiMinusXmean * xiMinusXmean;
+    double numberOfItems = this->FilterContainersNumberOfValidElements;
+    double xMean = this->FilterSumX / numberOfItems;
+    double yMean = this->FilterSumY / numberOfItems;
+    double covarianceXY = this->FilterSumXY - this->FilterSumX * yMean;
+    double varianceX = this->FilterSumXX - this->FilterSumX * xMean;
+    double a = covarianceXY / varianceX;
+
+    outFilteredTimestamp = this->FilterSumsReferenceTimestamp + yMean + a * ((itemIndex - this->FilterSumsReferenceIndex) - xMean);
   }
-  double a = covarianceXY / varianceX;
-  double b = yMean - a * xMean;
+  else
+  {
+    double xMean = this->FilterContainerIndexVector.mean();
+    double yMean = this->FilterContainerTimestampVector.mean();
+    double covarianceXY = 0;
+    double varianceX = 0;
+    for (int i = this->FilterContainerTimestampVector.size() - 1; i >= 0; i--)
+    {
+      double xiMinusXmean = (this->FilterContainerIndexVector(i) - xMean);
+      covarianceXY += xiMinusXmean * (this->FilterContainerTimestampVector(i) - yMean);
+      varianceX += xiMinusXmean * xiMinusXmean;
+    }
+    double a = covarianceXY / varianceX;
+    double b = yMean - a * xMean;
 
-  outFilteredTimestamp = a * itemIndex + b;
+    outFilteredTimestamp = a * itemIndex + b;
+  }
 
   if (this->TimeStampLogging)
   {
@@ -628,6 +1319,44 @@ PlusStatus vtkPlusTimestampedCircularBuffer::CreateFilteredTimeStampForItem(unsi
   return PLUS_SUCCESS;
 }
 
+//----------------------------------------------------------------------------
+void vtkPlusTimestampedCircularBuffer::RecomputeFilterSums()
+{
+  // The most recently added item is the reference
+  unsigned int newestIndex = (this->FilterContainersOldestIndex + this->AveragedItemsForFiltering - 1) % this->AveragedItemsForFiltering;
+  this->FilterSumsReferenceIndex = this->FilterContainerIndexVector(newestIndex);
+  this->FilterSumsReferenceTimestamp = this->FilterContainerTimestampVector(newestIndex);
+  this->FilterSumX = 0;
+  this->FilterSumY = 0;
+  this->FilterSumXX = 0;
+  this->FilterSumXY = 0;
+  // Until the containers are full the valid elements are at the beginning
+  for (unsigned int i = 0; i < this->FilterContainersNumberOfValidElements; i++)
+  {
+    double x = this->FilterContainerIndexVector(i) - this->FilterSumsReferenceIndex;
+    double y = this->FilterContainerTimestampVector(i) - this->FilterSumsReferenceTimestamp;
+    this->FilterSumX += x;
+    this->FilterSumY += y;
+    this->FilterSumXX += x * x;
+    this->FilterSumXY += x * y;
+  }
+  this->FilterSumsNumberOfUpdates = 0;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusTimestampedCircularBuffer::SetIncrementalTimestampFiltering(bool enable)
+{
+  this->Lock();
+  if (this->IncrementalTimestampFiltering != enable)
+  {
+    this->IncrementalTimestampFiltering = enable;
+    // Running sums are not maintained while disabled
+    this->FilterSumsNumberOfUpdates = -1;
+    this->Modified();
+  }
+  this->Unlock();
+}
+
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusTimestampedCircularBuffer::GetTimeStampReportTable(vtkTable* timeStampReportTable)
 {
@@ -677,6 +1406,12 @@ void vtkPlusTimestampedCircularBuffer::AddToTimeStampReport(unsigned long itemIn
     vtkSmartPointer<vtkDoubleArray> colFilteredTimestamp = vtkSmartPointer<vtkDoubleArray>::New();
     colFilteredTimestamp->SetName(colFilteredTimestampName);
     this->TimeStampReportTable->AddColumn(colFilteredTimestamp);
+
+    // Difference between the unfiltered and filtered timestamp, the jitter that the filtering removes
+    const char* colTimestampJitterName = "TimestampJitter";
+    vtkSmartPointer<vtkDoubleArray> colTimestampJitter = vtkSmartPointer<vtkDoubleArray>::New();
+    colTimestampJitter->SetName(colTimestampJitterName);
+    this->TimeStampReportTable->AddColumn(colTimestampJitter);
   }
 
   // create a new row for the timestamp report table
@@ -685,6 +1420,7 @@ void vtkPlusTimestampedCircularBuffer::AddToTimeStampReport(unsigned long itemIn
   timeStampReportTableRow->InsertNextValue(itemIndex);
   timeStampReportTableRow->InsertNextValue(unfilteredTimestamp - this->StartTime);
   timeStampReportTableRow->InsertNextValue(filteredTimestamp - this->StartTime);
+  timeStampReportTableRow->InsertNextValue(unfilteredTimestamp - filteredTimestamp);
 
   this->TimeStampReportTable->InsertNextRow(timeStampReportTableRow);
 
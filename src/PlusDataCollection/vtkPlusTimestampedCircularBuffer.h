@@ -9,8 +9,11 @@
 
 #include "PlusConfigure.h"
 #include "PlusStreamBufferItem.h"
+#include "PlusTransformSampleStore.h"
 #include "vtkObject.h"
+#include <atomic>
 #include <deque>
+#include <vector>
 
 #include "vnl/vnl_matrix.h"
 #include "vnl/vnl_vector.h"
@@ -45,7 +48,7 @@ public:
    video frames that it will hold.  The default is 30.
   */
   virtual PlusStatus SetBufferSize( int n );
-  virtual inline int GetBufferSize() { return this->BufferItemContainer.size(); };
+  virtual inline int GetBufferSize() { return this->CompactTransformStorage ? this->TransformSamples.GetSize() : this->BufferItemContainer.size(); };
 
   /*!
     Get the number of items in the list (this is not the same as
@@ -57,13 +60,31 @@ public:
 
   /*!
     Given a timestamp, compute the nearest frame UID
-    This assumes that the times motonically increase
+    This assumes that the times motonically increase.
+    The item is found by interpolation search, which typically requires only a few timestamp accesses,
+    independently of the buffer size.
   */
   virtual ItemStatus GetItemUidFromTime( const double time, BufferItemUidType& uid );
 
+  /*!
+    Given multiple timestamps, compute the nearest frame UID for each of them.
+    The result is the same as calling GetItemUidFromTime for each timestamp, but the buffer is locked only once.
+    If the timestamps are in increasing order then the items are found by walking the buffer forward from the item
+    found for the previous timestamp, so the cost is proportional to the number of timestamps plus the number of items
+    between the first and the last one. A timestamp that is smaller than the previous one is searched from scratch.
+    \param times Array of numberOfTimes timestamps
+    \param uids Array of numberOfTimes UIDs that receives the results
+    \param statuses Array of numberOfTimes statuses that receives the result of each lookup
+  */
+  virtual void GetItemUidsFromTimes( const double* times, int numberOfTimes, BufferItemUidType* uids, ItemStatus* statuses );
+
   /*! Get the most recent frame UID that is already in the buffer */
   virtual BufferItemUidType GetLatestItemUidInBuffer()
   {
+    if (this->LockFreeSlots.load(std::memory_order_acquire) != NULL)
+    {
+      return this->PublishedLatestItemUid.load(std::memory_order_acquire);
+    }
     this->Lock();
     BufferItemUidType latestUid = this->LatestItemUid;
     this->Unlock();
@@ -73,6 +94,12 @@ public:
   /*! Get the oldest frame UID in the buffer  */
   virtual BufferItemUidType GetOldestItemUidInBuffer()
   {
+    BufferItemUidType latestUid(0);
+    int numberOfItems(0);
+    if (this->LockFreeSlots.load(std::memory_order_acquire) != NULL && this->ReadPublishedItemRange(latestUid, numberOfItems))
+    {
+      return latestUid - (numberOfItems - 1);
+    }
     this->Lock();
     // LatestItemUid - ( NumberOfItems - 1 ) is the oldest element in the buffer
     BufferItemUidType oldestUid = this->LatestItemUid - ( this->NumberOfItems - 1 );
@@ -88,6 +115,10 @@ public:
 
   virtual ItemStatus GetOldestTimeStamp( double& timestamp )
   {
+    if (this->LockFreeSlots.load(std::memory_order_acquire) != NULL)
+    {
+      return this->GetOldestTimeStampLockFree(timestamp);
+    }
     // The oldest item may be removed from the buffer at any moment
     // therefore we need to retrieve its UID and timestamp within a single lock
     this->Lock();
@@ -166,6 +197,44 @@ public:
   */
   virtual ItemStatus GetBufferItemPointerFromUid( const BufferItemUidType uid, StreamBufferItem*& itemPtr );
 
+  /*!
+    Get buffer object for modification.
+    If the item is referenced by a view (see GetBufferItemViewFromUid) then it is replaced in the buffer by a new item
+    (itemReplaced is set to true), so that the referenced item is not modified.
+    If keepContent is true then the new item is a copy of the replaced item (for modifying the item in place), otherwise it is empty
+    (for overwriting the item with a new one).
+    If replacedItem is not NULL then it is set to the replaced item.
+    INTERNAL USE ONLY! Need to lock buffer until we use the buffer index
+  */
+  virtual StreamBufferItem* GetWritableBufferItemPointerFromBufferIndex( const int bufferIndex, bool& itemReplaced, StreamBufferItemView* replacedItem = NULL, bool keepContent = false );
+
+  /*!
+    Get buffer object for modification.
+    If the item is referenced by a view (see GetBufferItemViewFromUid) then it is replaced in the buffer by a copy,
+    so that the referenced item is not modified.
+    INTERNAL USE ONLY! Need to lock buffer until we use the item
+  */
+  virtual ItemStatus GetWritableBufferItemPointerFromUid( const BufferItemUidType uid, StreamBufferItem*& itemPtr );
+
+  /*!
+    Get a read-only reference to a buffer item, without copying it.
+    The buffer does not modify the item while the view is held: if a new item has to be written
+    into the same slot then the slot gets a new item.
+  */
+  virtual ItemStatus GetBufferItemViewFromUid( const BufferItemUidType uid, StreamBufferItemView& itemView );
+
+  /*!
+    Get the buffer index of the item with the specified UID
+    INTERNAL USE ONLY! Need to lock buffer until we use the buffer index
+  */
+  virtual ItemStatus GetBufferIndexFromUid( const BufferItemUidType uid, int& bufferIndex );
+
+  /*!
+    Get the compact storage of the buffer items. Only contains items if CompactTransformStorage is enabled.
+    INTERNAL USE ONLY! Need to lock buffer until we use the storage
+  */
+  PlusTransformSampleStore& GetTransformSampleStore() { return this->TransformSamples; }
+
   virtual PlusStatus PrepareForNewItem( const double timestamp, BufferItemUidType& newFrameUid, int& bufferIndex );
 
   /*!
@@ -183,7 +252,10 @@ public:
   /*! Add values to the timestamp report. If reporting is not enabled then no values will be added. This should only be called if an item is added without calling CreateFilteredTimeStampForItem. */
   void AddToTimeStampReport( unsigned long itemIndex, double unfilteredTimestamp, double filteredTimestamp );
 
-  /*! Get the table report of the timestamped buffer. To fill this table TimeStampReporting has to be enabled.  */
+  /*!
+    Get the table report of the timestamped buffer. To fill this table TimeStampReporting has to be enabled.
+    Columns: FrameNumber, UnfilteredTimestamp, FilteredTimestamp, TimestampJitter (unfiltered minus filtered timestamp).
+  */
   PlusStatus GetTimeStampReportTable( vtkTable* timeStampReportTable );
 
   /*! If TimeStampReporting is enabled then all filtered and unfiltered timestamp values will be saved in a table for diagnostic purposes. */
@@ -201,6 +273,37 @@ public:
   /*! Get number of items used for timestamp filtering (with LSQR mimimizer) */
   vtkGetMacro( AveragedItemsForFiltering, int );
 
+  /*!
+    Compute the filtered timestamps from running sums of the item indexes and timestamps that are updated
+    when an item is added (constant time per item), instead of fitting the line to all the averaged items for each new item.
+    Both methods give the same result, the non-incremental computation is kept for validation. Enabled by default.
+  */
+  virtual void SetIncrementalTimestampFiltering( bool enable );
+  vtkGetMacro( IncrementalTimestampFiltering, bool );
+  vtkBooleanMacro( IncrementalTimestampFiltering, bool );
+
+  /*!
+    Enable lock-free reads of the item UIDs and timestamps.
+    In this mode the item UID and filtered timestamp of each item is also published in a slot table
+    that readers can access without taking the buffer lock (each slot is validated by its item UID, as in a seqlock).
+    GetLatestItemUidInBuffer, GetOldestItemUidInBuffer, GetTimeStamp, GetFilteredTimeStamp, GetOldestTimeStamp and
+    GetItemUidFromTime then never wait for the buffer lock, so they cannot block (or be blocked by) the acquisition thread.
+    Only a single thread may add items to the buffer in this mode. Disabled by default.
+  */
+  virtual void SetLockFreeReads( bool enable );
+  virtual bool GetLockFreeReads() { return this->LockFreeReads; }
+  vtkBooleanMacro( LockFreeReads, bool );
+
+  /*!
+    Store the items in a compact, transform-only storage (see PlusTransformSampleStore) instead of StreamBufferItem objects.
+    Only transforms can be stored in this mode and item pointers and views cannot be retrieved
+    (items are retrieved by copying them from GetTransformSampleStore()).
+    Changing the storage mode clears the buffer. Disabled by default.
+  */
+  virtual void SetCompactTransformStorage( bool enable );
+  virtual bool GetCompactTransformStorage() { return this->CompactTransformStorage; }
+  vtkBooleanMacro( CompactTransformStorage, bool );
+
   /*! Set recording start time */
   vtkSetMacro( StartTime, double );
   /*! Get recording start time */
@@ -210,6 +313,71 @@ protected:
   vtkPlusTimestampedCircularBuffer();
   ~vtkPlusTimestampedCircularBuffer();
 
+  /*!
+    UID and filtered timestamp of a buffer item, readable without locking the buffer.
+    The writer sets Uid to 0 before modifying the slot and sets it to the new UID when done,
+    therefore the reader can detect an incomplete or overwritten slot by reading Uid before and after the timestamp.
+  */
+  struct LockFreeSlot
+  {
+    LockFreeSlot() : Uid(0), FilteredTimestamp(0.0) {}
+    std::atomic<BufferItemUidType> Uid;
+    std::atomic<double> FilteredTimestamp;
+  };
+
+  /*! Fixed-size table of lock-free slots, item with UID u is stored at index (u % Size) */
+  struct LockFreeSlotTable
+  {
+    explicit LockFreeSlotTable(int size) : Size(size > 0 ? size : 1), Slots(new LockFreeSlot[size > 0 ? size : 1]) {}
+    ~LockFreeSlotTable() { delete[] this->Slots; }
+    int Size;
+    LockFreeSlot* Slots;
+  private:
+    LockFreeSlotTable(const LockFreeSlotTable&);
+    void operator=(const LockFreeSlotTable&);
+  };
+
+  /*! Write UID and filtered timestamp (without local time offset) to the lock-free slot table. The caller must have locked the buffer. */
+  void PublishLockFreeSlot(LockFreeSlotTable* table, BufferItemUidType uid, double filteredTimestamp);
+
+  /*!
+    Read the filtered timestamp (without local time offset) of an item from the lock-free slot table.
+    Returns false if the slot does not contain the requested item (not written yet, being written, or already overwritten)
+    or if the UID is 0, which marks unwritten slots.
+  */
+  bool ReadLockFreeSlot(LockFreeSlotTable* table, BufferItemUidType uid, double& filteredTimestamp);
+
+  /*!
+    Recreate the lock-free slot table from the current content of the buffer and publish it along with the latest UID and
+    number of items. The caller must have locked the buffer. The previous table is kept alive until the buffer is deleted,
+    as readers may still access it.
+  */
+  void RebuildLockFreeSlotTable();
+
+  /*! Publish LatestItemUid and NumberOfItems for lock-free readers. The caller must have locked the buffer. */
+  void PublishItemRange();
+
+  /*!
+    Read the latest UID and number of items that were published together by PublishItemRange.
+    Returns false if a consistent pair could not be read because the writer kept modifying it.
+  */
+  bool ReadPublishedItemRange(BufferItemUidType& latestUid, int& numberOfItems);
+
+  /*! Get the filtered timestamp (without local time offset) of the item stored at the buffer index. The caller must have locked the buffer. */
+  double GetFilteredTimeStampFromBufferIndex( int bufferIndex );
+
+  /*!
+    Compute the running sums of the timestamp filter from the valid elements of the filter containers,
+    relative to the most recently added item. The caller must have locked the buffer.
+  */
+  void RecomputeFilterSums();
+
+  /*! Lock-free implementation of GetOldestTimeStamp */
+  ItemStatus GetOldestTimeStampLockFree( double& timestamp );
+  /*! Lock-free implementations of the corresponding public methods. Return false if the caller should fall back to the locked implementation. */
+  bool GetFilteredTimeStampLockFree( const BufferItemUidType uid, double& filteredTimestamp, ItemStatus& status );
+  bool GetItemUidFromTimeLockFree( const double time, BufferItemUidType& uid, ItemStatus& status );
+
 protected:
   vtkIGSIORecursiveCriticalSection* Mutex;
 
@@ -229,7 +397,37 @@ protected:
   */
   BufferItemUidType LatestItemUid;
 
-  std::deque<StreamBufferItem> BufferItemContainer;
+  typedef std::shared_ptr<StreamBufferItem> StreamBufferItemPtr;
+
+  /*! Buffer items. An item is shared with the views that refer to it. */
+  std::deque<StreamBufferItemPtr> BufferItemContainer;
+
+  /*! If enabled then items are stored in TransformSamples instead of BufferItemContainer */
+  bool CompactTransformStorage;
+
+  /*! Buffer items, if CompactTransformStorage is enabled */
+  PlusTransformSampleStore TransformSamples;
+
+  /*! If enabled then item UIDs and timestamps can be read without locking the buffer */
+  bool LockFreeReads;
+
+  /*! Slot table used for lock-free reads, NULL if LockFreeReads is disabled */
+  std::atomic<LockFreeSlotTable*> LockFreeSlots;
+
+  /*! Slot tables that have been replaced but may still be accessed by readers */
+  std::vector<LockFreeSlotTable*> RetiredLockFreeSlotTables;
+
+  /*! Copy of LatestItemUid for lock-free readers, updated after the item slot is published */
+  std::atomic<BufferItemUidType> PublishedLatestItemUid;
+
+  /*! Copy of NumberOfItems for lock-free readers */
+  std::atomic<int> PublishedNumberOfItems;
+
+  /*!
+    Sequence number of the published latest UID and number of items. It is odd while they are being modified,
+    readers use it to detect that they have read the two values from different updates.
+  */
+  std::atomic<unsigned int> PublishedItemRangeSequence;
 
   /*! Matrix used for storing the last number of AveragedItemsForFiltering frame index */
   vnl_vector<double> FilterContainerIndexVector;
@@ -243,6 +441,27 @@ protected:
   /*! Number of valid elements in the frame index and timestamp containers (maximum can be equal to AveragedItemsForFiltering) */
   unsigned int FilterContainersNumberOfValidElements;
 
+  /*! Compute the filtered timestamps from running sums */
+  bool IncrementalTimestampFiltering;
+
+  /*!
+    Running sums of the frame indexes (x) and unfiltered timestamps (y) that are stored in the filter containers.
+    Values are relative to a reference item, which keeps the sums small: the index sums remain exact integers
+    and the timestamp sums do not lose precision.
+  */
+  double FilterSumsReferenceIndex;
+  double FilterSumsReferenceTimestamp;
+  double FilterSumX;
+  double FilterSumY;
+  double FilterSumXX;
+  double FilterSumXY;
+
+  /*!
+    Number of incremental updates since the running sums were computed from the filter containers (negative if the sums are invalid).
+    The sums are recomputed after every AveragedItemsForFiltering updates to prevent accumulation of rounding errors.
+  */
+  int FilterSumsNumberOfUpdates;
+
   /*! Number of averaged items used for filtering - read from config files */
   unsigned int AveragedItemsForFiltering;
 
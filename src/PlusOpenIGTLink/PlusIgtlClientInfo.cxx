@@ -16,6 +16,7 @@ PlusIgtlClientInfo::PlusIgtlClientInfo()
   , TDATAResolution(0)
   , TDATARequested(false)
   , LastTDATASentTimeStamp(-1)
+  , ImageCrcEnabled(true)
 {
 
 }
@@ -65,6 +66,16 @@ PlusStatus PlusIgtlClientInfo::SetClientInfoFromXmlData(vtkXMLDataElement* xmlda
     xmldata->SetIntAttribute("TDATAResolution", resolution);
   }
 
+  if (xmldata->GetAttribute("OutputChannelId") != NULL)
+  {
+    clientInfo.OutputChannelId = xmldata->GetAttribute("OutputChannelId");
+  }
+
+  if (xmldata->GetAttribute("ImageCrcEnabled") != NULL)
+  {
+    clientInfo.SetImageCrcEnabled(!igsioCommon::IsEqualInsensitive(xmldata->GetAttribute("ImageCrcEnabled"), "FALSE"));
+  }
+
   // Get message types
   vtkXMLDataElement* messageTypes = xmldata->FindNestedElementWithName("MessageTypes");
   if (messageTypes != NULL)
@@ -239,6 +250,14 @@ void PlusIgtlClientInfo::GetClientInfoInXmlData(std::string& strXmlData)
   xmldata->SetName("ClientInfo");
   xmldata->SetAttribute("TDATARequested", (this->GetTDATARequested() ? "TRUE" : "FALSE"));
   xmldata->SetIntAttribute("TDATAResolution", this->GetTDATAResolution());
+  if (!this->OutputChannelId.empty())
+  {
+    xmldata->SetAttribute("OutputChannelId", this->OutputChannelId.c_str());
+  }
+  if (!this->GetImageCrcEnabled())
+  {
+    xmldata->SetAttribute("ImageCrcEnabled", "FALSE");
+  }
 
   vtkSmartPointer<vtkXMLDataElement> messageTypes = vtkSmartPointer<vtkXMLDataElement>::New();
   messageTypes->SetName("MessageTypes");
@@ -308,6 +327,7 @@ void PlusIgtlClientInfo::GetClientInfoInXmlData(std::string& strXmlData)
 void PlusIgtlClientInfo::PrintSelf(ostream& os, vtkIndent indent)
 {
   os << indent << "IGTL version: " << this->ClientHeaderVersion;
+  os << indent << "Output channel: " << (this->OutputChannelId.empty() ? "(default)" : this->OutputChannelId) << ". ";
   os << indent << "Message types: ";
   if (!this->IgtlMessageTypes.empty())
   {
@@ -329,6 +349,7 @@ void PlusIgtlClientInfo::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "TDATARequested: " << (this->GetTDATARequested() ? "TRUE" : "FALSE") << ". ";
   os << indent << "LastTDATASentTimeStamp: " << this->GetLastTDATASentTimeStamp() << ". ";
   os << indent << "TDATAResolution: " << this->GetTDATAResolution() << ". ";
+  os << indent << "ImageCrcEnabled: " << (this->GetImageCrcEnabled() ? "TRUE" : "FALSE") << ". ";
 
   os << ". Transforms: ";
   if (!this->TransformNames.empty())
@@ -433,3 +454,15 @@ void PlusIgtlClientInfo::SetLastTDATASentTimeStamp(double val)
 {
   this->LastTDATASentTimeStamp = val;
 }
+
+//----------------------------------------------------------------------------
+bool PlusIgtlClientInfo::GetImageCrcEnabled() const
+{
+  return this->ImageCrcEnabled;
+}
+
+//----------------------------------------------------------------------------
+void PlusIgtlClientInfo::SetImageCrcEnabled(bool val)
+{
+  this->ImageCrcEnabled = val;
+}
@@ -130,6 +130,17 @@ public:
   /*! timestamp of the last sent TDATA message. */
   void SetLastTDATASentTimeStamp(double val);
 
+  /*! Compute the CRC of IMAGE and USMESSAGE messages. If the client does not check the CRC then it can be disabled to reduce the cost of sending large images. */
+  bool GetImageCrcEnabled() const;
+  /*! Compute the CRC of IMAGE and USMESSAGE messages. If the client does not check the CRC then it can be disabled to reduce the cost of sending large images. */
+  void SetImageCrcEnabled(bool val);
+
+  /*!
+    ID of the channel that the client receives the data from. If empty then the data is sent from the
+    server's default output channel. The channel must be one of the channels that the server broadcasts.
+  */
+  std::string OutputChannelId;
+
   /*! Message types that client expects from the server */
   std::vector<std::string> IgtlMessageTypes;
 
@@ -150,6 +161,7 @@ protected:
   bool    TDATARequested;
   double  LastTDATASentTimeStamp;
   int     TDATAResolution;
+  bool    ImageCrcEnabled;
 };
 
 #endif
\ No newline at end of file
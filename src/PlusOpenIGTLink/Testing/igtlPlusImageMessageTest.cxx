@@ -0,0 +1,242 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file igtlPlusImageMessageTest.cxx
+  \brief Test that an igtl::PlusImageMessage that references the scalars of an image is sent as the same bytes
+  as an igtl::ImageMessage that copies the pixel data, and that receivers can unpack it with CRC check.
+*/
+
+#include "PlusConfigure.h"
+#include "igtlPlusImageMessage.h"
+#include "igtl_header.h"
+
+// OpenIGTLink includes
+#include <igtlImageMessage.h>
+#include <igtlMessageHeader.h>
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkSmartPointer.h>
+#include <vtksys/CommandLineArguments.hxx>
+
+// STL includes
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace
+{
+  const int IMAGE_DIMENSIONS[3] = { 32, 24, 1 };
+  const int NUMBER_OF_COMPONENTS = 3;
+
+  //----------------------------------------------------------------------------
+  vtkSmartPointer<vtkImageData> CreateImage()
+  {
+    vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+    image->SetDimensions(IMAGE_DIMENSIONS[0], IMAGE_DIMENSIONS[1], IMAGE_DIMENSIONS[2]);
+    image->AllocateScalars(VTK_UNSIGNED_CHAR, NUMBER_OF_COMPONENTS);
+    unsigned char* pixels = static_cast<unsigned char*>(image->GetScalarPointer());
+    const int numberOfBytes = IMAGE_DIMENSIONS[0] * IMAGE_DIMENSIONS[1] * IMAGE_DIMENSIONS[2] * NUMBER_OF_COMPONENTS;
+    for (int i = 0; i < numberOfBytes; ++i)
+    {
+      pixels[i] = static_cast<unsigned char>((i * 7 + i / 97) % 256);
+    }
+    return image;
+  }
+
+  //----------------------------------------------------------------------------
+  /*! Set the same parameters for the message that references the scalars and the message that copies them */
+  void SetUpImageMessage(igtl::ImageMessage* imageMessage)
+  {
+    int dimensions[3] = { IMAGE_DIMENSIONS[0], IMAGE_DIMENSIONS[1], IMAGE_DIMENSIONS[2] };
+    int subVolumeOffset[3] = { 0, 0, 0 };
+    imageMessage->SetHeaderVersion(IGTL_HEADER_VERSION_2);
+    imageMessage->SetDeviceName("Image_Reference");
+    imageMessage->SetTimeStamp(1234, 5678);
+    imageMessage->SetDimensions(dimensions);
+    imageMessage->SetSubVolume(dimensions, subVolumeOffset);
+    imageMessage->SetSpacing(0.2f, 0.3f, 1.0f);
+    imageMessage->SetScalarTypeToUint8();
+    imageMessage->SetNumComponents(NUMBER_OF_COMPONENTS);
+    // Metadata is packed after the pixel data
+    imageMessage->SetMetaDataElement("Note", IANA_TYPE_US_ASCII, "Metadata after the pixels");
+  }
+
+  //----------------------------------------------------------------------------
+  /*! Get the bytes of a packed message as they are sent */
+  std::string GetMessageBytes(igtl::MessageBase* message)
+  {
+    std::vector<igtl::PlusImageMessage::BufferSegment> segments;
+    igtl::PlusImageMessage::GetBufferSegments(message, segments);
+    std::string bytes;
+    for (std::vector<igtl::PlusImageMessage::BufferSegment>::const_iterator segmentIt = segments.begin(); segmentIt != segments.end(); ++segmentIt)
+    {
+      bytes.append(static_cast<const char*>(segmentIt->Data), static_cast<size_t>(segmentIt->Size));
+    }
+    return bytes;
+  }
+
+  //----------------------------------------------------------------------------
+  /*! Unpack the sent bytes as a receiver does and compare the pixels with the image */
+  int CheckReceivedMessage(const std::string& bytes, bool checkCrc, vtkImageData* image, const std::string& testName)
+  {
+    igtl::MessageHeader::Pointer header = igtl::MessageHeader::New();
+    header->InitBuffer();
+    if (bytes.size() < static_cast<size_t>(header->GetBufferSize()))
+    {
+      LOG_ERROR(testName << ": message is shorter than its header");
+      return 1;
+    }
+    memcpy(header->GetBufferPointer(), bytes.data(), header->GetBufferSize());
+    header->Unpack();
+    if (bytes.size() != static_cast<size_t>(header->GetBufferSize()) + header->GetBodySizeToRead())
+    {
+      LOG_ERROR(testName << ": message size is " << bytes.size() << " bytes, the header describes " << header->GetBufferSize() + header->GetBodySizeToRead() << " bytes");
+      return 1;
+    }
+
+    igtl::ImageMessage::Pointer receivedMessage = igtl::ImageMessage::New();
+    receivedMessage->SetMessageHeader(header);
+    receivedMessage->AllocateBuffer();
+    memcpy(receivedMessage->GetBufferBodyPointer(), bytes.data() + header->GetBufferSize(), receivedMessage->GetBufferBodySize());
+    if (!(receivedMessage->Unpack(checkCrc ? 1 : 0) & igtl::MessageHeader::UNPACK_BODY))
+    {
+      LOG_ERROR(testName << ": unable to unpack the message" << (checkCrc ? " with CRC check" : ""));
+      return 1;
+    }
+
+    int numberOfErrors(0);
+    int dimensions[3] = { 0, 0, 0 };
+    receivedMessage->GetDimensions(dimensions);
+    if (dimensions[0] != IMAGE_DIMENSIONS[0] || dimensions[1] != IMAGE_DIMENSIONS[1] || dimensions[2] != IMAGE_DIMENSIONS[2]
+        || receivedMessage->GetNumComponents() != NUMBER_OF_COMPONENTS)
+    {
+      LOG_ERROR(testName << ": received image size or number of components differs");
+      numberOfErrors++;
+    }
+    else if (memcmp(receivedMessage->GetScalarPointer(), image->GetScalarPointer(), receivedMessage->GetSubVolumeImageSize()) != 0)
+    {
+      LOG_ERROR(testName << ": received pixels differ from the image");
+      numberOfErrors++;
+    }
+    std::string note;
+    if (!receivedMessage->GetMetaDataElement("Note", note) || note != "Metadata after the pixels")
+    {
+      LOG_ERROR(testName << ": metadata after the pixels is not received");
+      numberOfErrors++;
+    }
+    return numberOfErrors;
+  }
+
+  //----------------------------------------------------------------------------
+  /*! The referencing message must be sent as exactly the same bytes (including body size and CRC) as the copying message */
+  int TestSameAsCopyingMessage(vtkImageData* image)
+  {
+    igtl::ImageMessage::Pointer copyingMessage = igtl::ImageMessage::New();
+    SetUpImageMessage(copyingMessage);
+    copyingMessage->AllocateScalars();
+    memcpy(copyingMessage->GetScalarPointer(), image->GetScalarPointer(), copyingMessage->GetSubVolumeImageSize());
+    copyingMessage->Pack();
+
+    igtl::PlusImageMessage::Pointer referencingMessage = igtl::PlusImageMessage::New();
+    SetUpImageMessage(referencingMessage);
+    if (referencingMessage->SetScalarsReference(image) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("SameAsCopyingMessage: unable to reference the scalars of the image");
+      return 1;
+    }
+    referencingMessage->Pack();
+
+    int numberOfErrors(0);
+    std::string copyingBytes(static_cast<const char*>(copyingMessage->GetBufferPointer()), static_cast<size_t>(copyingMessage->GetBufferSize()));
+    std::string referencingBytes = GetMessageBytes(referencingMessage);
+    if (referencingBytes.size() != copyingBytes.size())
+    {
+      LOG_ERROR("SameAsCopyingMessage: referencing message is " << referencingBytes.size() << " bytes, copying message is " << copyingBytes.size() << " bytes");
+      numberOfErrors++;
+    }
+    else if (referencingBytes.compare(0, IGTL_HEADER_SIZE, copyingBytes, 0, IGTL_HEADER_SIZE) != 0)
+    {
+      LOG_ERROR("SameAsCopyingMessage: header (body size or CRC) of the referencing message differs from the copying message");
+      numberOfErrors++;
+    }
+    else if (referencingBytes != copyingBytes)
+    {
+      LOG_ERROR("SameAsCopyingMessage: body of the referencing message differs from the copying message");
+      numberOfErrors++;
+    }
+    numberOfErrors += CheckReceivedMessage(referencingBytes, true, image, "SameAsCopyingMessage");
+    return numberOfErrors;
+  }
+
+  //----------------------------------------------------------------------------
+  /*! If the CRC is disabled then the CRC field is 0 and the message can be unpacked without CRC check */
+  int TestCrcDisabled(vtkImageData* image)
+  {
+    igtl::PlusImageMessage::Pointer referencingMessage = igtl::PlusImageMessage::New();
+    SetUpImageMessage(referencingMessage);
+    referencingMessage->SetCrcEnabled(false);
+    if (referencingMessage->SetScalarsReference(image) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("CrcDisabled: unable to reference the scalars of the image");
+      return 1;
+    }
+    referencingMessage->Pack();
+
+    int numberOfErrors(0);
+    std::string referencingBytes = GetMessageBytes(referencingMessage);
+    // The CRC is the last field of the header
+    const size_t crcOffset = static_cast<size_t>(IGTL_HEADER_SIZE) - sizeof(igtl_uint64);
+    if (referencingBytes.size() < static_cast<size_t>(IGTL_HEADER_SIZE) || referencingBytes.compare(crcOffset, sizeof(igtl_uint64), std::string(sizeof(igtl_uint64), '\0')) != 0)
+    {
+      LOG_ERROR("CrcDisabled: CRC of the message is not 0");
+      numberOfErrors++;
+    }
+    numberOfErrors += CheckReceivedMessage(referencingBytes, false, image, "CrcDisabled");
+    return numberOfErrors;
+  }
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  vtkSmartPointer<vtkImageData> image = CreateImage();
+  int numberOfErrors(0);
+  numberOfErrors += TestSameAsCopyingMessage(image);
+  numberOfErrors += TestCrcDisabled(image);
+
+  if (numberOfErrors != 0)
+  {
+    LOG_INFO("Test failed!");
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("Test completed successfully!");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,248 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file vtkPlusIgtlMessageFactoryCacheTest.cxx
+  \brief Test that the messages that are shared between clients through the packed message cache are
+  identical to the messages that are packed for each client separately.
+*/
+
+#include "PlusConfigure.h"
+#include "PlusIgtlClientInfo.h"
+#include "igsioTrackedFrame.h"
+#include "igtlPlusImageMessage.h"
+#include "vtkIGSIOTransformRepository.h"
+#include "vtkPlusIgtlMessageFactory.h"
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkMatrix4x4.h>
+#include <vtkSmartPointer.h>
+#include <vtksys/CommandLineArguments.hxx>
+
+// STL includes
+#include <string>
+#include <vector>
+
+namespace
+{
+  const double FRAME_TIMESTAMP = 10.5;
+  const int NUMBER_OF_CLIENTS = 3;
+
+  // Clients A and C request the same data, client B requests an additional transform and does not check the CRC
+  const char* CLIENT_INFO_XML[NUMBER_OF_CLIENTS] =
+  {
+    "<ClientInfo TDATARequested=\"TRUE\" TDATAResolution=\"0\">"
+    "  <MessageTypes> <Message Type=\"IMAGE\" /> <Message Type=\"TRANSFORM\" /> <Message Type=\"POSITION\" /> <Message Type=\"TDATA\" />"
+    "    <Message Type=\"TRACKEDFRAME\" /> <Message Type=\"STRING\" /> </MessageTypes>"
+    "  <TransformNames> <Transform Name=\"ProbeToTracker\" /> <Transform Name=\"StylusToTracker\" /> </TransformNames>"
+    "  <ImageNames> <Image Name=\"Image\" EmbeddedTransformToFrame=\"Tracker\" /> </ImageNames>"
+    "  <StringNames> <String Name=\"Note\" /> </StringNames>"
+    "</ClientInfo>",
+
+    "<ClientInfo TDATARequested=\"TRUE\" TDATAResolution=\"0\" ImageCrcEnabled=\"FALSE\">"
+    "  <MessageTypes> <Message Type=\"IMAGE\" /> <Message Type=\"TRANSFORM\" /> <Message Type=\"POSITION\" /> <Message Type=\"TDATA\" />"
+    "    <Message Type=\"TRACKEDFRAME\" /> <Message Type=\"STRING\" /> </MessageTypes>"
+    "  <TransformNames> <Transform Name=\"ProbeToTracker\" /> <Transform Name=\"StylusToTracker\" /> <Transform Name=\"ImageToProbe\" /> </TransformNames>"
+    "  <ImageNames> <Image Name=\"Image\" EmbeddedTransformToFrame=\"Tracker\" /> </ImageNames>"
+    "  <StringNames> <String Name=\"Note\" /> </StringNames>"
+    "</ClientInfo>",
+
+    "<ClientInfo TDATARequested=\"TRUE\" TDATAResolution=\"0\">"
+    "  <MessageTypes> <Message Type=\"IMAGE\" /> <Message Type=\"TRANSFORM\" /> <Message Type=\"POSITION\" /> <Message Type=\"TDATA\" />"
+    "    <Message Type=\"TRACKEDFRAME\" /> <Message Type=\"STRING\" /> </MessageTypes>"
+    "  <TransformNames> <Transform Name=\"ProbeToTracker\" /> <Transform Name=\"StylusToTracker\" /> </TransformNames>"
+    "  <ImageNames> <Image Name=\"Image\" EmbeddedTransformToFrame=\"Tracker\" /> </ImageNames>"
+    "  <StringNames> <String Name=\"Note\" /> </StringNames>"
+    "</ClientInfo>"
+  };
+
+  //----------------------------------------------------------------------------
+  void SetFrameTransform(igsioTrackedFrame& trackedFrame, const std::string& from, const std::string& to, double translation)
+  {
+    vtkSmartPointer<vtkMatrix4x4> matrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    matrix->SetElement(0, 3, translation);
+    matrix->SetElement(1, 3, -translation);
+    matrix->SetElement(2, 3, 2 * translation);
+    igsioTransformName transformName(from, to);
+    trackedFrame.SetFrameTransform(transformName, matrix);
+    trackedFrame.SetFrameTransformStatus(transformName, TOOL_OK);
+  }
+
+  //----------------------------------------------------------------------------
+  PlusStatus CreateTrackedFrame(igsioTrackedFrame& trackedFrame)
+  {
+    FrameSizeType frameSize = { 64, 48, 1 };
+    if (trackedFrame.GetImageData()->AllocateFrame(frameSize, VTK_UNSIGNED_CHAR, 1) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Unable to allocate the image of the tracked frame");
+      return PLUS_FAIL;
+    }
+    trackedFrame.GetImageData()->SetImageOrientation(US_IMG_ORIENT_MF);
+    trackedFrame.GetImageData()->SetImageType(US_IMG_BRIGHTNESS);
+    unsigned char* pixels = static_cast<unsigned char*>(trackedFrame.GetImageData()->GetScalarPointer());
+    for (unsigned int i = 0; i < frameSize[0] * frameSize[1]; ++i)
+    {
+      pixels[i] = static_cast<unsigned char>((i * 7) % 251);
+    }
+
+    trackedFrame.SetTimestamp(FRAME_TIMESTAMP);
+    SetFrameTransform(trackedFrame, "Probe", "Tracker", 10.0);
+    SetFrameTransform(trackedFrame, "Stylus", "Tracker", 20.0);
+    SetFrameTransform(trackedFrame, "Image", "Probe", 30.0);
+    trackedFrame.SetFrameField("Note", "CachedMessageTest");
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  /*! Get the bytes of a packed message as they are sent */
+  std::string GetMessageBytes(igtl::MessageBase* message)
+  {
+    std::vector<igtl::PlusImageMessage::BufferSegment> segments;
+    igtl::PlusImageMessage::GetBufferSegments(message, segments);
+    std::string bytes;
+    for (std::vector<igtl::PlusImageMessage::BufferSegment>::const_iterator segmentIt = segments.begin(); segmentIt != segments.end(); ++segmentIt)
+    {
+      bytes.append(static_cast<const char*>(segmentIt->Data), static_cast<size_t>(segmentIt->Size));
+    }
+    return bytes;
+  }
+
+  //----------------------------------------------------------------------------
+  /*! Pack the messages of the frame for all the clients in order, as the server does */
+  PlusStatus PackMessagesForClients(vtkPlusIgtlMessageFactory* factory, std::vector<PlusIgtlClientInfo>& clientInfos, bool useCache,
+                                    std::vector< std::vector<igtl::MessageBase::Pointer> >& messages, unsigned long& numberOfReusedMessages)
+  {
+    igsioTrackedFrame trackedFrame;
+    if (CreateTrackedFrame(trackedFrame) != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+    vtkSmartPointer<vtkIGSIOTransformRepository> transformRepository = vtkSmartPointer<vtkIGSIOTransformRepository>::New();
+    vtkPlusIgtlMessageFactory::PackedMessageCache messageCache;
+
+    messages.clear();
+    messages.resize(clientInfos.size());
+    for (unsigned int clientIndex = 0; clientIndex < clientInfos.size(); ++clientIndex)
+    {
+      if (factory->PackMessages(clientIndex, clientInfos[clientIndex], messages[clientIndex], trackedFrame, false, transformRepository,
+                                useCache ? &messageCache : NULL) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Failed to pack the messages of client " << clientIndex);
+        return PLUS_FAIL;
+      }
+    }
+    numberOfReusedMessages = messageCache.GetNumberOfReusedMessages();
+    return PLUS_SUCCESS;
+  }
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  int numberOfErrors(0);
+
+  std::vector<PlusIgtlClientInfo> clientInfos(NUMBER_OF_CLIENTS);
+  for (int clientIndex = 0; clientIndex < NUMBER_OF_CLIENTS; ++clientIndex)
+  {
+    if (clientInfos[clientIndex].SetClientInfoFromXmlData(CLIENT_INFO_XML[clientIndex]) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to read the client info of client " << clientIndex);
+      return EXIT_FAILURE;
+    }
+  }
+
+  vtkSmartPointer<vtkPlusIgtlMessageFactory> factory = vtkSmartPointer<vtkPlusIgtlMessageFactory>::New();
+
+  std::vector< std::vector<igtl::MessageBase::Pointer> > perClientMessages;
+  std::vector< std::vector<igtl::MessageBase::Pointer> > cachedMessages;
+  unsigned long numberOfReusedPerClientMessages(0);
+  unsigned long numberOfReusedCachedMessages(0);
+  if (PackMessagesForClients(factory, clientInfos, false, perClientMessages, numberOfReusedPerClientMessages) != PLUS_SUCCESS
+      || PackMessagesForClients(factory, clientInfos, true, cachedMessages, numberOfReusedCachedMessages) != PLUS_SUCCESS)
+  {
+    LOG_INFO("Test failed!");
+    return EXIT_FAILURE;
+  }
+
+  for (int clientIndex = 0; clientIndex < NUMBER_OF_CLIENTS; ++clientIndex)
+  {
+    if (perClientMessages[clientIndex].size() != cachedMessages[clientIndex].size())
+    {
+      LOG_ERROR("Client " << clientIndex << ": number of cached messages (" << cachedMessages[clientIndex].size()
+                << ") differs from the number of messages packed for the client (" << perClientMessages[clientIndex].size() << ")");
+      numberOfErrors++;
+      continue;
+    }
+    for (unsigned int messageIndex = 0; messageIndex < perClientMessages[clientIndex].size(); ++messageIndex)
+    {
+      igtl::MessageBase* perClientMessage = perClientMessages[clientIndex][messageIndex];
+      igtl::MessageBase* cachedMessage = cachedMessages[clientIndex][messageIndex];
+      if (GetMessageBytes(perClientMessage) != GetMessageBytes(cachedMessage))
+      {
+        LOG_ERROR("Client " << clientIndex << ": cached " << cachedMessage->GetMessageType() << " message " << cachedMessage->GetDeviceName()
+                  << " differs from the " << perClientMessage->GetMessageType() << " message " << perClientMessage->GetDeviceName() << " packed for the client");
+        numberOfErrors++;
+      }
+    }
+  }
+
+  // Client C requests the same data as client A, all of its messages are taken from the cache
+  if (numberOfReusedCachedMessages != cachedMessages[2].size())
+  {
+    LOG_ERROR("Number of reused messages is " << numberOfReusedCachedMessages << ", expected " << cachedMessages[2].size());
+    numberOfErrors++;
+  }
+  if (cachedMessages[0].size() == cachedMessages[2].size())
+  {
+    for (unsigned int messageIndex = 0; messageIndex < cachedMessages[0].size(); ++messageIndex)
+    {
+      if (cachedMessages[0][messageIndex] != cachedMessages[2][messageIndex])
+      {
+        LOG_ERROR("The " << cachedMessages[2][messageIndex]->GetMessageType() << " message of client C is not shared with client A");
+        numberOfErrors++;
+      }
+    }
+  }
+  else
+  {
+    LOG_ERROR("Clients A and C received a different number of messages: " << cachedMessages[0].size() << " and " << cachedMessages[2].size());
+    numberOfErrors++;
+  }
+
+  if (numberOfErrors > 0)
+  {
+    LOG_INFO("Test failed!");
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("Test completed successfully!");
+  return EXIT_SUCCESS;
+}
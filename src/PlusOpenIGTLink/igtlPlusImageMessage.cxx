@@ -0,0 +1,155 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+#include "PlusConfigure.h"
+#include "igtlPlusImageMessage.h"
+#include "igtl_header.h"
+#include "igtl_image.h"
+#include "igtl_util.h"
+
+namespace igtl
+{
+
+  //----------------------------------------------------------------------------
+  PlusImageMessage::PlusImageMessage()
+    : ImageMessage()
+    , m_CrcEnabled(true)
+  {
+  }
+
+  //----------------------------------------------------------------------------
+  PlusImageMessage::~PlusImageMessage()
+  {
+  }
+
+  //----------------------------------------------------------------------------
+  PlusStatus PlusImageMessage::SetScalarsReference(vtkImageData* image)
+  {
+    if (image == NULL || image->GetScalarPointer() == NULL)
+    {
+      LOG_ERROR("Unable to reference image scalars - image is invalid");
+      return PLUS_FAIL;
+    }
+
+    igtl_uint64 imageSizeBytes = static_cast<igtl_uint64>(image->GetNumberOfPoints()) * image->GetNumberOfScalarComponents() * image->GetScalarSize();
+    if (imageSizeBytes != static_cast<igtl_uint64>(this->GetSubVolumeImageSize()))
+    {
+      LOG_ERROR("Unable to reference image scalars - image size (" << imageSizeBytes << " bytes) does not match the message subvolume size (" << this->GetSubVolumeImageSize() << " bytes)");
+      return PLUS_FAIL;
+    }
+
+    this->m_ScalarsReference = image;
+    this->AllocateScalars();
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  bool PlusImageMessage::IsScalarsReferenced() const
+  {
+    return this->m_ScalarsReference != NULL;
+  }
+
+  //----------------------------------------------------------------------------
+  void PlusImageMessage::SetCrcEnabled(bool enabled)
+  {
+    this->m_CrcEnabled = enabled;
+  }
+
+  //----------------------------------------------------------------------------
+  bool PlusImageMessage::GetCrcEnabled() const
+  {
+    return this->m_CrcEnabled;
+  }
+
+  //----------------------------------------------------------------------------
+  int PlusImageMessage::CalculateContentBufferSize()
+  {
+    if (this->IsScalarsReferenced())
+    {
+      return IGTL_IMAGE_HEADER_SIZE;
+    }
+    return igtl::ImageMessage::CalculateContentBufferSize();
+  }
+
+  //----------------------------------------------------------------------------
+  unsigned char* PlusImageMessage::GetContentAfterScalars()
+  {
+    if (this->IsScalarsReferenced())
+    {
+      return this->m_ImageHeader + IGTL_IMAGE_HEADER_SIZE;
+    }
+    return this->m_ImageHeader + IGTL_IMAGE_HEADER_SIZE + this->GetSubVolumeImageSize();
+  }
+
+  //----------------------------------------------------------------------------
+  igtl_uint64 PlusImageMessage::GetScalarsOffset()
+  {
+    return static_cast<igtl_uint64>(this->m_ImageHeader + IGTL_IMAGE_HEADER_SIZE - this->m_Header);
+  }
+
+  //----------------------------------------------------------------------------
+  int PlusImageMessage::Pack()
+  {
+    int result = igtl::ImageMessage::Pack();
+    if (!result || !this->IsScalarsReferenced())
+    {
+      return result;
+    }
+
+    // The header was packed from the buffer, which does not contain the pixel data.
+    // Update the body size and the CRC so that they describe the message as it is sent.
+    igtl_uint64 scalarsSize = static_cast<igtl_uint64>(this->GetSubVolumeImageSize());
+    igtl_uint64 bufferBodySize = static_cast<igtl_uint64>(this->GetBufferBodySize());
+    igtl_uint64 scalarsOffsetInBody = this->GetScalarsOffset() - IGTL_HEADER_SIZE;
+
+    igtl_header* header = (igtl_header*)this->m_Header;
+    igtl_header_convert_byte_order(header);
+    header->body_size = bufferBodySize + scalarsSize;
+    if (this->m_CrcEnabled)
+    {
+      igtl_uint64 crc = crc64(0, 0, 0LL);
+      crc = crc64(this->m_Body, scalarsOffsetInBody, crc);
+      crc = crc64(static_cast<unsigned char*>(this->m_ScalarsReference->GetScalarPointer()), scalarsSize, crc);
+      crc = crc64(this->m_Body + scalarsOffsetInBody, bufferBodySize - scalarsOffsetInBody, crc);
+      header->crc = crc;
+    }
+    else
+    {
+      header->crc = 0;
+    }
+    igtl_header_convert_byte_order(header);
+
+    return result;
+  }
+
+  //----------------------------------------------------------------------------
+  void PlusImageMessage::GetBufferSegments(igtl::MessageBase* message, std::vector<BufferSegment>& segments)
+  {
+    segments.clear();
+    if (message == NULL)
+    {
+      return;
+    }
+
+    PlusImageMessage* imageMessage = dynamic_cast<PlusImageMessage*>(message);
+    if (imageMessage == NULL || !imageMessage->IsScalarsReferenced())
+    {
+      segments.push_back(BufferSegment(message->GetBufferPointer(), static_cast<igtl_uint64>(message->GetBufferSize())));
+      return;
+    }
+
+    unsigned char* buffer = static_cast<unsigned char*>(message->GetBufferPointer());
+    igtl_uint64 bufferSize = static_cast<igtl_uint64>(message->GetBufferSize());
+    igtl_uint64 scalarsOffset = imageMessage->GetScalarsOffset();
+    segments.push_back(BufferSegment(buffer, scalarsOffset));
+    segments.push_back(BufferSegment(imageMessage->m_ScalarsReference->GetScalarPointer(), static_cast<igtl_uint64>(imageMessage->GetSubVolumeImageSize())));
+    if (bufferSize > scalarsOffset)
+    {
+      segments.push_back(BufferSegment(buffer + scalarsOffset, bufferSize - scalarsOffset));
+    }
+  }
+
+} //namespace igtl
@@ -0,0 +1,103 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+#ifndef __igtlPlusImageMessage_h
+#define __igtlPlusImageMessage_h
+
+#include "PlusConfigure.h"
+#include "vtkPlusOpenIGTLinkExport.h"
+
+#include "igtlImageMessage.h"
+#include "igtl_types.h"
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkSmartPointer.h>
+
+// STL includes
+#include <vector>
+
+namespace igtl
+{
+  /*!
+    \class PlusImageMessage
+    \brief IGTL image message that can send the pixel data directly from a VTK image
+
+    If the scalars of the message reference an image (see SetScalarsReference) then the pixel data is not copied into
+    the message buffer. The packed buffer contains the header, the image header, and the data that follows the pixel data
+    (e.g., metadata), while the header of the packed message describes the complete message including the pixel data.
+    The message has to be sent by its buffer segments (see GetBufferSegments), for example with a single writev/sendmsg call.
+    The CRC of the message is computed incrementally over the segments, or it is left 0 if CRC is disabled.
+
+    A message that references the scalars of an image cannot be cloned or unpacked.
+
+    \ingroup PlusLibOpenIGTLink
+  */
+  class vtkPlusOpenIGTLinkExport PlusImageMessage: public igtl::ImageMessage
+  {
+  public:
+    igtlTypeMacro(igtl::PlusImageMessage, igtl::ImageMessage);
+    igtlNewMacro(igtl::PlusImageMessage);
+
+    /*! Contiguous part of a packed message */
+    struct BufferSegment
+    {
+      BufferSegment(const void* data, igtl_uint64 size)
+        : Data(data)
+        , Size(size)
+      {
+      }
+      const void* Data;
+      igtl_uint64 Size;
+    };
+
+  public:
+    /*!
+      Send the pixel data from the image instead of copying it into the message buffer.
+      Dimensions, subvolume, scalar type, and number of components of the message must be set before and must match the image.
+      The image is referenced by the message, it must not be modified while the message is in use.
+      Replaces AllocateScalars.
+    */
+    PlusStatus SetScalarsReference(vtkImageData* image);
+
+    /*! Returns true if the pixel data is sent from a referenced image */
+    bool IsScalarsReferenced() const;
+
+    /*!
+      Enable computing the CRC of a message that references the scalars of an image (enabled by default).
+      If the receivers do not check the CRC then it can be disabled to save processing all the pixel data.
+    */
+    void SetCrcEnabled(bool enabled);
+    bool GetCrcEnabled() const;
+
+    /*! Pack the message. If the scalars are referenced then the body size and CRC in the header include the pixel data. */
+    virtual int Pack();
+
+    /*!
+      Get the parts of a packed message in the order they have to be sent.
+      Any message type can be specified, the packed buffer is a single segment unless the message is a PlusImageMessage that references the scalars of an image.
+    */
+    static void GetBufferSegments(igtl::MessageBase* message, std::vector<BufferSegment>& segments);
+
+  protected:
+    PlusImageMessage();
+    ~PlusImageMessage();
+
+    /*! Does not include the size of the pixel data if the scalars are referenced */
+    virtual int CalculateContentBufferSize();
+
+    /*! Get the pointer to the content that follows the pixel data in the message buffer */
+    unsigned char* GetContentAfterScalars();
+
+    /*! Offset of the pixel data in the complete message (from the beginning of the header) */
+    igtl_uint64 GetScalarsOffset();
+
+    vtkSmartPointer<vtkImageData> m_ScalarsReference;
+    bool m_CrcEnabled;
+  };
+}
+
+#endif
@@ -47,7 +47,7 @@ namespace igtl
 
   //----------------------------------------------------------------------------
   PlusUsMessage::PlusUsMessage()
-    : ImageMessage()
+    : PlusImageMessage()
   {
     this->m_SendMessageType = "USMESSAGE";
   }
@@ -96,8 +96,28 @@ namespace igtl
   PlusStatus PlusUsMessage::SetTrackedFrame(const igsioTrackedFrame& trackedFrame)
   {
     this->m_TrackedFrame = trackedFrame;
+    this->SetMessageContent(this->m_TrackedFrame);
+    this->AllocateScalars();
+
+    unsigned char* igtlImagePointer = (unsigned char*)(this->GetScalarPointer());
+    unsigned char* plusImagePointer = (unsigned char*)(this->m_TrackedFrame.GetImageData()->GetScalarPointer());
+
+    memcpy(igtlImagePointer, plusImagePointer, this->GetImageSize());
+
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  PlusStatus PlusUsMessage::SetTrackedFrameImageReference(igsioTrackedFrame& trackedFrame)
+  {
+    this->SetMessageContent(trackedFrame);
+    return this->SetScalarsReference(trackedFrame.GetImageData()->GetImage());
+  }
 
-    double timestamp = this->m_TrackedFrame.GetTimestamp();
+  //----------------------------------------------------------------------------
+  void PlusUsMessage::SetMessageContent(igsioTrackedFrame& trackedFrame)
+  {
+    double timestamp = trackedFrame.GetTimestamp();
 
     igtl::TimeStamp::Pointer igtlFrameTime = igtl::TimeStamp::New();
     igtlFrameTime->SetTime(timestamp);
@@ -108,132 +128,123 @@ namespace igtl
     // NOTE: MUSiiC library expects the frame size in the format
     // as Ultrasonix provide, not like Plus (Plus: if vector data switch width and
     // height, because the image is not rasterized like a bitmap, but written rayline by rayline)
-    FrameSizeType size = this->m_TrackedFrame.GetFrameSize();
+    FrameSizeType size = trackedFrame.GetFrameSize();
     imageSizePixels[0] = size[1];
     imageSizePixels[1] = size[0];
     imageSizePixels[2] = 1;
 
-    int scalarType = PlusCommon::GetIGTLScalarPixelTypeFromVTK(this->m_TrackedFrame.GetImageData()->GetVTKScalarPixelType());
+    int scalarType = PlusCommon::GetIGTLScalarPixelTypeFromVTK(trackedFrame.GetImageData()->GetVTKScalarPixelType());
 
     this->SetDimensions(static_cast<int>(imageSizePixels[0]), static_cast<int>(imageSizePixels[1]), static_cast<int>(imageSizePixels[2]));
     this->SetSubVolume(static_cast<int>(imageSizePixels[0]), static_cast<int>(imageSizePixels[1]), static_cast<int>(imageSizePixels[2]), offset[0], offset[1], offset[2]);
     this->SetScalarType(scalarType);
     this->SetSpacing(0.2, 0.2, 1);
-    this->AllocateScalars();
-
-    unsigned char* igtlImagePointer = (unsigned char*)(this->GetScalarPointer());
-    unsigned char* plusImagePointer = (unsigned char*)(this->m_TrackedFrame.GetImageData()->GetScalarPointer());
-
-    memcpy(igtlImagePointer, plusImagePointer, this->GetImageSize());
-
     this->SetTimeStamp(igtlFrameTime);
 
     this->m_MessageHeader.m_DataType = 0;
-    if (this->m_TrackedFrame.IsFrameFieldDefined("SonixDataType"))
+    if (trackedFrame.IsFrameFieldDefined("SonixDataType"))
     {
-      std::string fieldValue = this->m_TrackedFrame.GetFrameField("SonixDataType");
+      std::string fieldValue = trackedFrame.GetFrameField("SonixDataType");
       igsioCommon::StringToNumber<igtl_int32>(fieldValue, this->m_MessageHeader.m_DataType);
     }
 
     this->m_MessageHeader.m_TransmitFrequency = 0;
-    if (this->m_TrackedFrame.IsFrameFieldDefined("SonixTransmitFrequency"))
+    if (trackedFrame.IsFrameFieldDefined("SonixTransmitFrequency"))
     {
-      std::string fieldValue = this->m_TrackedFrame.GetFrameField("SonixTransmitFrequency");
+      std::string fieldValue = trackedFrame.GetFrameField("SonixTransmitFrequency");
       igsioCommon::StringToNumber<igtl_int32>(fieldValue, this->m_MessageHeader.m_TransmitFrequency);
     }
 
     this->m_MessageHeader.m_SamplingFrequency = 0;
-    if (this->m_TrackedFrame.IsFrameFieldDefined("SonixSamplingFrequency"))
+    if (trackedFrame.IsFrameFieldDefined("SonixSamplingFrequency"))
     {
-      std::string fieldValue = this->m_TrackedFrame.GetFrameField("SonixSamplingFrequency");
+      std::string fieldValue = trackedFrame.GetFrameField("SonixSamplingFrequency");
       igsioCommon::StringToNumber<igtl_int32>(fieldValue, this->m_MessageHeader.m_SamplingFrequency);
     }
 
     this->m_MessageHeader.m_DataRate = 0;
-    if (this->m_TrackedFrame.IsFrameFieldDefined("SonixDataRate"))
+    if (trackedFrame.IsFrameFieldDefined("SonixDataRate"))
     {
-      std::string fieldValue = this->m_TrackedFrame.GetFrameField("SonixDataRate");
+      std::string fieldValue = trackedFrame.GetFrameField("SonixDataRate");
       igsioCommon::StringToNumber<igtl_int32>(fieldValue, this->m_MessageHeader.m_DataRate);
     }
 
     this->m_MessageHeader.m_LineDensity = 0;
-    if (this->m_TrackedFrame.IsFrameFieldDefined("SonixLineDensity"))
+    if (trackedFrame.IsFrameFieldDefined("SonixLineDensity"))
     {
-      std::string fieldValue = this->m_TrackedFrame.GetFrameField("SonixLineDensity");
+      std::string fieldValue = trackedFrame.GetFrameField("SonixLineDensity");
       igsioCommon::StringToNumber<igtl_int32>(fieldValue, this->m_MessageHeader.m_LineDensity);
     }
 
     this->m_MessageHeader.m_SteeringAngle = 0;
-    if (this->m_TrackedFrame.IsFrameFieldDefined("SonixSteeringAngle"))
+    if (trackedFrame.IsFrameFieldDefined("SonixSteeringAngle"))
     {
-      std::string fieldValue = this->m_TrackedFrame.GetFrameField("SonixSteeringAngle");
+      std::string fieldValue = trackedFrame.GetFrameField("SonixSteeringAngle");
       igsioCommon::StringToNumber<igtl_int32>(fieldValue, this->m_MessageHeader.m_SteeringAngle);
     }
 
     this->m_MessageHeader.m_ProbeID = 0;
-    if (this->m_TrackedFrame.IsFrameFieldDefined("SonixProbeID"))
+    if (trackedFrame.IsFrameFieldDefined("SonixProbeID"))
     {
-      std::string fieldValue = this->m_TrackedFrame.GetFrameField("SonixProbeID");
+      std::string fieldValue = trackedFrame.GetFrameField("SonixProbeID");
       igsioCommon::StringToNumber<igtl_int32>(fieldValue, this->m_MessageHeader.m_ProbeID);
     }
 
     this->m_MessageHeader.m_ExtensionAngle = 0;
-    if (this->m_TrackedFrame.IsFrameFieldDefined("SonixExtensionAngle"))
+    if (trackedFrame.IsFrameFieldDefined("SonixExtensionAngle"))
     {
-      std::string fieldValue = this->m_TrackedFrame.GetFrameField("SonixExtensionAngle");
+      std::string fieldValue = trackedFrame.GetFrameField("SonixExtensionAngle");
       igsioCommon::StringToNumber<igtl_int32>(fieldValue, this->m_MessageHeader.m_ExtensionAngle);
     }
 
     this->m_MessageHeader.m_Elements = 0;
-    if (this->m_TrackedFrame.IsFrameFieldDefined("SonixElements"))
+    if (trackedFrame.IsFrameFieldDefined("SonixElements"))
     {
-      std::string fieldValue = this->m_TrackedFrame.GetFrameField("SonixElements");
+      std::string fieldValue = trackedFrame.GetFrameField("SonixElements");
       igsioCommon::StringToNumber<igtl_int32>(fieldValue, this->m_MessageHeader.m_Elements);
     }
 
     this->m_MessageHeader.m_Pitch = 0;
-    if (this->m_TrackedFrame.IsFrameFieldDefined("SonixPitch"))
+    if (trackedFrame.IsFrameFieldDefined("SonixPitch"))
     {
-      std::string fieldValue = this->m_TrackedFrame.GetFrameField("SonixPitch");
+      std::string fieldValue = trackedFrame.GetFrameField("SonixPitch");
       igsioCommon::StringToNumber<igtl_int32>(fieldValue, this->m_MessageHeader.m_Pitch);
     }
 
     this->m_MessageHeader.m_Radius = 0;
-    if (this->m_TrackedFrame.IsFrameFieldDefined("SonixRadius"))
+    if (trackedFrame.IsFrameFieldDefined("SonixRadius"))
     {
-      std::string fieldValue = this->m_TrackedFrame.GetFrameField("SonixRadius");
+      std::string fieldValue = trackedFrame.GetFrameField("SonixRadius");
       igsioCommon::StringToNumber<igtl_int32>(fieldValue, this->m_MessageHeader.m_Radius);
     }
 
     this->m_MessageHeader.m_ProbeAngle = 0;
-    if (this->m_TrackedFrame.IsFrameFieldDefined("SonixProbeAngle"))
+    if (trackedFrame.IsFrameFieldDefined("SonixProbeAngle"))
     {
-      std::string fieldValue = this->m_TrackedFrame.GetFrameField("SonixProbeAngle");
+      std::string fieldValue = trackedFrame.GetFrameField("SonixProbeAngle");
       igsioCommon::StringToNumber<igtl_int32>(fieldValue, this->m_MessageHeader.m_ProbeAngle);
     }
 
     this->m_MessageHeader.m_TxOffset = 0;
-    if (this->m_TrackedFrame.IsFrameFieldDefined("SonixTxOffset"))
+    if (trackedFrame.IsFrameFieldDefined("SonixTxOffset"))
     {
-      std::string fieldValue = this->m_TrackedFrame.GetFrameField("SonixTxOffset");
+      std::string fieldValue = trackedFrame.GetFrameField("SonixTxOffset");
       igsioCommon::StringToNumber<igtl_int32>(fieldValue, this->m_MessageHeader.m_TxOffset);
     }
-
-    return PLUS_SUCCESS;
   }
 
   //----------------------------------------------------------------------------
   int PlusUsMessage::CalculateContentBufferSize()
   {
-    return GetSubVolumeImageSize() + IGTL_IMAGE_HEADER_SIZE + this->m_MessageHeader.GetMessageHeaderSize();
+    return igtl::PlusImageMessage::CalculateContentBufferSize() + this->m_MessageHeader.GetMessageHeaderSize();
   }
 
   //----------------------------------------------------------------------------
   int PlusUsMessage::PackContent()
   {
-    igtl::ImageMessage::PackContent();
+    igtl::PlusImageMessage::PackContent();
 
-    MessageHeader* header = (MessageHeader*)(m_Image + GetSubVolumeImageSize());
+    MessageHeader* header = (MessageHeader*)(this->GetContentAfterScalars());
     header->m_DataType = this->m_MessageHeader.m_DataType;
     header->m_TransmitFrequency = this->m_MessageHeader.m_TransmitFrequency;
     header->m_SamplingFrequency = this->m_MessageHeader.m_SamplingFrequency;
@@ -259,9 +270,9 @@ namespace igtl
   //----------------------------------------------------------------------------
   int PlusUsMessage::UnpackContent()
   {
-    igtl::ImageMessage::UnpackContent();
+    igtl::PlusImageMessage::UnpackContent();
 
-    MessageHeader* header = (MessageHeader*)(m_Image + GetSubVolumeImageSize());
+    MessageHeader* header = (MessageHeader*)(this->GetContentAfterScalars());
 
     // Convert header endian
     header->ConvertEndianness();
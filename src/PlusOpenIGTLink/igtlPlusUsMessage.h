@@ -8,7 +8,7 @@ See License.txt for details.
 
 #include "vtkPlusOpenIGTLinkExport.h"
 
-#include "igtlImageMessage.h"
+#include "igtlPlusImageMessage.h"
 #include "igtl_types.h"
 
 class igsioTrackedFrame; 
@@ -19,12 +19,13 @@ namespace igtl
   \class PlusUsMessage 
   \brief IGTL message helper class for sending USMessage device messages 
   as IMAGE type message from tracked frame (for MUSiiC igtlMUSMessage)
+  The pixel data can be sent directly from the tracked frame image (see SetTrackedFrameImageReference).
   \ingroup PlusLibOpenIGTLink
   */
-  class vtkPlusOpenIGTLinkExport PlusUsMessage: public igtl::ImageMessage
+  class vtkPlusOpenIGTLinkExport PlusUsMessage: public igtl::PlusImageMessage
   {
   public:
-    igtlTypeMacro(igtl::PlusUsMessage, igtl::ImageMessage);
+    igtlTypeMacro(igtl::PlusUsMessage, igtl::PlusImageMessage);
     igtlNewMacro(igtl::PlusUsMessage);
 
   public:
@@ -34,6 +35,12 @@ namespace igtl
     /*! Set Plus TrackedFrame */ 
     PlusStatus SetTrackedFrame( const igsioTrackedFrame& trackedFrame); 
 
+    /*!
+      Set the message content from a tracked frame without copying the frame or its pixel data.
+      The message references the image of the tracked frame, GetTrackedFrame does not return the frame.
+    */
+    PlusStatus SetTrackedFrameImageReference(igsioTrackedFrame& trackedFrame);
+
     /*! Get Plus TrackedFrame */ 
     igsioTrackedFrame& GetTrackedFrame(); 
 
@@ -65,6 +72,9 @@ namespace igtl
     virtual int PackContent();
     virtual int UnpackContent();
 
+    /*! Set the image geometry, timestamp, and ultrasound parameters of the message from a tracked frame */
+    void SetMessageContent(igsioTrackedFrame& trackedFrame);
+
     PlusUsMessage();
     ~PlusUsMessage();
 
@@ -170,7 +170,7 @@ PlusStatus vtkPlusIgtlMessageCommon::PackUsMessage(igtl::PlusUsMessage::Pointer
     return PLUS_FAIL;
   }
 
-  PlusStatus status = usMessage->SetTrackedFrame(trackedFrame);
+  PlusStatus status = usMessage->SetTrackedFrameImageReference(trackedFrame);
   usMessage->Pack();
 
   return status;
@@ -273,12 +273,27 @@ PlusStatus vtkPlusIgtlMessageCommon::PackImageMessage(igtl::ImageMessage::Pointe
   imageMessage->SetScalarType(scalarType);
   imageMessage->SetEndian(igtl_is_little_endian() ? igtl::ImageMessage::ENDIAN_LITTLE : igtl::ImageMessage::ENDIAN_BIG);
   imageMessage->SetSubVolume(subSizePixels, subOffset);
-  imageMessage->AllocateScalars();
 
-  unsigned char* igtlImagePointer = (unsigned char*)(imageMessage->GetScalarPointer());
-  unsigned char* vtkImagePointer = (unsigned char*)(frameImage->GetScalarPointer());
+  // The pixel data can be sent from the image without copying if the image is not modified later:
+  // it is the image of the tracked frame, or it was created by a temporary frame converter
+  igtl::PlusImageMessage* plusImageMessage = dynamic_cast<igtl::PlusImageMessage*>(imageMessage.GetPointer());
+  if (plusImageMessage != NULL && (frameConverter == NULL || frameImage.GetPointer() == trackedFrame.GetImageData()->GetImage()))
+  {
+    if (plusImageMessage->SetScalarsReference(frameImage) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to pack image message - unable to reference image data");
+      return PLUS_FAIL;
+    }
+  }
+  else
+  {
+    imageMessage->AllocateScalars();
 
-  memcpy(igtlImagePointer, vtkImagePointer, imageMessage->GetImageSize());
+    unsigned char* igtlImagePointer = (unsigned char*)(imageMessage->GetScalarPointer());
+    unsigned char* vtkImagePointer = (unsigned char*)(frameImage->GetScalarPointer());
+
+    memcpy(igtlImagePointer, vtkImagePointer, imageMessage->GetImageSize());
+  }
 
   // Convert VTK transform to IGTL transform.
   if (igtlioImageConverter::VTKTransformToIGTLImage(matrix, imageSizePixels, imageSpacingMm, imageOriginMm, imageMessage) != 1)
@@ -288,7 +303,14 @@ PlusStatus vtkPlusIgtlMessageCommon::PackImageMessage(igtl::ImageMessage::Pointe
   }
 
   imageMessage->SetTimeStamp(igtlFrameTime);
-  imageMessage->Pack();
+  if (plusImageMessage != NULL)
+  {
+    plusImageMessage->Pack();
+  }
+  else
+  {
+    imageMessage->Pack();
+  }
 
   return PLUS_SUCCESS;
 }
@@ -18,6 +18,7 @@ See License.txt for details.
 #include <igtlImageMessage.h>
 #include <igtlImageMetaMessage.h>
 #include <igtlMessageBase.h>
+#include <igtlPlusImageMessage.h>
 #include <igtlPlusTrackedFrameMessage.h>
 #include <igtlPlusUsMessage.h>
 #include <igtlPolyDataMessage.h>
@@ -58,13 +59,17 @@ public:
   /*! Unpack tracked frame message to tracked frame */
   static PlusStatus UnpackTrackedFrameMessage(igtl::MessageHeader::Pointer headerMsg, igtl::Socket* socket, igsioTrackedFrame& trackedFrame, const igsioTransformName& embeddedTransformName, int crccheck);
 
-  /*! Pack US message from tracked frame */
+  /*! Pack US message from tracked frame. The pixel data is sent directly from the image of the tracked frame. */
   static PlusStatus PackUsMessage(igtl::PlusUsMessage::Pointer usMessage, igsioTrackedFrame& trackedFrame);
 
   /*! Unpack US message to tracked frame */
   static PlusStatus UnpackUsMessage(igtl::MessageHeader::Pointer headerMsg, igtl::Socket* socket, igsioTrackedFrame& trackedFrame, int crccheck);
 
-  /*! Pack image message from tracked frame */
+  /*!
+    Pack image message from tracked frame.
+    If the message is an igtl::PlusImageMessage then the pixel data is sent directly from the image of the tracked frame
+    (or from the converted image if it is not reused by the frame converter) instead of copying it into the message.
+  */
   static PlusStatus PackImageMessage(igtl::ImageMessage::Pointer imageMessage, igsioTrackedFrame& trackedFrame, const vtkMatrix4x4& imageToReferenceTransform, vtkIGSIOFrameConverter* frameConverter = NULL);
 
   /*! Pack image message from vtkImageData volume */
@@ -24,6 +24,7 @@ See License.txt for details.
 #include "igtlCommandMessage.h"
 #include "igtlImageMessage.h"
 #include "igtlPlusClientInfoMessage.h"
+#include "igtlPlusImageMessage.h"
 #include "igtlPlusTrackedFrameMessage.h"
 #include "igtlPlusUsMessage.h"
 #include "igtlPositionMessage.h"
@@ -140,14 +141,18 @@ igtl::MessageBase::Pointer vtkPlusIgtlMessageFactory::CreateSendMessage(const st
 
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusIgtlMessageFactory::PackMessages(int clientId, const PlusIgtlClientInfo& clientInfo, std::vector<igtl::MessageBase::Pointer>& igtlMessages, igsioTrackedFrame& trackedFrame,
-    bool packValidTransformsOnly, vtkIGSIOTransformRepository* transformRepository/*=NULL*/)
+    bool packValidTransformsOnly, vtkIGSIOTransformRepository* transformRepository/*=NULL*/, PackedMessageCache* messageCache/*=NULL*/)
 {
   int numberOfErrors(0);
   igtlMessages.clear();
 
-  if (transformRepository != NULL)
+  if (transformRepository != NULL && (messageCache == NULL || !messageCache->TransformRepositoryUpdated))
   {
     transformRepository->SetTransforms(trackedFrame);
+    if (messageCache != NULL)
+    {
+      messageCache->TransformRepositoryUpdated = true;
+    }
   }
 
   for (std::vector<std::string>::const_iterator messageTypeIterator = clientInfo.IgtlMessageTypes.begin(); messageTypeIterator != clientInfo.IgtlMessageTypes.end(); ++ messageTypeIterator)
@@ -173,37 +178,37 @@ PlusStatus vtkPlusIgtlMessageFactory::PackMessages(int clientId, const PlusIgtlC
 
     if (typeid(*igtlMessage) == typeid(igtl::ImageMessage))
     {
-      numberOfErrors += PackImageMessage(clientInfo, *transformRepository, messageType, igtlMessage, trackedFrame, igtlMessages, clientId);
+      numberOfErrors += PackImageMessage(clientInfo, *transformRepository, messageType, igtlMessage, trackedFrame, igtlMessages, clientId, messageCache);
     }
 #if defined(OpenIGTLink_ENABLE_VIDEOSTREAMING)
     else if (typeid(*igtlMessage) == typeid(igtl::VideoMessage))
     {
-      numberOfErrors += PackVideoMessage(clientInfo, *transformRepository, messageType, igtlMessage, trackedFrame, igtlMessages, clientId);
+      numberOfErrors += PackVideoMessage(clientInfo, *transformRepository, messageType, igtlMessage, trackedFrame, igtlMessages, clientId, messageCache);
     }
 #endif
     else if (typeid(*igtlMessage) == typeid(igtl::TransformMessage))
     {
-      numberOfErrors += PackTransformMessage(clientInfo, *transformRepository, packValidTransformsOnly, igtlMessage, trackedFrame, igtlMessages);
+      numberOfErrors += PackTransformMessage(clientInfo, *transformRepository, packValidTransformsOnly, igtlMessage, trackedFrame, igtlMessages, messageCache);
     }
     else if (typeid(*igtlMessage) == typeid(igtl::TrackingDataMessage))
     {
-      numberOfErrors += PackTrackingDataMessage(clientInfo, trackedFrame, *transformRepository, packValidTransformsOnly, igtlMessage, igtlMessages);
+      numberOfErrors += PackTrackingDataMessage(clientInfo, trackedFrame, *transformRepository, packValidTransformsOnly, igtlMessage, igtlMessages, messageCache);
     }
     else if (typeid(*igtlMessage) == typeid(igtl::PositionMessage))
     {
-      numberOfErrors += PackPositionMessage(clientInfo, *transformRepository, igtlMessage, trackedFrame, igtlMessages);
+      numberOfErrors += PackPositionMessage(clientInfo, *transformRepository, igtlMessage, trackedFrame, igtlMessages, messageCache);
     }
     else if (typeid(*igtlMessage) == typeid(igtl::PlusTrackedFrameMessage))
     {
-      numberOfErrors += PackTrackedFrameMessage(igtlMessage, clientInfo, *transformRepository, trackedFrame, igtlMessages);
+      numberOfErrors += PackTrackedFrameMessage(igtlMessage, clientInfo, *transformRepository, trackedFrame, igtlMessages, messageCache);
     }
     else if (typeid(*igtlMessage) == typeid(igtl::PlusUsMessage))
     {
-      numberOfErrors += PackUsMessage(igtlMessage, trackedFrame, igtlMessages);
+      numberOfErrors += PackUsMessage(clientInfo, igtlMessage, trackedFrame, igtlMessages, messageCache);
     }
     else if (typeid(*igtlMessage) == typeid(igtl::StringMessage))
     {
-      numberOfErrors += PackStringMessage(clientInfo, trackedFrame, igtlMessage, igtlMessages);
+      numberOfErrors += PackStringMessage(clientInfo, trackedFrame, igtlMessage, igtlMessages, messageCache);
     }
     else if (typeid(*igtlMessage) == typeid(igtl::CommandMessage))
     {
@@ -218,6 +223,51 @@ PlusStatus vtkPlusIgtlMessageFactory::PackMessages(int clientId, const PlusIgtlC
   return (numberOfErrors == 0 ? PLUS_SUCCESS : PLUS_FAIL);
 }
 
+//----------------------------------------------------------------------------
+std::string vtkPlusIgtlMessageFactory::GetMessageCacheKey(const std::string& messageType, int headerVersion, const std::string& contentName/*=""*/)
+{
+  std::ostringstream key;
+  key << messageType << "|" << headerVersion << "|" << contentName;
+  return key.str();
+}
+
+//----------------------------------------------------------------------------
+bool vtkPlusIgtlMessageFactory::AddCachedMessage(PackedMessageCache* messageCache, const std::string& key, std::vector<igtl::MessageBase::Pointer>& igtlMessages)
+{
+  if (messageCache == NULL)
+  {
+    return false;
+  }
+  std::map<std::string, igtl::MessageBase::Pointer>::iterator messageIt = messageCache->Messages.find(key);
+  if (messageIt == messageCache->Messages.end())
+  {
+    return false;
+  }
+  igtlMessages.push_back(messageIt->second);
+  messageCache->NumberOfReusedMessages++;
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusIgtlMessageFactory::CacheMessage(PackedMessageCache* messageCache, const std::string& key, igtl::MessageBase::Pointer igtlMessage)
+{
+  if (messageCache != NULL)
+  {
+    messageCache->Messages[key] = igtlMessage;
+  }
+}
+
+//----------------------------------------------------------------------------
+std::string vtkPlusIgtlMessageFactory::GetTransformNamesCacheKey(const std::vector<igsioTransformName>& transformNames)
+{
+  std::ostringstream key;
+  for (std::vector<igsioTransformName>::const_iterator nameIter = transformNames.begin(); nameIter != transformNames.end(); ++nameIter)
+  {
+    key << nameIter->GetTransformName() << ";";
+  }
+  return key.str();
+}
+
 //----------------------------------------------------------------------------
 int vtkPlusIgtlMessageFactory::PackCommandMessage(igtl::MessageBase::Pointer igtlMessage, std::vector<igtl::MessageBase::Pointer>& igtlMessages)
 {
@@ -230,10 +280,15 @@ int vtkPlusIgtlMessageFactory::PackCommandMessage(igtl::MessageBase::Pointer igt
 }
 
 //----------------------------------------------------------------------------
-int vtkPlusIgtlMessageFactory::PackStringMessage(const PlusIgtlClientInfo& clientInfo, igsioTrackedFrame& trackedFrame, igtl::MessageBase::Pointer igtlMessage, std::vector<igtl::MessageBase::Pointer>& igtlMessages)
+int vtkPlusIgtlMessageFactory::PackStringMessage(const PlusIgtlClientInfo& clientInfo, igsioTrackedFrame& trackedFrame, igtl::MessageBase::Pointer igtlMessage, std::vector<igtl::MessageBase::Pointer>& igtlMessages, PackedMessageCache* messageCache/*=NULL*/)
 {
   for (std::vector<std::string>::const_iterator stringNameIterator = clientInfo.StringNames.begin(); stringNameIterator != clientInfo.StringNames.end(); ++stringNameIterator)
   {
+    std::string cacheKey = GetMessageCacheKey(igtlMessage->GetMessageType(), igtlMessage->GetHeaderVersion(), *stringNameIterator);
+    if (AddCachedMessage(messageCache, cacheKey, igtlMessages))
+    {
+      continue;
+    }
     std::string stringValue = trackedFrame.GetFrameField(*stringNameIterator);
     if (stringValue.empty())
     {
@@ -243,15 +298,23 @@ int vtkPlusIgtlMessageFactory::PackStringMessage(const PlusIgtlClientInfo& clien
     igtl::StringMessage::Pointer stringMessage = dynamic_cast<igtl::StringMessage*>(igtlMessage->Clone().GetPointer());
     vtkPlusIgtlMessageCommon::PackStringMessage(stringMessage, *stringNameIterator, stringValue, trackedFrame.GetTimestamp());
     igtlMessages.push_back(stringMessage.GetPointer());
+    CacheMessage(messageCache, cacheKey, stringMessage.GetPointer());
   }
   return 0; // message type does not produce errors
 }
 
 //----------------------------------------------------------------------------
-int vtkPlusIgtlMessageFactory::PackUsMessage(igtl::MessageBase::Pointer igtlMessage, igsioTrackedFrame& trackedFrame, std::vector<igtl::MessageBase::Pointer>& igtlMessages)
+int vtkPlusIgtlMessageFactory::PackUsMessage(const PlusIgtlClientInfo& clientInfo, igtl::MessageBase::Pointer igtlMessage, igsioTrackedFrame& trackedFrame, std::vector<igtl::MessageBase::Pointer>& igtlMessages, PackedMessageCache* messageCache/*=NULL*/)
 {
   int numberOfErrors(0);
+  // Clients that do not check the CRC get a message without CRC
+  std::string cacheKey = GetMessageCacheKey(igtlMessage->GetMessageType(), igtlMessage->GetHeaderVersion(), clientInfo.GetImageCrcEnabled() ? "" : "NoCrc");
+  if (AddCachedMessage(messageCache, cacheKey, igtlMessages))
+  {
+    return numberOfErrors;
+  }
   igtl::PlusUsMessage::Pointer usMessage = dynamic_cast<igtl::PlusUsMessage*>(igtlMessage->Clone().GetPointer());
+  usMessage->SetCrcEnabled(clientInfo.GetImageCrcEnabled());
   if (vtkPlusIgtlMessageCommon::PackUsMessage(usMessage, trackedFrame) != PLUS_SUCCESS)
   {
     LOG_ERROR("Failed to pack IGT messages - unable to pack US message");
@@ -259,13 +322,21 @@ int vtkPlusIgtlMessageFactory::PackUsMessage(igtl::MessageBase::Pointer igtlMess
     return numberOfErrors;
   }
   igtlMessages.push_back(usMessage.GetPointer());
+  CacheMessage(messageCache, cacheKey, usMessage.GetPointer());
   return numberOfErrors;
 }
 
 //----------------------------------------------------------------------------
-int vtkPlusIgtlMessageFactory::PackTrackedFrameMessage(igtl::MessageBase::Pointer igtlMessage, const PlusIgtlClientInfo& clientInfo, vtkIGSIOTransformRepository& transformRepository, igsioTrackedFrame& trackedFrame, std::vector<igtl::MessageBase::Pointer>& igtlMessages)
+int vtkPlusIgtlMessageFactory::PackTrackedFrameMessage(igtl::MessageBase::Pointer igtlMessage, const PlusIgtlClientInfo& clientInfo, vtkIGSIOTransformRepository& transformRepository, igsioTrackedFrame& trackedFrame, std::vector<igtl::MessageBase::Pointer>& igtlMessages, PackedMessageCache* messageCache/*=NULL*/)
 {
   int numberOfErrors(0);
+  // The message contains the requested transforms and the image with the embedded transform of the first image stream
+  std::string embeddedTransformName = clientInfo.ImageStreams.empty() ? "" : igsioTransformName(clientInfo.ImageStreams[0].Name, clientInfo.ImageStreams[0].EmbeddedTransformToFrame).GetTransformName();
+  std::string cacheKey = GetMessageCacheKey(igtlMessage->GetMessageType(), igtlMessage->GetHeaderVersion(), GetTransformNamesCacheKey(clientInfo.TransformNames) + "|" + embeddedTransformName);
+  if (AddCachedMessage(messageCache, cacheKey, igtlMessages))
+  {
+    return numberOfErrors;
+  }
   igtl::PlusTrackedFrameMessage::Pointer trackedFrameMessage = dynamic_cast<igtl::PlusTrackedFrameMessage*>(igtlMessage->Clone().GetPointer());
 
   for (auto nameIter = clientInfo.TransformNames.begin(); nameIter != clientInfo.TransformNames.end(); ++nameIter)
@@ -296,14 +367,21 @@ int vtkPlusIgtlMessageFactory::PackTrackedFrameMessage(igtl::MessageBase::Pointe
     return numberOfErrors;
   }
   igtlMessages.push_back(trackedFrameMessage.GetPointer());
+  CacheMessage(messageCache, cacheKey, trackedFrameMessage.GetPointer());
   return numberOfErrors;
 }
 
 //----------------------------------------------------------------------------
-int vtkPlusIgtlMessageFactory::PackPositionMessage(const PlusIgtlClientInfo& clientInfo, vtkIGSIOTransformRepository& transformRepository, igtl::MessageBase::Pointer igtlMessage, igsioTrackedFrame& trackedFrame, std::vector<igtl::MessageBase::Pointer>& igtlMessages)
+int vtkPlusIgtlMessageFactory::PackPositionMessage(const PlusIgtlClientInfo& clientInfo, vtkIGSIOTransformRepository& transformRepository, igtl::MessageBase::Pointer igtlMessage, igsioTrackedFrame& trackedFrame, std::vector<igtl::MessageBase::Pointer>& igtlMessages, PackedMessageCache* messageCache/*=NULL*/)
 {
   for (std::vector<igsioTransformName>::const_iterator transformNameIterator = clientInfo.TransformNames.begin(); transformNameIterator != clientInfo.TransformNames.end(); ++transformNameIterator)
   {
+    std::string cacheKey = GetMessageCacheKey(igtlMessage->GetMessageType(), igtlMessage->GetHeaderVersion(), transformNameIterator->GetTransformName());
+    if (AddCachedMessage(messageCache, cacheKey, igtlMessages))
+    {
+      continue;
+    }
+
     /*
       Advantage of using position message type:
       Although equivalent position and orientation can be described with the TRANSFORM data type,
@@ -325,13 +403,14 @@ int vtkPlusIgtlMessageFactory::PackPositionMessage(const PlusIgtlClientInfo& cli
     igtl::PositionMessage::Pointer positionMessage = dynamic_cast<igtl::PositionMessage*>(igtlMessage->Clone().GetPointer());
     vtkPlusIgtlMessageCommon::PackPositionMessage(positionMessage, transformName, status, position, quaternion, trackedFrame.GetTimestamp());
     igtlMessages.push_back(positionMessage.GetPointer());
+    CacheMessage(messageCache, cacheKey, positionMessage.GetPointer());
   }
 
   return 0; // no errors possible with this message type
 }
 
 //----------------------------------------------------------------------------
-int vtkPlusIgtlMessageFactory::PackTrackingDataMessage(const PlusIgtlClientInfo& clientInfo, igsioTrackedFrame& trackedFrame, vtkIGSIOTransformRepository& transformRepository, bool packValidTransformsOnly, igtl::MessageBase::Pointer igtlMessage, std::vector<igtl::MessageBase::Pointer>& igtlMessages)
+int vtkPlusIgtlMessageFactory::PackTrackingDataMessage(const PlusIgtlClientInfo& clientInfo, igsioTrackedFrame& trackedFrame, vtkIGSIOTransformRepository& transformRepository, bool packValidTransformsOnly, igtl::MessageBase::Pointer igtlMessage, std::vector<igtl::MessageBase::Pointer>& igtlMessages, PackedMessageCache* messageCache/*=NULL*/)
 {
   if (clientInfo.GetTDATARequested() && clientInfo.GetLastTDATASentTimeStamp() + clientInfo.GetTDATAResolution() < trackedFrame.GetTimestamp())
   {
@@ -355,15 +434,22 @@ int vtkPlusIgtlMessageFactory::PackTrackingDataMessage(const PlusIgtlClientInfo&
       names.push_back(transformName);
     }
 
+    std::string cacheKey = GetMessageCacheKey(igtlMessage->GetMessageType(), igtlMessage->GetHeaderVersion(), GetTransformNamesCacheKey(names));
+    if (AddCachedMessage(messageCache, cacheKey, igtlMessages))
+    {
+      return 0;
+    }
+
     igtl::TrackingDataMessage::Pointer trackingDataMessage = dynamic_cast<igtl::TrackingDataMessage*>(igtlMessage->Clone().GetPointer());
     vtkPlusIgtlMessageCommon::PackTrackingDataMessage(trackingDataMessage, names, transformRepository, trackedFrame.GetTimestamp());
     igtlMessages.push_back(trackingDataMessage.GetPointer());
+    CacheMessage(messageCache, cacheKey, trackingDataMessage.GetPointer());
   }
   return 0; // no errors possible for this message type
 }
 
 //----------------------------------------------------------------------------
-int vtkPlusIgtlMessageFactory::PackTransformMessage(const PlusIgtlClientInfo& clientInfo, vtkIGSIOTransformRepository& transformRepository, bool packValidTransformsOnly, igtl::MessageBase::Pointer igtlMessage, igsioTrackedFrame& trackedFrame, std::vector<igtl::MessageBase::Pointer>& igtlMessages)
+int vtkPlusIgtlMessageFactory::PackTransformMessage(const PlusIgtlClientInfo& clientInfo, vtkIGSIOTransformRepository& transformRepository, bool packValidTransformsOnly, igtl::MessageBase::Pointer igtlMessage, igsioTrackedFrame& trackedFrame, std::vector<igtl::MessageBase::Pointer>& igtlMessages, PackedMessageCache* messageCache/*=NULL*/)
 {
   for (std::vector<igsioTransformName>::const_iterator transformNameIterator = clientInfo.TransformNames.begin(); transformNameIterator != clientInfo.TransformNames.end(); ++transformNameIterator)
   {
@@ -378,6 +464,12 @@ int vtkPlusIgtlMessageFactory::PackTransformMessage(const PlusIgtlClientInfo& cl
       continue;
     }
 
+    std::string cacheKey = GetMessageCacheKey(igtlMessage->GetMessageType(), igtlMessage->GetHeaderVersion(), transformName.GetTransformName());
+    if (AddCachedMessage(messageCache, cacheKey, igtlMessages))
+    {
+      continue;
+    }
+
     igtl::Matrix4x4 igtlMatrix;
     vtkPlusIgtlMessageCommon::GetIgtlMatrix(igtlMatrix, &transformRepository, transformName);
 
@@ -397,13 +489,14 @@ int vtkPlusIgtlMessageFactory::PackTransformMessage(const PlusIgtlClientInfo& cl
     }
 	vtkPlusIgtlMessageCommon::PackTransformMessage(transformMessage, transformName, igtlMatrix, status, trackedFrame.GetTimestamp());
     igtlMessages.push_back(transformMessage.GetPointer());
+    CacheMessage(messageCache, cacheKey, transformMessage.GetPointer());
   }
 
   return 0; // no errors possible in this message type
 }
 
 //----------------------------------------------------------------------------
-int vtkPlusIgtlMessageFactory::PackImageMessage(const PlusIgtlClientInfo& clientInfo, vtkIGSIOTransformRepository& transformRepository, const std::string& messageType, igtl::MessageBase::Pointer igtlMessage, igsioTrackedFrame& trackedFrame, std::vector<igtl::MessageBase::Pointer>& igtlMessages, int clientId)
+int vtkPlusIgtlMessageFactory::PackImageMessage(const PlusIgtlClientInfo& clientInfo, vtkIGSIOTransformRepository& transformRepository, const std::string& messageType, igtl::MessageBase::Pointer igtlMessage, igsioTrackedFrame& trackedFrame, std::vector<igtl::MessageBase::Pointer>& igtlMessages, int clientId, PackedMessageCache* messageCache/*=NULL*/)
 {
   int numberOfErrors = 0;
   for (std::vector<PlusIgtlClientInfo::ImageStream>::const_iterator imageStreamIterator = clientInfo.ImageStreams.begin(); imageStreamIterator != clientInfo.ImageStreams.end(); ++imageStreamIterator)
@@ -413,6 +506,15 @@ int vtkPlusIgtlMessageFactory::PackImageMessage(const PlusIgtlClientInfo& client
     // Set transform name to [Name]To[CoordinateFrame]
     igsioTransformName imageTransformName = igsioTransformName(imageStream.Name, imageStream.EmbeddedTransformToFrame);
 
+    // The content of the message is determined by the image stream, clients that request the same stream get the same message
+    // (clients that do not check the CRC get a message without CRC)
+    std::string cacheKey = GetMessageCacheKey(messageType, igtlMessage->GetHeaderVersion(),
+                           imageTransformName.GetTransformName() + (clientInfo.GetImageCrcEnabled() ? "" : "|NoCrc"));
+    if (AddCachedMessage(messageCache, cacheKey, igtlMessages))
+    {
+      continue;
+    }
+
     vtkSmartPointer<vtkMatrix4x4> matrix = vtkSmartPointer<vtkMatrix4x4>::New();
     ToolStatus status;
     if (transformRepository.GetTransform(imageTransformName, matrix.Get(), &status) != PLUS_SUCCESS)
@@ -424,7 +526,10 @@ int vtkPlusIgtlMessageFactory::PackImageMessage(const PlusIgtlClientInfo& client
 
     std::string deviceName = imageTransformName.From() + std::string("_") + imageTransformName.To();
 
-    igtl::ImageMessage::Pointer imageMessage = dynamic_cast<igtl::ImageMessage*>(igtlMessage->Clone().GetPointer());
+    // The pixel data is sent directly from the tracked frame image
+    igtl::PlusImageMessage::Pointer imageMessage = igtl::PlusImageMessage::New();
+    imageMessage->SetHeaderVersion(igtlMessage->GetHeaderVersion());
+    imageMessage->SetCrcEnabled(clientInfo.GetImageCrcEnabled());
     if (trackedFrame.IsFrameFieldDefined(igsioTrackedFrame::FIELD_FRIENDLY_DEVICE_NAME))
     {
       // Allow overriding of device name with something human readable
@@ -447,21 +552,24 @@ int vtkPlusIgtlMessageFactory::PackImageMessage(const PlusIgtlClientInfo& client
       imageMessage->SetMetaDataElement(*stringNameIterator, IANA_TYPE_US_ASCII, trackedFrame.GetFrameField(*stringNameIterator));
     }
 
-    if (vtkPlusIgtlMessageCommon::PackImageMessage(imageMessage, trackedFrame, *matrix, imageStream.FrameConverter) != PLUS_SUCCESS)
+    if (vtkPlusIgtlMessageCommon::PackImageMessage(imageMessage.GetPointer(), trackedFrame, *matrix, imageStream.FrameConverter) != PLUS_SUCCESS)
     {
       LOG_ERROR("Failed to create " << messageType << " message - unable to pack image message");
       numberOfErrors++;
       continue;
     }
     igtlMessages.push_back(imageMessage.GetPointer());
+    CacheMessage(messageCache, cacheKey, imageMessage.GetPointer());
   }
   return numberOfErrors;
 }
 
 #if defined(OpenIGTLink_ENABLE_VIDEOSTREAMING)
 //----------------------------------------------------------------------------
-int vtkPlusIgtlMessageFactory::PackVideoMessage(const PlusIgtlClientInfo& clientInfo, vtkIGSIOTransformRepository& transformRepository, const std::string& messageType, igtl::MessageBase::Pointer igtlMessage, igsioTrackedFrame& trackedFrame, std::vector<igtl::MessageBase::Pointer>& igtlMessages, int clientId)
+int vtkPlusIgtlMessageFactory::PackVideoMessage(const PlusIgtlClientInfo& clientInfo, vtkIGSIOTransformRepository& transformRepository, const std::string& messageType, igtl::MessageBase::Pointer igtlMessage, igsioTrackedFrame& trackedFrame, std::vector<igtl::MessageBase::Pointer>& igtlMessages, int clientId, PackedMessageCache* messageCache/*=NULL*/)
 {
+  // The encoded frames are not cached: the frame converter of the client keeps the state of its encoded stream,
+  // and a key frame is requested from it when frames of the client are dropped.
   int numberOfErrors = 0;
   for (std::vector<PlusIgtlClientInfo::VideoStream>::const_iterator videoStreamIterator = clientInfo.VideoStreams.begin(); videoStreamIterator != clientInfo.VideoStreams.end(); ++videoStreamIterator)
   {
@@ -20,6 +20,9 @@
 // PlusLib includes
 #include "PlusIgtlClientInfo.h"
 
+// STL includes
+#include <map>
+
 class vtkXMLDataElement;
 //class igsioTrackedFrame; 
 //class vtkIGSIOTransformRepository;
@@ -42,6 +45,38 @@ public:
   /*! Function pointer for storing New() static methods of igtl::MessageBase classes */
   typedef igtl::MessageBase::Pointer (*PointerToMessageBaseNew)();
 
+  /*!
+    Messages that have been packed from the same tracked frame. Messages whose content only depends on the tracked frame
+    and on the message type, header version, and device name (or image stream) are packed once and shared by all the clients
+    that request them. TDATA and TRACKEDFRAME messages are shared by the clients that request the same list of transforms
+    (whether a TDATA message is due is still decided for each client). VIDEO messages are not shared: each client encodes
+    its streams by its own encoder, so a key frame can be requested for a client whose frames have been dropped.
+    The cache must be cleared before the messages of the next tracked frame are packed.
+  */
+  class vtkPlusOpenIGTLinkExport PackedMessageCache
+  {
+  public:
+    PackedMessageCache()
+      : TransformRepositoryUpdated(false)
+      , NumberOfReusedMessages(0)
+    {
+    }
+    void Clear()
+    {
+      this->Messages.clear();
+      this->TransformRepositoryUpdated = false;
+    }
+    /*! Get the number of times a message was taken from the cache instead of packing it again */
+    unsigned long GetNumberOfReusedMessages() const { return this->NumberOfReusedMessages; }
+
+  protected:
+    friend class vtkPlusIgtlMessageFactory;
+    std::map<std::string, igtl::MessageBase::Pointer> Messages;
+    /*! The transform repository has been updated with the transforms of the tracked frame */
+    bool TransformRepositoryUpdated;
+    unsigned long NumberOfReusedMessages;
+  };
+
   /*!
   Get pointer to message type new function, or NULL if the message type not registered
   Usage: igtl::MessageBase::Pointer message = GetMessageTypeNewPointer("IMAGE")();
@@ -76,9 +111,10 @@ public:
   \param igtMessages Output list for the generated IGTL messages
   \param trackedFrame Input tracked frame data used for IGTL message generation
   \param transformRepository Transform repository used for computing the selected transforms
+  \param messageCache Messages that have been packed from the same tracked frame for other clients. Messages are not shared if it is NULL.
   */
   PlusStatus PackMessages(int clientId, const PlusIgtlClientInfo& clientInfo, std::vector<igtl::MessageBase::Pointer>& igtMessages, igsioTrackedFrame& trackedFrame,
-                          bool packValidTransformsOnly, vtkIGSIOTransformRepository* transformRepository = NULL);
+                          bool packValidTransformsOnly, vtkIGSIOTransformRepository* transformRepository = NULL, PackedMessageCache* messageCache = NULL);
 
 protected:
   vtkPlusIgtlMessageFactory();
@@ -87,22 +123,36 @@ protected:
   igtl::MessageFactory::Pointer IgtlFactory;
 
 protected:
+  /*! Get the key of a message in the message cache */
+  static std::string GetMessageCacheKey(const std::string& messageType, int headerVersion, const std::string& contentName = "");
+  /*! Append the message with the specified key from the cache to the list. Returns false if the message is not in the cache. */
+  static bool AddCachedMessage(PackedMessageCache* messageCache, const std::string& key, std::vector<igtl::MessageBase::Pointer>& igtlMessages);
+  /*! Store a packed message in the cache (if the cache is not NULL) */
+  static void CacheMessage(PackedMessageCache* messageCache, const std::string& key, igtl::MessageBase::Pointer igtlMessage);
+  /*! Get the part of a message cache key that identifies a list of transforms */
+  static std::string GetTransformNamesCacheKey(const std::vector<igsioTransformName>& transformNames);
+
   int PackImageMessage(const PlusIgtlClientInfo& clientInfo, vtkIGSIOTransformRepository& transformRepository, const std::string& messageType,
-                       igtl::MessageBase::Pointer igtlMessage, igsioTrackedFrame& trackedFrame, std::vector<igtl::MessageBase::Pointer>& igtlMessages, int clientId);
+                       igtl::MessageBase::Pointer igtlMessage, igsioTrackedFrame& trackedFrame, std::vector<igtl::MessageBase::Pointer>& igtlMessages, int clientId,
+                       PackedMessageCache* messageCache = NULL);
 #if defined(OpenIGTLink_ENABLE_VIDEOSTREAMING)
   int PackVideoMessage(const PlusIgtlClientInfo& clientInfo, vtkIGSIOTransformRepository& transformRepository, const std::string& messageType,
-                       igtl::MessageBase::Pointer igtlMessage, igsioTrackedFrame& trackedFrame, std::vector<igtl::MessageBase::Pointer>& igtlMessages, int clientId);
+                       igtl::MessageBase::Pointer igtlMessage, igsioTrackedFrame& trackedFrame, std::vector<igtl::MessageBase::Pointer>& igtlMessages, int clientId,
+                       PackedMessageCache* messageCache = NULL);
 #endif
   int PackTransformMessage(const PlusIgtlClientInfo& clientInfo, vtkIGSIOTransformRepository& transformRepository, bool packValidTransformsOnly,
-                           igtl::MessageBase::Pointer igtlMessage, igsioTrackedFrame& trackedFrame, std::vector<igtl::MessageBase::Pointer>& igtlMessages);
+                           igtl::MessageBase::Pointer igtlMessage, igsioTrackedFrame& trackedFrame, std::vector<igtl::MessageBase::Pointer>& igtlMessages,
+                           PackedMessageCache* messageCache = NULL);
   int PackTrackingDataMessage(const PlusIgtlClientInfo& clientInfo, igsioTrackedFrame& trackedFrame, vtkIGSIOTransformRepository& transformRepository, bool packValidTransformsOnly,
-                              igtl::MessageBase::Pointer igtlMessage, std::vector<igtl::MessageBase::Pointer>& igtlMessages);
+                              igtl::MessageBase::Pointer igtlMessage, std::vector<igtl::MessageBase::Pointer>& igtlMessages, PackedMessageCache* messageCache = NULL);
   int PackPositionMessage(const PlusIgtlClientInfo& clientInfo, vtkIGSIOTransformRepository& transformRepository, igtl::MessageBase::Pointer igtlMessage,
-                          igsioTrackedFrame& trackedFrame, std::vector<igtl::MessageBase::Pointer>& igtlMessages);
+                          igsioTrackedFrame& trackedFrame, std::vector<igtl::MessageBase::Pointer>& igtlMessages, PackedMessageCache* messageCache = NULL);
   int PackTrackedFrameMessage(igtl::MessageBase::Pointer igtlMessage, const PlusIgtlClientInfo& clientInfo, vtkIGSIOTransformRepository& transformRepository,
-                              igsioTrackedFrame& trackedFrame, std::vector<igtl::MessageBase::Pointer>& igtlMessages);
-  int PackUsMessage(igtl::MessageBase::Pointer igtlMessage, igsioTrackedFrame& trackedFrame, std::vector<igtl::MessageBase::Pointer>& igtlMessages);
-  int PackStringMessage(const PlusIgtlClientInfo& clientInfo, igsioTrackedFrame& trackedFrame, igtl::MessageBase::Pointer igtlMessage, std::vector<igtl::MessageBase::Pointer>& igtlMessages);
+                              igsioTrackedFrame& trackedFrame, std::vector<igtl::MessageBase::Pointer>& igtlMessages, PackedMessageCache* messageCache = NULL);
+  int PackUsMessage(const PlusIgtlClientInfo& clientInfo, igtl::MessageBase::Pointer igtlMessage, igsioTrackedFrame& trackedFrame, std::vector<igtl::MessageBase::Pointer>& igtlMessages,
+                    PackedMessageCache* messageCache = NULL);
+  int PackStringMessage(const PlusIgtlClientInfo& clientInfo, igsioTrackedFrame& trackedFrame, igtl::MessageBase::Pointer igtlMessage, std::vector<igtl::MessageBase::Pointer>& igtlMessages,
+                        PackedMessageCache* messageCache = NULL);
   int PackCommandMessage(igtl::MessageBase::Pointer igtlMessage, std::vector<igtl::MessageBase::Pointer>& igtlMessages);
 
 private:
@@ -0,0 +1,118 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+#include "PlusConfigure.h"
+#include "igtl_header.h"
+#include "vtkPlusCommandProcessor.h"
+#include "vtkPlusDataCollector.h"
+#include "vtkPlusGetBufferMemoryUsageCommand.h"
+#include "vtkPlusOpenIGTLinkServer.h"
+
+#include <iomanip>
+
+vtkStandardNewMacro(vtkPlusGetBufferMemoryUsageCommand);
+
+namespace
+{
+  static const std::string GET_BUFFER_MEMORY_USAGE_CMD = "GetBufferMemoryUsage";
+}
+
+//----------------------------------------------------------------------------
+vtkPlusGetBufferMemoryUsageCommand::vtkPlusGetBufferMemoryUsageCommand()
+{
+  // It handles only one command, set its name by default
+  this->SetName(GET_BUFFER_MEMORY_USAGE_CMD);
+}
+
+//----------------------------------------------------------------------------
+vtkPlusGetBufferMemoryUsageCommand::~vtkPlusGetBufferMemoryUsageCommand()
+{
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusGetBufferMemoryUsageCommand::SetNameToGetBufferMemoryUsage()
+{
+  this->SetName(GET_BUFFER_MEMORY_USAGE_CMD);
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusGetBufferMemoryUsageCommand::GetCommandNames(std::list<std::string>& cmdNames)
+{
+  cmdNames.clear();
+  cmdNames.push_back(GET_BUFFER_MEMORY_USAGE_CMD);
+}
+
+//----------------------------------------------------------------------------
+std::string vtkPlusGetBufferMemoryUsageCommand::GetDescription(const std::string& commandName)
+{
+  std::string desc;
+  if (commandName.empty() || igsioCommon::IsEqualInsensitive(commandName, GET_BUFFER_MEMORY_USAGE_CMD))
+  {
+    desc += GET_BUFFER_MEMORY_USAGE_CMD;
+    desc += ": Request the memory usage, size, and consumer lag of the buffers of all devices, and the buffer memory budget.";
+  }
+  return desc;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusGetBufferMemoryUsageCommand::Execute()
+{
+  vtkPlusDataCollector* dataCollector = this->GetDataCollector();
+  if (dataCollector == NULL)
+  {
+    this->QueueCommandResponse(PLUS_FAIL, "Command failed. See error message.", "No data collector.");
+    return PLUS_FAIL;
+  }
+
+  std::vector<vtkPlusDataCollector::BufferMemoryUsage> bufferMemoryUsage;
+  size_t totalMemoryUsageBytes(0);
+  if (dataCollector->GetBufferMemoryUsage(bufferMemoryUsage, totalMemoryUsageBytes) != PLUS_SUCCESS)
+  {
+    this->QueueCommandResponse(PLUS_FAIL, "Command failed. See error message.", "Unable to retrieve buffer memory usage.");
+    return PLUS_FAIL;
+  }
+
+  // One line for each buffer: DeviceId/SourceId, buffer size, configured buffer size, item size, memory usage, consumer lag, items not available anymore
+  std::ostringstream bufferList;
+  igtl::MessageBase::MetaDataMap keyValuePairs;
+  for (std::vector<vtkPlusDataCollector::BufferMemoryUsage>::const_iterator it = bufferMemoryUsage.begin(); it != bufferMemoryUsage.end(); ++it)
+  {
+    std::ostringstream bufferInfo;
+    bufferInfo << "BufferSize=" << it->BufferSize
+               << ";ConfiguredBufferSize=" << it->ConfiguredBufferSize
+               << ";ItemSizeBytes=" << it->ItemSizeBytes
+               << ";MemoryUsageBytes=" << it->MemoryUsageBytes
+               << ";ConsumerLagSec=" << std::fixed << std::setprecision(3) << it->ConsumerLagSec
+               << ";ItemsNotAvailableAnymore=" << it->NumberOfItemsNotAvailableAnymore;
+    const std::string bufferName = it->DeviceId + "/" + it->SourceId;
+    bufferList << bufferName << ": " << bufferInfo.str() << std::endl;
+    keyValuePairs[bufferName] = std::pair<IANA_ENCODING_TYPE, std::string>(IANA_TYPE_US_ASCII, bufferInfo.str());
+  }
+  keyValuePairs["TotalMemoryUsageBytes"] = std::pair<IANA_ENCODING_TYPE, std::string>(IANA_TYPE_US_ASCII, igsioCommon::ToString<size_t>(totalMemoryUsageBytes));
+  keyValuePairs["BufferMemoryBudgetMb"] = std::pair<IANA_ENCODING_TYPE, std::string>(IANA_TYPE_US_ASCII, igsioCommon::ToString<double>(dataCollector->GetBufferMemoryBudgetMb()));
+
+  std::ostringstream oss;
+  oss << bufferMemoryUsage.size() << " buffers use " << std::fixed << std::setprecision(1) << totalMemoryUsageBytes / (1024.0 * 1024.0) << " MB memory";
+  if (dataCollector->GetBufferMemoryBudgetMb() > 0)
+  {
+    oss << " (budget: " << dataCollector->GetBufferMemoryBudgetMb() << " MB)";
+  }
+  oss << ".";
+
+  PlusIgtlClientInfo info;
+  if (this->CommandProcessor->GetPlusServer()->GetClientInfo(this->GetClientId(), info) != PLUS_SUCCESS)
+  {
+    LOG_WARNING("Unable to locate client data for client id: " << this->GetClientId());
+  }
+  if (info.GetClientHeaderVersion() <= IGTL_HEADER_VERSION_2)
+  {
+    // Clients with old header version do not receive the meta data, send the details in the message
+    oss << std::endl << bufferList.str();
+  }
+
+  this->QueueCommandResponse(PLUS_SUCCESS, oss.str(), "", &keyValuePairs);
+  return PLUS_SUCCESS;
+}
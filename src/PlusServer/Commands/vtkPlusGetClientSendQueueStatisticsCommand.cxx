@@ -0,0 +1,101 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+#include "PlusConfigure.h"
+#include "igtl_header.h"
+#include "vtkPlusCommandProcessor.h"
+#include "vtkPlusGetClientSendQueueStatisticsCommand.h"
+#include "vtkPlusOpenIGTLinkServer.h"
+
+vtkStandardNewMacro(vtkPlusGetClientSendQueueStatisticsCommand);
+
+namespace
+{
+  static const std::string GET_CLIENT_SEND_QUEUE_STATISTICS_CMD = "GetClientSendQueueStatistics";
+}
+
+//----------------------------------------------------------------------------
+vtkPlusGetClientSendQueueStatisticsCommand::vtkPlusGetClientSendQueueStatisticsCommand()
+{
+  // It handles only one command, set its name by default
+  this->SetName(GET_CLIENT_SEND_QUEUE_STATISTICS_CMD);
+}
+
+//----------------------------------------------------------------------------
+vtkPlusGetClientSendQueueStatisticsCommand::~vtkPlusGetClientSendQueueStatisticsCommand()
+{
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusGetClientSendQueueStatisticsCommand::SetNameToGetClientSendQueueStatistics()
+{
+  this->SetName(GET_CLIENT_SEND_QUEUE_STATISTICS_CMD);
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusGetClientSendQueueStatisticsCommand::GetCommandNames(std::list<std::string>& cmdNames)
+{
+  cmdNames.clear();
+  cmdNames.push_back(GET_CLIENT_SEND_QUEUE_STATISTICS_CMD);
+}
+
+//----------------------------------------------------------------------------
+std::string vtkPlusGetClientSendQueueStatisticsCommand::GetDescription(const std::string& commandName)
+{
+  std::string desc;
+  if (commandName.empty() || igsioCommon::IsEqualInsensitive(commandName, GET_CLIENT_SEND_QUEUE_STATISTICS_CMD))
+  {
+    desc += GET_CLIENT_SEND_QUEUE_STATISTICS_CMD;
+    desc += ": Request the number of queued, sent, and dropped messages of each connected client.";
+  }
+  return desc;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusGetClientSendQueueStatisticsCommand::Execute()
+{
+  vtkPlusOpenIGTLinkServer* server = this->CommandProcessor->GetPlusServer();
+  if (server == NULL)
+  {
+    this->QueueCommandResponse(PLUS_FAIL, "Command failed. See error message.", "No server.");
+    return PLUS_FAIL;
+  }
+
+  std::vector<vtkPlusOpenIGTLinkServer::ClientSendQueueStatistics> sendQueueStatistics;
+  server->GetClientSendQueueStatistics(sendQueueStatistics);
+
+  // One line for each client: queue depth, maximum queue depth, sent and dropped messages
+  std::ostringstream statisticsList;
+  igtl::MessageBase::MetaDataMap keyValuePairs;
+  for (std::vector<vtkPlusOpenIGTLinkServer::ClientSendQueueStatistics>::const_iterator it = sendQueueStatistics.begin(); it != sendQueueStatistics.end(); ++it)
+  {
+    std::ostringstream summary;
+    summary << "Queued=" << it->Statistics.NumberOfQueuedMessages
+            << " MaxQueued=" << it->Statistics.MaxNumberOfQueuedMessages
+            << " Sent=" << it->Statistics.NumberOfSentMessages
+            << " Dropped=" << it->Statistics.NumberOfDroppedMessages;
+    const std::string name = std::string("Client") + igsioCommon::ToString<int>(it->ClientId);
+    statisticsList << name << ": " << summary.str() << std::endl;
+    keyValuePairs[name] = std::pair<IANA_ENCODING_TYPE, std::string>(IANA_TYPE_US_ASCII, summary.str());
+  }
+
+  std::ostringstream oss;
+  oss << "Send queue statistics of " << sendQueueStatistics.size() << " clients.";
+
+  PlusIgtlClientInfo info;
+  if (server->GetClientInfo(this->GetClientId(), info) != PLUS_SUCCESS)
+  {
+    LOG_WARNING("Unable to locate client data for client id: " << this->GetClientId());
+  }
+  if (info.GetClientHeaderVersion() <= IGTL_HEADER_VERSION_2)
+  {
+    // Clients with old header version do not receive the meta data, send the details in the message
+    oss << std::endl << statisticsList.str();
+  }
+
+  this->QueueCommandResponse(PLUS_SUCCESS, oss.str(), "", &keyValuePairs);
+  return PLUS_SUCCESS;
+}
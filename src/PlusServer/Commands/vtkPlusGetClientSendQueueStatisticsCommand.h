@@ -0,0 +1,48 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+#ifndef __vtkPlusGetClientSendQueueStatisticsCommand_h
+#define __vtkPlusGetClientSendQueueStatisticsCommand_h
+
+#include "vtkPlusServerExport.h"
+
+#include "vtkPlusCommand.h"
+
+/*!
+  \class vtkPlusGetClientSendQueueStatisticsCommand
+  \brief This command returns the number of queued, sent, and dropped messages of each connected client
+  \ingroup PlusLibPlusServer
+ */
+class vtkPlusServerExport vtkPlusGetClientSendQueueStatisticsCommand : public vtkPlusCommand
+{
+public:
+
+  static vtkPlusGetClientSendQueueStatisticsCommand* New();
+  vtkTypeMacro(vtkPlusGetClientSendQueueStatisticsCommand, vtkPlusCommand);
+  virtual vtkPlusCommand* Clone() { return New(); }
+
+  /*! Executes the command  */
+  virtual PlusStatus Execute();
+
+  /*! Get all the command names that this class can execute */
+  virtual void GetCommandNames(std::list<std::string>& cmdNames);
+
+  /*! Gets the description for the specified command name. */
+  virtual std::string GetDescription(const std::string& commandName);
+
+  void SetNameToGetClientSendQueueStatistics();
+
+protected:
+  vtkPlusGetClientSendQueueStatisticsCommand();
+  virtual ~vtkPlusGetClientSendQueueStatisticsCommand();
+
+private:
+  vtkPlusGetClientSendQueueStatisticsCommand(const vtkPlusGetClientSendQueueStatisticsCommand&);
+  void operator=(const vtkPlusGetClientSendQueueStatisticsCommand&);
+};
+
+
+#endif
@@ -0,0 +1,96 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+#include "PlusConfigure.h"
+#include "igtl_header.h"
+#include "vtkPlusCommandProcessor.h"
+#include "vtkPlusGetLatencyStatisticsCommand.h"
+#include "vtkPlusOpenIGTLinkServer.h"
+
+vtkStandardNewMacro(vtkPlusGetLatencyStatisticsCommand);
+
+namespace
+{
+  static const std::string GET_LATENCY_STATISTICS_CMD = "GetLatencyStatistics";
+}
+
+//----------------------------------------------------------------------------
+vtkPlusGetLatencyStatisticsCommand::vtkPlusGetLatencyStatisticsCommand()
+{
+  // It handles only one command, set its name by default
+  this->SetName(GET_LATENCY_STATISTICS_CMD);
+}
+
+//----------------------------------------------------------------------------
+vtkPlusGetLatencyStatisticsCommand::~vtkPlusGetLatencyStatisticsCommand()
+{
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusGetLatencyStatisticsCommand::SetNameToGetLatencyStatistics()
+{
+  this->SetName(GET_LATENCY_STATISTICS_CMD);
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusGetLatencyStatisticsCommand::GetCommandNames(std::list<std::string>& cmdNames)
+{
+  cmdNames.clear();
+  cmdNames.push_back(GET_LATENCY_STATISTICS_CMD);
+}
+
+//----------------------------------------------------------------------------
+std::string vtkPlusGetLatencyStatisticsCommand::GetDescription(const std::string& commandName)
+{
+  std::string desc;
+  if (commandName.empty() || igsioCommon::IsEqualInsensitive(commandName, GET_LATENCY_STATISTICS_CMD))
+  {
+    desc += GET_LATENCY_STATISTICS_CMD;
+    desc += ": Request the latency percentiles of adding data to the buffers, reading frames from the channels, and sending frames to each client.";
+  }
+  return desc;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusGetLatencyStatisticsCommand::Execute()
+{
+  vtkPlusOpenIGTLinkServer* server = this->CommandProcessor->GetPlusServer();
+  if (server == NULL)
+  {
+    this->QueueCommandResponse(PLUS_FAIL, "Command failed. See error message.", "No server.");
+    return PLUS_FAIL;
+  }
+
+  std::vector<vtkPlusDataCollector::LatencyHistogramSnapshot> latencyHistograms;
+  server->GetLatencyHistograms(latencyHistograms);
+
+  // One line for each stage: name, count, mean, percentiles, and maximum
+  std::ostringstream latencyList;
+  igtl::MessageBase::MetaDataMap keyValuePairs;
+  for (std::vector<vtkPlusDataCollector::LatencyHistogramSnapshot>::const_iterator it = latencyHistograms.begin(); it != latencyHistograms.end(); ++it)
+  {
+    const std::string summary = it->Snapshot.GetSummary();
+    latencyList << it->Name << ": " << summary << std::endl;
+    keyValuePairs[it->Name] = std::pair<IANA_ENCODING_TYPE, std::string>(IANA_TYPE_US_ASCII, summary);
+  }
+
+  std::ostringstream oss;
+  oss << "Latency statistics of " << latencyHistograms.size() << " stages.";
+
+  PlusIgtlClientInfo info;
+  if (server->GetClientInfo(this->GetClientId(), info) != PLUS_SUCCESS)
+  {
+    LOG_WARNING("Unable to locate client data for client id: " << this->GetClientId());
+  }
+  if (info.GetClientHeaderVersion() <= IGTL_HEADER_VERSION_2)
+  {
+    // Clients with old header version do not receive the meta data, send the details in the message
+    oss << std::endl << latencyList.str();
+  }
+
+  this->QueueCommandResponse(PLUS_SUCCESS, oss.str(), "", &keyValuePairs);
+  return PLUS_SUCCESS;
+}
@@ -0,0 +1,48 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+#ifndef __vtkPlusGetLatencyStatisticsCommand_h
+#define __vtkPlusGetLatencyStatisticsCommand_h
+
+#include "vtkPlusServerExport.h"
+
+#include "vtkPlusCommand.h"
+
+/*!
+  \class vtkPlusGetLatencyStatisticsCommand
+  \brief This command returns the latency statistics of the buffer commit, channel read, and client send stages to the client
+  \ingroup PlusLibPlusServer
+ */
+class vtkPlusServerExport vtkPlusGetLatencyStatisticsCommand : public vtkPlusCommand
+{
+public:
+
+  static vtkPlusGetLatencyStatisticsCommand* New();
+  vtkTypeMacro(vtkPlusGetLatencyStatisticsCommand, vtkPlusCommand);
+  virtual vtkPlusCommand* Clone() { return New(); }
+
+  /*! Executes the command  */
+  virtual PlusStatus Execute();
+
+  /*! Get all the command names that this class can execute */
+  virtual void GetCommandNames(std::list<std::string>& cmdNames);
+
+  /*! Gets the description for the specified command name. */
+  virtual std::string GetDescription(const std::string& commandName);
+
+  void SetNameToGetLatencyStatistics();
+
+protected:
+  vtkPlusGetLatencyStatisticsCommand();
+  virtual ~vtkPlusGetLatencyStatisticsCommand();
+
+private:
+  vtkPlusGetLatencyStatisticsCommand(const vtkPlusGetLatencyStatisticsCommand&);
+  void operator=(const vtkPlusGetLatencyStatisticsCommand&);
+};
+
+
+#endif
@@ -0,0 +1,572 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+#include "PlusConfigure.h"
+#include "PlusClock.h"
+#include "PlusIgtlClientSendQueue.h"
+#include "PlusIgtlSocketDescriptorAccessor.h"
+
+#include <vtkIGSIOAccurateTimer.h>
+
+#if defined(OpenIGTLink_ENABLE_VIDEOSTREAMING)
+  #include <igtlCodecCommonClasses.h>
+  #include <igtlVideoMessage.h>
+#endif
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+#ifdef _WIN32
+  #include <winsock2.h>
+#else
+  #include <errno.h>
+  #include <sys/socket.h>
+  #include <sys/uio.h>
+#endif
+
+namespace
+{
+#ifdef MSG_NOSIGNAL
+  const int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+  const int SEND_FLAGS = 0;
+#endif
+}
+
+//----------------------------------------------------------------------------
+PlusIgtlClientSendQueue::PlusIgtlClientSendQueue(igtl::ClientSocket::Pointer clientSocket, int maxNumberOfQueuedMessages, int numberOfRetryAttempts, double delayBetweenRetryAttemptsSec,
+    std::shared_ptr<PlusLatencyHistogram> sendLatencyHistogram /*=std::shared_ptr<PlusLatencyHistogram>()*/)
+  : ClientSocket(clientSocket)
+  , MaxNumberOfQueuedMessages(maxNumberOfQueuedMessages)
+  , NumberOfRetryAttempts(numberOfRetryAttempts)
+  , DelayBetweenRetryAttemptsSec(delayBetweenRetryAttemptsSec)
+  , SendLatencyHistogram(sendLatencyHistogram)
+  , NumberOfDroppableMessages(0)
+  , Threader(vtkSmartPointer<vtkMultiThreader>::New())
+  , WriterThreadId(-1)
+  , StopRequested(false)
+  , WriterThreadActive(false)
+{
+}
+
+//----------------------------------------------------------------------------
+PlusIgtlClientSendQueue::~PlusIgtlClientSendQueue()
+{
+  this->Stop();
+}
+
+//----------------------------------------------------------------------------
+PlusStatus PlusIgtlClientSendQueue::Start()
+{
+  if (this->WriterThreadId >= 0)
+  {
+    return PLUS_SUCCESS;
+  }
+  if (this->ClientSocket.IsNull())
+  {
+    LOG_ERROR("Unable to start client send queue: client socket is not specified");
+    return PLUS_FAIL;
+  }
+  {
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    this->StopRequested = false;
+  }
+  this->WriterThreadActive = true;
+  this->WriterThreadId = this->Threader->SpawnThread((vtkThreadFunctionType)&WriterThread, this);
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+void PlusIgtlClientSendQueue::Stop()
+{
+  if (this->WriterThreadId < 0)
+  {
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    this->StopRequested = true;
+  }
+  this->MessageQueued.notify_all();
+  while (this->WriterThreadActive)
+  {
+    // Wait until the writer thread is finished
+    vtkIGSIOAccurateTimer::Delay(0.1);
+  }
+  this->Threader->TerminateThread(this->WriterThreadId);
+  this->WriterThreadId = -1;
+
+  std::lock_guard<std::mutex> lock(this->Mutex);
+  this->Messages.clear();
+  this->NumberOfDroppableMessages = 0;
+  this->SendStatistics.NumberOfQueuedMessages = 0;
+}
+
+//----------------------------------------------------------------------------
+void PlusIgtlClientSendQueue::ShutdownSocket()
+{
+  if (this->ClientSocket.IsNull())
+  {
+    return;
+  }
+  int socketDescriptor = PlusIgtlSocketDescriptorAccessor::GetSocketDescriptor(this->ClientSocket);
+  if (socketDescriptor < 0)
+  {
+    // Already closed
+    return;
+  }
+#ifdef _WIN32
+  shutdown(socketDescriptor, SD_BOTH);
+#else
+  shutdown(socketDescriptor, SHUT_RDWR);
+#endif
+}
+
+//----------------------------------------------------------------------------
+bool PlusIgtlClientSendQueue::QueueMessage(igtl::MessageBase::Pointer message, DropPolicy dropPolicy, double frameTimestamp /*=UNDEFINED_TIMESTAMP*/,
+    std::vector<igtl::MessageBase::Pointer>* droppedMessages /*=NULL*/)
+{
+  if (message.IsNull())
+  {
+    return true;
+  }
+
+  std::function<void()> messageQueuedCallback;
+  {
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    if (this->SendStatistics.SendFailed)
+    {
+      return false;
+    }
+
+    if (this->IsWaitingForKeyFrame(message))
+    {
+      // The frame cannot be decoded, no other message has to be dropped to make room for it
+      this->DropNewMessage(message, droppedMessages);
+      return true;
+    }
+
+    if (dropPolicy == DROP_POLICY_KEEP_LATEST)
+    {
+      // Only the latest message of the stream has to be sent
+      for (std::deque<QueuedMessage>::iterator it = this->Messages.begin(); it != this->Messages.end(); ++it)
+      {
+        if (it->Policy == DROP_POLICY_KEEP_LATEST && IsSameStream(it->Message, message))
+        {
+          this->DropMessage(it, droppedMessages);
+          break;
+        }
+      }
+    }
+
+    if (dropPolicy != DROP_POLICY_NEVER && this->NumberOfDroppableMessages >= this->MaxNumberOfQueuedMessages)
+    {
+      // Queue is full, drop the oldest message that can be dropped
+      for (std::deque<QueuedMessage>::iterator it = this->Messages.begin(); it != this->Messages.end(); ++it)
+      {
+        if (it->Policy != DROP_POLICY_NEVER)
+        {
+          this->DropMessage(it, droppedMessages);
+          break;
+        }
+      }
+      if (this->NumberOfDroppableMessages >= this->MaxNumberOfQueuedMessages)
+      {
+        // Nothing could be dropped (the maximum length is 0), drop the new message instead
+        this->DropNewMessage(message, droppedMessages);
+        return true;
+      }
+    }
+
+    if (this->IsWaitingForKeyFrame(message))
+    {
+      // A previous frame of the stream has just been dropped
+      this->DropNewMessage(message, droppedMessages);
+      return true;
+    }
+
+    QueuedMessage queuedMessage;
+    queuedMessage.Message = message;
+    queuedMessage.Policy = dropPolicy;
+    queuedMessage.FrameTimestamp = frameTimestamp;
+    this->Messages.push_back(queuedMessage);
+    if (dropPolicy != DROP_POLICY_NEVER)
+    {
+      this->NumberOfDroppableMessages++;
+    }
+    this->SendStatistics.NumberOfQueuedMessages = static_cast<unsigned int>(this->Messages.size());
+    if (this->SendStatistics.NumberOfQueuedMessages > this->SendStatistics.MaxNumberOfQueuedMessages)
+    {
+      this->SendStatistics.MaxNumberOfQueuedMessages = this->SendStatistics.NumberOfQueuedMessages;
+    }
+    messageQueuedCallback = this->MessageQueuedCallback;
+  }
+  this->MessageQueued.notify_one();
+  if (messageQueuedCallback)
+  {
+    messageQueuedCallback();
+  }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool PlusIgtlClientSendQueue::BeginSendMessage(igtl::MessageBase::Pointer& message)
+{
+  std::lock_guard<std::mutex> lock(this->Mutex);
+  if (this->Messages.empty() || this->SendStatistics.SendFailed || this->SendingMessage.Message.IsNotNull())
+  {
+    return false;
+  }
+  this->SendingMessage = this->Messages.front();
+  this->Messages.pop_front();
+  if (this->SendingMessage.Policy != DROP_POLICY_NEVER)
+  {
+    this->NumberOfDroppableMessages--;
+  }
+  this->SendStatistics.NumberOfQueuedMessages = static_cast<unsigned int>(this->Messages.size());
+  message = this->SendingMessage.Message;
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void PlusIgtlClientSendQueue::EndSendMessage(bool success)
+{
+  std::lock_guard<std::mutex> lock(this->Mutex);
+  if (this->SendingMessage.Message.IsNull())
+  {
+    return;
+  }
+  if (success)
+  {
+    this->SendStatistics.NumberOfSentMessages++;
+    if (this->SendingMessage.FrameTimestamp != UNDEFINED_TIMESTAMP && this->SendLatencyHistogram)
+    {
+      // Frame timestamps are in the time of PlusClock, which is virtual time when data is replayed
+      this->SendLatencyHistogram->RecordLatency(PlusClock::GetSystemTime() - this->SendingMessage.FrameTimestamp);
+    }
+  }
+  else
+  {
+    igtl::TimeStamp::Pointer ts = igtl::TimeStamp::New();
+    this->SendingMessage.Message->GetTimeStamp(ts);
+    LOG_INFO("Client disconnected - could not send " << this->SendingMessage.Message->GetMessageType() << " message to client (device name: " << this->SendingMessage.Message->GetDeviceName()
+             << "  Timestamp: " << std::fixed << ts->GetTimeStamp() << ").");
+    // The client cannot receive anything anymore, discard the rest of the messages
+    this->FailSend();
+  }
+  this->SendingMessage.Message = NULL;
+}
+
+//----------------------------------------------------------------------------
+void PlusIgtlClientSendQueue::SetMessageQueuedCallback(std::function<void()> callback)
+{
+  std::lock_guard<std::mutex> lock(this->Mutex);
+  this->MessageQueuedCallback = callback;
+}
+
+//----------------------------------------------------------------------------
+void PlusIgtlClientSendQueue::DropMessage(std::deque<QueuedMessage>::iterator messageIt, std::vector<igtl::MessageBase::Pointer>* droppedMessages)
+{
+  if (droppedMessages != NULL)
+  {
+    droppedMessages->push_back(messageIt->Message);
+  }
+  if (messageIt->Policy != DROP_POLICY_NEVER)
+  {
+    this->NumberOfDroppableMessages--;
+  }
+  igtl::MessageBase::Pointer message = messageIt->Message;
+  messageIt = this->Messages.erase(messageIt);
+  this->SendStatistics.NumberOfDroppedMessages++;
+
+  if (IsVideoMessage(message))
+  {
+    // The queued frames of the stream were encoded after the dropped one, they cannot be decoded until the next key frame
+    this->VideoStreamsWaitingForKeyFrame.insert(message->GetDeviceName());
+    while (messageIt != this->Messages.end())
+    {
+      if (!IsSameStream(messageIt->Message, message))
+      {
+        ++messageIt;
+        continue;
+      }
+      if (IsKeyFrame(messageIt->Message))
+      {
+        this->VideoStreamsWaitingForKeyFrame.erase(message->GetDeviceName());
+        break;
+      }
+      if (droppedMessages != NULL)
+      {
+        droppedMessages->push_back(messageIt->Message);
+      }
+      if (messageIt->Policy != DROP_POLICY_NEVER)
+      {
+        this->NumberOfDroppableMessages--;
+      }
+      messageIt = this->Messages.erase(messageIt);
+      this->SendStatistics.NumberOfDroppedMessages++;
+    }
+  }
+  this->SendStatistics.NumberOfQueuedMessages = static_cast<unsigned int>(this->Messages.size());
+}
+
+//----------------------------------------------------------------------------
+void PlusIgtlClientSendQueue::DropNewMessage(igtl::MessageBase::Pointer message, std::vector<igtl::MessageBase::Pointer>* droppedMessages)
+{
+  if (droppedMessages != NULL)
+  {
+    droppedMessages->push_back(message);
+  }
+  this->SendStatistics.NumberOfDroppedMessages++;
+  if (IsVideoMessage(message))
+  {
+    this->VideoStreamsWaitingForKeyFrame.insert(message->GetDeviceName());
+  }
+}
+
+//----------------------------------------------------------------------------
+bool PlusIgtlClientSendQueue::IsWaitingForKeyFrame(igtl::MessageBase* message)
+{
+  if (!IsVideoMessage(message))
+  {
+    return false;
+  }
+  std::set<std::string>::iterator streamIt = this->VideoStreamsWaitingForKeyFrame.find(message->GetDeviceName());
+  if (streamIt == this->VideoStreamsWaitingForKeyFrame.end())
+  {
+    return false;
+  }
+  if (IsKeyFrame(message))
+  {
+    this->VideoStreamsWaitingForKeyFrame.erase(streamIt);
+    return false;
+  }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool PlusIgtlClientSendQueue::IsSendFailed()
+{
+  std::lock_guard<std::mutex> lock(this->Mutex);
+  return this->SendStatistics.SendFailed;
+}
+
+//----------------------------------------------------------------------------
+void PlusIgtlClientSendQueue::SetSendFailed()
+{
+  std::lock_guard<std::mutex> lock(this->Mutex);
+  this->FailSend();
+}
+
+//----------------------------------------------------------------------------
+void PlusIgtlClientSendQueue::FailSend()
+{
+  this->SendStatistics.SendFailed = true;
+  this->Messages.clear();
+  this->VideoStreamsWaitingForKeyFrame.clear();
+  this->NumberOfDroppableMessages = 0;
+  this->SendStatistics.NumberOfQueuedMessages = 0;
+}
+
+//----------------------------------------------------------------------------
+void PlusIgtlClientSendQueue::GetStatistics(Statistics& statistics)
+{
+  std::lock_guard<std::mutex> lock(this->Mutex);
+  statistics = this->SendStatistics;
+}
+
+//----------------------------------------------------------------------------
+int PlusIgtlClientSendQueue::SendMessageSegments(igtl::MessageBase* message, igtl_uint64& numberOfSentBytes)
+{
+  std::vector<igtl::PlusImageMessage::BufferSegment> segments;
+  igtl::PlusImageMessage::GetBufferSegments(message, segments);
+
+  std::vector<igtl::PlusImageMessage::BufferSegment> unsentSegments;
+  while (true)
+  {
+    // Skip the data that has been sent
+    unsentSegments.clear();
+    igtl_uint64 segmentStart = 0;
+    for (std::vector<igtl::PlusImageMessage::BufferSegment>::const_iterator segmentIt = segments.begin(); segmentIt != segments.end(); ++segmentIt)
+    {
+      igtl_uint64 segmentEnd = segmentStart + segmentIt->Size;
+      if (segmentEnd > numberOfSentBytes)
+      {
+        igtl_uint64 offset = (numberOfSentBytes > segmentStart ? numberOfSentBytes - segmentStart : 0);
+        unsentSegments.push_back(igtl::PlusImageMessage::BufferSegment(static_cast<const char*>(segmentIt->Data) + offset, segmentIt->Size - offset));
+      }
+      segmentStart = segmentEnd;
+    }
+    if (unsentSegments.empty())
+    {
+      return 1;
+    }
+
+    long long bytesWritten = this->WriteSegments(unsentSegments);
+    if (bytesWritten <= 0)
+    {
+      return 0;
+    }
+    numberOfSentBytes += static_cast<igtl_uint64>(bytesWritten);
+  }
+}
+
+//----------------------------------------------------------------------------
+long long PlusIgtlClientSendQueue::WriteSegments(const std::vector<igtl::PlusImageMessage::BufferSegment>& segments)
+{
+  int socketDescriptor = PlusIgtlSocketDescriptorAccessor::GetSocketDescriptor(this->ClientSocket);
+  if (segments.empty() || socketDescriptor < 0)
+  {
+    return -1;
+  }
+
+#ifdef _WIN32
+  // Send from the first segment only, the rest is sent by the next calls
+  int bytesToSend = static_cast<int>((std::min<igtl_uint64>)(segments[0].Size, INT_MAX));
+  while (true)
+  {
+    int bytesSent = send(socketDescriptor, static_cast<const char*>(segments[0].Data), bytesToSend, SEND_FLAGS);
+    if (bytesSent == SOCKET_ERROR)
+    {
+      if (WSAGetLastError() == WSAEINTR)
+      {
+        continue;
+      }
+      return -1;
+    }
+    return bytesSent;
+  }
+#else
+  std::vector<iovec> ioVectors(segments.size());
+  for (size_t i = 0; i < segments.size(); ++i)
+  {
+    ioVectors[i].iov_base = const_cast<void*>(segments[i].Data);
+    ioVectors[i].iov_len = static_cast<size_t>(segments[i].Size);
+  }
+  msghdr socketMessage;
+  memset(&socketMessage, 0, sizeof(socketMessage));
+  socketMessage.msg_iov = &ioVectors[0];
+  socketMessage.msg_iovlen = ioVectors.size();
+  while (true)
+  {
+    ssize_t bytesSent = sendmsg(socketDescriptor, &socketMessage, SEND_FLAGS);
+    if (bytesSent < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      return -1;
+    }
+    return static_cast<long long>(bytesSent);
+  }
+#endif
+}
+
+//----------------------------------------------------------------------------
+bool PlusIgtlClientSendQueue::IsSameStream(igtl::MessageBase* message1, igtl::MessageBase* message2)
+{
+  return strcmp(message1->GetMessageType(), message2->GetMessageType()) == 0
+         && strcmp(message1->GetDeviceName(), message2->GetDeviceName()) == 0;
+}
+
+//----------------------------------------------------------------------------
+bool PlusIgtlClientSendQueue::IsVideoMessage(igtl::MessageBase* message)
+{
+  return strcmp(message->GetMessageType(), "VIDEO") == 0;
+}
+
+//----------------------------------------------------------------------------
+bool PlusIgtlClientSendQueue::IsKeyFrame(igtl::MessageBase* message)
+{
+#if defined(OpenIGTLink_ENABLE_VIDEOSTREAMING)
+  igtl::VideoMessage* videoMessage = dynamic_cast<igtl::VideoMessage*>(message);
+  if (videoMessage == NULL)
+  {
+    return false;
+  }
+  // The frame type is shifted by 8 bits for single component frames (see vtkPlusIgtlMessageCommon::PackVideoMessage)
+  int frameType = videoMessage->GetFrameType();
+  return frameType == FrameTypeKey || frameType == (FrameTypeKey << 8);
+#else
+  // Video messages are not packed without video streaming support
+  return true;
+#endif
+}
+
+//----------------------------------------------------------------------------
+std::string PlusIgtlClientSendQueue::GetDropPolicyAsString(DropPolicy dropPolicy)
+{
+  switch (dropPolicy)
+  {
+    case DROP_POLICY_OLDEST:
+      return "DropOldest";
+    case DROP_POLICY_KEEP_LATEST:
+      return "KeepLatest";
+    default:
+      return "Never";
+  }
+}
+
+//----------------------------------------------------------------------------
+bool PlusIgtlClientSendQueue::GetDropPolicyFromString(const std::string& dropPolicyString, DropPolicy& dropPolicy)
+{
+  if (igsioCommon::IsEqualInsensitive(dropPolicyString, "Never"))
+  {
+    dropPolicy = DROP_POLICY_NEVER;
+    return true;
+  }
+  if (igsioCommon::IsEqualInsensitive(dropPolicyString, "DropOldest"))
+  {
+    dropPolicy = DROP_POLICY_OLDEST;
+    return true;
+  }
+  if (igsioCommon::IsEqualInsensitive(dropPolicyString, "KeepLatest"))
+  {
+    dropPolicy = DROP_POLICY_KEEP_LATEST;
+    return true;
+  }
+  return false;
+}
+
+//----------------------------------------------------------------------------
+void* PlusIgtlClientSendQueue::WriterThread(vtkMultiThreader::ThreadInfo* data)
+{
+  PlusIgtlClientSendQueue* self = static_cast<PlusIgtlClientSendQueue*>(data->UserData);
+
+  while (true)
+  {
+    {
+      std::unique_lock<std::mutex> lock(self->Mutex);
+      self->MessageQueued.wait(lock, [self]()
+      {
+        return self->StopRequested || (!self->Messages.empty() && !self->SendStatistics.SendFailed);
+      });
+      if (self->StopRequested)
+      {
+        break;
+      }
+    }
+
+    // Send without holding the lock, so new messages can be queued meanwhile
+    igtl::MessageBase::Pointer message;
+    if (!self->BeginSendMessage(message))
+    {
+      continue;
+    }
+    // A retry continues after the data that has been sent already, the client could not parse a message whose beginning is sent twice
+    igtl_uint64 numberOfSentBytes = 0;
+    int retValue = 0;
+    RETRY_UNTIL_TRUE((retValue = self->SendMessageSegments(message, numberOfSentBytes)) != 0,
+                     self->NumberOfRetryAttempts, self->DelayBetweenRetryAttemptsSec);
+    self->EndSendMessage(retValue != 0);
+  }
+
+  self->WriterThreadActive = false;
+  return NULL;
+}
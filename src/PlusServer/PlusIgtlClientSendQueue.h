@@ -0,0 +1,235 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+#ifndef __PlusIgtlClientSendQueue_h
+#define __PlusIgtlClientSendQueue_h
+
+#include "PlusConfigure.h"
+#include "vtkPlusServerExport.h"
+#include "PlusLatencyHistogram.h"
+#include "igtlPlusImageMessage.h"
+
+// VTK includes
+#include <vtkMultiThreader.h>
+#include <vtkSmartPointer.h>
+
+// IGTL includes
+#include <igtlClientSocket.h>
+#include <igtlMessageBase.h>
+
+// STL includes
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+/*!
+  \class PlusIgtlClientSendQueue
+  \brief Bounded queue of the packed OpenIGTLink messages that are waiting to be sent to one client
+
+  The messages are sent by a writer thread that belongs to the queue, so a client that cannot receive data
+  as fast as it is produced does not delay the other clients or the packing of the next frames.
+  Alternatively, if the writer thread is not started, an event loop that handles the sockets of all the clients
+  can take the messages by BeginSendMessage and EndSendMessage, it is notified by the message queued callback.
+
+  When the queue is full, messages are dropped according to their drop policy:
+  - DROP_POLICY_NEVER: the message is always queued and never dropped (command replies, status messages).
+    These messages may make the queue longer than the maximum length.
+  - DROP_POLICY_OLDEST: when the queue is full the oldest droppable message is removed to make room for the new one.
+  - DROP_POLICY_KEEP_LATEST: a message that has not been sent yet is replaced by the next message of the same stream
+    (same message type and device name), so only the latest image of a stream is waiting.
+    It is also dropped like a DROP_POLICY_OLDEST message when the queue is full.
+
+  VIDEO messages of a stream cannot be decoded without the previous ones. When one of them is dropped, the queued and
+  the new VIDEO messages of the same stream are also dropped until the next key frame (the server requests a key frame
+  from the encoder of the client when it is notified about the dropped message).
+
+  If a message cannot be sent then the queue stops sending and discards all the messages, as the client is considered to be disconnected.
+  If sending is retried after a message has been partially written, then it continues after the data that has already been sent.
+
+  Messages that send the pixel data directly from an image (see igtl::PlusImageMessage) are written by a single
+  scatter-gather call (sendmsg), so the header and the pixel data do not have to be copied into one buffer.
+
+  \ingroup PlusLibPlusServer
+*/
+class vtkPlusServerExport PlusIgtlClientSendQueue
+{
+public:
+  enum DropPolicy
+  {
+    DROP_POLICY_NEVER,
+    DROP_POLICY_OLDEST,
+    DROP_POLICY_KEEP_LATEST
+  };
+
+  struct Statistics
+  {
+    Statistics()
+      : NumberOfQueuedMessages(0)
+      , MaxNumberOfQueuedMessages(0)
+      , NumberOfSentMessages(0)
+      , NumberOfDroppedMessages(0)
+      , SendFailed(false)
+    {
+    }
+    /*! Number of messages that are currently waiting to be sent */
+    unsigned int NumberOfQueuedMessages;
+    /*! Highest number of messages that were waiting to be sent at the same time */
+    unsigned int MaxNumberOfQueuedMessages;
+    unsigned long NumberOfSentMessages;
+    unsigned long NumberOfDroppedMessages;
+    bool SendFailed;
+  };
+
+  /*!
+    \param clientSocket Socket of the client, the messages are sent through it
+    \param maxNumberOfQueuedMessages Maximum number of droppable messages that may wait for sending
+    \param numberOfRetryAttempts Number of retry attempts if a message cannot be sent
+    \param delayBetweenRetryAttemptsSec Delay between retry attempts
+    \param sendLatencyHistogram Histogram of the age of the frames when they have been sent, may be empty
+  */
+  PlusIgtlClientSendQueue(igtl::ClientSocket::Pointer clientSocket, int maxNumberOfQueuedMessages, int numberOfRetryAttempts, double delayBetweenRetryAttemptsSec,
+                          std::shared_ptr<PlusLatencyHistogram> sendLatencyHistogram = std::shared_ptr<PlusLatencyHistogram>());
+  virtual ~PlusIgtlClientSendQueue();
+
+  /*! Start the writer thread */
+  PlusStatus Start();
+  /*!
+    Stop the writer thread. It waits until the message that is being sent is completed, the other queued messages are discarded.
+    Call ShutdownSocket before if the client is disconnected, so a message that is blocked in sending does not delay stopping.
+  */
+  void Stop();
+
+  /*!
+    Shut down the connection of the client socket, so sending or receiving that is in progress returns immediately.
+    The socket is not closed, so its descriptor is not reused while the writer thread may still use it.
+  */
+  void ShutdownSocket();
+
+  /*!
+    Add a packed message to the queue
+    \param message Packed message. It is not modified, therefore the same message can be queued for multiple clients.
+    \param dropPolicy Policy that determines if the message can be dropped, if the client cannot keep up with the data
+    \param frameTimestamp System time of the frame that the message contains, used for recording the send latency. UNDEFINED_TIMESTAMP if not a frame.
+    \param droppedMessages If not NULL then the messages that were dropped to make room for this one (or this message, if it was dropped) are appended to it
+    \return false if the messages cannot be sent anymore to the client (it is disconnected)
+  */
+  bool QueueMessage(igtl::MessageBase::Pointer message, DropPolicy dropPolicy, double frameTimestamp = UNDEFINED_TIMESTAMP,
+                    std::vector<igtl::MessageBase::Pointer>* droppedMessages = NULL);
+
+  /*!
+    Take the next message for sending. The message cannot be dropped anymore.
+    \return false if there is no message to send
+  */
+  bool BeginSendMessage(igtl::MessageBase::Pointer& message);
+  /*!
+    Complete sending the message that was taken by BeginSendMessage
+    \param success If false then the client is considered to be disconnected and all the queued messages are discarded
+  */
+  void EndSendMessage(bool success);
+
+  /*! Set a function that is called whenever a message is queued (e.g., to wake up an event loop). It is not called while the queue is locked. */
+  void SetMessageQueuedCallback(std::function<void()> callback);
+
+  /*! Returns true if a message could not be sent, which means that the client is disconnected */
+  bool IsSendFailed();
+  /*! Stop sending messages and discard the queued ones, for example because the client closed the connection */
+  void SetSendFailed();
+
+  void GetStatistics(Statistics& statistics);
+
+  static std::string GetDropPolicyAsString(DropPolicy dropPolicy);
+  /*! Get the drop policy from its string representation (Never, DropOldest, KeepLatest), returns false if the string is not recognized */
+  static bool GetDropPolicyFromString(const std::string& dropPolicyString, DropPolicy& dropPolicy);
+
+protected:
+  struct QueuedMessage
+  {
+    igtl::MessageBase::Pointer Message;
+    DropPolicy Policy;
+    double FrameTimestamp;
+  };
+
+  static void* WriterThread(vtkMultiThreader::ThreadInfo* data);
+
+  /*!
+    Send the rest of a packed message
+    \param numberOfSentBytes Number of bytes of the message that have been sent already, it is updated as the data is written.
+    If sending is retried after a failure then it resumes from here, so a partially sent message is not sent again from its beginning.
+    \return 0 if the message could not be completely sent
+  */
+  int SendMessageSegments(igtl::MessageBase* message, igtl_uint64& numberOfSentBytes);
+
+  /*!
+    Write the beginning of the buffer segments to the client socket by a single call
+    \return Number of bytes written (may be less than the total size of the segments), or -1 if nothing could be written
+    (e.g., the send timeout expired or the connection is broken)
+  */
+  virtual long long WriteSegments(const std::vector<igtl::PlusImageMessage::BufferSegment>& segments);
+
+  /*! Returns true if the two messages belong to the same stream */
+  static bool IsSameStream(igtl::MessageBase* message1, igtl::MessageBase* message2);
+
+  /*! Returns true if the message is a VIDEO message */
+  static bool IsVideoMessage(igtl::MessageBase* message);
+  /*! Returns true if the message is a VIDEO message that contains a key frame, which can be decoded without the previous frames */
+  static bool IsKeyFrame(igtl::MessageBase* message);
+
+  /*!
+    Remove a queued message and count it as dropped. Mutex must be locked.
+    If it is a VIDEO message then the following messages of the stream are dropped until the next key frame.
+  */
+  void DropMessage(std::deque<QueuedMessage>::iterator messageIt, std::vector<igtl::MessageBase::Pointer>* droppedMessages);
+
+  /*!
+    Count a message that is not queued as dropped. Mutex must be locked.
+    If it is a VIDEO message then the next messages of the stream are dropped until the next key frame.
+  */
+  void DropNewMessage(igtl::MessageBase::Pointer message, std::vector<igtl::MessageBase::Pointer>* droppedMessages);
+
+  /*!
+    Returns true if the message is a VIDEO message that depends on a dropped frame of its stream, so it has to be dropped, too.
+    A key frame restarts the stream. Mutex must be locked.
+  */
+  bool IsWaitingForKeyFrame(igtl::MessageBase* message);
+
+  /*! Discard all the messages and do not accept new ones. Mutex must be locked. */
+  void FailSend();
+
+  igtl::ClientSocket::Pointer ClientSocket;
+  int MaxNumberOfQueuedMessages;
+  int NumberOfRetryAttempts;
+  double DelayBetweenRetryAttemptsSec;
+  std::shared_ptr<PlusLatencyHistogram> SendLatencyHistogram;
+
+  std::mutex Mutex;
+  /*! Notified when a message is queued or the thread should stop */
+  std::condition_variable MessageQueued;
+  std::deque<QueuedMessage> Messages;
+  /*! Message that has been taken by BeginSendMessage and is being sent */
+  QueuedMessage SendingMessage;
+  std::function<void()> MessageQueuedCallback;
+  /*! Number of messages in the queue that may be dropped */
+  int NumberOfDroppableMessages;
+  /*! Device names of the VIDEO streams whose messages are dropped until the next key frame */
+  std::set<std::string> VideoStreamsWaitingForKeyFrame;
+  Statistics SendStatistics;
+
+  vtkSmartPointer<vtkMultiThreader> Threader;
+  int WriterThreadId;
+  bool StopRequested;
+  bool WriterThreadActive;
+
+private:
+  PlusIgtlClientSendQueue(const PlusIgtlClientSendQueue&);
+  PlusIgtlClientSendQueue& operator=(const PlusIgtlClientSendQueue&);
+};
+
+#endif
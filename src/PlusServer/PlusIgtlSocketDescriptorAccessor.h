@@ -0,0 +1,35 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+#ifndef __PlusIgtlSocketDescriptorAccessor_h
+#define __PlusIgtlSocketDescriptorAccessor_h
+
+// IGTL includes
+#include <igtlSocket.h>
+
+/*!
+  \class PlusIgtlSocketDescriptorAccessor
+  \brief Gives access to the descriptor of OpenIGTLink sockets
+
+  The descriptor is needed for operations that igtl::Socket does not provide, such as sending from multiple buffers
+  by a single call, polling the socket in an event loop, or shutting down the connection.
+  Returns -1 if the socket is not open.
+
+  \ingroup PlusLibPlusServer
+*/
+struct PlusIgtlSocketDescriptorAccessor : public igtl::Socket
+{
+  static int GetSocketDescriptor(igtl::Socket* socket)
+  {
+    if (socket == NULL)
+    {
+      return -1;
+    }
+    return socket->*(&PlusIgtlSocketDescriptorAccessor::m_SocketDescriptor);
+  }
+};
+
+#endif
@@ -0,0 +1,502 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file PlusIgtlClientSendQueueTest.cxx
+  \brief Tests the drop policies of PlusIgtlClientSendQueue and that a partially written message is resumed, not sent again.
+
+  The drop policies are tested by taking the messages from the queue as an event loop does (BeginSendMessage, EndSendMessage).
+  The same VIDEO messages are queued for two clients and only one of them drops frames, that client must skip
+  the frames until the next key frame while the other client receives all of them.
+  Sending is tested by the writer thread of a queue whose socket is replaced by a stub sink, which accepts only a few bytes
+  at a time and reports a send timeout regularly.
+*/
+
+#include "PlusConfigure.h"
+#include "PlusIgtlClientSendQueue.h"
+#include "igtlPlusImageMessage.h"
+
+// OpenIGTLink includes
+#include <igtlStringMessage.h>
+#if defined(OpenIGTLink_ENABLE_VIDEOSTREAMING)
+  #include <igtlCodecCommonClasses.h>
+  #include <igtlVideoMessage.h>
+#endif
+
+// VTK includes
+#include <vtkIGSIOAccurateTimer.h>
+#include <vtkImageData.h>
+#include <vtkSmartPointer.h>
+#include <vtksys/CommandLineArguments.hxx>
+
+// STL includes
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace
+{
+  const double SEND_TIMEOUT_SEC = 5.0;
+
+  //----------------------------------------------------------------------------
+  /*! Send queue that writes the messages into a buffer instead of a socket */
+  class StubSinkSendQueue : public PlusIgtlClientSendQueue
+  {
+  public:
+    StubSinkSendQueue(int maxNumberOfQueuedMessages, int numberOfRetryAttempts, size_t maxNumberOfBytesPerWrite, int timeoutEveryNthWrite, size_t brokenAfterNumberOfBytes)
+      : PlusIgtlClientSendQueue(igtl::ClientSocket::New(), maxNumberOfQueuedMessages, numberOfRetryAttempts, 0.001)
+      , MaxNumberOfBytesPerWrite(maxNumberOfBytesPerWrite)
+      , TimeoutEveryNthWrite(timeoutEveryNthWrite)
+      , BrokenAfterNumberOfBytes(brokenAfterNumberOfBytes)
+      , NumberOfWrites(0)
+    {
+    }
+
+    virtual ~StubSinkSendQueue()
+    {
+      // The writer thread must not use the sink while it is destroyed
+      this->Stop();
+    }
+
+    std::string GetReceivedBytes()
+    {
+      std::lock_guard<std::mutex> lock(this->SinkMutex);
+      return this->ReceivedBytes;
+    }
+
+  protected:
+    virtual long long WriteSegments(const std::vector<igtl::PlusImageMessage::BufferSegment>& segments)
+    {
+      std::lock_guard<std::mutex> lock(this->SinkMutex);
+      this->NumberOfWrites++;
+      if (this->TimeoutEveryNthWrite > 0 && this->NumberOfWrites % this->TimeoutEveryNthWrite == 0)
+      {
+        // Send timeout, nothing is written
+        return -1;
+      }
+      size_t bytesToWrite = std::min(this->MaxNumberOfBytesPerWrite, this->BrokenAfterNumberOfBytes - this->ReceivedBytes.size());
+      if (bytesToWrite == 0)
+      {
+        // Connection is broken
+        return -1;
+      }
+      size_t bytesWritten = 0;
+      for (std::vector<igtl::PlusImageMessage::BufferSegment>::const_iterator segmentIt = segments.begin(); segmentIt != segments.end() && bytesWritten < bytesToWrite; ++segmentIt)
+      {
+        size_t segmentBytes = std::min(static_cast<size_t>(segmentIt->Size), bytesToWrite - bytesWritten);
+        this->ReceivedBytes.append(static_cast<const char*>(segmentIt->Data), segmentBytes);
+        bytesWritten += segmentBytes;
+      }
+      return static_cast<long long>(bytesWritten);
+    }
+
+    std::mutex SinkMutex;
+    std::string ReceivedBytes;
+    size_t MaxNumberOfBytesPerWrite;
+    int TimeoutEveryNthWrite;
+    size_t BrokenAfterNumberOfBytes;
+    int NumberOfWrites;
+  };
+
+  //----------------------------------------------------------------------------
+  igtl::MessageBase::Pointer CreateStringMessage(const std::string& deviceName, const std::string& value)
+  {
+    igtl::StringMessage::Pointer stringMessage = igtl::StringMessage::New();
+    stringMessage->SetDeviceName(deviceName.c_str());
+    stringMessage->SetString(value.c_str());
+    stringMessage->Pack();
+    return stringMessage.GetPointer();
+  }
+
+  //----------------------------------------------------------------------------
+  /*! Create an image message that sends the pixel data directly from the image, so it is sent in multiple buffer segments */
+  igtl::MessageBase::Pointer CreateImageMessage(vtkImageData* image)
+  {
+    int dimensions[3] = { 0, 0, 0 };
+    image->GetDimensions(dimensions);
+    int subVolumeOffset[3] = { 0, 0, 0 };
+    igtl::PlusImageMessage::Pointer imageMessage = igtl::PlusImageMessage::New();
+    imageMessage->SetDeviceName("Image_Reference");
+    imageMessage->SetDimensions(dimensions);
+    imageMessage->SetSubVolume(dimensions, subVolumeOffset);
+    imageMessage->SetScalarTypeToUint8();
+    imageMessage->SetNumComponents(1);
+    if (imageMessage->SetScalarsReference(image) != PLUS_SUCCESS)
+    {
+      return NULL;
+    }
+    imageMessage->Pack();
+    return imageMessage.GetPointer();
+  }
+
+  //----------------------------------------------------------------------------
+  /*! Get the bytes of a packed message as they are sent */
+  std::string GetMessageBytes(igtl::MessageBase* message)
+  {
+    std::vector<igtl::PlusImageMessage::BufferSegment> segments;
+    igtl::PlusImageMessage::GetBufferSegments(message, segments);
+    std::string bytes;
+    for (std::vector<igtl::PlusImageMessage::BufferSegment>::const_iterator segmentIt = segments.begin(); segmentIt != segments.end(); ++segmentIt)
+    {
+      bytes.append(static_cast<const char*>(segmentIt->Data), static_cast<size_t>(segmentIt->Size));
+    }
+    return bytes;
+  }
+
+  //----------------------------------------------------------------------------
+  /*! Take all the queued messages as an event loop does */
+  void SendQueuedMessages(PlusIgtlClientSendQueue& sendQueue, std::vector<igtl::MessageBase::Pointer>& sentMessages)
+  {
+    igtl::MessageBase::Pointer message;
+    while (sendQueue.BeginSendMessage(message))
+    {
+      sentMessages.push_back(message);
+      sendQueue.EndSendMessage(true);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  int CheckSentMessages(const std::string& testName, const std::vector<igtl::MessageBase::Pointer>& sentMessages, const std::vector<igtl::MessageBase::Pointer>& expectedMessages)
+  {
+    if (sentMessages.size() != expectedMessages.size())
+    {
+      LOG_ERROR(testName << ": " << sentMessages.size() << " messages were sent, expected " << expectedMessages.size());
+      return 1;
+    }
+    for (size_t i = 0; i < sentMessages.size(); ++i)
+    {
+      if (sentMessages[i] != expectedMessages[i])
+      {
+        LOG_ERROR(testName << ": message #" << i << " is " << sentMessages[i]->GetDeviceName() << ", expected " << expectedMessages[i]->GetDeviceName());
+        return 1;
+      }
+    }
+    return 0;
+  }
+
+  //----------------------------------------------------------------------------
+  /*! Messages that cannot be dropped are all sent, even if there are more of them than the maximum length of the queue */
+  int TestDropPolicyNever()
+  {
+    StubSinkSendQueue sendQueue(2, 1, 0, 0, 0);
+    std::vector<igtl::MessageBase::Pointer> queuedMessages;
+    std::vector<igtl::MessageBase::Pointer> droppedMessages;
+    for (int i = 0; i < 5; ++i)
+    {
+      queuedMessages.push_back(CreateStringMessage("Reply" + igsioCommon::ToString(i), "OK"));
+      if (!sendQueue.QueueMessage(queuedMessages.back(), PlusIgtlClientSendQueue::DROP_POLICY_NEVER, UNDEFINED_TIMESTAMP, &droppedMessages))
+      {
+        LOG_ERROR("DropPolicyNever: message could not be queued");
+        return 1;
+      }
+    }
+    if (!droppedMessages.empty())
+    {
+      LOG_ERROR("DropPolicyNever: " << droppedMessages.size() << " messages were dropped");
+      return 1;
+    }
+    std::vector<igtl::MessageBase::Pointer> sentMessages;
+    SendQueuedMessages(sendQueue, sentMessages);
+    return CheckSentMessages("DropPolicyNever", sentMessages, queuedMessages);
+  }
+
+  //----------------------------------------------------------------------------
+  /*! When the queue is full the oldest droppable message is dropped, messages that cannot be dropped are kept */
+  int TestDropPolicyOldest()
+  {
+    StubSinkSendQueue sendQueue(2, 1, 0, 0, 0);
+    std::vector<igtl::MessageBase::Pointer> droppedMessages;
+    igtl::MessageBase::Pointer reply = CreateStringMessage("Reply", "OK");
+    sendQueue.QueueMessage(reply, PlusIgtlClientSendQueue::DROP_POLICY_NEVER, UNDEFINED_TIMESTAMP, &droppedMessages);
+    std::vector<igtl::MessageBase::Pointer> frameMessages;
+    for (int i = 0; i < 4; ++i)
+    {
+      frameMessages.push_back(CreateStringMessage("Frame" + igsioCommon::ToString(i), "Data"));
+      sendQueue.QueueMessage(frameMessages.back(), PlusIgtlClientSendQueue::DROP_POLICY_OLDEST, UNDEFINED_TIMESTAMP, &droppedMessages);
+    }
+
+    int numberOfErrors = 0;
+    std::vector<igtl::MessageBase::Pointer> expectedDroppedMessages;
+    expectedDroppedMessages.push_back(frameMessages[0]);
+    expectedDroppedMessages.push_back(frameMessages[1]);
+    numberOfErrors += CheckSentMessages("DropPolicyOldest (dropped)", droppedMessages, expectedDroppedMessages);
+
+    PlusIgtlClientSendQueue::Statistics statistics;
+    sendQueue.GetStatistics(statistics);
+    if (statistics.NumberOfDroppedMessages != 2 || statistics.NumberOfQueuedMessages != 3)
+    {
+      LOG_ERROR("DropPolicyOldest: " << statistics.NumberOfDroppedMessages << " messages were dropped and " << statistics.NumberOfQueuedMessages << " are queued, expected 2 and 3");
+      numberOfErrors++;
+    }
+
+    std::vector<igtl::MessageBase::Pointer> sentMessages;
+    SendQueuedMessages(sendQueue, sentMessages);
+    std::vector<igtl::MessageBase::Pointer> expectedSentMessages;
+    expectedSentMessages.push_back(reply);
+    expectedSentMessages.push_back(frameMessages[2]);
+    expectedSentMessages.push_back(frameMessages[3]);
+    numberOfErrors += CheckSentMessages("DropPolicyOldest (sent)", sentMessages, expectedSentMessages);
+    return numberOfErrors;
+  }
+
+  //----------------------------------------------------------------------------
+  /*! An unsent message is replaced by the next message of the same stream, and dropped as the oldest one when the queue is full */
+  int TestDropPolicyKeepLatest()
+  {
+    StubSinkSendQueue sendQueue(3, 1, 0, 0, 0);
+    std::vector<igtl::MessageBase::Pointer> droppedMessages;
+    igtl::MessageBase::Pointer image1 = CreateStringMessage("Image", "1");
+    igtl::MessageBase::Pointer probe1 = CreateStringMessage("Probe", "1");
+    igtl::MessageBase::Pointer image2 = CreateStringMessage("Image", "2");
+    igtl::MessageBase::Pointer stylus1 = CreateStringMessage("Stylus", "1");
+    igtl::MessageBase::Pointer needle1 = CreateStringMessage("Needle", "1");
+    sendQueue.QueueMessage(image1, PlusIgtlClientSendQueue::DROP_POLICY_KEEP_LATEST, UNDEFINED_TIMESTAMP, &droppedMessages);
+    sendQueue.QueueMessage(probe1, PlusIgtlClientSendQueue::DROP_POLICY_KEEP_LATEST, UNDEFINED_TIMESTAMP, &droppedMessages);
+    sendQueue.QueueMessage(image2, PlusIgtlClientSendQueue::DROP_POLICY_KEEP_LATEST, UNDEFINED_TIMESTAMP, &droppedMessages);
+
+    int numberOfErrors = 0;
+    std::vector<igtl::MessageBase::Pointer> expectedDroppedMessages;
+    expectedDroppedMessages.push_back(image1);
+    numberOfErrors += CheckSentMessages("DropPolicyKeepLatest (replaced)", droppedMessages, expectedDroppedMessages);
+
+    // The queue is full, the oldest message is dropped
+    sendQueue.QueueMessage(stylus1, PlusIgtlClientSendQueue::DROP_POLICY_KEEP_LATEST, UNDEFINED_TIMESTAMP, &droppedMessages);
+    sendQueue.QueueMessage(needle1, PlusIgtlClientSendQueue::DROP_POLICY_KEEP_LATEST, UNDEFINED_TIMESTAMP, &droppedMessages);
+    expectedDroppedMessages.push_back(probe1);
+    numberOfErrors += CheckSentMessages("DropPolicyKeepLatest (dropped)", droppedMessages, expectedDroppedMessages);
+
+    std::vector<igtl::MessageBase::Pointer> sentMessages;
+    SendQueuedMessages(sendQueue, sentMessages);
+    std::vector<igtl::MessageBase::Pointer> expectedSentMessages;
+    expectedSentMessages.push_back(image2);
+    expectedSentMessages.push_back(stylus1);
+    expectedSentMessages.push_back(needle1);
+    numberOfErrors += CheckSentMessages("DropPolicyKeepLatest (sent)", sentMessages, expectedSentMessages);
+    return numberOfErrors;
+  }
+
+#if defined(OpenIGTLink_ENABLE_VIDEOSTREAMING)
+  //----------------------------------------------------------------------------
+  igtl::MessageBase::Pointer CreateVideoMessage(const std::string& deviceName, bool keyFrame)
+  {
+    igtl::VideoMessage::Pointer videoMessage = igtl::VideoMessage::New();
+    videoMessage->SetDeviceName(deviceName.c_str());
+    // Single component frames have their frame type shifted, as vtkPlusIgtlMessageCommon::PackVideoMessage does
+    videoMessage->SetFrameType((keyFrame ? FrameTypeKey : FrameTypeUnKnown) << 8);
+    videoMessage->SetBitStreamSize(1);
+    videoMessage->AllocateScalars();
+    memset(videoMessage->GetPackFragmentPointer(2), 0, 1);
+    videoMessage->Pack();
+    return videoMessage.GetPointer();
+  }
+
+  //----------------------------------------------------------------------------
+  /*!
+    The same VIDEO messages are queued for a client that cannot keep up with them and for one that can.
+    Frames that depend on a dropped frame are dropped for the slow client until the next key frame, the other client gets all frames.
+  */
+  int TestVideoKeyFrameAfterDrop()
+  {
+    StubSinkSendQueue slowClientQueue(2, 1, 0, 0, 0);
+    StubSinkSendQueue fastClientQueue(10, 1, 0, 0, 0);
+    std::vector<igtl::MessageBase::Pointer> frames;
+    frames.push_back(CreateVideoMessage("Image_Reference", true));
+    frames.push_back(CreateVideoMessage("Image_Reference", false));
+    frames.push_back(CreateVideoMessage("Image_Reference", false));
+    frames.push_back(CreateVideoMessage("Image_Reference", false));
+    frames.push_back(CreateVideoMessage("Image_Reference", true));
+    frames.push_back(CreateVideoMessage("Image_Reference", false));
+    igtl::MessageBase::Pointer reply = CreateStringMessage("Reply", "OK");
+
+    std::vector<igtl::MessageBase::Pointer> slowClientDroppedMessages;
+    std::vector<igtl::MessageBase::Pointer> fastClientDroppedMessages;
+    for (size_t i = 0; i < frames.size(); ++i)
+    {
+      slowClientQueue.QueueMessage(frames[i], PlusIgtlClientSendQueue::DROP_POLICY_OLDEST, UNDEFINED_TIMESTAMP, &slowClientDroppedMessages);
+      fastClientQueue.QueueMessage(frames[i], PlusIgtlClientSendQueue::DROP_POLICY_OLDEST, UNDEFINED_TIMESTAMP, &fastClientDroppedMessages);
+      if (i == 2)
+      {
+        // Messages of other streams are not affected by the dropped frames
+        slowClientQueue.QueueMessage(reply, PlusIgtlClientSendQueue::DROP_POLICY_NEVER, UNDEFINED_TIMESTAMP, &slowClientDroppedMessages);
+      }
+    }
+
+    int numberOfErrors = 0;
+    // Queuing the third frame drops the first one from the full queue, the next frames depend on it until the key frame
+    std::vector<igtl::MessageBase::Pointer> expectedDroppedMessages(frames.begin(), frames.begin() + 4);
+    numberOfErrors += CheckSentMessages("VideoKeyFrameAfterDrop (dropped)", slowClientDroppedMessages, expectedDroppedMessages);
+    numberOfErrors += CheckSentMessages("VideoKeyFrameAfterDrop (dropped by the other client)", fastClientDroppedMessages, std::vector<igtl::MessageBase::Pointer>());
+
+    std::vector<igtl::MessageBase::Pointer> sentMessages;
+    SendQueuedMessages(slowClientQueue, sentMessages);
+    std::vector<igtl::MessageBase::Pointer> expectedSentMessages;
+    expectedSentMessages.push_back(reply);
+    expectedSentMessages.push_back(frames[4]);
+    expectedSentMessages.push_back(frames[5]);
+    numberOfErrors += CheckSentMessages("VideoKeyFrameAfterDrop (sent)", sentMessages, expectedSentMessages);
+
+    sentMessages.clear();
+    SendQueuedMessages(fastClientQueue, sentMessages);
+    numberOfErrors += CheckSentMessages("VideoKeyFrameAfterDrop (sent to the other client)", sentMessages, frames);
+
+    PlusIgtlClientSendQueue::Statistics statistics;
+    slowClientQueue.GetStatistics(statistics);
+    if (statistics.NumberOfDroppedMessages != 4)
+    {
+      LOG_ERROR("VideoKeyFrameAfterDrop: " << statistics.NumberOfDroppedMessages << " messages were dropped, expected 4");
+      numberOfErrors++;
+    }
+    return numberOfErrors;
+  }
+#endif
+
+  //----------------------------------------------------------------------------
+  /*! Wait until the writer thread has sent the specified number of messages or sending failed */
+  void WaitForSending(PlusIgtlClientSendQueue& sendQueue, unsigned long numberOfMessages, PlusIgtlClientSendQueue::Statistics& statistics)
+  {
+    double startTime = vtkIGSIOAccurateTimer::GetSystemTime();
+    do
+    {
+      vtkIGSIOAccurateTimer::Delay(0.01);
+      sendQueue.GetStatistics(statistics);
+    }
+    while (statistics.NumberOfSentMessages < numberOfMessages && !statistics.SendFailed && vtkIGSIOAccurateTimer::GetSystemTime() - startTime < SEND_TIMEOUT_SEC);
+  }
+
+  //----------------------------------------------------------------------------
+  /*! Messages are written partially with send timeouts in between, the sink must receive each byte once */
+  int TestResumePartialSend(vtkImageData* image)
+  {
+    StubSinkSendQueue sendQueue(10, 10, 100, 4, std::string::npos);
+    if (sendQueue.Start() != PLUS_SUCCESS)
+    {
+      LOG_ERROR("ResumePartialSend: unable to start the writer thread");
+      return 1;
+    }
+    igtl::MessageBase::Pointer imageMessage = CreateImageMessage(image);
+    igtl::MessageBase::Pointer stringMessage = CreateStringMessage("Note", "Message after the image");
+    if (imageMessage.IsNull())
+    {
+      LOG_ERROR("ResumePartialSend: unable to create the image message");
+      return 1;
+    }
+    sendQueue.QueueMessage(imageMessage, PlusIgtlClientSendQueue::DROP_POLICY_NEVER);
+    sendQueue.QueueMessage(stringMessage, PlusIgtlClientSendQueue::DROP_POLICY_NEVER);
+
+    PlusIgtlClientSendQueue::Statistics statistics;
+    WaitForSending(sendQueue, 2, statistics);
+    sendQueue.Stop();
+
+    if (statistics.SendFailed || statistics.NumberOfSentMessages != 2)
+    {
+      LOG_ERROR("ResumePartialSend: " << statistics.NumberOfSentMessages << " messages were sent" << (statistics.SendFailed ? " and sending failed" : "") << ", expected 2");
+      return 1;
+    }
+    if (sendQueue.GetReceivedBytes() != GetMessageBytes(imageMessage) + GetMessageBytes(stringMessage))
+    {
+      LOG_ERROR("ResumePartialSend: the received " << sendQueue.GetReceivedBytes().size() << " bytes differ from the "
+                << GetMessageBytes(imageMessage).size() + GetMessageBytes(stringMessage).size() << " bytes of the messages");
+      return 1;
+    }
+    return 0;
+  }
+
+  //----------------------------------------------------------------------------
+  /*! If the connection breaks after a partial write then the client is dropped, the beginning of the message is not sent again */
+  int TestBrokenConnection(vtkImageData* image)
+  {
+    const size_t brokenAfterNumberOfBytes = 100;
+    StubSinkSendQueue sendQueue(10, 3, 30, 0, brokenAfterNumberOfBytes);
+    if (sendQueue.Start() != PLUS_SUCCESS)
+    {
+      LOG_ERROR("BrokenConnection: unable to start the writer thread");
+      return 1;
+    }
+    igtl::MessageBase::Pointer imageMessage = CreateImageMessage(image);
+    if (imageMessage.IsNull())
+    {
+      LOG_ERROR("BrokenConnection: unable to create the image message");
+      return 1;
+    }
+    sendQueue.QueueMessage(imageMessage, PlusIgtlClientSendQueue::DROP_POLICY_NEVER);
+
+    PlusIgtlClientSendQueue::Statistics statistics;
+    WaitForSending(sendQueue, 1, statistics);
+    bool messageAccepted = sendQueue.QueueMessage(CreateStringMessage("Note", "Message after failure"), PlusIgtlClientSendQueue::DROP_POLICY_NEVER);
+    sendQueue.Stop();
+
+    int numberOfErrors = 0;
+    if (!statistics.SendFailed || messageAccepted)
+    {
+      LOG_ERROR("BrokenConnection: sending did not fail, or messages are still accepted");
+      numberOfErrors++;
+    }
+    if (sendQueue.GetReceivedBytes() != GetMessageBytes(imageMessage).substr(0, brokenAfterNumberOfBytes))
+    {
+      LOG_ERROR("BrokenConnection: the " << sendQueue.GetReceivedBytes().size() << " received bytes are not the beginning of the message");
+      numberOfErrors++;
+    }
+    return numberOfErrors;
+  }
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+  image->SetDimensions(32, 24, 1);
+  image->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  unsigned char* pixels = static_cast<unsigned char*>(image->GetScalarPointer());
+  for (int i = 0; i < 32 * 24; ++i)
+  {
+    pixels[i] = static_cast<unsigned char>((i * 13) % 256);
+  }
+
+  int numberOfErrors(0);
+  numberOfErrors += TestDropPolicyNever();
+  numberOfErrors += TestDropPolicyOldest();
+  numberOfErrors += TestDropPolicyKeepLatest();
+#if defined(OpenIGTLink_ENABLE_VIDEOSTREAMING)
+  numberOfErrors += TestVideoKeyFrameAfterDrop();
+#endif
+  numberOfErrors += TestResumePartialSend(image);
+  numberOfErrors += TestBrokenConnection(image);
+
+  if (numberOfErrors > 0)
+  {
+    LOG_INFO("Test failed!");
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("Test completed successfully!");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,306 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file vtkPlusOpenIGTLinkServerStreamsTest.cxx
+  \brief Test that the broadcast streams of vtkPlusOpenIGTLinkServer compute the transforms from their own frames.
+
+  Two fake trackers with the same tools but different reference frames are broadcast on two channels. The trackers are
+  related by configured transforms, so the transforms of the other tracker can be computed from the frames of both streams,
+  but with different results. Each client requests the stylus transform relative to both trackers and checks that the received
+  transforms are computed from the frames of its own channel. The first channel is slow, the client of the second channel
+  must still receive the frames of the fast tracker as they arrive.
+*/
+
+#include "PlusConfigure.h"
+#include "PlusIgtlClientInfo.h"
+#include "igtlPlusClientInfoMessage.h"
+#include "vtkIGSIOTransformRepository.h"
+#include "vtkPlusDataCollector.h"
+#include "vtkPlusOpenIGTLinkServer.h"
+
+// OpenIGTLink includes
+#include <igtlClientSocket.h>
+#include <igtlMessageHeader.h>
+#include <igtlTransformMessage.h>
+
+// VTK includes
+#include <vtkSmartPointer.h>
+#include <vtkXMLDataElement.h>
+#include <vtkXMLUtilities.h>
+#include <vtksys/CommandLineArguments.hxx>
+
+// STL includes
+#include <map>
+#include <string>
+#include <thread>
+
+namespace
+{
+  const double RECEIVE_TIME_SEC = 3.0;
+  const double FAST_TRACKER_RATE = 50.0;
+  const double MAX_TRANSLATION_ERROR = 1e-3;
+
+  // The stylus of the fake trackers is always at (0, 300, 0), TrackerB is translated by (1000, 0, 0) from TrackerA
+  const char* DEVICE_SET_CONFIGURATION_XML =
+    "<PlusConfiguration version=\"2.1\">"
+    "  <DataCollection StartupDelaySec=\"0.5\">"
+    "    <DeviceSet Name=\"vtkPlusOpenIGTLinkServerStreamsTest\" Description=\"Two trackers broadcast on separate channels\" />"
+    "    <Device Id=\"TrackerA\" Type=\"FakeTracker\" AcquisitionRate=\"5\" Mode=\"Default\" ToolReferenceFrame=\"TrackerA\">"
+    "      <DataSources>"
+    "        <DataSource Type=\"Tool\" Id=\"Reference\" PortName=\"0\" /> <DataSource Type=\"Tool\" Id=\"Stylus\" PortName=\"1\" />"
+    "        <DataSource Type=\"Tool\" Id=\"Stylus-2\" PortName=\"2\" /> <DataSource Type=\"Tool\" Id=\"Stylus-3\" PortName=\"3\" />"
+    "      </DataSources>"
+    "      <OutputChannels>"
+    "        <OutputChannel Id=\"TrackerAStream\">"
+    "          <DataSource Id=\"Reference\" /> <DataSource Id=\"Stylus\" /> <DataSource Id=\"Stylus-2\" /> <DataSource Id=\"Stylus-3\" />"
+    "        </OutputChannel>"
+    "      </OutputChannels>"
+    "    </Device>"
+    "    <Device Id=\"TrackerB\" Type=\"FakeTracker\" AcquisitionRate=\"50\" Mode=\"Default\" ToolReferenceFrame=\"TrackerB\">"
+    "      <DataSources>"
+    "        <DataSource Type=\"Tool\" Id=\"Reference\" PortName=\"0\" /> <DataSource Type=\"Tool\" Id=\"Stylus\" PortName=\"1\" />"
+    "        <DataSource Type=\"Tool\" Id=\"Stylus-2\" PortName=\"2\" /> <DataSource Type=\"Tool\" Id=\"Stylus-3\" PortName=\"3\" />"
+    "      </DataSources>"
+    "      <OutputChannels>"
+    "        <OutputChannel Id=\"TrackerBStream\">"
+    "          <DataSource Id=\"Reference\" /> <DataSource Id=\"Stylus\" /> <DataSource Id=\"Stylus-2\" /> <DataSource Id=\"Stylus-3\" />"
+    "        </OutputChannel>"
+    "      </OutputChannels>"
+    "    </Device>"
+    "  </DataCollection>"
+    "  <CoordinateDefinitions>"
+    "    <Transform From=\"TrackerA\" To=\"Ras\" Matrix=\"1 0 0 0  0 1 0 0  0 0 1 0  0 0 0 1\" />"
+    "    <Transform From=\"TrackerB\" To=\"Ras\" Matrix=\"1 0 0 1000  0 1 0 0  0 0 1 0  0 0 0 1\" />"
+    "  </CoordinateDefinitions>"
+    "  <PlusOpenIGTLinkServer ListeningPort=\"18961\" OutputChannelId=\"TrackerAStream\" AdditionalOutputChannelIds=\"TrackerBStream\""
+    "    SendValidTransformsOnly=\"TRUE\" LogWarningOnNoDataAvailable=\"FALSE\" />"
+    "</PlusConfiguration>";
+
+  /*! Client of a broadcast channel and the stylus translations that it must receive */
+  struct TestClient
+  {
+    std::string ChannelId;
+    std::map<std::string, double> ExpectedStylusTranslationX;
+    igtl::ClientSocket::Pointer Socket;
+    std::map<std::string, int> NumberOfReceivedTransforms;
+    int NumberOfErrors;
+  };
+
+  //----------------------------------------------------------------------------
+  PlusStatus ConnectClient(TestClient& client, int listeningPort)
+  {
+    client.Socket = igtl::ClientSocket::New();
+    client.NumberOfErrors = 0;
+    if (client.Socket->ConnectToServer("127.0.0.1", listeningPort) != 0)
+    {
+      LOG_ERROR("Client of channel " << client.ChannelId << " could not connect to the server");
+      return PLUS_FAIL;
+    }
+    client.Socket->SetReceiveTimeout(500);
+
+    std::string clientInfoXml = "<ClientInfo OutputChannelId=\"" + client.ChannelId + "\"> <MessageTypes> <Message Type=\"TRANSFORM\" /> </MessageTypes> <TransformNames>";
+    for (std::map<std::string, double>::iterator it = client.ExpectedStylusTranslationX.begin(); it != client.ExpectedStylusTranslationX.end(); ++it)
+    {
+      clientInfoXml += " <Transform Name=\"" + it->first + "\" />";
+    }
+    clientInfoXml += " </TransformNames> </ClientInfo>";
+    PlusIgtlClientInfo clientInfo;
+    if (clientInfo.SetClientInfoFromXmlData(clientInfoXml.c_str()) != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+
+    igtl::PlusClientInfoMessage::Pointer clientInfoMsg = igtl::PlusClientInfoMessage::New();
+    clientInfoMsg->SetDeviceName("TestClient");
+    clientInfoMsg->SetClientInfo(clientInfo);
+    clientInfoMsg->Pack();
+    if (client.Socket->Send(clientInfoMsg->GetBufferPointer(), clientInfoMsg->GetBufferSize()) == 0)
+    {
+      LOG_ERROR("Client of channel " << client.ChannelId << " could not send its client info");
+      return PLUS_FAIL;
+    }
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  void ReceiveTransforms(TestClient* client)
+  {
+    const double startTime = vtkIGSIOAccurateTimer::GetSystemTime();
+    while (vtkIGSIOAccurateTimer::GetSystemTime() < startTime + RECEIVE_TIME_SEC)
+    {
+      igtl::MessageHeader::Pointer headerMsg = igtl::MessageHeader::New();
+      headerMsg->InitBuffer();
+      if (client->Socket->Receive(headerMsg->GetBufferPointer(), headerMsg->GetBufferSize()) != headerMsg->GetBufferSize())
+      {
+        continue;
+      }
+      headerMsg->Unpack();
+      if (strcmp(headerMsg->GetDeviceType(), "TRANSFORM") != 0)
+      {
+        // Keep alive (STATUS) messages
+        client->Socket->Skip(headerMsg->GetBodySizeToRead(), 0);
+        continue;
+      }
+
+      igtl::TransformMessage::Pointer transformMsg = igtl::TransformMessage::New();
+      transformMsg->SetMessageHeader(headerMsg);
+      transformMsg->AllocateBuffer();
+      client->Socket->Receive(transformMsg->GetBufferBodyPointer(), transformMsg->GetBufferBodySize());
+      if (!(transformMsg->Unpack(1) & igtl::MessageHeader::UNPACK_BODY))
+      {
+        LOG_ERROR("Client of channel " << client->ChannelId << " received an invalid transform message");
+        client->NumberOfErrors++;
+        continue;
+      }
+
+      std::string transformName = transformMsg->GetDeviceName();
+      std::map<std::string, double>::iterator expectedIt = client->ExpectedStylusTranslationX.find(transformName);
+      if (expectedIt == client->ExpectedStylusTranslationX.end())
+      {
+        LOG_ERROR("Client of channel " << client->ChannelId << " received a transform that it did not request: " << transformName);
+        client->NumberOfErrors++;
+        continue;
+      }
+      igtl::Matrix4x4 matrix;
+      transformMsg->GetMatrix(matrix);
+      if (fabs(matrix[0][3] - expectedIt->second) > MAX_TRANSLATION_ERROR || fabs(matrix[1][3] - 300.0) > MAX_TRANSLATION_ERROR || fabs(matrix[2][3]) > MAX_TRANSLATION_ERROR)
+      {
+        // Only log the first mismatch, but count all of them
+        if (client->NumberOfErrors == 0)
+        {
+          LOG_ERROR("Client of channel " << client->ChannelId << " received " << transformName << " with translation (" << matrix[0][3] << ", " << matrix[1][3] << ", " << matrix[2][3]
+                    << "), expected (" << expectedIt->second << ", 300, 0). The transform is not computed from the frames of the channel.");
+        }
+        client->NumberOfErrors++;
+      }
+      client->NumberOfReceivedTransforms[transformName]++;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  int TestBroadcastStreams()
+  {
+    vtkSmartPointer<vtkXMLDataElement> configRootElement = vtkSmartPointer<vtkXMLDataElement>::Take(vtkXMLUtilities::ReadElementFromString(DEVICE_SET_CONFIGURATION_XML));
+    if (configRootElement == NULL)
+    {
+      LOG_ERROR("Unable to parse the device set configuration");
+      return 1;
+    }
+    vtkPlusConfig::GetInstance()->SetDeviceSetConfigurationData(configRootElement);
+
+    vtkSmartPointer<vtkPlusDataCollector> dataCollector = vtkSmartPointer<vtkPlusDataCollector>::New();
+    vtkSmartPointer<vtkIGSIOTransformRepository> transformRepository = vtkSmartPointer<vtkIGSIOTransformRepository>::New();
+    if (dataCollector->ReadConfiguration(configRootElement) != PLUS_SUCCESS
+        || transformRepository->ReadConfiguration(configRootElement) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Unable to read the device set configuration");
+      return 1;
+    }
+    if (dataCollector->Connect() != PLUS_SUCCESS || dataCollector->Start() != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Unable to start the data collection");
+      return 1;
+    }
+
+    vtkSmartPointer<vtkPlusOpenIGTLinkServer> server = vtkSmartPointer<vtkPlusOpenIGTLinkServer>::New();
+    if (server->Start(dataCollector, transformRepository, configRootElement->FindNestedElementWithName("PlusOpenIGTLinkServer"), "vtkPlusOpenIGTLinkServerStreamsTest.xml") != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Unable to start the server");
+      dataCollector->Stop();
+      return 1;
+    }
+
+    TestClient clients[2];
+    clients[0].ChannelId = "TrackerAStream";
+    clients[0].ExpectedStylusTranslationX["StylusToTrackerA"] = 0.0;
+    clients[0].ExpectedStylusTranslationX["StylusToTrackerB"] = -1000.0;
+    clients[1].ChannelId = "TrackerBStream";
+    clients[1].ExpectedStylusTranslationX["StylusToTrackerA"] = 1000.0;
+    clients[1].ExpectedStylusTranslationX["StylusToTrackerB"] = 0.0;
+
+    int numberOfErrors(0);
+    if (ConnectClient(clients[0], server->GetListeningPort()) != PLUS_SUCCESS || ConnectClient(clients[1], server->GetListeningPort()) != PLUS_SUCCESS)
+    {
+      numberOfErrors++;
+    }
+    else
+    {
+      std::thread receiverA(ReceiveTransforms, &clients[0]);
+      std::thread receiverB(ReceiveTransforms, &clients[1]);
+      receiverA.join();
+      receiverB.join();
+    }
+
+    for (int i = 0; i < 2; ++i)
+    {
+      numberOfErrors += clients[i].NumberOfErrors;
+      for (std::map<std::string, double>::iterator it = clients[i].ExpectedStylusTranslationX.begin(); it != clients[i].ExpectedStylusTranslationX.end(); ++it)
+      {
+        if (clients[i].NumberOfReceivedTransforms[it->first] == 0)
+        {
+          LOG_ERROR("Client of channel " << clients[i].ChannelId << " did not receive " << it->first);
+          numberOfErrors++;
+        }
+      }
+      if (clients[i].Socket.IsNotNull())
+      {
+        clients[i].Socket->CloseSocket();
+      }
+    }
+
+    // The frames of the fast tracker are sent as they arrive, even though the first channel rarely has new frames
+    const int minNumberOfFastTransforms = static_cast<int>(FAST_TRACKER_RATE * RECEIVE_TIME_SEC / 2);
+    if (clients[1].NumberOfReceivedTransforms["StylusToTrackerB"] < minNumberOfFastTransforms)
+    {
+      LOG_ERROR("Client of channel " << clients[1].ChannelId << " received " << clients[1].NumberOfReceivedTransforms["StylusToTrackerB"]
+                << " frames of the fast tracker (expected at least " << minNumberOfFastTransforms << ")");
+      numberOfErrors++;
+    }
+
+    server->Stop();
+    dataCollector->Stop();
+    dataCollector->Disconnect();
+    return numberOfErrors;
+  }
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  int numberOfErrors = TestBroadcastStreams();
+
+  if (numberOfErrors != 0)
+  {
+    LOG_INFO("Test failed!");
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("Test completed successfully!");
+  return EXIT_SUCCESS;
+}
@@ -13,6 +13,9 @@ See License.txt for details.
 #include "vtkPlusOpenIGTLinkVideoSource.h"
 #include "vtkIGSIOTransformRepository.h"
 
+// OpenIGTLink includes
+#include <igtlClientSocket.h>
+
 // VTK includes
 #include <vtkSmartPointer.h>
 #include <vtksys/CommandLineArguments.hxx>
@@ -109,7 +112,7 @@ PlusStatus DisconnectClients(std::vector< vtkSmartPointer<vtkPlusOpenIGTLinkVide
 }
 
 // -------------------------------------------------
-vtkSmartPointer<vtkPlusOpenIGTLinkServer> StartServer(const std::string& inputConfigFileName)
+vtkSmartPointer<vtkPlusOpenIGTLinkServer> StartServer(const std::string& inputConfigFileName, bool reactorEnabled)
 {
   // Read main configuration file
   std::string configFilePath = inputConfigFileName;
@@ -180,6 +183,10 @@ vtkSmartPointer<vtkPlusOpenIGTLinkServer> StartServer(const std::string& inputCo
 
     // This is a PlusServer tag, let's create it
     vtkSmartPointer<vtkPlusOpenIGTLinkServer> server = vtkSmartPointer<vtkPlusOpenIGTLinkServer>::New();
+    if (reactorEnabled)
+    {
+      serverElement->SetAttribute("ReactorEnabled", "TRUE");
+    }
     LOG_DEBUG("Initializing Plus OpenIGTLink server... ");
     if (server->Start(dataCollector, transformRepository, serverElement, configFilePath) != PLUS_SUCCESS)
     {
@@ -199,6 +206,7 @@ int main(int argc, char** argv)
   bool printHelp(false);
   std::string inputConfigFileName;
   std::string testingConfigFileName;
+  bool reactorEnabled(false);
   int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
 
   const double WAIT_TIME_SEC = 5.0;
@@ -211,6 +219,7 @@ int main(int argc, char** argv)
   args.AddArgument("--server-config-file", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &inputConfigFileName, "Name of the server configuration file.");
   args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
   args.AddArgument("--testing-config-file", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &testingConfigFileName, "Name of the testing configuration file");
+  args.AddArgument("--reactor-enabled", vtksys::CommandLineArguments::NO_ARGUMENT, &reactorEnabled, "Serve the clients by the event loop of the server (Linux only). A client that does not read and a client that closes its connection are added to the test.");
 
   if (!args.Parse())
   {
@@ -244,7 +253,7 @@ int main(int argc, char** argv)
   LOG_INFO("Logging at level " << vtkPlusLogger::Instance()->GetLogLevel() << " (" << vtkPlusLogger::Instance()->GetLogLevelString() << ") to file: " << vtkPlusLogger::Instance()->GetLogFileName());
 
   // Start a server
-  vtkSmartPointer<vtkPlusOpenIGTLinkServer> server = StartServer(inputConfigFileName);
+  vtkSmartPointer<vtkPlusOpenIGTLinkServer> server = StartServer(inputConfigFileName, reactorEnabled);
   if (server == nullptr)
   {
     LOG_ERROR("Unable to start server.");
@@ -267,6 +276,22 @@ int main(int argc, char** argv)
   }
   LOG_INFO("Clients are connected");
 
+  // The event loop must keep serving the clients while a client does not read its data and another one closes its connection
+  igtl::ClientSocket::Pointer stalledClientSocket;
+  if (reactorEnabled)
+  {
+    stalledClientSocket = igtl::ClientSocket::New();
+    igtl::ClientSocket::Pointer closedClientSocket = igtl::ClientSocket::New();
+    if (stalledClientSocket->ConnectToServer("127.0.0.1", server->GetListeningPort()) != 0
+        || closedClientSocket->ConnectToServer("127.0.0.1", server->GetListeningPort()) != 0)
+    {
+      LOG_ERROR("Unable to connect the stalled and closed clients to PlusServer!");
+      DisconnectClients(outTestClients);
+      exit(EXIT_FAILURE);
+    }
+    closedClientSocket->CloseSocket();
+  }
+
   const double commandQueuePollIntervalSec = 0.010;
   const double startTime = vtkIGSIOAccurateTimer::GetSystemTime();
   while (vtkIGSIOAccurateTimer::GetSystemTime() < startTime + WAIT_TIME_SEC)
@@ -279,16 +304,33 @@ int main(int argc, char** argv)
 
   LOG_INFO("Requested testing time elapsed");
 
-  // Make sure all the clients are still connected
+  // Make sure all the clients are still connected (the stalled client too, but not the closed one)
+  unsigned int numOfExpectedConnectedClients = outTestClients.size() + (stalledClientSocket.IsNotNull() ? 1 : 0);
   unsigned int numOfActuallyConnectedClients = server->GetNumberOfConnectedClients();
-  if (numOfActuallyConnectedClients != outTestClients.size())
+  if (numOfActuallyConnectedClients != numOfExpectedConnectedClients)
   {
     LOG_ERROR("Number of connected clients to PlusServer doesn't match the requirements ("
-              << numOfActuallyConnectedClients << " out of " << outTestClients.size() << ").");
+              << numOfActuallyConnectedClients << " out of " << numOfExpectedConnectedClients << ").");
     DisconnectClients(outTestClients);
     exit(EXIT_FAILURE);
   }
 
+  if (reactorEnabled)
+  {
+    // The stalled client must not prevent the other clients from receiving frames
+    for (unsigned int i = 0; i < outTestClients.size(); ++i)
+    {
+      vtkPlusDataSource* aSource(NULL);
+      if ((*(outTestClients[i]->GetOutputChannelsStart()))->GetVideoSource(aSource) != PLUS_SUCCESS || aSource->GetNumberOfItems() == 0)
+      {
+        LOG_ERROR("Client #" << i + 1 << " did not receive any frames.");
+        DisconnectClients(outTestClients);
+        exit(EXIT_FAILURE);
+      }
+    }
+    stalledClientSocket->CloseSocket();
+  }
+
   // Disconnect clients from server
   LOG_INFO("Disconnecting clients...");
   if (DisconnectClients(outTestClients) != PLUS_SUCCESS)
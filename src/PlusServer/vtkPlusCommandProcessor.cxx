@@ -23,6 +23,9 @@ See License.txt for details.
   #include "vtkPlusConoProbeLinkCommand.h"
 #endif
 #include "vtkPlusAddRecordingDeviceCommand.h"
+#include "vtkPlusGetBufferMemoryUsageCommand.h"
+#include "vtkPlusGetLatencyStatisticsCommand.h"
+#include "vtkPlusGetClientSendQueueStatisticsCommand.h"
 #include "vtkPlusGetPolydataCommand.h"
 #include "vtkPlusGetTransformCommand.h"
 #include "vtkPlusGetUsParameterCommand.h"
@@ -67,6 +70,9 @@ vtkPlusCommandProcessor::vtkPlusCommandProcessor()
   RegisterPlusCommand(vtkSmartPointer<vtkPlusSetUsParameterCommand>::New());
   RegisterPlusCommand(vtkSmartPointer<vtkPlusGetUsParameterCommand>::New());
   RegisterPlusCommand(vtkSmartPointer<vtkPlusAddRecordingDeviceCommand>::New());
+  RegisterPlusCommand(vtkSmartPointer<vtkPlusGetBufferMemoryUsageCommand>::New());
+  RegisterPlusCommand(vtkSmartPointer<vtkPlusGetLatencyStatisticsCommand>::New());
+  RegisterPlusCommand(vtkSmartPointer<vtkPlusGetClientSendQueueStatisticsCommand>::New());
 #ifdef PLUS_USE_STEALTHLINK
   RegisterPlusCommand(vtkSmartPointer<vtkPlusStealthLinkCommand>::New());
 #endif
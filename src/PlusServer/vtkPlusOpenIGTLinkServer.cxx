@@ -8,6 +8,8 @@ See License.txt for details.
 #include "PlusConfigure.h"
 #include "PlusCommon.h"
 #include "PlusConfigure.h"
+#include "PlusClock.h"
+#include "PlusIgtlSocketDescriptorAccessor.h"
 #include "igsioTrackedFrame.h"
 #include "vtkPlusChannel.h"
 #include "vtkPlusCommand.h"
@@ -33,6 +35,7 @@ See License.txt for details.
 #include <igtlImageMetaMessage.h>
 #include <igtlMessageHeader.h>
 #include <igtlPlusClientInfoMessage.h>
+#include <igtlPlusImageMessage.h>
 #include <igtlPointMessage.h>
 #include <igtlPolyDataMessage.h>
 #include <igtlStatusMessage.h>
@@ -51,6 +54,8 @@ See License.txt for details.
 #endif
 
 // STL includes
+#include <algorithm>
+#include <chrono>
 #include <fstream>
 #include <streambuf>
 
@@ -68,6 +73,22 @@ namespace
   // then we skip a SAMPLING_SKIPPING_MARGIN_SEC long period to allow the application to catch up.
   // This time should be long enough to comfortably retrieve a frame from the buffer.
   const double SAMPLING_SKIPPING_MARGIN_SEC = 0.1;
+
+  //----------------------------------------------------------------------------
+  // Channels that contain the same data sources provide the same tracked frames
+  bool HaveSameDataSources(vtkPlusChannel* channel1, vtkPlusChannel* channel2)
+  {
+    vtkPlusDataSource* videoSource1(NULL);
+    vtkPlusDataSource* videoSource2(NULL);
+    channel1->GetVideoSource(videoSource1);
+    channel2->GetVideoSource(videoSource2);
+    return videoSource1 == videoSource2
+           && channel1->GetNewFrameMasterSource() == channel2->GetNewFrameMasterSource()
+           && channel1->ToolCount() == channel2->ToolCount()
+           && std::equal(channel1->GetToolsStartConstIterator(), channel1->GetToolsEndConstIterator(), channel2->GetToolsStartConstIterator())
+           && channel1->FieldCount() == channel2->FieldCount()
+           && std::equal(channel1->GetFieldDataSourcesStartConstIterator(), channel1->GetFieldDataSourcesEndConstIterator(), channel2->GetFieldDataSourcesStartConstIterator());
+  }
 }
 
 //----------------------------------------------------------------------------
@@ -88,28 +109,35 @@ vtkPlusOpenIGTLinkServer::vtkPlusOpenIGTLinkServer()
   , NumberOfRetryAttempts(10)
   , DelayBetweenRetryAttemptsSec(0.05)
   , MaxNumberOfIgtlMessagesToSend(100)
+  , ReactorEnabled(false)
+  , JoinTrackedFrames(false)
+  , MaxClientSendQueueLength(100)
   , ConnectionReceiverThreadId(-1)
   , DataSenderThreadId(-1)
   , IgtlMessageFactory(vtkSmartPointer<vtkPlusIgtlMessageFactory>::New())
   , IgtlClientsMutex(vtkSmartPointer<vtkIGSIORecursiveCriticalSection>::New())
-  , LastSentTrackedFrameTimestamp(0)
   , MaxTimeSpentWithProcessingMs(50)
-  , LastProcessingTimePerFrameMs(-1)
   , SendValidTransformsOnly(true)
   , DefaultClientSendTimeoutSec(CLIENT_SOCKET_TIMEOUT_SEC)
   , DefaultClientReceiveTimeoutSec(CLIENT_SOCKET_TIMEOUT_SEC)
   , IgtlMessageCrcCheckEnabled(0)
   , PlusCommandProcessor(vtkSmartPointer<vtkPlusCommandProcessor>::New())
   , MessageResponseQueueMutex(vtkSmartPointer<vtkIGSIORecursiveCriticalSection>::New())
-  , BroadcastChannel(NULL)
+  , NewFramesSequenceNumber(0)
   , LogWarningOnNoDataAvailable(true)
   , KeepAliveIntervalSec(CLIENT_SOCKET_TIMEOUT_SEC / 2.0)
+  , LatencyLogIntervalSec(0.0)
+  , LastLatencyLogTime(0.0)
   , GracePeriodLogLevel(vtkPlusLogger::LOG_LEVEL_DEBUG)
   , MissingInputGracePeriodSec(0.0)
   , BroadcastStartTime(0.0)
   , NewClientConnected(false)
 {
-
+  // Only the latest image of a stream is worth sending to a client that cannot keep up with the data.
+  // VIDEO frames depend on the previous frames of the stream, so they are not replaced by the next one.
+  this->SendQueueDropPolicies["IMAGE"] = PlusIgtlClientSendQueue::DROP_POLICY_KEEP_LATEST;
+  this->SendQueueDropPolicies["USMESSAGE"] = PlusIgtlClientSendQueue::DROP_POLICY_KEEP_LATEST;
+  this->SendQueueDropPolicies["TRACKEDFRAME"] = PlusIgtlClientSendQueue::DROP_POLICY_KEEP_LATEST;
 }
 
 //----------------------------------------------------------------------------
@@ -167,7 +195,16 @@ PlusStatus vtkPlusOpenIGTLinkServer::StartOpenIGTLinkService()
   if (this->ConnectionReceiverThreadId < 0)
   {
     this->ConnectionActive.Request = true;
-    this->ConnectionReceiverThreadId = this->Threader->SpawnThread((vtkThreadFunctionType)&ConnectionReceiverThread, this);
+#if defined(__linux__)
+    if (this->ReactorEnabled)
+    {
+      this->ConnectionReceiverThreadId = this->Threader->SpawnThread((vtkThreadFunctionType)&ReactorThread, this);
+    }
+    else
+#endif
+    {
+      this->ConnectionReceiverThreadId = this->Threader->SpawnThread((vtkThreadFunctionType)&ConnectionReceiverThread, this);
+    }
   }
 
   if (this->DataSenderThreadId < 0)
@@ -258,45 +295,8 @@ void* vtkPlusOpenIGTLinkServer::ConnectionReceiverThread(vtkMultiThreader::Threa
     {
       // Lock before we change the clients list
       igsioLockGuard<vtkIGSIORecursiveCriticalSection> igtlClientsMutexGuardedLock(self->IgtlClientsMutex);
-      ClientData newClient;
-      self->IgtlClients.push_back(newClient);
-      self->NewClientConnected = true;
-
-      ClientData* client = &(self->IgtlClients.back());   // get a reference to the client data that is stored in the list
-      client->ClientId = self->ClientIdCounter;
-      self->ClientIdCounter++;
-      client->ClientSocket = newClientSocket;
-      client->ClientSocket->SetReceiveTimeout(self->DefaultClientReceiveTimeoutSec * 1000);
-      client->ClientSocket->SetSendTimeout(self->DefaultClientSendTimeoutSec * 1000);
-      client->ClientInfo = self->DefaultClientInfo;
-      client->Server = self;
-
-      // Setup vtkIGSIOFrameConverters for each stream
-      for (std::vector<PlusIgtlClientInfo::ImageStream>::iterator imageStreamIterator = client->ClientInfo.ImageStreams.begin();
-        imageStreamIterator != client->ClientInfo.ImageStreams.end(); ++imageStreamIterator)
-      {
-        PlusIgtlClientInfo::ImageStream* imageStream = &(*imageStreamIterator);
-        if (!imageStream->FrameConverter)
-        {
-          imageStream->FrameConverter = vtkSmartPointer<vtkIGSIOFrameConverter>::New();
-        }
-      }
-      for (std::vector<PlusIgtlClientInfo::VideoStream>::iterator videoStreamIterator = client->ClientInfo.VideoStreams.begin();
-           videoStreamIterator != client->ClientInfo.VideoStreams.end(); ++videoStreamIterator)
-      {
-        PlusIgtlClientInfo::VideoStream* videoStream = &(*videoStreamIterator);
-        if (!videoStream->FrameConverter)
-        {
-          videoStream->FrameConverter = vtkSmartPointer<vtkIGSIOFrameConverter>::New();
-        }
-      }
-
-      int port = 0;
-      std::string address = "unknown";
-#if (OPENIGTLINK_VERSION_MAJOR > 1) || ( OPENIGTLINK_VERSION_MAJOR == 1 && OPENIGTLINK_VERSION_MINOR > 9 ) || ( OPENIGTLINK_VERSION_MAJOR == 1 && OPENIGTLINK_VERSION_MINOR == 9 && OPENIGTLINK_VERSION_PATCH > 4 )
-      newClientSocket->GetSocketAddressAndPort(address, port);
-#endif
-      LOG_INFO("Received new client connection (client " << client->ClientId << " at " << address << ":" << port << "). Number of connected clients: " << self->GetNumberOfConnectedClients());
+      ClientData* client = self->AddClient(newClientSocket);
+      client->SendQueue->Start();
 
       client->DataReceiverActive.first = true;
       client->DataReceiverThreadId = self->Threader->SpawnThread((vtkThreadFunctionType)&DataReceiverThread, client);
@@ -315,27 +315,137 @@ void* vtkPlusOpenIGTLinkServer::ConnectionReceiverThread(vtkMultiThreader::Threa
   return NULL;
 }
 
+//----------------------------------------------------------------------------
+ClientData* vtkPlusOpenIGTLinkServer::AddClient(igtl::ClientSocket::Pointer clientSocket)
+{
+  ClientData newClient;
+  this->IgtlClients.push_back(newClient);
+  this->NewClientConnected = true;
+
+  ClientData* client = &(this->IgtlClients.back());   // get a reference to the client data that is stored in the list
+  client->ClientId = this->ClientIdCounter;
+  this->ClientIdCounter++;
+  client->ClientSocket = clientSocket;
+  client->ClientSocket->SetReceiveTimeout(this->DefaultClientReceiveTimeoutSec * 1000);
+  client->ClientSocket->SetSendTimeout(this->DefaultClientSendTimeoutSec * 1000);
+  client->ClientInfo = this->DefaultClientInfo;
+  client->Server = this;
+  client->SendQueue = std::make_shared<PlusIgtlClientSendQueue>(clientSocket, this->MaxClientSendQueueLength,
+                      this->NumberOfRetryAttempts, this->DelayBetweenRetryAttemptsSec, client->SendLatencyHistogram);
+
+  // Setup vtkIGSIOFrameConverters for each stream
+  for (std::vector<PlusIgtlClientInfo::ImageStream>::iterator imageStreamIterator = client->ClientInfo.ImageStreams.begin();
+    imageStreamIterator != client->ClientInfo.ImageStreams.end(); ++imageStreamIterator)
+  {
+    PlusIgtlClientInfo::ImageStream* imageStream = &(*imageStreamIterator);
+    if (!imageStream->FrameConverter)
+    {
+      imageStream->FrameConverter = vtkSmartPointer<vtkIGSIOFrameConverter>::New();
+    }
+  }
+  for (std::vector<PlusIgtlClientInfo::VideoStream>::iterator videoStreamIterator = client->ClientInfo.VideoStreams.begin();
+       videoStreamIterator != client->ClientInfo.VideoStreams.end(); ++videoStreamIterator)
+  {
+    PlusIgtlClientInfo::VideoStream* videoStream = &(*videoStreamIterator);
+    if (!videoStream->FrameConverter)
+    {
+      videoStream->FrameConverter = vtkSmartPointer<vtkIGSIOFrameConverter>::New();
+    }
+  }
+
+  int port = 0;
+  std::string address = "unknown";
+#if (OPENIGTLINK_VERSION_MAJOR > 1) || ( OPENIGTLINK_VERSION_MAJOR == 1 && OPENIGTLINK_VERSION_MINOR > 9 ) || ( OPENIGTLINK_VERSION_MAJOR == 1 && OPENIGTLINK_VERSION_MINOR == 9 && OPENIGTLINK_VERSION_PATCH > 4 )
+  clientSocket->GetSocketAddressAndPort(address, port);
+#endif
+  LOG_INFO("Received new client connection (client " << client->ClientId << " at " << address << ":" << port << "). Number of connected clients: " << this->GetNumberOfConnectedClients());
+
+  return client;
+}
+
 //----------------------------------------------------------------------------
 void* vtkPlusOpenIGTLinkServer::DataSenderThread(vtkMultiThreader::ThreadInfo* data)
 {
   vtkPlusOpenIGTLinkServer* self = (vtkPlusOpenIGTLinkServer*)(data->UserData);
   self->DataSenderActive.Respond = true;
 
+  if (self->SetUpBroadcastStreams() != PLUS_SUCCESS)
+  {
+    self->ClearBroadcastStreams();
+    return NULL;
+  }
+
+  double elapsedTimeSinceLastPacketSentSec = 0;
+  self->LastLatencyLogTime = PlusClock::GetSystemTime();
+  while (self->ConnectionActive.Request && self->DataSenderActive.Request)
+  {
+    self->LogLatencyStatistics();
+    self->DisconnectFailedClients();
+
+    bool clientsConnected = false;
+    {
+      igsioLockGuard<vtkIGSIORecursiveCriticalSection> igtlClientsMutexGuardedLock(self->IgtlClientsMutex);
+      if (!self->IgtlClients.empty())
+      {
+        clientsConnected = true;
+      }
+    }
+    if (!clientsConnected)
+    {
+      // No client connected, wait for a while
+      vtkIGSIOAccurateTimer::Delay(0.2);
+      for (std::vector<BroadcastStream>::iterator streamIt = self->BroadcastStreams.begin(); streamIt != self->BroadcastStreams.end(); ++streamIt)
+      {
+        streamIt->LastSentTrackedFrameTimestamp = 0; // next time start sending from the most recent timestamp
+        if (streamIt->FrameJoiner)
+        {
+          streamIt->FrameJoiner->ClearReadyFrames();
+        }
+      }
+      continue;
+    }
+
+    if (self->HasGracePeriodExpired())
+    {
+      self->GracePeriodLogLevel = vtkPlusLogger::LOG_LEVEL_WARNING;
+    }
+
+    SendMessageResponses(*self);
+
+    // Send remote command execution replies to clients before sending any images/transforms/etc...
+    SendCommandResponses(*self);
+
+    // Send image/tracking/string data
+    SendLatestFramesToClients(*self, elapsedTimeSinceLastPacketSentSec);
+  }
+  self->ClearBroadcastStreams();
+  // Close thread
+  self->DataSenderThreadId = -1;
+  self->DataSenderActive.Respond = false;
+  return NULL;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusOpenIGTLinkServer::SetUpBroadcastStreams()
+{
+  this->ClearBroadcastStreams();
+  this->DefaultBroadcastChannelId.clear();
+
   vtkPlusDevice* aDevice(NULL);
   vtkPlusChannel* aChannel(NULL);
 
   DeviceCollection aCollection;
-  if (self->DataCollector->GetDevices(aCollection) != PLUS_SUCCESS || aCollection.size() == 0)
+  if (this->DataCollector->GetDevices(aCollection) != PLUS_SUCCESS || aCollection.size() == 0)
   {
     LOG_ERROR("Unable to retrieve devices. Check configuration and connection.");
-    return NULL;
+    return PLUS_FAIL;
   }
 
   // Find the requested channel ID in all the devices
   for (DeviceCollectionIterator it = aCollection.begin(); it != aCollection.end(); ++it)
   {
     aDevice = *it;
-    if (aDevice->GetOutputChannelByName(aChannel, self->GetOutputChannelId()) == PLUS_SUCCESS)
+    if (aDevice->GetOutputChannelByName(aChannel, this->GetOutputChannelId()) == PLUS_SUCCESS)
     {
       break;
     }
@@ -344,12 +454,12 @@ void* vtkPlusOpenIGTLinkServer::DataSenderThread(vtkMultiThreader::ThreadInfo* d
   if (aChannel == NULL)
   {
     // The requested channel ID is not found
-    if (!self->GetOutputChannelId().empty())
+    if (!this->GetOutputChannelId().empty())
     {
       // the user explicitly requested a specific channel, but none was found by that name
       // this is an error
-      LOG_ERROR("Unable to start data sending. OutputChannelId not found: " << self->GetOutputChannelId());
-      return NULL;
+      LOG_ERROR("Unable to start data sending. OutputChannelId not found: " << this->GetOutputChannelId());
+      return PLUS_FAIL;
     }
     // the user did not specify any channel, so just use the first channel that can be found in any device
     for (DeviceCollectionIterator it = aCollection.begin(); it != aCollection.end(); ++it)
@@ -367,101 +477,160 @@ void* vtkPlusOpenIGTLinkServer::DataSenderThread(vtkMultiThreader::ThreadInfo* d
   if (aChannel == NULL)
   {
     LOG_WARNING("There are no channels to broadcast. Only command processing is available.");
+    return PLUS_SUCCESS;
   }
+  this->DefaultBroadcastChannelId = (aChannel->GetChannelId() != NULL ? aChannel->GetChannelId() : "");
 
-  self->BroadcastChannel = aChannel;
-  if (self->BroadcastChannel)
+  std::vector<vtkPlusChannel*> channels;
+  channels.push_back(aChannel);
+  for (std::vector<std::string>::iterator channelIdIt = this->AdditionalOutputChannelIds.begin(); channelIdIt != this->AdditionalOutputChannelIds.end(); ++channelIdIt)
   {
-    self->BroadcastChannel->GetMostRecentTimestamp(self->LastSentTrackedFrameTimestamp);
+    vtkPlusChannel* additionalChannel(NULL);
+    if (this->DataCollector->GetChannel(additionalChannel, *channelIdIt) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Unable to start data sending. Additional output channel not found: " << *channelIdIt);
+      return PLUS_FAIL;
+    }
+    if (std::find(channels.begin(), channels.end(), additionalChannel) == channels.end())
+    {
+      channels.push_back(additionalChannel);
+    }
   }
 
-  double elapsedTimeSinceLastPacketSentSec = 0;
-  while (self->ConnectionActive.Request && self->DataSenderActive.Request)
+  for (std::vector<vtkPlusChannel*>::iterator channelIt = channels.begin(); channelIt != channels.end(); ++channelIt)
   {
-    bool clientsConnected = false;
+    std::string channelId = ((*channelIt)->GetChannelId() != NULL ? (*channelIt)->GetChannelId() : "");
+
+    // Channels with the same data sources provide the same frames, retrieve and pack them only once
+    std::vector<BroadcastStream>::iterator streamIt = this->BroadcastStreams.begin();
+    for (; streamIt != this->BroadcastStreams.end(); ++streamIt)
     {
-      igsioLockGuard<vtkIGSIORecursiveCriticalSection> igtlClientsMutexGuardedLock(self->IgtlClientsMutex);
-      if (!self->IgtlClients.empty())
+      if (HaveSameDataSources(streamIt->Channel, *channelIt))
       {
-        clientsConnected = true;
+        break;
       }
     }
-    if (!clientsConnected)
+    if (streamIt != this->BroadcastStreams.end())
     {
-      // No client connected, wait for a while
-      vtkIGSIOAccurateTimer::Delay(0.2);
-      self->LastSentTrackedFrameTimestamp = 0; // next time start sending from the most recent timestamp
+      LOG_DEBUG("Channel " << channelId << " is broadcast together with channel " << streamIt->ChannelIds.front() << ", as they contain the same data sources");
+      streamIt->ChannelIds.push_back(channelId);
       continue;
     }
 
-    if (self->HasGracePeriodExpired())
+    BroadcastStream stream;
+    stream.Channel = *channelIt;
+    stream.ChannelIds.push_back(channelId);
+    stream.Channel->GetMostRecentTimestamp(stream.LastSentTrackedFrameTimestamp);
+    stream.TransformRepository = vtkSmartPointer<vtkIGSIOTransformRepository>::New();
+    // The data sender thread is woken up when a frame of any stream can be sent
+    if (this->JoinTrackedFrames)
     {
-      self->GracePeriodLogLevel = vtkPlusLogger::LOG_LEVEL_WARNING;
+      stream.FrameJoiner = std::make_shared<PlusTrackedFrameJoiner>(stream.Channel);
+      stream.FrameJoiner->SetMaxNumberOfReadyFrames(this->MaxNumberOfIgtlMessagesToSend);
+      stream.FrameJoiner->SetFramesReadyCallback([this]()
+      {
+        this->NotifyNewFrames();
+      });
+      if (stream.FrameJoiner->Start() != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Unable to start data sending. Failed to join the data sources of channel " << channelId);
+        return PLUS_FAIL;
+      }
+    }
+    else
+    {
+      stream.NewFrameCallbackId = stream.Channel->AddNewFrameCallback([this](vtkPlusChannel*, double)
+      {
+        this->NotifyNewFrames();
+      });
     }
+    this->BroadcastStreams.push_back(stream);
+  }
 
-    SendMessageResponses(*self);
+  return PLUS_SUCCESS;
+}
 
-    // Send remote command execution replies to clients before sending any images/transforms/etc...
-    SendCommandResponses(*self);
+//----------------------------------------------------------------------------
+void vtkPlusOpenIGTLinkServer::ClearBroadcastStreams()
+{
+  for (std::vector<BroadcastStream>::iterator streamIt = this->BroadcastStreams.begin(); streamIt != this->BroadcastStreams.end(); ++streamIt)
+  {
+    if (streamIt->NewFrameCallbackId != 0)
+    {
+      streamIt->Channel->RemoveNewFrameCallback(streamIt->NewFrameCallbackId);
+    }
+  }
+  // The frame joiners are stopped when they are deleted
+  this->BroadcastStreams.clear();
+}
 
-    // Send image/tracking/string data
-    SendLatestFramesToClients(*self, elapsedTimeSinceLastPacketSentSec);
+//----------------------------------------------------------------------------
+void vtkPlusOpenIGTLinkServer::NotifyNewFrames()
+{
+  {
+    std::lock_guard<std::mutex> lock(this->NewFramesMutex);
+    ++this->NewFramesSequenceNumber;
   }
-  // Close thread
-  self->DataSenderThreadId = -1;
-  self->DataSenderActive.Respond = false;
-  return NULL;
+  this->NewFramesAvailable.notify_all();
+}
+
+//----------------------------------------------------------------------------
+bool vtkPlusOpenIGTLinkServer::WaitForNewFrames(unsigned long long& sequenceNumber, double timeoutSec)
+{
+  std::unique_lock<std::mutex> lock(this->NewFramesMutex);
+  bool newFramesAvailable = this->NewFramesAvailable.wait_for(lock, std::chrono::duration<double>(timeoutSec), [this, &sequenceNumber]()
+  {
+    return this->NewFramesSequenceNumber != sequenceNumber;
+  });
+  sequenceNumber = this->NewFramesSequenceNumber;
+  return newFramesAvailable;
 }
 
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusOpenIGTLinkServer::SendLatestFramesToClients(vtkPlusOpenIGTLinkServer& self, double& elapsedTimeSinceLastPacketSentSec)
 {
-  vtkSmartPointer<vtkIGSIOTrackedFrameList> trackedFrameList = vtkSmartPointer<vtkIGSIOTrackedFrameList>::New();
-  double startTimeSec = vtkIGSIOAccurateTimer::GetSystemTime();
+  double startTimeSec = PlusClock::GetSystemTime();
 
-  // Acquire tracked frames since last acquisition (minimum 1 frame)
-  if (self.LastProcessingTimePerFrameMs < 1)
+  // Get the cursor before getting the frames, so that a frame of any stream that arrives meanwhile ends the waiting for new frames
+  unsigned long long newFramesSequenceNumber = 0;
   {
-    // if processing was less than 1ms/frame then assume it was 1ms (1000FPS processing speed) to avoid division by zero
-    self.LastProcessingTimePerFrameMs = 1;
+    std::lock_guard<std::mutex> lock(self.NewFramesMutex);
+    newFramesSequenceNumber = self.NewFramesSequenceNumber;
   }
-  int numberOfFramesToGet = std::max(self.MaxTimeSpentWithProcessingMs / self.LastProcessingTimePerFrameMs, 1);
-  // Maximize the number of frames to send
-  numberOfFramesToGet = std::min(numberOfFramesToGet, self.MaxNumberOfIgtlMessagesToSend);
 
-  if (self.BroadcastChannel != NULL)
+  bool hasSubscribedStream = false;
+  int numberOfSentFrames = 0;
+  for (std::vector<BroadcastStream>::iterator streamIt = self.BroadcastStreams.begin(); streamIt != self.BroadcastStreams.end(); ++streamIt)
   {
-    if ((self.BroadcastChannel->HasVideoSource() && !self.BroadcastChannel->GetVideoDataAvailable())
-        || (self.BroadcastChannel->ToolCount() > 0 && !self.BroadcastChannel->GetTrackingDataAvailable())
-        || (self.BroadcastChannel->FieldCount() > 0 && !self.BroadcastChannel->GetFieldDataAvailable()))
-    {
-      if (self.LogWarningOnNoDataAvailable)
-      {
-        LOG_DYNAMIC("No data is broadcasted, as no data is available yet.", self.GracePeriodLogLevel);
-      }
-    }
-    else
+    if (!self.HasSubscribedClients(*streamIt))
     {
-      double oldestDataTimestamp = 0;
-      if (self.BroadcastChannel->GetOldestTimestamp(oldestDataTimestamp) == PLUS_SUCCESS)
+      streamIt->LastSentTrackedFrameTimestamp = 0; // next time start sending from the most recent timestamp
+      if (streamIt->FrameJoiner)
       {
-        if (self.LastSentTrackedFrameTimestamp < oldestDataTimestamp)
-        {
-          LOG_INFO("OpenIGTLink broadcasting started. No data was available between " << self.LastSentTrackedFrameTimestamp << "-" << oldestDataTimestamp << "sec, therefore no data were broadcasted during this time period.");
-          self.LastSentTrackedFrameTimestamp = oldestDataTimestamp + SAMPLING_SKIPPING_MARGIN_SEC;
-        }
-        static vtkIGSIOLogHelper logHelper(60.0, 500000);
-        CUSTOM_RETURN_WITH_FAIL_IF(self.BroadcastChannel->GetTrackedFrameList(self.LastSentTrackedFrameTimestamp, trackedFrameList, numberOfFramesToGet) != PLUS_SUCCESS,
-                                   "Failed to get tracked frame list from data collector (last recorded timestamp: " << std::fixed << self.LastSentTrackedFrameTimestamp);
+        streamIt->FrameJoiner->ClearReadyFrames();
       }
+      continue;
     }
+    hasSubscribedStream = true;
+    int numberOfSentFramesOfStream = 0;
+    SendLatestFramesOfStream(self, *streamIt, numberOfSentFramesOfStream);
+    numberOfSentFrames += numberOfSentFramesOfStream;
   }
 
-  // There is no new frame in the buffer
-  if (trackedFrameList->GetNumberOfTrackedFrames() == 0)
+  // There is no new frame in the buffers
+  if (numberOfSentFrames == 0)
   {
-    vtkIGSIOAccurateTimer::Delay(DELAY_ON_NO_NEW_FRAMES_SEC);
-    elapsedTimeSinceLastPacketSentSec += vtkIGSIOAccurateTimer::GetSystemTime() - startTimeSec;
+    if (hasSubscribedStream)
+    {
+      // Wake up as soon as a new frame is available in any of the streams (but no later than the usual delay, to keep serving
+      // command responses and the clients that subscribe meanwhile)
+      self.WaitForNewFrames(newFramesSequenceNumber, DELAY_ON_NO_NEW_FRAMES_SEC);
+    }
+    else
+    {
+      vtkIGSIOAccurateTimer::Delay(DELAY_ON_NO_NEW_FRAMES_SEC);
+    }
+    elapsedTimeSinceLastPacketSentSec += PlusClock::GetSystemTime() - startTimeSec;
 
     // Send keep alive packet to clients
     if (elapsedTimeSinceLastPacketSentSec > self.KeepAliveIntervalSec)
@@ -474,24 +643,106 @@ PlusStatus vtkPlusOpenIGTLinkServer::SendLatestFramesToClients(vtkPlusOpenIGTLin
     return PLUS_FAIL;
   }
 
+  elapsedTimeSinceLastPacketSentSec = 0;
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusOpenIGTLinkServer::SendLatestFramesOfStream(vtkPlusOpenIGTLinkServer& self, BroadcastStream& stream, int& numberOfSentFrames)
+{
+  numberOfSentFrames = 0;
+  vtkSmartPointer<vtkIGSIOTrackedFrameList> trackedFrameList = vtkSmartPointer<vtkIGSIOTrackedFrameList>::New();
+  double startTimeSec = PlusClock::GetSystemTime();
+
+  // Acquire tracked frames since last acquisition (minimum 1 frame)
+  if (stream.LastProcessingTimePerFrameMs < 1)
+  {
+    // if processing was less than 1ms/frame then assume it was 1ms (1000FPS processing speed) to avoid division by zero
+    stream.LastProcessingTimePerFrameMs = 1;
+  }
+  int numberOfFramesToGet = std::max(self.MaxTimeSpentWithProcessingMs / stream.LastProcessingTimePerFrameMs, 1);
+  // Maximize the number of frames to send
+  numberOfFramesToGet = std::min(numberOfFramesToGet, self.MaxNumberOfIgtlMessagesToSend);
+
+  if ((stream.Channel->HasVideoSource() && !stream.Channel->GetVideoDataAvailable())
+      || (stream.Channel->ToolCount() > 0 && !stream.Channel->GetTrackingDataAvailable())
+      || (stream.Channel->FieldCount() > 0 && !stream.Channel->GetFieldDataAvailable()))
+  {
+    if (self.LogWarningOnNoDataAvailable)
+    {
+      LOG_DYNAMIC("No data is broadcasted from channel " << stream.ChannelIds.front() << ", as no data is available yet.", self.GracePeriodLogLevel);
+    }
+    return PLUS_SUCCESS;
+  }
+
+  if (stream.FrameJoiner)
+  {
+    // The joiner has already retrieved the frames that all the sources have data for
+    if (stream.FrameJoiner->PopReadyFrames(trackedFrameList, numberOfFramesToGet) > 0)
+    {
+      stream.LastSentTrackedFrameTimestamp = trackedFrameList->GetTrackedFrame(trackedFrameList->GetNumberOfTrackedFrames() - 1)->GetTimestamp();
+    }
+  }
+  else
+  {
+    double oldestDataTimestamp = 0;
+    if (stream.Channel->GetOldestTimestamp(oldestDataTimestamp) != PLUS_SUCCESS)
+    {
+      return PLUS_SUCCESS;
+    }
+    if (stream.LastSentTrackedFrameTimestamp < oldestDataTimestamp)
+    {
+      LOG_INFO("OpenIGTLink broadcasting of channel " << stream.ChannelIds.front() << " started. No data was available between " << stream.LastSentTrackedFrameTimestamp << "-" << oldestDataTimestamp << "sec, therefore no data were broadcasted during this time period.");
+      stream.LastSentTrackedFrameTimestamp = oldestDataTimestamp + SAMPLING_SKIPPING_MARGIN_SEC;
+    }
+    static vtkIGSIOLogHelper logHelper(60.0, 500000);
+    CUSTOM_RETURN_WITH_FAIL_IF(stream.Channel->GetTrackedFrameList(stream.LastSentTrackedFrameTimestamp, trackedFrameList, numberOfFramesToGet) != PLUS_SUCCESS,
+                               "Failed to get tracked frame list from data collector (last recorded timestamp: " << std::fixed << stream.LastSentTrackedFrameTimestamp);
+  }
+
+  if (trackedFrameList->GetNumberOfTrackedFrames() > 0 && self.TransformRepository != NULL)
+  {
+    // Pick up the transforms that have been changed by commands since the previous frames of the stream
+    stream.TransformRepository->DeepCopy(self.TransformRepository, false);
+  }
   for (unsigned int i = 0; i < trackedFrameList->GetNumberOfTrackedFrames(); ++i)
   {
     // Send tracked frame
-    self.SendTrackedFrame(*trackedFrameList->GetTrackedFrame(i));
-    elapsedTimeSinceLastPacketSentSec = 0;
+    self.SendTrackedFrame(*trackedFrameList->GetTrackedFrame(i), stream.ChannelIds, stream.TransformRepository);
   }
 
-  // Compute time spent with processing one frame in this round
-  double computationTimeMs = (vtkIGSIOAccurateTimer::GetSystemTime() - startTimeSec) * 1000.0;
-
   // Update last processing time if new tracked frames have been acquired
   if (trackedFrameList->GetNumberOfTrackedFrames() > 0)
   {
-    self.LastProcessingTimePerFrameMs = computationTimeMs / trackedFrameList->GetNumberOfTrackedFrames();
+    // Compute time spent with processing one frame in this round
+    double computationTimeMs = (PlusClock::GetSystemTime() - startTimeSec) * 1000.0;
+    stream.LastProcessingTimePerFrameMs = computationTimeMs / trackedFrameList->GetNumberOfTrackedFrames();
   }
+  numberOfSentFrames = trackedFrameList->GetNumberOfTrackedFrames();
   return PLUS_SUCCESS;
 }
 
+//----------------------------------------------------------------------------
+bool vtkPlusOpenIGTLinkServer::IsClientSubscribed(const ClientData& client, const std::vector<std::string>& channelIds) const
+{
+  const std::string& clientChannelId = (client.ClientInfo.OutputChannelId.empty() ? this->DefaultBroadcastChannelId : client.ClientInfo.OutputChannelId);
+  return std::find(channelIds.begin(), channelIds.end(), clientChannelId) != channelIds.end();
+}
+
+//----------------------------------------------------------------------------
+bool vtkPlusOpenIGTLinkServer::HasSubscribedClients(const BroadcastStream& stream) const
+{
+  igsioLockGuard<vtkIGSIORecursiveCriticalSection> igtlClientsMutexGuardedLock(this->IgtlClientsMutex);
+  for (std::list<ClientData>::const_iterator clientIterator = this->IgtlClients.begin(); clientIterator != this->IgtlClients.end(); ++clientIterator)
+  {
+    if (this->IsClientSubscribed(*clientIterator, stream.ChannelIds))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusOpenIGTLinkServer::SendMessageResponses(vtkPlusOpenIGTLinkServer& self)
 {
@@ -501,25 +752,26 @@ PlusStatus vtkPlusOpenIGTLinkServer::SendMessageResponses(vtkPlusOpenIGTLinkServ
     for (ClientIdToMessageListMap::iterator it = self.MessageResponseQueue.begin(); it != self.MessageResponseQueue.end(); ++it)
     {
       igsioLockGuard<vtkIGSIORecursiveCriticalSection> igtlClientsMutexGuardedLock(self.IgtlClientsMutex);
-      igtl::ClientSocket::Pointer clientSocket = NULL;
+      std::shared_ptr<PlusIgtlClientSendQueue> sendQueue;
 
       for (std::list<ClientData>::iterator clientIterator = self.IgtlClients.begin(); clientIterator != self.IgtlClients.end(); ++clientIterator)
       {
         if (clientIterator->ClientId == it->first)
         {
-          clientSocket = clientIterator->ClientSocket;
+          sendQueue = clientIterator->SendQueue;
           break;
         }
       }
-      if (clientSocket.IsNull())
+      if (!sendQueue)
       {
         LOG_WARNING("Message reply cannot be sent to client " << it->first << ", probably client has been disconnected.");
         continue;
       }
 
+      // Replies are never dropped
       for (std::vector<igtl::MessageBase::Pointer>::iterator messageIt = it->second.begin(); messageIt != it->second.end(); ++messageIt)
       {
-        clientSocket->Send((*messageIt)->GetBufferPointer(), (*messageIt)->GetBufferSize());
+        sendQueue->QueueMessage(*messageIt, PlusIgtlClientSendQueue::DROP_POLICY_NEVER);
       }
     }
     self.MessageResponseQueue.clear();
@@ -548,22 +800,22 @@ PlusStatus vtkPlusOpenIGTLinkServer::SendCommandResponses(vtkPlusOpenIGTLinkServ
       // Only send the response to the client that requested the command
       LOG_DEBUG("Send command reply to client " << (*responseIt)->GetClientId() << ": " << igtlResponseMessage->GetDeviceName());
       igsioLockGuard<vtkIGSIORecursiveCriticalSection> igtlClientsMutexGuardedLock(self.IgtlClientsMutex);
-      igtl::ClientSocket::Pointer clientSocket = NULL;
+      std::shared_ptr<PlusIgtlClientSendQueue> sendQueue;
       for (std::list<ClientData>::iterator clientIterator = self.IgtlClients.begin(); clientIterator != self.IgtlClients.end(); ++clientIterator)
       {
         if (clientIterator->ClientId == (*responseIt)->GetClientId())
         {
-          clientSocket = clientIterator->ClientSocket;
+          sendQueue = clientIterator->SendQueue;
           break;
         }
       }
 
-      if (clientSocket.IsNull())
+      if (!sendQueue)
       {
         LOG_WARNING("Message reply cannot be sent to client " << (*responseIt)->GetClientId() << ", probably client has been disconnected");
         continue;
       }
-      clientSocket->Send(igtlResponseMessage->GetBufferPointer(), igtlResponseMessage->GetBufferSize());
+      sendQueue->QueueMessage(igtlResponseMessage, PlusIgtlClientSendQueue::DROP_POLICY_NEVER);
     }
   }
 
@@ -582,7 +834,6 @@ void* vtkPlusOpenIGTLinkServer::DataReceiverThread(vtkMultiThreader::ThreadInfo*
 
   // Make copy of frequently used data to avoid locking of client data
   igtl::ClientSocket::Pointer clientSocket = client->ClientSocket;
-  int clientId = client->ClientId;
 
   igtl::MessageHeader::Pointer headerMsg = self->IgtlMessageFactory->CreateHeaderMessage(IGTL_HEADER_VERSION_1);
 
@@ -600,419 +851,410 @@ void* vtkPlusOpenIGTLinkServer::DataReceiverThread(vtkMultiThreader::ThreadInfo*
 
     headerMsg->Unpack(self->IgtlMessageCrcCheckEnabled);
 
+    // Receive the body, the body of unknown message types is skipped
+    igtl::MessageBase::Pointer bodyMessage = self->IgtlMessageFactory->CreateReceiveMessage(headerMsg);
+    if (bodyMessage.IsNull())
     {
-      igsioLockGuard<vtkIGSIORecursiveCriticalSection> igtlClientsMutexGuardedLock(self->IgtlClientsMutex);
-      // Keep track of the highest known version of message ever sent by this client, this is the version that we reply with
-      // (upper bounded by the servers version)
-      if (headerMsg->GetHeaderVersion() > client->ClientInfo.GetClientHeaderVersion())
+      clientSocket->Skip(headerMsg->GetBodySizeToRead(), 0);
+    }
+    else
+    {
+      bodyMessage->SetMessageHeader(headerMsg);
+      bodyMessage->AllocateBuffer();
+      if (bodyMessage->GetBufferBodySize() > 0)
       {
-        client->ClientInfo.SetClientHeaderVersion(std::min<int>(self->GetIGTLHeaderVersion(), headerMsg->GetHeaderVersion()));
+        clientSocket->Receive(bodyMessage->GetBufferBodyPointer(), bodyMessage->GetBufferBodySize());
       }
     }
 
-    igtl::MessageBase::Pointer bodyMessage = self->IgtlMessageFactory->CreateReceiveMessage(headerMsg);
-    if (bodyMessage.IsNull())
+    self->ProcessClientMessage(client, headerMsg, bodyMessage, previousCommandIds);
+  } // ConnectionActive
+
+  // Close thread
+  client->DataReceiverThreadId = -1;
+  client->DataReceiverActive.second = false;
+  return NULL;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusOpenIGTLinkServer::ProcessClientMessage(ClientData* client, igtl::MessageHeader::Pointer headerMsg, igtl::MessageBase::Pointer bodyMessage, std::deque<uint32_t>& previousCommandIds)
+{
+  int clientId = client->ClientId;
+
+  {
+    igsioLockGuard<vtkIGSIORecursiveCriticalSection> igtlClientsMutexGuardedLock(this->IgtlClientsMutex);
+    // Keep track of the highest known version of message ever sent by this client, this is the version that we reply with
+    // (upper bounded by the servers version)
+    if (headerMsg->GetHeaderVersion() > client->ClientInfo.GetClientHeaderVersion())
     {
-      LOG_ERROR("Unable to receive message from client: " << client->ClientId);
-      continue;
+      client->ClientInfo.SetClientHeaderVersion(std::min<int>(this->GetIGTLHeaderVersion(), headerMsg->GetHeaderVersion()));
     }
+  }
 
-    if (typeid(*bodyMessage) == typeid(igtl::PlusClientInfoMessage))
-    {
-      igtl::PlusClientInfoMessage::Pointer clientInfoMsg = dynamic_cast<igtl::PlusClientInfoMessage*>(bodyMessage.GetPointer());
-      clientInfoMsg->SetMessageHeader(headerMsg);
-      clientInfoMsg->AllocateBuffer();
+  if (bodyMessage.IsNull())
+  {
+    LOG_ERROR("Unable to receive message from client: " << client->ClientId);
+    return PLUS_FAIL;
+  }
 
-      clientSocket->Receive(clientInfoMsg->GetBufferBodyPointer(), clientInfoMsg->GetBufferBodySize());
+  if (typeid(*bodyMessage) == typeid(igtl::PlusClientInfoMessage))
+  {
+    igtl::PlusClientInfoMessage::Pointer clientInfoMsg = dynamic_cast<igtl::PlusClientInfoMessage*>(bodyMessage.GetPointer());
 
-      int c = clientInfoMsg->Unpack(self->IgtlMessageCrcCheckEnabled);
-      if (c & igtl::MessageHeader::UNPACK_BODY || clientInfoMsg->GetBufferBodySize() == 0)
+    int c = clientInfoMsg->Unpack(this->IgtlMessageCrcCheckEnabled);
+    if (c & igtl::MessageHeader::UNPACK_BODY || clientInfoMsg->GetBufferBodySize() == 0)
+    {
+      // Message received from client, need to lock to modify client info
+      igsioLockGuard<vtkIGSIORecursiveCriticalSection> igtlClientsMutexGuardedLock(this->IgtlClientsMutex);
+      client->ClientInfo = clientInfoMsg->GetClientInfo();
+      LOG_DEBUG("Client info message received from client " << clientId);
+      if (!client->ClientInfo.OutputChannelId.empty() && !this->IsOutputChannelId(client->ClientInfo.OutputChannelId))
       {
-        // Message received from client, need to lock to modify client info
-        igsioLockGuard<vtkIGSIORecursiveCriticalSection> igtlClientsMutexGuardedLock(self->IgtlClientsMutex);
-        client->ClientInfo = clientInfoMsg->GetClientInfo();
-        LOG_DEBUG("Client info message received from client " << clientId);
+        LOG_WARNING("Client " << clientId << " requested channel " << client->ClientInfo.OutputChannelId << ", which is not broadcast by the server. No data will be sent to the client.");
       }
     }
-    else if (typeid(*bodyMessage) == typeid(igtl::GetStatusMessage))
-    {
-      // Just ping server, we can skip message and respond
-      clientSocket->Skip(headerMsg->GetBodySizeToRead(), 0);
+  }
+  else if (typeid(*bodyMessage) == typeid(igtl::GetStatusMessage))
+  {
+    // Just ping server, respond
+    igtl::StatusMessage::Pointer replyMsg = dynamic_cast<igtl::StatusMessage*>(this->IgtlMessageFactory->CreateSendMessage("STATUS", client->ClientInfo.GetClientHeaderVersion()).GetPointer());
+    replyMsg->SetCode(igtl::StatusMessage::STATUS_OK);
+    replyMsg->Pack();
+    client->SendQueue->QueueMessage(replyMsg.GetPointer(), PlusIgtlClientSendQueue::DROP_POLICY_NEVER);
+  }
+  else if (typeid(*bodyMessage) == typeid(igtl::StringMessage)
+           && vtkPlusCommand::IsCommandDeviceName(headerMsg->GetDeviceName()))
+  {
+    igtl::StringMessage::Pointer stringMsg = dynamic_cast<igtl::StringMessage*>(bodyMessage.GetPointer());
 
-      igtl::StatusMessage::Pointer replyMsg = dynamic_cast<igtl::StatusMessage*>(self->IgtlMessageFactory->CreateSendMessage("STATUS", client->ClientInfo.GetClientHeaderVersion()).GetPointer());
-      replyMsg->SetCode(igtl::StatusMessage::STATUS_OK);
-      replyMsg->Pack();
-      clientSocket->Send(replyMsg->GetBufferPointer(), replyMsg->GetBufferSize());
-    }
-    else if (typeid(*bodyMessage) == typeid(igtl::StringMessage)
-             && vtkPlusCommand::IsCommandDeviceName(headerMsg->GetDeviceName()))
+    // We are receiving old style commands, handle it
+    int c = stringMsg->Unpack(this->IgtlMessageCrcCheckEnabled);
+    if (c & igtl::MessageHeader::UNPACK_BODY || stringMsg->GetBufferBodySize() == 0)
     {
-      igtl::StringMessage::Pointer stringMsg = dynamic_cast<igtl::StringMessage*>(bodyMessage.GetPointer());
-      stringMsg->SetMessageHeader(headerMsg);
-      stringMsg->AllocateBuffer();
-      clientSocket->Receive(stringMsg->GetBufferBodyPointer(), stringMsg->GetBufferBodySize());
-
-      // We are receiving old style commands, handle it
-      int c = stringMsg->Unpack(self->IgtlMessageCrcCheckEnabled);
-      if (c & igtl::MessageHeader::UNPACK_BODY || stringMsg->GetBufferBodySize() == 0)
+      std::string deviceName(headerMsg->GetDeviceName());
+      if (deviceName.empty())
       {
-        std::string deviceName(headerMsg->GetDeviceName());
-        if (deviceName.empty())
-        {
-          self->PlusCommandProcessor->QueueStringResponse(PLUS_FAIL, std::string(vtkPlusCommand::DEVICE_NAME_REPLY), clientId, "Unable to read DeviceName.");
-          continue;
-        }
+        this->PlusCommandProcessor->QueueStringResponse(PLUS_FAIL, std::string(vtkPlusCommand::DEVICE_NAME_REPLY), clientId, "Unable to read DeviceName.");
+        return PLUS_FAIL;
+      }
 
-        uint32_t uid(0);
-        try
-        {
+      uint32_t uid(0);
+      try
+      {
 #if (_MSC_VER == 1500)
-          std::istringstream ss(vtkPlusCommand::GetUidFromCommandDeviceName(deviceName));
-          ss >> uid;
+        std::istringstream ss(vtkPlusCommand::GetUidFromCommandDeviceName(deviceName));
+        ss >> uid;
 #else
-          uid = std::stoi(vtkPlusCommand::GetUidFromCommandDeviceName(deviceName));
+        uid = std::stoi(vtkPlusCommand::GetUidFromCommandDeviceName(deviceName));
 #endif
-        }
-        catch (std::invalid_argument e)
-        {
-          LOG_ERROR("Unable to extract command UID from device name string.");
-          // Removing support for malformed command strings, reply with error
-          self->PlusCommandProcessor->QueueStringResponse(PLUS_FAIL, std::string(vtkPlusCommand::DEVICE_NAME_REPLY), clientId, "Malformed DeviceName. Expected CMD_cmdId (ex: CMD_001)");
-          continue;
-        }
-
-        deviceName = vtkPlusCommand::GetPrefixFromCommandDeviceName(deviceName);
-
-        if (std::find(previousCommandIds.begin(), previousCommandIds.end(), uid) != previousCommandIds.end())
-        {
-          // Command already exists
-          LOG_WARNING("Already received a command with id = " << uid << " from client " << clientId << ". This repeated command will be ignored.");
-          continue;
-        }
-        // New command, remember its ID
-        previousCommandIds.push_back(uid);
-        if (previousCommandIds.size() > NUMBER_OF_RECENT_COMMAND_IDS_STORED)
-        {
-          previousCommandIds.pop_front();
-        }
-
-        LOG_DEBUG("Received command from client " << clientId << ", device " << deviceName << " with UID " << uid << ": " << stringMsg->GetString());
-
-        vtkSmartPointer<vtkXMLDataElement> cmdElement = vtkSmartPointer<vtkXMLDataElement>::Take(vtkXMLUtilities::ReadElementFromString(stringMsg->GetString()));
-        std::string commandName = std::string(cmdElement->GetAttribute("Name") == NULL ? "" : cmdElement->GetAttribute("Name"));
-
-        self->PlusCommandProcessor->QueueCommand(false, clientId, commandName, stringMsg->GetString(), deviceName, uid, stringMsg->GetMetaData());
       }
-
-    }
-    else if (typeid(*bodyMessage) == typeid(igtl::CommandMessage))
-    {
-      igtl::CommandMessage::Pointer commandMsg = dynamic_cast<igtl::CommandMessage*>(bodyMessage.GetPointer());
-      commandMsg->SetMessageHeader(headerMsg);
-      commandMsg->AllocateBuffer();
-      clientSocket->Receive(commandMsg->GetBufferBodyPointer(), commandMsg->GetBufferBodySize());
-
-      int c = commandMsg->Unpack(self->IgtlMessageCrcCheckEnabled);
-      if (c & igtl::MessageHeader::UNPACK_BODY || commandMsg->GetBufferBodySize() == 0)
+      catch (std::invalid_argument e)
       {
-        std::string deviceName(headerMsg->GetDeviceName());
-
-        uint32_t uid;
-        uid = commandMsg->GetCommandId();
-
-        if (std::find(previousCommandIds.begin(), previousCommandIds.end(), uid) != previousCommandIds.end())
-        {
-          // Command already exists
-          LOG_WARNING("Already received a command with id = " << uid << " from client " << clientId << ". This repeated command will be ignored.");
-          continue;
-        }
-        // New command, remember its ID
-        previousCommandIds.push_back(uid);
-        if (previousCommandIds.size() > NUMBER_OF_RECENT_COMMAND_IDS_STORED)
-        {
-          previousCommandIds.pop_front();
-        }
+        LOG_ERROR("Unable to extract command UID from device name string.");
+        // Removing support for malformed command strings, reply with error
+        this->PlusCommandProcessor->QueueStringResponse(PLUS_FAIL, std::string(vtkPlusCommand::DEVICE_NAME_REPLY), clientId, "Malformed DeviceName. Expected CMD_cmdId (ex: CMD_001)");
+        return PLUS_FAIL;
+      }
 
-        LOG_DEBUG("Received header version " << commandMsg->GetHeaderVersion() << " command " << commandMsg->GetCommandName()
-                  << " from client " << clientId << ", device " << deviceName << " with UID " << uid << ": " << commandMsg->GetCommandContent());
+      deviceName = vtkPlusCommand::GetPrefixFromCommandDeviceName(deviceName);
 
-        self->PlusCommandProcessor->QueueCommand(true, clientId, commandMsg->GetCommandName(), commandMsg->GetCommandContent(), deviceName, uid, commandMsg->GetMetaData());
+      if (std::find(previousCommandIds.begin(), previousCommandIds.end(), uid) != previousCommandIds.end())
+      {
+        // Command already exists
+        LOG_WARNING("Already received a command with id = " << uid << " from client " << clientId << ". This repeated command will be ignored.");
+        return PLUS_SUCCESS;
       }
-      else
+      // New command, remember its ID
+      previousCommandIds.push_back(uid);
+      if (previousCommandIds.size() > NUMBER_OF_RECENT_COMMAND_IDS_STORED)
       {
-        LOG_ERROR("STRING message unpacking failed for client " << clientId);
+        previousCommandIds.pop_front();
       }
+
+      LOG_DEBUG("Received command from client " << clientId << ", device " << deviceName << " with UID " << uid << ": " << stringMsg->GetString());
+
+      vtkSmartPointer<vtkXMLDataElement> cmdElement = vtkSmartPointer<vtkXMLDataElement>::Take(vtkXMLUtilities::ReadElementFromString(stringMsg->GetString()));
+      std::string commandName = std::string(cmdElement->GetAttribute("Name") == NULL ? "" : cmdElement->GetAttribute("Name"));
+
+      this->PlusCommandProcessor->QueueCommand(false, clientId, commandName, stringMsg->GetString(), deviceName, uid, stringMsg->GetMetaData());
     }
-    else if (typeid(*bodyMessage) == typeid(igtl::StartTrackingDataMessage))
-    {
-      std::string deviceName("");
 
-      igtl::StartTrackingDataMessage::Pointer startTracking = dynamic_cast<igtl::StartTrackingDataMessage*>(bodyMessage.GetPointer());
-      startTracking->SetMessageHeader(headerMsg);
-      startTracking->AllocateBuffer();
+  }
+  else if (typeid(*bodyMessage) == typeid(igtl::CommandMessage))
+  {
+    igtl::CommandMessage::Pointer commandMsg = dynamic_cast<igtl::CommandMessage*>(bodyMessage.GetPointer());
 
-      clientSocket->Receive(startTracking->GetBufferBodyPointer(), startTracking->GetBufferBodySize());
+    int c = commandMsg->Unpack(this->IgtlMessageCrcCheckEnabled);
+    if (c & igtl::MessageHeader::UNPACK_BODY || commandMsg->GetBufferBodySize() == 0)
+    {
+      std::string deviceName(headerMsg->GetDeviceName());
+
+      uint32_t uid;
+      uid = commandMsg->GetCommandId();
 
-      int c = startTracking->Unpack(self->IgtlMessageCrcCheckEnabled);
-      if (c & igtl::MessageHeader::UNPACK_BODY || startTracking->GetBufferBodySize() == 0)
+      if (std::find(previousCommandIds.begin(), previousCommandIds.end(), uid) != previousCommandIds.end())
       {
-        client->ClientInfo.SetTDATAResolution(startTracking->GetResolution());
-        client->ClientInfo.SetTDATARequested(true);
+        // Command already exists
+        LOG_WARNING("Already received a command with id = " << uid << " from client " << clientId << ". This repeated command will be ignored.");
+        return PLUS_SUCCESS;
       }
-      else
+      // New command, remember its ID
+      previousCommandIds.push_back(uid);
+      if (previousCommandIds.size() > NUMBER_OF_RECENT_COMMAND_IDS_STORED)
       {
-        LOG_ERROR("Client " << clientId << " STT_TDATA failed: could not retrieve startTracking message");
-        return NULL;
+        previousCommandIds.pop_front();
       }
 
-      igtl::MessageBase::Pointer msg = self->IgtlMessageFactory->CreateSendMessage("RTS_TDATA", client->ClientInfo.GetClientHeaderVersion());
-      igtl::RTSTrackingDataMessage* rtsMsg = dynamic_cast<igtl::RTSTrackingDataMessage*>(msg.GetPointer());
-      rtsMsg->SetStatus(0);
-      rtsMsg->Pack();
-      self->QueueMessageResponseForClient(client->ClientId, msg);
+      LOG_DEBUG("Received header version " << commandMsg->GetHeaderVersion() << " command " << commandMsg->GetCommandName()
+                << " from client " << clientId << ", device " << deviceName << " with UID " << uid << ": " << commandMsg->GetCommandContent());
+
+      this->PlusCommandProcessor->QueueCommand(true, clientId, commandMsg->GetCommandName(), commandMsg->GetCommandContent(), deviceName, uid, commandMsg->GetMetaData());
     }
-    else if (typeid(*bodyMessage) == typeid(igtl::StopTrackingDataMessage))
+    else
     {
-      igtl::StopTrackingDataMessage::Pointer stopTracking = dynamic_cast<igtl::StopTrackingDataMessage*>(bodyMessage.GetPointer());
-      stopTracking->SetMessageHeader(headerMsg);
-      stopTracking->AllocateBuffer();
+      LOG_ERROR("STRING message unpacking failed for client " << clientId);
+    }
+  }
+  else if (typeid(*bodyMessage) == typeid(igtl::StartTrackingDataMessage))
+  {
+    std::string deviceName("");
 
-      clientSocket->Receive(stopTracking->GetBufferBodyPointer(), stopTracking->GetBufferBodySize());
+    igtl::StartTrackingDataMessage::Pointer startTracking = dynamic_cast<igtl::StartTrackingDataMessage*>(bodyMessage.GetPointer());
 
-      client->ClientInfo.SetTDATARequested(false);
-      igtl::MessageBase::Pointer msg = self->IgtlMessageFactory->CreateSendMessage("RTS_TDATA", client->ClientInfo.GetClientHeaderVersion());
-      igtl::RTSTrackingDataMessage* rtsMsg = dynamic_cast<igtl::RTSTrackingDataMessage*>(msg.GetPointer());
-      rtsMsg->SetStatus(0);
-      rtsMsg->Pack();
-      self->QueueMessageResponseForClient(client->ClientId, msg);
+    int c = startTracking->Unpack(this->IgtlMessageCrcCheckEnabled);
+    if (c & igtl::MessageHeader::UNPACK_BODY || startTracking->GetBufferBodySize() == 0)
+    {
+      client->ClientInfo.SetTDATAResolution(startTracking->GetResolution());
+      client->ClientInfo.SetTDATARequested(true);
     }
-    else if (typeid(*bodyMessage) == typeid(igtl::GetPolyDataMessage))
+    else
     {
-      igtl::GetPolyDataMessage::Pointer polyDataMessage = dynamic_cast<igtl::GetPolyDataMessage*>(bodyMessage.GetPointer());
-      polyDataMessage->SetMessageHeader(headerMsg);
-      polyDataMessage->AllocateBuffer();
+      LOG_ERROR("Client " << clientId << " STT_TDATA failed: could not retrieve startTracking message");
+      return PLUS_FAIL;
+    }
 
-      clientSocket->Receive(polyDataMessage->GetBufferBodyPointer(), polyDataMessage->GetBufferBodySize());
+    igtl::MessageBase::Pointer msg = this->IgtlMessageFactory->CreateSendMessage("RTS_TDATA", client->ClientInfo.GetClientHeaderVersion());
+    igtl::RTSTrackingDataMessage* rtsMsg = dynamic_cast<igtl::RTSTrackingDataMessage*>(msg.GetPointer());
+    rtsMsg->SetStatus(0);
+    rtsMsg->Pack();
+    this->QueueMessageResponseForClient(client->ClientId, msg);
+  }
+  else if (typeid(*bodyMessage) == typeid(igtl::StopTrackingDataMessage))
+  {
+    igtl::StopTrackingDataMessage::Pointer stopTracking = dynamic_cast<igtl::StopTrackingDataMessage*>(bodyMessage.GetPointer());
+
+    client->ClientInfo.SetTDATARequested(false);
+    igtl::MessageBase::Pointer msg = this->IgtlMessageFactory->CreateSendMessage("RTS_TDATA", client->ClientInfo.GetClientHeaderVersion());
+    igtl::RTSTrackingDataMessage* rtsMsg = dynamic_cast<igtl::RTSTrackingDataMessage*>(msg.GetPointer());
+    rtsMsg->SetStatus(0);
+    rtsMsg->Pack();
+    this->QueueMessageResponseForClient(client->ClientId, msg);
+  }
+  else if (typeid(*bodyMessage) == typeid(igtl::GetPolyDataMessage))
+  {
+    igtl::GetPolyDataMessage::Pointer polyDataMessage = dynamic_cast<igtl::GetPolyDataMessage*>(bodyMessage.GetPointer());
 
-      int c = polyDataMessage->Unpack(self->IgtlMessageCrcCheckEnabled);
-      if (c & igtl::MessageHeader::UNPACK_BODY || polyDataMessage->GetBufferBodySize() == 0)
+    int c = polyDataMessage->Unpack(this->IgtlMessageCrcCheckEnabled);
+    if (c & igtl::MessageHeader::UNPACK_BODY || polyDataMessage->GetBufferBodySize() == 0)
+    {
+      std::string fileName;
+      // Check metadata for requisite parameters, if absent, check deviceName
+      if (polyDataMessage->GetHeaderVersion() > IGTL_HEADER_VERSION_1)
       {
-        std::string fileName;
-        // Check metadata for requisite parameters, if absent, check deviceName
-        if (polyDataMessage->GetHeaderVersion() > IGTL_HEADER_VERSION_1)
-        {
-          if (!polyDataMessage->GetMetaDataElement("filename", fileName))
-          {
-            fileName = polyDataMessage->GetDeviceName();
-            if (fileName.empty())
-            {
-              LOG_ERROR("GetPolyData message sent with no filename in either metadata or deviceName field.");
-              continue;
-            }
-          }
-        }
-        else
+        if (!polyDataMessage->GetMetaDataElement("filename", fileName))
         {
           fileName = polyDataMessage->GetDeviceName();
           if (fileName.empty())
           {
             LOG_ERROR("GetPolyData message sent with no filename in either metadata or deviceName field.");
-            continue;
+            return PLUS_FAIL;
           }
         }
+      }
+      else
+      {
+        fileName = polyDataMessage->GetDeviceName();
+        if (fileName.empty())
+        {
+          LOG_ERROR("GetPolyData message sent with no filename in either metadata or deviceName field.");
+          return PLUS_FAIL;
+        }
+      }
 
-        vtkSmartPointer<vtkPolyDataReader> reader = vtkSmartPointer<vtkPolyDataReader>::New();
-        reader->SetFileName(fileName.c_str());
-        reader->Update();
+      vtkSmartPointer<vtkPolyDataReader> reader = vtkSmartPointer<vtkPolyDataReader>::New();
+      reader->SetFileName(fileName.c_str());
+      reader->Update();
 
-        auto polyData = reader->GetOutput();
-        if (polyData != nullptr)
-        {
-          igtl::MessageBase::Pointer msg = self->IgtlMessageFactory->CreateSendMessage("POLYDATA", client->ClientInfo.GetClientHeaderVersion());
-          igtl::PolyDataMessage* polyMsg = dynamic_cast<igtl::PolyDataMessage*>(msg.GetPointer());
+      auto polyData = reader->GetOutput();
+      if (polyData != nullptr)
+      {
+        igtl::MessageBase::Pointer msg = this->IgtlMessageFactory->CreateSendMessage("POLYDATA", client->ClientInfo.GetClientHeaderVersion());
+        igtl::PolyDataMessage* polyMsg = dynamic_cast<igtl::PolyDataMessage*>(msg.GetPointer());
 
-          igtlioPolyDataConverter::ContentData data;
-          data.deviceName = "PlusServer";
-          data.polydata = polyData;
+        igtlioPolyDataConverter::ContentData data;
+        data.deviceName = "PlusServer";
+        data.polydata = polyData;
 
-          igtlioBaseConverter::HeaderData header;
-          header.deviceName = "PlusServer";
+        igtlioBaseConverter::HeaderData header;
+        header.deviceName = "PlusServer";
 
-          igtlioPolyDataConverter::toIGTL(header, data, (igtl::PolyDataMessage::Pointer*)&msg);
-          if (!msg->SetMetaDataElement("fileName", IANA_TYPE_US_ASCII, fileName))
-          {
-            LOG_ERROR("Filename too long to be sent back to client. Aborting.");
-            continue;
-          }
-          self->QueueMessageResponseForClient(client->ClientId, msg);
-          continue;
+        igtlioPolyDataConverter::toIGTL(header, data, (igtl::PolyDataMessage::Pointer*)&msg);
+        if (!msg->SetMetaDataElement("fileName", IANA_TYPE_US_ASCII, fileName))
+        {
+          LOG_ERROR("Filename too long to be sent back to client. Aborting.");
+          return PLUS_FAIL;
         }
-
-        igtl::MessageBase::Pointer msg = self->IgtlMessageFactory->CreateSendMessage("RTS_POLYDATA", polyDataMessage->GetHeaderVersion());
-        igtl::RTSPolyDataMessage* rtsPolyMsg = dynamic_cast<igtl::RTSPolyDataMessage*>(msg.GetPointer());
-        rtsPolyMsg->SetStatus(false);
-        self->QueueMessageResponseForClient(client->ClientId, rtsPolyMsg);
-      }
-      else
-      {
-        LOG_ERROR("Client " << clientId << " GET_POLYDATA failed: could not retrieve message");
-        return NULL;
+        this->QueueMessageResponseForClient(client->ClientId, msg);
+        return PLUS_SUCCESS;
       }
+
+      igtl::MessageBase::Pointer msg = this->IgtlMessageFactory->CreateSendMessage("RTS_POLYDATA", polyDataMessage->GetHeaderVersion());
+      igtl::RTSPolyDataMessage* rtsPolyMsg = dynamic_cast<igtl::RTSPolyDataMessage*>(msg.GetPointer());
+      rtsPolyMsg->SetStatus(false);
+      this->QueueMessageResponseForClient(client->ClientId, rtsPolyMsg);
     }
-    else if (typeid(*bodyMessage) == typeid(igtl::StatusMessage))
+    else
     {
-      // status message is used as a keep-alive, don't do anything
-      clientSocket->Skip(headerMsg->GetBodySizeToRead(), 0);
+      LOG_ERROR("Client " << clientId << " GET_POLYDATA failed: could not retrieve message");
+      return PLUS_FAIL;
     }
-    else if (typeid(*bodyMessage) == typeid(igtl::GetImageMetaMessage))
-    {
-      igtl::GetImageMetaMessage::Pointer getImageMetaMsg = dynamic_cast<igtl::GetImageMetaMessage*>(bodyMessage.GetPointer());
-      getImageMetaMsg->SetMessageHeader(headerMsg);
-      getImageMetaMsg->AllocateBuffer();
-
-      clientSocket->Receive(getImageMetaMsg->GetBufferBodyPointer(), getImageMetaMsg->GetBufferBodySize());
+  }
+  else if (typeid(*bodyMessage) == typeid(igtl::StatusMessage))
+  {
+    // status message is used as a keep-alive, don't do anything
+  }
+  else if (typeid(*bodyMessage) == typeid(igtl::GetImageMetaMessage))
+  {
+    igtl::GetImageMetaMessage::Pointer getImageMetaMsg = dynamic_cast<igtl::GetImageMetaMessage*>(bodyMessage.GetPointer());
 
-      int c = getImageMetaMsg->Unpack(self->IgtlMessageCrcCheckEnabled);
-      if (c & igtl::MessageHeader::UNPACK_BODY || getImageMetaMsg->GetBufferBodySize() == 0)
-      {
-        // Image meta message
-        std::string deviceName("");
-        if (headerMsg->GetDeviceName() != NULL)
-        {
-          deviceName = headerMsg->GetDeviceName();
-        }
-        self->PlusCommandProcessor->QueueGetImageMetaData(clientId, deviceName);
-      }
-      else
+    int c = getImageMetaMsg->Unpack(this->IgtlMessageCrcCheckEnabled);
+    if (c & igtl::MessageHeader::UNPACK_BODY || getImageMetaMsg->GetBufferBodySize() == 0)
+    {
+      // Image meta message
+      std::string deviceName("");
+      if (headerMsg->GetDeviceName() != NULL)
       {
-        LOG_ERROR("Client " << clientId << " GET_IMGMETA failed: could not retrieve message");
-        return NULL;
+        deviceName = headerMsg->GetDeviceName();
       }
+      this->PlusCommandProcessor->QueueGetImageMetaData(clientId, deviceName);
     }
-    else if (typeid(*bodyMessage) == typeid(igtl::GetImageMessage))
+    else
     {
-      igtl::GetImageMessage::Pointer getImageMsg = dynamic_cast<igtl::GetImageMessage*>(bodyMessage.GetPointer());
-      getImageMsg->SetMessageHeader(headerMsg);
-      getImageMsg->AllocateBuffer();
-
-      clientSocket->Receive(getImageMsg->GetBufferBodyPointer(), getImageMsg->GetBufferBodySize());
+      LOG_ERROR("Client " << clientId << " GET_IMGMETA failed: could not retrieve message");
+      return PLUS_FAIL;
+    }
+  }
+  else if (typeid(*bodyMessage) == typeid(igtl::GetImageMessage))
+  {
+    igtl::GetImageMessage::Pointer getImageMsg = dynamic_cast<igtl::GetImageMessage*>(bodyMessage.GetPointer());
 
-      int c = getImageMsg->Unpack(self->IgtlMessageCrcCheckEnabled);
-      if (c & igtl::MessageHeader::UNPACK_BODY || getImageMsg->GetBufferBodySize() == 0)
+    int c = getImageMsg->Unpack(this->IgtlMessageCrcCheckEnabled);
+    if (c & igtl::MessageHeader::UNPACK_BODY || getImageMsg->GetBufferBodySize() == 0)
+    {
+      std::string deviceName("");
+      if (headerMsg->GetDeviceName() != NULL)
       {
-        std::string deviceName("");
-        if (headerMsg->GetDeviceName() != NULL)
-        {
-          deviceName = headerMsg->GetDeviceName();
-        }
-        else
-        {
-          LOG_ERROR("Please select the image you want to acquire");
-          return NULL;
-        }
-        self->PlusCommandProcessor->QueueGetImage(clientId, deviceName);
+        deviceName = headerMsg->GetDeviceName();
       }
       else
       {
-        LOG_ERROR("Client " << clientId << " GET_IMAGE failed: could not retrieve message");
-        return NULL;
+        LOG_ERROR("Please select the image you want to acquire");
+        return PLUS_FAIL;
       }
-
+      this->PlusCommandProcessor->QueueGetImage(clientId, deviceName);
     }
-    else if (typeid(*bodyMessage) == typeid(igtl::GetPointMessage))
+    else
     {
-      igtl::GetPointMessage* getPointMsg = dynamic_cast<igtl::GetPointMessage*>(bodyMessage.GetPointer());
-      getPointMsg->SetMessageHeader(headerMsg);
-      getPointMsg->AllocateBuffer();
+      LOG_ERROR("Client " << clientId << " GET_IMAGE failed: could not retrieve message");
+      return PLUS_FAIL;
+    }
 
-      clientSocket->Receive(getPointMsg->GetBufferBodyPointer(), getPointMsg->GetBufferBodySize());
+  }
+  else if (typeid(*bodyMessage) == typeid(igtl::GetPointMessage))
+  {
+    igtl::GetPointMessage* getPointMsg = dynamic_cast<igtl::GetPointMessage*>(bodyMessage.GetPointer());
 
-      int c = getPointMsg->Unpack(self->IgtlMessageCrcCheckEnabled);
-      if (c & igtl::MessageHeader::UNPACK_BODY || getPointMsg->GetBufferBodySize() == 0)
+    int c = getPointMsg->Unpack(this->IgtlMessageCrcCheckEnabled);
+    if (c & igtl::MessageHeader::UNPACK_BODY || getPointMsg->GetBufferBodySize() == 0)
+    {
+      std::string fileName;
+      if (!getPointMsg->GetMetaDataElement("Filename", fileName))
       {
-        std::string fileName;
-        if (!getPointMsg->GetMetaDataElement("Filename", fileName))
-        {
-          fileName = getPointMsg->GetDeviceName();
-        }
+        fileName = getPointMsg->GetDeviceName();
+      }
 
-        if (igsioCommon::Tail(fileName, 4) != "fcsv")
-        {
-          LOG_WARNING("Filename does not end in fcsv. GetPoint behaviour may not function correctly.");
-        }
+      if (igsioCommon::Tail(fileName, 4) != "fcsv")
+      {
+        LOG_WARNING("Filename does not end in fcsv. GetPoint behaviour may not function correctly.");
+      }
 
-        if (!vtksys::SystemTools::FileExists(fileName) &&
-            !vtksys::SystemTools::FileExists(vtkPlusConfig::GetInstance()->GetImagePath(fileName)))
-        {
-          LOG_ERROR("File: " << fileName << " requested but does not exist. Cannot get POINT data from it.");
-          return NULL;
-        }
+      if (!vtksys::SystemTools::FileExists(fileName) &&
+          !vtksys::SystemTools::FileExists(vtkPlusConfig::GetInstance()->GetImagePath(fileName)))
+      {
+        LOG_ERROR("File: " << fileName << " requested but does not exist. Cannot get POINT data from it.");
+        return PLUS_FAIL;
+      }
 
-        igtl::MessageBase::Pointer msg = self->IgtlMessageFactory->CreateSendMessage("POINT", client->ClientInfo.GetClientHeaderVersion());
-        igtl::PointMessage* pointMsg = dynamic_cast<igtl::PointMessage*>(msg.GetPointer());
+      igtl::MessageBase::Pointer msg = this->IgtlMessageFactory->CreateSendMessage("POINT", client->ClientInfo.GetClientHeaderVersion());
+      igtl::PointMessage* pointMsg = dynamic_cast<igtl::PointMessage*>(msg.GetPointer());
 
-        std::ifstream t(fileName);
+      std::ifstream t(fileName);
+      if (!t.is_open())
+      {
+        t.open(vtkPlusConfig::GetInstance()->GetImagePath(fileName));
         if (!t.is_open())
         {
-          t.open(vtkPlusConfig::GetInstance()->GetImagePath(fileName));
-          if (!t.is_open())
-          {
-            LOG_ERROR("Cannot read file: " << fileName);
-            return NULL;
-          }
+          LOG_ERROR("Cannot read file: " << fileName);
+          return PLUS_FAIL;
         }
-        std::stringstream buffer;
-        buffer << t.rdbuf();
-        std::vector<std::string> lines = igsioCommon::SplitStringIntoTokens(buffer.str(), '\n', false);
-        for (std::vector<std::string>::iterator it = lines.begin(); it != lines.end(); ++it)
+      }
+      std::stringstream buffer;
+      buffer << t.rdbuf();
+      std::vector<std::string> lines = igsioCommon::SplitStringIntoTokens(buffer.str(), '\n', false);
+      for (std::vector<std::string>::iterator it = lines.begin(); it != lines.end(); ++it)
+      {
+        std::string line = igsioCommon::Trim(*it);
+        if (line[0] == '#')
         {
-          std::string line = igsioCommon::Trim(*it);
-          if (line[0] == '#')
-          {
-            continue;
-          }
-
-          std::vector<std::string> tokens = igsioCommon::SplitStringIntoTokens(line, ',', true);
-          igtl::PointElement::Pointer elem = igtl::PointElement::New();
-          elem->SetPosition(std::stof(tokens[1]), std::stof(tokens[2]), std::stof(tokens[3]));
-          elem->SetName(tokens[0].c_str());
-          elem->SetGroupName("Point");
-          pointMsg->AddPointElement(elem);
+          continue;
         }
 
-        self->QueueMessageResponseForClient(client->ClientId, pointMsg);
-      }
-      else
-      {
-        LOG_ERROR("Client " << clientId << " GET_POINT failed: could not retrieve message");
-        return NULL;
+        std::vector<std::string> tokens = igsioCommon::SplitStringIntoTokens(line, ',', true);
+        igtl::PointElement::Pointer elem = igtl::PointElement::New();
+        elem->SetPosition(std::stof(tokens[1]), std::stof(tokens[2]), std::stof(tokens[3]));
+        elem->SetName(tokens[0].c_str());
+        elem->SetGroupName("Point");
+        pointMsg->AddPointElement(elem);
       }
+
+      this->QueueMessageResponseForClient(client->ClientId, pointMsg);
     }
     else
     {
-      // if the device type is unknown, skip reading.
-      LOG_WARNING("Unknown OpenIGTLink message is received from client " << clientId << ". Device type: " << headerMsg->GetMessageType()
-                  << ". Device name: " << headerMsg->GetDeviceName() << ".");
-      clientSocket->Skip(headerMsg->GetBodySizeToRead(), 0);
-      continue;
+      LOG_ERROR("Client " << clientId << " GET_POINT failed: could not retrieve message");
+      return PLUS_FAIL;
     }
-  } // ConnectionActive
+  }
+  else
+  {
+    // if the device type is unknown, ignore the message
+    LOG_WARNING("Unknown OpenIGTLink message is received from client " << clientId << ". Device type: " << headerMsg->GetMessageType()
+                << ". Device name: " << headerMsg->GetDeviceName() << ".");
+    return PLUS_SUCCESS;
+  }
 
-  // Close thread
-  client->DataReceiverThreadId = -1;
-  client->DataReceiverActive.second = false;
-  return NULL;
+  return PLUS_SUCCESS;
 }
 
 //----------------------------------------------------------------------------
-PlusStatus vtkPlusOpenIGTLinkServer::SendTrackedFrame(igsioTrackedFrame& trackedFrame)
+PlusStatus vtkPlusOpenIGTLinkServer::SendTrackedFrame(igsioTrackedFrame& trackedFrame, const std::vector<std::string>& channelIds, vtkIGSIOTransformRepository* transformRepository)
 {
   int numberOfErrors = 0;
 
   // Update transform repository with the tracked frame
-  if (this->TransformRepository != NULL)
+  if (transformRepository != NULL)
   {
-    if (this->TransformRepository->SetTransforms(trackedFrame) != PLUS_SUCCESS)
+    if (transformRepository->SetTransforms(trackedFrame) != PLUS_SUCCESS)
     {
       LOG_ERROR("Failed to set current transforms to transform repository");
       numberOfErrors++;
@@ -1024,7 +1266,6 @@ PlusStatus vtkPlusOpenIGTLinkServer::SendTrackedFrame(igsioTrackedFrame& tracked
   double timestampUniversal = vtkIGSIOAccurateTimer::GetUniversalTimeFromSystemTime(timestampSystem);
   trackedFrame.SetTimestamp(timestampUniversal);
 
-  std::vector<int> disconnectedClientIds;
   {
     // Lock before we send message to the clients
     igsioLockGuard<vtkIGSIORecursiveCriticalSection> igtlClientsMutexGuardedLock(this->IgtlClientsMutex);
@@ -1045,20 +1286,34 @@ PlusStatus vtkPlusOpenIGTLinkServer::SendTrackedFrame(igsioTrackedFrame& tracked
     }
     this->NewClientConnected = false;
 
+    // Messages that multiple clients request with the same content are packed only once for this frame
+    vtkPlusIgtlMessageFactory::PackedMessageCache messageCache;
+
     for (std::list<ClientData>::iterator clientIterator = this->IgtlClients.begin(); clientIterator != this->IgtlClients.end(); ++clientIterator)
     {
-      igtl::ClientSocket::Pointer clientSocket = (*clientIterator).ClientSocket;
+      if (!this->IsClientSubscribed(*clientIterator, channelIds))
+      {
+        continue;
+      }
+      std::shared_ptr<PlusIgtlClientSendQueue> sendQueue = clientIterator->SendQueue;
+      if (sendQueue->IsSendFailed())
+      {
+        // Client is disconnected, it will be removed by DisconnectFailedClients
+        continue;
+      }
+      double packStartTime = PlusClock::GetSystemTime();
 
       // Create IGT messages
       std::vector<igtl::MessageBase::Pointer> igtlMessages;
       std::vector<igtl::MessageBase::Pointer>::iterator igtlMessageIterator;
 
-      if (this->IgtlMessageFactory->PackMessages(clientIterator->ClientId, clientIterator->ClientInfo, igtlMessages, trackedFrame, this->SendValidTransformsOnly, this->TransformRepository) != PLUS_SUCCESS)
+      if (this->IgtlMessageFactory->PackMessages(clientIterator->ClientId, clientIterator->ClientInfo, igtlMessages, trackedFrame, this->SendValidTransformsOnly, transformRepository, &messageCache) != PLUS_SUCCESS)
       {
         LOG_WARNING("Failed to pack all IGT messages");
       }
 
-      // Send all messages to a client
+      // Queue all messages for the client's writer thread. The send latency of the frame is recorded when its last message is sent.
+      std::vector<igtl::MessageBase::Pointer> droppedMessages;
       for (igtlMessageIterator = igtlMessages.begin(); igtlMessageIterator != igtlMessages.end(); ++igtlMessageIterator)
       {
         igtl::MessageBase::Pointer igtlMessage = (*igtlMessageIterator);
@@ -1067,28 +1322,39 @@ PlusStatus vtkPlusOpenIGTLinkServer::SendTrackedFrame(igsioTrackedFrame& tracked
           continue;
         }
 
-        int retValue = 0;
-        RETRY_UNTIL_TRUE((retValue = clientSocket->Send(igtlMessage->GetBufferPointer(), igtlMessage->GetBufferSize())) != 0, this->NumberOfRetryAttempts, this->DelayBetweenRetryAttemptsSec);
-        if (retValue == 0)
+        double frameTimestamp = (igtlMessageIterator + 1 == igtlMessages.end() ? timestampSystem : UNDEFINED_TIMESTAMP);
+        if (!sendQueue->QueueMessage(igtlMessage, this->GetSendQueueDropPolicy(igtlMessage->GetMessageType()), frameTimestamp, &droppedMessages))
         {
-          disconnectedClientIds.push_back(clientIterator->ClientId);
-          igtl::TimeStamp::Pointer ts = igtl::TimeStamp::New();
-          igtlMessage->GetTimeStamp(ts);
-          LOG_INFO("Client disconnected - could not send " << igtlMessage->GetMessageType() << " message to client (device name: " << igtlMessage->GetDeviceName()
-                   << "  Timestamp: " << std::fixed << ts->GetTimeStamp() << ").");
+          // Client is disconnected, it will be removed by DisconnectFailedClients
           break;
         }
 
         // Update the TDATA timestamp, even if TDATA isn't sent (cheaper than checking for existing TDATA message type)
         clientIterator->ClientInfo.SetLastTDATASentTimeStamp(trackedFrame.GetTimestamp());
       }
-    }
-  }
 
-  // Clean up disconnected clients
-  for (std::vector< int >::iterator it = disconnectedClientIds.begin(); it != disconnectedClientIds.end(); ++it)
-  {
-    DisconnectClient(*it);
+      for (std::vector<igtl::MessageBase::Pointer>::iterator droppedMessageIt = droppedMessages.begin(); droppedMessageIt != droppedMessages.end(); ++droppedMessageIt)
+      {
+        if (strcmp((*droppedMessageIt)->GetMessageType(), "VIDEO") == 0)
+        {
+          // The next video frames cannot be decoded without the dropped one, start a new sequence with a key frame.
+          // The frames of the client are encoded by its own frame converters (they are not shared with other clients).
+          for (std::vector<PlusIgtlClientInfo::VideoStream>::iterator videoStream = clientIterator->ClientInfo.VideoStreams.begin(); videoStream != clientIterator->ClientInfo.VideoStreams.end(); ++videoStream)
+          {
+            if (videoStream->FrameConverter)
+            {
+              videoStream->FrameConverter->RequestKeyFrameOn();
+            }
+          }
+          break;
+        }
+      }
+
+      if (!igtlMessages.empty())
+      {
+        clientIterator->PackSendDurationHistogram->RecordLatency(PlusClock::GetSystemTime() - packStartTime);
+      }
+    }
   }
 
   // restore original timestamp
@@ -1129,20 +1395,17 @@ void vtkPlusOpenIGTLinkServer::DisconnectClient(int clientId)
         {
           continue;
         }
-        if (clientIterator->DataReceiverThreadId > 0)
+        if (clientIterator->DataReceiverActive.second)
         {
-          if (clientIterator->DataReceiverActive.second)
-          {
-            // thread still running
-            clientDataReceiverThreadStillActive = true;
-          }
-          else
-          {
-            // thread stopped
-            clientIterator->DataReceiverThreadId = -1;
-          }
-          break;
+          // thread (or the event loop) still uses the client
+          clientDataReceiverThreadStillActive = true;
         }
+        else
+        {
+          // thread stopped
+          clientIterator->DataReceiverThreadId = -1;
+        }
+        break;
       }
     }
     if (clientDataReceiverThreadStillActive)
@@ -1153,6 +1416,27 @@ void vtkPlusOpenIGTLinkServer::DisconnectClient(int clientId)
   }
   while (clientDataReceiverThreadStillActive);
 
+  // Stop the client's writer thread, without locking the client list while the last message is being sent
+  std::shared_ptr<PlusIgtlClientSendQueue> sendQueue;
+  {
+    igsioLockGuard<vtkIGSIORecursiveCriticalSection> igtlClientsMutexGuardedLock(this->IgtlClientsMutex);
+    for (std::list<ClientData>::iterator clientIterator = this->IgtlClients.begin(); clientIterator != this->IgtlClients.end(); ++clientIterator)
+    {
+      if (clientIterator->ClientId == clientId)
+      {
+        sendQueue = clientIterator->SendQueue;
+        break;
+      }
+    }
+  }
+  if (sendQueue)
+  {
+    // Shut down the connection first, so a message that the client does not receive does not delay stopping the writer thread.
+    // The socket is closed below, after the writer thread does not use it anymore.
+    sendQueue->ShutdownSocket();
+    sendQueue->Stop();
+  }
+
   // Close socket and remove client from the list
   int port = 0;
   std::string address = "unknown";
@@ -1184,33 +1468,34 @@ void vtkPlusOpenIGTLinkServer::KeepAlive()
 {
   LOG_TRACE("Keep alive packet sent to clients...");
 
-  std::vector< int > disconnectedClientIds;
+  igtl::StatusMessage::Pointer replyMsg = igtl::StatusMessage::New();
+  replyMsg->SetCode(igtl::StatusMessage::STATUS_OK);
+  replyMsg->Pack();
 
+  // Lock before we send message to the clients
+  igsioLockGuard<vtkIGSIORecursiveCriticalSection> igtlClientsMutexGuardedLock(this->IgtlClientsMutex);
+  for (std::list<ClientData>::iterator clientIterator = this->IgtlClients.begin(); clientIterator != this->IgtlClients.end(); ++clientIterator)
   {
-    // Lock before we send message to the clients
-    igsioLockGuard<vtkIGSIORecursiveCriticalSection> igtlClientsMutexGuardedLock(this->IgtlClientsMutex);
+    // A keep alive message that is still waiting in the queue is not needed anymore.
+    // Clients that the message cannot be sent to are removed by DisconnectFailedClients.
+    clientIterator->SendQueue->QueueMessage(replyMsg.GetPointer(), PlusIgtlClientSendQueue::DROP_POLICY_KEEP_LATEST);
+  }
+}
 
+//----------------------------------------------------------------------------
+void vtkPlusOpenIGTLinkServer::DisconnectFailedClients()
+{
+  std::vector< int > disconnectedClientIds;
+  {
+    igsioLockGuard<vtkIGSIORecursiveCriticalSection> igtlClientsMutexGuardedLock(this->IgtlClientsMutex);
     for (std::list<ClientData>::iterator clientIterator = this->IgtlClients.begin(); clientIterator != this->IgtlClients.end(); ++clientIterator)
     {
-      igtl::StatusMessage::Pointer replyMsg = igtl::StatusMessage::New();
-      replyMsg->SetCode(igtl::StatusMessage::STATUS_OK);
-      replyMsg->Pack();
-
-      int retValue = 0;
-      RETRY_UNTIL_TRUE(
-        (retValue = clientIterator->ClientSocket->Send(replyMsg->GetPackPointer(), replyMsg->GetPackSize())) != 0,
-        this->NumberOfRetryAttempts, this->DelayBetweenRetryAttemptsSec);
-      if (retValue == 0)
+      if (clientIterator->SendQueue && clientIterator->SendQueue->IsSendFailed())
       {
         disconnectedClientIds.push_back(clientIterator->ClientId);
-        igtl::TimeStamp::Pointer ts = igtl::TimeStamp::New();
-        replyMsg->GetTimeStamp(ts);
-
-        LOG_DEBUG("Client disconnected - could not send " << replyMsg->GetMessageType() << " message to client (device name: " << replyMsg->GetDeviceName()
-                  << "  Timestamp: " << std::fixed <<  ts->GetTimeStamp() << ").");
       }
-    } // clientIterator
-  } // unlock client list
+    }
+  }
 
   // Clean up disconnected clients
   for (std::vector< int >::iterator it = disconnectedClientIds.begin(); it != disconnectedClientIds.end(); ++it)
@@ -1243,6 +1528,124 @@ PlusStatus vtkPlusOpenIGTLinkServer::GetClientInfo(unsigned int clientId, PlusIg
   return PLUS_FAIL;
 }
 
+//------------------------------------------------------------------------------
+void vtkPlusOpenIGTLinkServer::GetLatencyHistograms(std::vector<vtkPlusDataCollector::LatencyHistogramSnapshot>& latencyHistograms) const
+{
+  latencyHistograms.clear();
+  if (this->DataCollector != NULL)
+  {
+    this->DataCollector->GetLatencyHistograms(latencyHistograms);
+  }
+
+  igsioLockGuard<vtkIGSIORecursiveCriticalSection> igtlClientsMutexGuardedLock(this->IgtlClientsMutex);
+  for (std::list<ClientData>::const_iterator it = this->IgtlClients.begin(); it != this->IgtlClients.end(); ++it)
+  {
+    vtkPlusDataCollector::LatencyHistogramSnapshot sendLatencyHistogram;
+    sendLatencyHistogram.Name = std::string("Send:Client") + igsioCommon::ToString<int>(it->ClientId);
+    it->SendLatencyHistogram->GetSnapshot(sendLatencyHistogram.Snapshot);
+    latencyHistograms.push_back(sendLatencyHistogram);
+
+    vtkPlusDataCollector::LatencyHistogramSnapshot packSendDurationHistogram;
+    packSendDurationHistogram.Name = std::string("PackSend:Client") + igsioCommon::ToString<int>(it->ClientId);
+    it->PackSendDurationHistogram->GetSnapshot(packSendDurationHistogram.Snapshot);
+    latencyHistograms.push_back(packSendDurationHistogram);
+  }
+}
+
+//------------------------------------------------------------------------------
+void vtkPlusOpenIGTLinkServer::GetClientSendQueueStatistics(std::vector<ClientSendQueueStatistics>& statistics) const
+{
+  statistics.clear();
+  igsioLockGuard<vtkIGSIORecursiveCriticalSection> igtlClientsMutexGuardedLock(this->IgtlClientsMutex);
+  for (std::list<ClientData>::const_iterator it = this->IgtlClients.begin(); it != this->IgtlClients.end(); ++it)
+  {
+    ClientSendQueueStatistics clientStatistics;
+    clientStatistics.ClientId = it->ClientId;
+    it->SendQueue->GetStatistics(clientStatistics.Statistics);
+    statistics.push_back(clientStatistics);
+  }
+}
+
+//------------------------------------------------------------------------------
+void vtkPlusOpenIGTLinkServer::SetAdditionalOutputChannelIds(const std::vector<std::string>& channelIds)
+{
+  this->AdditionalOutputChannelIds = channelIds;
+}
+
+//------------------------------------------------------------------------------
+const std::vector<std::string>& vtkPlusOpenIGTLinkServer::GetAdditionalOutputChannelIds() const
+{
+  return this->AdditionalOutputChannelIds;
+}
+
+//------------------------------------------------------------------------------
+bool vtkPlusOpenIGTLinkServer::IsOutputChannelId(const std::string& channelId) const
+{
+  return channelId == this->OutputChannelId
+         || std::find(this->AdditionalOutputChannelIds.begin(), this->AdditionalOutputChannelIds.end(), channelId) != this->AdditionalOutputChannelIds.end();
+}
+
+//------------------------------------------------------------------------------
+void vtkPlusOpenIGTLinkServer::SetSendQueueDropPolicy(const std::string& messageType, PlusIgtlClientSendQueue::DropPolicy dropPolicy)
+{
+  this->SendQueueDropPolicies[messageType] = dropPolicy;
+}
+
+//------------------------------------------------------------------------------
+PlusIgtlClientSendQueue::DropPolicy vtkPlusOpenIGTLinkServer::GetSendQueueDropPolicy(const std::string& messageType) const
+{
+  std::map<std::string, PlusIgtlClientSendQueue::DropPolicy>::const_iterator it = this->SendQueueDropPolicies.find(messageType);
+  if (it == this->SendQueueDropPolicies.end())
+  {
+    return PlusIgtlClientSendQueue::DROP_POLICY_OLDEST;
+  }
+  return it->second;
+}
+
+//------------------------------------------------------------------------------
+void vtkPlusOpenIGTLinkServer::LogLatencyStatistics()
+{
+  if (this->LatencyLogIntervalSec <= 0)
+  {
+    return;
+  }
+  double currentTime = PlusClock::GetSystemTime();
+  if (currentTime - this->LastLatencyLogTime < this->LatencyLogIntervalSec)
+  {
+    return;
+  }
+  this->LastLatencyLogTime = currentTime;
+
+  std::vector<vtkPlusDataCollector::LatencyHistogramSnapshot> latencyHistograms;
+  this->GetLatencyHistograms(latencyHistograms);
+
+  // Histograms of disconnected clients are not needed anymore
+  std::map<std::string, PlusLatencyHistogram::Snapshot> loggedLatencyHistograms;
+  for (std::vector<vtkPlusDataCollector::LatencyHistogramSnapshot>::iterator it = latencyHistograms.begin(); it != latencyHistograms.end(); ++it)
+  {
+    PlusLatencyHistogram::Snapshot periodSnapshot = it->Snapshot;
+    std::map<std::string, PlusLatencyHistogram::Snapshot>::iterator lastLoggedIt = this->LastLoggedLatencyHistograms.find(it->Name);
+    if (lastLoggedIt != this->LastLoggedLatencyHistograms.end())
+    {
+      periodSnapshot.Subtract(lastLoggedIt->second);
+    }
+    if (periodSnapshot.GetCount() > 0)
+    {
+      LOG_INFO("Latency " << it->Name << ": " << periodSnapshot.GetSummary());
+    }
+    loggedLatencyHistograms[it->Name] = it->Snapshot;
+  }
+  this->LastLoggedLatencyHistograms.swap(loggedLatencyHistograms);
+
+  std::vector<ClientSendQueueStatistics> sendQueueStatistics;
+  this->GetClientSendQueueStatistics(sendQueueStatistics);
+  for (std::vector<ClientSendQueueStatistics>::iterator it = sendQueueStatistics.begin(); it != sendQueueStatistics.end(); ++it)
+  {
+    LOG_INFO("Send queue of client " << it->ClientId << ": " << it->Statistics.NumberOfQueuedMessages << " queued (max. " << it->Statistics.MaxNumberOfQueuedMessages
+             << "), " << it->Statistics.NumberOfSentMessages << " sent, " << it->Statistics.NumberOfDroppedMessages << " dropped messages");
+  }
+}
+
 //------------------------------------------------------------------------------
 PlusStatus vtkPlusOpenIGTLinkServer::ReadConfiguration(vtkXMLDataElement* serverElement, const std::string& aFilename)
 {
@@ -1257,12 +1660,29 @@ PlusStatus vtkPlusOpenIGTLinkServer::ReadConfiguration(vtkXMLDataElement* server
 
   XML_READ_SCALAR_ATTRIBUTE_REQUIRED(int, ListeningPort, serverElement);
   XML_READ_STRING_ATTRIBUTE_REQUIRED(OutputChannelId, serverElement);
+  this->AdditionalOutputChannelIds.clear();
+  if (serverElement->GetAttribute("AdditionalOutputChannelIds") != NULL)
+  {
+    // Space-separated list of channel IDs
+    this->AdditionalOutputChannelIds = igsioCommon::SplitStringIntoTokens(serverElement->GetAttribute("AdditionalOutputChannelIds"), ' ', false);
+  }
   XML_READ_SCALAR_ATTRIBUTE_OPTIONAL(double, MissingInputGracePeriodSec, serverElement);
   XML_READ_SCALAR_ATTRIBUTE_OPTIONAL(double, MaxTimeSpentWithProcessingMs, serverElement);
   XML_READ_SCALAR_ATTRIBUTE_OPTIONAL(int, MaxNumberOfIgtlMessagesToSend, serverElement);
   XML_READ_SCALAR_ATTRIBUTE_OPTIONAL(int, NumberOfRetryAttempts, serverElement);
   XML_READ_SCALAR_ATTRIBUTE_OPTIONAL(double, DelayBetweenRetryAttemptsSec, serverElement);
   XML_READ_SCALAR_ATTRIBUTE_OPTIONAL(double, KeepAliveIntervalSec, serverElement);
+  XML_READ_SCALAR_ATTRIBUTE_OPTIONAL(double, LatencyLogIntervalSec, serverElement);
+  XML_READ_SCALAR_ATTRIBUTE_OPTIONAL(int, MaxClientSendQueueLength, serverElement);
+  XML_READ_BOOL_ATTRIBUTE_OPTIONAL(ReactorEnabled, serverElement);
+#if !defined(__linux__)
+  if (this->ReactorEnabled)
+  {
+    LOG_WARNING("ReactorEnabled is only supported on Linux. Separate threads are used for each client.");
+    this->ReactorEnabled = false;
+  }
+#endif
+  XML_READ_BOOL_ATTRIBUTE_OPTIONAL(JoinTrackedFrames, serverElement);
   XML_READ_BOOL_ATTRIBUTE_OPTIONAL(SendValidTransformsOnly, serverElement);
   XML_READ_BOOL_ATTRIBUTE_OPTIONAL(IgtlMessageCrcCheckEnabled, serverElement);
   XML_READ_BOOL_ATTRIBUTE_OPTIONAL(LogWarningOnNoDataAvailable, serverElement);
@@ -1287,6 +1707,25 @@ PlusStatus vtkPlusOpenIGTLinkServer::ReadConfiguration(vtkXMLDataElement* server
   XML_READ_SCALAR_ATTRIBUTE_OPTIONAL(float, DefaultClientSendTimeoutSec, serverElement);
   XML_READ_SCALAR_ATTRIBUTE_OPTIONAL(float, DefaultClientReceiveTimeoutSec, serverElement);
 
+  // Drop policies of the message types, e.g. <SendQueueDropPolicy MessageType="TRANSFORM" Policy="KeepLatest" />
+  for (int nestedElementIndex = 0; nestedElementIndex < serverElement->GetNumberOfNestedElements(); ++nestedElementIndex)
+  {
+    vtkXMLDataElement* dropPolicyElement = serverElement->GetNestedElement(nestedElementIndex);
+    if (dropPolicyElement == NULL || STRCASECMP(dropPolicyElement->GetName(), "SendQueueDropPolicy") != 0)
+    {
+      continue;
+    }
+    const char* messageType = dropPolicyElement->GetAttribute("MessageType");
+    const char* policy = dropPolicyElement->GetAttribute("Policy");
+    PlusIgtlClientSendQueue::DropPolicy dropPolicy(PlusIgtlClientSendQueue::DROP_POLICY_OLDEST);
+    if (messageType == NULL || policy == NULL || !PlusIgtlClientSendQueue::GetDropPolicyFromString(policy, dropPolicy))
+    {
+      LOG_ERROR("Invalid SendQueueDropPolicy element. MessageType and Policy (Never, DropOldest, or KeepLatest) attributes are required.");
+      return PLUS_FAIL;
+    }
+    this->SetSendQueueDropPolicy(messageType, dropPolicy);
+  }
+
   return PLUS_SUCCESS;
 }
 
@@ -10,6 +10,8 @@
 // Local includes
 #include "vtkPlusServerExport.h"
 #include "PlusIgtlClientInfo.h"
+#include "PlusIgtlClientSendQueue.h"
+#include "PlusTrackedFrameJoiner.h"
 #include "vtkPlusDataCollector.h"
 #include "vtkPlusIgtlMessageFactory.h"
 #include "vtkIGSIOTransformRepository.h"
@@ -20,7 +22,13 @@
 #include <vtkSmartPointer.h>
 
 // STL includes
+#include <condition_variable>
 #include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
 
 // OS includes
 #if (_MSC_VER == 1500)
@@ -29,6 +37,7 @@
 
 // IGTL includes
 #include <igtlMessageBase.h>
+#include <igtlMessageHeader.h>
 #include <igtlServerSocket.h>
 
 //class igsioTrackedFrame; 
@@ -47,6 +56,8 @@ struct ClientData
     , ClientSocket(NULL)
     , DataReceiverActive(std::make_pair(false, false))
     , DataReceiverThreadId(-1)
+    , SendLatencyHistogram(std::make_shared<PlusLatencyHistogram>())
+    , PackSendDurationHistogram(std::make_shared<PlusLatencyHistogram>())
     , Server(NULL)
   {
   }
@@ -67,6 +78,14 @@ struct ClientData
 
   PlusIgtlClientInfo ClientInfo;
 
+  /// Age of the tracked frames when they have been sent to the client
+  std::shared_ptr<PlusLatencyHistogram> SendLatencyHistogram;
+  /// Time spent with packing a tracked frame and queueing its messages for sending to the client
+  std::shared_ptr<PlusLatencyHistogram> PackSendDurationHistogram;
+
+  /// Messages waiting to be sent to the client
+  std::shared_ptr<PlusIgtlClientSendQueue> SendQueue;
+
   vtkPlusOpenIGTLinkServer* Server;
 };
 
@@ -83,6 +102,13 @@ struct ClientData
   requested image and tracking information in the same format as in the DefaultClientInfo element in the device set
   configuration file.
 
+  The server broadcasts the output channel specified by OutputChannelId and optionally further channels (AdditionalOutputChannelIds).
+  A client receives the data of the channel that is specified by the OutputChannelId attribute of its client information
+  (the OutputChannelId of the server by default). Each channel is sent from its own position, therefore a slow channel does not delay the others.
+  Channels that contain the same data sources are retrieved and packed only once for all the clients that receive any of them.
+  If JoinTrackedFrames is enabled, the frames of each channel are sent when all its data sources have data for them (see PlusTrackedFrameJoiner),
+  instead of when they are in the buffer of the channel's master source.
+
   \ingroup PlusLibPlusServer
 */
 class vtkPlusServerExport vtkPlusOpenIGTLinkServer: public vtkObject
@@ -90,6 +116,13 @@ class vtkPlusServerExport vtkPlusOpenIGTLinkServer: public vtkObject
   typedef std::map<int, std::vector<igtl::MessageBase::Pointer> > ClientIdToMessageListMap;
 
 public:
+  /*! Statistics of the send queue of a connected client */
+  struct ClientSendQueueStatistics
+  {
+    int ClientId;
+    PlusIgtlClientSendQueue::Statistics Statistics;
+  };
+
   static vtkPlusOpenIGTLinkServer* New();
   vtkTypeMacro(vtkPlusOpenIGTLinkServer, vtkObject);
   virtual void PrintSelf(ostream& os, vtkIndent indent) VTK_OVERRIDE;
@@ -111,6 +144,13 @@ public:
 
   vtkGetStdStringMacro(OutputChannelId);
 
+  /*! Set the IDs of the channels that are broadcast in addition to OutputChannelId. It has to be set before the server is started. */
+  void SetAdditionalOutputChannelIds(const std::vector<std::string>& channelIds);
+  const std::vector<std::string>& GetAdditionalOutputChannelIds() const;
+
+  /*! Returns true if the channel is broadcast by the server (it is the OutputChannelId or one of the AdditionalOutputChannelIds) */
+  bool IsOutputChannelId(const std::string& channelId) const;
+
   vtkSetMacro(MissingInputGracePeriodSec, double);
   vtkGetMacroConst(MissingInputGracePeriodSec, double);
 
@@ -126,6 +166,36 @@ public:
   vtkSetMacro(DefaultClientReceiveTimeoutSec, float);
   vtkGetMacroConst(DefaultClientReceiveTimeoutSec, float);
 
+  /*! Set the period of logging the latency statistics (0 to disable) */
+  vtkSetMacro(LatencyLogIntervalSec, double);
+  vtkGetMacroConst(LatencyLogIntervalSec, double);
+
+  /*!
+    Enable handling of all the client connections by a single event loop thread (only available on Linux).
+    If disabled, a receiver and a writer thread is started for each client.
+    It has to be set before the server is started.
+  */
+  vtkSetMacro(ReactorEnabled, bool);
+  vtkGetMacroConst(ReactorEnabled, bool);
+  vtkBooleanMacro(ReactorEnabled, bool);
+
+  /*!
+    Send the frames of the broadcast channels as they are joined by a PlusTrackedFrameJoiner, so that the data of slower sources
+    is not extrapolated or missing. It has to be set before the server is started.
+  */
+  vtkSetMacro(JoinTrackedFrames, bool);
+  vtkGetMacroConst(JoinTrackedFrames, bool);
+  vtkBooleanMacro(JoinTrackedFrames, bool);
+
+  /*! Set the maximum number of droppable messages that may wait for sending to a client. Applies to clients that connect after the change. */
+  vtkSetMacro(MaxClientSendQueueLength, int);
+  vtkGetMacroConst(MaxClientSendQueueLength, int);
+
+  /*! Set the policy of dropping the messages of the specified type (e.g., IMAGE) if a client cannot receive them as fast as they are produced */
+  void SetSendQueueDropPolicy(const std::string& messageType, PlusIgtlClientSendQueue::DropPolicy dropPolicy);
+  /*! Get the policy of dropping the messages of the specified type. Messages without a specified policy use DROP_POLICY_OLDEST. */
+  PlusIgtlClientSendQueue::DropPolicy GetSendQueueDropPolicy(const std::string& messageType) const;
+
   /*! Set data collector instance */
   vtkSetMacro(DataCollector, vtkPlusDataCollector*);
   vtkGetMacroConst(DataCollector, vtkPlusDataCollector*);
@@ -142,6 +212,16 @@ public:
     */
   virtual PlusStatus GetClientInfo(unsigned int clientId, PlusIgtlClientInfo& outClientInfo) const;
 
+  /*!
+    Get the latency histograms of the data collector (see vtkPlusDataCollector::GetLatencyHistograms)
+    and of each connected client (Send stage: age of the tracked frames when they have been sent to the client,
+    PackSend stage: time spent with packing a tracked frame and queueing its messages for sending to the client)
+  */
+  void GetLatencyHistograms(std::vector<vtkPlusDataCollector::LatencyHistogramSnapshot>& latencyHistograms) const;
+
+  /*! Get the number of queued, sent, and dropped messages of each connected client */
+  void GetClientSendQueueStatistics(std::vector<ClientSendQueueStatistics>& statistics) const;
+
   /*! Start server */
   PlusStatus StartOpenIGTLinkService();
 
@@ -160,6 +240,35 @@ public:
   int ProcessPendingCommands();
 
 protected:
+  /*! Broadcast channel with its own sending position. Channels that contain the same data sources share one stream. */
+  struct BroadcastStream
+  {
+    BroadcastStream()
+      : Channel(NULL)
+      , NewFrameCallbackId(0)
+      , LastSentTrackedFrameTimestamp(0)
+      , LastProcessingTimePerFrameMs(-1)
+    {
+    }
+    /*! Channel that the tracked frames are retrieved from */
+    vtkPlusChannel* Channel;
+    /*! IDs of the channels that contain the same data sources as Channel. Clients that receive any of them are sent the frames of the stream. */
+    std::vector<std::string> ChannelIds;
+    /*! ID of the new frame callback of Channel that wakes up the data sender thread, 0 if the stream has a FrameJoiner */
+    unsigned long NewFrameCallbackId;
+    /*!
+      Transforms of the stream: the transforms of the server repository (from the configuration and the commands)
+      and the transforms of the frames of this stream, so that the frames of other streams do not affect the computed transforms
+    */
+    vtkSmartPointer<vtkIGSIOTransformRepository> TransformRepository;
+    /*! Last sent tracked frame timestamp */
+    double LastSentTrackedFrameTimestamp;
+    /*! Time needed to process one frame in the latest recording round (in milliseconds) */
+    int LastProcessingTimePerFrameMs;
+    /*! Joins the data sources of the channel if JoinTrackedFrames is enabled, empty otherwise */
+    std::shared_ptr<PlusTrackedFrameJoiner> FrameJoiner;
+  };
+
   vtkPlusOpenIGTLinkServer();
   virtual ~vtkPlusOpenIGTLinkServer();
 
@@ -175,6 +284,31 @@ protected:
   /*! Attempt to send any unsent frames to clients, if unsuccessful, accumulate an elapsed time */
   static PlusStatus SendLatestFramesToClients(vtkPlusOpenIGTLinkServer& self, double& elapsedTimeSinceLastPacketSentSec);
 
+  /*! Send the unsent frames of a broadcast stream to the clients that receive it */
+  static PlusStatus SendLatestFramesOfStream(vtkPlusOpenIGTLinkServer& self, BroadcastStream& stream, int& numberOfSentFrames);
+
+  /*! Find the channels to broadcast and group the channels that contain the same data sources into streams */
+  PlusStatus SetUpBroadcastStreams();
+
+  /*! Stop the frame joiners and remove the callbacks of the broadcast streams */
+  void ClearBroadcastStreams();
+
+  /*! Wake up the data sender thread, called when new frames are available in any broadcast stream */
+  void NotifyNewFrames();
+
+  /*!
+    Block the calling thread until new frames are available in any broadcast stream or the timeout expires
+    \param sequenceNumber In: the sequence number that was obtained before the frames were sent. Out: the current sequence number.
+    \return true if new frames are available since sequenceNumber
+  */
+  bool WaitForNewFrames(unsigned long long& sequenceNumber, double timeoutSec);
+
+  /*! Returns true if the client receives any of the specified channels. IgtlClientsMutex must be locked. */
+  bool IsClientSubscribed(const ClientData& client, const std::vector<std::string>& channelIds) const;
+
+  /*! Returns true if any connected client receives the frames of the broadcast stream */
+  bool HasSubscribedClients(const BroadcastStream& stream) const;
+
   /*! Process the message replies queue and send messages */
   static PlusStatus SendMessageResponses(vtkPlusOpenIGTLinkServer& self);
 
@@ -184,8 +318,25 @@ protected:
   /*! Thread for receiving control data from clients */
   static void* DataReceiverThread(vtkMultiThreader::ThreadInfo* data);
 
-  /*! Tracked frame interface, sends the selected message type and data to all clients */
-  virtual PlusStatus SendTrackedFrame(igsioTrackedFrame& trackedFrame);
+#if defined(__linux__)
+  /*!
+    Thread that accepts client connections, receives messages from the clients, and sends the queued messages to the clients,
+    using non-blocking sockets polled by epoll. Used instead of the connection receiver thread and the per-client threads if ReactorEnabled is set.
+  */
+  static void* ReactorThread(vtkMultiThreader::ThreadInfo* data);
+#endif
+
+  /*! Add a new client to the client list and set up its client info and send queue. IgtlClientsMutex must be locked. */
+  ClientData* AddClient(igtl::ClientSocket::Pointer clientSocket);
+
+  /*! Process a message that has been received from a client. The body of the message (if the message type is known) has been received already. */
+  PlusStatus ProcessClientMessage(ClientData* client, igtl::MessageHeader::Pointer headerMsg, igtl::MessageBase::Pointer bodyMessage, std::deque<uint32_t>& previousCommandIds);
+
+  /*!
+    Tracked frame interface, sends the selected message type and data to the clients that receive any of the specified channels
+    \param transformRepository Repository of the broadcast stream, it is updated with the transforms of the frame
+  */
+  virtual PlusStatus SendTrackedFrame(igsioTrackedFrame& trackedFrame, const std::vector<std::string>& channelIds, vtkIGSIOTransformRepository* transformRepository);
 
   /*! Converts a command response to an OpenIGTLink message that can be sent to the client */
   igtl::MessageBase::Pointer CreateIgtlMessageFromCommandResponse(vtkPlusCommandResponse* response);
@@ -193,6 +344,12 @@ protected:
   /*! Send status message to clients to keep alive the connection */
   virtual void KeepAlive();
 
+  /*! Disconnect the clients that messages could not be sent to */
+  void DisconnectFailedClients();
+
+  /*! Log the latency statistics of the last period, if LatencyLogIntervalSec has elapsed since the previous log */
+  void LogLatencyStatistics();
+
   /*! Stops client's data receiving thread, closes the socket, and removes the client from the client list */
   void DisconnectClient(int clientId);
 
@@ -228,7 +385,7 @@ private:
   /*! IGTL server socket */
   igtl::ServerSocket::Pointer ServerSocket;
 
-  /*! Transform repository instance */
+  /*! Transform repository instance. The transforms of the broadcast frames are kept in the repositories of the streams, not here. */
   vtkSmartPointer<vtkIGSIOTransformRepository> TransformRepository;
 
   /*! Data collector instance */
@@ -253,6 +410,18 @@ private:
   /*! Maximum number of IGTL messages to send in one period */
   int MaxNumberOfIgtlMessagesToSend;
 
+  /*! Handle the client connections by a single event loop thread instead of separate threads for each client */
+  bool ReactorEnabled;
+
+  /*! Send the frames of the broadcast channels when all their data sources have data for them */
+  bool JoinTrackedFrames;
+
+  /*! Maximum number of droppable messages that may wait for sending to a client */
+  int MaxClientSendQueueLength;
+
+  /*! Drop policy of the messages sent to the clients, for each message type */
+  std::map<std::string, PlusIgtlClientSendQueue::DropPolicy> SendQueueDropPolicies;
+
   // Active flag for threads (request, respond )
   struct ThreadFlags
   {
@@ -279,15 +448,9 @@ private:
   /*! Mutex instance for accessing client data list */
   vtkSmartPointer<vtkIGSIORecursiveCriticalSection> IgtlClientsMutex;
 
-  /*! Last sent tracked frame timestamp */
-  double LastSentTrackedFrameTimestamp;
-
   /*! Maximum time spent with processing (getting tracked frames, sending messages) per second (in milliseconds) */
   int MaxTimeSpentWithProcessingMs;
 
-  /*! Time needed to process one frame in the latest recording round (in milliseconds) */
-  int LastProcessingTimePerFrameMs;
-
   /*! Whether or not the server should send invalid transforms through the IGT Link */
   bool SendValidTransformsOnly;
 
@@ -315,13 +478,32 @@ private:
   /*! Channel ID to request the data from */
   std::string OutputChannelId;
 
-  /*! Channel to use for broadcasting */
-  vtkPlusChannel* BroadcastChannel;
+  /*! IDs of the channels that are broadcast in addition to OutputChannelId */
+  std::vector<std::string> AdditionalOutputChannelIds;
+
+  /*! Streams of the broadcast channels, only accessed by the data sender thread */
+  std::vector<BroadcastStream> BroadcastStreams;
+
+  /*! Protects NewFramesSequenceNumber */
+  std::mutex NewFramesMutex;
+  /*! Notified when new frames are available in any broadcast stream */
+  std::condition_variable NewFramesAvailable;
+  /*! Incremented when new frames are available in any broadcast stream */
+  unsigned long long NewFramesSequenceNumber;
+
+  /*! ID of the channel that is sent to the clients that do not specify a channel */
+  std::string DefaultBroadcastChannelId;
 
   bool LogWarningOnNoDataAvailable;
 
   double KeepAliveIntervalSec;
 
+  /*! Period of logging the latency statistics, 0 if they are not logged */
+  double LatencyLogIntervalSec;
+  double LastLatencyLogTime;
+  /*! Latency histograms at the previous log, only the latencies since then are logged */
+  std::map<std::string, PlusLatencyHistogram::Snapshot> LastLoggedLatencyHistograms;
+
   std::string ConfigFilename;
 
   vtkPlusLogger::LogLevelType GracePeriodLogLevel;
@@ -1,7 +1,13 @@
 #include <arpa/inet.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
+#include <errno.h>
 #include <ifaddrs.h>
 #include <stdio.h>
+#include <string.h>
+#include <unistd.h>
 
 void PrintServerInfo(vtkPlusOpenIGTLinkServer* self)
 {
@@ -35,4 +41,446 @@ void PrintServerInfo(vtkPlusOpenIGTLinkServer* self)
   }
   ss << " -- port " << self->GetListeningPort();
   LOG_INFO(ss.str());
-}
\ No newline at end of file
+}
+
+namespace
+{
+  const int REACTOR_MAX_NUMBER_OF_EVENTS = 64;
+  const int REACTOR_WAIT_TIMEOUT_MSEC = 100;
+  const size_t REACTOR_MAX_NUMBER_OF_SEGMENTS = 8; // a packed message has at most 3 buffer segments
+  const uint64_t REACTOR_LISTENING_SOCKET_EVENT_ID = 0; // client IDs start at 1
+  const uint64_t REACTOR_WAKEUP_EVENT_ID = static_cast<uint64_t>(-1);
+
+  //----------------------------------------------------------------------------
+  /*!
+    Event descriptor that wakes up the reactor when a message is queued for a client.
+    The send queue callbacks share its ownership, so it is not closed while a callback may still use it.
+  */
+  class ReactorWakeup
+  {
+  public:
+    ReactorWakeup() : EventDescriptor(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) {}
+    ~ReactorWakeup()
+    {
+      if (this->EventDescriptor >= 0)
+      {
+        close(this->EventDescriptor);
+      }
+    }
+    int GetDescriptor() const { return this->EventDescriptor; }
+    void Notify()
+    {
+      uint64_t value = 1;
+      if (write(this->EventDescriptor, &value, sizeof(value)) < 0)
+      {
+        // The counter is full, the reactor will wake up anyway
+      }
+    }
+    void Reset()
+    {
+      uint64_t value = 0;
+      if (read(this->EventDescriptor, &value, sizeof(value)) < 0)
+      {
+        // Nothing to reset
+      }
+    }
+  private:
+    int EventDescriptor;
+  };
+
+  //----------------------------------------------------------------------------
+  /*! State of a client connection that is handled by the reactor */
+  struct ReactorConnection
+  {
+    ReactorConnection()
+      : Client(NULL)
+      , SocketDescriptor(-1)
+      , BytesReceived(0)
+      , BodySize(0)
+      , ReceivingBody(false)
+      , SendingMessageSize(0)
+      , BytesSent(0)
+      , WaitingForWritable(false)
+    {}
+    ClientData* Client;
+    int SocketDescriptor;
+    std::shared_ptr<PlusIgtlClientSendQueue> SendQueue;
+    /*! Message that is being received. Body is NULL while the header is received, or if the body of an unknown message type is skipped. */
+    igtl::MessageHeader::Pointer Header;
+    igtl::MessageBase::Pointer Body;
+    int BytesReceived;
+    int BodySize;
+    bool ReceivingBody;
+    /*! Message that is being sent */
+    igtl::MessageBase::Pointer SendingMessage;
+    /*! Buffers of the message that is being sent, the pixel data of images may be sent from a separate buffer */
+    std::vector<igtl::PlusImageMessage::BufferSegment> SendingSegments;
+    igtl_uint64 SendingMessageSize;
+    igtl_uint64 BytesSent;
+    /*! The socket cannot accept more data, sending continues when epoll reports that it is writable */
+    bool WaitingForWritable;
+    /*! IDs of recent commands to be able to detect duplicate command IDs */
+    std::deque<uint32_t> PreviousCommandIds;
+  };
+}
+
+//----------------------------------------------------------------------------
+void* vtkPlusOpenIGTLinkServer::ReactorThread(vtkMultiThreader::ThreadInfo* data)
+{
+  vtkPlusOpenIGTLinkServer* self = (vtkPlusOpenIGTLinkServer*)(data->UserData);
+
+  int r = self->ServerSocket->CreateServer(self->ListeningPort);
+  if (r < 0)
+  {
+    LOG_ERROR("Cannot create a server socket.");
+    return NULL;
+  }
+
+  std::shared_ptr<ReactorWakeup> wakeup = std::make_shared<ReactorWakeup>();
+  int epollDescriptor = epoll_create1(EPOLL_CLOEXEC);
+  if (epollDescriptor < 0 || wakeup->GetDescriptor() < 0)
+  {
+    LOG_ERROR("Cannot create event loop for the server: " << strerror(errno));
+    if (epollDescriptor >= 0)
+    {
+      close(epollDescriptor);
+    }
+    self->ServerSocket->CloseSocket();
+    return NULL;
+  }
+
+  epoll_event event;
+  memset(&event, 0, sizeof(event));
+  event.events = EPOLLIN;
+  event.data.u64 = REACTOR_LISTENING_SOCKET_EVENT_ID;
+  int listeningResult = epoll_ctl(epollDescriptor, EPOLL_CTL_ADD, PlusIgtlSocketDescriptorAccessor::GetSocketDescriptor(self->ServerSocket), &event);
+  event.data.u64 = REACTOR_WAKEUP_EVENT_ID;
+  if (listeningResult < 0 || epoll_ctl(epollDescriptor, EPOLL_CTL_ADD, wakeup->GetDescriptor(), &event) < 0)
+  {
+    LOG_ERROR("Cannot poll the server socket: " << strerror(errno));
+    close(epollDescriptor);
+    self->ServerSocket->CloseSocket();
+    return NULL;
+  }
+
+  PrintServerInfo(self);
+
+  self->ConnectionActive.Respond = true;
+
+  std::map<int, ReactorConnection> connections;
+
+  // Stop polling the socket of a client and let DisconnectClient remove it
+  auto releaseConnection = [self, epollDescriptor, &connections](int clientId, bool connectionFailed)
+  {
+    std::map<int, ReactorConnection>::iterator connectionIt = connections.find(clientId);
+    if (connectionIt == connections.end())
+    {
+      return;
+    }
+    ReactorConnection& connection = connectionIt->second;
+    if (epoll_ctl(epollDescriptor, EPOLL_CTL_DEL, connection.SocketDescriptor, NULL) < 0 && errno != ENOENT)
+    {
+      // The socket is closed when the client is removed, which stops polling it anyway
+      LOG_DEBUG("Cannot stop polling the socket of client " << clientId << ": " << strerror(errno));
+    }
+    connection.SendQueue->SetMessageQueuedCallback(std::function<void()>());
+    if (connection.SendingMessage.IsNotNull())
+    {
+      connection.SendQueue->EndSendMessage(false);
+    }
+    if (connectionFailed)
+    {
+      // The client is disconnected by the data sender thread
+      connection.SendQueue->SetSendFailed();
+    }
+    {
+      igsioLockGuard<vtkIGSIORecursiveCriticalSection> igtlClientsMutexGuardedLock(self->IgtlClientsMutex);
+      connection.Client->DataReceiverActive.second = false;
+    }
+    connections.erase(connectionIt);
+  };
+
+  // Receive everything that is available on the socket, process the completed messages
+  auto receiveMessages = [self](ReactorConnection& connection) -> bool
+  {
+    char skippedBytes[4096];
+    while (true)
+    {
+      char* buffer(NULL);
+      int bytesToReceive(0);
+      if (!connection.ReceivingBody)
+      {
+        buffer = static_cast<char*>(connection.Header->GetBufferPointer()) + connection.BytesReceived;
+        bytesToReceive = connection.Header->GetBufferSize() - connection.BytesReceived;
+      }
+      else if (connection.Body.IsNull())
+      {
+        buffer = skippedBytes;
+        bytesToReceive = std::min<int>(sizeof(skippedBytes), connection.BodySize - connection.BytesReceived);
+      }
+      else
+      {
+        buffer = static_cast<char*>(connection.Body->GetBufferBodyPointer()) + connection.BytesReceived;
+        bytesToReceive = connection.BodySize - connection.BytesReceived;
+      }
+
+      if (bytesToReceive > 0)
+      {
+        ssize_t bytesReceived = recv(connection.SocketDescriptor, buffer, bytesToReceive, MSG_DONTWAIT);
+        if (bytesReceived == 0)
+        {
+          LOG_DEBUG("Client " << connection.Client->ClientId << " closed the connection");
+          return false;
+        }
+        if (bytesReceived < 0)
+        {
+          if (errno == EINTR)
+          {
+            continue;
+          }
+          return (errno == EAGAIN || errno == EWOULDBLOCK);
+        }
+        connection.BytesReceived += bytesReceived;
+        if (connection.BytesReceived < (connection.ReceivingBody ? connection.BodySize : connection.Header->GetBufferSize()))
+        {
+          continue;
+        }
+      }
+
+      if (!connection.ReceivingBody)
+      {
+        // Header is complete, prepare for receiving the body
+        connection.Header->Unpack(self->IgtlMessageCrcCheckEnabled);
+        connection.Body = self->IgtlMessageFactory->CreateReceiveMessage(connection.Header);
+        connection.BodySize = connection.Header->GetBodySizeToRead();
+        if (connection.Body.IsNotNull())
+        {
+          connection.Body->SetMessageHeader(connection.Header);
+          connection.Body->AllocateBuffer();
+          connection.BodySize = connection.Body->GetBufferBodySize();
+        }
+        connection.ReceivingBody = true;
+        connection.BytesReceived = 0;
+        if (connection.BodySize > 0)
+        {
+          continue;
+        }
+      }
+
+      // Message is complete
+      self->ProcessClientMessage(connection.Client, connection.Header, connection.Body, connection.PreviousCommandIds);
+      connection.Header->InitBuffer();
+      connection.Body = NULL;
+      connection.BodySize = 0;
+      connection.BytesReceived = 0;
+      connection.ReceivingBody = false;
+    }
+  };
+
+  // Send the queued messages until the socket cannot accept more data
+  auto sendMessages = [epollDescriptor](int clientId, ReactorConnection& connection) -> bool
+  {
+    while (true)
+    {
+      if (connection.SendingMessage.IsNull())
+      {
+        if (!connection.SendQueue->BeginSendMessage(connection.SendingMessage))
+        {
+          break;
+        }
+        igtl::PlusImageMessage::GetBufferSegments(connection.SendingMessage, connection.SendingSegments);
+        connection.SendingMessageSize = 0;
+        for (std::vector<igtl::PlusImageMessage::BufferSegment>::const_iterator segmentIt = connection.SendingSegments.begin(); segmentIt != connection.SendingSegments.end(); ++segmentIt)
+        {
+          connection.SendingMessageSize += segmentIt->Size;
+        }
+        connection.BytesSent = 0;
+      }
+
+      // Send the rest of the message from all its buffers at once
+      iovec ioVectors[REACTOR_MAX_NUMBER_OF_SEGMENTS];
+      size_t numberOfIoVectors = 0;
+      igtl_uint64 segmentStart = 0;
+      for (std::vector<igtl::PlusImageMessage::BufferSegment>::const_iterator segmentIt = connection.SendingSegments.begin();
+           segmentIt != connection.SendingSegments.end() && numberOfIoVectors < REACTOR_MAX_NUMBER_OF_SEGMENTS; ++segmentIt)
+      {
+        igtl_uint64 segmentEnd = segmentStart + segmentIt->Size;
+        if (segmentEnd > connection.BytesSent)
+        {
+          igtl_uint64 offset = (connection.BytesSent > segmentStart ? connection.BytesSent - segmentStart : 0);
+          ioVectors[numberOfIoVectors].iov_base = const_cast<char*>(static_cast<const char*>(segmentIt->Data)) + offset;
+          ioVectors[numberOfIoVectors].iov_len = static_cast<size_t>(segmentIt->Size - offset);
+          numberOfIoVectors++;
+        }
+        segmentStart = segmentEnd;
+      }
+      msghdr socketMessage;
+      memset(&socketMessage, 0, sizeof(socketMessage));
+      socketMessage.msg_iov = ioVectors;
+      socketMessage.msg_iovlen = numberOfIoVectors;
+      ssize_t bytesSent = sendmsg(connection.SocketDescriptor, &socketMessage, MSG_DONTWAIT | MSG_NOSIGNAL);
+      if (bytesSent < 0)
+      {
+        if (errno == EINTR)
+        {
+          continue;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+        {
+          break;
+        }
+        connection.SendQueue->EndSendMessage(false);
+        connection.SendingMessage = NULL;
+        return false;
+      }
+      connection.BytesSent += static_cast<igtl_uint64>(bytesSent);
+      if (connection.BytesSent >= connection.SendingMessageSize)
+      {
+        connection.SendQueue->EndSendMessage(true);
+        connection.SendingMessage = NULL;
+      }
+    }
+
+    // Poll for writability only while a message is partially sent
+    bool waitForWritable = connection.SendingMessage.IsNotNull();
+    if (waitForWritable != connection.WaitingForWritable)
+    {
+      epoll_event event;
+      memset(&event, 0, sizeof(event));
+      event.events = (waitForWritable ? EPOLLIN | EPOLLOUT : EPOLLIN);
+      event.data.u64 = static_cast<uint64_t>(clientId);
+      if (epoll_ctl(epollDescriptor, EPOLL_CTL_MOD, connection.SocketDescriptor, &event) < 0)
+      {
+        // The rest of the message could not be sent, the client is disconnected
+        LOG_ERROR("Cannot poll the socket of client " << clientId << ": " << strerror(errno));
+        return false;
+      }
+      connection.WaitingForWritable = waitForWritable;
+    }
+    return true;
+  };
+
+  epoll_event events[REACTOR_MAX_NUMBER_OF_EVENTS];
+  while (self->ConnectionActive.Request)
+  {
+    int numberOfEvents = epoll_wait(epollDescriptor, events, REACTOR_MAX_NUMBER_OF_EVENTS, REACTOR_WAIT_TIMEOUT_MSEC);
+    if (numberOfEvents < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      LOG_ERROR("Server event loop failed: " << strerror(errno));
+      break;
+    }
+
+    std::vector<int> failedClientIds;
+    for (int eventIndex = 0; eventIndex < numberOfEvents; ++eventIndex)
+    {
+      const uint64_t eventId = events[eventIndex].data.u64;
+      if (eventId == REACTOR_WAKEUP_EVENT_ID)
+      {
+        // Queued messages are sent below
+        wakeup->Reset();
+      }
+      else if (eventId == REACTOR_LISTENING_SOCKET_EVENT_ID)
+      {
+        igtl::ClientSocket::Pointer newClientSocket = self->ServerSocket->WaitForConnection(1);
+        if (newClientSocket.IsNull())
+        {
+          continue;
+        }
+
+        // Lock before we change the clients list
+        igsioLockGuard<vtkIGSIORecursiveCriticalSection> igtlClientsMutexGuardedLock(self->IgtlClientsMutex);
+        ClientData* client = self->AddClient(newClientSocket);
+        client->DataReceiverActive.first = true;
+        client->DataReceiverActive.second = true;
+
+        ReactorConnection& connection = connections[client->ClientId];
+        connection.Client = client;
+        connection.SocketDescriptor = PlusIgtlSocketDescriptorAccessor::GetSocketDescriptor(newClientSocket);
+        connection.SendQueue = client->SendQueue;
+        connection.Header = self->IgtlMessageFactory->CreateHeaderMessage(IGTL_HEADER_VERSION_1);
+        connection.Header->InitBuffer();
+        client->SendQueue->SetMessageQueuedCallback([wakeup]() { wakeup->Notify(); });
+
+        epoll_event clientEvent;
+        memset(&clientEvent, 0, sizeof(clientEvent));
+        clientEvent.events = EPOLLIN;
+        clientEvent.data.u64 = static_cast<uint64_t>(client->ClientId);
+        if (epoll_ctl(epollDescriptor, EPOLL_CTL_ADD, connection.SocketDescriptor, &clientEvent) < 0)
+        {
+          // The client would never be served, disconnect it
+          LOG_ERROR("Cannot poll the socket of client " << client->ClientId << ": " << strerror(errno));
+          failedClientIds.push_back(client->ClientId);
+        }
+      }
+      else
+      {
+        const int clientId = static_cast<int>(eventId);
+        std::map<int, ReactorConnection>::iterator connectionIt = connections.find(clientId);
+        if (connectionIt == connections.end())
+        {
+          continue;
+        }
+        if (events[eventIndex].events & EPOLLOUT)
+        {
+          connectionIt->second.WaitingForWritable = false;
+        }
+        if ((events[eventIndex].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) && !receiveMessages(connectionIt->second))
+        {
+          failedClientIds.push_back(clientId);
+        }
+      }
+    }
+
+    // Clients that are being disconnected (e.g., because sending failed) are not polled anymore
+    {
+      igsioLockGuard<vtkIGSIORecursiveCriticalSection> igtlClientsMutexGuardedLock(self->IgtlClientsMutex);
+      for (std::map<int, ReactorConnection>::iterator connectionIt = connections.begin(); connectionIt != connections.end(); ++connectionIt)
+      {
+        if (!connectionIt->second.Client->DataReceiverActive.first)
+        {
+          failedClientIds.push_back(connectionIt->first);
+        }
+      }
+    }
+    for (std::vector<int>::iterator it = failedClientIds.begin(); it != failedClientIds.end(); ++it)
+    {
+      releaseConnection(*it, true);
+    }
+
+    // Send queued messages
+    failedClientIds.clear();
+    for (std::map<int, ReactorConnection>::iterator connectionIt = connections.begin(); connectionIt != connections.end(); ++connectionIt)
+    {
+      if (!connectionIt->second.WaitingForWritable && !sendMessages(connectionIt->first, connectionIt->second))
+      {
+        failedClientIds.push_back(connectionIt->first);
+      }
+    }
+    for (std::vector<int>::iterator it = failedClientIds.begin(); it != failedClientIds.end(); ++it)
+    {
+      releaseConnection(*it, true);
+    }
+  }
+
+  // Release the remaining clients, they are disconnected when the server is stopped
+  while (!connections.empty())
+  {
+    releaseConnection(connections.begin()->first, false);
+  }
+  close(epollDescriptor);
+
+  // Close server socket
+  if (self->ServerSocket.IsNotNull())
+  {
+    self->ServerSocket->CloseSocket();
+  }
+
+  // Close thread
+  self->ConnectionReceiverThreadId = -1;
+  self->ConnectionActive.Respond = false;
+  return NULL;
+}